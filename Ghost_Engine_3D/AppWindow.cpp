@@ -28,9 +28,14 @@
 
 #include "AppWindow.h"
 #include <Windows.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include "Vector3D.h"
 #include "Vector2D.h"
 #include "Matrix4x4.h"
+#include "FileSystem.h"
+#include "JobSystem.h"
 
 #include "Libs/ImGui/imgui.h"
 #include "Libs/ImGui/imgui_impl_win32.h"
@@ -47,10 +52,10 @@ AppWindow::AppWindow()
 {
 }
 
-void AppWindow::updateTransform()
+void AppWindow::updateTransform(FrameSnapshot& frame)
 {
 	// getTickCount is a Windows function. Output the time since the start of the system in milliseconds	
-	m_ct->m_time = ::GetTickCount64();
+	frame.m_constants.m_time = ::GetTickCount64();
 
 	m_delta_pos += m_delta_time / 10.0f;	// last value makes the movement slower. Like 1 unit in x seconds
 	if (m_delta_pos > 1.0f)
@@ -68,11 +73,14 @@ void AppWindow::updateTransform()
 	// get light direction vector
 	Matrix4x4 light;
 	light.setIdentity();
-	light.setRotationY(m_light_rotation);
+	light.setRotationX(-frame.m_settings.m_light_elevation);
+	temp.setIdentity();
+	temp.setRotationY(frame.m_settings.m_light_rotation);
+	light *= temp;
 
-	//m_light_rotation += 0.6f * m_delta_time;
+	//frame.m_settings.m_light_rotation += 0.6f * m_delta_time;
 
-	m_ct->m_vectorLight = light.getZDirection();
+	frame.m_constants.m_vectorLight = light.getZDirection();
 
 
 	// camera matrix
@@ -98,25 +106,167 @@ void AppWindow::updateTransform()
 	world_cam.inverse();
 
 	// fill constant buffer with world matrix of cube which is identity matrix
-	m_ct->m_view = world_cam;
+	frame.m_constants.m_view = world_cam;
 
 	float height = (this->getClientWindowRect().bottom - this->getClientWindowRect().top);
 	float width = (this->getClientWindowRect().right - this->getClientWindowRect().left);
 
-	m_ct->m_proj.setPerspectiveFovLH(1.6f, (width / height), 0.1f, 100.0f);
+	frame.m_constants.m_proj.setPerspectiveFovLH(1.6f, (width / height), CAMERA_NEAR, CAMERA_FAR);
+
 
+	frame.m_constants.m_world.setIdentity();
 
-	m_ct->m_world.setIdentity();
 
+	// ambient light of the GUI
+	frame.m_constants.ambientColor = frame.m_settings.m_ambient_color;
+	frame.m_constants.ambientPower = frame.m_settings.m_ambient_power;
 
-	// pass it to the Constant buffer update function
-	m_cb->update(GraphicsEngine::get()->getImmediateDeviceContext(), m_ct);
+	// the render thread uploads the constants of the snapshot to the constant buffer
 }
 
 
-void AppWindow::UpdateGui()
+/*
+	- the lights are placed by a hash of their index: the same light keeps its place and color when the count changes
+	- each one circles around its place. Every fourth light is a spot light pointing down
+	- the radius shrinks with more lights, so the lights on one pixel stay about the same
+*/
+
+void AppWindow::updateLights(FrameSnapshot& frame)
 {
-	float CameraTranslation[3] = { m_input->getPosX(), m_input->getPosY(), m_input->getPosZ() };
+	const SceneSettings& settings = frame.m_settings;
+	unsigned int count = std::min((unsigned int)std::max(settings.m_light_count, 0), LightGrid::MAX_LIGHTS);
+	if (settings.m_animate_lights)
+		m_light_time += m_delta_time;
+
+	const Vector3D& area_min = m_light_area_min[settings.m_benchmark ? 1 : 0];
+	const Vector3D& area_max = m_light_area_max[settings.m_benchmark ? 1 : 0];
+	Vector3D size = area_max - area_min;
+	float radius = std::max(size.m_x, size.m_z) * 2.0f / sqrtf((float)std::max(count, 1u));
+
+	auto random = [](unsigned int light, unsigned int value)
+	{
+		unsigned int hash = (light * 4 + value + 1) * 2654435761u;
+		hash ^= hash >> 15;
+		hash *= 2246822519u;
+		hash ^= hash >> 13;
+		return (hash & 0xffff) / 65535.0f;
+	};
+
+	m_lights.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		PointLight& light = m_lights[i];
+		float angle = m_light_time * (0.3f + random(i, 0)) + random(i, 1) * 6.283f;
+		light.m_position = Vector3D(
+			area_min.m_x + random(i, 2) * size.m_x + cosf(angle) * radius * 0.5f,
+			area_min.m_y + (0.3f + 0.7f * random(i, 3)) * size.m_y,
+			area_min.m_z + random(i, 4) * size.m_z + sinf(angle) * radius * 0.5f);
+
+		float hue = random(i, 5) * 6.283f;
+		light.m_color = Vector3D(0.5f + 0.5f * cosf(hue), 0.5f + 0.5f * cosf(hue + 2.094f), 0.5f + 0.5f * cosf(hue + 4.189f));
+
+		bool spot = (i % 4) == 3;
+		light.m_radius = spot ? radius * 1.5f : radius;
+		light.m_direction = Vector3D(0.0f, -1.0f, 0.0f);
+		light.m_spot_cos_outer = spot ? 0.8f : -1.0f;
+		light.m_spot_cos_inner = spot ? 0.9f : -1.0f;
+	}
+
+	m_light_grid.build(m_lights, frame.m_constants.m_view, frame.m_constants.m_proj, frame.m_width, frame.m_height, frame.m_light_grid);
+}
+
+
+/*
+	- casters: every copy of the benchmark scene or the mesh, also the ones outside of the camera frustum, they can throw
+	  a shadow into it. The placements only translate -> the bounding sphere of the mesh box moves with the translation
+	- detail level per cascade: the coarsest level whose error stays below the pixel error in texels of the cascade
+*/
+
+void AppWindow::updateShadows(MeshModel* mesh, FrameSnapshot& frame)
+{
+	const SceneSettings& settings = frame.m_settings;
+	frame.m_shadow_casters.clear();
+	if (!settings.m_shadows)
+		return;
+
+	Vector3D box_min, box_max;
+	mesh->getBoundingBox(box_min, box_max);
+	Vector3D center = (box_min + box_max) * 0.5f;
+	float radius = (box_max - box_min).length() * 0.5f;
+
+	auto addCaster = [&](Matrix4x4 world)
+	{
+		ShadowCaster caster;
+		caster.m_world = world;
+		caster.m_center = center + world.getTranslation();
+		caster.m_radius = radius;
+		frame.m_shadow_casters.push_back(caster);
+	};
+
+	if (settings.m_benchmark)
+	{
+		for (const Matrix4x4& world : m_instances)
+			addCaster(world);
+	}
+	else
+	{
+		addCaster(frame.m_constants.m_world);
+	}
+
+	// m_vectorLight points to the light
+	unsigned int scene = settings.m_benchmark ? 1 : 0;
+	m_shadow_fit.fit(frame.m_constants.m_view, frame.m_constants.m_proj, frame.m_constants.m_vectorLight * -1.0f, m_scene_min[scene], m_scene_max[scene],
+		std::min(settings.m_shadow_distance, CAMERA_FAR), frame.m_shadow_cascades);
+	m_shadow_fit.cull(frame.m_shadow_casters, frame.m_shadow_cascades, frame.m_shadow_stats);
+
+	for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+	{
+		unsigned int level = 0;
+		float max_error = frame.m_shadow_cascades[c].m_texel_size * settings.m_lod_pixel_error;
+		while (level + 1 < mesh->getLodCount() && mesh->getLod(level + 1).m_error <= max_error)
+			level++;
+		frame.m_shadow_lod[c] = level;
+	}
+}
+
+
+void AppWindow::updateTerrain(FrameSnapshot& frame)
+{
+	// switched off: nothing to draw and nothing to upload, the tiles in the slots stay valid
+	if (!frame.m_settings.m_terrain || !m_terrain.isOpen())
+	{
+		frame.m_terrain.m_instances.clear();
+		frame.m_terrain.m_uploads.clear();
+		return;
+	}
+
+	m_terrain.select(frame.m_constants.m_view, frame.m_constants.m_proj, frame.m_camera_position, frame.m_settings.m_terrain_lod_distance, frame.m_terrain);
+}
+
+
+void AppWindow::updateParticles(FrameSnapshot& frame)
+{
+	// switched off: the particles stop where they are and nothing is drawn
+	if (!frame.m_settings.m_particles)
+	{
+		frame.m_particles.clear();
+		return;
+	}
+
+	// view direction of the camera: the third column of the view matrix (row vectors)
+	const Matrix4x4& view = frame.m_constants.m_view;
+	Vector3D forward(view.m_mat[0][2], view.m_mat[1][2], view.m_mat[2][2]);
+
+	m_particles.update(m_delta_time);
+	m_particles.fillVertices(frame.m_camera_position, forward, frame.m_settings.m_particle_sort, frame.m_particles);
+	frame.m_particle_stats = m_particles.getStats();
+}
+
+
+void AppWindow::UpdateGui(const FrameSnapshot& frame)
+{
+	// position of the camera in the frame on screen. Only an edit is written back, the game thread may already be ahead
+	float CameraTranslation[3] = { frame.m_camera_position.m_x, frame.m_camera_position.m_y, frame.m_camera_position.m_z };
 	static int counter = 0;
 
 	// start ImGui frame
@@ -130,25 +280,700 @@ void AppWindow::UpdateGui()
 	ImGui::Text(" (%.1f FPS)", ImGui::GetIO().Framerate);
 	ImGui::End();
 
+	AsyncReadStats prefetch = FileSystem::get()->getPrefetchStats();
+	ImGui::Begin("Files");
+	ImGui::Text("Packs mounted: %u", FileSystem::get()->getMountCount());
+	ImGui::Text("Prefetch (%s): %u files, %.2f MB", prefetch.m_backend, prefetch.m_files, prefetch.m_bytes / 1048576.0);
+	ImGui::Text("Queue depth: %.1f average, %u max of %u", prefetch.m_average_in_flight, prefetch.m_max_in_flight, prefetch.m_queue_depth);
+	ImGui::Text("Read: %.2f ms (%.1f MB/s)", prefetch.m_milliseconds, prefetch.m_megabytes_per_second);
+	ImGui::End();
+
 	ImGui::Begin("Camera");
-	ImGui::DragFloat3("Translation", CameraTranslation, 0.1f, -10.0f, 10.0f);
-	m_input->setTransform(CameraTranslation);
+	if (ImGui::DragFloat3("Translation", CameraTranslation, 0.1f, -10.0f, 10.0f))
+		m_input->setTransform(CameraTranslation);
 
-	ImGui::DragFloat3("Ambient Light", &m_ct->ambientColor.m_x, 0.01f, 0.0f, 1.0f);
-	ImGui::DragFloat("Ambient Alpha", &m_ct->ambientPower, 0.01f, 0.0f, 1.0f);
+	ImGui::DragFloat3("Ambient Light", &m_settings.m_ambient_color.m_x, 0.01f, 0.0f, 1.0f);
+	ImGui::DragFloat("Ambient Alpha", &m_settings.m_ambient_power, 0.01f, 0.0f, 1.0f);
 	ImGui::End();
 
 	ImGui::Begin("Light");
-	ImGui::DragFloat("Light Direction", &m_light_rotation, 0.01f, -3.141f, 3.141f);
+	ImGui::DragFloat("Light Direction", &m_settings.m_light_rotation, 0.01f, -3.141f, 3.141f);
+	ImGui::SliderInt("Point and Spot Lights", &m_settings.m_light_count, 0, (int)LightGrid::MAX_LIGHTS);
+	ImGui::Checkbox("Animate Lights", &m_settings.m_animate_lights);
+	const LightGridStats& light_stats = frame.m_light_grid.m_stats;
+	ImGui::Text("Clusters: %u x %u x %u, built in %.3f ms", LightGrid::LIGHT_GRID_X, LightGrid::LIGHT_GRID_Y, LightGrid::LIGHT_GRID_SLICES, light_stats.m_milliseconds);
+	ImGui::Text("Visible lights: %u of %u", light_stats.m_visible_lights, light_stats.m_lights);
+	ImGui::Text("Lights per cluster: %.2f average, %u max", (double)light_stats.m_references / LightGrid::LIGHT_GRID_CLUSTERS, light_stats.m_max_per_cluster);
+	if (light_stats.m_overflow)
+		ImGui::Text("Dropped: %u (cluster or index list full)", light_stats.m_overflow);
+
+	ImGui::Separator();
+	ImGui::SliderFloat("Light Elevation", &m_settings.m_light_elevation, 0.05f, 1.57f);
+	ImGui::Checkbox("Shadows", &m_settings.m_shadows);
+	ImGui::DragFloat("Shadow Distance", &m_settings.m_shadow_distance, 0.5f, 1.0f, CAMERA_FAR);
+	if (frame.m_settings.m_shadows)
+	{
+		const ShadowStats& shadow_stats = frame.m_shadow_stats;
+		ImGui::Text("Cascades: %u of %ux%u, casters culled in %.3f ms", ShadowCascades::CASCADE_COUNT, ShadowCascades::SHADOW_MAP_SIZE, ShadowCascades::SHADOW_MAP_SIZE, shadow_stats.m_milliseconds);
+		ImGui::Text("Casters: %u, per cascade %u / %u / %u / %u", shadow_stats.m_casters, shadow_stats.m_cascade_casters[0], shadow_stats.m_cascade_casters[1],
+			shadow_stats.m_cascade_casters[2], shadow_stats.m_cascade_casters[3]);
+		ImGui::Text("Splits: %.1f / %.1f / %.1f / %.1f", frame.m_shadow_cascades[0].m_split_far, frame.m_shadow_cascades[1].m_split_far,
+			frame.m_shadow_cascades[2].m_split_far, frame.m_shadow_cascades[3].m_split_far);
+		ImGui::Text("Shadow maps drawn: %u of %u, the others cached", m_shadow_maps_drawn, ShadowCascades::CASCADE_COUNT);
+	}
 
 
 	ImGui::End();
 
+	MeshModel* mesh = GraphicsEngine::get()->get(m_mesh);
+	if (mesh)
+	{
+		const MeshFileLod& lod = mesh->getLod(frame.m_lod_level);
+		const MeshFileLod& full = mesh->getLod(0);
+
+		ImGui::Begin("Mesh LOD");
+		ImGui::DragFloat("Pixel Error", &m_settings.m_lod_pixel_error, 0.1f, 0.1f, 50.0f);
+		ImGui::Text("Level: %u of %u", frame.m_lod_level, mesh->getLodCount() - 1);
+		ImGui::Text("Triangles: %u of %u", lod.m_index_count / 3, full.m_index_count / 3);
+		ImGui::Text("Vertices: %u of %u (%.1f%%)", lod.m_vertex_count, full.m_vertex_count, 100.0 * lod.m_vertex_count / std::max(full.m_vertex_count, 1u));
+		ImGui::Text("Error: %.4f", lod.m_error);
+
+		const VertexPackReport& vertex_report = mesh->getVertexReport();
+		ImGui::Text("Vertex stride: %u bytes (%s)", mesh->getVertexFormat().getStride(), mesh->getVertexFormat().isPacked() ? "packed" : "float");
+		ImGui::Text("Streams: position %u bytes, attributes %u bytes", mesh->getVertexFormat().getPositionStride(), mesh->getVertexFormat().getAttributeStride());
+		ImGui::Checkbox("Depth Pre-Pass", &m_depth_prepass);
+		if (mesh->getVertexFormat().isPacked())
+		{
+			ImGui::Text("Vertex memory: %u of %u bytes (%u saved)", vertex_report.m_packed_bytes, vertex_report.m_float_bytes, vertex_report.m_float_bytes - vertex_report.m_packed_bytes);
+			ImGui::Text("Precision: position %.5f, texcoord %.5f, normal %.3f deg", vertex_report.m_position_error, vertex_report.m_texcoord_error, vertex_report.m_normal_error);
+		}
+		ImGui::End();
+
+		const MeshletCullStats& culling = frame.m_meshlet_stats;
+		ImGui::Begin("Meshlets");
+		ImGui::Checkbox("Meshlet Culling", &m_settings.m_meshlet_culling);
+		if (frame.m_meshlet_culled && culling.m_meshlets)
+		{
+			ImGui::Text("Meshlets: %u, culled %u frustum, %u back facing, %u occluded", culling.m_meshlets, culling.m_frustum_culled, culling.m_cone_culled, culling.m_occlusion_culled);
+			ImGui::Text("Triangles: %u of %u drawn (%.1f%% culled)", culling.m_triangles - culling.m_triangles_culled, culling.m_triangles, 100.0 * culling.m_triangles_culled / culling.m_triangles);
+			ImGui::Text("Culling: %.3f ms", culling.m_milliseconds);
+		}
+		ImGui::End();
+	}
+
+	ImGui::Begin("Occlusion");
+	ImGui::Checkbox("Benchmark Scene", &m_settings.m_benchmark);
+	ImGui::Checkbox("Occlusion Culling", &m_settings.m_occlusion_culling);
+	ImGui::SliderInt("Occluders", &m_settings.m_occluder_count, 0, 32);
+	ImGui::Checkbox("Static Batches", &m_settings.m_static_batching);
+	ImGui::Checkbox("Parallel Command Lists", &m_parallel_submit);
+	if (ImGui::Checkbox("Command Stream in Memory", &m_recorded_lists))
+		createCommandLists(m_recorded_lists);
+	if (!m_command_lists.empty())
+		ImGui::Text("Lists: %s", m_command_lists[0]->isDeferred() ? "deferred contexts" : (GraphicsEngine::get()->hasDriverCommandLists() ? "command stream" : "command stream (no driver command lists)"));
+	if (frame.m_settings.m_benchmark)
+	{
+		const OcclusionStats& occlusion = frame.m_occlusion_stats;
+		ImGui::Text("Draw calls: %u of %u (%u saved)", m_draws, (unsigned int)m_instances.size(), (unsigned int)m_instances.size() - m_draws);
+		ImGui::Text("Submit: %.3f ms", m_submit_ms);
+		if (m_parallel_submit && !frame.m_settings.m_static_batching)
+			ImGui::Text("Record: %.3f ms on %u lists, execute: %.3f ms", m_record_ms, m_lists_used, m_execute_ms);
+		if (frame.m_settings.m_static_batching)
+		{
+			const StaticBatchStats& batches = m_batcher.getStats();
+			ImGui::Text("Batches: %u (%u with 16-bit indices), %u buffer binds", batches.m_batches, batches.m_batches_16bit, batches.m_binds);
+			ImGui::Text("Objects: %u visible of %u, %u vertices, %u indices", batches.m_objects_visible, batches.m_objects, batches.m_vertices, batches.m_indices);
+		}
+		if (frame.m_occlusion_rendered)
+		{
+			ImGui::Text("Occluders: %u, %u of %u triangles rasterized", occlusion.m_occluders, occlusion.m_triangles_rasterized, occlusion.m_triangles);
+			ImGui::Text("Rasterize: %.3f ms (%ux%u)", occlusion.m_raster_milliseconds, m_occlusion.getWidth(), m_occlusion.getHeight());
+			ImGui::Text("Tests: %u, %u occluded, %.3f ms", occlusion.m_tests, occlusion.m_occluded,
+				frame.m_settings.m_static_batching ? m_batcher.getStats().m_cull_milliseconds : frame.m_occlusion_test_ms);
+		}
+	}
+	ImGui::End();
+
+	TextureShader* texture = GraphicsEngine::get()->get(m_ts);
+	if (texture)
+	{
+		const MipMapStats& mips = texture->getMipStats();
+		RECT rc = this->getClientWindowRect();
+		size_t screen_pixels = (size_t)(rc.right - rc.left) * (rc.bottom - rc.top) / 4;
+		size_t texels = mips.m_base_bytes / 4;
+
+		ImGui::Begin("Texture");
+		ImGui::Text("Mip levels: %u", mips.m_levels);
+		ImGui::Text("Mip generation: %.2f ms (%.1f Mpix/s)", mips.m_milliseconds, mips.m_megapixels_per_second);
+		ImGui::Text("Memory: %.2f MB base, %.2f MB with mips", mips.m_base_bytes / 1048576.0, mips.m_chain_bytes / 1048576.0);
+		// texture drawn over a quarter of the window
+		ImGui::Text("Sampled per frame: %.2f MB without mips, %.2f MB with mips",
+			MipMapGenerator::estimateSampledBytes(texels, screen_pixels, false) / 1048576.0,
+			MipMapGenerator::estimateSampledBytes(texels, screen_pixels, true) / 1048576.0);
+
+		const CompressionReport& compression = texture->getCompressionReport();
+		if (compression.m_format != DXGI_FORMAT_UNKNOWN)
+		{
+			ImGui::Separator();
+			ImGui::Text("Block compression: BC%d", (compression.m_format == DXGI_FORMAT_BC1_UNORM) ? 1 : (compression.m_format == DXGI_FORMAT_BC3_UNORM) ? 3 : (compression.m_format == DXGI_FORMAT_BC5_UNORM) ? 5 : 7);
+			ImGui::Text("PSNR: %.2f dB", compression.m_psnr);
+			ImGui::Text("Encode: %.2f ms (%.1f Mpix/s)", compression.m_milliseconds, compression.m_megapixels_per_second);
+			ImGui::Text("Memory: %.2f MB -> %.2f MB", compression.m_source_bytes / 1048576.0, compression.m_compressed_bytes / 1048576.0);
+		}
+		ImGui::End();
+	}
+
+	drawTerrainGui(frame);
+	drawNoiseGui();
+	drawCollisionGui(frame);
+	drawParticleGui(frame);
+	drawPipelineGui(frame);
+	drawRenderGraphGui();
+
+	// the next simulated frame uses the settings of this GUI frame
+	{
+		std::lock_guard<std::mutex> lock(m_settings_mutex);
+		m_shared_settings = m_settings;
+	}
+
 	ImGui::Render();
 	ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
 }
 
 
+/*
+	- the timeline shows the profiler markers of the last PIPELINE_TIMELINE_MS, one row per thread. With the game thread
+	  the "Simulate" bars of frame N+1 run under the "Render" bars of frame N
+*/
+
+void AppWindow::drawPipelineGui(const FrameSnapshot& frame)
+{
+	FramePipelineStats stats = m_pipeline.getStats();
+
+	ImGui::Begin("Pipeline");
+	ImGui::Checkbox("Game Thread", &m_pipelined);
+	ImGui::SliderInt("Max Frame Latency", &m_max_latency, 1, (int)FramePipeline<FrameSnapshot>::MAX_LATENCY);
+	ImGui::Text("Frame %llu, simulated in %.3f ms", frame.m_frame, frame.m_simulate_ms);
+	if (m_pipeline.isRunning())
+	{
+		ImGui::Text("In flight: %u, game thread waited %.3f ms, render thread waited %.3f ms", stats.m_in_flight, stats.m_produce_wait_ms, stats.m_consume_wait_ms);
+		ImGui::Text("Simulation overlapping rendering: %.1f%%", 100.0 * Profiler::get()->getOverlap("Simulate", "Render", PIPELINE_TIMELINE_MS));
+	}
+
+	// by start time -> a marker is drawn over the one it is nested in
+	Profiler::get()->getRecords(PIPELINE_TIMELINE_MS, m_profile_records);
+	std::sort(m_profile_records.begin(), m_profile_records.end(), [](const ProfileRecord& a, const ProfileRecord& b) { return a.m_begin < b.m_begin; });
+	unsigned int thread_count = Profiler::get()->getThreadCount();
+
+	const float row_height = 18.0f;
+	const float label_width = 90.0f;
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	float width = std::max(ImGui::GetContentRegionAvail().x - label_width, 100.0f);
+	double end = Profiler::get()->now();
+	double begin = end - PIPELINE_TIMELINE_MS;
+
+	ImDrawList* draw_list = ImGui::GetWindowDrawList();
+	for (unsigned int thread = 0; thread < thread_count; thread++)
+	{
+		float y = origin.y + thread * row_height;
+		draw_list->AddText(ImVec2(origin.x, y), IM_COL32(255, 255, 255, 255), Profiler::get()->getThreadName(thread).c_str());
+	}
+
+	for (const ProfileRecord& record : m_profile_records)
+	{
+		float x0 = origin.x + label_width + (float)((std::max(record.m_begin, begin) - begin) / PIPELINE_TIMELINE_MS) * width;
+		float x1 = origin.x + label_width + (float)((record.m_end - begin) / PIPELINE_TIMELINE_MS) * width;
+		float y = origin.y + record.m_thread * row_height;
+
+		// the waits grey, the work coloured by the first letter of the marker
+		bool wait = strncmp(record.m_name, "Wait", 4) == 0;
+		ImU32 color = wait ? IM_COL32(90, 90, 90, 255) : IM_COL32(60 + (record.m_name[0] * 37) % 160, 80 + (record.m_name[0] * 91) % 140, 200, 255);
+		draw_list->AddRectFilled(ImVec2(x0, y + 1.0f), ImVec2(std::max(x1, x0 + 1.0f), y + row_height - 1.0f), color);
+		if (x1 - x0 > 40.0f)
+			draw_list->AddText(ImVec2(x0 + 2.0f, y + 2.0f), IM_COL32(255, 255, 255, 255), record.m_name);
+	}
+
+	ImGui::Dummy(ImVec2(label_width + width, thread_count * row_height));
+	ImGui::Text("Last %.0f ms", PIPELINE_TIMELINE_MS);
+	ImGui::End();
+}
+
+
+/*
+	- the graph of this frame: the passes in the order they run, the culled ones, and the physical target of every transient.
+	  Transients with the same target share its memory
+*/
+
+void AppWindow::drawRenderGraphGui()
+{
+	const RenderGraphStats& stats = m_graph.getStats();
+
+	ImGui::Begin("Render Graph");
+	ImGui::Checkbox("Bloom", &m_bloom);
+	ImGui::SliderFloat("Bloom Threshold", &m_bloom_threshold, 0.0f, 1.0f);
+	ImGui::SliderFloat("Bloom Intensity", &m_bloom_intensity, 0.0f, 2.0f);
+	ImGui::Checkbox("Depth View", &m_show_depth);
+
+	ImGui::Text("Passes: %u run, %u culled, compiled in %.3f ms", stats.m_passes - stats.m_passes_culled, stats.m_passes_culled, stats.m_compile_ms);
+	const std::vector<unsigned int>& order = m_graph.getOrder();
+	for (unsigned int i = 0; i < order.size(); i++)
+		ImGui::Text("  %u. %s", i + 1, m_graph.getPassName(order[i]));
+	for (unsigned int pass = 0; pass < m_graph.getPassCount(); pass++)
+	{
+		if (m_graph.isPassCulled(pass))
+			ImGui::TextDisabled("  culled: %s", m_graph.getPassName(pass));
+	}
+
+	ImGui::Separator();
+	for (RenderGraphResource resource = 0; resource < m_graph.getResourceCount(); resource++)
+	{
+		if (m_graph.isImported(resource)) continue;
+		unsigned int physical = m_graph.getPhysicalIndex(resource);
+		if (physical == RENDER_GRAPH_NONE)
+			ImGui::TextDisabled("  %s: unused", m_graph.getResourceName(resource));
+		else
+			ImGui::Text("  %s: target %u", m_graph.getResourceName(resource), physical);
+	}
+
+	ImGui::Text("Transients: %u in %u targets", stats.m_transients, stats.m_physical_targets);
+	ImGui::Text("Memory: %.2f MB without aliasing, %.2f MB allocated (%.2f MB saved)", stats.m_transient_bytes / 1048576.0,
+		stats.m_physical_bytes / 1048576.0, (stats.m_transient_bytes - stats.m_physical_bytes) / 1048576.0);
+	ImGui::Text("Peak alive in one pass: %.2f MB", stats.m_peak_live_bytes / 1048576.0);
+	ImGui::End();
+}
+
+
+/*
+	- game thread: the nearest m_occluder_count instances are rasterized into the occlusion buffer, with the level whose error
+	  stays below one pixel of the buffer (a coarse level covers the same pixels there, for a fraction of the triangles)
+	- every instance tests its box against the buffer on the JobSystem, the visible ones go to the snapshot with their level
+	- the occlusion buffer belongs to the game thread. With the game thread running, the static batches are culled by the
+	  render thread against the frustum only
+*/
+void AppWindow::cullBenchmarkScene(MeshModel* mesh, FrameSnapshot& frame, bool pipelined)
+{
+	const SceneSettings& settings = frame.m_settings;
+	const Matrix4x4& view = frame.m_constants.m_view;
+	const Matrix4x4& proj = frame.m_constants.m_proj;
+
+	m_instance_visible.assign(m_instances.size(), 1);
+
+	frame.m_occlusion_rendered = settings.m_occlusion_culling && !(settings.m_static_batching && pipelined);
+	if (frame.m_occlusion_rendered)
+	{
+		Matrix4x4 camera = view;
+		camera.inverse();
+		Vector3D eye = camera.getTranslation();
+
+		m_instance_order.resize(m_instances.size());
+		for (unsigned int i = 0; i < m_instance_order.size(); i++)
+		{
+			m_instance_order[i] = i;
+		}
+		std::sort(m_instance_order.begin(), m_instance_order.end(), [this, &eye](unsigned int a, unsigned int b)
+			{
+				return (m_instances[a].getTranslation() - eye).length() < (m_instances[b].getTranslation() - eye).length();
+			});
+
+		m_occlusion.begin(view, proj);
+		for (unsigned int i = 0; i < m_instance_order.size() && i < (unsigned int)settings.m_occluder_count; i++)
+		{
+			const Matrix4x4& world = m_instances[m_instance_order[i]];
+			const MeshFileLod& lod = mesh->getLod(mesh->selectLod(world, view, proj, (float)m_occlusion.getHeight()));
+			m_occlusion.addOccluder(mesh->getPositions().data(), mesh->getIndexData().data() + lod.m_index_start, lod.m_index_count, world);
+		}
+		m_occlusion.render();
+
+		// the static batches test their own object boxes in cull()
+		if (!settings.m_static_batching)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+
+			Vector3D box_min, box_max;
+			mesh->getBoundingBox(box_min, box_max);
+			JobSystem::get()->parallelFor((unsigned int)m_instances.size(), 16, [&](unsigned int begin, unsigned int end)
+				{
+					for (unsigned int i = begin; i < end; i++)
+					{
+						m_instance_visible[i] = !m_occlusion.isBoxOccluded(box_min, box_max, m_instances[i]);
+					}
+				});
+
+			frame.m_occlusion_test_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		}
+
+		frame.m_occlusion_stats = m_occlusion.getStats();
+	}
+
+	if (settings.m_static_batching)
+		return;
+
+	for (size_t i = 0; i < m_instances.size(); i++)
+	{
+		if (!m_instance_visible[i])
+			continue;
+
+		const MeshFileLod& lod = mesh->getLod(mesh->selectLod(m_instances[i], view, proj, (float)frame.m_height, settings.m_lod_pixel_error));
+		frame.m_draws.push_back({ m_instances[i], lod.m_index_count, lod.m_index_start });
+	}
+}
+
+
+/*
+	- render thread: one draw call per visible instance of the snapshot, the constant buffer gets the world matrix of the instance
+*/
+void AppWindow::drawBenchmarkScene(const FrameSnapshot& frame, MeshModel* mesh, VertexShader* vs, PixelShader* ps, ConstantBuffer* cb, TextureShader* ts,
+	RenderTarget* color, RenderTarget* depth)
+{
+	DeviceContext* context = GraphicsEngine::get()->getImmediateDeviceContext();
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_draws = 0;
+	if (frame.m_settings.m_static_batching)
+	{
+		// the occlusion buffer is only of this frame without the game thread
+		bool occlusion = frame.m_occlusion_rendered && !m_pipeline.isRunning();
+		m_batcher.cull(frame.m_constants.m_view, frame.m_constants.m_proj, occlusion ? &m_occlusion : nullptr);
+
+		// the batch vertices are already in world space, always in the float format
+		m_ct->m_world.setIdentity();
+		cb->update(context, m_ct);
+		context->setVertexShader(GraphicsEngine::get()->get(m_vs));
+
+		m_batcher.draw(context);
+		m_draws = m_batcher.getStats().m_draws;
+	}
+	else if (m_parallel_submit && !m_command_lists.empty())
+	{
+		// one group of instances per list. Every list starts from the default state and binds the whole pipeline itself
+		unsigned int draw_count = (unsigned int)frame.m_draws.size();
+		unsigned int list_count = (unsigned int)m_command_lists.size();
+		unsigned int group_size = std::max(1u, (draw_count + list_count - 1) / list_count);
+
+		// the clustered lights render() uploaded
+		ConstantBuffer* clusters_cb = GraphicsEngine::get()->get(m_clusters_cb);
+		StructuredBuffer* lights_buffer = GraphicsEngine::get()->get(m_lights_buffer);
+		StructuredBuffer* clusters_buffer = GraphicsEngine::get()->get(m_clusters_buffer);
+		StructuredBuffer* light_indices_buffer = GraphicsEngine::get()->get(m_light_indices_buffer);
+		bool lights = lights_buffer && clusters_buffer && light_indices_buffer && !frame.m_light_grid.m_lights.empty();
+
+		// the shadow maps of the shadow pass and its constants
+		ConstantBuffer* shadows_cb = GraphicsEngine::get()->get(m_shadows_cb);
+		RenderTarget* shadow_maps[ShadowCascades::CASCADE_COUNT] = {};
+		for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+			shadow_maps[c] = frame.m_settings.m_shadows ? GraphicsEngine::get()->get(m_shadow_maps[c]) : nullptr;
+
+		JobSystem::get()->parallelFor(draw_count, group_size, [&](unsigned int begin, unsigned int end)
+			{
+				CommandList* list = m_command_lists[begin / group_size];
+				list->begin(color, depth, color->getWidth(), color->getHeight());
+				list->setConstantBuffer(vs, cb);
+				list->setConstantBuffer(ps, cb);
+				if (mesh->getQuantization())
+					list->setConstantBuffer(vs, mesh->getQuantization(), 1);
+				list->setConstantBuffer(ps, clusters_cb, 2);
+				if (lights)
+				{
+					list->setStructuredBuffer(ps, lights_buffer, 1);
+					list->setStructuredBuffer(ps, clusters_buffer, 2);
+					list->setStructuredBuffer(ps, light_indices_buffer, 3);
+				}
+				list->setConstantBuffer(ps, shadows_cb, 3);
+				for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+					list->setTexture(shadow_maps[c], 4 + c);
+				list->setComparisonSampler(1);
+				list->setVertexShader(vs);
+				list->setPixelShader(ps);
+				list->setTextureShader(ts);
+				list->setVertexStreams(mesh->getPositionStream(), mesh->getVertex());
+				list->setIndexBuffer(mesh->getIndex());
+
+				// every thread its own copy of the constants, only the world matrix changes
+				ConstantType constants = frame.m_constants;
+				for (unsigned int i = begin; i < end; i++)
+				{
+					const FrameDraw& draw = frame.m_draws[i];
+					constants.m_world = draw.m_world;
+					cb->update(list, &constants);
+					list->drawIndexedTriangleList(draw.m_index_count, 0, draw.m_index_start);
+				}
+				list->finish();
+			});
+
+		m_record_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+		auto execute_start = std::chrono::high_resolution_clock::now();
+
+		// submit in order on the render thread
+		m_lists_used = (draw_count + group_size - 1) / group_size;
+		for (unsigned int i = 0; i < m_lists_used; i++)
+		{
+			context->executeCommandList(m_command_lists[i]);
+		}
+
+		// the state is reset after a list -> bind the targets of the scene pass again
+		context->setRenderTargets(color, depth);
+		context->setViewportSize(color->getWidth(), color->getHeight());
+
+		m_execute_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - execute_start).count();
+		m_draws = draw_count;
+	}
+	else
+	{
+		for (const FrameDraw& draw : frame.m_draws)
+		{
+			m_ct->m_world = draw.m_world;
+			cb->update(context, m_ct);
+			context->drawIndexedTriangleList(draw.m_index_count, 0, draw.m_index_start);
+			m_draws++;
+		}
+	}
+
+	m_submit_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+/*
+	- all chunks in one instanced draw: the grid indices are shared, the vertex shader places each chunk by its
+	  TerrainInstance and reads the heights from the slice of its tile
+*/
+
+void AppWindow::drawTerrain(const FrameSnapshot& frame)
+{
+	DeviceContext* context = GraphicsEngine::get()->getImmediateDeviceContext();
+	VertexShader* vs = GraphicsEngine::get()->get(m_terrain_vs);
+	PixelShader* ps = GraphicsEngine::get()->get(m_terrain_ps);
+	ConstantBuffer* cb = GraphicsEngine::get()->get(m_cb);
+	ConstantBuffer* terrain_cb = GraphicsEngine::get()->get(m_terrain_cb);
+	StructuredBuffer* instances = GraphicsEngine::get()->get(m_terrain_instances);
+	TextureArray* tiles = GraphicsEngine::get()->get(m_terrain_tiles);
+	IndexBuffer* index = GraphicsEngine::get()->get(m_terrain_index);
+	if (!vs || !ps || !terrain_cb || !instances || !tiles || !index || frame.m_terrain.m_instances.empty())
+		return;
+
+	context->setConstantBuffer(vs, cb);
+	context->setConstantBuffer(ps, cb);
+	context->setConstantBuffer(vs, terrain_cb, 1);
+	context->setConstantBuffer(ps, terrain_cb, 1);
+	context->setStructuredBuffer(vs, instances, 0);
+	context->setTextureArray(vs, tiles, 1);
+	TextureArray* detail = GraphicsEngine::get()->get(m_terrain_detail);
+	if (detail)
+		context->setTextureArray(ps, detail, 2);
+	context->setVertexShader(vs);
+	context->setPixelShader(ps);
+	context->setIndexBuffer(index);
+	context->drawIndexedInstancedVertexID(m_terrain_index_count, (UINT)frame.m_terrain.m_instances.size());
+}
+
+
+void AppWindow::drawTerrainGui(const FrameSnapshot& frame)
+{
+	ImGui::Begin("Terrain");
+	if (m_terrain_tiles.isValid())
+	{
+		// the header does not change after onCreate, the game thread only reads it
+		const TerrainFileHeader& header = m_terrain.getHeader();
+		const TerrainStats& stats = frame.m_terrain.m_stats;
+
+		ImGui::Checkbox("Terrain", &m_settings.m_terrain);
+		ImGui::SliderFloat("LOD Distance", &m_settings.m_terrain_lod_distance, 1.0f, 8.0f);
+		ImGui::Text("Map: %u x %u quads, %u quadtree levels, %u tile levels", header.m_size, header.m_size, header.m_node_levels, header.m_tile_levels);
+		if (frame.m_settings.m_terrain)
+		{
+			ImGui::Text("Chunks: %u, %llu vertices, %llu triangles", stats.m_instances, stats.m_vertices, stats.m_triangles);
+			ImGui::Text("Nodes: %u visited, %u culled, %u waiting for tiles", stats.m_nodes_visited, stats.m_nodes_culled, stats.m_waiting);
+			ImGui::Text("Tiles: %u of %u slots, %u loading, %u streamed", stats.m_tiles_resident, Terrain::TILE_SLOTS, stats.m_tiles_loading, stats.m_tiles_streamed);
+			ImGui::Text("Selection: %.3f ms", stats.m_select_ms);
+		}
+	}
+	else
+	{
+		ImGui::Text("No terrain in Graphics\\Terrain (AssetCooker -terrain 4096)");
+	}
+
+	// the render thread waits for the bounds of the procedural map (a few seconds), the selection is measured alone
+	ImGui::Separator();
+	if (ImGui::Button("Run 16k Benchmark"))
+		m_terrain_benchmark = Terrain::runBenchmark(16384, 256);
+	const TerrainBenchmark& benchmark = m_terrain_benchmark;
+	if (benchmark.m_frames)
+	{
+		ImGui::Text("%u x %u quads, bounds built in %.0f ms", benchmark.m_size, benchmark.m_size, benchmark.m_build_ms);
+		ImGui::Text("Selection: %.3f ms average, %.3f ms max over %u frames", benchmark.m_average_select_ms, benchmark.m_max_select_ms, benchmark.m_frames);
+		ImGui::Text("Chunks: %.0f, triangles: %.0f", benchmark.m_average_instances, benchmark.m_average_triangles);
+		ImGui::Text("Vertices: %.0f of %llu at full resolution (%.4f%%)", benchmark.m_average_vertices, benchmark.m_full_vertices,
+			100.0 * benchmark.m_average_vertices / (double)benchmark.m_full_vertices);
+	}
+	ImGui::End();
+}
+
+
+void AppWindow::drawNoiseGui()
+{
+	ImGui::Begin("Noise");
+
+	const char* backends[] = { "Scalar", "SSE2", "AVX2" };
+	int backend = (int)Noise::getBackend();
+	if (ImGui::Combo("Backend", &backend, backends, IM_ARRAYSIZE(backends)))
+		Noise::setBackend((NoiseBackend)backend);
+	if (!Noise::isSupported(NoiseBackend::AVX2))
+		ImGui::Text("AVX2 not supported by this CPU");
+
+	// blocks the render thread for about a second
+	if (ImGui::Button("Run Noise Benchmark"))
+		Noise::runBenchmark(1024, m_noise_benchmark);
+	for (const NoiseBenchmarkResult& result : m_noise_benchmark)
+	{
+		ImGui::Text("%-6s %-8s %s: %7.1f M samples/s, %7.1f M samples/s on %u threads", Noise::getBackendName(result.m_backend), Noise::getTypeName(result.m_type),
+			result.m_volume ? "3D" : "2D", result.m_samples_per_second / 1e6, result.m_samples_per_second_mt / 1e6, JobSystem::get()->getThreadCount());
+	}
+	ImGui::End();
+}
+
+
+void AppWindow::drawCollisionGui(const FrameSnapshot& frame)
+{
+	ImGui::Begin("Collision");
+	ImGui::Checkbox("Camera Collision", &m_settings.m_collision);
+	ImGui::SliderFloat("Camera Radius", &m_settings.m_collision_radius, 0.05f, 2.0f);
+	ImGui::Text("Mesh: %u triangles, %u BVH nodes", m_collision_mesh.getTriangleCount(), (unsigned int)m_collision_mesh.getBVH().getNodes().size());
+	ImGui::Text("Instances: %u", m_collision[frame.m_settings.m_benchmark ? 1 : 0].getInstanceCount());
+
+	// blocks the render thread for about a second
+	ImGui::Separator();
+	MeshModel* mesh = GraphicsEngine::get()->get(m_mesh);
+	if (mesh && ImGui::Button("Run Collision Benchmark"))
+	{
+		const MeshFileLod& lod = mesh->getLod(0);
+		m_collision_benchmark = CollisionWorld::runBenchmark(mesh->getPositions(), mesh->getIndexData().data() + lod.m_index_start, lod.m_index_count, 100000);
+	}
+	const CollisionBenchmark& benchmark = m_collision_benchmark;
+	if (benchmark.m_sweeps)
+	{
+		ImGui::Text("%u instances of %u triangles, BVH built in %.2f ms (%u nodes), broadphase in %.3f ms", benchmark.m_instances, benchmark.m_triangles,
+			benchmark.m_build_ms, benchmark.m_bvh_nodes, benchmark.m_broadphase_ms);
+		ImGui::Text("%u sweeps, %.0f%% hit", benchmark.m_sweeps, benchmark.m_hit_ratio * 100.0);
+		ImGui::Text("Sphere: %.0f sweeps/s, %.0f sweeps/s on %u threads", benchmark.m_sphere_sweeps_per_second, benchmark.m_sphere_sweeps_per_second_mt, benchmark.m_threads);
+		ImGui::Text("Capsule: %.0f sweeps/s", benchmark.m_capsule_sweeps_per_second);
+		ImGui::Text("Brute force: %.1f sweeps/s (%.0fx slower)", benchmark.m_brute_force_sweeps_per_second,
+			benchmark.m_sphere_sweeps_per_second / std::max(benchmark.m_brute_force_sweeps_per_second, 1e-9));
+	}
+
+	// 50000 moving boxes, then 5% of them moving
+	ImGui::Separator();
+	if (ImGui::Button("Run Broadphase Benchmark"))
+		m_broadphase_benchmark = Broadphase::runBenchmark(50000, 0.05f, 20);
+	const BroadphaseBenchmark& broadphase = m_broadphase_benchmark;
+	if (broadphase.m_frames)
+	{
+		ImGui::Text("%u boxes, %u pairs, %u threads%s", broadphase.m_proxies, broadphase.m_pairs, broadphase.m_threads,
+			broadphase.m_match ? "" : ", the methods found different pairs");
+		const char* methods[] = { "Sort and sweep", "Spatial hash" };
+		for (int method = 0; method < 2; method++)
+		{
+			ImGui::Text("%-14s first pass %6.2f ms, all moving %6.2f ms, %u moving %6.3f ms", methods[method], broadphase.m_add_ms[method],
+				broadphase.m_full_ms[method], broadphase.m_moving, broadphase.m_incremental_ms[method]);
+		}
+	}
+
+	// 10000 boxes falling and settling for ten seconds of simulation, blocks the render thread for a while
+	ImGui::Separator();
+	if (ImGui::Button("Run Physics Benchmark"))
+		m_physics_benchmark = PhysicsWorld::runBenchmark(10000, 600);
+	const PhysicsBenchmark& physics = m_physics_benchmark;
+	if (physics.m_steps)
+	{
+		const PhysicsStats& peak = physics.m_peak;
+		ImGui::Text("%u boxes, %u steps, %u threads, %u asleep at the end", physics.m_bodies, physics.m_steps, physics.m_threads, physics.m_sleeping);
+		ImGui::Text("Step: %.2f ms average, %.2f ms slowest, %.2f ms settled", physics.m_average_ms, physics.m_max_ms, physics.m_settled_ms);
+		ImGui::Text("Slowest: %u awake, %u pairs, %u contacts, %u islands (largest %u)", peak.m_awake, peak.m_pairs, peak.m_contacts, peak.m_islands, peak.m_largest_island);
+		ImGui::Text("Broadphase %.2f ms, contacts %.2f ms, islands %.2f ms, solver %.2f ms", peak.m_broadphase_ms, peak.m_narrowphase_ms, peak.m_islands_ms,
+			peak.m_solve_ms);
+	}
+	ImGui::End();
+}
+
+
+/*
+	- one instance per particle: the vertex shader reads its ParticleVertex and builds the quad from SV_VertexID.
+	  The vertices are sorted far to near, blending over the scene depth without writing it
+*/
+
+void AppWindow::drawParticles(const FrameSnapshot& frame)
+{
+	DeviceContext* context = GraphicsEngine::get()->getImmediateDeviceContext();
+	VertexShader* vs = GraphicsEngine::get()->get(m_particle_vs);
+	PixelShader* ps = GraphicsEngine::get()->get(m_particle_ps);
+	ConstantBuffer* cb = GraphicsEngine::get()->get(m_cb);
+	StructuredBuffer* particles = GraphicsEngine::get()->get(m_particle_buffer);
+	if (!vs || !ps || !particles || frame.m_particles.empty())
+		return;
+
+	context->setConstantBuffer(vs, cb);
+	context->setStructuredBuffer(vs, particles, 0);
+	context->setVertexShader(vs);
+	context->setPixelShader(ps);
+	context->setBlendState(BlendState::Alpha);
+	context->setDepthState(DepthState::Test);
+	context->drawInstancedVertexID(6, (UINT)std::min((unsigned int)frame.m_particles.size(), m_particle_capacity));
+	context->setDepthState(DepthState::Default);
+	context->setBlendState(BlendState::Opaque);
+}
+
+
+void AppWindow::drawParticleGui(const FrameSnapshot& frame)
+{
+	ImGui::Begin("Particles");
+	const ParticleStats& stats = frame.m_particle_stats;
+	ImGui::Checkbox("Particles", &m_settings.m_particles);
+	ImGui::Checkbox("Sort Back To Front", &m_settings.m_particle_sort);
+	if (frame.m_settings.m_particles)
+	{
+		ImGui::Text("%u particles, %u emitters, %u blocks, %u spawned", stats.m_particles, stats.m_emitters, stats.m_blocks, stats.m_spawned);
+		ImGui::Text("Spawn %.3f ms, simulate %.3f ms, sort %.3f ms, vertices %.3f ms", stats.m_spawn_ms, stats.m_simulate_ms, stats.m_sort_ms, stats.m_fill_ms);
+	}
+
+	// a million particles for a second of frames, blocks the render thread for a while
+	ImGui::Separator();
+	if (ImGui::Button("Run Particle Benchmark"))
+		m_particle_benchmark = ParticleSystem::runBenchmark(1000000, 60);
+	const ParticleBenchmark& benchmark = m_particle_benchmark;
+	if (benchmark.m_frames)
+	{
+		ImGui::Text("%u particles, %u frames, %u threads", benchmark.m_particles, benchmark.m_frames, benchmark.m_threads);
+		ImGui::Text("Simulate: scalar %.2f ms, SSE2 %.2f ms (%.2fx)", benchmark.m_simulate_ms[0], benchmark.m_simulate_ms[1],
+			benchmark.m_simulate_ms[1] > 0.0 ? benchmark.m_simulate_ms[0] / benchmark.m_simulate_ms[1] : 0.0);
+		ImGui::Text("Sort %.2f ms, vertices %.2f ms, frame %.2f ms", benchmark.m_sort_ms, benchmark.m_fill_ms, benchmark.m_frame_ms);
+		ImGui::Text("Streamed: %.1f MB per frame", benchmark.m_megabytes);
+	}
+	ImGui::End();
+}
+
+
+void AppWindow::createCommandLists(bool recorded)
+{
+	releaseCommandLists();
+
+	for (unsigned int i = 0; i < JobSystem::get()->getThreadCount(); i++)
+	{
+		CommandList* list = GraphicsEngine::get()->createCommandList(recorded);
+		if (list)
+			m_command_lists.push_back(list);
+	}
+}
+
+
+void AppWindow::releaseCommandLists()
+{
+	for (CommandList* list : m_command_lists)
+	{
+		delete list;
+	}
+	m_command_lists.clear();
+}
+
+
 AppWindow::~AppWindow()
 {
 }
@@ -161,6 +986,12 @@ void AppWindow::onCreate()
 	// init the singleton GraphicsEngine
 	GraphicsEngine::get();
 
+	// this thread creates the window and draws
+	Profiler::get()->setThreadName("Render");
+
+	// mount the asset pack if there is one, every asset not in a pack is read as a loose file
+	FileSystem::get()->mount(L"Graphics.gpak");
+
 	// init ImGui
 	GraphicsEngine::get()->InitGui(this->m_hwnd);
 
@@ -171,6 +1002,9 @@ void AppWindow::onCreate()
 	// set MeshModel()
 	GraphicsEngine::get()->setMeshModel();
 
+	// read the files of the scene in one batch and decode them in the completion jobs -> the loaders below only upload
+	FileSystem::get()->prefetch({ TextureShader::getPrefetchRequest(L"Graphics\\Textures\\marmor2.jpg"), MeshModel::getPrefetchRequest(L"Graphics\\Objects\\temple.obj") });
+
 	// create Texture from file 
 	m_ts = GraphicsEngine::get()->createTextureShader(L"Graphics\\Textures\\marmor2.jpg");
 	
@@ -178,6 +1012,137 @@ void AppWindow::onCreate()
 	// create mesh from file
 	m_mesh = GraphicsEngine::get()->createMeshModel(L"Graphics\\Objects\\temple.obj");
 
+	// room for the largest index list the meshlet culling can produce: all indices of the mesh
+	MeshModel* mesh = GraphicsEngine::get()->get(m_mesh);
+
+	// a mesh cooked with a texture atlas is drawn with the atlas: its texture coordinates point into it
+	if (mesh && !mesh->getAtlasTexture().empty())
+	{
+		TextureShaderHandle atlas = GraphicsEngine::get()->createTextureShader(mesh->getAtlasTexture().c_str());
+		if (atlas.isValid())
+		{
+			GraphicsEngine::get()->release(m_ts);
+			m_ts = atlas;
+		}
+	}
+	if (mesh && mesh->getIndex()->getSizeIndexList())
+		m_culled_indices = GraphicsEngine::get()->createDynamicIndexBuffer(mesh->getIndex()->getSizeIndexList());
+
+	// benchmark scene: 16 x 16 copies of the mesh on the ground, one and a half mesh sizes apart
+	if (mesh)
+	{
+		Vector3D box_min, box_max;
+		mesh->getBoundingBox(box_min, box_max);
+		float spacing = std::max(box_max.m_x - box_min.m_x, box_max.m_z - box_min.m_z) * 1.5f;
+
+		// the lights move around the mesh or over the grid
+		Vector3D margin = (box_max - box_min) * 0.25f;
+		m_light_area_min[0] = box_min - margin;
+		m_light_area_max[0] = box_max + margin;
+		m_light_area_min[1] = Vector3D(-8.0f * spacing, box_min.m_y, 0.5f * spacing);
+		m_light_area_max[1] = Vector3D(8.0f * spacing, box_max.m_y + margin.m_y, 16.5f * spacing);
+
+		// what casts and receives shadows: the mesh, the grid of copies below
+		m_scene_min[0] = box_min;
+		m_scene_max[0] = box_max;
+		m_scene_min[1] = box_min + Vector3D(-7.5f * spacing, 0.0f, spacing);
+		m_scene_max[1] = box_max + Vector3D(7.5f * spacing, 0.0f, 16.0f * spacing);
+
+		for (int z = 0; z < 16; z++)
+		{
+			for (int x = 0; x < 16; x++)
+			{
+				Matrix4x4 world;
+				world.setIdentity();
+				world.setTranslation(Vector3D((x - 7.5f) * spacing, 0.0f, (z + 1) * spacing));
+				m_instances.push_back(world);
+			}
+		}
+
+		// the same grid merged into one batch, baked at the second level (a batch cannot switch levels per copy)
+		for (const Matrix4x4& world : m_instances)
+		{
+			m_batcher.add(mesh, world, m_ts, 1);
+		}
+		m_batcher.build();
+
+		// collision against the finest level, the same mesh for the single mesh and all copies
+		const MeshFileLod& lod = mesh->getLod(0);
+		m_collision_mesh.build(mesh->getPositions(), mesh->getIndexData().data() + lod.m_index_start, lod.m_index_count);
+		Matrix4x4 identity;
+		identity.setIdentity();
+		m_collision[0].add(&m_collision_mesh, identity);
+		m_collision[0].build();
+		for (const Matrix4x4& world : m_instances)
+			m_collision[1].add(&m_collision_mesh, world);
+		m_collision[1].build();
+	}
+
+	createCommandLists(m_recorded_lists);
+
+	FileSystem::get()->clearPrefetched();
+
+	// terrain cooked by AssetCooker -terrain: centered below the mesh, its highest hills reach the ground of the mesh
+	if (m_terrain.open(L"Graphics\\Terrain"))
+	{
+		const TerrainFileHeader& header = m_terrain.getHeader();
+		float size = header.m_size * header.m_spacing;
+		m_terrain.setOrigin(Vector3D(-size * 0.5f, m_scene_min[0].m_y - header.m_height_scale, -size * 0.5f));
+	}
+
+	// particles around the mesh: a fountain above it, fire and its smoke beside it
+	{
+		Vector3D center = (m_scene_min[0] + m_scene_max[0]) * 0.5f;
+		Vector3D extent = m_scene_max[0] - m_scene_min[0];
+
+		ParticleEmitterSettings fountain;
+		fountain.m_position = Vector3D(center.m_x, m_scene_max[0].m_y, center.m_z);
+		fountain.m_spread = 0.25f;
+		fountain.m_rate = 8000.0f;
+		fountain.m_speed_min = 5.0f;
+		fountain.m_speed_max = 6.0f;
+		fountain.m_lifetime_min = 1.5f;
+		fountain.m_lifetime_max = 2.0f;
+		fountain.m_size_start = 0.04f;
+		fountain.m_size_end = 0.08f;
+		fountain.m_drag = 0.2f;
+		fountain.m_colors = { { 0.0f, Vector4D(0.6f, 0.8f, 1.0f, 0.8f) }, { 1.0f, Vector4D(0.3f, 0.5f, 1.0f, 0.0f) } };
+		fountain.m_capacity = 32768;
+		m_particles.createEmitter(fountain);
+
+		ParticleEmitterSettings fire;
+		fire.m_position = Vector3D(m_scene_max[0].m_x + extent.m_x * 0.25f, m_scene_min[0].m_y, center.m_z);
+		fire.m_extent = Vector3D(0.3f, 0.0f, 0.3f);
+		fire.m_spread = 0.4f;
+		fire.m_rate = 6000.0f;
+		fire.m_speed_min = 0.5f;
+		fire.m_speed_max = 1.5f;
+		fire.m_lifetime_min = 0.5f;
+		fire.m_lifetime_max = 1.0f;
+		fire.m_size_start = 0.15f;
+		fire.m_size_end = 0.05f;
+		fire.m_acceleration = Vector3D(0.0f, 2.0f, 0.0f);
+		fire.m_colors = { { 0.0f, Vector4D(1.0f, 0.9f, 0.4f, 0.9f) }, { 0.5f, Vector4D(1.0f, 0.4f, 0.1f, 0.7f) }, { 1.0f, Vector4D(0.4f, 0.1f, 0.0f, 0.0f) } };
+		fire.m_capacity = 8192;
+		m_particles.createEmitter(fire);
+
+		ParticleEmitterSettings smoke = fire;
+		smoke.m_position.m_y += 1.0f;
+		smoke.m_spread = 0.3f;
+		smoke.m_rate = 1500.0f;
+		smoke.m_lifetime_min = 3.0f;
+		smoke.m_lifetime_max = 5.0f;
+		smoke.m_size_start = 0.2f;
+		smoke.m_size_end = 0.8f;
+		smoke.m_acceleration = Vector3D(0.3f, 0.5f, 0.0f);
+		smoke.m_drag = 0.5f;
+		smoke.m_colors = { { 0.0f, Vector4D(0.3f, 0.3f, 0.3f, 0.0f) }, { 0.2f, Vector4D(0.3f, 0.3f, 0.3f, 0.4f) }, { 1.0f, Vector4D(0.5f, 0.5f, 0.5f, 0.0f) } };
+		smoke.m_capacity = 8192;
+		m_particles.createEmitter(smoke);
+
+		m_particle_capacity = fountain.m_capacity + fire.m_capacity + smoke.m_capacity;
+	}
+
 
 
 	// init SwapChain
@@ -196,6 +1161,16 @@ void AppWindow::onCreate()
 	// when create resources is finished -> release memory Buffer
 	GraphicsEngine::get()->releaseCompiledShader();
 
+	// decodes the packed vertex formats of VertexPacker
+	GraphicsEngine::get()->compileVertexShader(L"PackedVertexShader.hlsl", "vsmain", &shader_byte_code, &size_shader);
+	m_packed_vs = GraphicsEngine::get()->createVertexShader(shader_byte_code, size_shader);
+	GraphicsEngine::get()->releaseCompiledShader();
+
+	// position only passes
+	GraphicsEngine::get()->compileVertexShader(L"DepthShader.hlsl", "vsmain", &shader_byte_code, &size_shader);
+	m_depth_vs = GraphicsEngine::get()->createVertexShader(shader_byte_code, size_shader);
+	GraphicsEngine::get()->releaseCompiledShader();
+
 
 	// Pixel Shader Compiling with PixelShader.hlsl
 	GraphicsEngine::get()->compilePixelShader(L"PixelShader.hlsl", "psmain", &shader_byte_code, &size_shader);
@@ -203,13 +1178,98 @@ void AppWindow::onCreate()
 	m_ps = GraphicsEngine::get()->createPixelShader(shader_byte_code, size_shader);
 	GraphicsEngine::get()->releaseCompiledShader();
 
+	// full screen passes of the render graph
+	GraphicsEngine::get()->compileVertexShader(L"PostProcessShader.hlsl", "vsmain", &shader_byte_code, &size_shader);
+	m_post_vs = GraphicsEngine::get()->createVertexShader(shader_byte_code, size_shader);
+	GraphicsEngine::get()->releaseCompiledShader();
+
+	const char* post_entry_points[] = { "psbright", "psblur", "pscomposite", "psdepth" };
+	PixelShaderHandle* post_shaders[] = { &m_bright_ps, &m_blur_ps, &m_composite_ps, &m_depth_view_ps };
+	for (int i = 0; i < 4; i++)
+	{
+		GraphicsEngine::get()->compilePixelShader(L"PostProcessShader.hlsl", post_entry_points[i], &shader_byte_code, &size_shader);
+		*post_shaders[i] = GraphicsEngine::get()->createPixelShader(shader_byte_code, size_shader);
+		GraphicsEngine::get()->releaseCompiledShader();
+	}
+
+	PostProcessConstantType post_constants;
+	m_post_cb = GraphicsEngine::get()->createConstantBuffer(&post_constants, sizeof(PostProcessConstantType));
+
+	// clustered lights, sized for the limits of LightGrid
+	m_lights_buffer = GraphicsEngine::get()->createStructuredBuffer(sizeof(ShaderLight), LightGrid::MAX_LIGHTS);
+	m_clusters_buffer = GraphicsEngine::get()->createStructuredBuffer(sizeof(LightCluster), LightGrid::LIGHT_GRID_CLUSTERS);
+	m_light_indices_buffer = GraphicsEngine::get()->createStructuredBuffer(sizeof(unsigned int), LightGrid::MAX_LIGHT_INDICES);
+	ClusterConstantType cluster_constants;
+	m_clusters_cb = GraphicsEngine::get()->createConstantBuffer(&cluster_constants, sizeof(ClusterConstantType));
+
+	// shadow maps of the cascades, kept across frames
+	for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+		m_shadow_maps[c] = GraphicsEngine::get()->createRenderTarget(ShadowCascades::SHADOW_MAP_SIZE, ShadowCascades::SHADOW_MAP_SIZE, DXGI_FORMAT_D32_FLOAT);
+	ConstantType shadow_pass_constants;
+	m_shadow_pass_cb = GraphicsEngine::get()->createConstantBuffer(&shadow_pass_constants, sizeof(ConstantType));
+	ShadowConstantType shadow_constants;
+	m_shadows_cb = GraphicsEngine::get()->createConstantBuffer(&shadow_constants, sizeof(ShadowConstantType));
+
+	// terrain: the grid of one chunk (chunk_size / 2 quads per side, clockwise) and a slice per tile slot
+	if (m_terrain.isOpen())
+	{
+		const TerrainFileHeader& header = m_terrain.getHeader();
+		unsigned int grid = header.m_chunk_size / 2;
+		std::vector<unsigned int> terrain_indices;
+		for (unsigned int y = 0; y < grid; y++)
+		{
+			for (unsigned int x = 0; x < grid; x++)
+			{
+				unsigned int corner = y * (grid + 1) + x;
+				unsigned int quad[6] = { corner, corner + grid + 1, corner + 1, corner + 1, corner + grid + 1, corner + grid + 2 };
+				terrain_indices.insert(terrain_indices.end(), quad, quad + 6);
+			}
+		}
+		m_terrain_index = GraphicsEngine::get()->createIndexBuffer(terrain_indices.data(), (UINT)terrain_indices.size());
+		m_terrain_index_count = (UINT)terrain_indices.size();
+
+		m_terrain_tiles = GraphicsEngine::get()->createTextureArray(header.m_tile_size + 1, header.m_tile_size + 1, Terrain::TILE_SLOTS, DXGI_FORMAT_R16_UNORM);
+		m_terrain_instances = GraphicsEngine::get()->createStructuredBuffer(sizeof(TerrainInstance), Terrain::MAX_INSTANCES);
+		TerrainConstantType terrain_constants;
+		m_terrain_cb = GraphicsEngine::get()->createConstantBuffer(&terrain_constants, sizeof(TerrainConstantType));
+
+		GraphicsEngine::get()->compileVertexShader(L"TerrainShader.hlsl", "vsmain", &shader_byte_code, &size_shader);
+		m_terrain_vs = GraphicsEngine::get()->createVertexShader(shader_byte_code, size_shader);
+		GraphicsEngine::get()->releaseCompiledShader();
+		GraphicsEngine::get()->compilePixelShader(L"TerrainShader.hlsl", "psmain", &shader_byte_code, &size_shader);
+		m_terrain_ps = GraphicsEngine::get()->createPixelShader(shader_byte_code, size_shader);
+		GraphicsEngine::get()->releaseCompiledShader();
+
+		// detail: Perlin fBm repeating every 8 cells -> the texture wraps without a seam
+		NoiseSettings detail;
+		detail.m_frequency = 8.0f / 256.0f;
+		detail.m_octaves = 5;
+		detail.m_period = 8;
+		std::vector<unsigned char> texels(256 * 256);
+		Noise::fillTexels(detail, 256, 256, texels.data());
+		m_terrain_detail = GraphicsEngine::get()->createTextureArray(256, 256, 1, DXGI_FORMAT_R8_UNORM);
+		TextureArray* detail_texture = GraphicsEngine::get()->get(m_terrain_detail);
+		if (detail_texture)
+			detail_texture->update(GraphicsEngine::get()->getImmediateDeviceContext(), 0, texels.data(), 256);
+	}
+
+	// particles: the vertices of a frame, rewritten every frame
+	m_particle_buffer = GraphicsEngine::get()->createStructuredBuffer(sizeof(ParticleVertex), m_particle_capacity);
+	GraphicsEngine::get()->compileVertexShader(L"ParticleShader.hlsl", "vsmain", &shader_byte_code, &size_shader);
+	m_particle_vs = GraphicsEngine::get()->createVertexShader(shader_byte_code, size_shader);
+	GraphicsEngine::get()->releaseCompiledShader();
+	GraphicsEngine::get()->compilePixelShader(L"ParticleShader.hlsl", "psmain", &shader_byte_code, &size_shader);
+	m_particle_ps = GraphicsEngine::get()->createPixelShader(shader_byte_code, size_shader);
+	GraphicsEngine::get()->releaseCompiledShader();
+
 
 	m_ct = new ConstantType;
 	m_ct->m_time = 0.0f;
 
 	// ambient light
-	m_ct->ambientColor = Vector3D(1.0f, 1.0f, 1.0f);
-	m_ct->ambientPower = 1.0f;
+	m_ct->ambientColor = m_settings.m_ambient_color;
+	m_ct->ambientPower = m_settings.m_ambient_power;
+	m_shared_settings = m_settings;
 
 	m_cb = GraphicsEngine::get()->createConstantBuffer(m_ct, sizeof(ConstantType));
 }
@@ -219,55 +1279,443 @@ void AppWindow::onUpdate()
 	// call onUpdate in Window
 	Window::onUpdate();
 
-	// clear the render target
-	GraphicsEngine::get()->getImmediateDeviceContext()->clearRenderTargetColor(this->m_swap_chain, 0.0f, 0.0f, 0.0f, 1);
-
-	// set viewport of render target in which we have to draw 
-	RECT rc = this->getClientWindowRect();
-	GraphicsEngine::get()->getImmediateDeviceContext()->setViewportSize(rc.right - rc.left, rc.bottom - rc.top);
-
-	// include timer for transform and animation
-	updateTransform();
-
-	// Input
-	m_input->Update(m_delta_time);
-
-
-	// bind constant buffer to the graphics pipeline for each shader (overloading)
-	GraphicsEngine::get()->getImmediateDeviceContext()->setConstantBuffer(m_vs, m_cb);
-	GraphicsEngine::get()->getImmediateDeviceContext()->setConstantBuffer(m_ps, m_cb);
-
-	// set shader in the graphics pipeline to be able to draw
-	GraphicsEngine::get()->getImmediateDeviceContext()->setVertexShader(m_vs);
-	GraphicsEngine::get()->getImmediateDeviceContext()->setPixelShader(m_ps);
-
-	GraphicsEngine::get()->getImmediateDeviceContext()->setTextureShader(m_ts);
-
-	// set the vertices of the triangle to draw
-	GraphicsEngine::get()->getImmediateDeviceContext()->setVertexBuffer(m_mesh->getVertex());
+	// start or stop the game thread between two frames
+	if (m_pipelined && !m_pipeline.isRunning())
+		m_pipeline.start([this](FrameSnapshot& frame) { simulate(frame, true); }, "Game");
+	else if (!m_pipelined && m_pipeline.isRunning())
+		m_pipeline.stop();
+	m_pipeline.setMaxLatency((unsigned int)m_max_latency);
+
+	if (m_pipeline.isRunning())
+	{
+		// the game thread already simulates the next frames while this one is drawn
+		const FrameSnapshot* frame = m_pipeline.acquire();
+		if (!frame)
+			return;
+
+		render(*frame);
+		m_pipeline.release();
+	}
+	else
+	{
+		simulate(m_frame, false);
+		render(m_frame);
+	}
+}
 
 
-	//set the indices of the triangle to draw
-	GraphicsEngine::get()->getImmediateDeviceContext()->setIndexBuffer(m_mesh->getIndex());
+/*
+	- game thread: input, camera, level of detail and culling of one frame into the snapshot. No GPU calls here, the
+	  render thread owns the device context
+	- pipelined: running on the thread of m_pipeline, otherwise called by onUpdate right before render()
+*/
 
+void AppWindow::simulate(FrameSnapshot& frame, bool pipelined)
+{
+	ProfileMarker marker("Simulate");
+	auto start = std::chrono::high_resolution_clock::now();
 
+	// for timing. m_new_delta is current process time. 
+	m_old_delta = m_new_delta;
+	m_new_delta = ::GetTickCount64();
 
+	// aligned condition. For beginning when all delta would be zero
+	m_delta_time = (m_old_delta)?((m_new_delta - m_old_delta) / 1000.0f):0;
 
-	// finally draw triangles
-	GraphicsEngine::get()->getImmediateDeviceContext()->drawIndexedTriangleList(m_mesh->getIndex()->getSizeIndexList(), 0, 0);
+	{
+		std::lock_guard<std::mutex> lock(m_settings_mutex);
+		frame.m_settings = m_shared_settings;
+	}
 
+	RECT rc = this->getClientWindowRect();
+	frame.m_frame = m_frames_simulated++;
+	frame.m_width = rc.right - rc.left;
+	frame.m_height = rc.bottom - rc.top;
+	frame.m_draws.clear();
+	frame.m_meshlet_culled = false;
+	frame.m_occlusion_rendered = false;
+	frame.m_occlusion_test_ms = 0.0;
 
-	UpdateGui();
+	// Input
+	m_input->setCollision(frame.m_settings.m_collision ? &m_collision[frame.m_settings.m_benchmark ? 1 : 0] : nullptr, frame.m_settings.m_collision_radius);
+	m_input->Update(m_delta_time);
+	frame.m_camera_position = Vector3D(m_input->getPosX(), m_input->getPosY(), m_input->getPosZ());
 
-	m_swap_chain->present(true);
+	// include timer for transform and animation
+	updateTransform(frame);
+	updateLights(frame);
+
+	MeshModel* mesh = GraphicsEngine::get()->get(m_mesh);
+	if (mesh)
+		updateShadows(mesh, frame);
+	updateTerrain(frame);
+	updateParticles(frame);
+	if (mesh && frame.m_settings.m_benchmark)
+	{
+		cullBenchmarkScene(mesh, frame, pipelined);
+	}
+	else if (mesh)
+	{
+		// level of detail by the size of the mesh on screen
+		frame.m_lod_level = mesh->selectLod(frame.m_constants.m_world, frame.m_constants.m_view, frame.m_constants.m_proj, (float)frame.m_height, frame.m_settings.m_lod_pixel_error);
+		const MeshFileLod& lod = mesh->getLod(frame.m_lod_level);
+
+		FrameDraw draw = { frame.m_constants.m_world, lod.m_index_count, lod.m_index_start };
+
+		// only the meshlets in the frustum that face the camera. The render thread uploads the indices
+		if (frame.m_settings.m_meshlet_culling && m_culled_indices.isValid() && lod.m_meshlet_count)
+		{
+			m_culler.begin();
+			m_culler.cull(mesh, frame.m_lod_level, frame.m_constants.m_world, frame.m_constants.m_view, frame.m_constants.m_proj);
+
+			// assign keeps the memory of the snapshot -> no allocations after the first frames
+			const std::vector<unsigned int>& indices = m_culler.getIndices();
+			frame.m_culled_indices.assign(indices.begin(), indices.end());
+			frame.m_meshlet_culled = true;
+			frame.m_meshlet_stats = m_culler.getStats();
+
+			draw.m_index_count = (unsigned int)indices.size();
+			draw.m_index_start = 0;
+		}
+
+		frame.m_draws.push_back(draw);
+	}
+
+	frame.m_simulate_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
 
 
-	// for timing. m_new_delta is current process time. 
-	m_old_delta = m_new_delta;
-	m_new_delta = ::GetTickCount64();
+/*
+	- render thread: everything of the snapshot goes to the GPU, then the GUI and present. Only reads the snapshot
+*/
 
-	// aligned condition. For beginning when all delta would be zero
-	m_delta_time = (m_old_delta)?((m_new_delta - m_old_delta) / 1000.0f):0;
+void AppWindow::render(const FrameSnapshot& frame)
+{
+	ProfileMarker marker("Render");
+
+	DeviceContext* context = GraphicsEngine::get()->getImmediateDeviceContext();
+
+	// resolve the handles of this frame's resources
+	VertexShader* vs = GraphicsEngine::get()->get(m_vs);
+	PixelShader* ps = GraphicsEngine::get()->get(m_ps);
+	ConstantBuffer* cb = GraphicsEngine::get()->get(m_cb);
+	TextureShader* ts = GraphicsEngine::get()->get(m_ts);
+	MeshModel* mesh = GraphicsEngine::get()->get(m_mesh);
+	VertexShader* depth_vs = GraphicsEngine::get()->get(m_depth_vs);
+	VertexShader* post_vs = GraphicsEngine::get()->get(m_post_vs);
+	ConstantBuffer* post_cb = GraphicsEngine::get()->get(m_post_cb);
+
+	// constants of the snapshot
+	*m_ct = frame.m_constants;
+	cb->update(context, m_ct);
+
+	// lights and clusters of the snapshot. Without all buffers the shader gets no lights
+	StructuredBuffer* lights_buffer = GraphicsEngine::get()->get(m_lights_buffer);
+	StructuredBuffer* clusters_buffer = GraphicsEngine::get()->get(m_clusters_buffer);
+	StructuredBuffer* light_indices_buffer = GraphicsEngine::get()->get(m_light_indices_buffer);
+	ConstantBuffer* clusters_cb = GraphicsEngine::get()->get(m_clusters_cb);
+	const LightGridData& light_grid = frame.m_light_grid;
+	ClusterConstantType cluster_constants = light_grid.m_constants;
+	bool lights = lights_buffer && clusters_buffer && light_indices_buffer && !light_grid.m_lights.empty();
+	if (lights)
+	{
+		lights_buffer->update(context, light_grid.m_lights.data(), (UINT)light_grid.m_lights.size());
+		clusters_buffer->update(context, light_grid.m_clusters.data(), (UINT)light_grid.m_clusters.size());
+		if (!light_grid.m_indices.empty())
+			light_indices_buffer->update(context, light_grid.m_indices.data(), (UINT)light_grid.m_indices.size());
+	}
+	else
+	{
+		cluster_constants.m_light_count = 0;
+	}
+	clusters_cb->update(context, &cluster_constants);
+
+	// shadows of the snapshot. Without the maps or the shader constants the pixel shader gets no shadows
+	ConstantBuffer* shadow_pass_cb = GraphicsEngine::get()->get(m_shadow_pass_cb);
+	ConstantBuffer* shadows_cb = GraphicsEngine::get()->get(m_shadows_cb);
+	RenderTarget* shadow_maps[ShadowCascades::CASCADE_COUNT] = {};
+	bool shadows = frame.m_settings.m_shadows && mesh && depth_vs && shadow_pass_cb && !frame.m_shadow_casters.empty();
+	for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+	{
+		shadow_maps[c] = GraphicsEngine::get()->get(m_shadow_maps[c]);
+		shadows = shadows && shadow_maps[c];
+	}
+	ShadowConstantType shadow_constants;
+	if (shadows)
+	{
+		ShadowCascades::getConstants(frame.m_shadow_cascades, shadow_constants);
+		shadow_constants.m_enabled = 1.0f;
+		shadow_constants.m_bias = SHADOW_NORMAL_OFFSET;
+	}
+	shadows_cb->update(context, &shadow_constants);
+
+	// terrain of the snapshot: the tiles first, the chunks of this frame may already read them
+	TextureArray* terrain_tiles = GraphicsEngine::get()->get(m_terrain_tiles);
+	StructuredBuffer* terrain_instances = GraphicsEngine::get()->get(m_terrain_instances);
+	ConstantBuffer* terrain_cb = GraphicsEngine::get()->get(m_terrain_cb);
+	if (terrain_tiles)
+	{
+		for (const TerrainTileUpload& upload : frame.m_terrain.m_uploads)
+			terrain_tiles->update(context, upload.m_slice, upload.m_heights.data(), terrain_tiles->getWidth() * (UINT)sizeof(unsigned short));
+	}
+	if (terrain_instances && terrain_cb && !frame.m_terrain.m_instances.empty())
+	{
+		terrain_instances->update(context, frame.m_terrain.m_instances.data(), (UINT)frame.m_terrain.m_instances.size());
+		TerrainConstantType terrain_constants = frame.m_terrain.m_constants;
+		terrain_cb->update(context, &terrain_constants);
+	}
+
+	// particles of the snapshot, already sorted for its camera
+	StructuredBuffer* particles = GraphicsEngine::get()->get(m_particle_buffer);
+	if (particles && !frame.m_particles.empty())
+		particles->update(context, frame.m_particles.data(), (UINT)std::min((unsigned int)frame.m_particles.size(), m_particle_capacity));
+
+	// ranges of the vertex format of the mesh. A packed mesh needs the shader that decodes it
+	VertexShader* packed_vs = GraphicsEngine::get()->get(m_packed_vs);
+	if (mesh && mesh->getVertexFormat().isPacked() && packed_vs)
+		vs = packed_vs;
+
+	// visible meshlets of the game thread, uploaded before a pass draws the mesh. Without a mesh only the terrain,
+	// the particles and the post processing are drawn
+	bool single_draw = mesh && !frame.m_settings.m_benchmark && !frame.m_draws.empty();
+	bool benchmark = mesh && frame.m_settings.m_benchmark;
+	IndexBuffer* culled = GraphicsEngine::get()->get(m_culled_indices);
+	bool meshlet_culled = single_draw && frame.m_meshlet_culled && culled;
+	if (meshlet_culled)
+		culled->update(context, frame.m_culled_indices.data(), (UINT)frame.m_culled_indices.size());
+
+	bool prepass = single_draw && m_depth_prepass && depth_vs;
+
+	// the pipeline state of the scene. Every pass binds what it needs, the passes before leave theirs behind
+	auto bindScene = [&]()
+	{
+		// bind constant buffer to the graphics pipeline for each shader (overloading)
+		context->setConstantBuffer(vs, cb);
+		context->setConstantBuffer(ps, cb);
+		if (mesh && mesh->getQuantization())
+			context->setConstantBuffer(vs, mesh->getQuantization(), 1);
+
+		// clustered lights: b2 and t1 - t3 of the pixel shader
+		context->setConstantBuffer(ps, clusters_cb, 2);
+		if (lights)
+		{
+			context->setStructuredBuffer(ps, lights_buffer, 1);
+			context->setStructuredBuffer(ps, clusters_buffer, 2);
+			context->setStructuredBuffer(ps, light_indices_buffer, 3);
+		}
+
+		// cascaded shadows: b3, t4 - t7 and the comparison sampler s1
+		context->setConstantBuffer(ps, shadows_cb, 3);
+		if (shadows)
+		{
+			for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+				context->setTexture(shadow_maps[c], 4 + c);
+		}
+		context->setComparisonSampler(1);
+
+		// set shader in the graphics pipeline to be able to draw
+		context->setVertexShader(vs);
+		context->setPixelShader(ps);
+		context->setTextureShader(ts);
+
+		// set the vertices of the triangle to draw: position and attribute stream, and the indices
+		if (mesh)
+		{
+			context->setVertexStreams(mesh->getPositionStream(), mesh->getVertex());
+			context->setIndexBuffer(meshlet_culled ? culled : mesh->getIndex());
+		}
+	};
+
+	// full screen triangle from input into output
+	auto drawFullScreen = [&](RenderGraphContext& pass, RenderGraphResource input, RenderGraphResource output, PixelShaderHandle shader,
+		PostProcessConstantType& constants)
+	{
+		constants.m_texel_size[0] = 1.0f / (float)pass.getWidth(input);
+		constants.m_texel_size[1] = 1.0f / (float)pass.getHeight(input);
+		constants.m_threshold = m_bloom_threshold;
+		constants.m_near = CAMERA_NEAR;
+		constants.m_far = CAMERA_FAR;
+		post_cb->update(context, &constants);
+
+		PixelShader* post_ps = GraphicsEngine::get()->get(shader);
+		pass.setRenderTargets(output);
+		pass.setTexture(input, 0);
+		context->setConstantBuffer(post_ps, post_cb);
+		context->setVertexShader(post_vs);
+		context->setPixelShader(post_ps);
+		context->drawFullScreenTriangle();
+	};
+
+	UINT width = std::max(frame.m_width, 1u);
+	UINT height = std::max(frame.m_height, 1u);
+	RenderGraphTextureDesc half = { std::max(width / 2, 1u), std::max(height / 2, 1u), DXGI_FORMAT_R16G16B16A16_FLOAT };
+
+	m_graph.reset();
+	RenderGraphResource back_buffer = m_graph.importBackBuffer("Back Buffer", m_swap_chain, width, height);
+	RenderGraphResource scene_color = m_graph.createTexture("Scene Color", { width, height, DXGI_FORMAT_R16G16B16A16_FLOAT });
+	RenderGraphResource scene_depth = m_graph.createTexture("Scene Depth", { width, height, DXGI_FORMAT_D32_FLOAT });
+	RenderGraphResource bloom_bright = m_graph.createTexture("Bloom Bright", half);
+	RenderGraphResource bloom_blur_x = m_graph.createTexture("Bloom Blur X", half);
+	RenderGraphResource bloom_blur_y = m_graph.createTexture("Bloom Blur Y", half);
+	RenderGraphResource depth_view = m_graph.createTexture("Depth View", { half.m_width, half.m_height, DXGI_FORMAT_R8G8B8A8_UNORM });
+
+	/*
+		- the shadow maps are imported: they keep their content, a cascade whose matrix, casters and detail level are the
+		  same as when it was drawn is not drawn again. The last cascade only depends on the light
+		- the casters of each cascade with the depth shader, the cascade's matrices replace the camera
+	*/
+	RenderGraphResource shadow_resources[ShadowCascades::CASCADE_COUNT] = {};
+	if (shadows)
+	{
+		const char* shadow_names[] = { "Shadow Cascade 0", "Shadow Cascade 1", "Shadow Cascade 2", "Shadow Cascade 3" };
+		for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+			shadow_resources[c] = m_graph.importTexture(shadow_names[c], shadow_maps[c]);
+
+		std::vector<RenderGraphResource> shadow_writes(shadow_resources, shadow_resources + ShadowCascades::CASCADE_COUNT);
+		m_graph.addPass("Shadows", {}, shadow_writes, [&](RenderGraphContext& pass)
+			{
+				ConstantType constants = frame.m_constants;
+				m_shadow_maps_drawn = 0;
+
+				for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+				{
+					const ShadowCascade& cascade = frame.m_shadow_cascades[c];
+					ShadowMapCache cache;
+					cache.m_view_proj = cascade.m_view;
+					cache.m_view_proj *= cascade.m_proj;
+					cache.m_casters = (unsigned int)cascade.m_casters.size();
+					cache.m_lod = frame.m_shadow_lod[c];
+					cache.m_benchmark = frame.m_settings.m_benchmark;
+					cache.m_valid = true;
+					if (cache == m_shadow_cache[c])
+						continue;
+					m_shadow_cache[c] = cache;
+
+					pass.clear(shadow_resources[c]);
+					pass.setRenderTargets(RENDER_GRAPH_NONE, shadow_resources[c]);
+					context->setConstantBuffer(depth_vs, shadow_pass_cb);
+					if (mesh->getQuantization())
+						context->setConstantBuffer(depth_vs, mesh->getQuantization(), 1);
+					context->setVertexShader(depth_vs);
+					context->setPixelShader(nullptr);
+					context->setVertexStreams(mesh->getPositionStream());
+					context->setIndexBuffer(mesh->getIndex());
+
+					const MeshFileLod& lod = mesh->getLod(frame.m_shadow_lod[c]);
+					constants.m_view = cascade.m_view;
+					constants.m_proj = cascade.m_proj;
+					for (unsigned int caster : cascade.m_casters)
+					{
+						constants.m_world = frame.m_shadow_casters[caster].m_world;
+						shadow_pass_cb->update(context, &constants);
+						context->drawIndexedTriangleList(lod.m_index_count, 0, lod.m_index_start);
+					}
+					m_shadow_maps_drawn++;
+				}
+			});
+	}
+
+	if (prepass)
+	{
+		// only the position stream, no pixel shader. The scene pass then shades each pixel once
+		m_graph.addPass("Depth Pre-Pass", {}, { scene_depth }, [&](RenderGraphContext& pass)
+			{
+				const FrameDraw& draw = frame.m_draws[0];
+				pass.clear(scene_depth);
+				pass.setRenderTargets(RENDER_GRAPH_NONE, scene_depth);
+				bindScene();
+				context->setVertexShader(depth_vs);
+				context->setPixelShader(nullptr);
+				context->setVertexStreams(mesh->getPositionStream());
+				context->drawIndexedTriangleList(draw.m_index_count, 0, draw.m_index_start);
+			});
+	}
+
+	std::vector<RenderGraphResource> scene_reads;
+	if (prepass) scene_reads.push_back(scene_depth);
+	if (shadows) scene_reads.insert(scene_reads.end(), shadow_resources, shadow_resources + ShadowCascades::CASCADE_COUNT);
+	m_graph.addPass("Scene", scene_reads, { scene_color, scene_depth }, [&](RenderGraphContext& pass)
+		{
+			pass.clear(scene_color, 0.0f, 0.0f, 0.0f, 1.0f);
+			if (!prepass) pass.clear(scene_depth);
+			pass.setRenderTargets(scene_color, scene_depth);
+
+			// before the objects: it binds its own state, the command lists of the benchmark scene reset the context
+			drawTerrain(frame);
+			bindScene();
+
+			if (benchmark)
+			{
+				drawBenchmarkScene(frame, mesh, vs, ps, cb, ts, pass.getRenderTarget(scene_color), pass.getRenderTarget(scene_depth));
+			}
+			else if (single_draw)
+			{
+				const FrameDraw& draw = frame.m_draws[0];
+				if (prepass) context->setDepthState(DepthState::Equal);
+				// finally draw triangles
+				context->drawIndexedTriangleList(draw.m_index_count, 0, draw.m_index_start);
+				context->setDepthState(DepthState::Default);
+			}
+
+			// after everything opaque, the command lists may have reset the targets
+			pass.setRenderTargets(scene_color, scene_depth);
+			drawParticles(frame);
+		});
+
+	m_graph.addPass("Bloom Bright", { scene_color }, { bloom_bright }, [&](RenderGraphContext& pass)
+		{
+			PostProcessConstantType constants;
+			drawFullScreen(pass, scene_color, bloom_bright, m_bright_ps, constants);
+		});
+	m_graph.addPass("Bloom Blur X", { bloom_bright }, { bloom_blur_x }, [&](RenderGraphContext& pass)
+		{
+			PostProcessConstantType constants;
+			constants.m_direction[0] = 1.0f;
+			drawFullScreen(pass, bloom_bright, bloom_blur_x, m_blur_ps, constants);
+		});
+	m_graph.addPass("Bloom Blur Y", { bloom_blur_x }, { bloom_blur_y }, [&](RenderGraphContext& pass)
+		{
+			PostProcessConstantType constants;
+			constants.m_direction[1] = 1.0f;
+			drawFullScreen(pass, bloom_blur_x, bloom_blur_y, m_blur_ps, constants);
+		});
+	m_graph.addPass("Depth View", { scene_depth }, { depth_view }, [&](RenderGraphContext& pass)
+		{
+			PostProcessConstantType constants;
+			drawFullScreen(pass, scene_depth, depth_view, m_depth_view_ps, constants);
+		});
+
+	// what the composite reads decides which of the passes above run
+	std::vector<RenderGraphResource> composite_reads = { scene_color };
+	if (m_bloom) composite_reads.push_back(bloom_blur_y);
+	if (m_show_depth) composite_reads.push_back(depth_view);
+	m_graph.addPass("Composite", composite_reads, { back_buffer }, [&](RenderGraphContext& pass)
+		{
+			PostProcessConstantType constants;
+			constants.m_intensity = m_bloom ? m_bloom_intensity : 0.0f;
+			constants.m_show_depth = m_show_depth ? 1.0f : 0.0f;
+			if (m_bloom) pass.setTexture(bloom_blur_y, 1);
+			if (m_show_depth) pass.setTexture(depth_view, 2);
+			drawFullScreen(pass, scene_color, back_buffer, m_composite_ps, constants);
+		});
+
+	m_graph.addPass("GUI", {}, { back_buffer }, [&](RenderGraphContext& pass)
+		{
+			pass.setRenderTargets(back_buffer);
+			UpdateGui(frame);
+		});
+
+	m_graph.compile();
+	m_graph.execute(context);
+
+	{
+		// vsync wait: with the game thread the next frame is simulated meanwhile
+		ProfileMarker present_marker("Present");
+		m_swap_chain->present(true);
+	}
+
+	// destroy resources released during this frame
+	GraphicsEngine::get()->endFrame();
 }
 
 
@@ -319,12 +1767,48 @@ void AppWindow::onDestroy()
 	// call onDestroy in Window
 	Window::onDestroy();
 
-	delete m_mesh;
-	delete m_cb;
+	// the game thread reads the mesh and the input
+	m_pipeline.stop();
+	m_pipelined = false;
+
+	GraphicsEngine::get()->release(m_mesh);
+	GraphicsEngine::get()->release(m_culled_indices);
+	m_batcher.clear();
+	releaseCommandLists();
+	m_graph.clear();
+	GraphicsEngine::get()->release(m_post_vs);
+	GraphicsEngine::get()->release(m_bright_ps);
+	GraphicsEngine::get()->release(m_blur_ps);
+	GraphicsEngine::get()->release(m_composite_ps);
+	GraphicsEngine::get()->release(m_depth_view_ps);
+	GraphicsEngine::get()->release(m_post_cb);
+	GraphicsEngine::get()->release(m_lights_buffer);
+	GraphicsEngine::get()->release(m_clusters_buffer);
+	GraphicsEngine::get()->release(m_light_indices_buffer);
+	GraphicsEngine::get()->release(m_clusters_cb);
+	for (unsigned int c = 0; c < ShadowCascades::CASCADE_COUNT; c++)
+		GraphicsEngine::get()->release(m_shadow_maps[c]);
+	GraphicsEngine::get()->release(m_shadow_pass_cb);
+	GraphicsEngine::get()->release(m_shadows_cb);
+	GraphicsEngine::get()->release(m_terrain_tiles);
+	GraphicsEngine::get()->release(m_terrain_instances);
+	GraphicsEngine::get()->release(m_terrain_index);
+	GraphicsEngine::get()->release(m_terrain_vs);
+	GraphicsEngine::get()->release(m_terrain_ps);
+	GraphicsEngine::get()->release(m_terrain_cb);
+	GraphicsEngine::get()->release(m_terrain_detail);
+	GraphicsEngine::get()->release(m_particle_buffer);
+	GraphicsEngine::get()->release(m_particle_vs);
+	GraphicsEngine::get()->release(m_particle_ps);
+	GraphicsEngine::get()->release(m_cb);
+	GraphicsEngine::get()->release(m_vs);
+	GraphicsEngine::get()->release(m_packed_vs);
+	GraphicsEngine::get()->release(m_depth_vs);
+	GraphicsEngine::get()->release(m_ps);
+	GraphicsEngine::get()->release(m_ts);
+	GraphicsEngine::get()->endFrame();
+
 	delete m_swap_chain;
 	delete m_input;
-	delete m_vs;
-	delete m_ps;
-	delete m_ts;
 	delete m_ct;
 }
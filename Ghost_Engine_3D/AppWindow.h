@@ -40,6 +40,113 @@
 #include "Input.h"
 #include "TextureShader.h"
 #include "MeshModel.h"
+#include "MeshletCuller.h"
+#include "OcclusionBuffer.h"
+#include "StaticBatcher.h"
+#include "CommandList.h"
+#include "FramePipeline.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "LightGrid.h"
+#include "ShadowCascades.h"
+#include "Terrain.h"
+#include "Noise.h"
+#include "CollisionWorld.h"
+#include "Broadphase.h"
+#include "PhysicsWorld.h"
+#include "ParticleSystem.h"
+#include <mutex>
+#include <cstring>
+
+
+// what the GUI changes for the simulation. The render thread edits its own copy and publishes it once per frame
+struct SceneSettings
+{
+	float m_light_rotation = 0.0f;
+	float m_light_elevation = 0.8f;		// angle of the directional light above the horizon
+	Vector3D m_ambient_color = Vector3D(1.0f, 1.0f, 1.0f);
+	float m_ambient_power = 1.0f;
+	float m_lod_pixel_error = 1.0f;		// largest error of a mesh level on screen, in pixels
+	bool m_meshlet_culling = true;
+	bool m_benchmark = false;
+	bool m_occlusion_culling = true;
+	int m_occluder_count = 8;			// nearest instances that are rasterized as occluders
+	bool m_static_batching = false;
+	int m_light_count = 128;			// point and spot lights, culled into the clusters of LightGrid
+	bool m_animate_lights = true;
+	bool m_shadows = true;				// cascaded shadow maps of the directional light
+	float m_shadow_distance = 50.0f;	// view depth the cascades cover
+	bool m_terrain = true;				// streamed heightmap terrain below the scene, if it was cooked
+	float m_terrain_lod_distance = 2.5f;	// range of the finest terrain level, in leaf node sizes
+	bool m_collision = true;			// the camera slides along the mesh instead of flying through it
+	float m_collision_radius = 0.25f;
+	bool m_particles = true;			// the emitters around the mesh, simulated on the game thread
+	bool m_particle_sort = true;		// back to front, without it blending shows the block order
+};
+
+// one object to draw: placement and the index range of its detail level
+struct FrameDraw
+{
+	Matrix4x4 m_world;
+	unsigned int m_index_count = 0;
+	unsigned int m_index_start = 0;
+};
+
+/*
+	FrameSnapshot: one simulated frame, everything the render thread needs to draw it
+
+	- written by the game thread only, immutable for the render thread (see FramePipeline)
+	- the culling results are copied in, the game thread reuses its culling state for the next frame
+*/
+struct FrameSnapshot
+{
+	unsigned long long m_frame = 0;
+	SceneSettings m_settings;
+	ConstantType m_constants;				// camera and light, the world matrix is the identity
+	Vector3D m_camera_position;
+	UINT m_width = 0;
+	UINT m_height = 0;
+
+	std::vector<FrameDraw> m_draws;			// visible objects: the instances of the benchmark scene or the mesh
+	unsigned int m_lod_level = 0;			// level of the mesh outside of the benchmark scene
+	std::vector<unsigned int> m_culled_indices;
+	bool m_meshlet_culled = false;			// m_culled_indices replace the index buffer of the mesh
+
+	LightGridData m_light_grid;				// lights and their clusters for the pixel shader
+
+	// cascades fitted to this frame's camera, the casters they contain and the mesh level each cascade draws
+	ShadowCascade m_shadow_cascades[ShadowCascades::CASCADE_COUNT];
+	unsigned int m_shadow_lod[ShadowCascades::CASCADE_COUNT] = {};
+	std::vector<ShadowCaster> m_shadow_casters;
+	ShadowStats m_shadow_stats;
+
+	TerrainFrame m_terrain;					// selected terrain chunks and the height tiles to upload first
+
+	std::vector<ParticleVertex> m_particles;	// sorted for the camera of the frame
+	ParticleStats m_particle_stats;
+
+	MeshletCullStats m_meshlet_stats;
+	OcclusionStats m_occlusion_stats;
+	bool m_occlusion_rendered = false;
+	double m_occlusion_test_ms = 0.0;
+	double m_simulate_ms = 0.0;
+};
+
+// what a shadow map was drawn with. The scene does not move: the same inputs give the same shadow map
+struct ShadowMapCache
+{
+	Matrix4x4 m_view_proj;
+	unsigned int m_casters = 0;
+	unsigned int m_lod = 0;
+	bool m_benchmark = false;
+	bool m_valid = false;
+
+	bool operator ==(const ShadowMapCache& cache) const
+	{
+		return m_valid && cache.m_valid && !memcmp(&m_view_proj, &cache.m_view_proj, sizeof(Matrix4x4)) &&
+			m_casters == cache.m_casters && m_lod == cache.m_lod && m_benchmark == cache.m_benchmark;
+	}
+};
 
 
 class AppWindow: public Window
@@ -47,9 +154,42 @@ class AppWindow: public Window
 public:
 	AppWindow();
 
-	void updateTransform();
+	// game thread: one frame into the snapshot. pipelined: running on the thread of m_pipeline
+	void simulate(FrameSnapshot& frame, bool pipelined);
+	void updateTransform(FrameSnapshot& frame);
+	// game thread: move the lights and bin them into the clusters of the frame
+	void updateLights(FrameSnapshot& frame);
+	// game thread: fit the shadow cascades to the camera and cull the casters of the frame into them
+	void updateShadows(MeshModel* mesh, FrameSnapshot& frame);
+	// game thread: quadtree selection and tile streaming of the terrain for the camera of the frame
+	void updateTerrain(FrameSnapshot& frame);
+	// game thread: particles of the emitters one step on and their vertices for the camera of the frame
+	void updateParticles(FrameSnapshot& frame);
+	// render thread: draw the snapshot, GUI and present
+	void render(const FrameSnapshot& frame);
 
-	void UpdateGui();
+	void UpdateGui(const FrameSnapshot& frame);
+	// game thread, settings and profiler timeline
+	void drawPipelineGui(const FrameSnapshot& frame);
+	// benchmark scene: a grid of copies of the mesh, with or without occlusion culling
+	void cullBenchmarkScene(MeshModel* mesh, FrameSnapshot& frame, bool pipelined);
+	// color and depth: targets of the scene pass, the command lists draw into them
+	void drawBenchmarkScene(const FrameSnapshot& frame, MeshModel* mesh, VertexShader* vs, PixelShader* ps, ConstantBuffer* cb, TextureShader* ts,
+		RenderTarget* color, RenderTarget* depth);
+	// passes, culled passes and aliased targets of the render graph
+	void drawRenderGraphGui();
+	// render thread: the chunks of the frame into the bound targets, the tiles were uploaded by render()
+	void drawTerrain(const FrameSnapshot& frame);
+	void drawTerrainGui(const FrameSnapshot& frame);
+	// noise backend and its benchmark
+	void drawNoiseGui();
+	void drawCollisionGui(const FrameSnapshot& frame);
+	// render thread: the vertices of the snapshot into the bound targets, blended without depth writes
+	void drawParticles(const FrameSnapshot& frame);
+	void drawParticleGui(const FrameSnapshot& frame);
+	// one command list per job thread. recorded: command stream in memory instead of deferred contexts
+	void createCommandLists(bool recorded);
+	void releaseCommandLists();
 
 	~AppWindow();
 
@@ -67,14 +207,108 @@ public:
 
 private:
 	SwapChain* m_swap_chain;
-	VertexShader* m_vs;
-	PixelShader* m_ps;
-	ConstantBuffer* m_cb;
+	VertexShaderHandle m_vs;
+	VertexShaderHandle m_packed_vs;			// meshes with a packed vertex format
+	VertexShaderHandle m_depth_vs;			// position stream only
+	bool m_depth_prepass = false;
+	PixelShaderHandle m_ps;
+	ConstantBufferHandle m_cb;
 	Input* m_input;
-	TextureShader* m_ts;
-	MeshModel* m_mesh;
+	TextureShaderHandle m_ts;
+	MeshModelHandle m_mesh;
 	ConstantType* m_ct;
 
+	SceneSettings m_settings;				// render thread, edited by the GUI
+	SceneSettings m_shared_settings;		// read by the game thread
+	std::mutex m_settings_mutex;
+
+	FramePipeline<FrameSnapshot> m_pipeline;
+	FrameSnapshot m_frame;					// without the game thread
+	bool m_pipelined = true;
+	int m_max_latency = 1;
+	unsigned long long m_frames_simulated = 0;
+	std::vector<ProfileRecord> m_profile_records;
+
+	// game thread
+	MeshletCuller m_culler;
+	OcclusionBuffer m_occlusion;
+	std::vector<Matrix4x4> m_instances;		// world matrices of the benchmark scene
+	std::vector<unsigned int> m_instance_order;
+	std::vector<char> m_instance_visible;
+	LightGrid m_light_grid;
+	std::vector<PointLight> m_lights;
+	float m_light_time = 0.0f;
+	Vector3D m_light_area_min[2];			// where the lights move: around the mesh, over the benchmark scene
+	Vector3D m_light_area_max[2];
+	ShadowCascades m_shadow_fit;
+	Vector3D m_scene_min[2];				// bounds of the mesh and of the benchmark scene, for the cascade fitting
+	Vector3D m_scene_max[2];
+	Terrain m_terrain;
+	CollisionMesh m_collision_mesh;			// level 0 of the mesh
+	CollisionWorld m_collision[2];			// the mesh, the copies of the benchmark scene
+	ParticleSystem m_particles;
+
+	// render thread
+	IndexBufferHandle m_culled_indices;		// visible meshlets of the mesh, rewritten every frame
+	StaticBatcher m_batcher;
+	unsigned int m_draws = 0;
+	double m_submit_ms = 0.0;
+
+	std::vector<CommandList*> m_command_lists;
+	bool m_parallel_submit = true;			// record the draws of the benchmark scene on all job threads
+	bool m_recorded_lists = false;
+	unsigned int m_lists_used = 0;
+	double m_record_ms = 0.0;
+	double m_execute_ms = 0.0;
+
+	// LightGridData of the frame
+	StructuredBufferHandle m_lights_buffer;
+	StructuredBufferHandle m_clusters_buffer;
+	StructuredBufferHandle m_light_indices_buffer;
+	ConstantBufferHandle m_clusters_cb;
+
+	// shadow maps stay between frames, a cascade is only drawn again when its ShadowMapCache changes
+	RenderTargetHandle m_shadow_maps[ShadowCascades::CASCADE_COUNT];
+	ShadowMapCache m_shadow_cache[ShadowCascades::CASCADE_COUNT];
+	ConstantBufferHandle m_shadow_pass_cb;	// ConstantType of the casters with the matrices of a cascade
+	ConstantBufferHandle m_shadows_cb;		// ShadowConstantType of the pixel shader
+	unsigned int m_shadow_maps_drawn = 0;
+
+	// terrain: height tiles of Terrain in the slices of a texture array, one grid index list for all chunks
+	TextureArrayHandle m_terrain_tiles;
+	StructuredBufferHandle m_terrain_instances;
+	IndexBufferHandle m_terrain_index;
+	UINT m_terrain_index_count = 0;
+	VertexShaderHandle m_terrain_vs;
+	PixelShaderHandle m_terrain_ps;
+	ConstantBufferHandle m_terrain_cb;
+	TextureArrayHandle m_terrain_detail;	// tileable noise, one slice, modulates the terrain color up close
+	TerrainBenchmark m_terrain_benchmark;
+	std::vector<NoiseBenchmarkResult> m_noise_benchmark;
+	CollisionBenchmark m_collision_benchmark;
+	BroadphaseBenchmark m_broadphase_benchmark;
+	PhysicsBenchmark m_physics_benchmark;
+
+	// particles: ParticleVertex of the snapshot, one quad per instance
+	StructuredBufferHandle m_particle_buffer;
+	unsigned int m_particle_capacity = 0;
+	VertexShaderHandle m_particle_vs;
+	PixelShaderHandle m_particle_ps;
+	ParticleBenchmark m_particle_benchmark;
+
+	// rebuilt every frame. Bloom and depth view passes are always declared, the graph culls them when the composite does not read them
+	RenderGraph m_graph;
+	VertexShaderHandle m_post_vs;			// full screen triangle
+	PixelShaderHandle m_bright_ps;
+	PixelShaderHandle m_blur_ps;
+	PixelShaderHandle m_composite_ps;
+	PixelShaderHandle m_depth_view_ps;
+	ConstantBufferHandle m_post_cb;
+	bool m_bloom = true;
+	bool m_show_depth = false;
+	float m_bloom_threshold = 0.6f;
+	float m_bloom_intensity = 0.8f;
+
 private:
 	long m_old_delta;
 	long m_new_delta;
@@ -84,6 +318,13 @@ private:
 	float m_delta_scale;
 	float m_delta_rot;
 
-	float m_light_rotation;
+	// timeline of the pipeline window
+	static constexpr double PIPELINE_TIMELINE_MS = 50.0;
+
+	static constexpr float CAMERA_NEAR = 0.1f;
+	static constexpr float CAMERA_FAR = 100.0f;
+
+	// position offset along the normal before the shadow map lookup, in texels of the cascade
+	static constexpr float SHADOW_NORMAL_OFFSET = 1.5f;
 };
 
@@ -0,0 +1,970 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "AssetCooker.h"
+#include "AsyncFileReader.h"
+#include "JobSystem.h"
+#include "MappedFile.h"
+#include "MeshFile.h"
+#include "MeshletBuilder.h"
+#include "ObjImporter.h"
+#include "PackFile.h"
+#include "TextureAtlas.h"
+#include "TextureCooker.h"
+#include "TextureFile.h"
+
+#include <DirectXTex.h>
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+
+static std::wstring toLower(const std::wstring& text)
+{
+	std::wstring result(text);
+	for (size_t i = 0; i < result.size(); i++)
+	{
+		if (result[i] >= L'A' && result[i] <= L'Z')
+			result[i] = result[i] - L'A' + L'a';
+	}
+	return result;
+}
+
+
+static std::wstring getExtension(const std::wstring& path)
+{
+	size_t dot = path.find_last_of(L'.');
+	size_t separator = path.find_last_of(L"\\/");
+	if (dot == std::wstring::npos || (separator != std::wstring::npos && dot < separator))
+		return std::wstring();
+	return toLower(path.substr(dot));
+}
+
+
+static std::wstring getDirectory(const std::wstring& path)
+{
+	size_t separator = path.find_last_of(L"\\/");
+	return (separator == std::wstring::npos) ? std::wstring() : path.substr(0, separator + 1);
+}
+
+
+// remove "." and ".." segments -> one node per file, however it is referenced
+static std::wstring collapsePath(const std::wstring& path)
+{
+	std::vector<std::wstring> segments;
+	std::wstring segment;
+
+	for (size_t i = 0; i <= path.size(); i++)
+	{
+		if (i < path.size() && path[i] != L'\\' && path[i] != L'/')
+		{
+			segment.push_back(path[i]);
+			continue;
+		}
+
+		if (segment == L".." && !segments.empty() && segments.back() != L"..")
+			segments.pop_back();
+		else if (!segment.empty() && segment != L".")
+			segments.push_back(segment);
+		segment.clear();
+	}
+
+	std::wstring result;
+	for (size_t i = 0; i < segments.size(); i++)
+	{
+		if (i > 0)
+			result += L"\\";
+		result += segments[i];
+	}
+	return result;
+}
+
+
+static std::string toUtf8(const std::wstring& text)
+{
+	if (text.empty())
+		return std::string();
+
+	int size = ::WideCharToMultiByte(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0, nullptr, nullptr);
+	std::string result(size, 0);
+	::WideCharToMultiByte(CP_UTF8, 0, text.data(), (int)text.size(), &result[0], size, nullptr, nullptr);
+	return result;
+}
+
+
+static std::wstring toWide(const std::string& text)
+{
+	if (text.empty())
+		return std::wstring();
+
+	int size = ::MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), nullptr, 0);
+	std::wstring result(size, 0);
+	::MultiByteToWideChar(CP_UTF8, 0, text.data(), (int)text.size(), &result[0], size);
+	return result;
+}
+
+
+// zero terminated copy into a fixed array of the cooked files. False (and empty) if it does not fit
+static bool copyString(char* destination, size_t capacity, const std::string& text)
+{
+	if (text.size() >= capacity)
+	{
+		destination[0] = 0;
+		return false;
+	}
+
+	::memcpy(destination, text.c_str(), text.size() + 1);
+	return true;
+}
+
+
+static bool fileExists(const std::wstring& path)
+{
+	DWORD attributes = ::GetFileAttributesW(path.c_str());
+	return attributes != INVALID_FILE_ATTRIBUTES && !(attributes & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+
+AssetCooker::AssetCooker(const std::wstring& root) :m_root(root)
+{
+	while (!m_root.empty() && (m_root.back() == L'\\' || m_root.back() == L'/'))
+		m_root.pop_back();
+
+	// offline: the slow BC7 search is worth it
+	m_texture_settings.m_preset = CompressionPreset::Quality;
+}
+
+
+void AssetCooker::setLodSettings(const MeshLodSettings& settings)
+{
+	m_lod_settings = settings;
+}
+
+
+void AssetCooker::setVertexFormat(const VertexFormat& format)
+{
+	m_vertex_format = format;
+}
+
+
+void AssetCooker::setTextureSettings(const TextureCookSettings& settings)
+{
+	m_texture_settings = settings;
+}
+
+
+void AssetCooker::setAtlasSettings(const AtlasSettings& settings)
+{
+	m_atlas_settings = settings;
+}
+
+
+bool AssetCooker::scan()
+{
+	DWORD attributes = ::GetFileAttributesW(m_root.c_str());
+	if (attributes == INVALID_FILE_ATTRIBUTES || !(attributes & FILE_ATTRIBUTE_DIRECTORY))
+		return false;
+
+	scanDirectory(m_root);
+
+	// references can add new nodes -> index loop
+	for (unsigned int i = 0; i < m_nodes.size(); i++)
+	{
+		addReferences(i);
+	}
+
+	computeLevels();
+	return true;
+}
+
+
+void AssetCooker::scanDirectory(const std::wstring& directory)
+{
+	WIN32_FIND_DATAW data;
+	HANDLE find = ::FindFirstFileW((directory + L"\\*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		std::wstring name = data.cFileName;
+		if (name == L"." || name == L"..")
+			continue;
+
+		std::wstring path = directory + L"\\" + name;
+
+		if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+		{
+			scanDirectory(path);
+			continue;
+		}
+
+		std::wstring extension = getExtension(path);
+		if (extension == L".obj")
+			addNode(path, AssetType::Mesh);
+		else if (extension == L".mtl")
+			addNode(path, AssetType::Material);
+		else if (extension == L".jpg" || extension == L".jpeg" || extension == L".png" || extension == L".bmp" ||
+			extension == L".tif" || extension == L".tiff" || extension == L".gif")
+			addNode(path, AssetType::Texture);
+
+	} while (::FindNextFileW(find, &data));
+
+	::FindClose(find);
+}
+
+
+unsigned int AssetCooker::addNode(const std::wstring& path, AssetType type)
+{
+	std::string key = PackFile::normalizePath(path.c_str());
+
+	auto found = m_node_lookup.find(key);
+	if (found != m_node_lookup.end())
+		return found->second;
+
+	AssetNode node;
+	node.m_path = path;
+	node.m_type = type;
+	node.m_normal_map = (type == AssetType::Texture) && TextureCooker::isNormalMapName(path.c_str());
+	m_nodes.push_back(node);
+
+	unsigned int index = (unsigned int)m_nodes.size() - 1;
+	m_node_lookup[key] = index;
+	return index;
+}
+
+
+/*
+	referenced files are looked up next to the referencing file first, then relative to the working directory
+	(the same order as the runtime)
+*/
+
+void AssetCooker::addReferences(unsigned int node)
+{
+	AssetType type = m_nodes[node].m_type;
+	if (type == AssetType::Texture)
+		return;
+
+	std::wstring path = m_nodes[node].m_path;
+
+	MappedFile file;
+	if (!file.open(path.c_str()))
+		return;
+
+	std::vector<std::string> references;
+	std::vector<std::string> normal_maps;
+	if (type == AssetType::Mesh)
+		ObjImporter::getMaterialLibraries(file.getData(), file.getSize(), references);
+	else
+	{
+		ObjImporter::getMaterialTextures(file.getData(), file.getSize(), references);
+		ObjImporter::getMaterialNormalMaps(file.getData(), file.getSize(), normal_maps);
+	}
+
+	for (size_t i = 0; i < references.size(); i++)
+	{
+		std::wstring name = toWide(references[i]);
+		std::replace(name.begin(), name.end(), L'/', L'\\');
+
+		std::wstring resolved = getDirectory(path) + name;
+		if (!fileExists(resolved))
+			resolved = name;
+
+		if (!fileExists(resolved))
+		{
+			printf("warning: %ls references missing file %ls\n", path.c_str(), name.c_str());
+			continue;
+		}
+
+		unsigned int dependency = addNode(collapsePath(resolved), (type == AssetType::Mesh) ? AssetType::Material : AssetType::Texture);
+		m_nodes[node].m_dependencies.push_back(dependency);
+
+		if (std::find(normal_maps.begin(), normal_maps.end(), references[i]) != normal_maps.end())
+			m_nodes[dependency].m_normal_map = true;
+	}
+}
+
+
+// level = longest path to a leaf. The graph has no cycles: meshes -> materials -> textures
+void AssetCooker::computeLevels()
+{
+	bool changed = true;
+	while (changed)
+	{
+		changed = false;
+		for (size_t i = 0; i < m_nodes.size(); i++)
+		{
+			for (size_t j = 0; j < m_nodes[i].m_dependencies.size(); j++)
+			{
+				unsigned int level = m_nodes[m_nodes[i].m_dependencies[j]].m_level + 1;
+				if (level > m_nodes[i].m_level)
+				{
+					m_nodes[i].m_level = level;
+					changed = true;
+				}
+			}
+		}
+	}
+}
+
+
+/*
+	all sources are read in one batch; every file is hashed by a job as soon as it is there
+*/
+
+void AssetCooker::hashSources()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	AsyncFileReader reader;
+	for (unsigned int i = 0; i < m_nodes.size(); i++)
+	{
+		reader.read(m_nodes[i].m_path, [this, i](const std::wstring&, std::vector<unsigned char>& data, bool ok)
+			{
+				m_nodes[i].m_found = ok;
+				m_nodes[i].m_content_hash = ok ? hash(data.data(), data.size()) : 0;
+			});
+	}
+	reader.submit();
+	reader.wait();
+
+	// keys in level order: the keys of the dependencies are ready before they are used
+	std::vector<unsigned int> order(m_nodes.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+		{
+			return m_nodes[a].m_level < m_nodes[b].m_level;
+		});
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		AssetNode& node = m_nodes[order[i]];
+
+		unsigned int versions[4] = { ASSET_COOKER_VERSION, TEXTURE_FILE_VERSION, MESH_FILE_VERSION, (unsigned int)node.m_type };
+		unsigned long long key = hash(&node.m_content_hash, sizeof(node.m_content_hash));
+		key = hash(versions, sizeof(versions), key);
+
+		if (node.m_type == AssetType::Mesh)
+		{
+			key = hash(&m_lod_settings.m_max_lods, sizeof(m_lod_settings.m_max_lods), key);
+			key = hash(&m_lod_settings.m_reduction, sizeof(m_lod_settings.m_reduction), key);
+			key = hash(&m_lod_settings.m_max_error, sizeof(m_lod_settings.m_max_error), key);
+
+			unsigned int vertex_format = m_vertex_format.getKey();
+			key = hash(&vertex_format, sizeof(vertex_format), key);
+
+			unsigned int atlas_settings[4] = { m_atlas_settings.m_size, m_atlas_settings.m_padding, m_atlas_settings.m_mip_levels, (unsigned int)m_texture_settings.m_preset };
+			key = hash(atlas_settings, sizeof(atlas_settings), key);
+		}
+		else if (node.m_type == AssetType::Texture)
+		{
+			unsigned int texture_settings[3] = { (unsigned int)m_texture_settings.m_preset, (unsigned int)m_texture_settings.m_mip_filter, (unsigned int)node.m_normal_map };
+			key = hash(texture_settings, sizeof(texture_settings), key);
+		}
+
+		for (size_t j = 0; j < node.m_dependencies.size(); j++)
+		{
+			key = hash(&m_nodes[node.m_dependencies[j]].m_key, sizeof(unsigned long long), key);
+		}
+		node.m_key = key;
+	}
+
+	m_stats.m_hash_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+void AssetCooker::cook(bool force)
+{
+	m_stats = CookStats();
+
+	loadManifest();
+	hashSources();
+
+	unsigned int max_level = 0;
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		AssetNode& node = m_nodes[i];
+		max_level = std::max(max_level, node.m_level);
+
+		auto entry = m_manifest.find(PackFile::normalizePath(node.m_path.c_str()));
+		std::wstring output = getOutputPath(node);
+
+		node.m_cached = !force && node.m_found && entry != m_manifest.end() && entry->second == node.m_key &&
+			(output.empty() || fileExists(output));
+
+		// the atlases of a mesh are outputs as well
+		if (node.m_cached && node.m_type == AssetType::Mesh)
+		{
+			std::vector<std::wstring> atlases;
+			node.m_cached = getAtlasOutputs(node, atlases) && std::all_of(atlases.begin(), atlases.end(), fileExists);
+		}
+		node.m_ok = node.m_cached;
+		node.m_milliseconds = 0.0;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// dependencies first, the stale assets of one level in parallel
+	for (unsigned int level = 0; level <= max_level; level++)
+	{
+		std::vector<unsigned int> stale;
+		for (unsigned int i = 0; i < m_nodes.size(); i++)
+		{
+			if (m_nodes[i].m_level == level && !m_nodes[i].m_cached)
+				stale.push_back(i);
+		}
+
+		JobSystem::get()->parallelFor((unsigned int)stale.size(), 1, [this, &stale](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; i++)
+				{
+					AssetNode& node = m_nodes[stale[i]];
+
+					auto asset_start = std::chrono::high_resolution_clock::now();
+					node.m_ok = node.m_found && cookAsset(node);
+					node.m_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - asset_start).count();
+				}
+			});
+	}
+
+	m_stats.m_cook_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		m_stats.m_assets++;
+		if (m_nodes[i].m_cached)
+			m_stats.m_cached++;
+		else if (m_nodes[i].m_ok)
+			m_stats.m_cooked++;
+		else
+			m_stats.m_failed++;
+	}
+	m_stats.m_hit_rate = m_stats.m_assets ? (double)m_stats.m_cached / m_stats.m_assets : 0.0;
+
+	saveManifest();
+}
+
+
+bool AssetCooker::cookAsset(AssetNode& node)
+{
+	std::wstring output = getOutputPath(node);
+
+	switch (node.m_type)
+	{
+	case AssetType::Texture:
+	{
+		MappedFile source;
+		if (!source.open(node.m_path.c_str()))
+			return false;
+
+		TextureCookSettings settings = m_texture_settings;
+		settings.m_normal_map = node.m_normal_map;
+
+		DirectX::ScratchImage cooked;
+		// the report is printed by printReport()
+		if (!TextureCooker::cook(source.getData(), source.getSize(), cooked, nullptr, &node.m_texture_report, settings))
+			return false;
+
+		return TextureFile::write(cooked, output.c_str());
+	}
+
+	case AssetType::Mesh:
+	{
+		std::vector<VertexMesh> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<unsigned short> vertex_materials;
+		std::vector<ObjMaterial> obj_materials;
+		if (!ObjImporter::load(node.m_path.c_str(), vertices, indices, &vertex_materials, &obj_materials))
+			return false;
+
+		// before the levels: the simplifier sees the texture coordinates of the atlas
+		std::vector<MeshFileMaterial> materials;
+		if (!buildMaterials(node, vertices, vertex_materials, obj_materials, materials))
+			return false;
+
+		std::vector<unsigned int> lod_indices;
+		std::vector<MeshFileLod> lods;
+		std::vector<MeshFileMeshlet> meshlets;
+		MeshSimplifier::buildLods(vertices, indices, m_lod_settings, lod_indices, lods);
+		MeshletBuilder::buildLods(vertices, lod_indices, lods, meshlets);
+
+		return MeshFile::write(vertices, lod_indices, lods, meshlets, output.c_str(), m_vertex_format, &node.m_vertex_report, materials,
+			materials.empty() ? std::vector<unsigned short>() : vertex_materials);
+	}
+
+	// materials are packed as they are, their textures are separate assets
+	case AssetType::Material:
+		return true;
+	}
+
+	return false;
+}
+
+
+// next to the materials of the mesh first, then next to the mesh, then relative to the working directory
+std::wstring AssetCooker::resolveTexture(const AssetNode& mesh, const std::string& name)
+{
+	std::wstring relative = toWide(name);
+	std::replace(relative.begin(), relative.end(), L'/', L'\\');
+
+	std::vector<std::wstring> candidates;
+	for (size_t i = 0; i < mesh.m_dependencies.size(); i++)
+	{
+		candidates.push_back(getDirectory(m_nodes[mesh.m_dependencies[i]].m_path) + relative);
+	}
+	candidates.push_back(getDirectory(mesh.m_path) + relative);
+	candidates.push_back(relative);
+
+	for (size_t i = 0; i < candidates.size(); i++)
+	{
+		if (fileExists(candidates[i]))
+			return collapsePath(candidates[i]);
+	}
+	return std::wstring();
+}
+
+
+/*
+	- every material keeps its texture, unless the atlas settings are on and the texture goes into an atlas
+	- one texture used by several materials is packed once. A texture that repeats (texture coordinates outside [0, 1])
+	  stays out for the material that repeats it
+	- the atlas only pays when it holds two or more textures: one texture is already one bind
+	- atlases are block compressed with the preset of the textures. Their mips are the box filtered chain of
+	  TextureAtlas, which never mixes two neighbours
+*/
+
+bool AssetCooker::buildMaterials(AssetNode& node, std::vector<VertexMesh>& vertices, const std::vector<unsigned short>& vertex_materials,
+	const std::vector<ObjMaterial>& obj_materials, std::vector<MeshFileMaterial>& materials)
+{
+	MeshAtlasReport& report = node.m_atlas_report;
+	report = MeshAtlasReport();
+
+	materials.assign(obj_materials.size(), MeshFileMaterial());
+	std::vector<std::wstring> textures(obj_materials.size());
+
+	for (size_t i = 0; i < obj_materials.size(); i++)
+	{
+		copyString(materials[i].m_name, sizeof(materials[i].m_name), obj_materials[i].m_name);
+		if (obj_materials[i].m_diffuse_texture.empty())
+			continue;
+
+		report.m_textured++;
+		textures[i] = resolveTexture(node, obj_materials[i].m_diffuse_texture);
+		if (textures[i].empty())
+			report.m_unreadable.push_back(obj_materials[i].m_name);
+		else
+			copyString(materials[i].m_texture, sizeof(materials[i].m_texture), toUtf8(textures[i]));
+	}
+
+	if (!m_atlas_settings.m_size)
+		return true;
+
+	TextureAtlas atlas(m_atlas_settings.m_size, m_atlas_settings.m_padding, m_atlas_settings.m_mip_levels);
+	unsigned int gutter = m_atlas_settings.m_padding << (m_atlas_settings.m_mip_levels - 1);
+
+	std::map<std::wstring, int> images;
+	std::vector<int> material_images(obj_materials.size(), -1);
+
+	for (unsigned short i = 0; i < (unsigned short)obj_materials.size(); i++)
+	{
+		if (textures[i].empty())
+			continue;
+
+		if (!TextureAtlas::fitsAtlas(vertices, vertex_materials, i))
+		{
+			report.m_tiling.push_back(obj_materials[i].m_name);
+			continue;
+		}
+
+		auto found = images.find(textures[i]);
+		if (found != images.end())
+		{
+			material_images[i] = found->second;
+			continue;
+		}
+
+		MappedFile source;
+		DirectX::ScratchImage image;
+		if (!source.open(textures[i].c_str()) || !TextureCooker::decode(source.getData(), source.getSize(), image))
+		{
+			report.m_unreadable.push_back(obj_materials[i].m_name);
+			continue;
+		}
+
+		const DirectX::Image& level = *image.GetImage(0, 0, 0);
+		if (level.width + 2 * gutter > m_atlas_settings.m_size || level.height + 2 * gutter > m_atlas_settings.m_size)
+		{
+			report.m_oversized.push_back(obj_materials[i].m_name);
+			continue;
+		}
+
+		int id = atlas.add(level);
+		if (id < 0)
+		{
+			report.m_unreadable.push_back(obj_materials[i].m_name);
+			continue;
+		}
+
+		images[textures[i]] = id;
+		material_images[i] = id;
+	}
+
+	if (images.size() < 2)
+		return true;
+
+	if (!atlas.build())
+		return false;
+
+	for (unsigned int i = 0; i < atlas.getAtlasCount(); i++)
+	{
+		const DirectX::ScratchImage& chain = atlas.getAtlas(i);
+		std::wstring output = TextureFile::getCookedPath(getAtlasName(node, i).c_str());
+
+		DXGI_FORMAT format = TextureCompressor::chooseFormat(*chain.GetImage(0, 0, 0), m_texture_settings.m_preset, false);
+		DirectX::ScratchImage compressed;
+		bool written = TextureCompressor::compress(chain, format, m_texture_settings.m_preset, compressed) ?
+			TextureFile::write(compressed, output.c_str()) : TextureFile::write(chain, output.c_str());
+
+		if (!written)
+			return false;
+	}
+
+	for (unsigned short i = 0; i < (unsigned short)obj_materials.size(); i++)
+	{
+		if (material_images[i] < 0)
+			continue;
+
+		const AtlasRegion& region = atlas.getRegion(material_images[i]);
+		if (!copyString(materials[i].m_texture, sizeof(materials[i].m_texture), toUtf8(getAtlasName(node, region.m_atlas))))
+			return false;
+
+		TextureAtlas::remapTexcoords(vertices, vertex_materials, i, region);
+		materials[i].m_atlas = 1;
+		report.m_packed++;
+	}
+
+	report.m_stats = atlas.getStats();
+	return true;
+}
+
+
+bool AssetCooker::writePack(const wchar_t* pack_file)
+{
+	std::vector<PackSource> sources;
+
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		const AssetNode& node = m_nodes[i];
+		if (!node.m_ok)
+			continue;
+
+		std::wstring output = getOutputPath(node);
+		if (output.empty())
+			output = node.m_path;
+
+		PackSource source;
+		source.m_path = output;
+		source.m_file = output;
+		sources.push_back(source);
+
+		std::vector<std::wstring> atlases;
+		if (node.m_type == AssetType::Mesh && getAtlasOutputs(node, atlases))
+		{
+			for (size_t j = 0; j < atlases.size(); j++)
+			{
+				source.m_path = atlases[j];
+				source.m_file = atlases[j];
+				sources.push_back(source);
+			}
+		}
+	}
+
+	return PackFile::write(sources, pack_file, true);
+}
+
+
+const std::vector<AssetNode>& AssetCooker::getAssets()
+{
+	return m_nodes;
+}
+
+
+CookStats AssetCooker::getStats()
+{
+	return m_stats;
+}
+
+
+void AssetCooker::printReport()
+{
+	static const char* const type_names[] = { "mesh", "material", "texture" };
+
+	std::vector<unsigned int> order(m_nodes.size());
+	for (unsigned int i = 0; i < order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](unsigned int a, unsigned int b)
+		{
+			return m_nodes[a].m_level < m_nodes[b].m_level;
+		});
+
+	printf("%-8s %-9s %10s  %s\n", "status", "type", "ms", "asset");
+
+	unsigned int type_assets[3] = {};
+	unsigned int type_cached[3] = {};
+
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		const AssetNode& node = m_nodes[order[i]];
+		const char* status = node.m_cached ? "cached" : node.m_ok ? "cooked" : node.m_found ? "FAILED" : "MISSING";
+		unsigned int type = (unsigned int)node.m_type;
+
+		printf("%-8s %-9s %10.2f  %ls\n", status, type_names[type], node.m_milliseconds, node.m_path.c_str());
+
+		type_assets[type]++;
+		if (node.m_cached)
+			type_cached[type]++;
+	}
+
+	printf("\n");
+	for (unsigned int type = 0; type < 3; type++)
+	{
+		if (type_assets[type])
+			printf("%-9s %u/%u cached (%.1f%%)\n", type_names[type], type_cached[type], type_assets[type], 100.0 * type_cached[type] / type_assets[type]);
+	}
+
+	// quality and speed of the block compression, for the textures cooked in this run
+	{
+		unsigned long long source_bytes = 0, compressed_bytes = 0;
+		for (size_t i = 0; i < m_nodes.size(); i++)
+		{
+			const AssetNode& node = m_nodes[i];
+			const CompressionReport& report = node.m_texture_report;
+			if (node.m_type != AssetType::Texture || !node.m_ok || node.m_cached || report.m_format == DXGI_FORMAT_UNKNOWN)
+				continue;
+
+			double megabytes_per_second = (report.m_milliseconds > 0.0) ? report.m_source_bytes / 1048576.0 / (report.m_milliseconds / 1000.0) : 0.0;
+			printf("texture %2u bpp: %9llu -> %9llu bytes, PSNR %6.2f dB, %8.2f ms, %7.1f MB/s  %ls\n", (unsigned int)DirectX::BitsPerPixel(report.m_format),
+				(unsigned long long)report.m_source_bytes, (unsigned long long)report.m_compressed_bytes, report.m_psnr, report.m_milliseconds,
+				megabytes_per_second, node.m_path.c_str());
+			source_bytes += report.m_source_bytes;
+			compressed_bytes += report.m_compressed_bytes;
+		}
+		if (source_bytes)
+			printf("texture memory %llu -> %llu bytes (%.1f%% saved)\n\n", source_bytes, compressed_bytes, 100.0 * (source_bytes - compressed_bytes) / source_bytes);
+	}
+
+	// texture atlases, for the meshes cooked in this run
+	if (m_atlas_settings.m_size)
+	{
+		for (size_t i = 0; i < m_nodes.size(); i++)
+		{
+			const AssetNode& node = m_nodes[i];
+			const MeshAtlasReport& report = node.m_atlas_report;
+			if (node.m_type != AssetType::Mesh || !node.m_ok || node.m_cached)
+				continue;
+
+			printf("atlas %u/%u textured materials in %u atlases, %.1f%% of the atlas texels used  %ls\n", report.m_packed, report.m_textured,
+				report.m_stats.m_atlases, report.m_stats.m_efficiency * 100.0, node.m_path.c_str());
+			for (size_t j = 0; j < report.m_tiling.size(); j++)
+				printf("      left out, the texture repeats: %s\n", report.m_tiling[j].c_str());
+			for (size_t j = 0; j < report.m_oversized.size(); j++)
+				printf("      left out, the texture is bigger than an atlas: %s\n", report.m_oversized[j].c_str());
+			for (size_t j = 0; j < report.m_unreadable.size(); j++)
+				printf("      left out, the texture is missing or can not be decoded: %s\n", report.m_unreadable[j].c_str());
+		}
+		printf("\n");
+	}
+
+	// precision of the packed vertex formats, for the meshes cooked in this run
+	if (m_vertex_format.isPacked())
+	{
+		unsigned long long float_bytes = 0, packed_bytes = 0;
+		for (size_t i = 0; i < m_nodes.size(); i++)
+		{
+			const AssetNode& node = m_nodes[i];
+			const VertexPackReport& report = node.m_vertex_report;
+			if (node.m_type != AssetType::Mesh || !node.m_ok || node.m_cached)
+				continue;
+
+			printf("vertices %8u: %9u -> %9u bytes, error position %.6f texcoord %.6f normal %.3f deg  %ls\n", report.m_vertices,
+				report.m_float_bytes, report.m_packed_bytes, report.m_position_error, report.m_texcoord_error, report.m_normal_error, node.m_path.c_str());
+			float_bytes += report.m_float_bytes;
+			packed_bytes += report.m_packed_bytes;
+		}
+		if (float_bytes)
+			printf("vertex memory %llu -> %llu bytes (%.1f%% saved)\n\n", float_bytes, packed_bytes, 100.0 * (float_bytes - packed_bytes) / float_bytes);
+	}
+
+	printf("%u assets: %u cooked, %u cached, %u failed. Cache hit rate %.1f%%\n",
+		m_stats.m_assets, m_stats.m_cooked, m_stats.m_cached, m_stats.m_failed, m_stats.m_hit_rate * 100.0);
+	printf("hashing %.2f ms, cooking %.2f ms on %u threads\n", m_stats.m_hash_milliseconds, m_stats.m_cook_milliseconds, JobSystem::get()->getThreadCount());
+}
+
+
+std::wstring AssetCooker::getOutputPath(const AssetNode& node)
+{
+	switch (node.m_type)
+	{
+	case AssetType::Texture:
+		return TextureFile::getCookedPath(node.m_path.c_str());
+	case AssetType::Mesh:
+		return MeshFile::getCookedPath(node.m_path.c_str());
+	default:
+		return std::wstring();
+	}
+}
+
+
+std::wstring AssetCooker::getAtlasName(const AssetNode& node, unsigned int atlas)
+{
+	return node.m_path + L".atlas" + std::to_wstring(atlas);
+}
+
+
+bool AssetCooker::getAtlasOutputs(const AssetNode& node, std::vector<std::wstring>& outputs)
+{
+	outputs.clear();
+
+	MappedFile file;
+	MeshFile mesh;
+	if (!file.open(getOutputPath(node).c_str()) || !mesh.open(file.getData(), file.getSize()))
+		return false;
+
+	for (unsigned int i = 0; i < mesh.getHeader().m_material_count; i++)
+	{
+		const MeshFileMaterial& material = mesh.getMaterials()[i];
+		if (!material.m_atlas)
+			continue;
+
+		std::wstring output = TextureFile::getCookedPath(toWide(material.m_texture).c_str());
+		if (std::find(outputs.begin(), outputs.end(), output) == outputs.end())
+			outputs.push_back(output);
+	}
+	return true;
+}
+
+
+// FNV-1a, 64 bit
+unsigned long long AssetCooker::hash(const void* data, size_t size, unsigned long long seed)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	unsigned long long value = seed;
+
+	for (size_t i = 0; i < size; i++)
+	{
+		value ^= bytes[i];
+		value *= 1099511628211ull;
+	}
+
+	return value;
+}
+
+
+std::wstring AssetCooker::getManifestPath()
+{
+	return m_root + L"\\.cookcache";
+}
+
+
+/*
+	manifest: one line per asset that was cooked successfully
+		GhostCookCache <version>
+		<key as 16 hex digits> <normalized path>
+*/
+
+void AssetCooker::loadManifest()
+{
+	m_manifest.clear();
+
+	MappedFile file;
+	if (!file.open(getManifestPath().c_str()))
+		return;
+
+	std::istringstream stream(std::string((const char*)file.getData(), file.getSize()));
+	std::string magic;
+	unsigned int version = 0;
+	stream >> magic >> version;
+
+	// another cooker version -> nothing is cached
+	if (magic != "GhostCookCache" || version != ASSET_COOKER_VERSION)
+		return;
+
+	// the path is the rest of the line, it can contain spaces
+	std::string key;
+	std::string path;
+	while (stream >> key && std::getline(stream, path))
+	{
+		if (path.size() > 1)
+			m_manifest[path.substr(1)] = std::strtoull(key.c_str(), nullptr, 16);
+	}
+}
+
+
+void AssetCooker::saveManifest()
+{
+	std::ostringstream stream;
+	stream << "GhostCookCache " << ASSET_COOKER_VERSION << "\n";
+
+	for (size_t i = 0; i < m_nodes.size(); i++)
+	{
+		if (!m_nodes[i].m_ok)
+			continue;
+
+		char key[17];
+		snprintf(key, sizeof(key), "%016llx", m_nodes[i].m_key);
+		stream << key << " " << PackFile::normalizePath(m_nodes[i].m_path.c_str()) << "\n";
+	}
+
+	std::string text = stream.str();
+	std::wstring path = getManifestPath();
+	std::wstring temp = path + L".tmp";
+
+	HANDLE handle = ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return;
+
+	DWORD written = 0;
+	BOOL ok = ::WriteFile(handle, text.data(), (DWORD)text.size(), &written, nullptr);
+	::CloseHandle(handle);
+
+	if (!ok || written != text.size())
+	{
+		::DeleteFileW(temp.c_str());
+		return;
+	}
+
+	::MoveFileExW(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+}
@@ -0,0 +1,172 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "MeshFile.h"
+#include "MeshSimplifier.h"
+#include "ObjImporter.h"
+#include "TextureAtlas.h"
+#include "TextureCooker.h"
+#include "VertexPacker.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// part of every cache key: a new version recooks everything (bump it when the output of a cook step changes)
+static const unsigned int ASSET_COOKER_VERSION = 4;
+
+enum class AssetType
+{
+	Mesh,			// .obj -> .gmesh with detail levels and meshlets
+	Material,		// .mtl, not cooked, packed as it is
+	Texture			// .jpg, .png, ... -> .gtex
+};
+
+// texture atlas of a mesh cooked in this run
+struct MeshAtlasReport
+{
+	AtlasStats m_stats;
+	unsigned int m_textured = 0;				// materials with a texture
+	unsigned int m_packed = 0;					// of them drawn from an atlas
+	std::vector<std::string> m_tiling;			// left out: texture coordinates outside [0, 1], the texture repeats
+	std::vector<std::string> m_oversized;		// left out: texture bigger than an atlas
+	std::vector<std::string> m_unreadable;		// left out: texture missing or not decodable
+};
+
+struct AssetNode
+{
+	std::wstring m_path;						// source, relative to the working directory
+	AssetType m_type = AssetType::Texture;
+	std::vector<unsigned int> m_dependencies;	// mesh -> materials -> textures
+	unsigned int m_level = 0;					// 0 = no dependencies, cooked before the assets that depend on it
+
+	unsigned long long m_content_hash = 0;
+	unsigned long long m_key = 0;				// content + cooker version + keys of the dependencies
+	bool m_found = false;						// source exists
+	bool m_cached = false;						// output was up to date
+	bool m_ok = false;
+	bool m_normal_map = false;					// texture named by a "norm" map or by the naming convention
+	double m_milliseconds = 0.0;
+	VertexPackReport m_vertex_report;			// meshes cooked in this run
+	CompressionReport m_texture_report;			// textures cooked in this run
+	MeshAtlasReport m_atlas_report;				// meshes cooked in this run with atlases
+};
+
+struct CookStats
+{
+	unsigned int m_assets = 0;
+	unsigned int m_cooked = 0;
+	unsigned int m_cached = 0;
+	unsigned int m_failed = 0;
+	double m_hash_milliseconds = 0.0;
+	double m_cook_milliseconds = 0.0;
+	double m_hit_rate = 0.0;		// cached / assets
+};
+
+
+/*
+	AssetCooker: turns the source assets of a directory tree into the files the runtime loads directly
+
+	- scan(): walk the tree and build the dependency graph. A mesh depends on the .mtl files of its "mtllib" lines,
+	  a material on the textures of its maps. Textures nobody references are cooked as well
+	- cook(): read all sources in one batch (AsyncFileReader) and hash them (FNV-1a 64). The key of an asset is the
+	  hash of its content, the cooker version and the keys of its dependencies -> a changed texture also marks
+	  the materials and meshes using it as stale
+	- an asset is cached when its key is the one in the manifest of the last run and its output exists
+	- stale assets are cooked level by level (dependencies first), all assets of a level in parallel on the JobSystem
+	- texture atlases (when enabled): the diffuse textures of the materials of a mesh are packed into atlases, the
+	  texture coordinates of their vertices are moved into the regions. A material whose texture repeats stays out
+	  and keeps its texture. The atlases are written next to the mesh (<mesh>.atlas<n>.gtex) and listed as textures
+	  of its materials in the .gmesh
+*/
+
+class AssetCooker
+{
+public:
+
+	AssetCooker(const std::wstring& root);
+
+	// false if the root directory does not exist
+	bool scan();
+	// detail levels of the cooked meshes, part of their cache keys
+	void setLodSettings(const MeshLodSettings& settings);
+	// vertex format of the cooked meshes, part of their cache keys
+	void setVertexFormat(const VertexFormat& format);
+	// mip filter and compression preset of the cooked textures, part of their cache keys
+	void setTextureSettings(const TextureCookSettings& settings);
+	// texture atlases of the meshes, part of their cache keys. Off by default
+	void setAtlasSettings(const AtlasSettings& settings);
+	// force: ignore the manifest and cook everything
+	void cook(bool force);
+	// pack the cooked outputs and the materials into one pack file
+	bool writePack(const wchar_t* pack_file);
+
+	const std::vector<AssetNode>& getAssets();
+	CookStats getStats();
+
+	// per asset timings, texture and vertex compression and the cache hit rate on stdout
+	void printReport();
+
+	// output file of an asset, empty for assets that are not cooked
+	static std::wstring getOutputPath(const AssetNode& node);
+	// name of an atlas of a mesh, loaded like the name of a texture (the cooked file is TextureFile::getCookedPath(name))
+	static std::wstring getAtlasName(const AssetNode& node, unsigned int atlas);
+	// cooked atlases a cooked mesh uses. False if the cooked mesh can not be read
+	static bool getAtlasOutputs(const AssetNode& node, std::vector<std::wstring>& outputs);
+
+	static unsigned long long hash(const void* data, size_t size, unsigned long long seed = 14695981039346656037ull);
+
+private:
+
+	unsigned int addNode(const std::wstring& path, AssetType type);
+	void scanDirectory(const std::wstring& directory);
+	// read a mesh or material and add the assets it references
+	void addReferences(unsigned int node);
+	void computeLevels();
+
+	void hashSources();
+	bool cookAsset(AssetNode& node);
+	// resolve the textures of the materials, pack the ones that fit into atlases and move their texture coordinates
+	bool buildMaterials(AssetNode& node, std::vector<VertexMesh>& vertices, const std::vector<unsigned short>& vertex_materials,
+		const std::vector<ObjMaterial>& obj_materials, std::vector<MeshFileMaterial>& materials);
+	std::wstring resolveTexture(const AssetNode& mesh, const std::string& name);
+
+	std::wstring getManifestPath();
+	void loadManifest();
+	void saveManifest();
+
+private:
+
+	std::wstring m_root;
+	std::vector<AssetNode> m_nodes;
+	std::map<std::string, unsigned int> m_node_lookup;		// normalized path -> node
+	std::map<std::string, unsigned long long> m_manifest;	// normalized path -> key of the last cook
+	CookStats m_stats;
+	MeshLodSettings m_lod_settings;
+	VertexFormat m_vertex_format;
+	TextureCookSettings m_texture_settings;
+	AtlasSettings m_atlas_settings;
+};
@@ -0,0 +1,644 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "AsyncFileReader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <cerrno>
+#endif
+
+
+// one read is never bigger than this, bigger files are read in several steps
+static const size_t ASYNC_READ_CHUNK = 64 * 1024 * 1024;
+
+
+struct AsyncFileReader::Request
+{
+	std::wstring m_path;
+	Completion m_completion;
+	std::vector<unsigned char> m_data;
+	size_t m_done = 0;
+
+#ifdef _WIN32
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+#else
+	int m_file = -1;
+#endif
+
+#ifdef __linux__
+	struct iovec m_iovec = {};
+#endif
+};
+
+
+/*
+	platform part: open a file and get its size, blocking read of the rest of a file, close
+*/
+
+#ifdef _WIN32
+
+static bool openRequestFile(const std::wstring& path, HANDLE* file, size_t* size)
+{
+	*file = ::CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (*file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size = {};
+	if (!::GetFileSizeEx(*file, &file_size))
+	{
+		::CloseHandle(*file);
+		*file = INVALID_HANDLE_VALUE;
+		return false;
+	}
+
+	*size = (size_t)file_size.QuadPart;
+	return true;
+}
+
+
+static void closeRequestFile(HANDLE* file)
+{
+	if (*file != INVALID_HANDLE_VALUE)
+		::CloseHandle(*file);
+	*file = INVALID_HANDLE_VALUE;
+}
+
+
+static bool readRequestFile(HANDLE file, unsigned char* data, size_t size)
+{
+	size_t done = 0;
+	while (done < size)
+	{
+		DWORD count = (DWORD)std::min(size - done, ASYNC_READ_CHUNK);
+		DWORD read = 0;
+		if (!::ReadFile(file, data + done, count, &read, nullptr) || read == 0)
+			return false;
+		done += read;
+	}
+	return true;
+}
+
+#else
+
+// asset paths use '\' as separator -> native path, UTF-8 encoded
+static std::string toNativePath(const std::wstring& path)
+{
+	std::string result;
+	for (size_t i = 0; i < path.size(); i++)
+	{
+		unsigned int c = (unsigned int)path[i];
+		if (c == L'\\')
+			c = L'/';
+
+		if (c < 0x80)
+		{
+			result.push_back((char)c);
+		}
+		else if (c < 0x800)
+		{
+			result.push_back((char)(0xC0 | (c >> 6)));
+			result.push_back((char)(0x80 | (c & 0x3F)));
+		}
+		else if (c < 0x10000)
+		{
+			result.push_back((char)(0xE0 | (c >> 12)));
+			result.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+			result.push_back((char)(0x80 | (c & 0x3F)));
+		}
+		else
+		{
+			result.push_back((char)(0xF0 | (c >> 18)));
+			result.push_back((char)(0x80 | ((c >> 12) & 0x3F)));
+			result.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+			result.push_back((char)(0x80 | (c & 0x3F)));
+		}
+	}
+	return result;
+}
+
+
+static bool openRequestFile(const std::wstring& path, int* file, size_t* size)
+{
+	*file = ::open(toNativePath(path).c_str(), O_RDONLY | O_CLOEXEC);
+	if (*file < 0)
+		return false;
+
+	struct stat info;
+	if (::fstat(*file, &info) != 0 || !S_ISREG(info.st_mode))
+	{
+		::close(*file);
+		*file = -1;
+		return false;
+	}
+
+	*size = (size_t)info.st_size;
+	return true;
+}
+
+
+static void closeRequestFile(int* file)
+{
+	if (*file >= 0)
+		::close(*file);
+	*file = -1;
+}
+
+
+static bool readRequestFile(int file, unsigned char* data, size_t size)
+{
+	size_t done = 0;
+	while (done < size)
+	{
+		ssize_t read = ::pread(file, data + done, std::min(size - done, ASYNC_READ_CHUNK), (off_t)done);
+		if (read < 0 && errno == EINTR)
+			continue;
+		if (read <= 0)
+			return false;
+		done += (size_t)read;
+	}
+	return true;
+}
+
+#endif
+
+
+#ifdef __linux__
+
+/*
+	minimal io_uring without liburing: the two rings are shared with the kernel through mmap
+	- submission: write an entry, then publish the new tail (release) -> io_uring_enter submits and waits
+	- completion: read entries between our head and the tail of the kernel (acquire), then publish the new head
+*/
+
+class UringQueue
+{
+public:
+
+	bool init(unsigned int entries)
+	{
+		io_uring_params params = {};
+		m_fd = (int)::syscall(__NR_io_uring_setup, entries, &params);
+		if (m_fd < 0)
+			return false;
+
+		m_sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+		if (single_mmap)
+			m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+
+		m_sq_ring = ::mmap(nullptr, m_sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+		if (m_sq_ring == MAP_FAILED)
+		{
+			m_sq_ring = nullptr;
+			return false;
+		}
+
+		if (single_mmap)
+		{
+			m_cq_ring = m_sq_ring;
+		}
+		else
+		{
+			m_cq_ring = ::mmap(nullptr, m_cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+			if (m_cq_ring == MAP_FAILED)
+			{
+				m_cq_ring = nullptr;
+				return false;
+			}
+		}
+
+		m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		void* sqes = ::mmap(nullptr, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+		if (sqes == MAP_FAILED)
+			return false;
+		m_sqes = (io_uring_sqe*)sqes;
+
+		unsigned char* sq = (unsigned char*)m_sq_ring;
+		m_sq_head = (unsigned int*)(sq + params.sq_off.head);
+		m_sq_tail = (unsigned int*)(sq + params.sq_off.tail);
+		m_sq_mask = *(unsigned int*)(sq + params.sq_off.ring_mask);
+		m_sq_entries = *(unsigned int*)(sq + params.sq_off.ring_entries);
+		m_sq_array = (unsigned int*)(sq + params.sq_off.array);
+
+		unsigned char* cq = (unsigned char*)m_cq_ring;
+		m_cq_head = (unsigned int*)(cq + params.cq_off.head);
+		m_cq_tail = (unsigned int*)(cq + params.cq_off.tail);
+		m_cq_mask = *(unsigned int*)(cq + params.cq_off.ring_mask);
+		m_cqes = (io_uring_cqe*)(cq + params.cq_off.cqes);
+
+		m_local_tail = *m_sq_tail;
+		return true;
+	}
+
+	// free submission entry, nullptr when the ring is full
+	io_uring_sqe* getSqe()
+	{
+		unsigned int head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+		if (m_local_tail - head >= m_sq_entries)
+			return nullptr;
+
+		unsigned int index = m_local_tail & m_sq_mask;
+		m_sq_array[index] = index;
+		m_local_tail++;
+		m_to_submit++;
+
+		io_uring_sqe* sqe = &m_sqes[index];
+		::memset(sqe, 0, sizeof(io_uring_sqe));
+		return sqe;
+	}
+
+	// submit the new entries and wait for at least wait_count completions
+	bool submitAndWait(unsigned int wait_count)
+	{
+		__atomic_store_n(m_sq_tail, m_local_tail, __ATOMIC_RELEASE);
+
+		while (true)
+		{
+			int res = (int)::syscall(__NR_io_uring_enter, m_fd, m_to_submit, wait_count, wait_count ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+			if (res >= 0)
+			{
+				m_to_submit -= std::min((unsigned int)res, m_to_submit);
+				return true;
+			}
+			if (errno != EINTR)
+				return false;
+		}
+	}
+
+	bool popCqe(io_uring_cqe* cqe)
+	{
+		unsigned int head = *m_cq_head;
+		if (head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE))
+			return false;
+
+		*cqe = m_cqes[head & m_cq_mask];
+		__atomic_store_n(m_cq_head, head + 1, __ATOMIC_RELEASE);
+		return true;
+	}
+
+	~UringQueue()
+	{
+		if (m_sqes) ::munmap(m_sqes, m_sqes_size);
+		if (m_cq_ring && m_cq_ring != m_sq_ring) ::munmap(m_cq_ring, m_cq_size);
+		if (m_sq_ring) ::munmap(m_sq_ring, m_sq_size);
+		if (m_fd >= 0) ::close(m_fd);
+	}
+
+private:
+
+	int m_fd = -1;
+	void* m_sq_ring = nullptr;
+	void* m_cq_ring = nullptr;
+	size_t m_sq_size = 0;
+	size_t m_cq_size = 0;
+	size_t m_sqes_size = 0;
+
+	unsigned int* m_sq_head = nullptr;
+	unsigned int* m_sq_tail = nullptr;
+	unsigned int* m_sq_array = nullptr;
+	unsigned int m_sq_mask = 0;
+	unsigned int m_sq_entries = 0;
+	io_uring_sqe* m_sqes = nullptr;
+
+	unsigned int* m_cq_head = nullptr;
+	unsigned int* m_cq_tail = nullptr;
+	unsigned int m_cq_mask = 0;
+	io_uring_cqe* m_cqes = nullptr;
+
+	unsigned int m_local_tail = 0;
+	unsigned int m_to_submit = 0;
+};
+
+#endif
+
+
+AsyncFileReader::AsyncFileReader(unsigned int queue_depth) :m_queue_depth(queue_depth ? queue_depth : 1)
+{
+}
+
+
+void AsyncFileReader::read(const std::wstring& path, const Completion& completion)
+{
+	Request* request = new Request();
+	request->m_path = path;
+	request->m_completion = completion;
+	m_queued.push_back(request);
+}
+
+
+void AsyncFileReader::submit()
+{
+	// one batch at a time: the I/O thread of the previous batch has to be finished
+	if (m_thread.joinable())
+		m_thread.join();
+
+	if (m_queued.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_stats_mutex);
+		m_stats = AsyncReadStats();
+		m_stats.m_queue_depth = m_queue_depth;
+		m_in_flight_sum = 0;
+		m_in_flight_samples = 0;
+	}
+
+	std::vector<Request*> batch;
+	batch.swap(m_queued);
+	m_thread = std::thread(&AsyncFileReader::ioLoop, this, std::move(batch));
+}
+
+
+void AsyncFileReader::wait()
+{
+	if (m_thread.joinable())
+		m_thread.join();
+
+	JobSystem::get()->wait(m_counter);
+}
+
+
+AsyncReadStats AsyncFileReader::getStats()
+{
+	std::lock_guard<std::mutex> lock(m_stats_mutex);
+	return m_stats;
+}
+
+
+bool AsyncFileReader::isUringAvailable()
+{
+#ifdef __linux__
+	UringQueue queue;
+	return queue.init(1);
+#else
+	return false;
+#endif
+}
+
+
+void AsyncFileReader::ioLoop(std::vector<Request*> batch)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	// io_uring leaves the files it could not read in the batch
+	runUring(batch);
+	runThreadPool(batch);
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	std::lock_guard<std::mutex> lock(m_stats_mutex);
+	m_stats.m_milliseconds = ms;
+	m_stats.m_megabytes_per_second = ms > 0.0 ? (m_stats.m_bytes / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+	m_stats.m_average_in_flight = m_in_flight_samples ? (double)m_in_flight_sum / m_in_flight_samples : 0.0;
+}
+
+
+/*
+	- keeps up to queue_depth files in flight; one io_uring_enter submits all new reads and waits for the next completion
+	- every completion either finishes a file (-> job) or submits the next part of it (short read or big file)
+	- if the ring can not be created or fails later, the unfinished files are left in batch for the thread pool
+*/
+
+void AsyncFileReader::runUring(std::vector<Request*>& batch)
+{
+#ifdef __linux__
+	std::deque<Request*> pending(batch.begin(), batch.end());
+	std::vector<Request*> in_flight;
+	batch.clear();
+
+	{
+		UringQueue queue;
+		if (!queue.init(m_queue_depth))
+		{
+			batch.assign(pending.begin(), pending.end());
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_stats_mutex);
+			m_stats.m_backend = "io_uring";
+		}
+
+		auto queueRead = [&queue](Request* request)
+		{
+			request->m_iovec.iov_base = request->m_data.data() + request->m_done;
+			request->m_iovec.iov_len = std::min(request->m_data.size() - request->m_done, ASYNC_READ_CHUNK);
+
+			// the ring has queue_depth entries and at most queue_depth files are in flight -> never full
+			io_uring_sqe* sqe = queue.getSqe();
+			sqe->opcode = IORING_OP_READV;
+			sqe->fd = request->m_file;
+			sqe->addr = (unsigned long long)(uintptr_t)&request->m_iovec;
+			sqe->len = 1;
+			sqe->off = request->m_done;
+			sqe->user_data = (unsigned long long)(uintptr_t)request;
+		};
+
+		while (!pending.empty() || !in_flight.empty())
+		{
+			// refill the queue
+			while (in_flight.size() < m_queue_depth && !pending.empty())
+			{
+				Request* request = pending.front();
+				pending.pop_front();
+
+				size_t size = 0;
+				if (!openRequestFile(request->m_path, &request->m_file, &size))
+				{
+					complete(request, false);
+					continue;
+				}
+
+				request->m_data.resize(size);
+				if (size == 0)
+				{
+					closeRequestFile(&request->m_file);
+					complete(request, true);
+					continue;
+				}
+
+				queueRead(request);
+				in_flight.push_back(request);
+			}
+
+			if (in_flight.empty())
+				continue;
+
+			sampleInFlight((unsigned int)in_flight.size());
+
+			// the ring broke down: the queue is destroyed first (the kernel cancels and finishes its reads), then
+			// the thread pool reads the unfinished files again
+			if (!queue.submitAndWait(1))
+				break;
+
+			io_uring_cqe cqe;
+			while (queue.popCqe(&cqe))
+			{
+				Request* request = (Request*)(uintptr_t)cqe.user_data;
+
+				if (cqe.res > 0)
+					request->m_done += (size_t)cqe.res;
+
+				if (cqe.res > 0 && request->m_done < request->m_data.size())
+				{
+					queueRead(request);
+					continue;
+				}
+
+				in_flight.erase(std::find(in_flight.begin(), in_flight.end(), request));
+				closeRequestFile(&request->m_file);
+				complete(request, cqe.res > 0);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < in_flight.size(); i++)
+	{
+		closeRequestFile(&in_flight[i]->m_file);
+		in_flight[i]->m_done = 0;
+		batch.push_back(in_flight[i]);
+	}
+	batch.insert(batch.end(), pending.begin(), pending.end());
+#else
+	(void)batch;
+#endif
+}
+
+
+/*
+	blocking reads on queue_depth threads. Each thread takes the next file of the batch until all are read
+*/
+
+void AsyncFileReader::runThreadPool(std::vector<Request*>& batch)
+{
+	if (batch.empty())
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_stats_mutex);
+		if (m_stats.m_backend[0] == 0)
+			m_stats.m_backend = "thread pool";
+	}
+
+	std::atomic<size_t> next(0);
+	std::atomic<unsigned int> in_flight(0);
+
+	auto worker = [this, &batch, &next, &in_flight]()
+	{
+		for (size_t i = next++; i < batch.size(); i = next++)
+		{
+			Request* request = batch[i];
+			sampleInFlight(++in_flight);
+
+			size_t size = 0;
+			bool ok = openRequestFile(request->m_path, &request->m_file, &size);
+			if (ok)
+			{
+				request->m_data.resize(size);
+				ok = readRequestFile(request->m_file, request->m_data.data(), size);
+				closeRequestFile(&request->m_file);
+			}
+
+			in_flight--;
+			complete(request, ok);
+		}
+	};
+
+	unsigned int thread_count = (unsigned int)std::min((size_t)m_queue_depth, batch.size());
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < thread_count; i++)
+	{
+		threads.push_back(std::thread(worker));
+	}
+
+	// the I/O thread is one of the pool
+	worker();
+
+	for (size_t i = 0; i < threads.size(); i++)
+	{
+		threads[i].join();
+	}
+}
+
+
+void AsyncFileReader::complete(Request* request, bool ok)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_stats_mutex);
+		m_stats.m_files++;
+		if (ok)
+			m_stats.m_bytes += request->m_data.size();
+		else
+			m_stats.m_failed++;
+	}
+
+	if (!ok)
+		request->m_data.clear();
+
+	JobSystem::get()->execute([request, ok]()
+		{
+			request->m_completion(request->m_path, request->m_data, ok);
+			delete request;
+		}, &m_counter);
+}
+
+
+void AsyncFileReader::sampleInFlight(unsigned int in_flight)
+{
+	std::lock_guard<std::mutex> lock(m_stats_mutex);
+	m_in_flight_sum += in_flight;
+	m_in_flight_samples++;
+	m_stats.m_max_in_flight = std::max(m_stats.m_max_in_flight, in_flight);
+}
+
+
+AsyncFileReader::~AsyncFileReader()
+{
+	wait();
+
+	for (size_t i = 0; i < m_queued.size(); i++)
+	{
+		delete m_queued[i];
+	}
+}
@@ -0,0 +1,110 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "JobSystem.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+struct AsyncReadStats
+{
+	const char* m_backend = "";
+	unsigned int m_files = 0;
+	unsigned int m_failed = 0;
+	size_t m_bytes = 0;
+	unsigned int m_queue_depth = 0;			// reads allowed in flight
+	unsigned int m_max_in_flight = 0;
+	double m_average_in_flight = 0.0;		// sampled every time the queue is refilled
+	double m_milliseconds = 0.0;
+	double m_megabytes_per_second = 0.0;
+};
+
+
+/*
+	AsyncFileReader: reads many whole files in one batch and hands every file to a job of the JobSystem
+
+	- read() only queues, submit() starts the I/O on a separate thread, wait() returns when all files are read and
+	  all completion jobs are finished
+	- the completion runs on a worker as soon as its file is there, while other reads are still in flight -> work done
+	  in it overlaps the I/O (the AssetCooker hashes its sources there, FileSystem::prefetch() decodes textures and
+	  meshes there, the render thread only uploads them)
+	- Linux: io_uring. Up to queue_depth reads are in flight with one system call per refill, short reads are
+	  resubmitted. If the kernel has no io_uring (or it is blocked) the thread pool is used
+	- thread pool fallback (Windows and old kernels): queue_depth threads doing blocking reads
+	- only std and OS headers: the reader also builds for the Linux command line tools
+*/
+
+class AsyncFileReader
+{
+public:
+
+	// data is empty when ok is false. The completion may move the data out of the vector
+	typedef std::function<void(const std::wstring& path, std::vector<unsigned char>& data, bool ok)> Completion;
+
+	AsyncFileReader(unsigned int queue_depth = 32);
+	// waits for the reads that are still running
+	~AsyncFileReader();
+
+	// queue the read of a whole file
+	void read(const std::wstring& path, const Completion& completion);
+
+	// start the I/O of all queued reads, returns at once
+	void submit();
+
+	// wait until all submitted reads and their completion jobs are finished
+	void wait();
+
+	// statistics of the last finished batch
+	AsyncReadStats getStats();
+
+	// false when the kernel does not support io_uring (always false on Windows)
+	static bool isUringAvailable();
+
+private:
+
+	struct Request;
+
+	void ioLoop(std::vector<Request*> batch);
+	void runUring(std::vector<Request*>& batch);
+	void runThreadPool(std::vector<Request*>& batch);
+	// hand the file to the JobSystem
+	void complete(Request* request, bool ok);
+	void sampleInFlight(unsigned int in_flight);
+
+private:
+
+	unsigned int m_queue_depth;
+	std::vector<Request*> m_queued;
+
+	std::thread m_thread;
+	JobCounter m_counter;
+
+	AsyncReadStats m_stats;
+	std::mutex m_stats_mutex;
+	unsigned long long m_in_flight_sum = 0;
+	unsigned int m_in_flight_samples = 0;
+};
@@ -0,0 +1,215 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "BVH.h"
+
+#include <algorithm>
+#include <cfloat>
+
+
+static float surfaceArea(const Vector3D& min, const Vector3D& max)
+{
+	Vector3D size = max - min;
+	return size.m_x * size.m_y + size.m_y * size.m_z + size.m_z * size.m_x;
+}
+
+static void growBox(Vector3D& box_min, Vector3D& box_max, const Vector3D& min, const Vector3D& max)
+{
+	box_min = Vector3D(std::min(box_min.m_x, min.m_x), std::min(box_min.m_y, min.m_y), std::min(box_min.m_z, min.m_z));
+	box_max = Vector3D(std::max(box_max.m_x, max.m_x), std::max(box_max.m_y, max.m_y), std::max(box_max.m_z, max.m_z));
+}
+
+static float getAxis(const Vector3D& vector, unsigned int axis)
+{
+	return axis == 0 ? vector.m_x : (axis == 1 ? vector.m_y : vector.m_z);
+}
+
+
+void BVH::build(const std::vector<Vector3D>& min, const std::vector<Vector3D>& max)
+{
+	clear();
+	if (min.empty())
+		return;
+
+	std::vector<Vector3D> centers(min.size());
+	m_items.resize(min.size());
+	for (unsigned int i = 0; i < (unsigned int)min.size(); i++)
+	{
+		centers[i] = (min[i] + max[i]) * 0.5f;
+		m_items[i] = i;
+	}
+
+	// a binary tree with leaves of at least one item has fewer than 2 n nodes
+	m_nodes.reserve(min.size() * 2);
+	buildNode(min, max, centers, 0, (unsigned int)min.size(), 0);
+}
+
+
+void BVH::clear()
+{
+	m_nodes.clear();
+	m_items.clear();
+}
+
+
+/*
+	- cost of a split: one node test plus the area of each side * its items, relative to the area of the node.
+	  A leaf costs its items
+	- all centers in one bin (identical centers): split in the middle of the range, the tree stays balanced
+*/
+
+unsigned int BVH::buildNode(const std::vector<Vector3D>& min, const std::vector<Vector3D>& max, const std::vector<Vector3D>& centers,
+	unsigned int begin, unsigned int end, unsigned int depth)
+{
+	unsigned int index = (unsigned int)m_nodes.size();
+	m_nodes.push_back(BVHNode());
+
+	Vector3D box_min(FLT_MAX, FLT_MAX, FLT_MAX), box_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	Vector3D center_min = box_min, center_max = box_max;
+	for (unsigned int i = begin; i < end; i++)
+	{
+		unsigned int item = m_items[i];
+		growBox(box_min, box_max, min[item], max[item]);
+		growBox(center_min, center_max, centers[item], centers[item]);
+	}
+
+	BVHNode& node = m_nodes[index];
+	node.m_min[0] = box_min.m_x; node.m_min[1] = box_min.m_y; node.m_min[2] = box_min.m_z;
+	node.m_max[0] = box_max.m_x; node.m_max[1] = box_max.m_y; node.m_max[2] = box_max.m_z;
+	node.m_first = begin;
+	node.m_count = end - begin;
+
+	unsigned int count = end - begin;
+	if (count <= 1 || depth + 2 >= MAX_DEPTH)
+		return index;
+
+	Vector3D extent = center_max - center_min;
+	unsigned int axis = (extent.m_x >= extent.m_y && extent.m_x >= extent.m_z) ? 0 : (extent.m_y >= extent.m_z ? 1 : 2);
+	float axis_min = getAxis(center_min, axis);
+	float axis_extent = getAxis(extent, axis);
+
+	unsigned int middle = begin + count / 2;
+	if (axis_extent > 0.0f)
+	{
+		const unsigned int BINS = 16;
+		unsigned int bin_count[BINS] = {};
+		Vector3D bin_min[BINS], bin_max[BINS];
+		for (unsigned int b = 0; b < BINS; b++)
+		{
+			bin_min[b] = Vector3D(FLT_MAX, FLT_MAX, FLT_MAX);
+			bin_max[b] = Vector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		}
+
+		float scale = BINS / axis_extent;
+		auto binOf = [&](unsigned int item)
+		{
+			return std::min((unsigned int)((getAxis(centers[item], axis) - axis_min) * scale), BINS - 1);
+		};
+		for (unsigned int i = begin; i < end; i++)
+		{
+			unsigned int item = m_items[i];
+			unsigned int b = binOf(item);
+			bin_count[b]++;
+			growBox(bin_min[b], bin_max[b], min[item], max[item]);
+		}
+
+		// areas and counts left of each plane, then right of it while sweeping back
+		float left_area[BINS];
+		unsigned int left_count[BINS];
+		Vector3D grow_min(FLT_MAX, FLT_MAX, FLT_MAX), grow_max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		unsigned int running = 0;
+		for (unsigned int b = 0; b < BINS - 1; b++)
+		{
+			running += bin_count[b];
+			if (bin_count[b])
+				growBox(grow_min, grow_max, bin_min[b], bin_max[b]);
+			left_count[b] = running;
+			left_area[b] = running ? surfaceArea(grow_min, grow_max) : 0.0f;
+		}
+
+		float best_cost = FLT_MAX;
+		unsigned int best_plane = 0;
+		grow_min = Vector3D(FLT_MAX, FLT_MAX, FLT_MAX);
+		grow_max = Vector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		running = 0;
+		for (unsigned int b = BINS - 1; b > 0; b--)
+		{
+			running += bin_count[b];
+			if (bin_count[b])
+				growBox(grow_min, grow_max, bin_min[b], bin_max[b]);
+			if (!running || !left_count[b - 1])
+				continue;
+
+			float cost = left_area[b - 1] * left_count[b - 1] + surfaceArea(grow_min, grow_max) * running;
+			if (cost < best_cost)
+			{
+				best_cost = cost;
+				best_plane = b;
+			}
+		}
+
+		float area = surfaceArea(box_min, box_max);
+		float leaf_cost = area * count;
+		if (count <= MAX_LEAF_ITEMS && best_cost + area >= leaf_cost)
+			return index;
+
+		if (best_cost < FLT_MAX)
+		{
+			unsigned int* split = std::partition(m_items.data() + begin, m_items.data() + end, [&](unsigned int item) { return binOf(item) < best_plane; });
+			middle = (unsigned int)(split - m_items.data());
+		}
+	}
+	else if (count <= MAX_LEAF_ITEMS)
+	{
+		return index;
+	}
+
+	buildNode(min, max, centers, begin, middle, depth + 1);
+	unsigned int second = buildNode(min, max, centers, middle, end, depth + 1);
+
+	// m_nodes may have grown: no reference across the recursion
+	m_nodes[index].m_first = second;
+	m_nodes[index].m_count = 0;
+	return index;
+}
+
+
+const std::vector<BVHNode>& BVH::getNodes() const
+{
+	return m_nodes;
+}
+
+
+const std::vector<unsigned int>& BVH::getItems() const
+{
+	return m_items;
+}
+
+
+bool BVH::isEmpty() const
+{
+	return m_nodes.empty();
+}
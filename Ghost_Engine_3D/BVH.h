@@ -0,0 +1,197 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Vector3D.h"
+#include <vector>
+
+// 32 bytes, two nodes per cache line
+struct BVHNode
+{
+	float m_min[3];
+	unsigned int m_first;		// leaf: first slot in getItems(). Inner node: index of the second child, the first one follows the node
+	float m_max[3];
+	unsigned int m_count;		// items of a leaf, 0 for an inner node
+};
+
+
+/*
+	BVH: bounding volume hierarchy over the boxes of items (triangles of a mesh, instances of a scene)
+
+	- built top down with the surface area heuristic in 16 bins along the longest axis of the box centers. A range
+	  becomes a leaf when no split is cheaper than testing all its items, at most MAX_LEAF_ITEMS
+	- nodes depth first: the first child directly after its parent, so the near path of a query stays in the cache
+	- the item indices are reordered by leaf: slot s of the leaves holds item getItems()[s]. Queries pass the slot, so an
+	  owner that stored its data in slot order (CollisionMesh) reads it without the indirection
+	- queries walk the tree with a small stack, no recursion and no allocation -> safe from any number of threads
+*/
+
+class BVH
+{
+public:
+
+	static const unsigned int MAX_LEAF_ITEMS = 4;
+	static const unsigned int MAX_DEPTH = 64;
+
+	// item i has the box min[i], max[i]
+	void build(const std::vector<Vector3D>& min, const std::vector<Vector3D>& max);
+	void clear();
+
+	const std::vector<BVHNode>& getNodes() const;
+	const std::vector<unsigned int>& getItems() const;
+	bool isEmpty() const;
+
+	/*
+		slots whose box overlaps the box min - max: visit(slot)
+	*/
+	template <class Visitor>
+	void query(const Vector3D& min, const Vector3D& max, Visitor visit) const
+	{
+		if (m_nodes.empty())
+			return;
+
+		unsigned int stack[MAX_DEPTH];
+		unsigned int top = 0;
+		stack[top++] = 0;
+		while (top)
+		{
+			const BVHNode& node = m_nodes[stack[--top]];
+			if (node.m_min[0] > max.m_x || node.m_max[0] < min.m_x || node.m_min[1] > max.m_y || node.m_max[1] < min.m_y ||
+				node.m_min[2] > max.m_z || node.m_max[2] < min.m_z)
+				continue;
+
+			if (node.m_count)
+			{
+				for (unsigned int i = 0; i < node.m_count; i++)
+					visit(node.m_first + i);
+			}
+			else
+			{
+				stack[top++] = node.m_first;
+				stack[top++] = (unsigned int)(&node - m_nodes.data()) + 1;
+			}
+		}
+	}
+
+	/*
+		slots whose box, grown by radius, is touched by the segment start + delta * t for t in [0, max_t]:
+		visit(slot, max_t) may lower max_t to the nearest hit so far. The nearer child is visited first and nodes
+		entered beyond max_t are skipped -> a sweep that hits something early tests few items
+	*/
+	template <class Visitor>
+	void sweep(const Vector3D& start, const Vector3D& delta, float radius, float& max_t, Visitor visit) const
+	{
+		if (m_nodes.empty())
+			return;
+
+		// 1 / 0 as a large number: 0 * large stays 0 for a start on the slab plane, where infinity gives NaN
+		float inverse[3] =
+		{
+			fabsf(delta.m_x) > 1e-30f ? 1.0f / delta.m_x : (delta.m_x < 0.0f ? -1e30f : 1e30f),
+			fabsf(delta.m_y) > 1e-30f ? 1.0f / delta.m_y : (delta.m_y < 0.0f ? -1e30f : 1e30f),
+			fabsf(delta.m_z) > 1e-30f ? 1.0f / delta.m_z : (delta.m_z < 0.0f ? -1e30f : 1e30f)
+		};
+		float origin[3] = { start.m_x, start.m_y, start.m_z };
+
+		auto enter = [&](const BVHNode& node, float& t)
+		{
+			float near_t = 0.0f;
+			float far_t = max_t;
+			for (int axis = 0; axis < 3; axis++)
+			{
+				float t0 = (node.m_min[axis] - radius - origin[axis]) * inverse[axis];
+				float t1 = (node.m_max[axis] + radius - origin[axis]) * inverse[axis];
+				if (t0 > t1)
+				{
+					float swap = t0;
+					t0 = t1;
+					t1 = swap;
+				}
+				near_t = t0 > near_t ? t0 : near_t;
+				far_t = t1 < far_t ? t1 : far_t;
+			}
+			t = near_t;
+			return near_t <= far_t;
+		};
+
+		struct Entry
+		{
+			unsigned int m_node;
+			float m_t;
+		};
+		Entry stack[MAX_DEPTH];
+		unsigned int top = 0;
+
+		float t = 0.0f;
+		if (enter(m_nodes[0], t))
+			stack[top++] = { 0, t };
+
+		while (top)
+		{
+			Entry entry = stack[--top];
+			if (entry.m_t > max_t)
+				continue;
+
+			const BVHNode& node = m_nodes[entry.m_node];
+			if (node.m_count)
+			{
+				for (unsigned int i = 0; i < node.m_count; i++)
+					visit(node.m_first + i, max_t);
+				continue;
+			}
+
+			unsigned int first = entry.m_node + 1;
+			unsigned int second = node.m_first;
+			float first_t = 0.0f, second_t = 0.0f;
+			bool first_hit = enter(m_nodes[first], first_t);
+			bool second_hit = enter(m_nodes[second], second_t);
+
+			// the nearer child on top of the stack
+			if (first_hit && second_hit && first_t < second_t)
+			{
+				stack[top++] = { second, second_t };
+				stack[top++] = { first, first_t };
+			}
+			else
+			{
+				if (first_hit)
+					stack[top++] = { first, first_t };
+				if (second_hit)
+					stack[top++] = { second, second_t };
+			}
+		}
+	}
+
+private:
+
+	unsigned int buildNode(const std::vector<Vector3D>& min, const std::vector<Vector3D>& max, const std::vector<Vector3D>& centers,
+		unsigned int begin, unsigned int end, unsigned int depth);
+
+private:
+
+	std::vector<BVHNode> m_nodes;
+	std::vector<unsigned int> m_items;
+};
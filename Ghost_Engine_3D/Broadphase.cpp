@@ -0,0 +1,800 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "Broadphase.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+
+// cell coordinates in 21 bits per axis of a key
+static const int CELL_BIAS = 1 << 20;
+
+static uint64_t packCell(int x, int y, int z)
+{
+	return ((uint64_t)(x + CELL_BIAS) << 42) | ((uint64_t)(y + CELL_BIAS) << 21) | (uint64_t)(z + CELL_BIAS);
+}
+
+static int toCell(float value, float inverse_cell)
+{
+	float cell = floorf(value * inverse_cell);
+	return (int)std::min(std::max(cell, (float)-CELL_BIAS), (float)(CELL_BIAS - 1));
+}
+
+template <class Box>
+static bool overlaps(const Box& a, const Box& b)
+{
+	return a.m_min[0] <= b.m_max[0] && b.m_min[0] <= a.m_max[0] &&
+		a.m_min[1] <= b.m_max[1] && b.m_min[1] <= a.m_max[1] &&
+		a.m_min[2] <= b.m_max[2] && b.m_min[2] <= a.m_max[2];
+}
+
+static BroadphasePair makePair(unsigned int a, unsigned int b)
+{
+	return a < b ? BroadphasePair{ a, b } : BroadphasePair{ b, a };
+}
+
+
+/*
+	- chunks sorted on all threads, then merged: a round of merges per doubling of the chunk size
+*/
+
+template <class T, class Less>
+static void parallelSort(std::vector<T>& items, Less less)
+{
+	unsigned int count = (unsigned int)items.size();
+	unsigned int chunks = 1;
+	while (chunks * 2 <= JobSystem::get()->getThreadCount())
+		chunks *= 2;
+	if (chunks == 1 || count < 8192)
+	{
+		std::sort(items.begin(), items.end(), less);
+		return;
+	}
+
+	unsigned int size = (count + chunks - 1) / chunks;
+	JobSystem::get()->parallelFor(chunks, 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int chunk = begin; chunk < end; chunk++)
+				std::sort(items.begin() + std::min(chunk * size, count), items.begin() + std::min((chunk + 1) * size, count), less);
+		});
+
+	for (; size < count; size *= 2)
+	{
+		unsigned int merges = (count + size * 2 - 1) / (size * 2);
+		JobSystem::get()->parallelFor(merges, 1, [&](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int merge = begin; merge < end; merge++)
+				{
+					unsigned int first = merge * size * 2;
+					unsigned int middle = std::min(first + size, count);
+					unsigned int last = std::min(first + size * 2, count);
+					std::inplace_merge(items.begin() + first, items.begin() + middle, items.begin() + last, less);
+				}
+			});
+	}
+}
+
+
+/*
+	- job(begin, end, pairs) for chunks of [0, count) on all threads, the pairs of the chunks appended in chunk order
+*/
+
+template <class Job>
+static void collectPairs(unsigned int count, std::vector<std::vector<BroadphasePair>>& chunk_pairs, std::vector<BroadphasePair>& pairs, Job job)
+{
+	if (!count)
+		return;
+
+	unsigned int jobs = JobSystem::get()->getThreadCount() * 8;
+	unsigned int group = std::max((count + jobs - 1) / jobs, 1u);
+	unsigned int chunks = (count + group - 1) / group;
+	if (chunk_pairs.size() < chunks)
+		chunk_pairs.resize(chunks);
+
+	JobSystem::get()->parallelFor(count, group, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<BroadphasePair>& chunk = chunk_pairs[begin / group];
+			chunk.clear();
+			job(begin, end, chunk);
+		});
+
+	for (unsigned int chunk = 0; chunk < chunks; chunk++)
+		pairs.insert(pairs.end(), chunk_pairs[chunk].begin(), chunk_pairs[chunk].end());
+}
+
+
+unsigned int Broadphase::add(const Vector3D& min, const Vector3D& max)
+{
+	unsigned int proxy;
+	if (!m_free.empty())
+	{
+		proxy = m_free.back();
+		m_free.pop_back();
+	}
+	else
+	{
+		proxy = (unsigned int)m_boxes.size();
+		m_boxes.emplace_back();
+		m_alive.push_back(0);
+		m_moved_flag.push_back(0);
+		m_stale.push_back(0);
+		m_large_flag.push_back(0);
+	}
+
+	m_alive[proxy] = 1;
+	m_proxy_count++;
+	update(proxy, min, max);
+	return proxy;
+}
+
+
+void Broadphase::remove(unsigned int proxy)
+{
+	if (proxy >= m_boxes.size() || !m_alive[proxy])
+		return;
+
+	// empty: sorts behind every box and overlaps nothing, its pairs go away as the pairs of a moved proxy
+	update(proxy, Vector3D(FLT_MAX, FLT_MAX, FLT_MAX), Vector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX));
+	m_alive[proxy] = 0;
+	m_free.push_back(proxy);
+	m_proxy_count--;
+}
+
+
+void Broadphase::update(unsigned int proxy, const Vector3D& min, const Vector3D& max)
+{
+	Box& box = m_boxes[proxy];
+	box.m_min[0] = min.m_x;
+	box.m_min[1] = min.m_y;
+	box.m_min[2] = min.m_z;
+	box.m_max[0] = max.m_x;
+	box.m_max[1] = max.m_y;
+	box.m_max[2] = max.m_z;
+
+	if (!m_moved_flag[proxy])
+	{
+		m_moved_flag[proxy] = 1;
+		m_moved.push_back(proxy);
+	}
+}
+
+
+void Broadphase::clear()
+{
+	m_boxes.clear();
+	m_alive.clear();
+	m_free.clear();
+	m_proxy_count = 0;
+	m_moved.clear();
+	m_moved_flag.clear();
+	m_order.clear();
+	m_position.clear();
+	m_sorted.clear();
+	m_cells.clear();
+	m_moved_cells.clear();
+	m_stale.clear();
+	m_stale_list.clear();
+	m_large_flag.clear();
+	m_large.clear();
+	m_pairs.clear();
+	m_full = true;
+	m_incremental = false;
+}
+
+
+void Broadphase::setMethod(BroadphaseMethod method)
+{
+	if (method != m_method)
+		m_full = true;
+	m_method = method;
+}
+
+
+BroadphaseMethod Broadphase::getMethod() const
+{
+	return m_method;
+}
+
+
+void Broadphase::setCellSize(float size)
+{
+	if (size != m_cell_size)
+		m_full = true;
+	m_cell_size = size;
+}
+
+
+float Broadphase::getCellSize() const
+{
+	return m_used_cell_size;
+}
+
+
+const std::vector<BroadphasePair>& Broadphase::getPairs() const
+{
+	return m_pairs;
+}
+
+
+bool Broadphase::wasIncremental() const
+{
+	return m_incremental;
+}
+
+
+unsigned int Broadphase::getProxyCount() const
+{
+	return m_proxy_count;
+}
+
+
+void Broadphase::findPairs()
+{
+	bool full = m_full || m_moved.size() * 4 > m_proxy_count;
+	if (!full && m_method == BroadphaseMethod::SpatialHash)
+	{
+		for (unsigned int proxy : m_moved)
+		{
+			if (!m_stale[proxy])
+			{
+				m_stale[proxy] = 1;
+				m_stale_list.push_back(proxy);
+			}
+		}
+		full = m_stale_list.size() * 8 > m_proxy_count;
+	}
+
+	if (full)
+	{
+		m_pairs.clear();
+		if (m_method == BroadphaseMethod::SortAndSweep)
+			sweepAll();
+		else
+			hashAll();
+	}
+	else
+	{
+		// the pairs of the moved proxies are found again
+		m_pairs.erase(std::remove_if(m_pairs.begin(), m_pairs.end(), [&](const BroadphasePair& pair) { return m_moved_flag[pair.m_a] || m_moved_flag[pair.m_b]; }),
+			m_pairs.end());
+		if (m_method == BroadphaseMethod::SortAndSweep)
+			sweepMoved();
+		else
+			hashMoved();
+	}
+
+	m_incremental = !full;
+	m_full = false;
+	for (unsigned int proxy : m_moved)
+		m_moved_flag[proxy] = 0;
+	m_moved.clear();
+}
+
+
+void Broadphase::sweepAll()
+{
+	unsigned int count = (unsigned int)m_boxes.size();
+
+	// the axis along which the centers spread most separates the most proxies
+	double sum[3] = {};
+	double square[3] = {};
+	for (unsigned int proxy = 0; proxy < count; proxy++)
+	{
+		if (!m_alive[proxy])
+			continue;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			double center = 0.5 * ((double)m_boxes[proxy].m_min[axis] + m_boxes[proxy].m_max[axis]);
+			sum[axis] += center;
+			square[axis] += center * center;
+		}
+	}
+	double best_variance = -1.0;
+	for (unsigned int axis = 0; axis < 3; axis++)
+	{
+		double variance = square[axis] - sum[axis] * sum[axis] / std::max(m_proxy_count, 1u);
+		if (variance > best_variance)
+		{
+			best_variance = variance;
+			m_axis = axis;
+		}
+	}
+
+	unsigned int axis = m_axis;
+	const std::vector<Box>& boxes = m_boxes;
+	m_order.resize(count);
+	for (unsigned int proxy = 0; proxy < count; proxy++)
+		m_order[proxy] = proxy;
+	parallelSort(m_order, [&](unsigned int a, unsigned int b)
+		{
+			return boxes[a].m_min[axis] < boxes[b].m_min[axis] || (boxes[a].m_min[axis] == boxes[b].m_min[axis] && a < b);
+		});
+
+	double width = 0.0;
+	for (unsigned int proxy = 0; proxy < count; proxy++)
+	{
+		if (m_alive[proxy])
+			width += m_boxes[proxy].m_max[axis] - m_boxes[proxy].m_min[axis];
+	}
+	m_large_width = std::max((float)(LARGE_WIDTH * width / std::max(m_proxy_count, 1u)), FLT_MIN);
+
+	m_position.resize(count);
+	m_sorted.resize(count);
+	m_max_width = 0.0f;
+	m_large.clear();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int proxy = m_order[i];
+		m_position[proxy] = i;
+		m_sorted[i] = m_boxes[proxy];
+		float box_width = m_sorted[i].m_max[axis] - m_sorted[i].m_min[axis];
+		m_large_flag[proxy] = m_alive[proxy] && box_width > m_large_width;
+		if (m_large_flag[proxy])
+			m_large.push_back(proxy);
+		else if (m_alive[proxy])
+			m_max_width = std::max(m_max_width, box_width);
+	}
+
+	const Box* sorted = m_sorted.data();
+	const unsigned int* order = m_order.data();
+	collectPairs(count, m_chunk_pairs, m_pairs, [&](unsigned int begin, unsigned int end, std::vector<BroadphasePair>& pairs)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				const Box& box = sorted[i];
+				for (unsigned int j = i + 1; j < count && sorted[j].m_min[axis] <= box.m_max[axis]; j++)
+				{
+					if (overlaps(box, sorted[j]))
+						pairs.push_back(makePair(order[i], order[j]));
+				}
+			}
+		});
+}
+
+
+void Broadphase::sweepMoved()
+{
+	unsigned int count = (unsigned int)m_boxes.size();
+	unsigned int axis = m_axis;
+
+	// added proxies at the end, the insertion sort moves them to their place with the moved ones
+	unsigned int sorted_count = (unsigned int)m_order.size();
+	m_order.resize(count);
+	m_position.resize(count);
+	m_sorted.resize(count);
+	for (unsigned int proxy = sorted_count; proxy < count; proxy++)
+	{
+		m_order[proxy] = proxy;
+		m_position[proxy] = proxy;
+	}
+	bool large_changed = false;
+	for (unsigned int proxy : m_moved)
+	{
+		Box& box = m_sorted[m_position[proxy]];
+		box = m_boxes[proxy];
+		float box_width = box.m_max[axis] - box.m_min[axis];
+		char large = m_alive[proxy] && box_width > m_large_width;
+		large_changed |= large != m_large_flag[proxy];
+		m_large_flag[proxy] = large;
+		if (m_alive[proxy] && !large)
+			m_max_width = std::max(m_max_width, box_width);
+	}
+	if (large_changed)
+	{
+		m_large.clear();
+		for (unsigned int proxy = 0; proxy < count; proxy++)
+		{
+			if (m_large_flag[proxy])
+				m_large.push_back(proxy);
+		}
+	}
+
+	auto before = [axis](const Box& a, unsigned int a_proxy, const Box& b, unsigned int b_proxy)
+	{
+		return a.m_min[axis] < b.m_min[axis] || (a.m_min[axis] == b.m_min[axis] && a_proxy < b_proxy);
+	};
+	for (unsigned int i = 1; i < count; i++)
+	{
+		if (!before(m_sorted[i], m_order[i], m_sorted[i - 1], m_order[i - 1]))
+			continue;
+
+		Box box = m_sorted[i];
+		unsigned int proxy = m_order[i];
+		unsigned int j = i;
+		do
+		{
+			m_sorted[j] = m_sorted[j - 1];
+			m_order[j] = m_order[j - 1];
+			m_position[m_order[j]] = j;
+			j--;
+		} while (j > 0 && before(box, proxy, m_sorted[j - 1], m_order[j - 1]));
+		m_sorted[j] = box;
+		m_order[j] = proxy;
+		m_position[proxy] = j;
+	}
+
+	// forwards like the full pass. Backwards the boxes that start at most the widest box earlier and the large ones
+	// before it, unless they moved too and find this one themselves
+	const Box* sorted = m_sorted.data();
+	const unsigned int* order = m_order.data();
+	float reach = m_max_width;
+	collectPairs((unsigned int)m_moved.size(), m_chunk_pairs, m_pairs, [&](unsigned int begin, unsigned int end, std::vector<BroadphasePair>& pairs)
+		{
+			for (unsigned int k = begin; k < end; k++)
+			{
+				unsigned int proxy = m_moved[k];
+				if (!m_alive[proxy])
+					continue;
+
+				unsigned int position = m_position[proxy];
+				const Box& box = sorted[position];
+				for (unsigned int j = position + 1; j < count && sorted[j].m_min[axis] <= box.m_max[axis]; j++)
+				{
+					if (overlaps(box, sorted[j]))
+						pairs.push_back(makePair(proxy, order[j]));
+				}
+				for (unsigned int j = position; j > 0 && sorted[j - 1].m_min[axis] >= box.m_min[axis] - reach; j--)
+				{
+					unsigned int other = order[j - 1];
+					if (!m_moved_flag[other] && !m_large_flag[other] && overlaps(box, sorted[j - 1]))
+						pairs.push_back(makePair(proxy, other));
+				}
+				for (unsigned int other : m_large)
+				{
+					if (!m_moved_flag[other] && m_position[other] < position && overlaps(box, m_boxes[other]))
+						pairs.push_back(makePair(proxy, other));
+				}
+			}
+		});
+}
+
+
+unsigned int Broadphase::getCells(const Box& box, int low[3], int high[3]) const
+{
+	float inverse = 1.0f / m_used_cell_size;
+	uint64_t cells = 1;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		low[axis] = toCell(box.m_min[axis], inverse);
+		high[axis] = toCell(box.m_max[axis], inverse);
+		cells *= (uint64_t)(high[axis] - low[axis] + 1);
+	}
+	return cells <= MAX_PROXY_CELLS ? (unsigned int)cells : 0;
+}
+
+
+// the cell of the min corner of the overlap, a cell of both boxes
+uint64_t Broadphase::getOwnerCell(const Box& a, const Box& b) const
+{
+	float inverse = 1.0f / m_used_cell_size;
+	return packCell(toCell(std::max(a.m_min[0], b.m_min[0]), inverse), toCell(std::max(a.m_min[1], b.m_min[1]), inverse),
+		toCell(std::max(a.m_min[2], b.m_min[2]), inverse));
+}
+
+
+void Broadphase::addCells(unsigned int proxy, CellEntry* entries) const
+{
+	int low[3], high[3];
+	getCells(m_boxes[proxy], low, high);
+	for (int z = low[2]; z <= high[2]; z++)
+	{
+		for (int y = low[1]; y <= high[1]; y++)
+		{
+			for (int x = low[0]; x <= high[0]; x++)
+				*entries++ = { packCell(x, y, z), proxy };
+		}
+	}
+}
+
+
+void Broadphase::hashAll()
+{
+	unsigned int count = (unsigned int)m_boxes.size();
+
+	// twice the mean box size: most proxies in one to eight cells
+	m_used_cell_size = m_cell_size;
+	if (m_used_cell_size <= 0.0f)
+	{
+		double size = 0.0;
+		for (unsigned int proxy = 0; proxy < count; proxy++)
+		{
+			if (!m_alive[proxy])
+				continue;
+			const Box& box = m_boxes[proxy];
+			size += std::max(std::max(box.m_max[0] - box.m_min[0], box.m_max[1] - box.m_min[1]), box.m_max[2] - box.m_min[2]);
+		}
+		m_used_cell_size = std::max((float)(2.0 * size / std::max(m_proxy_count, 1u)), 1e-3f);
+	}
+
+	for (unsigned int proxy : m_stale_list)
+		m_stale[proxy] = 0;
+	m_stale_list.clear();
+	m_moved_cells.clear();
+
+	// entries of every proxy at the offset of its cell count
+	m_cell_offsets.resize(count + 1);
+	JobSystem::get()->parallelFor(count, 1024, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int proxy = begin; proxy < end; proxy++)
+			{
+				int low[3], high[3];
+				unsigned int cells = m_alive[proxy] ? getCells(m_boxes[proxy], low, high) : 0;
+				m_large_flag[proxy] = m_alive[proxy] && !cells;
+				m_cell_offsets[proxy] = cells;
+			}
+		});
+	unsigned int total = 0;
+	m_large.clear();
+	for (unsigned int proxy = 0; proxy < count; proxy++)
+	{
+		unsigned int cells = m_cell_offsets[proxy];
+		m_cell_offsets[proxy] = total;
+		total += cells;
+		if (m_large_flag[proxy])
+			m_large.push_back(proxy);
+	}
+	m_cell_offsets[count] = total;
+
+	m_cells.resize(total);
+	JobSystem::get()->parallelFor(count, 1024, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int proxy = begin; proxy < end; proxy++)
+			{
+				if (m_cell_offsets[proxy + 1] > m_cell_offsets[proxy])
+					addCells(proxy, m_cells.data() + m_cell_offsets[proxy]);
+			}
+		});
+	parallelSort(m_cells, [](const CellEntry& a, const CellEntry& b) { return a.m_key < b.m_key || (a.m_key == b.m_key && a.m_proxy < b.m_proxy); });
+
+	m_runs.clear();
+	for (unsigned int i = 0; i < total;)
+	{
+		unsigned int j = i + 1;
+		while (j < total && m_cells[j].m_key == m_cells[i].m_key)
+			j++;
+		if (j - i > 1)
+			m_runs.push_back(i);
+		i = j;
+	}
+
+	const Box* boxes = m_boxes.data();
+	const CellEntry* cells = m_cells.data();
+	collectPairs((unsigned int)m_runs.size(), m_chunk_pairs, m_pairs, [&](unsigned int begin, unsigned int end, std::vector<BroadphasePair>& pairs)
+		{
+			for (unsigned int run = begin; run < end; run++)
+			{
+				uint64_t key = cells[m_runs[run]].m_key;
+				for (unsigned int i = m_runs[run]; i < total && cells[i].m_key == key; i++)
+				{
+					const Box& box = boxes[cells[i].m_proxy];
+					for (unsigned int j = i + 1; j < total && cells[j].m_key == key; j++)
+					{
+						const Box& other = boxes[cells[j].m_proxy];
+						if (overlaps(box, other) && getOwnerCell(box, other) == key)
+							pairs.push_back(makePair(cells[i].m_proxy, cells[j].m_proxy));
+					}
+				}
+			}
+		});
+
+	// large proxies against every other one, two large ones from the lower id
+	collectPairs((unsigned int)m_large.size(), m_chunk_pairs, m_pairs, [&](unsigned int begin, unsigned int end, std::vector<BroadphasePair>& pairs)
+		{
+			for (unsigned int k = begin; k < end; k++)
+			{
+				unsigned int proxy = m_large[k];
+				for (unsigned int other = 0; other < count; other++)
+				{
+					if (other != proxy && (!m_large_flag[other] || other > proxy) && overlaps(boxes[proxy], boxes[other]))
+						pairs.push_back(makePair(proxy, other));
+				}
+			}
+		});
+}
+
+
+void Broadphase::hashMoved()
+{
+	unsigned int count = (unsigned int)m_boxes.size();
+
+	// the grid of the full pass without the stale proxies, their current cells in the second grid
+	m_current_large.clear();
+	for (unsigned int proxy : m_large)
+	{
+		if (!m_stale[proxy])
+			m_current_large.push_back(proxy);
+	}
+	m_moved_cells.clear();
+	for (unsigned int proxy : m_stale_list)
+	{
+		int low[3], high[3];
+		unsigned int cells = m_alive[proxy] ? getCells(m_boxes[proxy], low, high) : 0;
+		m_large_flag[proxy] = m_alive[proxy] && !cells;
+		if (m_large_flag[proxy])
+			m_current_large.push_back(proxy);
+		else if (cells)
+		{
+			size_t first = m_moved_cells.size();
+			m_moved_cells.resize(first + cells);
+			addCells(proxy, m_moved_cells.data() + first);
+		}
+	}
+	std::sort(m_moved_cells.begin(), m_moved_cells.end(), [](const CellEntry& a, const CellEntry& b) { return a.m_key < b.m_key; });
+
+	// a pair of two moved proxies is found by both, the lower id keeps it
+	const Box* boxes = m_boxes.data();
+	auto visitCell = [&](const std::vector<CellEntry>& cells, bool skip_stale, uint64_t key, unsigned int proxy, std::vector<BroadphasePair>& pairs)
+	{
+		auto entry = std::lower_bound(cells.begin(), cells.end(), key, [](const CellEntry& a, uint64_t b) { return a.m_key < b; });
+		for (; entry != cells.end() && entry->m_key == key; ++entry)
+		{
+			unsigned int other = entry->m_proxy;
+			if (other == proxy || (skip_stale && m_stale[other]) || (m_moved_flag[other] && other < proxy))
+				continue;
+			if (overlaps(boxes[proxy], boxes[other]) && getOwnerCell(boxes[proxy], boxes[other]) == key)
+				pairs.push_back(makePair(proxy, other));
+		}
+	};
+
+	collectPairs((unsigned int)m_moved.size(), m_chunk_pairs, m_pairs, [&](unsigned int begin, unsigned int end, std::vector<BroadphasePair>& pairs)
+		{
+			for (unsigned int k = begin; k < end; k++)
+			{
+				unsigned int proxy = m_moved[k];
+				if (!m_alive[proxy])
+					continue;
+
+				if (m_large_flag[proxy])
+				{
+					for (unsigned int other = 0; other < count; other++)
+					{
+						if (other != proxy && (!m_moved_flag[other] || other > proxy) && overlaps(boxes[proxy], boxes[other]))
+							pairs.push_back(makePair(proxy, other));
+					}
+					continue;
+				}
+
+				int low[3], high[3];
+				getCells(boxes[proxy], low, high);
+				for (int z = low[2]; z <= high[2]; z++)
+				{
+					for (int y = low[1]; y <= high[1]; y++)
+					{
+						for (int x = low[0]; x <= high[0]; x++)
+						{
+							uint64_t key = packCell(x, y, z);
+							visitCell(m_cells, true, key, proxy, pairs);
+							visitCell(m_moved_cells, false, key, proxy, pairs);
+						}
+					}
+				}
+				for (unsigned int other : m_current_large)
+				{
+					if (other != proxy && (!m_moved_flag[other] || other > proxy) && overlaps(boxes[proxy], boxes[other]))
+						pairs.push_back(makePair(proxy, other));
+				}
+			}
+		});
+}
+
+
+BroadphaseBenchmark Broadphase::runBenchmark(unsigned int count, float moving_ratio, unsigned int frames)
+{
+	BroadphaseBenchmark result;
+	result.m_proxies = count;
+	result.m_moving = std::min((unsigned int)(count * std::max(moving_ratio, 0.0f)), count);
+	result.m_frames = frames;
+	result.m_threads = JobSystem::get()->getThreadCount();
+	if (!count || !frames)
+		return result;
+
+	auto random = [](unsigned int index, unsigned int value)
+	{
+		unsigned int hash = (index * 8 + value + 1) * 2654435761u;
+		hash ^= hash >> 15;
+		hash *= 2246822519u;
+		hash ^= hash >> 13;
+		return (hash & 0xffff) / 65535.0f;
+	};
+
+	// a box per 20 cubic units: a few neighbours each. The floor tiles cover a quarter each and stay where they are
+	Vector3D size(sqrtf((float)count) * 1.5f, 8.0f, sqrtf((float)count) * 1.5f);
+	std::vector<Vector3D> start_centers(count), halves(count), start_velocities(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (i < 4)
+		{
+			start_centers[i] = Vector3D(size.m_x * ((i & 1) * 0.5f + 0.25f), 0.0f, size.m_z * ((i >> 1) * 0.5f + 0.25f));
+			halves[i] = Vector3D(size.m_x * 0.25f, 0.25f, size.m_z * 0.25f);
+			start_velocities[i] = Vector3D(0.0f, 0.0f, 0.0f);
+			continue;
+		}
+		start_centers[i] = Vector3D(random(i, 0) * size.m_x, random(i, 1) * size.m_y, random(i, 2) * size.m_z);
+		halves[i] = Vector3D(0.25f + random(i, 3) * 0.5f, 0.25f + random(i, 4) * 0.5f, 0.25f + random(i, 5) * 0.5f);
+		start_velocities[i] = Vector3D(random(i, 6) - 0.5f, random(i, 7) - 0.5f, random(i + count, 0) - 0.5f) * 0.2f;
+	}
+
+	std::vector<BroadphasePair> found[2];
+	for (int method = 0; method < 2; method++)
+	{
+		std::vector<Vector3D> centers = start_centers;
+		std::vector<Vector3D> velocities = start_velocities;
+		auto move = [&](Broadphase& broadphase, unsigned int first)
+		{
+			for (unsigned int i = first; i < count; i++)
+			{
+				Vector3D& center = centers[i];
+				Vector3D& velocity = velocities[i];
+				center = center + velocity;
+				if (center.m_x < 0.0f || center.m_x > size.m_x) velocity.m_x = -velocity.m_x;
+				if (center.m_y < 0.0f || center.m_y > size.m_y) velocity.m_y = -velocity.m_y;
+				if (center.m_z < 0.0f || center.m_z > size.m_z) velocity.m_z = -velocity.m_z;
+				broadphase.update(i, center - halves[i], center + halves[i]);
+			}
+		};
+		auto milliseconds = [](std::chrono::high_resolution_clock::time_point begin)
+		{
+			return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+		};
+
+		Broadphase broadphase;
+		broadphase.setMethod((BroadphaseMethod)method);
+		for (unsigned int i = 0; i < count; i++)
+			broadphase.add(centers[i] - halves[i], centers[i] + halves[i]);
+		auto start = std::chrono::high_resolution_clock::now();
+		broadphase.findPairs();
+		result.m_add_ms[method] = milliseconds(start);
+
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			move(broadphase, 0);
+			start = std::chrono::high_resolution_clock::now();
+			broadphase.findPairs();
+			result.m_full_ms[method] += milliseconds(start) / frames;
+		}
+
+		// the last ones move, the slabs at the start stay
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			move(broadphase, count - result.m_moving);
+			start = std::chrono::high_resolution_clock::now();
+			broadphase.findPairs();
+			result.m_incremental_ms[method] += milliseconds(start) / frames;
+		}
+
+		found[method] = broadphase.getPairs();
+		std::sort(found[method].begin(), found[method].end(), [](const BroadphasePair& a, const BroadphasePair& b) { return a.m_a < b.m_a || (a.m_a == b.m_a && a.m_b < b.m_b); });
+	}
+
+	result.m_pairs = (unsigned int)found[0].size();
+	result.m_match = found[0].size() == found[1].size() &&
+		std::equal(found[0].begin(), found[0].end(), found[1].begin(), [](const BroadphasePair& a, const BroadphasePair& b) { return a.m_a == b.m_a && a.m_b == b.m_b; });
+	return result;
+}
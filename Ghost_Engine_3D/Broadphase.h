@@ -0,0 +1,171 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Vector3D.h"
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+// two proxies whose boxes overlap, m_a < m_b
+struct BroadphasePair
+{
+	unsigned int m_a;
+	unsigned int m_b;
+};
+
+enum class BroadphaseMethod
+{
+	SortAndSweep,
+	SpatialHash
+};
+
+// Broadphase::runBenchmark, times indexed by BroadphaseMethod
+struct BroadphaseBenchmark
+{
+	unsigned int m_proxies = 0;
+	unsigned int m_moving = 0;					// per frame of the incremental test
+	unsigned int m_frames = 0;
+	unsigned int m_pairs = 0;
+	double m_add_ms[2] = {};					// the first findPairs() after adding every proxy
+	double m_full_ms[2] = {};					// every proxy moving, per frame
+	double m_incremental_ms[2] = {};			// m_moving proxies moving, per frame
+	bool m_match = false;						// both methods found the same pairs
+	unsigned int m_threads = 0;
+};
+
+
+/*
+	Broadphase: the pairs of overlapping boxes among many moving proxies, the input of a narrow phase
+
+	- sort and sweep: the proxies sorted by the min of their box on the axis where the centers spread most. A proxy
+	  only tests the ones after it that start before it ends on that axis. Proxies over LARGE_WIDTH times the mean
+	  width are kept apart, so one floor does not make every moved proxy scan back over the whole axis
+	- spatial hash: every proxy in the cells of a uniform grid it touches, sorted by cell. Proxies test the others of
+	  their cells, a pair is reported in the cell of the min corner of its overlap only -> no duplicates without a set.
+	  Proxies over MAX_PROXY_CELLS cells (a floor, a terrain) test every proxy instead
+	- incremental: findPairs() keeps the pairs of the proxies that did not move and tests the moved ones only. Sort and
+	  sweep repairs its order with an insertion sort, the hash adds the moved proxies to a small second grid. More than
+	  a quarter moved (or an eighth since the last full pass for the hash) -> everything is tested again
+	- the tests run in chunks on the JobSystem, the pairs of a chunk are appended in chunk order -> the result does not
+	  depend on the thread count
+	- proxy ids stay valid until remove(), removed ids are reused by add()
+*/
+
+class Broadphase
+{
+public:
+
+	static const unsigned int MAX_PROXY_CELLS = 64;
+	static constexpr float LARGE_WIDTH = 16.0f;
+
+	unsigned int add(const Vector3D& min, const Vector3D& max);
+	void remove(unsigned int proxy);
+	// the new box of a proxy, only moved proxies are tested again
+	void update(unsigned int proxy, const Vector3D& min, const Vector3D& max);
+	void clear();
+
+	// the next findPairs() is a full pass
+	void setMethod(BroadphaseMethod method);
+	BroadphaseMethod getMethod() const;
+	// edge of a hash cell, 0 -> twice the mean box size at every full pass
+	void setCellSize(float size);
+	float getCellSize() const;
+
+	void findPairs();
+	const std::vector<BroadphasePair>& getPairs() const;
+	// the last findPairs() only tested the moved proxies
+	bool wasIncremental() const;
+	unsigned int getProxyCount() const;
+
+	/*
+		count boxes of 0.5 to 1.5 units flying and bouncing in a flat level 8 units high, four floor tiles under it.
+		frames of every proxy moving, then frames of moving_ratio of them moving, for both methods
+	*/
+	static BroadphaseBenchmark runBenchmark(unsigned int count, float moving_ratio, unsigned int frames);
+
+private:
+
+	struct Box
+	{
+		float m_min[3];
+		float m_max[3];
+	};
+
+	struct CellEntry
+	{
+		uint64_t m_key;
+		unsigned int m_proxy;
+	};
+
+	void sweepAll();
+	void sweepMoved();
+	void hashAll();
+	void hashMoved();
+
+	// cell range of a box and its number of cells, 0 when it covers more than MAX_PROXY_CELLS
+	unsigned int getCells(const Box& box, int low[3], int high[3]) const;
+	uint64_t getOwnerCell(const Box& a, const Box& b) const;
+	void addCells(unsigned int proxy, CellEntry* entries) const;
+
+private:
+
+	std::vector<Box> m_boxes;				// by proxy id, removed ones empty (min > max) so they overlap nothing
+	std::vector<char> m_alive;
+	std::vector<unsigned int> m_free;
+	unsigned int m_proxy_count = 0;
+
+	std::vector<unsigned int> m_moved;		// since the last findPairs(), each once
+	std::vector<char> m_moved_flag;
+	bool m_full = true;
+	bool m_incremental = false;
+	BroadphaseMethod m_method = BroadphaseMethod::SortAndSweep;
+
+	// sort and sweep: every proxy id in the order of the boxes on m_axis, the boxes copied in that order
+	unsigned int m_axis = 0;
+	std::vector<unsigned int> m_order;
+	std::vector<unsigned int> m_position;	// of a proxy in m_order
+	std::vector<Box> m_sorted;
+	float m_max_width = 0.0f;				// widest box on m_axis that is not large: how far a backwards scan has to look
+	float m_large_width = FLT_MAX;
+
+	// spatial hash: the grid of the last full pass, the proxies moved since then in a second one
+	float m_cell_size = 0.0f;
+	float m_used_cell_size = 1.0f;
+	std::vector<CellEntry> m_cells;
+	std::vector<unsigned int> m_cell_offsets;	// first entry of a proxy in m_cells while it is filled
+	std::vector<unsigned int> m_runs;			// first entry of every cell with more than one proxy
+	std::vector<CellEntry> m_moved_cells;
+	std::vector<char> m_stale;				// moved since the last full pass, its entries in m_cells are old
+	std::vector<unsigned int> m_stale_list;
+	// sort and sweep: over m_large_width. Hash: over MAX_PROXY_CELLS, not in the grid
+	std::vector<char> m_large_flag;
+	std::vector<unsigned int> m_large;		// of the last full pass for the hash
+	std::vector<unsigned int> m_current_large;
+
+	std::vector<BroadphasePair> m_pairs;
+	std::vector<std::vector<BroadphasePair>> m_chunk_pairs;
+};
@@ -0,0 +1,565 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "CollisionMesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+static Vector3D minVector(const Vector3D& a, const Vector3D& b)
+{
+	return Vector3D(std::min(a.m_x, b.m_x), std::min(a.m_y, b.m_y), std::min(a.m_z, b.m_z));
+}
+
+static Vector3D maxVector(const Vector3D& a, const Vector3D& b)
+{
+	return Vector3D(std::max(a.m_x, b.m_x), std::max(a.m_y, b.m_y), std::max(a.m_z, b.m_z));
+}
+
+static Vector3D normalize(const Vector3D& vector)
+{
+	float length = vector.length();
+	return length > 1e-20f ? vector * (1.0f / length) : Vector3D(0.0f, 1.0f, 0.0f);
+}
+
+
+// smallest root of a t^2 + b t + c = 0 in [0, max_t)
+static bool solveQuadratic(float a, float b, float c, float max_t, float& t)
+{
+	if (fabsf(a) < 1e-20f)
+		return false;
+	float discriminant = b * b - 4.0f * a * c;
+	if (discriminant < 0.0f)
+		return false;
+
+	float root = (-b - sqrtf(discriminant)) / (2.0f * a);
+	if (root < 0.0f || root >= max_t)
+		return false;
+	t = root;
+	return true;
+}
+
+
+/*
+	sphere start + delta * t of radius against one triangle, contacts before max_t
+	- face: the plane distance shrinks to radius while the touching point is inside the triangle. When the sphere only
+	  reaches the plane at or after max_t, no edge or corner can be touched earlier either
+	- edge: distance of the center to the line of the edge reaches radius with the closest point on the edge
+	- corner: distance of the center to the corner reaches radius
+	- overlaps at t = 0 are skipped
+*/
+
+static bool sweepTriangle(const Vector3D& start, const Vector3D& delta, float radius, const Vector3D* triangle, float max_t, CollisionHit& hit)
+{
+	const Vector3D& a = triangle[0];
+	const Vector3D& b = triangle[1];
+	const Vector3D& c = triangle[2];
+
+	Vector3D face = Vector3D::cross(b - a, c - a);
+	float area = face.length();
+	if (area < 1e-20f)
+		return false;
+	Vector3D normal = face * (1.0f / area);
+
+	float distance = Vector3D::dot(normal, start - a);
+	Vector3D side = distance < 0.0f ? normal * -1.0f : normal;
+	distance = fabsf(distance);
+	float approach = Vector3D::dot(side, delta);
+
+	// never closer to the plane than radius
+	if (distance >= radius && approach >= 0.0f)
+		return false;
+
+	if (distance >= radius)
+	{
+		float t = (distance - radius) / -approach;
+		if (t >= max_t)
+			return false;
+
+		Vector3D point = start + delta * t - side * radius;
+		if (Vector3D::dot(Vector3D::cross(b - a, point - a), normal) >= 0.0f &&
+			Vector3D::dot(Vector3D::cross(c - b, point - b), normal) >= 0.0f &&
+			Vector3D::dot(Vector3D::cross(a - c, point - c), normal) >= 0.0f)
+		{
+			hit.m_t = t;
+			hit.m_normal = side;
+			hit.m_point = point;
+			return true;
+		}
+	}
+
+	bool found = false;
+	float best = max_t;
+	float radius2 = radius * radius;
+	float delta2 = Vector3D::dot(delta, delta);
+
+	for (int i = 0; i < 3; i++)
+	{
+		const Vector3D& corner = triangle[i];
+		Vector3D offset = start - corner;
+		float t = 0.0f;
+		float c2 = Vector3D::dot(offset, offset) - radius2;
+		if (c2 > 0.0f && solveQuadratic(delta2, 2.0f * Vector3D::dot(delta, offset), c2, best, t))
+		{
+			best = t;
+			found = true;
+			hit.m_point = corner;
+		}
+
+		const Vector3D& end = triangle[(i + 1) % 3];
+		Vector3D edge = end - corner;
+		float edge2 = Vector3D::dot(edge, edge);
+		float edge_delta = Vector3D::dot(edge, delta);
+		float edge_offset = Vector3D::dot(edge, offset);
+
+		float qa = edge2 * delta2 - edge_delta * edge_delta;
+		float qb = 2.0f * (edge2 * Vector3D::dot(offset, delta) - edge_offset * edge_delta);
+		float qc = edge2 * (Vector3D::dot(offset, offset) - radius2) - edge_offset * edge_offset;
+		if (qc > 0.0f && solveQuadratic(qa, qb, qc, best, t))
+		{
+			float along = (edge_offset + edge_delta * t) / edge2;
+			if (along >= 0.0f && along <= 1.0f)
+			{
+				best = t;
+				found = true;
+				hit.m_point = corner + edge * along;
+			}
+		}
+	}
+
+	if (!found)
+		return false;
+
+	hit.m_t = best;
+	hit.m_normal = normalize(start + delta * best - hit.m_point);
+	return true;
+}
+
+
+// Ericson, Real-Time Collision Detection 5.1.5: the regions of the corners, then the edges, then the face
+static Vector3D closestPointOnTriangle(const Vector3D& p, const Vector3D& a, const Vector3D& b, const Vector3D& c)
+{
+	Vector3D ab = b - a, ac = c - a, ap = p - a;
+	float d1 = Vector3D::dot(ab, ap), d2 = Vector3D::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return a;
+
+	Vector3D bp = p - b;
+	float d3 = Vector3D::dot(ab, bp), d4 = Vector3D::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+		return b;
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return a + ab * (d1 / (d1 - d3));
+
+	Vector3D cp = p - c;
+	float d5 = Vector3D::dot(ab, cp), d6 = Vector3D::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+		return c;
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return a + ac * (d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float denominator = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
+
+static float clampUnit(float value)
+{
+	return std::min(std::max(value, 0.0f), 1.0f);
+}
+
+
+// Ericson, Real-Time Collision Detection 5.1.9: closest points of the segments p1 + d1 s and p2 + d2 t, s and t in [0, 1]
+static void closestPointsOfSegments(const Vector3D& p1, const Vector3D& d1, const Vector3D& p2, const Vector3D& d2, Vector3D& c1, Vector3D& c2)
+{
+	Vector3D r = p1 - p2;
+	float a = Vector3D::dot(d1, d1), e = Vector3D::dot(d2, d2), f = Vector3D::dot(d2, r);
+	float s = 0.0f, t = 0.0f;
+
+	if (a <= 1e-20f && e > 1e-20f)
+	{
+		t = clampUnit(f / e);
+	}
+	else if (a > 1e-20f)
+	{
+		float c = Vector3D::dot(d1, r);
+		if (e <= 1e-20f)
+		{
+			s = clampUnit(-c / a);
+		}
+		else
+		{
+			float b = Vector3D::dot(d1, d2);
+			float denominator = a * e - b * b;
+			s = denominator > 0.0f ? clampUnit((b * f - c * e) / denominator) : 0.0f;
+			t = (b * s + f) / e;
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = clampUnit(-c / a);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = clampUnit((b - c) / a);
+			}
+		}
+	}
+
+	c1 = p1 + d1 * s;
+	c2 = p2 + d2 * t;
+}
+
+
+/*
+	closest points of the segment bottom + segment * s and a triangle, returns their distance
+	- a segment through the triangle: distance 0 at the crossing
+	- otherwise one of them is on the boundary of the other: an end of the segment against the triangle or the
+	  segment against an edge
+*/
+static float closestSegmentTriangle(const Vector3D& bottom, const Vector3D& segment, const Vector3D* triangle, Vector3D& on_segment, Vector3D& on_triangle)
+{
+	const Vector3D& a = triangle[0];
+	const Vector3D& b = triangle[1];
+	const Vector3D& c = triangle[2];
+
+	Vector3D normal = Vector3D::cross(b - a, c - a);
+	float start = Vector3D::dot(normal, bottom - a);
+	float end = Vector3D::dot(normal, bottom + segment - a);
+	if ((start < 0.0f) != (end < 0.0f) && start != end)
+	{
+		Vector3D point = bottom + segment * (start / (start - end));
+		if (Vector3D::dot(Vector3D::cross(b - a, point - a), normal) >= 0.0f &&
+			Vector3D::dot(Vector3D::cross(c - b, point - b), normal) >= 0.0f &&
+			Vector3D::dot(Vector3D::cross(a - c, point - c), normal) >= 0.0f)
+		{
+			on_segment = on_triangle = point;
+			return 0.0f;
+		}
+	}
+
+	float best = FLT_MAX;
+	for (int i = 0; i < 2; i++)
+	{
+		Vector3D p = bottom + segment * (float)i;
+		Vector3D closest = closestPointOnTriangle(p, a, b, c);
+		float distance = (p - closest).length();
+		if (distance < best)
+		{
+			best = distance;
+			on_segment = p;
+			on_triangle = closest;
+		}
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		Vector3D p, q;
+		closestPointsOfSegments(bottom, segment, triangle[i], triangle[(i + 1) % 3] - triangle[i], p, q);
+		float distance = (p - q).length();
+		if (distance < best)
+		{
+			best = distance;
+			on_segment = p;
+			on_triangle = q;
+		}
+	}
+	return best;
+}
+
+
+/*
+	capsule (segment start - axis to start + axis, radius around it) moving by delta * t against one triangle
+	- the spheres at both ends: sweepTriangle, the face, edges and corners of the triangle
+	- the side against an edge: the distance of the two lines changes linearly with t, it counts when the closest
+	  points are inside both segments
+	- the side against a corner: the distance of the corner to the line of the segment reaches radius inside the segment
+	- the side against the face needs no test of its own: it touches an edge or an end sphere touches the face first
+	- overlaps at t = 0 are skipped like for the sphere
+*/
+
+static bool sweepCapsuleTriangle(const Vector3D& start, const Vector3D& axis, const Vector3D& delta, float radius, const Vector3D* triangle, float max_t, CollisionHit& hit)
+{
+	bool found = false;
+	for (int end = -1; end <= 1; end += 2)
+	{
+		CollisionHit local;
+		if (sweepTriangle(start + axis * (float)end, delta, radius, triangle, max_t, local))
+		{
+			hit = local;
+			max_t = local.m_t;
+			found = true;
+		}
+	}
+
+	Vector3D bottom = start - axis;
+	Vector3D segment = axis * 2.0f;
+	float segment2 = Vector3D::dot(segment, segment);
+	if (segment2 < 1e-20f)
+		return found;
+
+	float radius2 = radius * radius;
+	float delta2 = Vector3D::dot(delta, delta);
+
+	for (int i = 0; i < 3; i++)
+	{
+		const Vector3D& corner = triangle[i];
+		Vector3D edge = triangle[(i + 1) % 3] - corner;
+		float edge2 = Vector3D::dot(edge, edge);
+
+		// side against the edge. Parallel lines touch first at an end sphere or a corner
+		Vector3D cross = Vector3D::cross(segment, edge);
+		float cross_length = cross.length();
+		if (cross_length > 1e-6f * sqrtf(segment2 * edge2))
+		{
+			Vector3D side = cross * (1.0f / cross_length);
+			float distance = Vector3D::dot(side, bottom - corner);
+			if (distance < 0.0f)
+			{
+				side = side * -1.0f;
+				distance = -distance;
+			}
+			float approach = Vector3D::dot(side, delta);
+
+			if (distance > radius && approach < 0.0f)
+			{
+				float t = (distance - radius) / -approach;
+				if (t < max_t)
+				{
+					Vector3D offset = bottom + delta * t - corner;
+					float b = Vector3D::dot(segment, edge);
+					float c = Vector3D::dot(segment, offset);
+					float f = Vector3D::dot(edge, offset);
+					float s = (b * f - c * edge2) / (segment2 * edge2 - b * b);
+					float w = (b * s + f) / edge2;
+					if (s >= 0.0f && s <= 1.0f && w >= 0.0f && w <= 1.0f)
+					{
+						max_t = t;
+						found = true;
+						hit.m_t = t;
+						hit.m_normal = side;
+						hit.m_point = corner + edge * w;
+					}
+				}
+			}
+		}
+
+		// side against the corner: the corner moves by -delta against the segment
+		Vector3D offset = corner - bottom;
+		float segment_delta = -Vector3D::dot(segment, delta);
+		float segment_offset = Vector3D::dot(segment, offset);
+		float qa = segment2 * delta2 - segment_delta * segment_delta;
+		float qb = 2.0f * (segment2 * -Vector3D::dot(offset, delta) - segment_offset * segment_delta);
+		float qc = segment2 * (Vector3D::dot(offset, offset) - radius2) - segment_offset * segment_offset;
+		float t = 0.0f;
+		if (qc > 0.0f && solveQuadratic(qa, qb, qc, max_t, t))
+		{
+			float along = (segment_offset + segment_delta * t) / segment2;
+			if (along >= 0.0f && along <= 1.0f)
+			{
+				max_t = t;
+				found = true;
+				hit.m_t = t;
+				hit.m_point = corner;
+				hit.m_normal = normalize(bottom + delta * t + segment * along - corner);
+			}
+		}
+	}
+	return found;
+}
+
+
+void CollisionMesh::build(const std::vector<Vector3D>& positions, const unsigned int* indices, unsigned int index_count)
+{
+	unsigned int triangles = index_count / 3;
+	std::vector<Vector3D> min(triangles), max(triangles);
+	m_min = Vector3D(FLT_MAX, FLT_MAX, FLT_MAX);
+	m_max = Vector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (unsigned int i = 0; i < triangles; i++)
+	{
+		const Vector3D& a = positions[indices[i * 3]];
+		const Vector3D& b = positions[indices[i * 3 + 1]];
+		const Vector3D& c = positions[indices[i * 3 + 2]];
+		min[i] = minVector(minVector(a, b), c);
+		max[i] = maxVector(maxVector(a, b), c);
+		m_min = minVector(m_min, min[i]);
+		m_max = maxVector(m_max, max[i]);
+	}
+	m_bvh.build(min, max);
+
+	// leaf order: item slot i of the BVH is triangle i of m_vertices
+	const std::vector<unsigned int>& items = m_bvh.getItems();
+	m_vertices.resize(items.size() * 3);
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		for (unsigned int corner = 0; corner < 3; corner++)
+			m_vertices[i * 3 + corner] = positions[indices[items[i] * 3 + corner]];
+	}
+	if (!triangles)
+		m_min = m_max = Vector3D();
+}
+
+
+bool CollisionMesh::sweepSphere(const Vector3D& start, const Vector3D& delta, float radius, CollisionHit& hit) const
+{
+	bool found = false;
+	float max_t = hit.m_t;
+	m_bvh.sweep(start, delta, radius, max_t, [&](unsigned int slot, float& nearest)
+		{
+			if (sweepTriangle(start, delta, radius, &m_vertices[slot * 3], nearest, hit))
+			{
+				nearest = hit.m_t;
+				found = true;
+			}
+		});
+	return found;
+}
+
+
+bool CollisionMesh::sweepSphereBruteForce(const Vector3D& start, const Vector3D& delta, float radius, CollisionHit& hit) const
+{
+	bool found = false;
+	float max_t = hit.m_t;
+	for (size_t i = 0; i < m_vertices.size(); i += 3)
+	{
+		if (sweepTriangle(start, delta, radius, &m_vertices[i], max_t, hit))
+		{
+			max_t = hit.m_t;
+			found = true;
+		}
+	}
+	return found;
+}
+
+
+bool CollisionMesh::sweepCapsule(const Vector3D& start, const Vector3D& axis, const Vector3D& delta, float radius, CollisionHit& hit) const
+{
+	bool found = false;
+	float max_t = hit.m_t;
+	m_bvh.sweep(start, delta, radius + axis.length(), max_t, [&](unsigned int slot, float& nearest)
+		{
+			if (sweepCapsuleTriangle(start, axis, delta, radius, &m_vertices[slot * 3], nearest, hit))
+			{
+				nearest = hit.m_t;
+				found = true;
+			}
+		});
+	return found;
+}
+
+
+bool CollisionMesh::findPenetration(const Vector3D& center, float radius, Vector3D& normal, float& depth) const
+{
+	bool found = false;
+	depth = 0.0f;
+	Vector3D extent(radius, radius, radius);
+	m_bvh.query(center - extent, center + extent, [&](unsigned int slot)
+		{
+			const Vector3D* triangle = &m_vertices[slot * 3];
+			Vector3D closest = closestPointOnTriangle(center, triangle[0], triangle[1], triangle[2]);
+			Vector3D offset = center - closest;
+			float distance = offset.length();
+			if (distance >= radius || radius - distance <= depth)
+				return;
+
+			// the center on the surface: out along the face normal
+			if (distance > 1e-6f)
+				normal = offset * (1.0f / distance);
+			else
+				normal = normalize(Vector3D::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]));
+			depth = radius - distance;
+			found = true;
+		});
+	return found;
+}
+
+
+bool CollisionMesh::findPenetration(const Vector3D& center, const Vector3D& axis, float radius, Vector3D& normal, float& depth) const
+{
+	bool found = false;
+	depth = 0.0f;
+	Vector3D bottom = center - axis;
+	Vector3D segment = axis * 2.0f;
+	Vector3D extent = maxVector(axis, axis * -1.0f) + Vector3D(radius, radius, radius);
+	m_bvh.query(center - extent, center + extent, [&](unsigned int slot)
+		{
+			const Vector3D* triangle = &m_vertices[slot * 3];
+			Vector3D on_segment, on_triangle;
+			float distance = closestSegmentTriangle(bottom, segment, triangle, on_segment, on_triangle);
+			if (distance >= radius || radius - distance <= depth)
+				return;
+
+			// the segment through the surface: out along the face normal, to the side of the center
+			if (distance > 1e-6f)
+			{
+				normal = (on_segment - on_triangle) * (1.0f / distance);
+			}
+			else
+			{
+				normal = normalize(Vector3D::cross(triangle[1] - triangle[0], triangle[2] - triangle[0]));
+				if (Vector3D::dot(normal, center - triangle[0]) < 0.0f)
+					normal = normal * -1.0f;
+			}
+			depth = radius - distance;
+			found = true;
+		});
+	return found;
+}
+
+
+unsigned int CollisionMesh::getTriangleCount() const
+{
+	return (unsigned int)(m_vertices.size() / 3);
+}
+
+
+const Vector3D* CollisionMesh::getTriangle(unsigned int slot) const
+{
+	return m_vertices.data() + (size_t)slot * 3;
+}
+
+
+const BVH& CollisionMesh::getBVH() const
+{
+	return m_bvh;
+}
+
+
+void CollisionMesh::getBoundingBox(Vector3D& min, Vector3D& max) const
+{
+	min = m_min;
+	max = m_max;
+}
@@ -0,0 +1,93 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "BVH.h"
+#include "Vector3D.h"
+#include <vector>
+
+// first contact of a sweep
+struct CollisionHit
+{
+	float m_t = 1.0f;			// fraction of the movement until the contact
+	Vector3D m_normal;			// unit length, from the surface toward the moving shape
+	Vector3D m_point;			// contact point on the surface
+};
+
+
+/*
+	CollisionMesh: static triangle mesh for swept sphere queries, accelerated by a BVH over the triangles
+
+	- triangles are two sided: a sphere is pushed to the side its center is on. Meshes with open or mixed windings
+	  (most imported models) collide like closed ones
+	- sweeps are exact: the face, then the three edges (cylinders) and corners (spheres) of each triangle. Triangles the
+	  sphere already overlaps at the start are ignored, so it can always move out of them -> call pushOut() before
+	  sweeping when the start may overlap
+	- the triangles are stored in the order of the BVH leaves: a leaf reads consecutive memory
+	- const methods only read -> any number of threads can query one mesh
+*/
+
+class CollisionMesh
+{
+public:
+
+	// the triangles of index_count indices into positions
+	void build(const std::vector<Vector3D>& positions, const unsigned int* indices, unsigned int index_count);
+
+	/*
+		first contact of a sphere moving from start to start + delta. Only contacts before hit.m_t count (1 for a new
+		CollisionHit) -> several sweeps into one hit keep the nearest. False when nothing nearer was hit
+	*/
+	bool sweepSphere(const Vector3D& start, const Vector3D& delta, float radius, CollisionHit& hit) const;
+	// the same without the BVH: every triangle, for the benchmark
+	bool sweepSphereBruteForce(const Vector3D& start, const Vector3D& delta, float radius, CollisionHit& hit) const;
+	/*
+		the same for a capsule: radius around the segment from start - axis to start + axis. Exact as well: the spheres
+		at the ends against the triangles, the side against their edges and corners
+	*/
+	bool sweepCapsule(const Vector3D& start, const Vector3D& axis, const Vector3D& delta, float radius, CollisionHit& hit) const;
+
+	/*
+		the deepest overlap of a sphere: the direction out of the surface (normal) and how far (depth).
+		False when the sphere touches nothing
+	*/
+	bool findPenetration(const Vector3D& center, float radius, Vector3D& normal, float& depth) const;
+	// the same for a capsule, the segment from center - axis to center + axis
+	bool findPenetration(const Vector3D& center, const Vector3D& axis, float radius, Vector3D& normal, float& depth) const;
+
+	unsigned int getTriangleCount() const;
+	// the triangle in a slot of the BVH leaves
+	const Vector3D* getTriangle(unsigned int slot) const;
+	const BVH& getBVH() const;
+	void getBoundingBox(Vector3D& min, Vector3D& max) const;
+
+private:
+
+	std::vector<Vector3D> m_vertices;	// 3 per triangle
+	BVH m_bvh;
+	Vector3D m_min;
+	Vector3D m_max;
+};
@@ -0,0 +1,361 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "CollisionWorld.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+
+static Vector3D transformPoint(const Matrix4x4& matrix, const Vector3D& p)
+{
+	return Vector3D(
+		p.m_x * matrix.m_mat[0][0] + p.m_y * matrix.m_mat[1][0] + p.m_z * matrix.m_mat[2][0] + matrix.m_mat[3][0],
+		p.m_x * matrix.m_mat[0][1] + p.m_y * matrix.m_mat[1][1] + p.m_z * matrix.m_mat[2][1] + matrix.m_mat[3][1],
+		p.m_x * matrix.m_mat[0][2] + p.m_y * matrix.m_mat[1][2] + p.m_z * matrix.m_mat[2][2] + matrix.m_mat[3][2]);
+}
+
+static Vector3D transformVector(const Matrix4x4& matrix, const Vector3D& v)
+{
+	return Vector3D(
+		v.m_x * matrix.m_mat[0][0] + v.m_y * matrix.m_mat[1][0] + v.m_z * matrix.m_mat[2][0],
+		v.m_x * matrix.m_mat[0][1] + v.m_y * matrix.m_mat[1][1] + v.m_z * matrix.m_mat[2][1],
+		v.m_x * matrix.m_mat[0][2] + v.m_y * matrix.m_mat[1][2] + v.m_z * matrix.m_mat[2][2]);
+}
+
+// with the inverse transpose of the world matrix: a normal stays perpendicular to its surface, renormalized after
+static Vector3D transformNormal(const Matrix4x4& inverse, const Vector3D& n)
+{
+	Vector3D normal(
+		n.m_x * inverse.m_mat[0][0] + n.m_y * inverse.m_mat[0][1] + n.m_z * inverse.m_mat[0][2],
+		n.m_x * inverse.m_mat[1][0] + n.m_y * inverse.m_mat[1][1] + n.m_z * inverse.m_mat[1][2],
+		n.m_x * inverse.m_mat[2][0] + n.m_y * inverse.m_mat[2][1] + n.m_z * inverse.m_mat[2][2]);
+	float length = normal.length();
+	return length > 1e-20f ? normal * (1.0f / length) : n;
+}
+
+
+void CollisionWorld::add(const CollisionMesh* mesh, const Matrix4x4& world)
+{
+	Instance instance;
+	instance.m_mesh = mesh;
+	instance.m_world = world;
+	instance.m_inverse = world;
+	instance.m_inverse.inverse();
+	m_instances.push_back(instance);
+}
+
+
+void CollisionWorld::clear()
+{
+	m_instances.clear();
+	m_broadphase.clear();
+}
+
+
+// world box of an instance: the 8 corners of its mesh box
+void CollisionWorld::build()
+{
+	std::vector<Vector3D> min(m_instances.size()), max(m_instances.size());
+	for (size_t i = 0; i < m_instances.size(); i++)
+	{
+		Vector3D box_min, box_max;
+		m_instances[i].m_mesh->getBoundingBox(box_min, box_max);
+		min[i] = Vector3D(FLT_MAX, FLT_MAX, FLT_MAX);
+		max[i] = Vector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+		for (unsigned int corner = 0; corner < 8; corner++)
+		{
+			Vector3D p = transformPoint(m_instances[i].m_world, Vector3D(corner & 1 ? box_max.m_x : box_min.m_x,
+				corner & 2 ? box_max.m_y : box_min.m_y, corner & 4 ? box_max.m_z : box_min.m_z));
+			min[i] = Vector3D(std::min(min[i].m_x, p.m_x), std::min(min[i].m_y, p.m_y), std::min(min[i].m_z, p.m_z));
+			max[i] = Vector3D(std::max(max[i].m_x, p.m_x), std::max(max[i].m_y, p.m_y), std::max(max[i].m_z, p.m_z));
+		}
+	}
+	m_broadphase.build(min, max);
+
+	// slot order, like the triangles of a CollisionMesh
+	std::vector<Instance> ordered;
+	ordered.reserve(m_instances.size());
+	for (unsigned int item : m_broadphase.getItems())
+		ordered.push_back(m_instances[item]);
+	m_instances.swap(ordered);
+}
+
+
+unsigned int CollisionWorld::getInstanceCount() const
+{
+	return (unsigned int)m_instances.size();
+}
+
+
+/*
+	the broadphase sweeps the sphere around the whole capsule, each instance it reaches gets the capsule in its own
+	space. hit.m_t shrinks with every contact, so later instances only look for nearer ones
+*/
+
+bool CollisionWorld::sweep(const Vector3D& start, const Vector3D& delta, float radius, float half_height, CollisionHit& hit) const
+{
+	bool found = false;
+	float max_t = hit.m_t;
+
+	m_broadphase.sweep(start, delta, radius + half_height, max_t, [&](unsigned int slot, float& nearest)
+		{
+			const Instance& instance = m_instances[slot];
+			Vector3D local_start = transformPoint(instance.m_inverse, start);
+			Vector3D local_delta = transformVector(instance.m_inverse, delta);
+
+			CollisionHit local;
+			local.m_t = nearest;
+			bool contact = half_height > 0.0f ?
+				instance.m_mesh->sweepCapsule(local_start, transformVector(instance.m_inverse, Vector3D(0.0f, half_height, 0.0f)), local_delta, radius, local) :
+				instance.m_mesh->sweepSphere(local_start, local_delta, radius, local);
+			if (contact)
+			{
+				hit.m_t = local.m_t;
+				hit.m_normal = transformNormal(instance.m_inverse, local.m_normal);
+				hit.m_point = transformPoint(instance.m_world, local.m_point);
+				nearest = local.m_t;
+				found = true;
+			}
+		});
+	return found;
+}
+
+
+bool CollisionWorld::sweepSphere(const Vector3D& start, const Vector3D& delta, float radius, CollisionHit& hit) const
+{
+	return sweep(start, delta, radius, 0.0f, hit);
+}
+
+
+bool CollisionWorld::sweepCapsule(const Vector3D& start, const Vector3D& delta, float radius, float half_height, CollisionHit& hit) const
+{
+	return sweep(start, delta, radius, half_height, hit);
+}
+
+
+bool CollisionWorld::findPenetration(const Vector3D& center, float radius, float half_height, Vector3D& normal, float& depth) const
+{
+	bool found = false;
+	depth = 0.0f;
+	Vector3D extent(radius, radius + half_height, radius);
+
+	m_broadphase.query(center - extent, center + extent, [&](unsigned int slot)
+		{
+			const Instance& instance = m_instances[slot];
+			Vector3D local_center = transformPoint(instance.m_inverse, center);
+
+			Vector3D local_normal;
+			float local_depth = 0.0f;
+			bool overlap = half_height > 0.0f ?
+				instance.m_mesh->findPenetration(local_center, transformVector(instance.m_inverse, Vector3D(0.0f, half_height, 0.0f)), radius, local_normal, local_depth) :
+				instance.m_mesh->findPenetration(local_center, radius, local_normal, local_depth);
+			if (overlap && local_depth > depth)
+			{
+				normal = transformNormal(instance.m_inverse, local_normal);
+				depth = local_depth;
+				found = true;
+			}
+		});
+	return found;
+}
+
+
+// the deepest overlap first, a few rounds for a shape wedged between surfaces
+Vector3D CollisionWorld::pushOut(const Vector3D& center, float radius, float half_height) const
+{
+	Vector3D position = center;
+	for (unsigned int round = 0; round < MAX_SLIDES; round++)
+	{
+		Vector3D normal;
+		float depth = 0.0f;
+		if (!findPenetration(position, radius, half_height, normal, depth))
+			break;
+		position = position + normal * (depth + SKIN);
+	}
+	return position;
+}
+
+
+Vector3D CollisionWorld::move(const Vector3D& start, const Vector3D& delta, float radius, float half_height) const
+{
+	if (m_instances.empty())
+		return start + delta;
+
+	Vector3D position = pushOut(start, radius, half_height);
+	Vector3D remaining = delta;
+	for (unsigned int slide = 0; slide < MAX_SLIDES; slide++)
+	{
+		float length = remaining.length();
+		if (length < 1e-6f)
+			break;
+
+		CollisionHit hit;
+		if (!sweep(position, remaining, radius, half_height, hit))
+		{
+			position = position + remaining;
+			break;
+		}
+
+		// up to the skin before the contact, the rest without the part into the surface
+		float travel = std::max(hit.m_t * length - SKIN, 0.0f);
+		position = position + remaining * (travel / length);
+		remaining = remaining * (1.0f - hit.m_t);
+		remaining = remaining - hit.m_normal * Vector3D::dot(remaining, hit.m_normal);
+	}
+	return pushOut(position, radius, half_height);
+}
+
+
+Vector3D CollisionWorld::moveSphere(const Vector3D& start, const Vector3D& delta, float radius) const
+{
+	return move(start, delta, radius, 0.0f);
+}
+
+
+Vector3D CollisionWorld::moveCapsule(const Vector3D& start, const Vector3D& delta, float radius, float half_height) const
+{
+	return move(start, delta, radius, half_height);
+}
+
+
+CollisionBenchmark CollisionWorld::runBenchmark(const std::vector<Vector3D>& positions, const unsigned int* indices, unsigned int index_count, unsigned int sweeps)
+{
+	CollisionBenchmark result;
+	result.m_sweeps = sweeps;
+	result.m_threads = JobSystem::get()->getThreadCount();
+
+	CollisionMesh mesh;
+	auto start = std::chrono::high_resolution_clock::now();
+	mesh.build(positions, indices, index_count);
+	result.m_build_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	result.m_triangles = mesh.getTriangleCount();
+	result.m_bvh_nodes = (unsigned int)mesh.getBVH().getNodes().size();
+	if (!result.m_triangles || !sweeps)
+		return result;
+
+	Vector3D box_min, box_max;
+	mesh.getBoundingBox(box_min, box_max);
+	Vector3D size = box_max - box_min;
+	float extent = std::max(std::max(size.m_x, size.m_z), 0.0001f);
+	float spacing = extent * 1.5f;
+
+	CollisionWorld world;
+	for (int z = 0; z < 16; z++)
+	{
+		for (int x = 0; x < 16; x++)
+		{
+			Matrix4x4 transform;
+			transform.setIdentity();
+			transform.setTranslation(Vector3D((x - 7.5f) * spacing, 0.0f, (z + 1) * spacing));
+			world.add(&mesh, transform);
+		}
+	}
+	start = std::chrono::high_resolution_clock::now();
+	world.build();
+	result.m_broadphase_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	result.m_instances = world.getInstanceCount();
+
+	auto random = [](unsigned int sweep, unsigned int value)
+	{
+		unsigned int hash = (sweep * 8 + value + 1) * 2654435761u;
+		hash ^= hash >> 15;
+		hash *= 2246822519u;
+		hash ^= hash >> 13;
+		return (hash & 0xffff) / 65535.0f;
+	};
+
+	std::vector<Vector3D> starts(sweeps), deltas(sweeps);
+	Vector3D area_min = box_min + Vector3D(-8.0f * spacing, 0.0f, 0.5f * spacing);
+	Vector3D area_size = Vector3D(16.0f * spacing, size.m_y, 16.0f * spacing);
+	for (unsigned int i = 0; i < sweeps; i++)
+	{
+		starts[i] = area_min + Vector3D(random(i, 0) * area_size.m_x, random(i, 1) * area_size.m_y, random(i, 2) * area_size.m_z);
+
+		float yaw = random(i, 3) * 6.2831853f;
+		float pitch = (random(i, 4) - 0.5f) * 1.5f;
+		deltas[i] = Vector3D(cosf(yaw) * cosf(pitch), sinf(pitch), sinf(yaw) * cosf(pitch)) * (extent * 0.5f);
+	}
+	float radius = extent * 0.05f;
+
+	auto seconds = [](std::chrono::high_resolution_clock::time_point begin)
+	{
+		return std::max(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - begin).count(), 1e-9);
+	};
+
+	unsigned int hits = 0;
+	start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < sweeps; i++)
+	{
+		CollisionHit hit;
+		hits += world.sweepSphere(starts[i], deltas[i], radius, hit) ? 1 : 0;
+	}
+	result.m_sphere_sweeps_per_second = sweeps / seconds(start);
+	result.m_hit_ratio = (double)hits / sweeps;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (unsigned int i = 0; i < sweeps; i++)
+	{
+		CollisionHit hit;
+		world.sweepCapsule(starts[i], deltas[i], radius, radius * 2.0f, hit);
+	}
+	result.m_capsule_sweeps_per_second = sweeps / seconds(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	std::atomic<unsigned int> mt_hits(0);
+	JobSystem::get()->parallelFor(sweeps, 256, [&](unsigned int begin, unsigned int end)
+		{
+			unsigned int local = 0;
+			for (unsigned int i = begin; i < end; i++)
+			{
+				CollisionHit hit;
+				local += world.sweepSphere(starts[i], deltas[i], radius, hit) ? 1 : 0;
+			}
+			mt_hits += local;
+		});
+	result.m_sphere_sweeps_per_second_mt = sweeps / seconds(start);
+
+	// every triangle of every instance: a sweep can take many milliseconds, measure for a quarter second at most
+	unsigned int brute_sweeps = 0;
+	start = std::chrono::high_resolution_clock::now();
+	while (brute_sweeps < sweeps && (brute_sweeps == 0 || seconds(start) < 0.25))
+	{
+		CollisionHit hit;
+		for (const Instance& instance : world.m_instances)
+		{
+			mesh.sweepSphereBruteForce(transformPoint(instance.m_inverse, starts[brute_sweeps]), transformVector(instance.m_inverse, deltas[brute_sweeps]),
+				radius, hit);
+		}
+		brute_sweeps++;
+	}
+	result.m_brute_force_sweeps_per_second = brute_sweeps / seconds(start);
+
+	return result;
+}
@@ -0,0 +1,110 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "CollisionMesh.h"
+#include "Matrix4x4.h"
+#include <vector>
+
+// CollisionWorld::runBenchmark
+struct CollisionBenchmark
+{
+	unsigned int m_instances = 0;
+	unsigned int m_triangles = 0;				// of one mesh
+	unsigned int m_bvh_nodes = 0;
+	double m_build_ms = 0.0;					// BVH of the mesh
+	double m_broadphase_ms = 0.0;				// BVH of the instances
+	unsigned int m_sweeps = 0;
+	double m_hit_ratio = 0.0;
+	double m_sphere_sweeps_per_second = 0.0;
+	double m_capsule_sweeps_per_second = 0.0;
+	double m_sphere_sweeps_per_second_mt = 0.0;	// on all threads of the JobSystem
+	double m_brute_force_sweeps_per_second = 0.0;	// every triangle of every instance, no broadphase or BVH
+	unsigned int m_threads = 0;
+};
+
+
+/*
+	CollisionWorld: instances of collision meshes and the queries a camera or a character moves with
+
+	- broadphase: a BVH over the world boxes of the instances. A sweep only visits the instances its path touches,
+	  then the BVH of their mesh
+	- world: rotation and translation. A scale would change the radius of the sphere in the space of the mesh
+	- capsule: vertical, its segment from center - half_height to center + half_height on the y axis. Swept exactly
+	  like the sphere: its end spheres against the triangles, its side against their edges and corners
+	- hit and push out normals go to the world with the inverse transpose of the instance matrix
+	- move: sweep, stop a skin width before the contact and slide the rest of the movement along the surface. A crease
+	  or corner takes a slide per face, MAX_SLIDES at most. Overlaps at the start and the end are pushed out
+	- build() after the last add(). Queries are const -> the game thread and the jobs of a benchmark share a world
+*/
+
+class CollisionWorld
+{
+public:
+
+	static const unsigned int MAX_SLIDES = 4;
+	static constexpr float SKIN = 0.001f;
+
+	// the mesh stays owned by the caller and must outlive the world
+	void add(const CollisionMesh* mesh, const Matrix4x4& world);
+	void clear();
+	void build();
+
+	bool sweepSphere(const Vector3D& start, const Vector3D& delta, float radius, CollisionHit& hit) const;
+	bool sweepCapsule(const Vector3D& start, const Vector3D& delta, float radius, float half_height, CollisionHit& hit) const;
+
+	// the position after moving by delta, sliding along what is in the way
+	Vector3D moveSphere(const Vector3D& start, const Vector3D& delta, float radius) const;
+	Vector3D moveCapsule(const Vector3D& start, const Vector3D& delta, float radius, float half_height) const;
+
+	unsigned int getInstanceCount() const;
+
+	/*
+		sweeps against a grid of 16 x 16 copies of a mesh, one and a half mesh sizes apart like the benchmark scene.
+		Random starts and directions over the grid (the same every run), each half a mesh size long, radius 1/20
+	*/
+	static CollisionBenchmark runBenchmark(const std::vector<Vector3D>& positions, const unsigned int* indices, unsigned int index_count, unsigned int sweeps);
+
+private:
+
+	// half_height 0 -> a sphere
+	bool sweep(const Vector3D& start, const Vector3D& delta, float radius, float half_height, CollisionHit& hit) const;
+	bool findPenetration(const Vector3D& center, float radius, float half_height, Vector3D& normal, float& depth) const;
+	Vector3D move(const Vector3D& start, const Vector3D& delta, float radius, float half_height) const;
+	Vector3D pushOut(const Vector3D& center, float radius, float half_height) const;
+
+private:
+
+	struct Instance
+	{
+		const CollisionMesh* m_mesh;
+		Matrix4x4 m_world;
+		Matrix4x4 m_inverse;
+	};
+
+	std::vector<Instance> m_instances;		// in the slot order of the broadphase after build()
+	BVH m_broadphase;
+};
@@ -0,0 +1,255 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "CommandList.h"
+#include "GraphicsEngine.h"
+#include "ConstantBuffer.h"
+
+#include <exception>
+
+/*
+	- ID3D11Device::CreateDeferredContext: a context that records instead of drawing. Each thread needs its own one,
+	  the immediate context stays on the render thread
+*/
+
+CommandList::CommandList(bool recorded)
+{
+	if (recorded)
+		return;
+
+	ID3D11DeviceContext* deferred = nullptr;
+	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateDeferredContext(0, &deferred)))
+	{
+		throw std::exception("Create Deferred Context was not successful");
+	}
+
+	m_context = new DeviceContext(deferred);
+}
+
+
+void CommandList::begin(SwapChain* swap_chain, UINT width, UINT height)
+{
+	reset();
+	record(CommandType::RenderTarget, swap_chain);
+	record(CommandType::Viewport, nullptr, nullptr, width, height);
+}
+
+void CommandList::begin(RenderTarget* color, RenderTarget* depth, UINT width, UINT height)
+{
+	reset();
+	record(CommandType::RenderTargets, color, depth);
+	record(CommandType::Viewport, nullptr, nullptr, width, height);
+}
+
+/*
+	- FinishCommandList(FALSE, ...): the deferred context starts from the default state for the next recording,
+	  nothing of this recording is carried over
+*/
+
+void CommandList::finish()
+{
+	if (m_context && !m_list)
+	{
+		if (FAILED(m_context->m_device_context->FinishCommandList(FALSE, &m_list)))
+		{
+			throw std::exception("Finish Command List was not successful");
+		}
+	}
+}
+
+
+void CommandList::setVertexBuffer(VertexBuffer* vertex_buffer)
+{
+	record(CommandType::VertexBuffer, vertex_buffer);
+}
+
+void CommandList::setVertexStreams(VertexBuffer* positions, VertexBuffer* attributes)
+{
+	record(CommandType::VertexStreams, positions, attributes);
+}
+
+void CommandList::setIndexBuffer(IndexBuffer* index_buffer)
+{
+	record(CommandType::IndexBuffer, index_buffer);
+}
+
+void CommandList::drawTriangleList(UINT vertex_count, UINT start_vertex_index)
+{
+	record(CommandType::DrawTriangleList, nullptr, nullptr, vertex_count, start_vertex_index);
+}
+
+void CommandList::drawIndexedTriangleList(UINT index_count, UINT start_vertex_index, UINT start_index_location)
+{
+	record(CommandType::DrawIndexedTriangleList, nullptr, nullptr, index_count, start_vertex_index, start_index_location);
+}
+
+void CommandList::setDepthState(DepthState state)
+{
+	record(CommandType::DepthState, nullptr, nullptr, (UINT)state);
+}
+
+void CommandList::setComparisonSampler(UINT slot)
+{
+	record(CommandType::ComparisonSampler, nullptr, nullptr, slot);
+}
+
+void CommandList::setVertexShader(VertexShader* vertex_shader)
+{
+	record(CommandType::VertexShader, vertex_shader);
+}
+
+void CommandList::setPixelShader(PixelShader* pixel_shader)
+{
+	record(CommandType::PixelShader, pixel_shader);
+}
+
+void CommandList::setConstantBuffer(VertexShader* vertex_shader, ConstantBuffer* buffer, UINT slot)
+{
+	record(CommandType::VertexConstantBuffer, vertex_shader, buffer, slot);
+}
+
+void CommandList::setConstantBuffer(PixelShader* pixel_shader, ConstantBuffer* buffer, UINT slot)
+{
+	record(CommandType::PixelConstantBuffer, pixel_shader, buffer, slot);
+}
+
+void CommandList::setStructuredBuffer(PixelShader* pixel_shader, StructuredBuffer* buffer, UINT slot)
+{
+	record(CommandType::PixelStructuredBuffer, pixel_shader, buffer, slot);
+}
+
+void CommandList::setTexture(RenderTarget* target, UINT slot)
+{
+	record(CommandType::Texture, target, nullptr, slot);
+}
+
+/*
+	- deferred context: UpdateSubresource is recorded with a copy of the data by D3D11
+	- command stream: the data is appended to m_data. Only the offset is stored, m_data can grow while recording
+*/
+
+void CommandList::updateConstantBuffer(ConstantBuffer* buffer, void* data)
+{
+	if (m_context)
+	{
+		buffer->update(m_context, data);
+		m_command_count++;
+		return;
+	}
+
+	UINT offset = (UINT)m_data.size();
+	m_data.insert(m_data.end(), (unsigned char*)data, (unsigned char*)data + buffer->getSizeBuffer());
+	record(CommandType::UpdateConstantBuffer, buffer, nullptr, offset);
+}
+
+void CommandList::setTextureShader(TextureShader* texture_shader)
+{
+	record(CommandType::TextureShader, texture_shader);
+}
+
+
+bool CommandList::isDeferred()
+{
+	return m_context != nullptr;
+}
+
+UINT CommandList::getCommandCount()
+{
+	return m_command_count;
+}
+
+
+/*
+	- a deferred context records the call right away. The command stream stores it for replay()
+*/
+
+void CommandList::record(CommandType type, void* object0, void* object1, UINT value0, UINT value1, UINT value2)
+{
+	Command command = { type, { object0, object1 }, { value0, value1, value2 } };
+	m_command_count++;
+
+	if (m_context)
+		run(command, m_context);
+	else
+		m_commands.push_back(command);
+}
+
+
+void CommandList::replay(DeviceContext* context)
+{
+	for (const Command& command : m_commands)
+	{
+		run(command, context);
+	}
+}
+
+
+void CommandList::run(const Command& command, DeviceContext* context)
+{
+	switch (command.m_type)
+	{
+	case CommandType::RenderTarget: context->setRenderTarget((SwapChain*)command.m_objects[0]); break;
+	case CommandType::RenderTargets: context->setRenderTargets((RenderTarget*)command.m_objects[0], (RenderTarget*)command.m_objects[1]); break;
+	case CommandType::Viewport: context->setViewportSize(command.m_values[0], command.m_values[1]); break;
+	case CommandType::VertexBuffer: context->setVertexBuffer((VertexBuffer*)command.m_objects[0]); break;
+	case CommandType::VertexStreams: context->setVertexStreams((VertexBuffer*)command.m_objects[0], (VertexBuffer*)command.m_objects[1]); break;
+	case CommandType::IndexBuffer: context->setIndexBuffer((IndexBuffer*)command.m_objects[0]); break;
+	case CommandType::DrawTriangleList: context->drawTriangleList(command.m_values[0], command.m_values[1]); break;
+	case CommandType::DrawIndexedTriangleList: context->drawIndexedTriangleList(command.m_values[0], command.m_values[1], command.m_values[2]); break;
+	case CommandType::DepthState: context->setDepthState((DepthState)command.m_values[0]); break;
+	case CommandType::ComparisonSampler: context->setComparisonSampler(command.m_values[0]); break;
+	case CommandType::VertexShader: context->setVertexShader((VertexShader*)command.m_objects[0]); break;
+	case CommandType::PixelShader: context->setPixelShader((PixelShader*)command.m_objects[0]); break;
+	case CommandType::VertexConstantBuffer: context->setConstantBuffer((VertexShader*)command.m_objects[0], (ConstantBuffer*)command.m_objects[1], command.m_values[0]); break;
+	case CommandType::PixelConstantBuffer: context->setConstantBuffer((PixelShader*)command.m_objects[0], (ConstantBuffer*)command.m_objects[1], command.m_values[0]); break;
+	case CommandType::PixelStructuredBuffer: context->setStructuredBuffer((PixelShader*)command.m_objects[0], (StructuredBuffer*)command.m_objects[1], command.m_values[0]); break;
+	case CommandType::Texture: context->setTexture((RenderTarget*)command.m_objects[0], command.m_values[0]); break;
+	case CommandType::UpdateConstantBuffer: ((ConstantBuffer*)command.m_objects[0])->update(context, m_data.data() + command.m_values[0]); break;
+	case CommandType::TextureShader: context->setTextureShader((TextureShader*)command.m_objects[0]); break;
+	}
+}
+
+
+void CommandList::reset()
+{
+	if (m_list)
+	{
+		m_list->Release();
+		m_list = nullptr;
+	}
+
+	// clear() keeps the memory -> no allocations after the first frames
+	m_commands.clear();
+	m_data.clear();
+	m_command_count = 0;
+}
+
+
+CommandList::~CommandList()
+{
+	reset();
+	delete m_context;
+}
@@ -0,0 +1,134 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+#include <vector>
+#include "DeviceContext.h"
+
+/*
+	CommandList: draw calls recorded on a worker thread and submitted later on the render thread (DeviceContext::executeCommandList)
+
+	- one list per recording thread. The render thread executes the lists in the order the draws should happen
+	- with driver command lists the calls go to a deferred context of D3D11 -> the driver builds the commands on the recording thread
+	- without (WARP, software drivers) the calls are written to a command stream in memory and replayed on the immediate context.
+	  Constant buffer data is copied into the stream, resources are referenced and have to live until the list was executed
+	- a list starts from the default pipeline state: begin() binds the render target, everything else the draws need is set after it
+*/
+
+class CommandList
+{
+public:
+
+	// create with GraphicsEngine::createCommandList. recorded: the command stream in memory, otherwise a deferred context
+	CommandList(bool recorded);
+	~CommandList();
+
+	// start recording. The draws go to the render target of the swap chain
+	void begin(SwapChain* swap_chain, UINT width, UINT height);
+	// start recording into textures, e.g. the scene targets of the render graph. depth can be nullptr
+	void begin(RenderTarget* color, RenderTarget* depth, UINT width, UINT height);
+	// end recording. The list can then be executed once and is empty again afterwards
+	void finish();
+
+	void setVertexBuffer(VertexBuffer* vertex_buffer);
+	void setVertexStreams(VertexBuffer* positions, VertexBuffer* attributes = nullptr);
+	void setIndexBuffer(IndexBuffer* index_buffer);
+
+	void drawTriangleList(UINT vertex_count, UINT start_vertex_index);
+	void drawIndexedTriangleList(UINT index_count, UINT start_vertex_index, UINT start_index_location);
+
+	void setDepthState(DepthState state);
+	void setComparisonSampler(UINT slot);
+
+	void setVertexShader(VertexShader* vertex_shader);
+	void setPixelShader(PixelShader* pixel_shader);
+
+	void setConstantBuffer(VertexShader* vertex_shader, ConstantBuffer* buffer, UINT slot = 0);
+	void setConstantBuffer(PixelShader* pixel_shader, ConstantBuffer* buffer, UINT slot = 0);
+	void setStructuredBuffer(PixelShader* pixel_shader, StructuredBuffer* buffer, UINT slot);
+	void setTexture(RenderTarget* target, UINT slot);
+	// ConstantBuffer::update(CommandList*, ...). The data is copied, the upload happens in order with the draws
+	void updateConstantBuffer(ConstantBuffer* buffer, void* data);
+
+	void setTextureShader(TextureShader* texture_shader);
+
+	// true: deferred context of D3D11, false: command stream in memory
+	bool isDeferred();
+	// calls recorded since begin()
+	UINT getCommandCount();
+
+private:
+
+	enum class CommandType
+	{
+		RenderTarget,
+		RenderTargets,
+		Viewport,
+		VertexBuffer,
+		VertexStreams,
+		IndexBuffer,
+		DrawTriangleList,
+		DrawIndexedTriangleList,
+		DepthState,
+		ComparisonSampler,
+		VertexShader,
+		PixelShader,
+		VertexConstantBuffer,
+		PixelConstantBuffer,
+		PixelStructuredBuffer,
+		Texture,
+		UpdateConstantBuffer,
+		TextureShader
+	};
+
+	// pointers to the resources and up to three values. UpdateConstantBuffer: m_values[0] is the offset of the data in m_data
+	struct Command
+	{
+		CommandType m_type;
+		void* m_objects[2];
+		UINT m_values[3];
+	};
+
+	void record(CommandType type, void* object0, void* object1 = nullptr, UINT value0 = 0, UINT value1 = 0, UINT value2 = 0);
+	// run the command stream on the immediate context
+	void replay(DeviceContext* context);
+	void run(const Command& command, DeviceContext* context);
+	void reset();
+
+private:
+
+	DeviceContext* m_context = nullptr;			// deferred context, nullptr for the command stream
+	ID3D11CommandList* m_list = nullptr;		// result of finish() on the deferred context
+
+	std::vector<Command> m_commands;
+	std::vector<unsigned char> m_data;			// constant buffer data of UpdateConstantBuffer
+	UINT m_command_count = 0;
+
+private:
+
+	friend class DeviceContext;
+};
@@ -29,6 +29,7 @@
 #include "ConstantBuffer.h"
 #include "GraphicsEngine.h"
 #include "DeviceContext.h"
+#include "CommandList.h"
 
 #include <exception>
 
@@ -64,6 +65,8 @@ ConstantBuffer::ConstantBuffer(void* buffer, UINT size_buffer)
 	{
 		throw std::exception("Create Constant Buffer was not successful");
 	}
+
+	m_size_buffer = size_buffer;
 }
 
 
@@ -89,6 +92,16 @@ void ConstantBuffer::update(DeviceContext* context, void* buffer)
 	context->m_device_context->UpdateSubresource(this->m_buffer, NULL, NULL, buffer, NULL, NULL);
 }
 
+void ConstantBuffer::update(CommandList* list, void* buffer)
+{
+	list->updateConstantBuffer(this, buffer);
+}
+
+UINT ConstantBuffer::getSizeBuffer()
+{
+	return m_size_buffer;
+}
+
 
 ConstantBuffer::~ConstantBuffer()
 {
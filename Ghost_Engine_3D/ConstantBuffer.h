@@ -34,6 +34,7 @@
 #include "Matrix4x4.h"
 
 class DeviceContext;
+class CommandList;
 
 class ConstantBuffer
 {
@@ -42,10 +43,14 @@ public:
 	ConstantBuffer(void* buffer, UINT size_buffer);
 	~ConstantBuffer();
 	void update(DeviceContext* context, void* buffer);
+	// recorded into the list, uploaded when the list is executed
+	void update(CommandList* list, void* buffer);
+	UINT getSizeBuffer();
 
 private:
 
 	ID3D11Buffer* m_buffer = nullptr;
+	UINT m_size_buffer = 0;
 
 private:
 
@@ -68,4 +73,86 @@ struct ConstantType
 	Vector3D ambientColor;
 	float ambientPower;
 	Vector3D m_vectorLight;
+};
+
+
+/*
+	- ranges of a packed vertex format (VertexQuantization) for PackedVertexShader.hlsl, register b1.
+		every float3 starts a new 16 Bytes register in HLSL -> padded here
+*/
+
+__declspec(align(16))
+struct QuantizationConstantType
+{
+	Vector3D m_position_offset;
+	float m_pad0 = 0.0f;
+	Vector3D m_position_scale;
+	float m_pad1 = 0.0f;
+	float m_texcoord_offset_scale[4] = {};		// offset x y, scale x y
+	float m_octahedral_normals = 0.0f;			// 1: the normal is octahedral encoded
+	float m_pad2[3] = {};
+};
+
+
+/*
+	- full screen passes of the render graph, PostProcessShader.hlsl register b0
+*/
+
+__declspec(align(16))
+struct PostProcessConstantType
+{
+	float m_texel_size[2] = {};
+	float m_direction[2] = {};
+	float m_threshold = 0.0f;
+	float m_intensity = 0.0f;
+	float m_near = 0.0f;
+	float m_far = 0.0f;
+	float m_show_depth = 0.0f;
+};
+
+
+/*
+	- clustered lights of LightGrid, PixelShader.hlsl register b2
+*/
+
+__declspec(align(16))
+struct ClusterConstantType
+{
+	unsigned int m_grid[3] = {};				// clusters in x, y and depth slices
+	unsigned int m_light_count = 0;
+	float m_tile_size[2] = {};					// pixels per cluster on screen
+	float m_slice_scale = 0.0f;					// slice = log(view depth) * scale + bias
+	float m_slice_bias = 0.0f;
+};
+
+
+/*
+	- cascaded shadow maps of ShadowCascades, PixelShader.hlsl register b3
+*/
+
+__declspec(align(16))
+struct ShadowConstantType
+{
+	Matrix4x4 m_cascade_matrix[4];				// world to shadow map: view * proj of the cascade
+	float m_cascade_far[4] = {};				// view depth where each cascade ends
+	float m_texel_size[4] = {};					// world size of one texel per cascade, for the normal offset
+	float m_enabled = 0.0f;
+	float m_bias = 0.0f;
+	float m_pad[2] = {};
+};
+
+
+/*
+	- terrain of Terrain, TerrainShader.hlsl register b1
+*/
+
+__declspec(align(16))
+struct TerrainConstantType
+{
+	float m_camera[3] = {};						// world position, for the morph distance
+	float m_height_scale = 0.0f;				// world height of the height 1 (65535)
+	float m_origin[3] = {};						// world position of the first height
+	float m_tile_samples = 0.0f;				// heights per side of a tile
+	unsigned int m_grid_size = 0;				// quads per side of the instance grid
+	float m_pad[3] = {};
 };
\ No newline at end of file
@@ -0,0 +1,206 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "AssetCooker.h"
+#include "TerrainFile.h"
+#include <Windows.h>
+#include <algorithm>
+#include <cstdio>
+#include <cwchar>
+#include <string>
+
+/*
+	AssetCooker command line tool
+
+		AssetCooker [root] [-force] [-pack file] [-lods count] [-vertex float|packed|half] [-mips box|kaiser]
+		            [-compression fast|quality] [-atlas size] [-terrain size]
+
+	- root: asset directory, relative to the working directory of the game (default: Graphics)
+	- -force: cook everything, ignore the cache manifest
+	- -pack: also write the cooked assets into a pack file, which the game mounts at startup
+	- -lods: detail levels per mesh including the full one (default 4, 1 = no simplification)
+	- -vertex: vertex format of the meshes. float: 32 bytes (default). packed: 16 bytes, 16-bit positions and
+	  texcoords relative to the mesh bounds, octahedral normals. half: packed with half float texcoords
+	- -mips: filter of the texture mip chains. kaiser: sharp (default), box: 2x2 average, faster and softer
+	- -compression: block compression of the textures. quality: BC7 full search (default), fast: BC1/BC3
+	- -atlas: pack the diffuse textures of the materials of each mesh into texture atlases of size texels per side
+	  (a power of two, at least 256) and move the texture coordinates into them. Materials whose texture repeats
+	  keep their own texture. Off by default
+	- -terrain: write the streamed terrain (TerrainFile) of size quads per side, a power of two, into root\Terrain.
+	  Heights from root\Terrain\heightmap.r16 (square 16-bit raw) if it exists, otherwise procedural hills.
+	  Always written, the cache manifest does not cover the tiles
+*/
+
+int wmain(int argc, wchar_t** argv)
+{
+	std::wstring root = L"Graphics";
+	std::wstring pack;
+	bool force = false;
+	MeshLodSettings lod_settings;
+	VertexFormat vertex_format;
+	TextureCookSettings texture_settings;
+	texture_settings.m_preset = CompressionPreset::Quality;
+	AtlasSettings atlas_settings;
+	unsigned int terrain_size = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		std::wstring argument = argv[i];
+
+		if (argument == L"-force")
+			force = true;
+		else if (argument == L"-pack" && i + 1 < argc)
+			pack = argv[++i];
+		else if (argument == L"-lods" && i + 1 < argc)
+			lod_settings.m_max_lods = (unsigned int)std::max(1l, wcstol(argv[++i], nullptr, 10));
+		else if (argument == L"-vertex" && i + 1 < argc)
+		{
+			std::wstring name = argv[++i];
+			if (name == L"packed" || name == L"half")
+			{
+				vertex_format = VertexFormat::packed();
+				if (name == L"half")
+					vertex_format.m_texcoord = TexcoordFormat::Half2;
+			}
+			else if (name != L"float")
+			{
+				printf("unknown vertex format %ls (float, packed or half)\n", name.c_str());
+				return 1;
+			}
+		}
+		else if (argument == L"-mips" && i + 1 < argc)
+		{
+			std::wstring name = argv[++i];
+			if (name == L"box")
+				texture_settings.m_mip_filter = MipFilter::Box;
+			else if (name == L"kaiser")
+				texture_settings.m_mip_filter = MipFilter::Kaiser;
+			else
+			{
+				printf("unknown mip filter %ls (box or kaiser)\n", name.c_str());
+				return 1;
+			}
+		}
+		else if (argument == L"-compression" && i + 1 < argc)
+		{
+			std::wstring name = argv[++i];
+			if (name == L"fast")
+				texture_settings.m_preset = CompressionPreset::Fast;
+			else if (name == L"quality")
+				texture_settings.m_preset = CompressionPreset::Quality;
+			else
+			{
+				printf("unknown compression %ls (fast or quality)\n", name.c_str());
+				return 1;
+			}
+		}
+		else if (argument == L"-atlas" && i + 1 < argc)
+		{
+			atlas_settings.m_size = (unsigned int)std::max(0l, wcstol(argv[++i], nullptr, 10));
+			if (atlas_settings.m_size < 256 || (atlas_settings.m_size & (atlas_settings.m_size - 1)))
+			{
+				printf("atlas size %u is not a power of two of at least 256\n", atlas_settings.m_size);
+				return 1;
+			}
+		}
+		else if (argument == L"-terrain" && i + 1 < argc)
+			terrain_size = (unsigned int)std::max(0l, wcstol(argv[++i], nullptr, 10));
+		else if (argument[0] != L'-')
+			root = argument;
+		else
+		{
+			printf("usage: AssetCooker [root] [-force] [-pack file] [-lods count] [-vertex float|packed|half] [-mips box|kaiser]"
+				" [-compression fast|quality] [-atlas size] [-terrain size]\n");
+			return 1;
+		}
+	}
+
+	// WIC decodes on the job threads: in the multithreaded apartment every thread of the process can use COM
+	HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	if (FAILED(hr))
+	{
+		return -1;
+	}
+
+	AssetCooker cooker(root);
+	cooker.setLodSettings(lod_settings);
+	cooker.setVertexFormat(vertex_format);
+	cooker.setTextureSettings(texture_settings);
+	cooker.setAtlasSettings(atlas_settings);
+	if (!cooker.scan())
+	{
+		printf("asset directory %ls not found\n", root.c_str());
+		return 1;
+	}
+
+	cooker.cook(force);
+	cooker.printReport();
+
+	int result = cooker.getStats().m_failed ? 1 : 0;
+
+	if (terrain_size)
+	{
+		// 4096 quads cover 409.6 units, 20 units from the lowest to the highest height
+		TerrainFileHeader header;
+		header.m_size = terrain_size;
+		header.m_tile_size = std::min(header.m_tile_size, terrain_size);
+		header.m_spacing = 0.1f;
+		header.m_height_scale = 20.0f;
+
+		std::wstring directory = root + L"\\Terrain";
+		std::wstring raw = directory + L"\\heightmap.r16";
+		std::vector<unsigned short> heights;
+		bool from_raw = TerrainFile::readRaw(raw.c_str(), terrain_size, heights);
+		if (!from_raw)
+			TerrainFile::generate(terrain_size, heights);
+
+		if (TerrainFile::setLevels(header) && TerrainFile::write(directory.c_str(), header, heights))
+		{
+			printf("terrain written: %ls, %u quads per side from %ls\n", directory.c_str(), terrain_size, from_raw ? raw.c_str() : L"procedural heights");
+		}
+		else
+		{
+			printf("writing terrain %ls failed (size: a power of two of at least 32)\n", directory.c_str());
+			result = 1;
+		}
+	}
+
+	if (!pack.empty())
+	{
+		if (cooker.writePack(pack.c_str()))
+		{
+			printf("pack written: %ls\n", pack.c_str());
+		}
+		else
+		{
+			printf("writing pack %ls failed\n", pack.c_str());
+			result = 1;
+		}
+	}
+
+	CoUninitialize();
+	return result;
+}
@@ -0,0 +1,82 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	vertex shader of position only passes (depth pre-pass): reads the position stream of a mesh
+	(VertexStream::Position), 12 bytes per vertex or 8 for packed positions, and nothing else.
+	No pixel shader is bound, the pass only writes depth
+*/
+struct VS_INPUT
+{
+	float4 position: POSITION;
+};
+
+struct VS_OUTPUT
+{
+	precise float4 position: SV_POSITION;
+};
+
+// adding Data Structure passed into ConstantBuffer
+cbuffer constant: register(b0)
+{
+	row_major float4x4 m_world;
+	row_major float4x4 m_view;
+	row_major float4x4 m_proj;
+	unsigned int m_time;
+	float3 ambientColor;
+	float ambientPower;
+	float3 m_vectorLight;
+
+};
+
+// ranges of the vertex format of the mesh (QuantizationConstantType), identity for float positions
+cbuffer quantization: register(b1)
+{
+	float3 m_position_offset;
+	float3 m_position_scale;
+	float4 m_texcoord_offset_scale;
+	float m_octahedral_normals;
+};
+
+
+/*
+	the same operations as the shaders of the full pass -> the same depth, the full pass can test it with LESS_EQUAL
+*/
+VS_OUTPUT vsmain(VS_INPUT input)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+
+	float4 position = float4(m_position_offset + input.position.xyz * m_position_scale, 1.0f);
+
+	// world space
+	output.position = mul(position, m_world);
+	// view space
+	output.position = mul(output.position, m_view);
+	// screen space
+	output.position = mul(output.position, m_proj);
+
+	return output;
+}
\ No newline at end of file
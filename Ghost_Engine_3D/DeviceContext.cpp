@@ -34,6 +34,11 @@
 #include "VertexShader.h"
 #include "PixelShader.h"
 #include "TextureShader.h"
+#include "GraphicsEngine.h"
+#include "CommandList.h"
+#include "RenderTarget.h"
+#include "StructuredBuffer.h"
+#include "TextureArray.h"
 
 DeviceContext::DeviceContext(ID3D11DeviceContext* device_context):m_device_context(device_context)
 {
@@ -68,6 +73,42 @@ void DeviceContext::clearRenderTargetColor(SwapChain* swap_chain, float red, flo
 	m_device_context->OMSetRenderTargets(1, &swap_chain->m_rtv, swap_chain->m_dsv);
 }
 
+void DeviceContext::setRenderTarget(SwapChain* swap_chain, bool depth)
+{
+	m_device_context->OMSetRenderTargets(1, &swap_chain->m_rtv, depth ? swap_chain->m_dsv : nullptr);
+}
+
+void DeviceContext::setRenderTargets(RenderTarget* color, RenderTarget* depth)
+{
+	ID3D11RenderTargetView* rtv = color ? color->m_rtv : nullptr;
+	m_device_context->OMSetRenderTargets(color ? 1 : 0, color ? &rtv : nullptr, depth ? depth->m_dsv : nullptr);
+}
+
+void DeviceContext::clearRenderTarget(RenderTarget* target, float red, float green, float blue, float alpha)
+{
+	if (target->isDepth())
+	{
+		m_device_context->ClearDepthStencilView(target->m_dsv, D3D11_CLEAR_DEPTH, 1.0f, 0);
+		return;
+	}
+
+	FLOAT clear_color[] = { red,green,blue,alpha };
+	m_device_context->ClearRenderTargetView(target->m_rtv, clear_color);
+}
+
+void DeviceContext::setTexture(RenderTarget* target, UINT slot)
+{
+	ID3D11ShaderResourceView* srv = target ? target->m_srv : nullptr;
+	m_device_context->PSSetShaderResources(slot, 1, &srv);
+}
+
+void DeviceContext::unbindTextures(UINT count)
+{
+	ID3D11ShaderResourceView* srvs[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT] = {};
+	if (count > D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT) count = D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT;
+	m_device_context->PSSetShaderResources(0, count, srvs);
+}
+
 void DeviceContext::setVertexBuffer(VertexBuffer* vertex_buffer)
 {
 	UINT stride = vertex_buffer->m_size_vertex;
@@ -76,9 +117,18 @@ void DeviceContext::setVertexBuffer(VertexBuffer* vertex_buffer)
 	m_device_context->IASetInputLayout(vertex_buffer->m_layout);
 }
 
+void DeviceContext::setVertexStreams(VertexBuffer* positions, VertexBuffer* attributes)
+{
+	ID3D11Buffer* buffers[2] = { positions->m_buffer, attributes ? attributes->m_buffer : nullptr };
+	UINT strides[2] = { positions->m_size_vertex, attributes ? attributes->m_size_vertex : 0 };
+	UINT offsets[2] = { 0, 0 };
+	m_device_context->IASetVertexBuffers(0, 2, buffers, strides, offsets);
+	m_device_context->IASetInputLayout(attributes ? attributes->m_layout : positions->m_layout);
+}
+
 void DeviceContext::setIndexBuffer(IndexBuffer* index_buffer)
 {
-	m_device_context->IASetIndexBuffer(index_buffer->m_buffer, DXGI_FORMAT_R32_UINT, 0);
+	m_device_context->IASetIndexBuffer(index_buffer->m_buffer, index_buffer->m_format, 0);
 }
 
 /*
@@ -110,6 +160,27 @@ void DeviceContext::drawTriangleStrip(UINT vertex_count, UINT start_vertex_index
 	m_device_context->Draw(vertex_count, start_vertex_index);
 }
 
+void DeviceContext::drawFullScreenTriangle()
+{
+	m_device_context->IASetInputLayout(nullptr);
+	m_device_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_device_context->Draw(3, 0);
+}
+
+void DeviceContext::drawIndexedInstancedVertexID(UINT index_count, UINT instance_count)
+{
+	m_device_context->IASetInputLayout(nullptr);
+	m_device_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_device_context->DrawIndexedInstanced(index_count, instance_count, 0, 0, 0);
+}
+
+void DeviceContext::drawInstancedVertexID(UINT vertex_count, UINT instance_count)
+{
+	m_device_context->IASetInputLayout(nullptr);
+	m_device_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	m_device_context->DrawInstanced(vertex_count, instance_count, 0, 0);
+}
+
 /*
 	set in which area of the targetView we want to draw
 */
@@ -130,7 +201,22 @@ void DeviceContext::setVertexShader(VertexShader* vertex_shader)
 
 void DeviceContext::setPixelShader(PixelShader* pixel_shader)
 {
-	m_device_context->PSSetShader(pixel_shader->m_ps, nullptr, 0);
+	m_device_context->PSSetShader(pixel_shader ? pixel_shader->m_ps : nullptr, nullptr, 0);
+}
+
+void DeviceContext::setDepthState(DepthState state)
+{
+	m_device_context->OMSetDepthStencilState(GraphicsEngine::get()->m_depth_states[(unsigned int)state], 0);
+}
+
+void DeviceContext::setBlendState(BlendState state)
+{
+	m_device_context->OMSetBlendState(GraphicsEngine::get()->m_blend_states[(unsigned int)state], nullptr, 0xffffffff);
+}
+
+void DeviceContext::setComparisonSampler(UINT slot)
+{
+	m_device_context->PSSetSamplers(slot, 1, &GraphicsEngine::get()->m_comparison_sampler);
 }
 
 
@@ -151,14 +237,53 @@ void DeviceContext::setTextureShader(TextureShader* texture_shader)
 	m_device_context->PSSetShaderResources(0, 1, &texture_shader->m_ts);
 }
 
-void DeviceContext::setConstantBuffer(VertexShader* vertex_shader, ConstantBuffer* buffer)
+void DeviceContext::setConstantBuffer(VertexShader* vertex_shader, ConstantBuffer* buffer, UINT slot)
+{
+	m_device_context->VSSetConstantBuffers(slot, 1, &buffer->m_buffer);
+}
+
+void DeviceContext::setConstantBuffer(PixelShader* pixel_shader, ConstantBuffer* buffer, UINT slot)
+{
+	m_device_context->PSSetConstantBuffers(slot, 1, &buffer->m_buffer);
+}
+
+void DeviceContext::setStructuredBuffer(PixelShader* pixel_shader, StructuredBuffer* buffer, UINT slot)
 {
-	m_device_context->VSSetConstantBuffers(0, 1, &buffer->m_buffer);
+	m_device_context->PSSetShaderResources(slot, 1, &buffer->m_srv);
 }
 
-void DeviceContext::setConstantBuffer(PixelShader* pixel_shader, ConstantBuffer* buffer)
+void DeviceContext::setStructuredBuffer(VertexShader* vertex_shader, StructuredBuffer* buffer, UINT slot)
 {
-	m_device_context->PSSetConstantBuffers(0, 1, &buffer->m_buffer);
+	m_device_context->VSSetShaderResources(slot, 1, &buffer->m_srv);
+}
+
+void DeviceContext::setTextureArray(VertexShader* vertex_shader, TextureArray* texture, UINT slot)
+{
+	m_device_context->VSSetShaderResources(slot, 1, &texture->m_srv);
+}
+
+
+void DeviceContext::setTextureArray(PixelShader* pixel_shader, TextureArray* texture, UINT slot)
+{
+	m_device_context->PSSetShaderResources(slot, 1, &texture->m_srv);
+}
+
+/*
+	- ExecuteCommandList(list, FALSE): the state of the immediate context is not saved and restored around the list (that costs time),
+	  it is cleared to the default state afterwards
+	- a command stream in memory is replayed here. Its state stays bound
+*/
+
+void DeviceContext::executeCommandList(CommandList* list)
+{
+	list->finish();
+
+	if (list->m_list)
+		m_device_context->ExecuteCommandList(list->m_list, FALSE);
+	else
+		list->replay(this);
+
+	list->reset();
 }
 
 
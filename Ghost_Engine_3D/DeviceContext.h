@@ -36,6 +36,23 @@ class ConstantBuffer;
 class VertexShader;
 class PixelShader;
 class TextureShader;
+class CommandList;
+class RenderTarget;
+class StructuredBuffer;
+class TextureArray;
+
+enum class DepthState
+{
+	Default,		// LESS, writes depth
+	Equal,			// LESS_EQUAL without writes: after a depth pre-pass only the visible surface is shaded
+	Test			// LESS without writes: blended draws are hidden by the scene but do not hide each other
+};
+
+enum class BlendState
+{
+	Opaque,			// the pipeline default, the color replaces the target
+	Alpha			// color * alpha + target * (1 - alpha), for sorted transparent draws
+};
 
 class DeviceContext
 {
@@ -43,26 +60,62 @@ public:
 
 	DeviceContext(ID3D11DeviceContext* device_context);
 	void clearRenderTargetColor(SwapChain* swap_chain, float red, float green, float blue, float alpha);
+	// draw to the back buffer and depth buffer of the swap chain (clearRenderTargetColor sets them too).
+	// depth = false: only the back buffer, for full screen passes that must not test against the depth of the swap chain
+	void setRenderTarget(SwapChain* swap_chain, bool depth = true);
+	// draw to textures. Either one can be nullptr: no color (depth only passes) or no depth
+	void setRenderTargets(RenderTarget* color, RenderTarget* depth);
+	// color targets to the color, depth targets to 1
+	void clearRenderTarget(RenderTarget* target, float red, float green, float blue, float alpha);
+	// read a target in the pixel shader, register t<slot>. nullptr unbinds the slot
+	void setTexture(RenderTarget* target, UINT slot);
+	// unbind the textures of slot 0 to count - 1: a target still bound for reading cannot be drawn into
+	void unbindTextures(UINT count);
 	void setVertexBuffer(VertexBuffer* vertex_buffer);
+	// split streams of a mesh: positions in slot 0, texcoord + normal in slot 1 with the input layout of both.
+	// Without attributes only the positions are bound (position only passes)
+	void setVertexStreams(VertexBuffer* positions, VertexBuffer* attributes = nullptr);
 	void setIndexBuffer(IndexBuffer* index_buffer);
 
 
 	void drawTriangleList(UINT vertex_count, UINT start_vertex_index);
 	void drawIndexedTriangleList(UINT index_count, UINT start_vertex_index, UINT start_index_location);
 	void drawTriangleStrip(UINT vertex_count, UINT start_vertex_index);
+	// one triangle covering the viewport, the vertex shader builds it from SV_VertexID (no vertex buffer)
+	void drawFullScreenTriangle();
+	// instances of an index list without a vertex buffer: the vertex shader builds each vertex from SV_VertexID (the
+	// index) and SV_InstanceID, e.g. the grid chunks of Terrain
+	void drawIndexedInstancedVertexID(UINT index_count, UINT instance_count);
+	// the same without indices, e.g. the 6 vertices of a quad per particle
+	void drawInstancedVertexID(UINT vertex_count, UINT instance_count);
 
 	void setViewportSize(UINT width, UINT height);
+	void setDepthState(DepthState state);
+	void setBlendState(BlendState state);
+	// sampler for shadow maps (SamplerComparisonState), register s<slot> of the pixel shader
+	void setComparisonSampler(UINT slot);
 
 	void setVertexShader(VertexShader* vertex_shader);
+	// nullptr: no pixel shader, the draws only write depth
 	void setPixelShader(PixelShader* pixel_shader);
 
 
-	// link ConstantBuffer to the graphics pipeline. Bind it to Pixel and Vertex Shader with overloading
-	void setConstantBuffer(VertexShader* vertex_shader, ConstantBuffer* buffer);
-	void setConstantBuffer(PixelShader* pixel_shader, ConstantBuffer* buffer);
+	// link ConstantBuffer to the graphics pipeline. Bind it to Pixel and Vertex Shader with overloading. slot: register b<slot>
+	void setConstantBuffer(VertexShader* vertex_shader, ConstantBuffer* buffer, UINT slot = 0);
+	void setConstantBuffer(PixelShader* pixel_shader, ConstantBuffer* buffer, UINT slot = 0);
+	// read by the pixel shader, register t<slot>
+	void setStructuredBuffer(PixelShader* pixel_shader, StructuredBuffer* buffer, UINT slot);
+	void setTextureArray(PixelShader* pixel_shader, TextureArray* texture, UINT slot);
+	// read by the vertex shader, register t<slot>
+	void setStructuredBuffer(VertexShader* vertex_shader, StructuredBuffer* buffer, UINT slot);
+	void setTextureArray(VertexShader* vertex_shader, TextureArray* texture, UINT slot);
 
 	void setTextureShader(TextureShader* texture_shader);
 
+	// submit a list recorded on another thread. Only on the immediate context, in the order the draws should happen.
+	// Afterwards the pipeline state is reset to the default -> bind again what the next draws need
+	void executeCommandList(CommandList* list);
+
 	~DeviceContext();
 
 private:
@@ -72,5 +125,9 @@ private:
 private:
 
 	friend class ConstantBuffer;
+	friend class IndexBuffer;
+	friend class StructuredBuffer;
+	friend class TextureArray;
+	friend class CommandList;
 };
 
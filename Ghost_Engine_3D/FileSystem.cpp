@@ -0,0 +1,292 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "FileSystem.h"
+#include "LZCompressor.h"
+
+
+FileSpan::FileSpan()
+{
+}
+
+
+const unsigned char* FileSpan::getData()
+{
+	return m_data;
+}
+
+
+size_t FileSpan::getSize()
+{
+	return m_size;
+}
+
+
+bool FileSpan::isPacked()
+{
+	return m_packed;
+}
+
+
+void FileSpan::reset()
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_packed = false;
+	m_buffer.clear();
+	m_mapped.close();
+}
+
+
+FileSpan::~FileSpan()
+{
+}
+
+
+// the stream never writes into the buffer: the const_cast is only for the signature of setg
+SpanStream::SpanStream(const unsigned char* data, size_t size) : std::istream(static_cast<std::streambuf*>(this))
+{
+	char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+	setg(begin, begin, begin + size);
+}
+
+
+FileSystem::FileSystem()
+{
+}
+
+
+FileSystem* FileSystem::get()
+{
+	static FileSystem system;
+	return &system;
+}
+
+
+bool FileSystem::mount(const wchar_t* pack_file)
+{
+	PackFile* pack = new PackFile();
+
+	if (!pack->open(pack_file))
+	{
+		delete pack;
+		return false;
+	}
+
+	m_packs.push_back(pack);
+	return true;
+}
+
+
+void FileSystem::unmountAll()
+{
+	for (size_t i = 0; i < m_packs.size(); i++)
+	{
+		delete m_packs[i];
+	}
+	m_packs.clear();
+}
+
+
+PackFile* FileSystem::findPack(const std::string& path, const PackFileEntry** entry)
+{
+	for (size_t i = m_packs.size(); i > 0; i--)
+	{
+		*entry = m_packs[i - 1]->find(path.c_str());
+		if (*entry)
+			return m_packs[i - 1];
+	}
+
+	return nullptr;
+}
+
+
+bool FileSystem::read(const wchar_t* path, FileSpan& span)
+{
+	span.reset();
+
+	const PackFileEntry* entry = nullptr;
+	PackFile* pack = m_packs.empty() ? nullptr : findPack(PackFile::normalizePath(path), &entry);
+
+	if (pack)
+	{
+		const unsigned char* data = pack->getData(*entry);
+
+		if (entry->m_flags & PACK_ENTRY_COMPRESSED)
+		{
+			span.m_buffer.resize((size_t)entry->m_size);
+			if (!LZCompressor::decompress(data, (size_t)entry->m_stored_size, span.m_buffer.data(), span.m_buffer.size()))
+			{
+				span.reset();
+				return false;
+			}
+			data = span.m_buffer.data();
+		}
+
+		span.m_data = data;
+		span.m_size = (size_t)entry->m_size;
+		span.m_packed = true;
+		return true;
+	}
+
+	{
+		// the completion jobs insert from the workers -> even empty() is only read under the lock
+		std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+		if (!m_prefetched.empty())
+		{
+			auto it = m_prefetched.find(PackFile::normalizePath(path));
+			if (it != m_prefetched.end())
+			{
+				span.m_buffer.swap(it->second);
+				m_prefetched.erase(it);
+				span.m_data = span.m_buffer.data();
+				span.m_size = span.m_buffer.size();
+				return true;
+			}
+		}
+	}
+
+	// loose file fallback
+	if (!span.m_mapped.open(path))
+		return false;
+
+	span.m_data = span.m_mapped.getData();
+	span.m_size = span.m_mapped.getSize();
+	return true;
+}
+
+
+bool FileSystem::isPacked(const wchar_t* path)
+{
+	const PackFileEntry* entry = nullptr;
+	return !m_packs.empty() && findPack(PackFile::normalizePath(path), &entry) != nullptr;
+}
+
+
+bool FileSystem::exists(const wchar_t* path)
+{
+	return isPacked(path) || ::GetFileAttributesW(path) != INVALID_FILE_ATTRIBUTES;
+}
+
+
+unsigned int FileSystem::getMountCount()
+{
+	return (unsigned int)m_packs.size();
+}
+
+
+/*
+	- the decoders run in the completion jobs: parsing, mip mapping and compression overlap the reads still in flight
+	- a decoder that throws only loses its result: the loader reads the file again and reports the error itself
+*/
+
+void FileSystem::prefetch(const std::vector<PrefetchRequest>& requests)
+{
+	AsyncFileReader reader;
+
+	for (size_t i = 0; i < requests.size(); i++)
+	{
+		if (isPacked(requests[i].m_path.c_str()))
+			continue;
+
+		PrefetchDecoder decoder = requests[i].m_decoder;
+		reader.read(requests[i].m_path, [this, decoder](const std::wstring& path, std::vector<unsigned char>& data, bool ok)
+			{
+				if (!ok)
+					return;
+
+				if (!decoder)
+				{
+					std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+					m_prefetched[PackFile::normalizePath(path.c_str())].swap(data);
+					return;
+				}
+
+				PrefetchedAsset* asset = nullptr;
+				try
+				{
+					asset = decoder(path, data);
+				}
+				catch (...)
+				{
+					asset = nullptr;
+				}
+
+				if (!asset)
+					return;
+
+				std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+				PrefetchedAsset*& slot = m_decoded[PackFile::normalizePath(path.c_str())];
+				delete slot;
+				slot = asset;
+			});
+	}
+
+	reader.submit();
+	reader.wait();
+
+	m_prefetch_stats = reader.getStats();
+}
+
+
+PrefetchedAsset* FileSystem::takeDecoded(const wchar_t* path)
+{
+	std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+
+	auto it = m_decoded.find(PackFile::normalizePath(path));
+	if (it == m_decoded.end())
+		return nullptr;
+
+	PrefetchedAsset* asset = it->second;
+	m_decoded.erase(it);
+	return asset;
+}
+
+
+void FileSystem::clearPrefetched()
+{
+	std::lock_guard<std::mutex> lock(m_prefetch_mutex);
+	m_prefetched.clear();
+
+	for (auto it = m_decoded.begin(); it != m_decoded.end(); ++it)
+	{
+		delete it->second;
+	}
+	m_decoded.clear();
+}
+
+
+AsyncReadStats FileSystem::getPrefetchStats()
+{
+	return m_prefetch_stats;
+}
+
+
+FileSystem::~FileSystem()
+{
+	clearPrefetched();
+	unmountAll();
+}
@@ -0,0 +1,172 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "MappedFile.h"
+#include "PackFile.h"
+#include "AsyncFileReader.h"
+#include <functional>
+#include <istream>
+#include <map>
+#include <mutex>
+#include <streambuf>
+#include <vector>
+
+/*
+	FileSpan: bytes of one file, read through the FileSystem
+
+	- a raw entry of a pack points straight into the mapping of the pack (zero copy)
+	- a compressed entry is decompressed into m_buffer
+	- a loose file is mapped by its own MappedFile
+	- the bytes stay valid until the span is reset or destroyed
+*/
+
+class FileSpan
+{
+public:
+
+	FileSpan();
+	~FileSpan();
+
+	const unsigned char* getData();
+	size_t getSize();
+	// true when the bytes came from a pack
+	bool isPacked();
+
+	void reset();
+
+private:
+
+	FileSpan(const FileSpan&) = delete;
+	FileSpan& operator=(const FileSpan&) = delete;
+
+private:
+
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+	bool m_packed = false;
+	std::vector<unsigned char> m_buffer;
+	MappedFile m_mapped;
+
+private:
+
+	friend class FileSystem;
+};
+
+
+/*
+	SpanStream: std::istream over the bytes of a FileSpan, for parsers that only accept streams (tinyobjloader)
+*/
+
+class SpanStream : private std::streambuf, public std::istream
+{
+public:
+
+	SpanStream(const unsigned char* data, size_t size);
+};
+
+
+/*
+	PrefetchedAsset: what a decoder made of a prefetched file in its completion job (the CPU side of a texture or mesh)
+
+	- the loader takes it with FileSystem::takeDecoded() and casts it to its own type, only the GPU upload is left
+*/
+
+class PrefetchedAsset
+{
+public:
+
+	virtual ~PrefetchedAsset() {}
+};
+
+// runs on a worker: must not touch the device. nullptr when the bytes can not be decoded (the loader reads again)
+typedef std::function<PrefetchedAsset*(const std::wstring& path, std::vector<unsigned char>& data)> PrefetchDecoder;
+
+// one file of a prefetch. Without a decoder the bytes are kept as they are and read() returns them
+struct PrefetchRequest
+{
+	std::wstring m_path;
+	PrefetchDecoder m_decoder;
+};
+
+
+/*
+	FileSystem: virtual file system of the assets
+
+	- pack files are mounted once at startup and stay mapped -> opening an asset is a binary search, not a file open
+	- paths are the same relative paths as for loose files (L"Graphics\\Textures\\marmor2.jpg")
+	- packs mounted later override earlier ones (patches), loose files are the fallback for everything not packed
+	- prefetch() reads a list of loose files in one batch with the AsyncFileReader (io_uring / thread pool). The
+	  decoder of a file runs in its completion job while the other reads are still in flight, the loader then takes
+	  the result with takeDecoded(). Files without a decoder are taken from memory by read()
+*/
+
+class FileSystem
+{
+public:
+
+	static FileSystem* get();
+
+	// map a pack file. False if it does not exist or is broken
+	bool mount(const wchar_t* pack_file);
+	void unmountAll();
+
+	// read a file from the packs or from disk. False if it is found nowhere
+	bool read(const wchar_t* path, FileSpan& span);
+	// true if one of the mounted packs contains the file
+	bool isPacked(const wchar_t* path);
+	bool exists(const wchar_t* path);
+
+	unsigned int getMountCount();
+
+	// read loose files in one batch and keep them (or what their decoders made of them) until they are asked for.
+	// Packed files are skipped
+	void prefetch(const std::vector<PrefetchRequest>& requests);
+	// the decoded file, owned by the caller from now on. nullptr if it was not prefetched with a decoder
+	PrefetchedAsset* takeDecoded(const wchar_t* path);
+	// drop prefetched files that were never read
+	void clearPrefetched();
+	// queue depth and throughput of the last prefetch
+	AsyncReadStats getPrefetchStats();
+
+private:
+
+	FileSystem();
+	~FileSystem();
+
+	// the pack that serves a path (the one mounted last wins)
+	PackFile* findPack(const std::string& path, const PackFileEntry** entry);
+
+private:
+
+	std::vector<PackFile*> m_packs;
+
+	// normalized path -> bytes. Filled by the completion jobs of the prefetch
+	std::map<std::string, std::vector<unsigned char>> m_prefetched;
+	std::map<std::string, PrefetchedAsset*> m_decoded;
+	std::mutex m_prefetch_mutex;
+	AsyncReadStats m_prefetch_stats;
+};
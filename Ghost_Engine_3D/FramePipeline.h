@@ -0,0 +1,200 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "Profiler.h"
+
+struct FramePipelineStats
+{
+	unsigned long long m_produced = 0;
+	unsigned int m_in_flight = 0;			// snapshots produced and not released yet
+	double m_produce_wait_ms = 0.0;			// of the last frame: producer blocked by the latency limit (consumer is slower)
+	double m_consume_wait_ms = 0.0;			// of the last frame: consumer waited for a snapshot (producer is slower)
+};
+
+
+/*
+	FramePipeline: a producer thread fills snapshots of type T ahead of the consumer, which reads them in order
+
+	- the game thread produces frame N+1 while the render thread consumes frame N. A snapshot is not touched by the producer
+	  between publishing and release() -> the consumer reads it without locks
+	- max latency: how many snapshots the producer may be ahead of the one being consumed. 1 is double buffering,
+	  more smooths out uneven frames at the price of input lag. The slots are reused in a ring, T keeps its memory between frames
+	- waits are profiler markers ("Wait for Render" on the producer, "Wait for Frame" on the consumer) -> the stalls
+	  show up in the timeline next to the work
+*/
+
+template <class T>
+class FramePipeline
+{
+public:
+	static const unsigned int MAX_LATENCY = 3;
+
+public:
+
+	FramePipeline()
+	{
+	}
+
+	~FramePipeline()
+	{
+		stop();
+	}
+
+	// start the producer thread. produce(snapshot) is called for every frame until stop()
+	void start(const std::function<void(T& snapshot)>& produce, const char* thread_name)
+	{
+		stop();
+
+		m_produce = produce;
+		m_stop = false;
+		m_published = m_acquired = m_released = 0;
+		m_thread = std::thread([this, thread_name]()
+			{
+				Profiler::get()->setThreadName(thread_name);
+				producerLoop();
+			});
+	}
+
+	// finish the frame being produced and join the thread. Snapshots not consumed yet are dropped
+	void stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_changed.notify_all();
+
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+
+	bool isRunning()
+	{
+		return m_thread.joinable();
+	}
+
+	void setMaxLatency(unsigned int latency)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_max_latency = latency < 1 ? 1 : (latency > MAX_LATENCY ? MAX_LATENCY : latency);
+		}
+		m_changed.notify_all();
+	}
+
+	unsigned int getMaxLatency()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_max_latency;
+	}
+
+	// consumer: the next snapshot in order, waits until it is published. nullptr when the pipeline was stopped
+	const T* acquire()
+	{
+		ProfileMarker marker("Wait for Frame");
+		double begin = Profiler::get()->now();
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_changed.wait(lock, [this]() { return m_acquired < m_published || m_stop; });
+		m_stats.m_consume_wait_ms = Profiler::get()->now() - begin;
+
+		if (m_acquired == m_published)
+			return nullptr;
+
+		return &m_slots[m_acquired++ % (MAX_LATENCY + 1)];
+	}
+
+	// consumer: done with the snapshot of acquire(), the producer can reuse its slot
+	void release()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_released < m_acquired)
+				m_released++;
+		}
+		m_changed.notify_all();
+	}
+
+	FramePipelineStats getStats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		FramePipelineStats stats = m_stats;
+		stats.m_produced = m_published;
+		stats.m_in_flight = (unsigned int)(m_published - m_released);
+		return stats;
+	}
+
+private:
+
+	void producerLoop()
+	{
+		while (true)
+		{
+			{
+				ProfileMarker marker("Wait for Render");
+				double begin = Profiler::get()->now();
+
+				// the slot written next must not be one the consumer still reads
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_changed.wait(lock, [this]() { return m_published - m_released <= m_max_latency || m_stop; });
+				m_stats.m_produce_wait_ms = Profiler::get()->now() - begin;
+
+				if (m_stop)
+					return;
+			}
+
+			m_produce(m_slots[m_published % (MAX_LATENCY + 1)]);
+
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_published++;
+			}
+			m_changed.notify_all();
+		}
+	}
+
+private:
+
+	T m_slots[MAX_LATENCY + 1];
+	std::function<void(T&)> m_produce;
+	std::thread m_thread;
+	std::mutex m_mutex;
+	std::condition_variable m_changed;
+	bool m_stop = false;
+	unsigned int m_max_latency = 1;
+
+	// frame counters, the slot of a frame is counter % (MAX_LATENCY + 1)
+	unsigned long long m_published = 0;
+	unsigned long long m_acquired = 0;
+	unsigned long long m_released = 0;
+
+	FramePipelineStats m_stats;
+};
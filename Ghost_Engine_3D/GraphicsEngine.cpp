@@ -29,6 +29,7 @@
 #include "GraphicsEngine.h"
 #include "SwapChain.h"
 #include "DeviceContext.h"
+#include "CommandList.h"
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
 #include "ConstantBuffer.h"
@@ -104,6 +105,93 @@ GraphicsEngine::GraphicsEngine()
 	//instance of DeviceContext where we pass (immediate Context)-> m_imm_context of class ID3D11DeviceContext*
 	m_imm_device_context = new DeviceContext(m_imm_context);
 
+	/*
+		depth states: 0 is what the pipeline uses without a state (LESS, depth writes on), 1 is for the draws after a depth
+		pre-pass -> LESS_EQUAL lets the surface that wrote the depth pass again, nothing is written a second time.
+		2 tests like 0 without writing, for blended draws
+	*/
+	D3D11_DEPTH_STENCIL_DESC depth_desc = {};
+	depth_desc.DepthEnable = TRUE;
+	depth_desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
+	depth_desc.DepthFunc = D3D11_COMPARISON_LESS;
+	depth_desc.StencilEnable = FALSE;
+
+	if (FAILED(m_d3d_device->CreateDepthStencilState(&depth_desc, &m_depth_states[0])))
+	{
+		throw std::exception("Create Depth Stencil State was not successful");
+	}
+
+	depth_desc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+	depth_desc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+
+	if (FAILED(m_d3d_device->CreateDepthStencilState(&depth_desc, &m_depth_states[1])))
+	{
+		throw std::exception("Create Depth Stencil State was not successful");
+	}
+
+	depth_desc.DepthFunc = D3D11_COMPARISON_LESS;
+
+	if (FAILED(m_d3d_device->CreateDepthStencilState(&depth_desc, &m_depth_states[2])))
+	{
+		throw std::exception("Create Depth Stencil State was not successful");
+	}
+
+	/*
+		blend states: 0 writes the color like the pipeline without a state, 1 blends by the alpha of the pixel shader.
+		The alpha of the target keeps its value
+	*/
+	D3D11_BLEND_DESC blend_desc = {};
+	blend_desc.RenderTarget[0].BlendEnable = FALSE;
+	blend_desc.RenderTarget[0].SrcBlend = D3D11_BLEND_ONE;
+	blend_desc.RenderTarget[0].DestBlend = D3D11_BLEND_ZERO;
+	blend_desc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	blend_desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	blend_desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+	blend_desc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	blend_desc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+	if (FAILED(m_d3d_device->CreateBlendState(&blend_desc, &m_blend_states[0])))
+	{
+		throw std::exception("Create Blend State was not successful");
+	}
+
+	blend_desc.RenderTarget[0].BlendEnable = TRUE;
+	blend_desc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	blend_desc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	blend_desc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ZERO;
+	blend_desc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
+
+	if (FAILED(m_d3d_device->CreateBlendState(&blend_desc, &m_blend_states[1])))
+	{
+		throw std::exception("Create Blend State was not successful");
+	}
+
+	/*
+		shadow map sampler: compares the depth of the pixel with the shadow map (LESS_EQUAL -> 1 is lit) and filters the
+		results of the 4 texels. Outside of the map the border depth 1 -> lit
+	*/
+	D3D11_SAMPLER_DESC sampler_desc = {};
+	sampler_desc.Filter = D3D11_FILTER_COMPARISON_MIN_MAG_LINEAR_MIP_POINT;
+	sampler_desc.AddressU = D3D11_TEXTURE_ADDRESS_BORDER;
+	sampler_desc.AddressV = D3D11_TEXTURE_ADDRESS_BORDER;
+	sampler_desc.AddressW = D3D11_TEXTURE_ADDRESS_BORDER;
+	sampler_desc.ComparisonFunc = D3D11_COMPARISON_LESS_EQUAL;
+	sampler_desc.BorderColor[0] = sampler_desc.BorderColor[1] = sampler_desc.BorderColor[2] = sampler_desc.BorderColor[3] = 1.0f;
+	sampler_desc.MaxLOD = 0.0f;
+
+	if (FAILED(m_d3d_device->CreateSamplerState(&sampler_desc, &m_comparison_sampler)))
+	{
+		throw std::exception("Create Sampler State was not successful");
+	}
+
+	/*
+		DriverCommandLists: the driver builds command lists of deferred contexts itself. Without it (WARP, older drivers) D3D11
+		only emulates them -> CommandList uses its own command stream there
+	*/
+	D3D11_FEATURE_DATA_THREADING threading = {};
+	if (SUCCEEDED(m_d3d_device->CheckFeatureSupport(D3D11_FEATURE_THREADING, &threading, sizeof(threading))))
+		m_driver_command_lists = threading.DriverCommandLists == TRUE;
+
 	/*
 		 - To create a SwapChain -> call the dxgi factory, from which we call the SwapChain
 			1. m_d3d_device->QueryInterface -> return instance of IDXGIDevice class, which takes care  of low-level tasks
@@ -165,12 +253,17 @@ DeviceContext* GraphicsEngine::getImmediateDeviceContext()
 }
 
 
-VertexBuffer* GraphicsEngine::createVertexBuffer(void* list_vertices, UINT size_vertex, UINT size_list, void* shader_byte_code, size_t size_byte_shader)
+/*
+	- resources are constructed inside the typed pools -> GraphicsEngine hands out 32-bit handles instead of raw pointers
+	- when a constructor throws, the slot goes back to the pool and an invalid handle is returned
+*/
+
+VertexBufferHandle GraphicsEngine::createVertexBuffer(void* list_vertices, UINT size_vertex, UINT size_list, void* shader_byte_code, size_t size_byte_shader)
 {
-	VertexBuffer* vertex = nullptr;
+	VertexBufferHandle vertex;
 	try
 	{
-		vertex = new VertexBuffer(list_vertices, size_vertex, size_list, shader_byte_code, size_byte_shader);
+		vertex = m_vertex_buffers.create(list_vertices, size_vertex, size_list, shader_byte_code, size_byte_shader);
 	}
 	catch (...) {}
 
@@ -178,12 +271,39 @@ VertexBuffer* GraphicsEngine::createVertexBuffer(void* list_vertices, UINT size_
 }
 
 
-IndexBuffer * GraphicsEngine::createIndexBuffer(void* list_indices, UINT size_list)
+VertexBufferHandle GraphicsEngine::createVertexBuffer(void* list_vertices, const VertexFormat& format, UINT size_list, void* shader_byte_code, size_t size_byte_shader,
+	VertexStream stream)
+{
+	VertexBufferHandle vertex;
+	try
+	{
+		vertex = m_vertex_buffers.create(list_vertices, format, size_list, shader_byte_code, size_byte_shader, stream);
+	}
+	catch (...) {}
+
+	return vertex;
+}
+
+
+IndexBufferHandle GraphicsEngine::createIndexBuffer(void* list_indices, UINT size_list, DXGI_FORMAT format)
+{
+	IndexBufferHandle index;
+	try
+	{
+		index = m_index_buffers.create(list_indices, size_list, false, format);
+	}
+	catch (...) {}
+
+	return index;
+}
+
+
+IndexBufferHandle GraphicsEngine::createDynamicIndexBuffer(UINT size_list)
 {
-	IndexBuffer* index = nullptr;
+	IndexBufferHandle index;
 	try
 	{
-		index = new IndexBuffer(list_indices, size_list);
+		index = m_index_buffers.create(nullptr, size_list, true);
 	}
 	catch (...) {}
 
@@ -191,12 +311,12 @@ IndexBuffer * GraphicsEngine::createIndexBuffer(void* list_indices, UINT size_li
 }
 
 
-ConstantBuffer* GraphicsEngine::createConstantBuffer(void* buffer, UINT size_buffer)
+ConstantBufferHandle GraphicsEngine::createConstantBuffer(void* buffer, UINT size_buffer)
 {
-	ConstantBuffer* constant = nullptr;
+	ConstantBufferHandle constant;
 	try
 	{
-		constant = new ConstantBuffer(buffer, size_buffer);
+		constant = m_constant_buffers.create(buffer, size_buffer);
 	}
 	catch (...) {}
 
@@ -210,17 +330,36 @@ Input* GraphicsEngine::createInput()
 }
 
 
+CommandList* GraphicsEngine::createCommandList(bool recorded)
+{
+	CommandList* list = nullptr;
+	try
+	{
+		list = new CommandList(recorded || !m_driver_command_lists);
+	}
+	catch (...) {}
+
+	return list;
+}
+
+
+bool GraphicsEngine::hasDriverCommandLists()
+{
+	return m_driver_command_lists;
+}
+
+
 /*
-	- Create new instance of VertexShader class -> vertex
+	- Create new instance of VertexShader class in the pool -> vertex
 	- make Graphicsengine friend class in Vertex shader to call private method init
 */
 
-VertexShader* GraphicsEngine::createVertexShader(const void* shader_byte_code, size_t byte_code_size)
+VertexShaderHandle GraphicsEngine::createVertexShader(const void* shader_byte_code, size_t byte_code_size)
 {
-	VertexShader* vertex = nullptr;
+	VertexShaderHandle vertex;
 	try
 	{
-		vertex = new VertexShader(shader_byte_code, byte_code_size);
+		vertex = m_vertex_shaders.create(shader_byte_code, byte_code_size);
 	}
 	catch (...) {}
 
@@ -228,12 +367,12 @@ VertexShader* GraphicsEngine::createVertexShader(const void* shader_byte_code, s
 }
 
 
-PixelShader* GraphicsEngine::createPixelShader(const void * shader_byte_code, size_t byte_code_size)
+PixelShaderHandle GraphicsEngine::createPixelShader(const void * shader_byte_code, size_t byte_code_size)
 {
-	PixelShader* pixel = nullptr;
+	PixelShaderHandle pixel;
 	try
 	{
-		pixel = new PixelShader(shader_byte_code, byte_code_size);
+		pixel = m_pixel_shaders.create(shader_byte_code, byte_code_size);
 	}
 	catch (...) {}
 
@@ -241,12 +380,12 @@ PixelShader* GraphicsEngine::createPixelShader(const void * shader_byte_code, si
 }
 
 
-TextureShader* GraphicsEngine::createTextureShader(const wchar_t* file)
+TextureShaderHandle GraphicsEngine::createTextureShader(const wchar_t* file)
 {
-	TextureShader* texture = nullptr;
+	TextureShaderHandle texture;
 	try
 	{
-		texture = new TextureShader(file);
+		texture = m_texture_shaders.create(file);
 	}
 	catch (...) {}
 
@@ -254,18 +393,98 @@ TextureShader* GraphicsEngine::createTextureShader(const wchar_t* file)
 }
 
 
-MeshModel* GraphicsEngine::createMeshModel(const wchar_t* file)
+MeshModelHandle GraphicsEngine::createMeshModel(const wchar_t* file)
 {
-	MeshModel* mesh = nullptr;
+	MeshModelHandle mesh;
 	try
 	{
-		mesh = new MeshModel(file);
+		mesh = m_mesh_models.create(file);
+	}
+	catch (...) {}
+
+	return mesh;
+}
 
+
+RenderTargetHandle GraphicsEngine::createRenderTarget(UINT width, UINT height, DXGI_FORMAT format)
+{
+	RenderTargetHandle target;
+	try
+	{
+		target = m_render_targets.create(width, height, format);
 	}
 	catch (...) {}
 
+	return target;
+}
 
-	return mesh;
+
+StructuredBufferHandle GraphicsEngine::createStructuredBuffer(UINT size_element, UINT size_list)
+{
+	StructuredBufferHandle buffer;
+	try
+	{
+		buffer = m_structured_buffers.create(size_element, size_list);
+	}
+	catch (...) {}
+
+	return buffer;
+}
+
+
+TextureArrayHandle GraphicsEngine::createTextureArray(UINT width, UINT height, UINT slices, DXGI_FORMAT format)
+{
+	TextureArrayHandle texture;
+	try
+	{
+		texture = m_texture_arrays.create(width, height, slices, format);
+	}
+	catch (...) {}
+
+	return texture;
+}
+
+
+VertexBuffer* GraphicsEngine::get(VertexBufferHandle handle) { return m_vertex_buffers.get(handle); }
+IndexBuffer* GraphicsEngine::get(IndexBufferHandle handle) { return m_index_buffers.get(handle); }
+ConstantBuffer* GraphicsEngine::get(ConstantBufferHandle handle) { return m_constant_buffers.get(handle); }
+VertexShader* GraphicsEngine::get(VertexShaderHandle handle) { return m_vertex_shaders.get(handle); }
+PixelShader* GraphicsEngine::get(PixelShaderHandle handle) { return m_pixel_shaders.get(handle); }
+TextureShader* GraphicsEngine::get(TextureShaderHandle handle) { return m_texture_shaders.get(handle); }
+MeshModel* GraphicsEngine::get(MeshModelHandle handle) { return m_mesh_models.get(handle); }
+RenderTarget* GraphicsEngine::get(RenderTargetHandle handle) { return m_render_targets.get(handle); }
+StructuredBuffer* GraphicsEngine::get(StructuredBufferHandle handle) { return m_structured_buffers.get(handle); }
+TextureArray* GraphicsEngine::get(TextureArrayHandle handle) { return m_texture_arrays.get(handle); }
+
+void GraphicsEngine::release(VertexBufferHandle handle) { m_vertex_buffers.destroy(handle); }
+void GraphicsEngine::release(IndexBufferHandle handle) { m_index_buffers.destroy(handle); }
+void GraphicsEngine::release(ConstantBufferHandle handle) { m_constant_buffers.destroy(handle); }
+void GraphicsEngine::release(VertexShaderHandle handle) { m_vertex_shaders.destroy(handle); }
+void GraphicsEngine::release(PixelShaderHandle handle) { m_pixel_shaders.destroy(handle); }
+void GraphicsEngine::release(TextureShaderHandle handle) { m_texture_shaders.destroy(handle); }
+void GraphicsEngine::release(MeshModelHandle handle) { m_mesh_models.destroy(handle); }
+void GraphicsEngine::release(RenderTargetHandle handle) { m_render_targets.destroy(handle); }
+void GraphicsEngine::release(StructuredBufferHandle handle) { m_structured_buffers.destroy(handle); }
+void GraphicsEngine::release(TextureArrayHandle handle) { m_texture_arrays.destroy(handle); }
+
+
+/*
+	- deferred destruction: resources released during the frame are destroyed here, after the frame was submitted
+	- meshes are flushed first, because destroying a mesh releases its vertex and index buffer
+*/
+
+void GraphicsEngine::endFrame()
+{
+	m_mesh_models.flush();
+	m_texture_shaders.flush();
+	m_render_targets.flush();
+	m_structured_buffers.flush();
+	m_texture_arrays.flush();
+	m_vertex_buffers.flush();
+	m_index_buffers.flush();
+	m_constant_buffers.flush();
+	m_vertex_shaders.flush();
+	m_pixel_shaders.flush();
 }
 
 void GraphicsEngine::setMeshModel()
@@ -278,12 +497,17 @@ void GraphicsEngine::setMeshModel()
 	::memcpy(m_mesh_byte, shader_byte_code, size_shader);
 	m_mesh_size = size_shader;
 	GraphicsEngine::get()->releaseCompiledShader();
+
+	GraphicsEngine::get()->compileVertexShader(L"MeshModelShader.hlsl", "vsposition", &shader_byte_code, &size_shader);
+	::memcpy(m_position_byte, shader_byte_code, size_shader);
+	m_position_size = size_shader;
+	GraphicsEngine::get()->releaseCompiledShader();
 }
 
-void GraphicsEngine::getMeshModelShader(void** byte_code, size_t* size)
+void GraphicsEngine::getMeshModelShader(void** byte_code, size_t* size, bool position_only)
 {
-	*byte_code = m_mesh_byte;
-	*size = m_mesh_size;
+	*byte_code = position_only ? m_position_byte : m_mesh_byte;
+	*size = position_only ? m_position_size : m_mesh_size;
 }
 
 
@@ -340,6 +564,25 @@ void GraphicsEngine::releaseCompiledShader()
 
 GraphicsEngine::~GraphicsEngine()
 {
+	// destroy all pooled resources before the device goes away
+	m_mesh_models.clear();
+	m_texture_shaders.clear();
+	m_render_targets.clear();
+	m_structured_buffers.clear();
+	m_texture_arrays.clear();
+	m_vertex_buffers.clear();
+	m_index_buffers.clear();
+	m_constant_buffers.clear();
+	m_vertex_shaders.clear();
+	m_pixel_shaders.clear();
+
+	m_depth_states[0]->Release();
+	m_depth_states[1]->Release();
+	m_depth_states[2]->Release();
+	m_blend_states[0]->Release();
+	m_blend_states[1]->Release();
+	m_comparison_sampler->Release();
+
 	m_dxgi_device->Release();
 	m_dxgi_adapter->Release();
 	m_dxgi_factory->Release();
@@ -28,17 +28,33 @@
 
 #pragma once
 #include <d3d11.h>
+#include "ResourcePool.h"
+#include "VertexBuffer.h"
+#include "IndexBuffer.h"
+#include "ConstantBuffer.h"
+#include "VertexShader.h"
+#include "PixelShader.h"
+#include "TextureShader.h"
+#include "MeshModel.h"
+#include "RenderTarget.h"
+#include "StructuredBuffer.h"
+#include "TextureArray.h"
 
 class SwapChain;
 class DeviceContext;
-class VertexBuffer;
-class IndexBuffer;
-class ConstantBuffer;
-class VertexShader;
-class PixelShader;
+class CommandList;
 class Input;
-class TextureShader;
-class MeshModel;
+
+typedef ResourceHandle<VertexBuffer> VertexBufferHandle;
+typedef ResourceHandle<IndexBuffer> IndexBufferHandle;
+typedef ResourceHandle<ConstantBuffer> ConstantBufferHandle;
+typedef ResourceHandle<VertexShader> VertexShaderHandle;
+typedef ResourceHandle<PixelShader> PixelShaderHandle;
+typedef ResourceHandle<TextureShader> TextureShaderHandle;
+typedef ResourceHandle<MeshModel> MeshModelHandle;
+typedef ResourceHandle<RenderTarget> RenderTargetHandle;
+typedef ResourceHandle<StructuredBuffer> StructuredBufferHandle;
+typedef ResourceHandle<TextureArray> TextureArrayHandle;
 
 class GraphicsEngine
 {
@@ -56,14 +72,57 @@ public:
 
 	SwapChain* createSwapChain(HWND hwnd, UINT width, UINT height);
 	DeviceContext* getImmediateDeviceContext();
-	VertexBuffer* createVertexBuffer(void* list_vertices, UINT size_vertex, UINT size_list, void* shader_byte_code, size_t size_byte_shader);
-	IndexBuffer* createIndexBuffer(void* list_indices, UINT size_list);
-	ConstantBuffer* createConstantBuffer(void* buffer, UINT size_buffer);
-	VertexShader* createVertexShader(const void* shader_byte_code, size_t byte_code_size);
-	PixelShader* createPixelShader(const void* shader_byte_code, size_t byte_code_size);
 	Input* createInput();
-	TextureShader* createTextureShader(const wchar_t* file);
-	MeshModel* createMeshModel(const wchar_t* file);
+	// one list per recording thread. recorded: command stream in memory even when the driver has command lists
+	CommandList* createCommandList(bool recorded = false);
+	bool hasDriverCommandLists();
+
+	// resources live in the pools below. On failure an invalid handle is returned (handle.isValid() == false)
+	VertexBufferHandle createVertexBuffer(void* list_vertices, UINT size_vertex, UINT size_list, void* shader_byte_code, size_t size_byte_shader);
+	// vertices encoded by VertexPacker
+	VertexBufferHandle createVertexBuffer(void* list_vertices, const VertexFormat& format, UINT size_list, void* shader_byte_code, size_t size_byte_shader,
+		VertexStream stream = VertexStream::Interleaved);
+	IndexBufferHandle createIndexBuffer(void* list_indices, UINT size_list, DXGI_FORMAT format = DXGI_FORMAT_R32_UINT);
+	// index buffer the CPU rewrites every frame (IndexBuffer::update), for size_list indices at most
+	IndexBufferHandle createDynamicIndexBuffer(UINT size_list);
+	ConstantBufferHandle createConstantBuffer(void* buffer, UINT size_buffer);
+	VertexShaderHandle createVertexShader(const void* shader_byte_code, size_t byte_code_size);
+	PixelShaderHandle createPixelShader(const void* shader_byte_code, size_t byte_code_size);
+	TextureShaderHandle createTextureShader(const wchar_t* file);
+	MeshModelHandle createMeshModel(const wchar_t* file);
+	// color target, or depth target with DXGI_FORMAT_D32_FLOAT. Both can be read by shaders afterwards
+	RenderTargetHandle createRenderTarget(UINT width, UINT height, DXGI_FORMAT format);
+	// array of size_list structs of size_element bytes for the shaders, rewritten by the CPU (StructuredBuffer::update)
+	StructuredBufferHandle createStructuredBuffer(UINT size_element, UINT size_list);
+	// slices of one size and format the CPU replaces one by one (TextureArray::update)
+	TextureArrayHandle createTextureArray(UINT width, UINT height, UINT slices, DXGI_FORMAT format);
+
+	// resolve a handle. Returns nullptr when the handle is invalid or the resource was already destroyed
+	VertexBuffer* get(VertexBufferHandle handle);
+	IndexBuffer* get(IndexBufferHandle handle);
+	ConstantBuffer* get(ConstantBufferHandle handle);
+	VertexShader* get(VertexShaderHandle handle);
+	PixelShader* get(PixelShaderHandle handle);
+	TextureShader* get(TextureShaderHandle handle);
+	MeshModel* get(MeshModelHandle handle);
+	RenderTarget* get(RenderTargetHandle handle);
+	StructuredBuffer* get(StructuredBufferHandle handle);
+	TextureArray* get(TextureArrayHandle handle);
+
+	// mark a resource for destruction. It is destroyed in endFrame(), so it can still be used by the current frame
+	void release(VertexBufferHandle handle);
+	void release(IndexBufferHandle handle);
+	void release(ConstantBufferHandle handle);
+	void release(VertexShaderHandle handle);
+	void release(PixelShaderHandle handle);
+	void release(TextureShaderHandle handle);
+	void release(MeshModelHandle handle);
+	void release(RenderTargetHandle handle);
+	void release(StructuredBufferHandle handle);
+	void release(TextureArrayHandle handle);
+
+	// destroy the released resources. Call once per frame after present
+	void endFrame();
 
 	// ImGui
 	void InitGui(HWND hwnd);
@@ -71,7 +130,8 @@ public:
 public:
 
 	void setMeshModel();
-	void getMeshModelShader(void** byte_code, size_t* size);
+	// input signature for the vertex buffers of meshes. position_only: for VertexStream::Position buffers
+	void getMeshModelShader(void** byte_code, size_t* size, bool position_only = false);
 
 	bool compileVertexShader(const wchar_t* file_name, const char* entry_point_name, void** shader_byte_code, size_t* byte_code_size);
 	bool compilePixelShader(const wchar_t* file_name, const char* entry_point_name, void** shader_byte_code, size_t* byte_code_size);
@@ -101,6 +161,31 @@ private:
 
 	unsigned char m_mesh_byte[1024] = {0};
 	size_t m_mesh_size = 0;
+	unsigned char m_position_byte[1024] = {0};
+	size_t m_position_size = 0;
+
+	// DeviceContext::setDepthState, indexed by DepthState
+	ID3D11DepthStencilState* m_depth_states[3] = {};
+	// DeviceContext::setBlendState, indexed by BlendState
+	ID3D11BlendState* m_blend_states[2] = {};
+	// DeviceContext::setComparisonSampler
+	ID3D11SamplerState* m_comparison_sampler = nullptr;
+
+	bool m_driver_command_lists = false;
+
+private:
+
+	// MeshModel pool is declared last -> destroyed first, because meshes release their buffers
+	ResourcePool<VertexBuffer> m_vertex_buffers;
+	ResourcePool<IndexBuffer> m_index_buffers;
+	ResourcePool<ConstantBuffer> m_constant_buffers;
+	ResourcePool<VertexShader> m_vertex_shaders;
+	ResourcePool<PixelShader> m_pixel_shaders;
+	ResourcePool<TextureShader> m_texture_shaders;
+	ResourcePool<RenderTarget> m_render_targets;
+	ResourcePool<StructuredBuffer> m_structured_buffers;
+	ResourcePool<TextureArray> m_texture_arrays;
+	ResourcePool<MeshModel> m_mesh_models;
 
 private:
 
@@ -113,5 +198,10 @@ private:
 	friend class Input;
 	friend class TextureShader;
 	friend class MeshModel;
+	friend class DeviceContext;
+	friend class CommandList;
+	friend class RenderTarget;
+	friend class StructuredBuffer;
+	friend class TextureArray;
 };
 
@@ -28,18 +28,32 @@
 
 #include "IndexBuffer.h"
 #include "GraphicsEngine.h"
+#include "DeviceContext.h"
 
+#include <algorithm>
+#include <cstring>
 #include <exception>
 
-IndexBuffer::IndexBuffer(void* list_indices, UINT size_list) : m_buffer(0)
+/*
+	- a dynamic buffer lives in memory the CPU can write to (D3D11_USAGE_DYNAMIC) and is rewritten with Map(WRITE_DISCARD):
+	  the driver hands out fresh memory while the GPU may still read the old content
+	- 16-bit indices halve the memory and the index fetch bandwidth of meshes with at most 65536 vertices
+*/
+IndexBuffer::IndexBuffer(void* list_indices, UINT size_list, bool dynamic, DXGI_FORMAT format) : m_buffer(0), m_dynamic(dynamic), m_format(format)
 {
 	if (m_buffer)m_buffer->Release();
 
+	if (format != DXGI_FORMAT_R32_UINT && format != DXGI_FORMAT_R16_UINT)
+	{
+		throw std::exception("Index Buffer format has to be R32_UINT or R16_UINT");
+	}
+	m_index_size = (format == DXGI_FORMAT_R16_UINT) ? 2 : 4;
+
 	D3D11_BUFFER_DESC buff_desc = {};
-	buff_desc.Usage = D3D11_USAGE_DEFAULT;
-	buff_desc.ByteWidth = 4 * size_list;			// each elements 4 Bytes
+	buff_desc.Usage = dynamic ? D3D11_USAGE_DYNAMIC : D3D11_USAGE_DEFAULT;
+	buff_desc.ByteWidth = m_index_size * size_list;			// each elements 2 or 4 Bytes
 	buff_desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	buff_desc.CPUAccessFlags = 0;
+	buff_desc.CPUAccessFlags = dynamic ? D3D11_CPU_ACCESS_WRITE : 0;
 	buff_desc.MiscFlags = 0;
 
 	D3D11_SUBRESOURCE_DATA init_data = {};
@@ -47,19 +61,39 @@ IndexBuffer::IndexBuffer(void* list_indices, UINT size_list) : m_buffer(0)
 
 	m_size_list = size_list;
 
-	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateBuffer(&buff_desc, &init_data, &m_buffer)))
+	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateBuffer(&buff_desc, list_indices ? &init_data : nullptr, &m_buffer)))
 	{
 		throw std::exception("Create Index Buffer was not successful");
 	}
 }
 
 
+void IndexBuffer::update(DeviceContext* context, const void* list_indices, UINT size_list)
+{
+	if (!m_dynamic)
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->m_device_context->Map(m_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+
+	::memcpy(mapped.pData, list_indices, m_index_size * (size_t)std::min(size_list, m_size_list));
+	context->m_device_context->Unmap(m_buffer, 0);
+}
+
+
 UINT IndexBuffer::getSizeIndexList()
 {
 	return this->m_size_list;
 }
 
 
+DXGI_FORMAT IndexBuffer::getFormat()
+{
+	return this->m_format;
+}
+
+
 IndexBuffer::~IndexBuffer()
 {
 	m_buffer->Release();
@@ -35,14 +35,23 @@ class IndexBuffer
 {
 public:
 
-	IndexBuffer(void* list_indices, UINT size_list);
+	// dynamic: the CPU rewrites the indices every frame with update(), list_indices can be nullptr then
+	// format: DXGI_FORMAT_R32_UINT or DXGI_FORMAT_R16_UINT, list_indices holds elements of that size
+	IndexBuffer(void* list_indices, UINT size_list, bool dynamic = false, DXGI_FORMAT format = DXGI_FORMAT_R32_UINT);
 	~IndexBuffer();
 	UINT getSizeIndexList();
+	DXGI_FORMAT getFormat();
+
+	// dynamic buffers only: replace the content with size_list indices (at most the size of the buffer)
+	void update(DeviceContext* context, const void* list_indices, UINT size_list);
 
 private:
 
 	UINT m_size_list = 0;
 	ID3D11Buffer* m_buffer = nullptr;
+	bool m_dynamic = false;
+	DXGI_FORMAT m_format = DXGI_FORMAT_R32_UINT;
+	UINT m_index_size = 4;
 
 private:
 
@@ -25,6 +25,7 @@
 */
 
 #include "Input.h"
+#include "CollisionWorld.h"
 
 Input::Input()
 {
@@ -37,12 +38,14 @@ Input::Input()
 
 void Input::KeyDown(unsigned int value)
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	// when key is pressed -> position = 1
 	m_keys[value] = 1;
 }
 
 void Input::KeyUp(unsigned int value)
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	// when release -> position = 0
 	m_keys[value] = 0;
 }
@@ -50,6 +53,7 @@ void Input::KeyUp(unsigned int value)
 
 void Input::RMouseDown(int posX, int posY)
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	m_RMouseClicked = true;
 	m_lastMouseX = posX;
 	m_lastMouseY = posY;
@@ -57,6 +61,7 @@ void Input::RMouseDown(int posX, int posY)
 
 void Input::RMouseUp(int posX, int posY)
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	m_RMouseClicked = false;
 
 	m_moveMouseLeft = false;
@@ -68,6 +73,7 @@ void Input::RMouseUp(int posX, int posY)
 
 void Input::MouseMove(int posX, int posY)
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	if (m_RMouseClicked)
 	{
 
@@ -126,6 +132,9 @@ void Input::MouseLeave()
 // check if movement should be done
 void Input::Update(float time)
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Vector3D start(m_posX, m_posY, m_posZ);
+
 	ForwardMove(time);
 	BackwardMove(time);
 	HorizontalLeftMove(time);
@@ -136,17 +145,35 @@ void Input::Update(float time)
 	RightRotateMove(time);
 	UpRotateMove(time);
 	DownRotateMove(time);
+
+	// the move methods add up the movement of this frame, the sweep replaces it with what is free
+	if (m_collision)
+	{
+		Vector3D end = m_collision->moveSphere(start, Vector3D(m_posX, m_posY, m_posZ) - start, m_collision_radius);
+		m_posX = end.m_x;
+		m_posY = end.m_y;
+		m_posZ = end.m_z;
+	}
 }
 
 
 void Input::setTransform(float Transform[3])
 {
+	std::lock_guard<std::mutex> lock(m_mutex);
 	m_posX = Transform[0];
 	m_posY = Transform[1];
 	m_posZ = Transform[2];
 }
 
 
+void Input::setCollision(const CollisionWorld* world, float radius)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_collision = world;
+	m_collision_radius = radius;
+}
+
+
 void Input::ForwardMove(float time) 
 {
 	if (m_keys['W'] == 1)
@@ -413,12 +440,12 @@ void Input::DownRotateMove(float time)
 }
 
 
-float Input::getRotX() { return m_rotX; }
-float Input::getRotY() { return m_rotY; }
+float Input::getRotX() { std::lock_guard<std::mutex> lock(m_mutex); return m_rotX; }
+float Input::getRotY() { std::lock_guard<std::mutex> lock(m_mutex); return m_rotY; }
 
-float Input::getPosX() { return m_posX; }
-float Input::getPosY() { return m_posY; }
-float Input::getPosZ() { return m_posZ; }
+float Input::getPosX() { std::lock_guard<std::mutex> lock(m_mutex); return m_posX; }
+float Input::getPosY() { std::lock_guard<std::mutex> lock(m_mutex); return m_posY; }
+float Input::getPosZ() { std::lock_guard<std::mutex> lock(m_mutex); return m_posZ; }
 
 
 Input::~Input()
@@ -27,6 +27,16 @@
 #pragma once
 #include "Window.h"
 #include <math.h>
+#include <mutex>
+
+class CollisionWorld;
+
+/*
+	- the window thread writes the keys and the mouse, the game thread calls Update() and reads the camera -> every public
+	  method locks m_mutex. The move methods are called by Update() inside the lock
+	- collision: Update() moves the camera as a sphere through a CollisionWorld and slides along what is in the way.
+	  setTransform() places it without collision
+*/
 
 class Input
 {
@@ -44,6 +54,8 @@ public:
 
 	void Update(float time);
 	void setTransform(float Transform[3]);
+	// nullptr -> the camera flies through everything. The world is only read and must stay alive while it is set
+	void setCollision(const CollisionWorld* world, float radius);
 
 	// transform and rotation movement
 	void ForwardMove(float time);
@@ -66,6 +78,7 @@ public:
 
 private:
 
+	std::mutex m_mutex;
 	bool m_keys[256];
 
 	float acc = 0.03f;
@@ -94,6 +107,9 @@ private:
 	float m_rotY = 0.0f;
 	float m_rotZ = 0.0f;
 
+	const CollisionWorld* m_collision = nullptr;
+	float m_collision_radius = 0.25f;
+
 	// rotation speed
 	float m_rotLeftSpeed = 0.0f;
 	float m_rotRightSpeed = 0.0f;
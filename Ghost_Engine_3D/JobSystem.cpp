@@ -0,0 +1,192 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "JobSystem.h"
+
+
+JobSystem::JobSystem()
+{
+	unsigned int threads = std::thread::hardware_concurrency();
+	unsigned int workers = (threads > 1) ? threads - 1 : 1;
+
+	for (unsigned int i = 0; i < workers; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::workerLoop, this));
+	}
+}
+
+
+JobSystem* JobSystem::get()
+{
+	static JobSystem jobs;
+	return &jobs;
+}
+
+
+void JobSystem::execute(const std::function<void()>& job, JobCounter* counter)
+{
+	if (counter)
+		counter->m_count.fetch_add(1, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back(Job{ job, counter });
+	}
+	m_wake.notify_one();
+}
+
+
+void JobSystem::wait(JobCounter& counter)
+{
+	while (!counter.isDone())
+	{
+		// help the workers instead of sleeping. If the queue is empty the remaining jobs run on other threads
+		if (!runPendingJob())
+			std::this_thread::yield();
+	}
+
+	std::exception_ptr exception = counter.takeException();
+	if (exception)
+		std::rethrow_exception(exception);
+}
+
+
+/*
+	- group_size should be big enough that one group does some microseconds of work, otherwise the queue overhead dominates
+	- the last group of the calling thread is run directly without the queue. If it throws, the queued groups still
+	  reference job -> wait for them before the exception leaves
+*/
+
+void JobSystem::parallelFor(unsigned int count, unsigned int group_size, const std::function<void(unsigned int begin, unsigned int end)>& job)
+{
+	if (count == 0)
+		return;
+
+	if (group_size == 0)
+		group_size = 1;
+
+	JobCounter counter;
+	unsigned int begin = 0;
+
+	for (; begin + group_size < count; begin += group_size)
+	{
+		unsigned int end = begin + group_size;
+		execute([&job, begin, end]() { job(begin, end); }, &counter);
+	}
+
+	try
+	{
+		job(begin, count);
+	}
+	catch (...)
+	{
+		counter.setException(std::current_exception());
+	}
+
+	wait(counter);
+}
+
+
+unsigned int JobSystem::getThreadCount()
+{
+	return (unsigned int)m_workers.size() + 1;
+}
+
+
+void JobSystem::workerLoop()
+{
+	while (true)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+
+			if (m_queue.empty())
+				return;
+
+			job = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		runJob(job);
+	}
+}
+
+
+bool JobSystem::runPendingJob()
+{
+	Job job;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_queue.empty())
+			return false;
+
+		job = m_queue.front();
+		m_queue.pop_front();
+	}
+
+	runJob(job);
+	return true;
+}
+
+
+/*
+	the exception of a job with a counter goes to the counter, the job still counts as finished -> wait() returns.
+	A job without a counter has nobody to report to: its exception ends the program as on any other thread
+*/
+
+void JobSystem::runJob(Job& job)
+{
+	try
+	{
+		job.m_function();
+	}
+	catch (...)
+	{
+		if (!job.m_counter)
+			throw;
+		job.m_counter->setException(std::current_exception());
+	}
+
+	if (job.m_counter)
+		job.m_counter->m_count.fetch_sub(1, std::memory_order_release);
+}
+
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+}
@@ -0,0 +1,129 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	counts the jobs of one group that are not finished yet. Pass it to execute() and wait for it with wait()
+	- the first exception thrown by a job of the group is kept and rethrown by wait()
+*/
+
+class JobCounter
+{
+public:
+	JobCounter() :m_count(0)
+	{
+	}
+
+	bool isDone() const { return m_count.load(std::memory_order_acquire) == 0; }
+
+	// keeps the first exception of the group
+	void setException(std::exception_ptr exception)
+	{
+		std::lock_guard<std::mutex> lock(m_exception_mutex);
+		if (!m_exception)
+			m_exception = exception;
+	}
+
+	std::exception_ptr takeException()
+	{
+		std::lock_guard<std::mutex> lock(m_exception_mutex);
+		std::exception_ptr exception = m_exception;
+		m_exception = nullptr;
+		return exception;
+	}
+
+public:
+	std::atomic<int> m_count;
+
+private:
+	std::mutex m_exception_mutex;
+	std::exception_ptr m_exception;
+};
+
+
+/*
+	JobSystem: a pool of worker threads (one per core, minus the calling thread) with a shared job queue
+
+	- execute() pushes a job to the queue. Workers pick jobs in FIFO order
+	- wait() does not sleep while jobs are pending -> the waiting thread helps by running jobs of the queue itself.
+	  This makes nested parallelFor calls from inside a job safe
+	- JobSystem class is a Singleton like GraphicsEngine
+*/
+
+class JobSystem
+{
+public:
+
+	// start one worker per hardware thread minus one (the main thread also works while waiting)
+	JobSystem();
+	// finish the queued jobs and join the workers
+	~JobSystem();
+
+	static JobSystem* get();
+
+	// run a job on a worker thread. When a counter is given it is increased now and decreased when the job is finished
+	void execute(const std::function<void()>& job, JobCounter* counter = nullptr);
+
+	// wait until all jobs of the counter are finished, running queued jobs in the meantime. Then rethrows the first
+	// exception of its jobs
+	void wait(JobCounter& counter);
+
+	// split [0, count) in groups of group_size elements, run them in parallel and return when all groups are done.
+	// When a group throws the other groups still finish, then the first exception is rethrown
+	void parallelFor(unsigned int count, unsigned int group_size, const std::function<void(unsigned int begin, unsigned int end)>& job);
+
+	// number of threads that execute jobs (workers + calling thread)
+	unsigned int getThreadCount();
+
+private:
+
+	struct Job
+	{
+		std::function<void()> m_function;
+		JobCounter* m_counter = nullptr;
+	};
+
+	void workerLoop();
+	bool runPendingJob();
+	void runJob(Job& job);
+
+private:
+
+	std::vector<std::thread> m_workers;
+	std::deque<Job> m_queue;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_stop = false;
+};
@@ -0,0 +1,220 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "LZCompressor.h"
+#include <cstring>
+
+// format rules of LZ4: the last 5 bytes are always literals and the last match starts 12 bytes before the end
+static const size_t LZ_MIN_MATCH = 4;
+static const size_t LZ_LAST_LITERALS = 5;
+static const size_t LZ_MATCH_LIMIT = 12;
+static const size_t LZ_MAX_OFFSET = 65535;
+static const unsigned int LZ_HASH_BITS = 16;
+
+
+static unsigned int readU32(const unsigned char* p)
+{
+	unsigned int value;
+	::memcpy(&value, p, 4);
+	return value;
+}
+
+
+static unsigned int hashSequence(unsigned int sequence)
+{
+	return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+
+// length in the 4 bit field of the token, the rest as a run of 255 bytes
+static unsigned char* writeLength(unsigned char* out, size_t length)
+{
+	while (length >= 255)
+	{
+		*out++ = 255;
+		length -= 255;
+	}
+	*out++ = (unsigned char)length;
+	return out;
+}
+
+
+size_t LZCompressor::getMaxCompressedSize(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+
+size_t LZCompressor::compress(const unsigned char* data, size_t size, std::vector<unsigned char>& compressed)
+{
+	compressed.resize(getMaxCompressedSize(size));
+
+	unsigned char* out = compressed.data();
+	size_t anchor = 0;
+	size_t pos = 0;
+
+	if (size > LZ_MATCH_LIMIT)
+	{
+		std::vector<unsigned int> table((size_t)1 << LZ_HASH_BITS, 0);
+		size_t match_end = size - LZ_MATCH_LIMIT;
+		size_t limit = size - LZ_LAST_LITERALS;
+
+		while (pos < match_end)
+		{
+			unsigned int sequence = readU32(data + pos);
+			unsigned int hash = hashSequence(sequence);
+			size_t candidate = table[hash];
+			table[hash] = (unsigned int)pos;
+
+			if (candidate >= pos || pos - candidate > LZ_MAX_OFFSET || readU32(data + candidate) != sequence)
+			{
+				pos++;
+				continue;
+			}
+
+			// extend the match backwards over pending literals and forwards up to the limit
+			while (pos > anchor && candidate > 0 && data[pos - 1] == data[candidate - 1])
+			{
+				pos--;
+				candidate--;
+			}
+
+			size_t length = LZ_MIN_MATCH;
+			while (pos + length < limit && data[pos + length] == data[candidate + length])
+			{
+				length++;
+			}
+
+			size_t literals = pos - anchor;
+			unsigned char* token = out++;
+			*token = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+			if (literals >= 15)
+				out = writeLength(out, literals - 15);
+
+			::memcpy(out, data + anchor, literals);
+			out += literals;
+
+			size_t offset = pos - candidate;
+			*out++ = (unsigned char)(offset & 0xff);
+			*out++ = (unsigned char)(offset >> 8);
+
+			size_t extra = length - LZ_MIN_MATCH;
+			*token |= (unsigned char)(extra >= 15 ? 15 : extra);
+			if (extra >= 15)
+				out = writeLength(out, extra - 15);
+
+			pos += length;
+			anchor = pos;
+		}
+	}
+
+	// last sequence: literals only
+	size_t literals = size - anchor;
+	*out++ = (unsigned char)((literals >= 15 ? 15 : literals) << 4);
+	if (literals >= 15)
+		out = writeLength(out, literals - 15);
+
+	::memcpy(out, data + anchor, literals);
+	out += literals;
+
+	size_t compressed_size = out - compressed.data();
+	compressed.resize(compressed_size);
+	return compressed_size;
+}
+
+
+bool LZCompressor::decompress(const unsigned char* compressed, size_t compressed_size, unsigned char* data, size_t original_size)
+{
+	const unsigned char* in = compressed;
+	const unsigned char* in_end = compressed + compressed_size;
+	unsigned char* out = data;
+	unsigned char* out_end = data + original_size;
+
+	while (in < in_end)
+	{
+		unsigned char token = *in++;
+
+		size_t literals = token >> 4;
+		if (literals == 15)
+		{
+			unsigned char byte;
+			do
+			{
+				if (in >= in_end)
+					return false;
+				byte = *in++;
+				literals += byte;
+			} while (byte == 255);
+		}
+
+		if (literals > (size_t)(in_end - in) || literals > (size_t)(out_end - out))
+			return false;
+
+		::memcpy(out, in, literals);
+		in += literals;
+		out += literals;
+
+		// the last sequence has no match
+		if (in == in_end)
+			break;
+
+		if (in_end - in < 2)
+			return false;
+
+		size_t offset = in[0] | (in[1] << 8);
+		in += 2;
+
+		if (offset == 0 || offset > (size_t)(out - data))
+			return false;
+
+		size_t length = token & 15;
+		if (length == 15)
+		{
+			unsigned char byte;
+			do
+			{
+				if (in >= in_end)
+					return false;
+				byte = *in++;
+				length += byte;
+			} while (byte == 255);
+		}
+		length += LZ_MIN_MATCH;
+
+		if (length > (size_t)(out_end - out))
+			return false;
+
+		// byte wise copy: source and destination may overlap (offset < length repeats a pattern)
+		const unsigned char* match = out - offset;
+		for (size_t i = 0; i < length; i++)
+		{
+			out[i] = match[i];
+		}
+		out += length;
+	}
+
+	return out == out_end;
+}
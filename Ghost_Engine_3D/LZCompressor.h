@@ -0,0 +1,52 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/*
+	LZCompressor: byte oriented LZ77 in the LZ4 block format
+
+	- sequence = token (4 bit literal length | 4 bit match length - 4), literals, 16 bit offset, extra length bytes
+	- no entropy coding: decompression is a few hundred MB/s to GB/s per core, fast enough to not slow down
+	  a memory mapped read
+	- the compressor uses a single hash table of 4 byte sequences (greedy matching)
+*/
+
+class LZCompressor
+{
+public:
+
+	// worst case size of the compressed data (incompressible input)
+	static size_t getMaxCompressedSize(size_t size);
+
+	// returns the compressed size (0 on failure). compressed is resized to fit
+	static size_t compress(const unsigned char* data, size_t size, std::vector<unsigned char>& compressed);
+
+	// decompress exactly original_size bytes. False on corrupt input, never reads or writes out of bounds
+	static bool decompress(const unsigned char* compressed, size_t compressed_size, unsigned char* data, size_t original_size);
+};
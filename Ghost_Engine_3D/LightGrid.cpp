@@ -0,0 +1,321 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "LightGrid.h"
+#include "JobSystem.h"
+
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+
+LightGrid::LightGrid()
+{
+	m_box_min.resize(LIGHT_GRID_CLUSTERS * 3);
+	m_box_max.resize(LIGHT_GRID_CLUSTERS * 3);
+	m_slice_depth.resize(LIGHT_GRID_SLICES + 1);
+	m_slice_lights.resize(LIGHT_GRID_SLICES);
+	m_slice_overflow.resize(LIGHT_GRID_SLICES);
+	m_cluster_lights.resize((size_t)LIGHT_GRID_CLUSTERS * MAX_LIGHTS_PER_CLUSTER);
+	m_cluster_counts.resize(LIGHT_GRID_CLUSTERS);
+}
+
+
+/*
+	- scales and planes of the projection: x_ndc = x * x_scale / z, near = -m32 / m22, far = m32 / (1 - m22)
+	- a tile spans [x0, x1] in ndc -> in view space x0 * z / x_scale ... at every depth z of the slice. The box takes
+	  the corners at the near and the far depth of the slice
+*/
+
+void LightGrid::setProjection(const Matrix4x4& proj)
+{
+	float x_scale = proj.m_mat[0][0];
+	float y_scale = proj.m_mat[1][1];
+	float z_near = -proj.m_mat[3][2] / proj.m_mat[2][2];
+	float z_far = proj.m_mat[3][2] / (1.0f - proj.m_mat[2][2]);
+
+	if (x_scale == m_x_scale && y_scale == m_y_scale && z_near == m_near && z_far == m_far)
+		return;
+
+	m_x_scale = x_scale;
+	m_y_scale = y_scale;
+	m_near = z_near;
+	m_far = z_far;
+
+	for (unsigned int slice = 0; slice <= LIGHT_GRID_SLICES; slice++)
+		m_slice_depth[slice] = m_near * powf(m_far / m_near, (float)slice / LIGHT_GRID_SLICES);
+
+	for (unsigned int slice = 0; slice < LIGHT_GRID_SLICES; slice++)
+	{
+		float depths[2] = { m_slice_depth[slice], m_slice_depth[slice + 1] };
+		for (unsigned int y = 0; y < LIGHT_GRID_Y; y++)
+		{
+			// tile rows from the top of the screen
+			float ndc_y[2] = { 1.0f - 2.0f * (y + 1) / LIGHT_GRID_Y, 1.0f - 2.0f * y / LIGHT_GRID_Y };
+			for (unsigned int x = 0; x < LIGHT_GRID_X; x++)
+			{
+				float ndc_x[2] = { -1.0f + 2.0f * x / LIGHT_GRID_X, -1.0f + 2.0f * (x + 1) / LIGHT_GRID_X };
+				unsigned int cluster = (slice * LIGHT_GRID_Y + y) * LIGHT_GRID_X + x;
+				float* box_min = &m_box_min[cluster * 3];
+				float* box_max = &m_box_max[cluster * 3];
+
+				box_min[0] = box_min[1] = FLT_MAX;
+				box_max[0] = box_max[1] = -FLT_MAX;
+				for (float depth : depths)
+				{
+					for (int i = 0; i < 2; i++)
+					{
+						box_min[0] = std::min(box_min[0], ndc_x[i] * depth / m_x_scale);
+						box_max[0] = std::max(box_max[0], ndc_x[i] * depth / m_x_scale);
+						box_min[1] = std::min(box_min[1], ndc_y[i] * depth / m_y_scale);
+						box_max[1] = std::max(box_max[1], ndc_y[i] * depth / m_y_scale);
+					}
+				}
+				box_min[2] = depths[0];
+				box_max[2] = depths[1];
+			}
+		}
+	}
+}
+
+
+void LightGrid::build(const std::vector<PointLight>& lights, const Matrix4x4& view, const Matrix4x4& proj, UINT width, UINT height, LightGridData& data)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	setProjection(proj);
+	data.m_stats = LightGridStats();
+
+	// lights to view space (row vectors: p * view)
+	unsigned int count = (unsigned int)std::min(lights.size(), (size_t)MAX_LIGHTS);
+	m_light_x.resize(count);
+	m_light_y.resize(count);
+	m_light_z.resize(count);
+	m_light_radius.resize(count);
+	m_light_direction.resize(count);
+	m_light_cos.resize(count);
+	m_light_sin.resize(count);
+	data.m_lights.resize(count);
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const PointLight& light = lights[i];
+		const Vector3D& p = light.m_position;
+		const Vector3D& d = light.m_direction;
+
+		m_light_x[i] = p.m_x * view.m_mat[0][0] + p.m_y * view.m_mat[1][0] + p.m_z * view.m_mat[2][0] + view.m_mat[3][0];
+		m_light_y[i] = p.m_x * view.m_mat[0][1] + p.m_y * view.m_mat[1][1] + p.m_z * view.m_mat[2][1] + view.m_mat[3][1];
+		m_light_z[i] = p.m_x * view.m_mat[0][2] + p.m_y * view.m_mat[1][2] + p.m_z * view.m_mat[2][2] + view.m_mat[3][2];
+		m_light_radius[i] = light.m_radius;
+		m_light_direction[i] = Vector3D(
+			d.m_x * view.m_mat[0][0] + d.m_y * view.m_mat[1][0] + d.m_z * view.m_mat[2][0],
+			d.m_x * view.m_mat[0][1] + d.m_y * view.m_mat[1][1] + d.m_z * view.m_mat[2][1],
+			d.m_x * view.m_mat[0][2] + d.m_y * view.m_mat[1][2] + d.m_z * view.m_mat[2][2]);
+		m_light_cos[i] = light.m_spot_cos_outer;
+		m_light_sin[i] = sqrtf(std::max(1.0f - light.m_spot_cos_outer * light.m_spot_cos_outer, 0.0f));
+
+		ShaderLight& shader_light = data.m_lights[i];
+		shader_light.m_position[0] = p.m_x;
+		shader_light.m_position[1] = p.m_y;
+		shader_light.m_position[2] = p.m_z;
+		shader_light.m_radius = light.m_radius;
+		shader_light.m_color[0] = light.m_color.m_x;
+		shader_light.m_color[1] = light.m_color.m_y;
+		shader_light.m_color[2] = light.m_color.m_z;
+		shader_light.m_spot_cos_outer = light.m_spot_cos_outer;
+		shader_light.m_direction[0] = d.m_x;
+		shader_light.m_direction[1] = d.m_y;
+		shader_light.m_direction[2] = d.m_z;
+		shader_light.m_spot_cos_inner = light.m_spot_cos_inner;
+	}
+
+	// every light to the slices its depth range touches
+	float log_range = logf(m_far / m_near);
+	auto sliceOf = [&](float depth)
+	{
+		int slice = (int)(logf(depth / m_near) / log_range * LIGHT_GRID_SLICES);
+		return (unsigned int)std::min(std::max(slice, 0), (int)LIGHT_GRID_SLICES - 1);
+	};
+
+	for (std::vector<unsigned int>& slice_lights : m_slice_lights)
+		slice_lights.clear();
+
+	for (unsigned int i = 0; i < count; i++)
+	{
+		float z_min = m_light_z[i] - m_light_radius[i];
+		float z_max = m_light_z[i] + m_light_radius[i];
+		if (z_max < m_near || z_min > m_far)
+			continue;
+
+		unsigned int first = sliceOf(std::max(z_min, m_near));
+		unsigned int last = sliceOf(std::min(z_max, m_far));
+		for (unsigned int slice = first; slice <= last; slice++)
+			m_slice_lights[slice].push_back(i);
+	}
+
+	JobSystem::get()->parallelFor(LIGHT_GRID_SLICES, 1, [this](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int slice = begin; slice < end; slice++)
+				cullSlice(slice);
+		});
+
+	// pack the clusters into one index list
+	unsigned int total = 0;
+	for (unsigned int cluster = 0; cluster < LIGHT_GRID_CLUSTERS; cluster++)
+		total += m_cluster_counts[cluster];
+
+	data.m_clusters.resize(LIGHT_GRID_CLUSTERS);
+	data.m_indices.resize(std::min(total, MAX_LIGHT_INDICES));
+
+	std::vector<char> visible(count, 0);
+	unsigned int offset = 0;
+	for (unsigned int cluster = 0; cluster < LIGHT_GRID_CLUSTERS; cluster++)
+	{
+		unsigned int cluster_count = m_cluster_counts[cluster];
+		unsigned int taken = std::min(cluster_count, MAX_LIGHT_INDICES - offset);
+		const unsigned short* cluster_lights = &m_cluster_lights[(size_t)cluster * MAX_LIGHTS_PER_CLUSTER];
+
+		for (unsigned int i = 0; i < taken; i++)
+		{
+			data.m_indices[offset + i] = cluster_lights[i];
+			visible[cluster_lights[i]] = 1;
+		}
+
+		data.m_clusters[cluster].m_offset = offset;
+		data.m_clusters[cluster].m_count = taken;
+		offset += taken;
+
+		data.m_stats.m_max_per_cluster = std::max(data.m_stats.m_max_per_cluster, cluster_count);
+		data.m_stats.m_overflow += cluster_count - taken;
+	}
+
+	for (unsigned int overflow : m_slice_overflow)
+		data.m_stats.m_overflow += overflow;
+
+	data.m_stats.m_lights = count;
+	data.m_stats.m_visible_lights = (unsigned int)std::count(visible.begin(), visible.end(), 1);
+	data.m_stats.m_references = offset;
+
+	ClusterConstantType& constants = data.m_constants;
+	constants.m_grid[0] = LIGHT_GRID_X;
+	constants.m_grid[1] = LIGHT_GRID_Y;
+	constants.m_grid[2] = LIGHT_GRID_SLICES;
+	constants.m_light_count = count;
+	constants.m_tile_size[0] = (float)std::max(width, 1u) / LIGHT_GRID_X;
+	constants.m_tile_size[1] = (float)std::max(height, 1u) / LIGHT_GRID_Y;
+	constants.m_slice_scale = LIGHT_GRID_SLICES / log_range;
+	constants.m_slice_bias = -(float)LIGHT_GRID_SLICES * logf(m_near) / log_range;
+
+	data.m_stats.m_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+/*
+	- the candidates of the slice go to SoA arrays, padded to four with lights no box can touch (negative squared radius)
+	- sphere - box: squared distance of the center to the box, per axis max(min - c, c - max, 0)
+	- spot lights: cone against the sphere around the box. Outside when the sphere is beyond the side of the cone,
+	  in front of its range or behind its apex
+*/
+
+void LightGrid::cullSlice(unsigned int slice)
+{
+	const std::vector<unsigned int>& candidates = m_slice_lights[slice];
+	unsigned int count = (unsigned int)candidates.size();
+	unsigned int padded = (count + 3) & ~3u;
+
+	alignas(16) float light_x[MAX_LIGHTS];
+	alignas(16) float light_y[MAX_LIGHTS];
+	alignas(16) float light_z[MAX_LIGHTS];
+	alignas(16) float light_radius2[MAX_LIGHTS];
+	for (unsigned int i = 0; i < padded; i++)
+	{
+		unsigned int light = i < count ? candidates[i] : 0;
+		light_x[i] = i < count ? m_light_x[light] : 0.0f;
+		light_y[i] = i < count ? m_light_y[light] : 0.0f;
+		light_z[i] = i < count ? m_light_z[light] : 0.0f;
+		light_radius2[i] = i < count ? m_light_radius[light] * m_light_radius[light] : -1.0f;
+	}
+
+	unsigned int overflow = 0;
+	const __m128 zero = _mm_setzero_ps();
+	for (unsigned int y = 0; y < LIGHT_GRID_Y; y++)
+	{
+		for (unsigned int x = 0; x < LIGHT_GRID_X; x++)
+		{
+			unsigned int cluster = (slice * LIGHT_GRID_Y + y) * LIGHT_GRID_X + x;
+			const float* box_min = &m_box_min[cluster * 3];
+			const float* box_max = &m_box_max[cluster * 3];
+			__m128 min_x = _mm_set1_ps(box_min[0]), min_y = _mm_set1_ps(box_min[1]), min_z = _mm_set1_ps(box_min[2]);
+			__m128 max_x = _mm_set1_ps(box_max[0]), max_y = _mm_set1_ps(box_max[1]), max_z = _mm_set1_ps(box_max[2]);
+
+			Vector3D center((box_min[0] + box_max[0]) * 0.5f, (box_min[1] + box_max[1]) * 0.5f, (box_min[2] + box_max[2]) * 0.5f);
+			float sphere_radius = (Vector3D(box_max[0], box_max[1], box_max[2]) - center).length();
+
+			unsigned short* cluster_lights = &m_cluster_lights[(size_t)cluster * MAX_LIGHTS_PER_CLUSTER];
+			unsigned int cluster_count = 0;
+
+			for (unsigned int i = 0; i < padded; i += 4)
+			{
+				__m128 lx = _mm_load_ps(light_x + i);
+				__m128 ly = _mm_load_ps(light_y + i);
+				__m128 lz = _mm_load_ps(light_z + i);
+				__m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_x, lx), _mm_sub_ps(lx, max_x)), zero);
+				__m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_y, ly), _mm_sub_ps(ly, max_y)), zero);
+				__m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(min_z, lz), _mm_sub_ps(lz, max_z)), zero);
+				__m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+				int mask = _mm_movemask_ps(_mm_cmple_ps(distance2, _mm_load_ps(light_radius2 + i)));
+				for (int k = 0; mask; k++, mask >>= 1)
+				{
+					if (!(mask & 1))
+						continue;
+
+					unsigned int light = candidates[i + k];
+					if (m_light_cos[light] > -1.0f)
+					{
+						Vector3D to_center = center - Vector3D(m_light_x[light], m_light_y[light], m_light_z[light]);
+						float length2 = Vector3D::dot(to_center, to_center);
+						float along = Vector3D::dot(to_center, m_light_direction[light]);
+						float side = m_light_cos[light] * sqrtf(std::max(length2 - along * along, 0.0f)) - along * m_light_sin[light];
+						if (side > sphere_radius || along > sphere_radius + m_light_radius[light] || along < -sphere_radius)
+							continue;
+					}
+
+					if (cluster_count < MAX_LIGHTS_PER_CLUSTER)
+						cluster_lights[cluster_count++] = (unsigned short)light;
+					else
+						overflow++;
+				}
+			}
+
+			m_cluster_counts[cluster] = cluster_count;
+		}
+	}
+
+	m_slice_overflow[slice] = overflow;
+}
@@ -0,0 +1,142 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Matrix4x4.h"
+#include "ConstantBuffer.h"
+#include <vector>
+
+// a light of the scene in world space. Point light: m_spot_cos_outer = -1
+struct PointLight
+{
+	Vector3D m_position;
+	float m_radius = 1.0f;					// no light beyond it
+	Vector3D m_color = Vector3D(1.0f, 1.0f, 1.0f);	// times intensity
+	Vector3D m_direction = Vector3D(0.0f, -1.0f, 0.0f);
+	float m_spot_cos_outer = -1.0f;			// cos of the half angle of the cone, the light ends there
+	float m_spot_cos_inner = -1.0f;			// full light inside
+};
+
+// LightGridData::m_lights, StructuredBuffer<Light> in PixelShader.hlsl
+struct ShaderLight
+{
+	float m_position[3];
+	float m_radius;
+	float m_color[3];
+	float m_spot_cos_outer;
+	float m_direction[3];
+	float m_spot_cos_inner;
+};
+
+// range of a cluster in LightGridData::m_indices
+struct LightCluster
+{
+	unsigned int m_offset;
+	unsigned int m_count;
+};
+
+struct LightGridStats
+{
+	unsigned int m_lights = 0;
+	unsigned int m_visible_lights = 0;		// in at least one cluster
+	unsigned int m_references = 0;			// entries of the index list
+	unsigned int m_max_per_cluster = 0;
+	unsigned int m_overflow = 0;			// references dropped: cluster or index list full
+	double m_milliseconds = 0.0;
+};
+
+// result of LightGrid::build: what the pixel shader reads
+struct LightGridData
+{
+	std::vector<ShaderLight> m_lights;
+	std::vector<LightCluster> m_clusters;	// x fastest, then y, then the slice
+	std::vector<unsigned int> m_indices;
+	ClusterConstantType m_constants;
+	LightGridStats m_stats;
+};
+
+
+/*
+	LightGrid: clustered light culling on the CPU
+
+	- the view frustum is split into LIGHT_GRID_X * LIGHT_GRID_Y tiles on screen and LIGHT_GRID_SLICES depth slices.
+	  The slices are exponential in view depth, so clusters far away are not much longer than they are wide
+	- every cluster keeps a view space box, built again only when the projection changes
+	- build(): the lights go to view space in SoA arrays of four. One job per slice takes the lights in the depth range
+	  of the slice and tests four lights at once against the box of each tile (sphere - box with SSE). Spot lights
+	  that pass are tested with their cone against the sphere around the box
+	- the per cluster lists are then packed into one index list: the pixel shader finds its cluster by pixel position
+	  and view depth and only loops over the lights of it
+*/
+
+class LightGrid
+{
+public:
+
+	static const unsigned int LIGHT_GRID_X = 16;
+	static const unsigned int LIGHT_GRID_Y = 9;
+	static const unsigned int LIGHT_GRID_SLICES = 24;
+	static const unsigned int LIGHT_GRID_CLUSTERS = LIGHT_GRID_X * LIGHT_GRID_Y * LIGHT_GRID_SLICES;
+	static const unsigned int MAX_LIGHTS = 1024;
+	static const unsigned int MAX_LIGHTS_PER_CLUSTER = 128;
+	static const unsigned int MAX_LIGHT_INDICES = 1 << 17;
+
+	LightGrid();
+
+	// lights beyond MAX_LIGHTS are ignored. view and proj: row vector matrices of the camera (perspective LH),
+	// width and height of the screen in pixels
+	void build(const std::vector<PointLight>& lights, const Matrix4x4& view, const Matrix4x4& proj, UINT width, UINT height, LightGridData& data);
+
+private:
+
+	void setProjection(const Matrix4x4& proj);
+	void cullSlice(unsigned int slice);
+
+private:
+
+	// projection the cluster boxes were built for
+	float m_x_scale = 0.0f;
+	float m_y_scale = 0.0f;
+	float m_near = 0.0f;
+	float m_far = 0.0f;
+	std::vector<float> m_box_min;			// 3 floats per cluster
+	std::vector<float> m_box_max;
+	std::vector<float> m_slice_depth;		// LIGHT_GRID_SLICES + 1 borders
+
+	// view space lights of the current build
+	std::vector<float> m_light_x;
+	std::vector<float> m_light_y;
+	std::vector<float> m_light_z;
+	std::vector<float> m_light_radius;
+	std::vector<Vector3D> m_light_direction;
+	std::vector<float> m_light_cos;			// spot cone, -1 for point lights
+	std::vector<float> m_light_sin;
+
+	std::vector<std::vector<unsigned int>> m_slice_lights;	// lights in the depth range of a slice, per slice
+	std::vector<unsigned short> m_cluster_lights;			// MAX_LIGHTS_PER_CLUSTER per cluster
+	std::vector<unsigned int> m_cluster_counts;
+	std::vector<unsigned int> m_slice_overflow;
+};
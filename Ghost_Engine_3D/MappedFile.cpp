@@ -0,0 +1,127 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "MappedFile.h"
+
+
+MappedFile::MappedFile()
+{
+}
+
+
+/*
+	CreateFileMapping + MapViewOfFile map the file into the address space of the process.
+	FILE_FLAG_SEQUENTIAL_SCAN tells the cache manager to read ahead
+*/
+
+bool MappedFile::open(const wchar_t* file)
+{
+	close();
+
+	m_file = ::CreateFileW(file, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size = {};
+	if (!::GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	m_mapping = ::CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping)
+	{
+		close();
+		return false;
+	}
+
+	m_data = (const unsigned char*)::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!m_data)
+	{
+		close();
+		return false;
+	}
+
+	m_size = (size_t)size.QuadPart;
+	return true;
+}
+
+
+void MappedFile::close()
+{
+	if (m_data) ::UnmapViewOfFile(m_data);
+	if (m_mapping) ::CloseHandle(m_mapping);
+	if (m_file != INVALID_HANDLE_VALUE) ::CloseHandle(m_file);
+
+	m_data = nullptr;
+	m_mapping = nullptr;
+	m_file = INVALID_HANDLE_VALUE;
+	m_size = 0;
+}
+
+
+const unsigned char* MappedFile::getData()
+{
+	return m_data;
+}
+
+
+size_t MappedFile::getSize()
+{
+	return m_size;
+}
+
+
+bool MappedFile::getWriteTime(const wchar_t* file, FILETIME* time)
+{
+	WIN32_FILE_ATTRIBUTE_DATA data = {};
+	if (!::GetFileAttributesExW(file, GetFileExInfoStandard, &data))
+		return false;
+
+	*time = data.ftLastWriteTime;
+	return true;
+}
+
+
+bool MappedFile::isUpToDate(const wchar_t* cooked_file, const wchar_t* source_file)
+{
+	FILETIME cooked_time = {};
+	if (!getWriteTime(cooked_file, &cooked_time))
+		return false;
+
+	FILETIME source_time = {};
+	if (!getWriteTime(source_file, &source_time))
+		return true;
+
+	return ::CompareFileTime(&cooked_time, &source_time) >= 0;
+}
+
+
+MappedFile::~MappedFile()
+{
+	close();
+}
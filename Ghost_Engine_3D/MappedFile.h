@@ -0,0 +1,64 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <Windows.h>
+
+/*
+	MappedFile: read only memory mapping of a whole file
+
+	- the OS pages the file in on first access, there is no copy into a separate buffer
+	- the view stays valid until the MappedFile is closed or destroyed
+*/
+
+class MappedFile
+{
+public:
+
+	MappedFile();
+	// unmap and close the file
+	~MappedFile();
+
+	// map the whole file. Returns false if it does not exist or is empty
+	bool open(const wchar_t* file);
+	void close();
+
+	const unsigned char* getData();
+	size_t getSize();
+
+	// last write time of a file, false if the file does not exist
+	static bool getWriteTime(const wchar_t* file, FILETIME* time);
+
+	// true when the cooked file exists and is not older than the source (a missing source counts as older)
+	static bool isUpToDate(const wchar_t* cooked_file, const wchar_t* source_file);
+
+private:
+
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = nullptr;
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+};
@@ -0,0 +1,300 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "MeshFile.h"
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+
+MeshFile::MeshFile()
+{
+}
+
+
+bool MeshFile::write(const std::vector<VertexMesh>& vertices, const std::vector<unsigned int>& indices, const std::vector<MeshFileLod>& lods,
+	const std::vector<MeshFileMeshlet>& meshlets, const wchar_t* file, const VertexFormat& format, VertexPackReport* report,
+	const std::vector<MeshFileMaterial>& materials, const std::vector<unsigned short>& vertex_materials)
+{
+	std::vector<MeshFileLod> levels = lods;
+	if (levels.empty())
+	{
+		MeshFileLod lod;
+		lod.m_index_count = (unsigned int)indices.size();
+		lod.m_vertex_count = (unsigned int)vertices.size();
+		levels.push_back(lod);
+	}
+
+	if (levels.size() > MESH_FILE_MAX_LODS)
+		return false;
+
+	if (!materials.empty() && vertex_materials.size() != vertices.size())
+		return false;
+
+	MeshFileHeader header = {};
+	header.m_magic = MESH_FILE_MAGIC;
+	header.m_version = MESH_FILE_VERSION;
+	header.m_vertex_count = (unsigned int)vertices.size();
+	header.m_index_count = (unsigned int)indices.size();
+	header.m_vertex_stride = format.getStride();
+	header.m_vertex_format = format.getKey();
+	header.m_lod_count = (unsigned int)levels.size();
+	header.m_lod_offset = sizeof(MeshFileHeader);
+	header.m_meshlet_count = (unsigned int)meshlets.size();
+	header.m_meshlet_offset = header.m_lod_offset + (unsigned int)(sizeof(MeshFileLod) * levels.size());
+	header.m_material_count = (unsigned int)materials.size();
+	header.m_material_offset = header.m_meshlet_offset + (unsigned int)(sizeof(MeshFileMeshlet) * meshlets.size());
+	header.m_vertex_material_offset = header.m_material_offset + (unsigned int)(sizeof(MeshFileMaterial) * materials.size());
+	size_t vertex_material_bytes = materials.empty() ? 0 : sizeof(unsigned short) * vertices.size();
+	header.m_vertex_offset = alignUp(header.m_vertex_material_offset + vertex_material_bytes, MESH_FILE_ALIGNMENT);
+	header.m_index_offset = alignUp((size_t)header.m_vertex_offset + (size_t)header.m_vertex_stride * vertices.size(), MESH_FILE_ALIGNMENT);
+
+	Vector3D center;
+	computeBounds(vertices.data(), vertices.size(), center, header.m_radius);
+	header.m_center[0] = center.m_x;
+	header.m_center[1] = center.m_y;
+	header.m_center[2] = center.m_z;
+
+	header.m_quantization = VertexPacker::computeQuantization(vertices.data(), vertices.size(), format);
+
+	std::vector<unsigned char> packed;
+	VertexPackReport pack_report;
+	VertexPacker::encode(vertices.data(), vertices.size(), format, header.m_quantization, packed, &pack_report);
+	header.m_position_error = pack_report.m_position_error;
+	header.m_texcoord_error = pack_report.m_texcoord_error;
+	header.m_normal_error = pack_report.m_normal_error;
+	if (report)
+		*report = pack_report;
+
+	size_t size = alignUp((size_t)header.m_index_offset + sizeof(unsigned int) * indices.size(), MESH_FILE_ALIGNMENT);
+
+	std::vector<unsigned char> data(size, 0);
+	::memcpy(&data[0], &header, sizeof(header));
+	::memcpy(&data[header.m_lod_offset], levels.data(), sizeof(MeshFileLod) * levels.size());
+	if (!meshlets.empty())
+		::memcpy(&data[header.m_meshlet_offset], meshlets.data(), sizeof(MeshFileMeshlet) * meshlets.size());
+	if (!materials.empty())
+	{
+		::memcpy(&data[header.m_material_offset], materials.data(), sizeof(MeshFileMaterial) * materials.size());
+		::memcpy(&data[header.m_vertex_material_offset], vertex_materials.data(), vertex_material_bytes);
+	}
+	if (!packed.empty())
+		::memcpy(&data[(size_t)header.m_vertex_offset], packed.data(), packed.size());
+	if (!indices.empty())
+		::memcpy(&data[(size_t)header.m_index_offset], indices.data(), sizeof(unsigned int) * indices.size());
+
+	std::wstring temp = std::wstring(file) + L".tmp";
+
+	HANDLE handle = ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	DWORD written = 0;
+	BOOL ok = ::WriteFile(handle, data.data(), (DWORD)data.size(), &written, nullptr);
+	::CloseHandle(handle);
+
+	if (!ok || written != data.size())
+	{
+		::DeleteFileW(temp.c_str());
+		return false;
+	}
+
+	return ::MoveFileExW(temp.c_str(), file, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+
+/*
+	validate everything that is later used as offset or size -> a broken file is rejected instead of read out of bounds
+*/
+
+bool MeshFile::open(const unsigned char* data, size_t size)
+{
+	m_data = nullptr;
+	m_size = 0;
+	m_header = nullptr;
+
+	if (size < sizeof(MeshFileHeader))
+		return false;
+
+	const MeshFileHeader* header = (const MeshFileHeader*)data;
+	if (header->m_magic != MESH_FILE_MAGIC || header->m_version != MESH_FILE_VERSION)
+		return false;
+
+	VertexFormat format;
+	if (!VertexFormat::fromKey(header->m_vertex_format, format) || header->m_vertex_stride != format.getStride())
+		return false;
+
+	if (header->m_vertex_offset > size || (size - (size_t)header->m_vertex_offset) / header->m_vertex_stride < header->m_vertex_count)
+		return false;
+
+	if (header->m_index_offset > size || (size - (size_t)header->m_index_offset) / sizeof(unsigned int) < header->m_index_count)
+		return false;
+
+	if (header->m_lod_count == 0 || header->m_lod_count > MESH_FILE_MAX_LODS || header->m_lod_offset > size ||
+		(size - header->m_lod_offset) / sizeof(MeshFileLod) < header->m_lod_count)
+		return false;
+
+	if (header->m_meshlet_offset > size || (size - header->m_meshlet_offset) / sizeof(MeshFileMeshlet) < header->m_meshlet_count)
+		return false;
+
+	if (header->m_material_offset > size || (size - header->m_material_offset) / sizeof(MeshFileMaterial) < header->m_material_count)
+		return false;
+
+	// the strings must end inside their arrays, every vertex must name a material of the table
+	const MeshFileMaterial* materials = (const MeshFileMaterial*)(data + header->m_material_offset);
+	for (unsigned int i = 0; i < header->m_material_count; i++)
+	{
+		if (!memchr(materials[i].m_name, 0, sizeof(materials[i].m_name)) || !memchr(materials[i].m_texture, 0, sizeof(materials[i].m_texture)))
+			return false;
+	}
+
+	if (header->m_material_count)
+	{
+		if (header->m_vertex_material_offset > size || (size - header->m_vertex_material_offset) / sizeof(unsigned short) < header->m_vertex_count)
+			return false;
+
+		const unsigned short* vertex_materials = (const unsigned short*)(data + header->m_vertex_material_offset);
+		for (unsigned int i = 0; i < header->m_vertex_count; i++)
+		{
+			if (vertex_materials[i] >= header->m_material_count)
+				return false;
+		}
+	}
+
+	const MeshFileLod* lods = (const MeshFileLod*)(data + header->m_lod_offset);
+	for (unsigned int i = 0; i < header->m_lod_count; i++)
+	{
+		if (lods[i].m_index_start > header->m_index_count || header->m_index_count - lods[i].m_index_start < lods[i].m_index_count)
+			return false;
+
+		if (lods[i].m_meshlet_start > header->m_meshlet_count || header->m_meshlet_count - lods[i].m_meshlet_start < lods[i].m_meshlet_count)
+			return false;
+	}
+
+	const MeshFileMeshlet* meshlets = (const MeshFileMeshlet*)(data + header->m_meshlet_offset);
+	for (unsigned int i = 0; i < header->m_meshlet_count; i++)
+	{
+		if (meshlets[i].m_index_start > header->m_index_count || (header->m_index_count - meshlets[i].m_index_start) / 3 < meshlets[i].m_triangle_count)
+			return false;
+	}
+
+	// every index must address a vertex
+	const unsigned int* indices = (const unsigned int*)(data + header->m_index_offset);
+	for (unsigned int i = 0; i < header->m_index_count; i++)
+	{
+		if (indices[i] >= header->m_vertex_count)
+			return false;
+	}
+
+	m_data = data;
+	m_size = size;
+	m_header = header;
+	m_vertex_format = format;
+	return true;
+}
+
+
+const MeshFileHeader& MeshFile::getHeader()
+{
+	return *m_header;
+}
+
+
+const VertexFormat& MeshFile::getVertexFormat()
+{
+	return m_vertex_format;
+}
+
+
+const unsigned char* MeshFile::getVertexData()
+{
+	return m_data + m_header->m_vertex_offset;
+}
+
+
+const unsigned int* MeshFile::getIndices()
+{
+	return (const unsigned int*)(m_data + m_header->m_index_offset);
+}
+
+
+const MeshFileLod* MeshFile::getLods()
+{
+	return (const MeshFileLod*)(m_data + m_header->m_lod_offset);
+}
+
+
+const MeshFileMeshlet* MeshFile::getMeshlets()
+{
+	return (const MeshFileMeshlet*)(m_data + m_header->m_meshlet_offset);
+}
+
+
+const MeshFileMaterial* MeshFile::getMaterials()
+{
+	return (const MeshFileMaterial*)(m_data + m_header->m_material_offset);
+}
+
+
+const unsigned short* MeshFile::getVertexMaterials()
+{
+	return m_header->m_material_count ? (const unsigned short*)(m_data + m_header->m_vertex_material_offset) : nullptr;
+}
+
+
+void MeshFile::computeBounds(const VertexMesh* vertices, size_t count, Vector3D& center, float& radius)
+{
+	center = Vector3D();
+	radius = 0.0f;
+	if (count == 0)
+		return;
+
+	Vector3D min = vertices[0].m_Pos, max = vertices[0].m_Pos;
+	for (size_t i = 1; i < count; i++)
+	{
+		const Vector3D& pos = vertices[i].m_Pos;
+		min = Vector3D(std::min(min.m_x, pos.m_x), std::min(min.m_y, pos.m_y), std::min(min.m_z, pos.m_z));
+		max = Vector3D(std::max(max.m_x, pos.m_x), std::max(max.m_y, pos.m_y), std::max(max.m_z, pos.m_z));
+	}
+
+	center = (min + max) * 0.5f;
+	for (size_t i = 0; i < count; i++)
+	{
+		radius = std::max(radius, (vertices[i].m_Pos - center).length());
+	}
+}
+
+
+std::wstring MeshFile::getCookedPath(const wchar_t* source_file)
+{
+	return std::wstring(source_file) + L".gmesh";
+}
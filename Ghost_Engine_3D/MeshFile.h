@@ -0,0 +1,160 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "VertexMesh.h"
+#include "VertexPacker.h"
+#include <string>
+#include <vector>
+
+/*
+	Cooked mesh container (.gmesh)
+
+		MeshFileHeader          144 bytes
+		MeshFileLod[lods]       detail levels, finest first
+		MeshFileMeshlet[meshlets]
+		MeshFileMaterial[materials]
+		unsigned short[vertices]   material of every vertex, only when there are materials
+		padding                 -> vertices start 16 byte aligned
+		vertices                m_vertex_stride bytes each, in the format m_vertex_format (see VertexPacker)
+		padding                 -> indices start 16 byte aligned
+		unsigned int[indices]   index lists of all levels, one after the other
+
+	- vertices and indices are stored exactly as the vertex and index buffer expect them -> a mapped file (or a
+	  span of a pack) is passed to the buffers without parsing
+	- all levels share the vertices, a level is a range of the indices (see MeshSimplifier)
+	- the triangles of a level are sorted by meshlet, a meshlet is a range of the indices of its level (see MeshletBuilder)
+	- every vertex belongs to one material (see ObjImporter). The texture coordinates of a material in a texture atlas
+	  are already moved into its region of the atlas (see TextureAtlas)
+	- all values are little endian
+*/
+
+static const unsigned int MESH_FILE_MAGIC = 0x48534D47;		// "GMSH"
+static const unsigned int MESH_FILE_VERSION = 5;
+static const unsigned int MESH_FILE_ALIGNMENT = 16;
+static const unsigned int MESH_FILE_MAX_LODS = 8;
+
+struct MeshFileLod
+{
+	unsigned int m_index_start = 0;
+	unsigned int m_index_count = 0;
+	unsigned int m_vertex_count = 0;	// vertices the level references
+	float m_error = 0.0f;				// largest distance to the surface of level 0, in object space
+	unsigned int m_meshlet_start = 0;
+	unsigned int m_meshlet_count = 0;
+};
+
+// small cluster of triangles with the bounds to cull it on its own
+struct MeshFileMeshlet
+{
+	unsigned int m_index_start = 0;
+	unsigned int m_triangle_count = 0;
+	float m_center[3] = {};				// bounding sphere, object space
+	float m_radius = 0.0f;
+	float m_cone_axis[3] = {};			// normal cone: all triangles face away from a camera for which
+	float m_cone_cutoff = 1.0f;			// dot(center - camera, axis) >= cutoff * |center - camera| + radius
+};
+
+// the texture a material is drawn with
+struct MeshFileMaterial
+{
+	char m_name[64] = {};				// name in the .mtl, zero terminated
+	char m_texture[188] = {};			// UTF-8 path relative to the working directory, zero terminated. Empty without a texture
+	unsigned int m_atlas = 0;			// 1: m_texture is a texture atlas of the AssetCooker (no source, only the cooked file)
+};
+
+struct MeshFileHeader
+{
+	unsigned int m_magic;
+	unsigned int m_version;
+	unsigned int m_vertex_count;
+	unsigned int m_index_count;		// of all levels
+	unsigned int m_vertex_stride;	// VertexFormat::getStride()
+	unsigned int m_flags;
+	unsigned int m_lod_count;
+	unsigned int m_lod_offset;
+	unsigned int m_meshlet_count;
+	unsigned int m_meshlet_offset;
+	unsigned long long m_vertex_offset;
+	unsigned long long m_index_offset;
+	float m_center[3];				// bounding sphere of the vertices
+	float m_radius;
+	unsigned int m_vertex_format;	// VertexFormat::getKey()
+	VertexQuantization m_quantization;
+	float m_position_error;			// of the vertex format, see VertexPackReport
+	float m_texcoord_error;
+	float m_normal_error;
+	unsigned int m_material_count;
+	unsigned int m_material_offset;
+	unsigned int m_vertex_material_offset;
+	unsigned int m_reserved;
+};
+
+
+class MeshFile
+{
+public:
+
+	MeshFile();
+
+	/*
+		write a cooked mesh (through a temporary file, so a crash never leaves half a file)
+		- lods: ranges of indices, finest first. Empty -> one level with all indices
+		- meshlets: ranges of indices inside the levels, can be empty
+		- format: the vertices are encoded into it, report gets the sizes and the precision lost
+		- materials and the material of every vertex, both empty for a mesh without materials
+	*/
+	static bool write(const std::vector<VertexMesh>& vertices, const std::vector<unsigned int>& indices, const std::vector<MeshFileLod>& lods,
+		const std::vector<MeshFileMeshlet>& meshlets, const wchar_t* file, const VertexFormat& format = VertexFormat(), VertexPackReport* report = nullptr,
+		const std::vector<MeshFileMaterial>& materials = std::vector<MeshFileMaterial>(), const std::vector<unsigned short>& vertex_materials = std::vector<unsigned short>());
+
+	// read the container from memory (mapped file or a span of a pack). The memory must stay valid while it is used
+	bool open(const unsigned char* data, size_t size);
+
+	const MeshFileHeader& getHeader();
+	const VertexFormat& getVertexFormat();
+	// m_vertex_count * m_vertex_stride bytes, the data of the vertex buffer
+	const unsigned char* getVertexData();
+	const unsigned int* getIndices();
+	const MeshFileLod* getLods();
+	const MeshFileMeshlet* getMeshlets();
+	const MeshFileMaterial* getMaterials();
+	// m_vertex_count entries, nullptr when the mesh has no materials
+	const unsigned short* getVertexMaterials();
+
+	// sphere around the center of the bounding box: not the smallest one, but cheap and good enough to pick a level
+	static void computeBounds(const VertexMesh* vertices, size_t count, Vector3D& center, float& radius);
+
+	// path of the cooked file of a source mesh
+	static std::wstring getCookedPath(const wchar_t* source_file);
+
+private:
+
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+	const MeshFileHeader* m_header = nullptr;
+	VertexFormat m_vertex_format;
+};
@@ -28,125 +28,396 @@
 #include "MeshModel.h"
 #include "GraphicsEngine.h"
 #include "VertexMesh.h"
-#include <locale>
-#include <codecvt>
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-
+#include "FileSystem.h"
+#include "MeshFile.h"
+#include "ObjImporter.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+
+#include <Windows.h>
+#include <algorithm>
 #include <exception>
 
 /*
-	with the help of https://github.com/tinyobjloader/tinyobjloader
-	- parsing of polygons. embedding .obj files to Engine
-*/
-
-/*
-	Explanation( Everything is based on polygons ):  with the help of https://www.tutorialfor.com/questions-104539.htm
-		obj file contains vertices coordinaes (vx, vy, vz), Normal (nx, ny, nz) and Texture coordinates (tx, ty)
+	- prefer the cooked file (.gmesh) when it is not older than the source (or inside a pack): vertices and indices
+	  go straight from the mapping into the buffers
+	- otherwise parse the .obj, build the detail levels and their meshlets and write the cooked file for the next start
+	- a mesh decoded by a prefetch completion job only gets its buffers
 */
 MeshModel::MeshModel(const wchar_t* file)
 {
-	
-	tinyobj::attrib_t attrib;
+	std::wstring load_path = getLoadPath(file);
 
-	// pass vector of shapes/formes 
-	std::vector<tinyobj::shape_t> shape;
+	PrefetchedAsset* asset = FileSystem::get()->takeDecoded(load_path.c_str());
+	MeshData* prefetched = dynamic_cast<MeshData*>(asset);
+	if (prefetched)
+	{
+		create(*prefetched);
+		delete asset;
+		return;
+	}
+	delete asset;
 
-	// vector of materials
-	std::vector<tinyobj::material_t> material;
+	FileSpan span;
+	MeshData data;
+	if (!FileSystem::get()->read(load_path.c_str(), span) || !decode(file, load_path, span.getData(), span.getSize(), data))
+	{
+		// a broken cooked file is cooked again from the source
+		if (load_path == file || !FileSystem::get()->read(file, span) || !decode(file, file, span.getData(), span.getSize(), data))
+		{
+			throw std::exception("Loading Mesh Resources was not successful");
+		}
+	}
+	span.reset();
 
-	std::string warning;
-	std::string error;
+	create(data);
+}
 
-	// no unicode file path -> convert unicode into AscII path with wstring_converter 
-	std::string input = std::wstring_convert<std::codecvt_utf8<wchar_t>>().to_bytes(file);
 
+PrefetchRequest MeshModel::getPrefetchRequest(const wchar_t* file)
+{
+	PrefetchRequest request;
+	request.m_path = getLoadPath(file);
 
-	bool res = tinyobj::LoadObj(&attrib, &shape, &material, &warning, &error, input.c_str());
+	std::wstring source = file;
+	std::wstring load_path = request.m_path;
+	request.m_decoder = [source, load_path](const std::wstring& path, std::vector<unsigned char>& bytes) -> PrefetchedAsset*
+		{
+			MeshData* data = new MeshData();
+			if (!decode(source.c_str(), load_path, bytes.data(), bytes.size(), *data))
+			{
+				delete data;
+				return nullptr;
+			}
 
-	if ((error.empty() && res))
-	{
-		std::vector<VertexMesh> verticeList;
-		std::vector<unsigned int> indiceList;
+			return data;
+		};
 
+	return request;
+}
 
 
-		for (size_t i = 0; i < shape.size(); i++)
+bool MeshModel::decode(const wchar_t* file, const std::wstring& load_path, const unsigned char* bytes, size_t size, MeshData& data)
+{
+	if (load_path != file)
+	{
+		MeshFile mesh;
+		if (!mesh.open(bytes, size))
+			return false;
+
+		const MeshFileHeader& header = mesh.getHeader();
+		data.m_lods.assign(mesh.getLods(), mesh.getLods() + header.m_lod_count);
+		data.m_meshlets.assign(mesh.getMeshlets(), mesh.getMeshlets() + header.m_meshlet_count);
+		data.m_indices.assign(mesh.getIndices(), mesh.getIndices() + header.m_index_count);
+		data.m_center = Vector3D(header.m_center[0], header.m_center[1], header.m_center[2]);
+		data.m_radius = header.m_radius;
+		data.m_atlas_texture = getAtlasTexture(mesh);
+
+		data.m_report.m_vertices = header.m_vertex_count;
+		data.m_report.m_float_bytes = header.m_vertex_count * (unsigned int)sizeof(VertexMesh);
+		data.m_report.m_packed_bytes = header.m_vertex_count * header.m_vertex_stride;
+		data.m_report.m_position_error = header.m_position_error;
+		data.m_report.m_texcoord_error = header.m_texcoord_error;
+		data.m_report.m_normal_error = header.m_normal_error;
+
+		// the GPU gets the packed vertices as they are, the CPU copies are decoded
+		if (mesh.getVertexFormat().isPacked())
+		{
+			data.m_format = mesh.getVertexFormat();
+			data.m_quantization = header.m_quantization;
+			data.m_packed_vertices.assign(mesh.getVertexData(), mesh.getVertexData() + (size_t)header.m_vertex_count * header.m_vertex_stride);
+			VertexPacker::decode(mesh.getVertexData(), header.m_vertex_count, mesh.getVertexFormat(), header.m_quantization, data.m_vertices);
+		}
+		else
 		{
-			size_t indexPosition = 0;
-			verticeList.reserve(shape[i].mesh.indices.size());
-			indiceList.reserve(shape[i].mesh.indices.size());
+			const VertexMesh* vertices = (const VertexMesh*)mesh.getVertexData();
+			data.m_vertices.assign(vertices, vertices + header.m_vertex_count);
+		}
+		return true;
+	}
 
+	std::vector<unsigned int> indices;
+	if (!ObjImporter::load(file, bytes, size, data.m_vertices, indices))
+		return false;
 
-			for (size_t j = 0; j < shape[i].mesh.num_face_vertices.size(); j++)
-			{
-				// each face -> number of vertices 
-				 int verticeNumber = shape[i].mesh.num_face_vertices[j];
+	MeshSimplifier::buildLods(data.m_vertices, indices, MeshLodSettings(), data.m_indices, data.m_lods);
+	MeshletBuilder::buildLods(data.m_vertices, data.m_indices, data.m_lods, data.m_meshlets);
+	MeshFile::computeBounds(data.m_vertices.data(), data.m_vertices.size(), data.m_center, data.m_radius);
+
+	// a packed source has no place on disk for a cooked file next to it
+	if (!FileSystem::get()->isPacked(file))
+	{
+		MeshFile::write(data.m_vertices, data.m_indices, data.m_lods, data.m_meshlets, MeshFile::getCookedPath(file).c_str(), VertexFormat(), &data.m_report);
+	}
+	else
+	{
+		data.m_report.m_vertices = (unsigned int)data.m_vertices.size();
+		data.m_report.m_float_bytes = data.m_report.m_packed_bytes = (unsigned int)(data.m_vertices.size() * sizeof(VertexMesh));
+	}
+	return true;
+}
 
-				for (size_t k = 0; k < verticeNumber; k++)
-				{
-					tinyobj::index_t idx = shape[i].mesh.indices[indexPosition + k];
 
-					// vertices coordinates
-					tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
-					tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
-					tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
+void MeshModel::create(MeshData& data)
+{
+	m_lods.swap(data.m_lods);
+	m_meshlets.swap(data.m_meshlets);
+	m_indices.swap(data.m_indices);
+	m_center = data.m_center;
+	m_radius = data.m_radius;
+	m_atlas_texture = data.m_atlas_texture;
+	m_vertex_report = data.m_report;
+
+	if (data.m_format.isPacked())
+	{
+		createBuffers(data.m_vertices.data(), (unsigned int)data.m_vertices.size(), m_indices.data(), (unsigned int)m_indices.size(), data.m_format,
+			data.m_packed_vertices.data(), data.m_quantization);
+	}
+	else
+	{
+		createBuffers(data.m_vertices.data(), (unsigned int)data.m_vertices.size(), m_indices.data(), (unsigned int)m_indices.size());
+	}
+}
 
-					// vertex normal
-					tinyobj::real_t nx = attrib.normals[3 * idx.normal_index + 0];
-					tinyobj::real_t ny = attrib.normals[3 * idx.normal_index + 1];
-					tinyobj::real_t nz = attrib.normals[3 * idx.normal_index + 2];
 
-					
-					// texture coordinates
-					tinyobj::real_t tx = attrib.texcoords[2 * idx.texcoord_index + 0];
-					tinyobj::real_t ty = attrib.texcoords[2 * idx.texcoord_index + 1];
+/*
+	the mesh has one atlas when every material with a texture is drawn from the same atlas. With textures that stay out
+	(they repeat) or more than one atlas the materials need binds of their own
+*/
 
-					// VertexMesh(position, texcoord, normal)
-					VertexMesh V(Vector3D(vx, vy, vz), Vector2D(tx, ty), Vector3D(nx, ny, nz));
-					// add to the Vector list
-					verticeList.push_back(V);
+std::wstring MeshModel::getAtlasTexture(MeshFile& mesh)
+{
+	std::string atlas;
 
-					indiceList.push_back((unsigned int)indexPosition + k);
+	for (unsigned int i = 0; i < mesh.getHeader().m_material_count; i++)
+	{
+		const MeshFileMaterial& material = mesh.getMaterials()[i];
+		if (!material.m_texture[0])
+			continue;
 
-				}
+		if (!material.m_atlas || (!atlas.empty() && atlas != material.m_texture))
+			return std::wstring();
 
-				indexPosition += verticeNumber;
-			}
-		}
+		atlas = material.m_texture;
+	}
 
-		void* shader_byte_code = nullptr;
-		size_t size_shader = 0;
-		GraphicsEngine::get()->getMeshModelShader(&shader_byte_code, &size_shader);
+	if (atlas.empty())
+		return std::wstring();
 
-		v_Buffer = GraphicsEngine::get()->createVertexBuffer(&verticeList[0], sizeof(VertexMesh), (UINT)verticeList.size(), shader_byte_code, (UINT)size_shader);
+	int size = ::MultiByteToWideChar(CP_UTF8, 0, atlas.data(), (int)atlas.size(), nullptr, 0);
+	std::wstring result(size, 0);
+	::MultiByteToWideChar(CP_UTF8, 0, atlas.data(), (int)atlas.size(), &result[0], size);
+	return result;
+}
 
 
-		i_Buffer = GraphicsEngine::get()->createIndexBuffer(&indiceList[0], (UINT)indiceList.size());
+std::wstring MeshModel::getLoadPath(const wchar_t* file)
+{
+	std::wstring cooked = MeshFile::getCookedPath(file);
+
+	if (FileSystem::get()->isPacked(cooked.c_str()) || MappedFile::isUpToDate(cooked.c_str(), file))
+		return cooked;
+
+	return file;
+}
+
+
+void MeshModel::createBuffers(const VertexMesh* vertices, unsigned int vertex_count, const unsigned int* indices, unsigned int index_count,
+	const VertexFormat& format, const void* packed_vertices, const VertexQuantization& quantization)
+{
+	m_vertices.assign(vertices, vertices + vertex_count);
+	m_positions.resize(vertex_count);
+	for (unsigned int i = 0; i < vertex_count; i++)
+	{
+		m_positions[i] = vertices[i].m_Pos;
+
+		const Vector3D& p = m_positions[i];
+		m_box_min = (i == 0) ? p : Vector3D(std::min(m_box_min.m_x, p.m_x), std::min(m_box_min.m_y, p.m_y), std::min(m_box_min.m_z, p.m_z));
+		m_box_max = (i == 0) ? p : Vector3D(std::max(m_box_max.m_x, p.m_x), std::max(m_box_max.m_y, p.m_y), std::max(m_box_max.m_z, p.m_z));
 	}
 
-	else
+	// float vertices are split like packed ones, their format is the identity
+	std::vector<unsigned char> float_vertices;
+	VertexQuantization ranges = quantization;
+	m_vertex_format = format;
+	if (!packed_vertices || !format.isPacked())
+	{
+		m_vertex_format = VertexFormat();
+		ranges = VertexQuantization();
+		VertexPacker::encode(vertices, vertex_count, m_vertex_format, ranges, float_vertices);
+		packed_vertices = float_vertices.data();
+	}
+
+	/*
+		- two streams: a position only pass (depth, shadow) fetches getPositionStride() bytes per vertex instead of the
+		  whole vertex, the full pass binds both
+		- the constant buffer with the ranges exists for every format, so position only shaders can always apply it
+	*/
+	std::vector<unsigned char> positions, attributes;
+	VertexPacker::split((const unsigned char*)packed_vertices, vertex_count, m_vertex_format, positions, attributes);
+
+	void* shader_byte_code = nullptr;
+	size_t size_shader = 0;
+
+	// the buffers copy the data at creation, the pointers are never written through
+	GraphicsEngine::get()->getMeshModelShader(&shader_byte_code, &size_shader, true);
+	m_position_stream = GraphicsEngine::get()->createVertexBuffer(positions.data(), m_vertex_format, vertex_count, shader_byte_code, (UINT)size_shader, VertexStream::Position);
+
+	GraphicsEngine::get()->getMeshModelShader(&shader_byte_code, &size_shader);
+	v_Buffer = GraphicsEngine::get()->createVertexBuffer(attributes.data(), m_vertex_format, vertex_count, shader_byte_code, (UINT)size_shader, VertexStream::Attributes);
+
+	QuantizationConstantType constants;
+	constants.m_position_offset = Vector3D(ranges.m_position_offset[0], ranges.m_position_offset[1], ranges.m_position_offset[2]);
+	constants.m_position_scale = Vector3D(ranges.m_position_scale[0], ranges.m_position_scale[1], ranges.m_position_scale[2]);
+	constants.m_texcoord_offset_scale[0] = ranges.m_texcoord_offset[0];
+	constants.m_texcoord_offset_scale[1] = ranges.m_texcoord_offset[1];
+	constants.m_texcoord_offset_scale[2] = ranges.m_texcoord_scale[0];
+	constants.m_texcoord_offset_scale[3] = ranges.m_texcoord_scale[1];
+	constants.m_octahedral_normals = (m_vertex_format.m_normal == NormalFormat::Octahedral16) ? 1.0f : 0.0f;
+	m_quantization = GraphicsEngine::get()->createConstantBuffer(&constants, sizeof(QuantizationConstantType));
+
+	i_Buffer = GraphicsEngine::get()->createIndexBuffer(const_cast<unsigned int*>(indices), index_count);
+
+	if (!v_Buffer.isValid() || !m_position_stream.isValid() || !i_Buffer.isValid() || !m_quantization.isValid())
 	{
-		throw std::exception("Loading Mesh Resources was not successful");
+		GraphicsEngine::get()->release(v_Buffer);
+		GraphicsEngine::get()->release(m_position_stream);
+		GraphicsEngine::get()->release(i_Buffer);
+		GraphicsEngine::get()->release(m_quantization);
+		throw std::exception("Create Mesh Buffers was not successful");
 	}
 }
 
 
 VertexBuffer* MeshModel::getVertex()
 {
-	return v_Buffer;
+	return GraphicsEngine::get()->get(v_Buffer);
+
+}
+
 
+VertexBuffer* MeshModel::getPositionStream()
+{
+	return GraphicsEngine::get()->get(m_position_stream);
 }
 
 IndexBuffer* MeshModel::getIndex()
 {
-	return i_Buffer;
+	return GraphicsEngine::get()->get(i_Buffer);
+
+}
+
+
+unsigned int MeshModel::getLodCount()
+{
+	return (unsigned int)m_lods.size();
+}
+
+
+const MeshFileLod& MeshModel::getLod(unsigned int level)
+{
+	return m_lods[level];
+}
+
+
+const VertexFormat& MeshModel::getVertexFormat()
+{
+	return m_vertex_format;
+}
+
+
+ConstantBuffer* MeshModel::getQuantization()
+{
+	return GraphicsEngine::get()->get(m_quantization);
+}
+
+
+const VertexPackReport& MeshModel::getVertexReport()
+{
+	return m_vertex_report;
+}
+
+
+const std::vector<MeshFileMeshlet>& MeshModel::getMeshlets()
+{
+	return m_meshlets;
+}
+
+
+const std::vector<unsigned int>& MeshModel::getIndexData()
+{
+	return m_indices;
+}
+
+
+const std::vector<Vector3D>& MeshModel::getPositions()
+{
+	return m_positions;
+}
+
+
+const std::vector<VertexMesh>& MeshModel::getVertexData()
+{
+	return m_vertices;
+}
+
+
+void MeshModel::getBoundingBox(Vector3D& min, Vector3D& max)
+{
+	min = m_box_min;
+	max = m_box_max;
+}
+
+
+const std::wstring& MeshModel::getAtlasTexture()
+{
+	return m_atlas_texture;
+}
+
+
+/*
+	projected size of an object space length l at view depth z: l * proj[1][1] / z in clip space, which spans
+	the viewport height with 2 -> l * proj[1][1] * height / (2 z) pixels
+*/
+unsigned int MeshModel::selectLod(const Matrix4x4& world, const Matrix4x4& view, const Matrix4x4& proj, float viewport_height, float pixel_error)
+{
+	// center to view space (row vectors: v * world * view)
+	float position[3] = { m_center.m_x, m_center.m_y, m_center.m_z };
+	float world_position[3], depth = 0.0f;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		world_position[i] = position[0] * world.m_mat[0][i] + position[1] * world.m_mat[1][i] + position[2] * world.m_mat[2][i] + world.m_mat[3][i];
+	}
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		depth += world_position[i] * view.m_mat[i][2];
+	}
+	depth += view.m_mat[3][2];
+
+	// errors grow with the largest scale of the world matrix
+	float scale = 0.0f;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		scale = std::max(scale, Vector3D(world.m_mat[i][0], world.m_mat[i][1], world.m_mat[i][2]).length());
+	}
+
+	if (depth - m_radius * scale <= 0.0f)
+		return 0;
+
+	float pixels_per_unit = proj.m_mat[1][1] * viewport_height * 0.5f / depth;
+
+	unsigned int level = 0;
+	while (level + 1 < m_lods.size() && m_lods[level + 1].m_error * scale * pixels_per_unit <= pixel_error)
+		level++;
 
+	return level;
 }
 
 
 MeshModel::~MeshModel()
 {
-	delete v_Buffer;
-	delete i_Buffer;
+	GraphicsEngine::get()->release(v_Buffer);
+	GraphicsEngine::get()->release(m_position_stream);
+	GraphicsEngine::get()->release(i_Buffer);
+	GraphicsEngine::get()->release(m_quantization);
 }
\ No newline at end of file
@@ -27,13 +27,43 @@
 #pragma once
 
 #include <d3d11.h>
+#include <string>
+#include <vector>
 #include "IndexBuffer.h"
 #include "VertexBuffer.h"
+#include "ConstantBuffer.h"
+#include "ResourcePool.h"
+#include "MeshFile.h"
+#include "Matrix4x4.h"
+#include "VertexMesh.h"
+#include "FileSystem.h"
 
 
 class GraphicsEngine;
 class DeviceContext;
 
+/*
+	MeshData: CPU side of a mesh, everything the constructor needs besides the device. Built by MeshModel::decode on
+	any thread, so a prefetch completion job does the parsing and only the buffers are created on the render thread
+*/
+
+struct MeshData : public PrefetchedAsset
+{
+	std::vector<VertexMesh> m_vertices;
+	std::vector<unsigned char> m_packed_vertices;		// the vertices in m_format as cooked, empty for the float format
+	VertexFormat m_format;
+	VertexQuantization m_quantization;
+	VertexPackReport m_report;
+
+	std::vector<unsigned int> m_indices;
+	std::vector<MeshFileLod> m_lods;
+	std::vector<MeshFileMeshlet> m_meshlets;
+	Vector3D m_center;
+	float m_radius = 0.0f;
+	std::wstring m_atlas_texture;
+};
+
+
 class MeshModel
 {
 public:
@@ -41,14 +71,88 @@ public:
 	// this will load a mesh from a file
 	MeshModel(const wchar_t* file);
 	~MeshModel();
-	VertexBuffer* getVertex();
+	// the file the constructor will read: the cooked file if it can be used, otherwise the source
+	static std::wstring getLoadPath(const wchar_t* file);
+	// getLoadPath(file) with a decoder for FileSystem::prefetch: the constructor then only creates the buffers
+	static PrefetchRequest getPrefetchRequest(const wchar_t* file);
+	/*
+		bytes of load_path (see getLoadPath) -> data. A cooked file is validated and copied out, a source is parsed,
+		its detail levels and meshlets are built and its cooked file is written. Needs no device
+	*/
+	static bool decode(const wchar_t* file, const std::wstring& load_path, const unsigned char* bytes, size_t size, MeshData& data);
+	/*
+		the vertices are split into two streams (VertexStream): bind them with DeviceContext::setVertexStreams,
+		getPositionStream() alone for position only passes (DepthShader.hlsl), both for a full pass
+	*/
+	VertexBuffer* getVertex();				// texcoord + normal
+	VertexBuffer* getPositionStream();
 	IndexBuffer* getIndex();
 
+	// format of the vertex streams. A packed one is drawn with PackedVertexShader.hlsl. getQuantization() holds the
+	// ranges of the format for register b1 (identity for the float format)
+	const VertexFormat& getVertexFormat();
+	ConstantBuffer* getQuantization();
+	// bytes saved and precision lost by the vertex format, from the cook
+	const VertexPackReport& getVertexReport();
+
+	// detail levels, finest first. A level is a range of the index buffer (draw it with start = m_index_start)
+	unsigned int getLodCount();
+	const MeshFileLod& getLod(unsigned int level);
+
+	/*
+		coarsest level whose error, projected with proj onto a viewport viewport_height pixels high, stays below
+		pixel_error pixels. The distance is the one of the bounding sphere center, a camera inside the sphere
+		gets level 0
+	*/
+	unsigned int selectLod(const Matrix4x4& world, const Matrix4x4& view, const Matrix4x4& proj, float viewport_height, float pixel_error = 1.0f);
+
+	// meshlets of all levels (a level has the range m_meshlet_start, m_meshlet_count) and a CPU copy of the index
+	// buffer, so a culling pass can build an index list of the visible meshlets
+	const std::vector<MeshFileMeshlet>& getMeshlets();
+	const std::vector<unsigned int>& getIndexData();
+	// CPU copy of the vertex positions (occluder rasterization) and their box
+	const std::vector<Vector3D>& getPositions();
+	// CPU copy of the vertices (static batching bakes them into world space)
+	const std::vector<VertexMesh>& getVertexData();
+	void getBoundingBox(Vector3D& min, Vector3D& max);
+
+	// texture atlas of the AssetCooker holding the textures of all textured materials (load it with createTextureShader),
+	// empty when the mesh has none. Its texture coordinates point into the atlas, the whole mesh is drawn with this one bind
+	const std::wstring& getAtlasTexture();
+
+
+private:
+
+	// the atlas of the cooked mesh, see getAtlasTexture()
+	static std::wstring getAtlasTexture(MeshFile& mesh);
+	// take over the result of decode() and create the buffers
+	void create(MeshData& data);
+
+	// packed_vertices: the vertices encoded in format (from a cooked file), nullptr for the float format
+	void createBuffers(const VertexMesh* vertices, unsigned int vertex_count, const unsigned int* indices, unsigned int index_count,
+		const VertexFormat& format = VertexFormat(), const void* packed_vertices = nullptr, const VertexQuantization& quantization = VertexQuantization());
 
 private:
 
-	VertexBuffer* v_Buffer;
-	IndexBuffer* i_Buffer;
+	// buffers are owned by the pools of GraphicsEngine
+	ResourceHandle<VertexBuffer> v_Buffer;
+	ResourceHandle<VertexBuffer> m_position_stream;
+	ResourceHandle<IndexBuffer> i_Buffer;
+	ResourceHandle<ConstantBuffer> m_quantization;
+
+	VertexFormat m_vertex_format;
+	VertexPackReport m_vertex_report;
+
+	std::vector<MeshFileLod> m_lods;
+	std::vector<MeshFileMeshlet> m_meshlets;
+	std::vector<unsigned int> m_indices;
+	std::vector<Vector3D> m_positions;
+	std::vector<VertexMesh> m_vertices;
+	Vector3D m_box_min;
+	Vector3D m_box_max;
+	Vector3D m_center;
+	float m_radius = 0.0f;
+	std::wstring m_atlas_texture;
 
 private:
 
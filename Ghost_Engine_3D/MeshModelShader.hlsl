@@ -52,4 +52,16 @@ VS_OUTPUT vsmain(VS_INPUT input)
 	VS_OUTPUT output = (VS_OUTPUT)0;
  
 	return output;
+}
+
+
+// input signature of the position streams (VertexStream::Position)
+struct VS_POSITION_INPUT
+{
+	float4 position: POSITION;
+};
+
+float4 vsposition(VS_POSITION_INPUT input) : SV_POSITION
+{
+	return input.position;
 }
\ No newline at end of file
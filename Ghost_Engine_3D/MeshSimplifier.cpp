@@ -0,0 +1,703 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "MeshSimplifier.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// a normal or texture coordinate that changes by 1 costs as much as moving the surface by this * radius of the mesh
+static const float MESH_SIMPLIFY_ATTRIBUTE_WEIGHT = 0.05f;
+// attributes kept by the attribute quadrics: u, v, normal x, y, z
+static const unsigned int MESH_SIMPLIFY_ATTRIBUTES = 5;
+// vertices at one position a collapse can move, more and the position is not collapsed
+static const unsigned int MESH_SIMPLIFY_MAX_WEDGES = 8;
+
+
+/*
+	symmetric 4x4 matrix of a sum of squared distances to planes: error(p) = p^T A p + 2 b.p + c
+	- for attributes the "plane" is the gradient of the attribute over a triangle. m_g, m_d and m_weight then give
+	  the terms with the attribute value s: error(p, s) = (g.p + d - s)^2 summed over the triangles
+*/
+struct Quadric
+{
+	double m_a00 = 0.0, m_a11 = 0.0, m_a22 = 0.0, m_a01 = 0.0, m_a02 = 0.0, m_a12 = 0.0;
+	double m_b0 = 0.0, m_b1 = 0.0, m_b2 = 0.0;
+	double m_c = 0.0;
+	double m_weight = 0.0;
+};
+
+struct AttributeQuadric
+{
+	Quadric m_quadric;
+	double m_g0 = 0.0, m_g1 = 0.0, m_g2 = 0.0;
+	double m_d = 0.0;
+};
+
+struct Collapse
+{
+	float m_cost;
+	float m_distance;		// squared, of the surface alone
+	unsigned int m_from;	// position that goes away
+	unsigned int m_to;
+};
+
+
+static void addPlane(Quadric& q, const Vector3D& n, double d, double weight)
+{
+	q.m_a00 += weight * n.m_x * n.m_x;
+	q.m_a11 += weight * n.m_y * n.m_y;
+	q.m_a22 += weight * n.m_z * n.m_z;
+	q.m_a01 += weight * n.m_x * n.m_y;
+	q.m_a02 += weight * n.m_x * n.m_z;
+	q.m_a12 += weight * n.m_y * n.m_z;
+	q.m_b0 += weight * n.m_x * d;
+	q.m_b1 += weight * n.m_y * d;
+	q.m_b2 += weight * n.m_z * d;
+	q.m_c += weight * d * d;
+	q.m_weight += weight;
+}
+
+static void addQuadric(Quadric& q, const Quadric& other)
+{
+	q.m_a00 += other.m_a00;
+	q.m_a11 += other.m_a11;
+	q.m_a22 += other.m_a22;
+	q.m_a01 += other.m_a01;
+	q.m_a02 += other.m_a02;
+	q.m_a12 += other.m_a12;
+	q.m_b0 += other.m_b0;
+	q.m_b1 += other.m_b1;
+	q.m_b2 += other.m_b2;
+	q.m_c += other.m_c;
+	q.m_weight += other.m_weight;
+}
+
+static void addQuadric(AttributeQuadric& q, const AttributeQuadric& other)
+{
+	addQuadric(q.m_quadric, other.m_quadric);
+	q.m_g0 += other.m_g0;
+	q.m_g1 += other.m_g1;
+	q.m_g2 += other.m_g2;
+	q.m_d += other.m_d;
+}
+
+static double evaluate(const Quadric& q, const Vector3D& p)
+{
+	double x = p.m_x, y = p.m_y, z = p.m_z;
+	return q.m_a00 * x * x + q.m_a11 * y * y + q.m_a22 * z * z
+		+ 2.0 * (q.m_a01 * x * y + q.m_a02 * x * z + q.m_a12 * y * z)
+		+ 2.0 * (q.m_b0 * x + q.m_b1 * y + q.m_b2 * z) + q.m_c;
+}
+
+static double evaluate(const AttributeQuadric& q, const Vector3D& p, double s)
+{
+	double gp = q.m_g0 * p.m_x + q.m_g1 * p.m_y + q.m_g2 * p.m_z + q.m_d;
+	return evaluate(q.m_quadric, p) - 2.0 * s * gp + q.m_quadric.m_weight * s * s;
+}
+
+static float getAttribute(const VertexMesh& vertex, unsigned int attribute)
+{
+	switch (attribute)
+	{
+	case 0: return vertex.m_Tex.m_x;
+	case 1: return vertex.m_Tex.m_y;
+	case 2: return vertex.m_Norm.m_x;
+	case 3: return vertex.m_Norm.m_y;
+	default: return vertex.m_Norm.m_z;
+	}
+}
+
+
+/*
+	everything one simplify() call works on. Positions are numbered separately from vertices: all vertices at one
+	position are the "wedges" of that position
+*/
+struct SimplifyState
+{
+	const std::vector<VertexMesh>* m_vertices = nullptr;
+	std::vector<unsigned int> m_position;			// vertex -> position
+	std::vector<unsigned int> m_wedge_count;		// position -> referenced vertices at it
+	std::vector<char> m_locked;						// position -> on a border or a non-manifold edge
+	std::vector<Quadric> m_quadrics;				// position -> distance to the planes around it
+	std::vector<AttributeQuadric> m_attributes;		// vertex * MESH_SIMPLIFY_ATTRIBUTES
+	float m_attribute_scale = 0.0f;
+
+	// triangles around every position, rebuilt every pass
+	std::vector<unsigned int> m_fan_offsets;
+	std::vector<unsigned int> m_fan;
+	const std::vector<unsigned int>* m_indices = nullptr;
+};
+
+
+static const Vector3D& getPosition(const SimplifyState& state, unsigned int vertex)
+{
+	return (*state.m_vertices)[vertex].m_Pos;
+}
+
+
+static void buildFans(SimplifyState& state, const std::vector<unsigned int>& indices)
+{
+	size_t positions = state.m_wedge_count.size();
+	state.m_indices = &indices;
+	state.m_fan_offsets.assign(positions + 1, 0);
+	state.m_fan.resize(indices.size());
+
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		state.m_fan_offsets[state.m_position[indices[i]] + 1]++;
+	}
+	for (size_t i = 0; i < positions; i++)
+	{
+		state.m_fan_offsets[i + 1] += state.m_fan_offsets[i];
+	}
+
+	std::vector<unsigned int> fill(state.m_fan_offsets.begin(), state.m_fan_offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		state.m_fan[fill[state.m_position[indices[i]]]++] = (unsigned int)(i / 3);
+	}
+}
+
+
+/*
+	cost of moving position from onto position to. Every vertex at from needs a partner at to: the vertex it shares
+	an edge with -> its triangles take over the attributes of the partner. False if the collapse would tear a seam open
+	- cost: surface and attributes, orders the collapses
+	- distance: squared distance of the surface alone, what max_error limits and the level reports
+*/
+static bool evaluateCollapse(const SimplifyState& state, unsigned int from, unsigned int to, unsigned int* wedges, unsigned int* partners, unsigned int& wedge_count,
+	float& cost, float& distance)
+{
+	const std::vector<unsigned int>& indices = *state.m_indices;
+	wedge_count = 0;
+
+	for (unsigned int f = state.m_fan_offsets[from]; f < state.m_fan_offsets[from + 1]; f++)
+	{
+		const unsigned int* triangle = &indices[state.m_fan[f] * 3];
+
+		unsigned int wedge = 0, partner = ~0u;
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			if (state.m_position[triangle[k]] == from)
+				wedge = triangle[k];
+			else if (state.m_position[triangle[k]] == to)
+				partner = triangle[k];
+		}
+
+		unsigned int w = 0;
+		while (w < wedge_count && wedges[w] != wedge)
+			w++;
+
+		if (w == wedge_count)
+		{
+			if (wedge_count == MESH_SIMPLIFY_MAX_WEDGES)
+				return false;
+			wedges[w] = wedge;
+			partners[w] = ~0u;
+			wedge_count++;
+		}
+
+		if (partners[w] == ~0u)
+			partners[w] = partner;
+	}
+
+	if (wedge_count == 0)
+		return false;
+
+	for (unsigned int w = 0; w < wedge_count; w++)
+	{
+		if (partners[w] == ~0u)
+			return false;
+
+		// a seam only collapses onto another seam vertex, and its sides stay apart
+		for (unsigned int v = 0; v < w; v++)
+		{
+			if (partners[v] == partners[w])
+				return false;
+		}
+	}
+
+	if (wedge_count > 1 && state.m_wedge_count[to] < 2)
+		return false;
+
+	const Vector3D& target = getPosition(state, partners[0]);
+
+	Quadric quadric = state.m_quadrics[from];
+	addQuadric(quadric, state.m_quadrics[to]);
+	double error = evaluate(quadric, target);
+	double surface_error = error;
+
+	double attribute_error = 0.0;
+	for (unsigned int w = 0; w < wedge_count; w++)
+	{
+		const VertexMesh& partner = (*state.m_vertices)[partners[w]];
+
+		for (unsigned int a = 0; a < MESH_SIMPLIFY_ATTRIBUTES; a++)
+		{
+			AttributeQuadric attribute = state.m_attributes[wedges[w] * MESH_SIMPLIFY_ATTRIBUTES + a];
+			addQuadric(attribute, state.m_attributes[partners[w] * MESH_SIMPLIFY_ATTRIBUTES + a]);
+			attribute_error += evaluate(attribute, target, getAttribute(partner, a));
+		}
+	}
+
+	error += attribute_error * state.m_attribute_scale * state.m_attribute_scale;
+
+	// area weighted sum -> average squared distance
+	if (quadric.m_weight > 0.0)
+	{
+		error /= quadric.m_weight;
+		surface_error /= quadric.m_weight;
+	}
+
+	cost = (float)std::max(error, 0.0);
+	distance = (float)std::max(surface_error, 0.0);
+	return true;
+}
+
+
+// true if moving from onto to turns a triangle around from (that is not removed by the collapse) over
+static bool flipsTriangle(const SimplifyState& state, unsigned int from, unsigned int to, const Vector3D& target)
+{
+	const std::vector<unsigned int>& indices = *state.m_indices;
+
+	for (unsigned int f = state.m_fan_offsets[from]; f < state.m_fan_offsets[from + 1]; f++)
+	{
+		const unsigned int* triangle = &indices[state.m_fan[f] * 3];
+
+		Vector3D before[3], after[3];
+		bool removed = false;
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			unsigned int position = state.m_position[triangle[k]];
+			removed |= (position == to);
+			before[k] = getPosition(state, triangle[k]);
+			after[k] = (position == from) ? target : before[k];
+		}
+
+		if (removed)
+			continue;
+
+		Vector3D normal_before = Vector3D::cross(before[1] - before[0], before[2] - before[0]);
+		Vector3D normal_after = Vector3D::cross(after[1] - after[0], after[2] - after[0]);
+
+		if (Vector3D::dot(normal_before, normal_after) <= 0.25f * normal_before.length() * normal_after.length())
+			return true;
+	}
+
+	return false;
+}
+
+
+// distance of p to the triangle a b c (closest point by the regions of the triangle, Ericson 5.1.5)
+static float getTriangleDistance(const Vector3D& p, const Vector3D& a, const Vector3D& b, const Vector3D& c)
+{
+	Vector3D ab = b - a, ac = c - a, ap = p - a;
+	float d1 = Vector3D::dot(ab, ap), d2 = Vector3D::dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+		return ap.length();
+
+	Vector3D bp = p - b;
+	float d3 = Vector3D::dot(ab, bp), d4 = Vector3D::dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+		return bp.length();
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		return (p - (a + ab * (d1 / (d1 - d3)))).length();
+
+	Vector3D cp = p - c;
+	float d5 = Vector3D::dot(ab, cp), d6 = Vector3D::dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+		return cp.length();
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		return (p - (a + ac * (d2 / (d2 - d6)))).length();
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		return (p - (b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6))))).length();
+
+	float denominator = 1.0f / (va + vb + vc);
+	return (p - (a + ab * (vb * denominator) + ac * (vc * denominator))).length();
+}
+
+
+float MeshSimplifier::simplify(const std::vector<VertexMesh>& vertices, const std::vector<unsigned int>& indices, size_t target_index_count, float max_error, std::vector<unsigned int>& result)
+{
+	SimplifyState state;
+	state.m_vertices = &vertices;
+
+	size_t vertex_count = vertices.size();
+
+	// weld positions: sort the vertices by position, equal neighbours are one position
+	std::vector<unsigned int> order(vertex_count);
+	for (unsigned int i = 0; i < vertex_count; i++)
+	{
+		order[i] = i;
+	}
+	auto less = [&vertices](unsigned int a, unsigned int b)
+	{
+		const Vector3D& pa = vertices[a].m_Pos;
+		const Vector3D& pb = vertices[b].m_Pos;
+		if (pa.m_x != pb.m_x) return pa.m_x < pb.m_x;
+		if (pa.m_y != pb.m_y) return pa.m_y < pb.m_y;
+		return pa.m_z < pb.m_z;
+	};
+	std::sort(order.begin(), order.end(), less);
+
+	state.m_position.resize(vertex_count);
+	unsigned int positions = 0;
+	for (size_t i = 0; i < vertex_count; i++)
+	{
+		if (i > 0 && less(order[i - 1], order[i]))
+			positions++;
+		state.m_position[order[i]] = positions;
+	}
+	if (vertex_count > 0)
+		positions++;
+
+	// the triangles that are not already degenerate
+	std::vector<unsigned int> current;
+	current.reserve(indices.size());
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		unsigned int p0 = state.m_position[indices[i]], p1 = state.m_position[indices[i + 1]], p2 = state.m_position[indices[i + 2]];
+		if (p0 != p1 && p1 != p2 && p0 != p2)
+			current.insert(current.end(), &indices[i], &indices[i] + 3);
+	}
+
+	std::vector<char> referenced(vertex_count, 0);
+	state.m_wedge_count.assign(positions, 0);
+	for (size_t i = 0; i < current.size(); i++)
+	{
+		if (!referenced[current[i]])
+		{
+			referenced[current[i]] = 1;
+			state.m_wedge_count[state.m_position[current[i]]]++;
+		}
+	}
+
+	// every edge of a closed surface has two triangles. Edges with one (border) or more than two are locked
+	state.m_locked.assign(positions, 0);
+	std::vector<unsigned long long> edges;
+	edges.reserve(current.size());
+	for (size_t i = 0; i < current.size(); i += 3)
+	{
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			unsigned int a = state.m_position[current[i + k]], b = state.m_position[current[i + (k + 1) % 3]];
+			edges.push_back(((unsigned long long)std::min(a, b) << 32) | std::max(a, b));
+		}
+	}
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size();)
+	{
+		size_t j = i;
+		while (j < edges.size() && edges[j] == edges[i])
+			j++;
+
+		if (j - i != 2)
+		{
+			state.m_locked[(unsigned int)(edges[i] >> 32)] = 1;
+			state.m_locked[(unsigned int)edges[i]] = 1;
+		}
+		i = j;
+	}
+
+	// quadrics of the triangle planes and of the attribute gradients, weighted by area
+	Vector3D center;
+	float radius = 0.0f;
+	MeshFile::computeBounds(vertices.data(), vertex_count, center, radius);
+	state.m_attribute_scale = radius * MESH_SIMPLIFY_ATTRIBUTE_WEIGHT;
+
+	state.m_quadrics.assign(positions, Quadric());
+	state.m_attributes.assign(vertex_count * MESH_SIMPLIFY_ATTRIBUTES, AttributeQuadric());
+
+	for (size_t i = 0; i < current.size(); i += 3)
+	{
+		const unsigned int* triangle = &current[i];
+		const Vector3D& p0 = vertices[triangle[0]].m_Pos;
+		Vector3D e1 = vertices[triangle[1]].m_Pos - p0;
+		Vector3D e2 = vertices[triangle[2]].m_Pos - p0;
+
+		Vector3D normal = Vector3D::cross(e1, e2);
+		float length = normal.length();
+		if (length <= 0.0f)
+			continue;
+
+		double area = length * 0.5;
+		Vector3D unit = normal * (1.0f / length);
+		double d = -Vector3D::dot(unit, p0);
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			addPlane(state.m_quadrics[state.m_position[triangle[k]]], unit, d, area);
+		}
+
+		// gradient g of an attribute over the triangle: g.e1 = s1 - s0, g.e2 = s2 - s0, g.normal = 0
+		Vector3D g1 = Vector3D::cross(e2, normal) * (1.0f / (length * length));
+		Vector3D g2 = Vector3D::cross(normal, e1) * (1.0f / (length * length));
+
+		for (unsigned int a = 0; a < MESH_SIMPLIFY_ATTRIBUTES; a++)
+		{
+			float s0 = getAttribute(vertices[triangle[0]], a);
+			Vector3D gradient = g1 * (getAttribute(vertices[triangle[1]], a) - s0) + g2 * (getAttribute(vertices[triangle[2]], a) - s0);
+			double offset = s0 - Vector3D::dot(gradient, p0);
+
+			AttributeQuadric attribute;
+			addPlane(attribute.m_quadric, gradient, offset, area);
+			attribute.m_g0 = area * gradient.m_x;
+			attribute.m_g1 = area * gradient.m_y;
+			attribute.m_g2 = area * gradient.m_z;
+			attribute.m_d = area * offset;
+
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				addQuadric(state.m_attributes[triangle[k] * MESH_SIMPLIFY_ATTRIBUTES + a], attribute);
+			}
+		}
+	}
+
+	size_t triangle_count = current.size() / 3;
+	size_t target_triangles = target_index_count / 3;
+	float max_distance = max_error * max_error;		// squared, like the quadrics
+	float error = 0.0f;
+
+	std::vector<Collapse> collapses;
+	std::vector<unsigned int> remap(vertex_count);
+	std::vector<unsigned int> collapsed_into(positions);	// position -> the position it was moved onto
+	std::vector<Vector3D> original(positions);
+	for (unsigned int i = 0; i < vertex_count; i++)
+	{
+		collapsed_into[state.m_position[i]] = state.m_position[i];
+		original[state.m_position[i]] = vertices[i].m_Pos;
+	}
+	std::vector<char> touched(positions);
+	unsigned int wedges[MESH_SIMPLIFY_MAX_WEDGES], partners[MESH_SIMPLIFY_MAX_WEDGES], wedge_count = 0;
+
+	while (triangle_count > target_triangles)
+	{
+		buildFans(state, current);
+
+		// every edge in both directions, as long as the position that goes away is not locked
+		edges.clear();
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				unsigned int a = state.m_position[current[i + k]], b = state.m_position[current[i + (k + 1) % 3]];
+				if (!state.m_locked[a])
+					edges.push_back(((unsigned long long)a << 32) | b);
+				if (!state.m_locked[b])
+					edges.push_back(((unsigned long long)b << 32) | a);
+			}
+		}
+		std::sort(edges.begin(), edges.end());
+		edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+		collapses.clear();
+		for (size_t i = 0; i < edges.size(); i++)
+		{
+			Collapse collapse;
+			collapse.m_from = (unsigned int)(edges[i] >> 32);
+			collapse.m_to = (unsigned int)edges[i];
+
+			if (evaluateCollapse(state, collapse.m_from, collapse.m_to, wedges, partners, wedge_count, collapse.m_cost, collapse.m_distance) &&
+				collapse.m_distance <= max_distance)
+				collapses.push_back(collapse);
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b)
+			{
+				return a.m_cost < b.m_cost;
+			});
+
+		for (unsigned int i = 0; i < vertex_count; i++)
+		{
+			remap[i] = i;
+		}
+		std::fill(touched.begin(), touched.end(), 0);
+
+		// cheapest first, a position whose triangles already changed in this pass waits for the next one
+		size_t collapsed = 0;
+		for (size_t c = 0; c < collapses.size() && triangle_count > target_triangles; c++)
+		{
+			const Collapse& collapse = collapses[c];
+			if (touched[collapse.m_from] || touched[collapse.m_to])
+				continue;
+
+			float cost = 0.0f, distance = 0.0f;
+			evaluateCollapse(state, collapse.m_from, collapse.m_to, wedges, partners, wedge_count, cost, distance);
+
+			if (flipsTriangle(state, collapse.m_from, collapse.m_to, getPosition(state, partners[0])))
+				continue;
+
+			for (unsigned int w = 0; w < wedge_count; w++)
+			{
+				remap[wedges[w]] = partners[w];
+				for (unsigned int a = 0; a < MESH_SIMPLIFY_ATTRIBUTES; a++)
+				{
+					addQuadric(state.m_attributes[partners[w] * MESH_SIMPLIFY_ATTRIBUTES + a], state.m_attributes[wedges[w] * MESH_SIMPLIFY_ATTRIBUTES + a]);
+				}
+			}
+			addQuadric(state.m_quadrics[collapse.m_to], state.m_quadrics[collapse.m_from]);
+			collapsed_into[collapse.m_from] = collapse.m_to;
+
+			state.m_wedge_count[collapse.m_from] = 0;
+			for (unsigned int f = state.m_fan_offsets[collapse.m_from]; f < state.m_fan_offsets[collapse.m_from + 1]; f++)
+			{
+				const unsigned int* triangle = &current[state.m_fan[f] * 3];
+				bool removed = false;
+				for (unsigned int k = 0; k < 3; k++)
+				{
+					unsigned int position = state.m_position[triangle[k]];
+					removed |= (position == collapse.m_to);
+					touched[position] = 1;
+				}
+				if (removed)
+					triangle_count--;
+			}
+
+			collapsed++;
+		}
+
+		if (collapsed == 0)
+			break;
+
+		// move the corners and drop the triangles that lost an edge
+		size_t write = 0;
+		for (size_t i = 0; i < current.size(); i += 3)
+		{
+			unsigned int v0 = remap[current[i]], v1 = remap[current[i + 1]], v2 = remap[current[i + 2]];
+			unsigned int p0 = state.m_position[v0], p1 = state.m_position[v1], p2 = state.m_position[v2];
+			if (p0 == p1 || p1 == p2 || p0 == p2)
+				continue;
+
+			current[write++] = v0;
+			current[write++] = v1;
+			current[write++] = v2;
+		}
+		current.resize(write);
+		triangle_count = current.size() / 3;
+	}
+
+	/*
+		error of the result: every position that went away to the triangles around the one it ended up on and around
+		their corners (the area it moved into may have gone on to a neighbour). The nearest of all triangles can only
+		be nearer -> never less than the real distance to the surface
+	*/
+	buildFans(state, current);
+	for (unsigned int position = 0; position < positions; position++)
+	{
+		unsigned int survivor = collapsed_into[position];
+		if (survivor == position)
+			continue;
+		while (collapsed_into[survivor] != survivor)
+			survivor = collapsed_into[survivor];
+
+		float distance = FLT_MAX;
+		for (unsigned int f = state.m_fan_offsets[survivor]; f < state.m_fan_offsets[survivor + 1]; f++)
+		{
+			const unsigned int* corners = &current[state.m_fan[f] * 3];
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				unsigned int corner = state.m_position[corners[k]];
+				for (unsigned int g = state.m_fan_offsets[corner]; g < state.m_fan_offsets[corner + 1]; g++)
+				{
+					const unsigned int* triangle = &current[state.m_fan[g] * 3];
+					distance = std::min(distance, getTriangleDistance(original[position], vertices[triangle[0]].m_Pos, vertices[triangle[1]].m_Pos, vertices[triangle[2]].m_Pos));
+				}
+			}
+		}
+		if (distance < FLT_MAX)
+			error = std::max(error, distance);
+	}
+
+	result.swap(current);
+	return error;
+}
+
+
+void MeshSimplifier::buildLods(const std::vector<VertexMesh>& vertices, const std::vector<unsigned int>& indices, const MeshLodSettings& settings,
+	std::vector<unsigned int>& lod_indices, std::vector<MeshFileLod>& lods)
+{
+	lod_indices = indices;
+	lods.clear();
+
+	std::vector<char> used(vertices.size());
+	auto addLevel = [&](size_t start, float error)
+	{
+		MeshFileLod lod;
+		lod.m_index_start = (unsigned int)start;
+		lod.m_index_count = (unsigned int)(lod_indices.size() - start);
+		lod.m_error = error;
+
+		std::fill(used.begin(), used.end(), 0);
+		for (size_t i = start; i < lod_indices.size(); i++)
+		{
+			lod.m_vertex_count += used[lod_indices[i]] ? 0 : 1;
+			used[lod_indices[i]] = 1;
+		}
+		lods.push_back(lod);
+	};
+
+	addLevel(0, 0.0f);
+
+	if (vertices.empty())
+		return;
+
+	Vector3D center;
+	float radius = 0.0f;
+	MeshFile::computeBounds(vertices.data(), vertices.size(), center, radius);
+	float max_error = radius * settings.m_max_error;
+
+	unsigned int max_lods = std::min(settings.m_max_lods, MESH_FILE_MAX_LODS);
+	double target = (double)indices.size();
+	std::vector<unsigned int> level;
+
+	for (unsigned int i = 1; i < max_lods; i++)
+	{
+		target *= settings.m_reduction;
+
+		// the collapses are limited by their average distance, the measured one can be larger -> tighter limits
+		float limit = max_error;
+		float error = simplify(vertices, indices, (size_t)target / 3 * 3, limit, level);
+		for (unsigned int retry = 0; retry < 4 && error > max_error; retry++)
+		{
+			limit *= 0.5f;
+			error = simplify(vertices, indices, (size_t)target / 3 * 3, limit, level);
+		}
+
+		const MeshFileLod& previous = lods.back();
+		if (error > max_error || level.empty() || level.size() > previous.m_index_count * 9 / 10)
+			break;
+
+		size_t start = lod_indices.size();
+		lod_indices.insert(lod_indices.end(), level.begin(), level.end());
+		addLevel(start, std::max(error, previous.m_error));
+	}
+}
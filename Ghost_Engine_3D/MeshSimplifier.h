@@ -0,0 +1,79 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "MeshFile.h"
+#include "VertexMesh.h"
+#include <vector>
+
+// how the detail levels of a mesh are built at cook time
+struct MeshLodSettings
+{
+	unsigned int m_max_lods = 4;		// including level 0, at most MESH_FILE_MAX_LODS
+	float m_reduction = 0.5f;			// triangles of a level / triangles of the level before
+	float m_max_error = 0.1f;			// a level never moves the surface further than this * radius of the mesh
+};
+
+
+/*
+	MeshSimplifier: edge collapse simplification with quadric error metrics (Garland & Heckbert)
+
+	- half edge collapses: a vertex is moved onto a neighbour, no new vertices are made. All levels of a mesh keep
+	  using the vertex buffer of level 0 and only get an index list of their own
+	- topology works on positions: vertices at the same position (split by a normal or texture seam) are one
+	  corner of the surface. A seam vertex only collapses along the seam, so the seam stays closed
+	- the cost of a collapse is the squared distance to the planes of the triangles around both vertices plus the
+	  error of the normals and texture coordinates, interpolated over those triangles (attribute quadrics,
+	  Hoppe 1999) -> flat, evenly mapped areas go first, silhouettes and UV seams last. Only the surface part is
+	  limited by max_error: the attributes order the collapses but are no distance
+	- vertices on an open border (or a non-manifold edge) are locked, the outline of the mesh never changes
+	- a collapse that flips a triangle is rejected
+	- collapses run in passes: sorted by cost, each vertex is touched once per pass, the index list is rebuilt after
+	  every pass
+*/
+
+class MeshSimplifier
+{
+public:
+
+	/*
+		reduce the triangles of a mesh to target_index_count indices (or as close as max_error allows)
+		- max_error: object space distance a collapse may move the surface, on average over the planes around it
+		- returns the largest distance of a removed vertex to the result, in object space. Measured against the
+		  triangles near the vertex it was moved onto -> never less than the real distance, may be more than max_error
+	*/
+	static float simplify(const std::vector<VertexMesh>& vertices, const std::vector<unsigned int>& indices, size_t target_index_count, float max_error, std::vector<unsigned int>& result);
+
+	/*
+		detail levels of a mesh, level 0 is the mesh itself
+		- lod_indices: the index lists of all levels, one after the other. lods: the range of each level
+		- every level is simplified from level 0, so its error is measured against the real surface. A level whose
+		  error is above m_max_error is simplified again with a tighter limit, or dropped. Errors never decrease
+		- stops early when a level would not remove at least 10% of the triangles of the one before
+	*/
+	static void buildLods(const std::vector<VertexMesh>& vertices, const std::vector<unsigned int>& indices, const MeshLodSettings& settings,
+		std::vector<unsigned int>& lod_indices, std::vector<MeshFileLod>& lods);
+};
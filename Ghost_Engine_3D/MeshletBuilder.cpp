@@ -0,0 +1,263 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "MeshletBuilder.h"
+#include <algorithm>
+#include <cmath>
+
+// cost of a candidate triangle: new vertices + this * (1 - cos of the angle to the average normal of the meshlet)
+static const float MESHLET_CONE_WEIGHT = 0.5f;
+
+
+static Vector3D normalize(const Vector3D& vector)
+{
+	float length = vector.length();
+	return (length > 0.0f) ? vector * (1.0f / length) : Vector3D();
+}
+
+
+static void computeMeshletBounds(const std::vector<VertexMesh>& vertices, const unsigned int* indices, unsigned int triangle_count, MeshFileMeshlet& meshlet)
+{
+	Vector3D min = vertices[indices[0]].m_Pos, max = min;
+	for (unsigned int i = 1; i < triangle_count * 3; i++)
+	{
+		const Vector3D& p = vertices[indices[i]].m_Pos;
+		min = Vector3D(std::min(min.m_x, p.m_x), std::min(min.m_y, p.m_y), std::min(min.m_z, p.m_z));
+		max = Vector3D(std::max(max.m_x, p.m_x), std::max(max.m_y, p.m_y), std::max(max.m_z, p.m_z));
+	}
+
+	Vector3D center = (min + max) * 0.5f;
+	float radius = 0.0f;
+	for (unsigned int i = 0; i < triangle_count * 3; i++)
+	{
+		radius = std::max(radius, (vertices[indices[i]].m_Pos - center).length());
+	}
+
+	// normals in the winding the rasterizer culls with (clockwise = front) -> a triangle faces away when dot(normal, p - camera) > 0
+	Vector3D axis;
+	for (unsigned int t = 0; t < triangle_count; t++)
+	{
+		const Vector3D& p0 = vertices[indices[t * 3]].m_Pos;
+		axis = axis + normalize(Vector3D::cross(vertices[indices[t * 3 + 1]].m_Pos - p0, vertices[indices[t * 3 + 2]].m_Pos - p0));
+	}
+	axis = normalize(axis);
+
+	float min_dot = 1.0f;
+	for (unsigned int t = 0; t < triangle_count; t++)
+	{
+		const Vector3D& p0 = vertices[indices[t * 3]].m_Pos;
+		Vector3D normal = normalize(Vector3D::cross(vertices[indices[t * 3 + 1]].m_Pos - p0, vertices[indices[t * 3 + 2]].m_Pos - p0));
+		min_dot = std::min(min_dot, Vector3D::dot(normal, axis));
+	}
+
+	/*
+		all normals are within acos(min_dot) of the axis. The whole meshlet faces away when every view direction is within
+		90 degrees - acos(min_dot) of the axis -> cutoff = cos(90 - acos(min_dot)) = sqrt(1 - min_dot^2). A cone of 90
+		degrees or more (or a zero axis) is never culled: cutoff 1
+	*/
+	meshlet.m_center[0] = center.m_x;
+	meshlet.m_center[1] = center.m_y;
+	meshlet.m_center[2] = center.m_z;
+	meshlet.m_radius = radius;
+	meshlet.m_cone_axis[0] = axis.m_x;
+	meshlet.m_cone_axis[1] = axis.m_y;
+	meshlet.m_cone_axis[2] = axis.m_z;
+	meshlet.m_cone_cutoff = (min_dot > 0.0f && axis.length() > 0.0f) ? sqrtf(1.0f - min_dot * min_dot) : 1.0f;
+}
+
+
+void MeshletBuilder::build(const std::vector<VertexMesh>& vertices, std::vector<unsigned int>& indices, unsigned int index_start, unsigned int index_count,
+	std::vector<MeshFileMeshlet>& meshlets)
+{
+	const unsigned int* source = &indices[index_start];
+	unsigned int triangle_count = index_count / 3;
+	if (triangle_count == 0)
+		return;
+
+	// triangles around every vertex
+	std::vector<unsigned int> offsets(vertices.size() + 1, 0);
+	for (unsigned int i = 0; i < triangle_count * 3; i++)
+	{
+		offsets[source[i] + 1]++;
+	}
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		offsets[i + 1] += offsets[i];
+	}
+	std::vector<unsigned int> adjacency(triangle_count * 3);
+	std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+	for (unsigned int i = 0; i < triangle_count * 3; i++)
+	{
+		adjacency[fill[source[i]]++] = i / 3;
+	}
+
+	std::vector<Vector3D> normals(triangle_count);
+	for (unsigned int t = 0; t < triangle_count; t++)
+	{
+		const Vector3D& p0 = vertices[source[t * 3]].m_Pos;
+		normals[t] = normalize(Vector3D::cross(vertices[source[t * 3 + 1]].m_Pos - p0, vertices[source[t * 3 + 2]].m_Pos - p0));
+	}
+
+	std::vector<unsigned int> ordered;
+	ordered.reserve(triangle_count * 3);
+
+	std::vector<char> emitted(triangle_count, 0);
+	std::vector<unsigned int> vertex_stamp(vertices.size(), 0);		// meshlet number + 1 of the meshlet using the vertex
+	std::vector<unsigned int> candidate_stamp(triangle_count, 0);
+	std::vector<unsigned int> candidates, meshlet_triangles;
+	unsigned int stamp = 1, meshlet_vertices = 0, cursor = 0, done = 0;
+	int seed = -1;
+	Vector3D normal_sum;
+
+	auto flush = [&]()
+	{
+		MeshFileMeshlet meshlet;
+		meshlet.m_index_start = index_start + (unsigned int)ordered.size();
+		meshlet.m_triangle_count = (unsigned int)meshlet_triangles.size();
+
+		for (size_t i = 0; i < meshlet_triangles.size(); i++)
+		{
+			ordered.insert(ordered.end(), source + meshlet_triangles[i] * 3, source + meshlet_triangles[i] * 3 + 3);
+		}
+		computeMeshletBounds(vertices, &ordered[meshlet.m_index_start - index_start], meshlet.m_triangle_count, meshlet);
+		meshlets.push_back(meshlet);
+
+		meshlet_triangles.clear();
+		meshlet_vertices = 0;
+		normal_sum = Vector3D();
+		stamp++;
+
+		// the next meshlet starts next to this one
+		seed = -1;
+		for (size_t c = 0; c < candidates.size() && seed < 0; c++)
+		{
+			if (!emitted[candidates[c]])
+				seed = (int)candidates[c];
+		}
+		candidates.clear();
+	};
+
+	while (done < triangle_count)
+	{
+		// cheapest neighbour that still fits
+		Vector3D direction = normalize(normal_sum);
+		int best = -1;
+		float best_cost = 0.0f;
+		size_t kept = 0;
+		for (size_t c = 0; c < candidates.size(); c++)
+		{
+			unsigned int t = candidates[c];
+			if (emitted[t])
+				continue;
+			candidates[kept++] = t;
+
+			unsigned int added = 0;
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				added += (vertex_stamp[source[t * 3 + k]] != stamp) ? 1 : 0;
+			}
+			if (meshlet_vertices + added > MESHLET_MAX_VERTICES)
+				continue;
+
+			float cost = added + MESHLET_CONE_WEIGHT * (1.0f - Vector3D::dot(normals[t], direction));
+			if (best < 0 || cost < best_cost)
+			{
+				best = (int)t;
+				best_cost = cost;
+			}
+		}
+		candidates.resize(kept);
+
+		if (best < 0)
+		{
+			if (!meshlet_triangles.empty())
+			{
+				flush();
+				continue;
+			}
+
+			// new meshlet: next to the last one if possible, otherwise the next free triangle
+			if (seed >= 0 && !emitted[seed])
+			{
+				best = seed;
+			}
+			else
+			{
+				while (emitted[cursor])
+					cursor++;
+				best = (int)cursor;
+			}
+		}
+
+		unsigned int t = (unsigned int)best;
+		emitted[t] = 1;
+		done++;
+		meshlet_triangles.push_back(t);
+		normal_sum = normal_sum + normals[t];
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			unsigned int v = source[t * 3 + k];
+			if (vertex_stamp[v] != stamp)
+			{
+				vertex_stamp[v] = stamp;
+				meshlet_vertices++;
+			}
+
+			for (unsigned int a = offsets[v]; a < offsets[v + 1]; a++)
+			{
+				unsigned int neighbour = adjacency[a];
+				if (!emitted[neighbour] && candidate_stamp[neighbour] != stamp)
+				{
+					candidate_stamp[neighbour] = stamp;
+					candidates.push_back(neighbour);
+				}
+			}
+		}
+
+		if (meshlet_triangles.size() == MESHLET_MAX_TRIANGLES)
+			flush();
+	}
+
+	if (!meshlet_triangles.empty())
+		flush();
+
+	std::copy(ordered.begin(), ordered.end(), indices.begin() + index_start);
+}
+
+
+void MeshletBuilder::buildLods(const std::vector<VertexMesh>& vertices, std::vector<unsigned int>& lod_indices, std::vector<MeshFileLod>& lods,
+	std::vector<MeshFileMeshlet>& meshlets)
+{
+	meshlets.clear();
+
+	for (size_t i = 0; i < lods.size(); i++)
+	{
+		lods[i].m_meshlet_start = (unsigned int)meshlets.size();
+		build(vertices, lod_indices, lods[i].m_index_start, lods[i].m_index_count, meshlets);
+		lods[i].m_meshlet_count = (unsigned int)meshlets.size() - lods[i].m_meshlet_start;
+	}
+}
@@ -0,0 +1,58 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "MeshFile.h"
+#include "VertexMesh.h"
+#include <vector>
+
+// limits of one meshlet (the sizes mesh shader hardware works with)
+static const unsigned int MESHLET_MAX_VERTICES = 64;
+static const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+
+/*
+	MeshletBuilder: splits the triangles of a mesh into meshlets at cook time, so big meshes can be culled in small
+	pieces (see MeshletCuller)
+
+	- greedy growth: a meshlet takes the neighbour triangle that adds the fewest new vertices and bends its normal
+	  cone the least, until MESHLET_MAX_VERTICES or MESHLET_MAX_TRIANGLES is reached or no neighbour is left
+	- the triangles are reordered, so the indices of a meshlet are one range of the index list
+	- bounds: sphere around the box of the meshlet and the cone of its triangle normals
+*/
+
+class MeshletBuilder
+{
+public:
+
+	// meshlets of indices[index_start, index_start + index_count): reorders that range, appends to meshlets
+	static void build(const std::vector<VertexMesh>& vertices, std::vector<unsigned int>& indices, unsigned int index_start, unsigned int index_count,
+		std::vector<MeshFileMeshlet>& meshlets);
+
+	// meshlets of every detail level, sets the meshlet range of each level
+	static void buildLods(const std::vector<VertexMesh>& vertices, std::vector<unsigned int>& lod_indices, std::vector<MeshFileLod>& lods,
+		std::vector<MeshFileMeshlet>& meshlets);
+};
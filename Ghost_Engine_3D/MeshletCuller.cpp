@@ -0,0 +1,197 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "MeshletCuller.h"
+#include "MeshModel.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+// meshlets per job of the culling pass
+static const unsigned int MESHLET_CULL_GROUP = 64;
+
+
+MeshletCuller::MeshletCuller()
+{
+}
+
+
+void MeshletCuller::begin()
+{
+	m_indices.clear();
+	m_stats = MeshletCullStats();
+}
+
+
+/*
+	frustum planes from the columns c0..c3 of a row vector matrix (Gribb / Hartmann). A point is inside when
+	-w <= x <= w, -w <= y <= w and 0 <= z <= w -> c3 + c0, c3 - c0, c3 + c1, c3 - c1, c2, c3 - c2
+*/
+void getFrustumPlanes(const Matrix4x4& matrix, float planes[6][4])
+{
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		float c0 = matrix.m_mat[i][0], c1 = matrix.m_mat[i][1], c2 = matrix.m_mat[i][2], c3 = matrix.m_mat[i][3];
+		planes[0][i] = c3 + c0;
+		planes[1][i] = c3 - c0;
+		planes[2][i] = c3 + c1;
+		planes[3][i] = c3 - c1;
+		planes[4][i] = c2;
+		planes[5][i] = c3 - c2;
+	}
+
+	// unit normals -> the plane equation gives the distance, comparable with the sphere radius
+	for (unsigned int p = 0; p < 6; p++)
+	{
+		float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+		if (length > 0.0f)
+		{
+			for (unsigned int i = 0; i < 4; i++)
+			{
+				planes[p][i] /= length;
+			}
+		}
+	}
+}
+
+
+void MeshletCuller::cull(MeshModel* mesh, unsigned int level, const Matrix4x4& world, const Matrix4x4& view, const Matrix4x4& proj, OcclusionTest* occlusion)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const MeshFileLod& lod = mesh->getLod(level);
+	const MeshFileMeshlet* meshlets = mesh->getMeshlets().data() + lod.m_meshlet_start;
+	const unsigned int* indices = mesh->getIndexData().data();
+
+	Matrix4x4 world_view = world;
+	world_view *= view;
+
+	Matrix4x4 world_view_proj = world_view;
+	world_view_proj *= proj;
+
+	float planes[6][4];
+	getFrustumPlanes(world_view_proj, planes);
+
+	Matrix4x4 camera_matrix = world_view;
+	camera_matrix.inverse();
+	Vector3D camera = camera_matrix.getTranslation();
+
+	// the occlusion test works on world space spheres
+	float scale = 0.0f;
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		scale = std::max(scale, Vector3D(world.m_mat[i][0], world.m_mat[i][1], world.m_mat[i][2]).length());
+	}
+
+	m_results.resize(lod.m_meshlet_count);
+
+	JobSystem::get()->parallelFor(lod.m_meshlet_count, MESHLET_CULL_GROUP, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int m = begin; m < end; m++)
+			{
+				const MeshFileMeshlet& meshlet = meshlets[m];
+				Vector3D center(meshlet.m_center[0], meshlet.m_center[1], meshlet.m_center[2]);
+
+				CullResult result = Visible;
+				for (unsigned int p = 0; p < 6 && result == Visible; p++)
+				{
+					if (planes[p][0] * center.m_x + planes[p][1] * center.m_y + planes[p][2] * center.m_z + planes[p][3] < -meshlet.m_radius)
+						result = FrustumCulled;
+				}
+
+				if (result == Visible)
+				{
+					Vector3D direction = center - camera;
+					Vector3D axis(meshlet.m_cone_axis[0], meshlet.m_cone_axis[1], meshlet.m_cone_axis[2]);
+					if (Vector3D::dot(direction, axis) >= meshlet.m_cone_cutoff * direction.length() + meshlet.m_radius)
+						result = ConeCulled;
+				}
+
+				if (result == Visible && occlusion)
+				{
+					Vector3D world_center(
+						center.m_x * world.m_mat[0][0] + center.m_y * world.m_mat[1][0] + center.m_z * world.m_mat[2][0] + world.m_mat[3][0],
+						center.m_x * world.m_mat[0][1] + center.m_y * world.m_mat[1][1] + center.m_z * world.m_mat[2][1] + world.m_mat[3][1],
+						center.m_x * world.m_mat[0][2] + center.m_y * world.m_mat[1][2] + center.m_z * world.m_mat[2][2] + world.m_mat[3][2]);
+
+					if (occlusion->isOccluded(world_center, meshlet.m_radius * scale))
+						result = OcclusionCulled;
+				}
+
+				m_results[m] = result;
+			}
+		});
+
+	// copy the visible ranges, neighbouring meshlets are one range
+	size_t run_start = 0, run_count = 0;
+	for (unsigned int m = 0; m < lod.m_meshlet_count; m++)
+	{
+		const MeshFileMeshlet& meshlet = meshlets[m];
+		m_stats.m_meshlets++;
+		m_stats.m_triangles += meshlet.m_triangle_count;
+
+		switch (m_results[m])
+		{
+		case FrustumCulled: m_stats.m_frustum_culled++; break;
+		case ConeCulled: m_stats.m_cone_culled++; break;
+		case OcclusionCulled: m_stats.m_occlusion_culled++; break;
+		default: break;
+		}
+
+		if (m_results[m] != Visible)
+		{
+			m_stats.m_triangles_culled += meshlet.m_triangle_count;
+			continue;
+		}
+
+		if (run_count && run_start + run_count == meshlet.m_index_start)
+		{
+			run_count += meshlet.m_triangle_count * 3;
+			continue;
+		}
+
+		m_indices.insert(m_indices.end(), indices + run_start, indices + run_start + run_count);
+		run_start = meshlet.m_index_start;
+		run_count = meshlet.m_triangle_count * 3;
+	}
+	m_indices.insert(m_indices.end(), indices + run_start, indices + run_start + run_count);
+
+	m_stats.m_milliseconds += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+const std::vector<unsigned int>& MeshletCuller::getIndices()
+{
+	return m_indices;
+}
+
+
+const MeshletCullStats& MeshletCuller::getStats()
+{
+	return m_stats;
+}
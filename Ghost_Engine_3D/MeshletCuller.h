@@ -0,0 +1,97 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Matrix4x4.h"
+#include <vector>
+
+class MeshModel;
+
+// occlusion culling source for the culling passes. Called from job threads, so it must only read
+class OcclusionTest
+{
+public:
+	virtual ~OcclusionTest() {}
+	// true when the world space sphere is hidden for sure
+	virtual bool isOccluded(const Vector3D& center, float radius) = 0;
+};
+
+// frustum planes of a row vector matrix with unit normals: a point is inside when a x + b y + c z + d >= 0 for all six.
+// The planes are in the space the matrix transforms from
+void getFrustumPlanes(const Matrix4x4& matrix, float planes[6][4]);
+
+struct MeshletCullStats
+{
+	unsigned int m_meshlets = 0;
+	unsigned int m_frustum_culled = 0;
+	unsigned int m_cone_culled = 0;			// facing away from the camera as a whole
+	unsigned int m_occlusion_culled = 0;
+	unsigned int m_triangles = 0;
+	unsigned int m_triangles_culled = 0;
+	double m_milliseconds = 0.0;
+};
+
+
+/*
+	MeshletCuller: culls the meshlets of a mesh on the CPU and builds one index list of the visible ones per frame
+
+	- tests, cheapest first: bounding sphere against the frustum, normal cone against the camera position,
+	  then the optional OcclusionTest
+	- tests run in object space (planes of world * view * proj, camera through the inverse of world * view), so
+	  the meshlet bounds are used without transforming them
+	- the meshlets are tested in parallel on the JobSystem, the visible index ranges are then copied in meshlet order
+	- the indices are written to a dynamic index buffer and drawn with one call (GraphicsEngine::createDynamicIndexBuffer)
+*/
+
+class MeshletCuller
+{
+public:
+
+	MeshletCuller();
+
+	// start a frame: empty index list and stats
+	void begin();
+	// cull the meshlets of one level of a mesh and append the indices of the visible ones
+	void cull(MeshModel* mesh, unsigned int level, const Matrix4x4& world, const Matrix4x4& view, const Matrix4x4& proj, OcclusionTest* occlusion = nullptr);
+
+	const std::vector<unsigned int>& getIndices();
+	// of all cull() calls since begin()
+	const MeshletCullStats& getStats();
+
+private:
+
+	enum CullResult : unsigned char
+	{
+		Visible,
+		FrustumCulled,
+		ConeCulled,
+		OcclusionCulled
+	};
+
+	std::vector<unsigned int> m_indices;
+	std::vector<unsigned char> m_results;
+	MeshletCullStats m_stats;
+};
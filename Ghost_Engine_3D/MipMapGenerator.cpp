@@ -0,0 +1,446 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "MipMapGenerator.h"
+#include "JobSystem.h"
+
+#include <DirectXTex.h>
+#include <emmintrin.h>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+/*
+	Resampling is done with a separable filter kernel. For each destination texel the kernel stores the first source texel
+	and the weights of all source texels under the filter. Source indices outside the image are clamped to the border.
+
+	filter support (radius in destination texels):  Box -> 0.5   Kaiser -> 2.0
+	At a 2x reduction this gives 2 taps (box) and 8 taps (Kaiser) per axis.
+*/
+
+struct FilterTap
+{
+	int m_first;		// first source texel (can be < 0 -> clamped)
+	int m_count;		// number of weights
+	size_t m_weight;	// offset in FilterKernel::m_weights
+};
+
+struct FilterKernel
+{
+	std::vector<FilterTap> m_taps;
+	std::vector<float> m_weights;
+};
+
+
+// zero order modified Bessel function of the first kind (power series) for the Kaiser window
+static float besselI0(float x)
+{
+	float sum = 1.0f;
+	float term = 1.0f;
+	for (int k = 1; k < 16; k++)
+	{
+		term *= (x / (2.0f * k)) * (x / (2.0f * k));
+		sum += term;
+	}
+	return sum;
+}
+
+
+static float evaluateFilter(MipFilter filter, float t)
+{
+	t = fabsf(t);
+
+	if (filter == MipFilter::Box)
+		return (t <= 0.5f) ? 1.0f : 0.0f;
+
+	const float width = 2.0f;
+	const float alpha = 4.0f;
+
+	if (t >= width)
+		return 0.0f;
+
+	float sinc = (t < 1e-5f) ? 1.0f : sinf(3.14159265f * t) / (3.14159265f * t);
+	float ratio = t / width;
+	float window = besselI0(alpha * sqrtf(1.0f - ratio * ratio)) / besselI0(alpha);
+
+	return sinc * window;
+}
+
+
+static void buildKernel(MipFilter filter, int src_size, int dst_size, FilterKernel& kernel)
+{
+	float scale = (float)src_size / (float)dst_size;
+	float support = ((filter == MipFilter::Box) ? 0.5f : 2.0f) * scale;
+
+	kernel.m_taps.resize(dst_size);
+	kernel.m_weights.clear();
+
+	for (int x = 0; x < dst_size; x++)
+	{
+		float center = (x + 0.5f) * scale;
+		int first = (int)floorf(center - support);
+		int last = (int)ceilf(center + support);
+
+		// drop the zero weights at both ends of the window
+		while (first < last && evaluateFilter(filter, (first + 0.5f - center) / scale) == 0.0f) first++;
+		while (last > first && evaluateFilter(filter, (last + 0.5f - center) / scale) == 0.0f) last--;
+
+		FilterTap& tap = kernel.m_taps[x];
+		tap.m_first = first;
+		tap.m_count = last - first + 1;
+		tap.m_weight = kernel.m_weights.size();
+
+		float sum = 0.0f;
+		for (int s = first; s <= last; s++)
+		{
+			float w = evaluateFilter(filter, (s + 0.5f - center) / scale);
+			kernel.m_weights.push_back(w);
+			sum += w;
+		}
+
+		// normalize -> constant color stays constant
+		for (int k = 0; k < tap.m_count; k++)
+		{
+			kernel.m_weights[tap.m_weight + k] /= sum;
+		}
+	}
+}
+
+
+static inline int clampIndex(int i, int size)
+{
+	return (i < 0) ? 0 : ((i >= size) ? size - 1 : i);
+}
+
+
+/*
+	lookup tables for the conversion between 8 bit sRGB and linear float
+	- 256 entries sRGB -> linear
+	- 4096 entries linear -> sRGB (index = linear * 4095)
+*/
+
+struct GammaTables
+{
+	float m_to_linear[256];
+	unsigned char m_to_srgb[4096];
+
+	GammaTables()
+	{
+		for (int i = 0; i < 256; i++)
+		{
+			m_to_linear[i] = MipMapGenerator::toLinear(i / 255.0f);
+		}
+
+		for (int i = 0; i < 4096; i++)
+		{
+			m_to_srgb[i] = (unsigned char)(MipMapGenerator::toSRGB(i / 4095.0f) * 255.0f + 0.5f);
+		}
+	}
+};
+
+static const GammaTables& getGammaTables()
+{
+	static GammaTables tables;
+	return tables;
+}
+
+
+float MipMapGenerator::toLinear(float srgb)
+{
+	return (srgb <= 0.04045f) ? srgb / 12.92f : powf((srgb + 0.055f) / 1.055f, 2.4f);
+}
+
+
+float MipMapGenerator::toSRGB(float linear)
+{
+	return (linear <= 0.0031308f) ? linear * 12.92f : 1.055f * powf(linear, 1.0f / 2.4f) - 0.055f;
+}
+
+
+unsigned int MipMapGenerator::getLevelCount(size_t width, size_t height)
+{
+	unsigned int levels = 1;
+	while (width > 1 || height > 1)
+	{
+		width = (width > 1) ? width / 2 : 1;
+		height = (height > 1) ? height / 2 : 1;
+		levels++;
+	}
+	return levels;
+}
+
+
+double MipMapGenerator::estimateSampledBytes(size_t texels, size_t screen_pixels, bool mipmapped)
+{
+	const double bytes_per_texel = 4.0;
+	const double texels_per_line = 16.0;
+
+	if (screen_pixels == 0)
+		return 0.0;
+
+	double ratio = (double)texels / (double)screen_pixels;
+
+	// magnification or 1:1 -> both cases read each texel about once
+	if (ratio <= 1.0)
+		return (double)texels * bytes_per_texel;
+
+	if (mipmapped)
+		return (double)screen_pixels * bytes_per_texel * 1.25;
+
+	// each pixel touches its own cache line(s) until the lines are as far apart as a whole line
+	double fetched = (double)screen_pixels * bytes_per_texel * ((ratio < texels_per_line) ? ratio : texels_per_line);
+	double all = (double)texels * bytes_per_texel;
+	return (fetched < all) ? fetched : all;
+}
+
+
+/*
+	- horizontal pass: src (src_w x src_h) -> tmp (dst_w x src_h)
+	- vertical pass:   tmp (dst_w x src_h) -> dst (dst_w x dst_h)
+	each texel is 4 floats, one SSE register
+*/
+
+static void filterHorizontal(const float* src, int src_w, float* dst, int dst_w, const FilterKernel& kernel, unsigned int row_begin, unsigned int row_end)
+{
+	for (unsigned int y = row_begin; y < row_end; y++)
+	{
+		const float* src_row = src + (size_t)y * src_w * 4;
+		float* dst_row = dst + (size_t)y * dst_w * 4;
+
+		for (int x = 0; x < dst_w; x++)
+		{
+			const FilterTap& tap = kernel.m_taps[x];
+			const float* weights = &kernel.m_weights[tap.m_weight];
+
+			__m128 acc = _mm_setzero_ps();
+			for (int k = 0; k < tap.m_count; k++)
+			{
+				__m128 texel = _mm_loadu_ps(src_row + clampIndex(tap.m_first + k, src_w) * 4);
+				acc = _mm_add_ps(acc, _mm_mul_ps(texel, _mm_set1_ps(weights[k])));
+			}
+			_mm_storeu_ps(dst_row + x * 4, acc);
+		}
+	}
+}
+
+
+static void filterVertical(const float* src, int src_h, float* dst, int width, const FilterKernel& kernel, unsigned int row_begin, unsigned int row_end)
+{
+	for (unsigned int y = row_begin; y < row_end; y++)
+	{
+		const FilterTap& tap = kernel.m_taps[y];
+		const float* weights = &kernel.m_weights[tap.m_weight];
+		float* dst_row = dst + (size_t)y * width * 4;
+
+		for (int x = 0; x < width; x++)
+		{
+			_mm_storeu_ps(dst_row + x * 4, _mm_setzero_ps());
+		}
+
+		// whole source rows are accumulated one after another -> sequential memory access
+		for (int k = 0; k < tap.m_count; k++)
+		{
+			const float* src_row = src + (size_t)clampIndex(tap.m_first + k, src_h) * width * 4;
+			__m128 w = _mm_set1_ps(weights[k]);
+
+			for (int x = 0; x < width; x++)
+			{
+				__m128 acc = _mm_loadu_ps(dst_row + x * 4);
+				acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(src_row + x * 4), w));
+				_mm_storeu_ps(dst_row + x * 4, acc);
+			}
+		}
+	}
+}
+
+
+static void convertToFloat(const DirectX::Image& image, bool srgb, float* dst, unsigned int row_begin, unsigned int row_end)
+{
+	const GammaTables& tables = getGammaTables();
+
+	for (unsigned int y = row_begin; y < row_end; y++)
+	{
+		const unsigned char* src = image.pixels + y * image.rowPitch;
+		float* row = dst + (size_t)y * image.width * 4;
+
+		for (size_t x = 0; x < image.width; x++)
+		{
+			for (int c = 0; c < 3; c++)
+			{
+				row[x * 4 + c] = srgb ? tables.m_to_linear[src[x * 4 + c]] : src[x * 4 + c] / 255.0f;
+			}
+			row[x * 4 + 3] = src[x * 4 + 3] / 255.0f;
+		}
+	}
+}
+
+
+static void convertToBytes(const float* src, bool srgb, bool normal_map, const DirectX::Image& image, unsigned int row_begin, unsigned int row_end)
+{
+	const GammaTables& tables = getGammaTables();
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	// rgb -> index in the 4096 table, alpha -> 8 bit value
+	const __m128 scale = srgb ? _mm_setr_ps(4095.0f, 4095.0f, 4095.0f, 255.0f) : _mm_set1_ps(255.0f);
+
+	for (unsigned int y = row_begin; y < row_end; y++)
+	{
+		const float* row = src + (size_t)y * image.width * 4;
+		unsigned char* dst = image.pixels + y * image.rowPitch;
+
+		for (size_t x = 0; x < image.width; x++)
+		{
+			__m128 texel = _mm_loadu_ps(row + x * 4);
+
+			if (normal_map)
+			{
+				// [0,1] -> [-1,1], unit length, back to [0,1]. Alpha maps back to itself
+				__m128 normal = _mm_sub_ps(_mm_add_ps(texel, texel), one);
+
+				alignas(16) float squares[4];
+				_mm_store_ps(squares, _mm_mul_ps(normal, normal));
+				float length = sqrtf(squares[0] + squares[1] + squares[2]);
+
+				if (length > 1e-6f)
+				{
+					float scale = 0.5f / length;
+					texel = _mm_add_ps(_mm_mul_ps(normal, _mm_setr_ps(scale, scale, scale, 0.5f)), _mm_set1_ps(0.5f));
+				}
+			}
+
+			texel = _mm_min_ps(_mm_max_ps(texel, zero), one);
+
+			alignas(16) int values[4];
+			_mm_store_si128((__m128i*)values, _mm_cvtps_epi32(_mm_mul_ps(texel, scale)));
+
+			for (int c = 0; c < 3; c++)
+			{
+				dst[x * 4 + c] = srgb ? tables.m_to_srgb[values[c]] : (unsigned char)values[c];
+			}
+			dst[x * 4 + 3] = (unsigned char)values[3];
+		}
+	}
+}
+
+
+bool MipMapGenerator::generate(const DirectX::Image& base, MipFilter filter, MipContent content, DirectX::ScratchImage& mip_chain, MipMapStats* stats, unsigned int max_levels)
+{
+	bool srgb = (content == MipContent::Color);
+	bool normal_map = (content == MipContent::NormalMap);
+	DXGI_FORMAT format = base.format;
+
+	switch (base.format)
+	{
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM_SRGB:
+		// the vectors of a normal map are never gamma encoded, the chain is stored as what it is
+		if (normal_map)
+			format = (base.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) ? DXGI_FORMAT_R8G8B8A8_UNORM : DXGI_FORMAT_B8G8R8A8_UNORM;
+		else
+			srgb = true;
+		break;
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+		break;
+	default:
+		return false;
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	unsigned int levels = getLevelCount(base.width, base.height);
+	if (max_levels > 0 && max_levels < levels)
+		levels = max_levels;
+	if (FAILED(mip_chain.Initialize2D(format, base.width, base.height, 1, levels)))
+		return false;
+
+	// level 0 is a plain copy
+	const DirectX::Image* top = mip_chain.GetImage(0, 0, 0);
+	for (size_t y = 0; y < base.height; y++)
+	{
+		::memcpy(top->pixels + y * top->rowPitch, base.pixels + y * base.rowPitch, base.width * 4);
+	}
+
+	int src_w = (int)base.width;
+	int src_h = (int)base.height;
+
+	std::vector<float> current((size_t)src_w * src_h * 4);
+	std::vector<float> temp;
+	std::vector<float> next;
+
+	JobSystem::get()->parallelFor((unsigned int)src_h, 32, [&](unsigned int begin, unsigned int end)
+	{
+		convertToFloat(base, srgb, current.data(), begin, end);
+	});
+
+	FilterKernel horizontal;
+	FilterKernel vertical;
+
+	for (unsigned int level = 1; level < levels; level++)
+	{
+		int dst_w = (src_w > 1) ? src_w / 2 : 1;
+		int dst_h = (src_h > 1) ? src_h / 2 : 1;
+
+		buildKernel(filter, src_w, dst_w, horizontal);
+		buildKernel(filter, src_h, dst_h, vertical);
+
+		temp.resize((size_t)dst_w * src_h * 4);
+		next.resize((size_t)dst_w * dst_h * 4);
+
+		// small levels are not worth to be split in jobs
+		unsigned int rows = (dst_w >= 64) ? 16 : 1024;
+
+		JobSystem::get()->parallelFor((unsigned int)src_h, rows, [&](unsigned int begin, unsigned int end)
+		{
+			filterHorizontal(current.data(), src_w, temp.data(), dst_w, horizontal, begin, end);
+		});
+
+		const DirectX::Image* image = mip_chain.GetImage(level, 0, 0);
+
+		JobSystem::get()->parallelFor((unsigned int)dst_h, rows, [&](unsigned int begin, unsigned int end)
+		{
+			filterVertical(temp.data(), src_h, next.data(), dst_w, vertical, begin, end);
+			convertToBytes(next.data(), srgb, normal_map, *image, begin, end);
+		});
+
+		current.swap(next);
+		src_w = dst_w;
+		src_h = dst_h;
+	}
+
+	if (stats)
+	{
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		stats->m_levels = levels;
+		stats->m_milliseconds = ms;
+		stats->m_megapixels_per_second = (ms > 0.0) ? (base.width * base.height) / (ms * 1000.0) : 0.0;
+		stats->m_base_bytes = base.width * base.height * 4;
+		stats->m_chain_bytes = mip_chain.GetPixelsSize();
+	}
+
+	return true;
+}
@@ -0,0 +1,97 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <cstddef>
+
+namespace DirectX
+{
+	struct Image;
+	class ScratchImage;
+}
+
+// filter used to reduce one mip level to the next one
+enum class MipFilter
+{
+	Box,			// 2x2 average. Fast, slightly blurry
+	Kaiser			// Kaiser windowed sinc (8 taps per axis). Sharper, keeps detail in the smaller levels
+};
+
+
+// what the texels hold -> how they are filtered
+enum class MipContent
+{
+	Color,			// sRGB color: filtered in linear light
+	Linear,			// linear data (masks, heights). An _SRGB image is still filtered as color
+	NormalMap		// rgb = normal * 0.5 + 0.5, filtered linearly and renormalized. The _SRGB tag of the image is ignored
+};
+
+
+// result of one generate() call
+struct MipMapStats
+{
+	unsigned int m_levels = 1;
+	double m_milliseconds = 0.0;
+	double m_megapixels_per_second = 0.0;	// base level pixels / generation time
+	size_t m_base_bytes = 0;				// memory of level 0 only
+	size_t m_chain_bytes = 0;				// memory of the whole mip chain (~ 4/3 of level 0)
+};
+
+
+/*
+	MipMapGenerator: builds the mip chain of a RGBA8 texture on the CPU
+
+	- gamma correct: sRGB texels are converted to linear light before filtering and back to sRGB after filtering.
+	  Alpha is always filtered linearly
+	- normal maps: the filtered vectors are shorter than 1 where the normals diverge -> every texel of a level is
+	  renormalized. The next level is filtered from the unnormalized floats, like a wider kernel on level 0
+	- separable filter: horizontal pass + vertical pass, each in parallel on the JobSystem (groups of rows)
+	- SIMD: one texel = one __m128 (4 channels in linear float), weights are applied with SSE multiply/add
+	- every level is computed from the float copy of the level above, so the rounding error does not accumulate
+*/
+
+class MipMapGenerator
+{
+public:
+
+	// generate the mip chain of a R8G8B8A8 or B8G8R8A8 image. max_levels = 0 -> complete chain down to 1x1
+	static bool generate(const DirectX::Image& base, MipFilter filter, MipContent content, DirectX::ScratchImage& mip_chain, MipMapStats* stats = nullptr, unsigned int max_levels = 0);
+
+	// number of levels of a complete chain
+	static unsigned int getLevelCount(size_t width, size_t height);
+
+	/*
+		estimated bytes fetched from memory per frame when the texture is drawn over screen_pixels pixels
+		- with mips the sampler reads the level whose texel density matches the screen (+ 1/4 for the second trilinear level)
+		- without mips every pixel fetches texels from level 0 that are texels/screen_pixels apart, so neighbouring pixels
+		  do not share cache lines (a 64 byte line holds 16 texels) and most of the fetched bytes are never used
+	*/
+	static double estimateSampledBytes(size_t texels, size_t screen_pixels, bool mipmapped);
+
+	// linear <-> sRGB for one channel in [0,1]
+	static float toLinear(float srgb);
+	static float toSRGB(float linear);
+};
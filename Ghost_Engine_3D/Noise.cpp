@@ -0,0 +1,349 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "Noise.h"
+#include "JobSystem.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+
+namespace
+{
+#include "NoiseKernels.h"
+
+	/*
+		SSE2 lanes: 4 samples. SSE2 has no 32-bit multiply and no floor, both are built from what it has
+	*/
+
+	struct SseF { __m128 m_v; SseF() {} SseF(__m128 v) : m_v(v) {} SseF(float v) : m_v(_mm_set1_ps(v)) {} };
+	struct SseI { __m128i m_v; SseI() {} SseI(__m128i v) : m_v(v) {} SseI(unsigned int v) : m_v(_mm_set1_epi32((int)v)) {} };
+	struct SseM { __m128 m_v; SseM(__m128 v) : m_v(v) {} };
+
+	inline SseF operator+(SseF a, SseF b) { return _mm_add_ps(a.m_v, b.m_v); }
+	inline SseF operator-(SseF a, SseF b) { return _mm_sub_ps(a.m_v, b.m_v); }
+	inline SseF operator*(SseF a, SseF b) { return _mm_mul_ps(a.m_v, b.m_v); }
+	inline SseI operator+(SseI a, SseI b) { return _mm_add_epi32(a.m_v, b.m_v); }
+	inline SseI operator^(SseI a, SseI b) { return _mm_xor_si128(a.m_v, b.m_v); }
+	inline SseI operator&(SseI a, SseI b) { return _mm_and_si128(a.m_v, b.m_v); }
+	inline SseI operator>>(SseI a, int bits) { return _mm_srli_epi32(a.m_v, bits); }
+
+	// low 32 bits of the products: the even and the odd lanes with two 32 x 32 -> 64 bit multiplies
+	inline SseI operator*(SseI a, SseI b)
+	{
+		__m128i even = _mm_mul_epu32(a.m_v, b.m_v);
+		__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a.m_v, 32), _mm_srli_epi64(b.m_v, 32));
+		return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+	}
+
+	// truncate, then one less where that rounded up (negative values)
+	inline SseF floorF(SseF v)
+	{
+		__m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(v.m_v));
+		return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmplt_ps(v.m_v, truncated), _mm_set1_ps(1.0f)));
+	}
+
+	inline SseF absF(SseF v) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), v.m_v); }
+	inline SseF minF(SseF a, SseF b) { return _mm_min_ps(a.m_v, b.m_v); }
+	inline SseF maxF(SseF a, SseF b) { return _mm_max_ps(a.m_v, b.m_v); }
+	inline SseF sqrtF(SseF v) { return _mm_sqrt_ps(v.m_v); }
+	inline SseI toInt(SseF v) { return _mm_cvttps_epi32(v.m_v); }
+	inline SseF toFloat(SseI v) { return _mm_cvtepi32_ps(v.m_v); }
+	inline SseM lessF(SseF a, SseF b) { return _mm_cmplt_ps(a.m_v, b.m_v); }
+	inline SseM lessEqualF(SseF a, SseF b) { return _mm_cmple_ps(a.m_v, b.m_v); }
+	inline SseM lessI(SseI a, SseI b) { return _mm_castsi128_ps(_mm_cmplt_epi32(a.m_v, b.m_v)); }
+	inline SseM equalI(SseI a, SseI b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(a.m_v, b.m_v)); }
+	inline SseM orM(SseM a, SseM b) { return _mm_or_ps(a.m_v, b.m_v); }
+	inline SseF selectF(SseM mask, SseF a, SseF b) { return _mm_or_ps(_mm_and_ps(mask.m_v, a.m_v), _mm_andnot_ps(mask.m_v, b.m_v)); }
+	inline SseF flipSign(SseF v, SseI bit) { return _mm_xor_ps(v.m_v, _mm_castsi128_ps(_mm_slli_epi32(bit.m_v, 31))); }
+
+	struct NoiseSse2
+	{
+		typedef SseF F;
+		typedef SseI I;
+		typedef SseM M;
+		static const unsigned int WIDTH = 4;
+
+		static I lanes() { return _mm_setr_epi32(0, 1, 2, 3); }
+		static void store(float* out, F value) { _mm_storeu_ps(out, value.m_v); }
+	};
+
+
+	bool hasAvx2()
+	{
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		// AVX and the OS saves the YMM registers (OSXSAVE, XCR0 bits 1 and 2)
+		__cpuid(info, 1);
+		if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2") != 0;
+#endif
+	}
+
+	std::atomic<NoiseBackend>& currentBackend()
+	{
+		static std::atomic<NoiseBackend> backend(hasAvx2() ? NoiseBackend::AVX2 : NoiseBackend::SSE2);
+		return backend;
+	}
+}
+
+
+NoiseBackend Noise::getBackend()
+{
+	return currentBackend().load();
+}
+
+
+void Noise::setBackend(NoiseBackend backend)
+{
+	if (!isSupported(backend))
+		backend = isSupported(NoiseBackend::AVX2) ? NoiseBackend::AVX2 : NoiseBackend::SSE2;
+	currentBackend().store(backend);
+}
+
+
+bool Noise::isSupported(NoiseBackend backend)
+{
+	static const bool avx2 = hasAvx2();
+	return backend != NoiseBackend::AVX2 || avx2;
+}
+
+
+const char* Noise::getBackendName(NoiseBackend backend)
+{
+	switch (backend)
+	{
+	case NoiseBackend::Scalar: return "Scalar";
+	case NoiseBackend::SSE2: return "SSE2";
+	default: return "AVX2";
+	}
+}
+
+
+const char* Noise::getTypeName(NoiseType type)
+{
+	switch (type)
+	{
+	case NoiseType::Value: return "Value";
+	case NoiseType::Perlin: return "Perlin";
+	case NoiseType::Simplex: return "Simplex";
+	default: return "Cellular";
+	}
+}
+
+
+float Noise::sample2D(const NoiseSettings& settings, float x, float y)
+{
+	float value = 0.0f;
+	noiseRow<NoiseScalar>(settings, &value, 1, x, 0.0f, y, 0.0f, false);
+	return value;
+}
+
+
+float Noise::sample3D(const NoiseSettings& settings, float x, float y, float z)
+{
+	float value = 0.0f;
+	noiseRow<NoiseScalar>(settings, &value, 1, x, 0.0f, y, z, true);
+	return value;
+}
+
+
+void Noise::fillRow(NoiseBackend backend, const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y, float z, bool volume)
+{
+	switch (backend)
+	{
+	case NoiseBackend::Scalar: noiseRow<NoiseScalar>(settings, out, count, x0, step, y, z, volume); break;
+	case NoiseBackend::SSE2: noiseRow<NoiseSse2>(settings, out, count, x0, step, y, z, volume); break;
+	default: fillRowAvx2(settings, out, count, x0, step, y, z, volume); break;
+	}
+}
+
+
+void Noise::fillRow2D(const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y)
+{
+	fillRow(getBackend(), settings, out, count, x0, step, y, 0.0f, false);
+}
+
+
+void Noise::fillRow3D(const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y, float z)
+{
+	fillRow(getBackend(), settings, out, count, x0, step, y, z, true);
+}
+
+
+/*
+	groups of rows on the JobSystem: a row of a large grid is long enough to hide the cost of a job
+*/
+
+void Noise::fill2D(const NoiseSettings& settings, unsigned int width, unsigned int height, float* out)
+{
+	NoiseBackend backend = getBackend();
+	JobSystem::get()->parallelFor(height, 4, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int y = begin; y < end; y++)
+				fillRow(backend, settings, out + (size_t)y * width, width, 0.0f, 1.0f, (float)y, 0.0f, false);
+		});
+}
+
+
+void Noise::fill3D(const NoiseSettings& settings, unsigned int width, unsigned int height, unsigned int depth, float* out)
+{
+	NoiseBackend backend = getBackend();
+	JobSystem::get()->parallelFor(height * depth, 4, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int row = begin; row < end; row++)
+				fillRow(backend, settings, out + (size_t)row * width, width, 0.0f, 1.0f, (float)(row % height), (float)(row / height), true);
+		});
+}
+
+
+void Noise::fillHeights(const NoiseSettings& settings, unsigned int width, unsigned int height, unsigned short* out)
+{
+	NoiseBackend backend = getBackend();
+	JobSystem::get()->parallelFor(height, 4, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<float> row(width);
+			for (unsigned int y = begin; y < end; y++)
+			{
+				fillRow(backend, settings, row.data(), width, 0.0f, 1.0f, (float)y, 0.0f, false);
+				for (unsigned int x = 0; x < width; x++)
+					out[(size_t)y * width + x] = toHeight(row[x]);
+			}
+		});
+}
+
+
+void Noise::fillTexels(const NoiseSettings& settings, unsigned int width, unsigned int height, unsigned char* out)
+{
+	NoiseBackend backend = getBackend();
+	JobSystem::get()->parallelFor(height, 4, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<float> row(width);
+			for (unsigned int y = begin; y < end; y++)
+			{
+				fillRow(backend, settings, row.data(), width, 0.0f, 1.0f, (float)y, 0.0f, false);
+				for (unsigned int x = 0; x < width; x++)
+					out[(size_t)y * width + x] = toTexel(row[x]);
+			}
+		});
+}
+
+
+unsigned short Noise::toHeight(float value)
+{
+	return (unsigned short)(std::min(std::max(value * 0.5f + 0.5f, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+
+unsigned char Noise::toTexel(float value)
+{
+	return (unsigned char)(std::min(std::max(value * 0.5f + 0.5f, 0.0f), 1.0f) * 255.0f + 0.5f);
+}
+
+
+/*
+	- single octave at 1/16 cells per sample, so the cells are larger than a SIMD row segment like in real use
+	- one thread: the rows one after the other on the calling thread. All threads: fill2D / fill3D
+	- 3D: size x size / 8 x 8 samples, the same count as 2D
+	- restores the selected backend
+*/
+
+void Noise::runBenchmark(unsigned int size, std::vector<NoiseBenchmarkResult>& results)
+{
+	results.clear();
+	size = std::max(size, 8u);
+
+	NoiseBackend selected = getBackend();
+	std::vector<float> grid((size_t)size * size);
+	double samples = (double)size * size;
+
+	auto seconds = [](std::chrono::high_resolution_clock::time_point start)
+	{
+		return std::max(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count(), 1e-9);
+	};
+
+	NoiseBackend backends[] = { NoiseBackend::Scalar, NoiseBackend::SSE2, NoiseBackend::AVX2 };
+	NoiseType types[] = { NoiseType::Value, NoiseType::Perlin, NoiseType::Simplex, NoiseType::Cellular };
+
+	for (NoiseBackend backend : backends)
+	{
+		if (!isSupported(backend))
+			continue;
+		currentBackend().store(backend);
+
+		for (int volume = 0; volume < 2; volume++)
+		{
+			for (NoiseType type : types)
+			{
+				NoiseSettings settings;
+				settings.m_type = type;
+				settings.m_fractal = NoiseFractal::None;
+				settings.m_frequency = 1.0f / 16.0f;
+
+				NoiseBenchmarkResult result;
+				result.m_type = type;
+				result.m_backend = backend;
+				result.m_volume = volume != 0;
+
+				auto start = std::chrono::high_resolution_clock::now();
+				for (unsigned int row = 0; row < size; row++)
+				{
+					if (volume)
+						fillRow(backend, settings, grid.data() + (size_t)row * size, size, 0.0f, 1.0f, (float)(row % (size / 8)), (float)(row / (size / 8)), true);
+					else
+						fillRow(backend, settings, grid.data() + (size_t)row * size, size, 0.0f, 1.0f, (float)row, 0.0f, false);
+				}
+				result.m_samples_per_second = samples / seconds(start);
+
+				start = std::chrono::high_resolution_clock::now();
+				if (volume)
+					fill3D(settings, size, size / 8, 8, grid.data());
+				else
+					fill2D(settings, size, size, grid.data());
+				result.m_samples_per_second_mt = samples / seconds(start);
+
+				results.push_back(result);
+			}
+		}
+	}
+
+	currentBackend().store(selected);
+}
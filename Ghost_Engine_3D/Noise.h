@@ -0,0 +1,127 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <vector>
+
+enum class NoiseType
+{
+	Value,			// random values at the lattice points, interpolated. Blocky, cheapest
+	Perlin,			// gradients at the lattice points. Smooth, the usual terrain noise
+	Simplex,		// gradients on a simplex lattice. Fewer corners in 3D, no axis artifacts. Never periodic
+	Cellular		// distance to the nearest jittered feature point (Worley F1): cells, cracks, stones
+};
+
+enum class NoiseFractal
+{
+	None,			// one octave
+	FBm,			// sum of octaves with rising frequency and falling amplitude
+	Ridged			// sum of (1 - |noise|)^2: sharp crests, mountain ranges
+};
+
+// instruction set of the bulk fills. The best one the CPU supports is chosen at start
+enum class NoiseBackend
+{
+	Scalar,			// 1 sample per instruction, the reference
+	SSE2,			// 4 samples
+	AVX2			// 8 samples
+};
+
+
+struct NoiseSettings
+{
+	NoiseType m_type = NoiseType::Perlin;
+	NoiseFractal m_fractal = NoiseFractal::FBm;
+	unsigned int m_seed = 1337;
+	float m_frequency = 1.0f;				// lattice cells per unit of the coordinates
+	unsigned int m_octaves = 4;
+	float m_lacunarity = 2.0f;				// frequency factor from one octave to the next
+	float m_gain = 0.5f;					// amplitude factor from one octave to the next
+	unsigned int m_period = 0;				// repeat after this many cells (a power of two), 0 -> no repeat. Needs lacunarity 2
+};
+
+
+// one type and backend of runBenchmark()
+struct NoiseBenchmarkResult
+{
+	NoiseType m_type = NoiseType::Perlin;
+	NoiseBackend m_backend = NoiseBackend::Scalar;
+	bool m_volume = false;					// 3D noise
+	double m_samples_per_second = 0.0;		// on one thread
+	double m_samples_per_second_mt = 0.0;	// fill2D / fill3D on all threads of the JobSystem
+};
+
+
+/*
+	Noise: procedural noise for terrain and textures
+
+	- value, Perlin, simplex and cellular noise in 2D and 3D, single octave, fBm or ridged. Output in [-1, 1]
+	- the bulk fills evaluate a row of samples with SIMD: 4 (SSE2) or 8 (AVX2) samples per instruction, and fill the
+	  rows of a grid in parallel on the JobSystem
+	- deterministic: the same settings and coordinates give the same value on every backend, thread count and run.
+	  sample2D() and a fill agree, so a single height can be computed without filling the map
+	- periodic: with m_period the noise repeats after that many lattice cells -> tileable textures
+	- all members are static, the backend is shared by all threads
+*/
+
+class Noise
+{
+public:
+
+	static NoiseBackend getBackend();
+	// an unsupported backend falls back to the best supported one
+	static void setBackend(NoiseBackend backend);
+	static bool isSupported(NoiseBackend backend);
+	static const char* getBackendName(NoiseBackend backend);
+	static const char* getTypeName(NoiseType type);
+
+	// one sample at (x, y) or (x, y, z), always scalar
+	static float sample2D(const NoiseSettings& settings, float x, float y);
+	static float sample3D(const NoiseSettings& settings, float x, float y, float z);
+
+	// count samples of one row at x = x0 + i * step, on the calling thread
+	static void fillRow2D(const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y);
+	static void fillRow3D(const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y, float z);
+
+	// grids with one sample per integer coordinate, row by row (and slice by slice), rows in parallel
+	static void fill2D(const NoiseSettings& settings, unsigned int width, unsigned int height, float* out);
+	static void fill3D(const NoiseSettings& settings, unsigned int width, unsigned int height, unsigned int depth, float* out);
+	// fill2D mapped from [-1, 1] to heights 0 - 65535 or texels 0 - 255
+	static void fillHeights(const NoiseSettings& settings, unsigned int width, unsigned int height, unsigned short* out);
+	static void fillTexels(const NoiseSettings& settings, unsigned int width, unsigned int height, unsigned char* out);
+
+	static unsigned short toHeight(float value);
+	static unsigned char toTexel(float value);
+
+	// samples per second of every type, 2D and 3D, on every supported backend: size^2 samples each, one octave
+	static void runBenchmark(unsigned int size, std::vector<NoiseBenchmarkResult>& results);
+
+private:
+
+	static void fillRow(NoiseBackend backend, const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y, float z, bool volume);
+	// NoiseAvx2.cpp, the only file compiled with AVX2
+	static void fillRowAvx2(const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y, float z, bool volume);
+};
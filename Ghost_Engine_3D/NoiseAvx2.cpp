@@ -0,0 +1,85 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "Noise.h"
+
+#include <immintrin.h>
+#include <cmath>
+
+/*
+	The AVX2 backend of Noise: the only file compiled with AVX2 (EnableEnhancedInstructionSet in the project), and only
+	called after Noise checked the CPU. No fused multiply-add, so the values stay the same as on SSE2 and scalar
+*/
+
+namespace
+{
+#include "NoiseKernels.h"
+
+	struct AvxF { __m256 m_v; AvxF() {} AvxF(__m256 v) : m_v(v) {} AvxF(float v) : m_v(_mm256_set1_ps(v)) {} };
+	struct AvxI { __m256i m_v; AvxI() {} AvxI(__m256i v) : m_v(v) {} AvxI(unsigned int v) : m_v(_mm256_set1_epi32((int)v)) {} };
+	struct AvxM { __m256 m_v; AvxM(__m256 v) : m_v(v) {} };
+
+	inline AvxF operator+(AvxF a, AvxF b) { return _mm256_add_ps(a.m_v, b.m_v); }
+	inline AvxF operator-(AvxF a, AvxF b) { return _mm256_sub_ps(a.m_v, b.m_v); }
+	inline AvxF operator*(AvxF a, AvxF b) { return _mm256_mul_ps(a.m_v, b.m_v); }
+	inline AvxI operator+(AvxI a, AvxI b) { return _mm256_add_epi32(a.m_v, b.m_v); }
+	inline AvxI operator*(AvxI a, AvxI b) { return _mm256_mullo_epi32(a.m_v, b.m_v); }
+	inline AvxI operator^(AvxI a, AvxI b) { return _mm256_xor_si256(a.m_v, b.m_v); }
+	inline AvxI operator&(AvxI a, AvxI b) { return _mm256_and_si256(a.m_v, b.m_v); }
+	inline AvxI operator>>(AvxI a, int bits) { return _mm256_srli_epi32(a.m_v, bits); }
+
+	inline AvxF floorF(AvxF v) { return _mm256_floor_ps(v.m_v); }
+	inline AvxF absF(AvxF v) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), v.m_v); }
+	inline AvxF minF(AvxF a, AvxF b) { return _mm256_min_ps(a.m_v, b.m_v); }
+	inline AvxF maxF(AvxF a, AvxF b) { return _mm256_max_ps(a.m_v, b.m_v); }
+	inline AvxF sqrtF(AvxF v) { return _mm256_sqrt_ps(v.m_v); }
+	inline AvxI toInt(AvxF v) { return _mm256_cvttps_epi32(v.m_v); }
+	inline AvxF toFloat(AvxI v) { return _mm256_cvtepi32_ps(v.m_v); }
+	inline AvxM lessF(AvxF a, AvxF b) { return _mm256_cmp_ps(a.m_v, b.m_v, _CMP_LT_OQ); }
+	inline AvxM lessEqualF(AvxF a, AvxF b) { return _mm256_cmp_ps(a.m_v, b.m_v, _CMP_LE_OQ); }
+	inline AvxM lessI(AvxI a, AvxI b) { return _mm256_castsi256_ps(_mm256_cmpgt_epi32(b.m_v, a.m_v)); }
+	inline AvxM equalI(AvxI a, AvxI b) { return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a.m_v, b.m_v)); }
+	inline AvxM orM(AvxM a, AvxM b) { return _mm256_or_ps(a.m_v, b.m_v); }
+	inline AvxF selectF(AvxM mask, AvxF a, AvxF b) { return _mm256_blendv_ps(b.m_v, a.m_v, mask.m_v); }
+	inline AvxF flipSign(AvxF v, AvxI bit) { return _mm256_xor_ps(v.m_v, _mm256_castsi256_ps(_mm256_slli_epi32(bit.m_v, 31))); }
+
+	struct NoiseAvx2
+	{
+		typedef AvxF F;
+		typedef AvxI I;
+		typedef AvxM M;
+		static const unsigned int WIDTH = 8;
+
+		static I lanes() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+		static void store(float* out, F value) { _mm256_storeu_ps(out, value.m_v); }
+	};
+}
+
+
+void Noise::fillRowAvx2(const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y, float z, bool volume)
+{
+	noiseRow<NoiseAvx2>(settings, out, count, x0, step, y, z, volume);
+}
@@ -0,0 +1,507 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	NoiseKernels: the noise functions of Noise, written once for every backend
+
+	- every backend includes this file inside an unnamed namespace after defining its lane type V:
+		V::F, V::I, V::M	float, 32-bit integer and mask of WIDTH lanes
+		V::WIDTH			samples per instruction (scalar 1, SSE2 4, AVX2 8)
+		V::lanes()			integers 0 ... WIDTH - 1
+		V::store()			write the lanes to memory
+	  and the operators and functions below for its types. Each backend gets its own copy of the templates, compiled
+	  with its own instruction set -> the linker can never mix an AVX2 instance into the SSE2 code
+	- no branches on values: corners, gradients and simplex ordering are selected with masks, so every lane of a
+	  vector runs the same instructions
+	- the same operations in the same order on every backend, without fused multiply-add -> the same values
+	- no includes here: the file is included inside a namespace
+*/
+
+// spread the lattice coordinates before hashing (FastNoise primes)
+static const unsigned int NOISE_PRIME_X = 501125321u;
+static const unsigned int NOISE_PRIME_Y = 1136930381u;
+static const unsigned int NOISE_PRIME_Z = 1720413743u;
+
+
+/*
+	scalar lanes: the reference and the tail of the grids
+*/
+
+inline float floorF(float v) { return floorf(v); }
+inline float absF(float v) { return fabsf(v); }
+inline float minF(float a, float b) { return a < b ? a : b; }
+inline float maxF(float a, float b) { return a > b ? a : b; }
+inline float sqrtF(float v) { return sqrtf(v); }
+inline unsigned int toInt(float v) { return (unsigned int)(int)v; }
+inline float toFloat(unsigned int v) { return (float)(int)v; }
+inline bool lessF(float a, float b) { return a < b; }
+inline bool lessEqualF(float a, float b) { return a <= b; }
+inline bool lessI(unsigned int a, unsigned int b) { return (int)a < (int)b; }
+inline bool equalI(unsigned int a, unsigned int b) { return a == b; }
+inline bool orM(bool a, bool b) { return a || b; }
+inline float selectF(bool mask, float a, float b) { return mask ? a : b; }
+// bit is 0 or 1: flip the sign for 1
+inline float flipSign(float v, unsigned int bit) { return bit ? -v : v; }
+
+struct NoiseScalar
+{
+	typedef float F;
+	typedef unsigned int I;
+	typedef bool M;
+	static const unsigned int WIDTH = 1;
+
+	static I lanes() { return 0; }
+	static void store(float* out, F value) { *out = value; }
+};
+
+
+template <class I>
+inline I hashLattice(I seed, I x, I y)
+{
+	I hash = seed ^ x ^ y;
+	hash = hash * I(0x27d4eb2du);
+	return hash ^ (hash >> 15);
+}
+
+template <class I>
+inline I hashLattice(I seed, I x, I y, I z)
+{
+	I hash = seed ^ x ^ y ^ z;
+	hash = hash * I(0x27d4eb2du);
+	return hash ^ (hash >> 15);
+}
+
+// 16 bits of the hash to [-1, 1]
+template <class V>
+inline typename V::F hashToFloat(typename V::I hash)
+{
+	typedef typename V::F F;
+	return toFloat(hash & typename V::I(0xffff)) * F(2.0f / 65535.0f) - F(1.0f);
+}
+
+template <class F>
+inline F quintic(F t)
+{
+	return t * t * t * (t * (t * F(6.0f) - F(15.0f)) + F(10.0f));
+}
+
+template <class F>
+inline F lerpF(F a, F b, F t)
+{
+	return a + (b - a) * t;
+}
+
+/*
+	gradient of improved Perlin noise: one of the 12 edge directions of a cube, picked by the low 4 bits of the hash.
+	2D noise passes z = 0
+*/
+template <class V>
+inline typename V::F gradient(typename V::I hash, typename V::F x, typename V::F y, typename V::F z)
+{
+	typedef typename V::I I;
+	I h = hash & I(15);
+	typename V::F u = selectF(lessI(h, I(8)), x, y);
+	typename V::F v = selectF(lessI(h, I(4)), y, selectF(orM(equalI(h, I(12)), equalI(h, I(14))), x, z));
+	return flipSign(u, h & I(1)) + flipSign(v, (h >> 1) & I(1));
+}
+
+
+// the lattice cell of a coordinate and the position in it
+template <class V>
+inline void splitCell(typename V::F p, typename V::I& cell, typename V::F& fraction)
+{
+	typename V::F floored = floorF(p);
+	cell = toInt(floored);
+	fraction = p - floored;
+}
+
+
+/*
+	value noise: a random value per lattice point, quintic interpolation
+	period_mask: the lattice coordinates are wrapped with it (period - 1), all bits set -> no period
+*/
+
+template <class V>
+typename V::F valueNoise(typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	I xi, yi;
+	F tx, ty;
+	splitCell<V>(x, xi, tx);
+	splitCell<V>(y, yi, ty);
+
+	I x0 = (xi & period_mask) * I(NOISE_PRIME_X), x1 = ((xi + I(1)) & period_mask) * I(NOISE_PRIME_X);
+	I y0 = (yi & period_mask) * I(NOISE_PRIME_Y), y1 = ((yi + I(1)) & period_mask) * I(NOISE_PRIME_Y);
+
+	F sx = quintic(tx), sy = quintic(ty);
+	F top = lerpF(hashToFloat<V>(hashLattice(seed, x0, y0)), hashToFloat<V>(hashLattice(seed, x1, y0)), sx);
+	F bottom = lerpF(hashToFloat<V>(hashLattice(seed, x0, y1)), hashToFloat<V>(hashLattice(seed, x1, y1)), sx);
+	return lerpF(top, bottom, sy);
+}
+
+template <class V>
+typename V::F valueNoise(typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y, typename V::F z)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	I xi, yi, zi;
+	F tx, ty, tz;
+	splitCell<V>(x, xi, tx);
+	splitCell<V>(y, yi, ty);
+	splitCell<V>(z, zi, tz);
+
+	I x0 = (xi & period_mask) * I(NOISE_PRIME_X), x1 = ((xi + I(1)) & period_mask) * I(NOISE_PRIME_X);
+	I y0 = (yi & period_mask) * I(NOISE_PRIME_Y), y1 = ((yi + I(1)) & period_mask) * I(NOISE_PRIME_Y);
+	I z0 = (zi & period_mask) * I(NOISE_PRIME_Z), z1 = ((zi + I(1)) & period_mask) * I(NOISE_PRIME_Z);
+
+	F sx = quintic(tx), sy = quintic(ty), sz = quintic(tz);
+	F near_top = lerpF(hashToFloat<V>(hashLattice(seed, x0, y0, z0)), hashToFloat<V>(hashLattice(seed, x1, y0, z0)), sx);
+	F near_bottom = lerpF(hashToFloat<V>(hashLattice(seed, x0, y1, z0)), hashToFloat<V>(hashLattice(seed, x1, y1, z0)), sx);
+	F far_top = lerpF(hashToFloat<V>(hashLattice(seed, x0, y0, z1)), hashToFloat<V>(hashLattice(seed, x1, y0, z1)), sx);
+	F far_bottom = lerpF(hashToFloat<V>(hashLattice(seed, x0, y1, z1)), hashToFloat<V>(hashLattice(seed, x1, y1, z1)), sx);
+	return lerpF(lerpF(near_top, near_bottom, sy), lerpF(far_top, far_bottom, sy), sz);
+}
+
+
+/*
+	Perlin noise: a gradient per lattice point, the dot products with the offsets interpolated (quintic)
+*/
+
+template <class V>
+typename V::F perlinNoise(typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	I xi, yi;
+	F tx, ty;
+	splitCell<V>(x, xi, tx);
+	splitCell<V>(y, yi, ty);
+
+	I x0 = (xi & period_mask) * I(NOISE_PRIME_X), x1 = ((xi + I(1)) & period_mask) * I(NOISE_PRIME_X);
+	I y0 = (yi & period_mask) * I(NOISE_PRIME_Y), y1 = ((yi + I(1)) & period_mask) * I(NOISE_PRIME_Y);
+
+	F zero(0.0f), one(1.0f);
+	F sx = quintic(tx), sy = quintic(ty);
+	F top = lerpF(gradient<V>(hashLattice(seed, x0, y0), tx, ty, zero), gradient<V>(hashLattice(seed, x1, y0), tx - one, ty, zero), sx);
+	F bottom = lerpF(gradient<V>(hashLattice(seed, x0, y1), tx, ty - one, zero), gradient<V>(hashLattice(seed, x1, y1), tx - one, ty - one, zero), sx);
+	return lerpF(top, bottom, sy);
+}
+
+template <class V>
+typename V::F perlinNoise(typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y, typename V::F z)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	I xi, yi, zi;
+	F tx, ty, tz;
+	splitCell<V>(x, xi, tx);
+	splitCell<V>(y, yi, ty);
+	splitCell<V>(z, zi, tz);
+
+	I x0 = (xi & period_mask) * I(NOISE_PRIME_X), x1 = ((xi + I(1)) & period_mask) * I(NOISE_PRIME_X);
+	I y0 = (yi & period_mask) * I(NOISE_PRIME_Y), y1 = ((yi + I(1)) & period_mask) * I(NOISE_PRIME_Y);
+	I z0 = (zi & period_mask) * I(NOISE_PRIME_Z), z1 = ((zi + I(1)) & period_mask) * I(NOISE_PRIME_Z);
+
+	F one(1.0f);
+	F ux = tx - one, uy = ty - one, uz = tz - one;
+	F sx = quintic(tx), sy = quintic(ty), sz = quintic(tz);
+	F near_top = lerpF(gradient<V>(hashLattice(seed, x0, y0, z0), tx, ty, tz), gradient<V>(hashLattice(seed, x1, y0, z0), ux, ty, tz), sx);
+	F near_bottom = lerpF(gradient<V>(hashLattice(seed, x0, y1, z0), tx, uy, tz), gradient<V>(hashLattice(seed, x1, y1, z0), ux, uy, tz), sx);
+	F far_top = lerpF(gradient<V>(hashLattice(seed, x0, y0, z1), tx, ty, uz), gradient<V>(hashLattice(seed, x1, y0, z1), ux, ty, uz), sx);
+	F far_bottom = lerpF(gradient<V>(hashLattice(seed, x0, y1, z1), tx, uy, uz), gradient<V>(hashLattice(seed, x1, y1, z1), ux, uy, uz), sx);
+	return lerpF(lerpF(near_top, near_bottom, sy), lerpF(far_top, far_bottom, sy), sz);
+}
+
+
+/*
+	simplex noise (Gustavson): the skewed lattice of triangles / tetrahedra, a radial falloff per corner instead of
+	interpolation. The corner order comes from comparisons of the offsets. Not periodic: the skewed lattice does not
+	repeat on the axes
+*/
+
+template <class V>
+inline typename V::F simplexCorner(typename V::I hash, typename V::F x, typename V::F y, typename V::F z, float radius)
+{
+	typedef typename V::F F;
+	F t = maxF(F(radius) - x * x - y * y - z * z, F(0.0f));
+	t = t * t;
+	return t * t * gradient<V>(hash, x, y, z);
+}
+
+template <class V>
+typename V::F simplexNoise(typename V::I seed, typename V::F x, typename V::F y)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	const float skew = 0.36602540378f;			// (sqrt(3) - 1) / 2
+	const float unskew = 0.21132486540f;		// (3 - sqrt(3)) / 6
+
+	F s = (x + y) * F(skew);
+	F i = floorF(x + s), j = floorF(y + s);
+	F t = (i + j) * F(unskew);
+	F x0 = x - (i - t), y0 = y - (j - t);
+
+	// upper or lower triangle of the skewed cell
+	F zero(0.0f), one(1.0f);
+	F i1 = selectF(lessF(y0, x0), one, zero);
+	F j1 = one - i1;
+
+	F x1 = x0 - i1 + F(unskew), y1 = y0 - j1 + F(unskew);
+	F x2 = x0 - one + F(2.0f * unskew), y2 = y0 - one + F(2.0f * unskew);
+
+	I xp = toInt(i) * I(NOISE_PRIME_X), yp = toInt(j) * I(NOISE_PRIME_Y);
+	I n0 = hashLattice(seed, xp, yp);
+	I n1 = hashLattice(seed, xp + toInt(i1) * I(NOISE_PRIME_X), yp + toInt(j1) * I(NOISE_PRIME_Y));
+	I n2 = hashLattice(seed, xp + I(NOISE_PRIME_X), yp + I(NOISE_PRIME_Y));
+
+	F sum = simplexCorner<V>(n0, x0, y0, zero, 0.5f) + simplexCorner<V>(n1, x1, y1, zero, 0.5f) + simplexCorner<V>(n2, x2, y2, zero, 0.5f);
+	return sum * F(70.0f);
+}
+
+template <class V>
+typename V::F simplexNoise(typename V::I seed, typename V::F x, typename V::F y, typename V::F z)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	const float skew = 1.0f / 3.0f;
+	const float unskew = 1.0f / 6.0f;
+
+	F s = (x + y + z) * F(skew);
+	F i = floorF(x + s), j = floorF(y + s), k = floorF(z + s);
+	F t = (i + j + k) * F(unskew);
+	F x0 = x - (i - t), y0 = y - (j - t), z0 = z - (k - t);
+
+	// rank of each axis among the offsets (0 - 2, ties broken by axis order): the largest steps first
+	F zero(0.0f), one(1.0f);
+	F rank_x = selectF(lessEqualF(y0, x0), one, zero) + selectF(lessEqualF(z0, x0), one, zero);
+	F rank_y = selectF(lessF(x0, y0), one, zero) + selectF(lessEqualF(z0, y0), one, zero);
+	F rank_z = selectF(lessF(x0, z0), one, zero) + selectF(lessF(y0, z0), one, zero);
+
+	F i1 = selectF(lessF(F(1.5f), rank_x), one, zero), j1 = selectF(lessF(F(1.5f), rank_y), one, zero), k1 = selectF(lessF(F(1.5f), rank_z), one, zero);
+	F i2 = selectF(lessF(F(0.5f), rank_x), one, zero), j2 = selectF(lessF(F(0.5f), rank_y), one, zero), k2 = selectF(lessF(F(0.5f), rank_z), one, zero);
+
+	F x1 = x0 - i1 + F(unskew), y1 = y0 - j1 + F(unskew), z1 = z0 - k1 + F(unskew);
+	F x2 = x0 - i2 + F(2.0f * unskew), y2 = y0 - j2 + F(2.0f * unskew), z2 = z0 - k2 + F(2.0f * unskew);
+	F x3 = x0 - one + F(3.0f * unskew), y3 = y0 - one + F(3.0f * unskew), z3 = z0 - one + F(3.0f * unskew);
+
+	I xp = toInt(i) * I(NOISE_PRIME_X), yp = toInt(j) * I(NOISE_PRIME_Y), zp = toInt(k) * I(NOISE_PRIME_Z);
+	I n0 = hashLattice(seed, xp, yp, zp);
+	I n1 = hashLattice(seed, xp + toInt(i1) * I(NOISE_PRIME_X), yp + toInt(j1) * I(NOISE_PRIME_Y), zp + toInt(k1) * I(NOISE_PRIME_Z));
+	I n2 = hashLattice(seed, xp + toInt(i2) * I(NOISE_PRIME_X), yp + toInt(j2) * I(NOISE_PRIME_Y), zp + toInt(k2) * I(NOISE_PRIME_Z));
+	I n3 = hashLattice(seed, xp + I(NOISE_PRIME_X), yp + I(NOISE_PRIME_Y), zp + I(NOISE_PRIME_Z));
+
+	F sum = simplexCorner<V>(n0, x0, y0, z0, 0.6f) + simplexCorner<V>(n1, x1, y1, z1, 0.6f) +
+		simplexCorner<V>(n2, x2, y2, z2, 0.6f) + simplexCorner<V>(n3, x3, y3, z3, 0.6f);
+	return sum * F(32.0f);
+}
+
+
+/*
+	cellular noise (Worley): one feature point per cell, jittered up to 0.45 from the center so the nearest one is
+	always in the 3 x 3 (x 3) cells around the sample. Distance to the nearest point (F1), scaled to [-1, 1]
+*/
+
+template <class V>
+typename V::F cellularNoise(typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	I xi, yi;
+	F tx, ty;
+	splitCell<V>(x, xi, tx);
+	splitCell<V>(y, yi, ty);
+
+	const float jitter = 0.9f / 65535.0f;
+	F nearest(8.0f);
+	for (int dy = -1; dy <= 1; dy++)
+	{
+		I yp = ((yi + I((unsigned int)dy)) & period_mask) * I(NOISE_PRIME_Y);
+		for (int dx = -1; dx <= 1; dx++)
+		{
+			I hash = hashLattice(seed, ((xi + I((unsigned int)dx)) & period_mask) * I(NOISE_PRIME_X), yp);
+			F px = F((float)dx + 0.05f) + toFloat(hash & I(0xffff)) * F(jitter) - tx;
+			F py = F((float)dy + 0.05f) + toFloat((hash >> 16) & I(0xffff)) * F(jitter) - ty;
+			nearest = minF(nearest, px * px + py * py);
+		}
+	}
+	return minF(sqrtF(nearest), F(1.0f)) * F(2.0f) - F(1.0f);
+}
+
+template <class V>
+typename V::F cellularNoise(typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y, typename V::F z)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	I xi, yi, zi;
+	F tx, ty, tz;
+	splitCell<V>(x, xi, tx);
+	splitCell<V>(y, yi, ty);
+	splitCell<V>(z, zi, tz);
+
+	const float jitter = 0.9f / 1023.0f;
+	F nearest(8.0f);
+	for (int dz = -1; dz <= 1; dz++)
+	{
+		I zp = ((zi + I((unsigned int)dz)) & period_mask) * I(NOISE_PRIME_Z);
+		for (int dy = -1; dy <= 1; dy++)
+		{
+			I yp = ((yi + I((unsigned int)dy)) & period_mask) * I(NOISE_PRIME_Y);
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				I hash = hashLattice(seed, ((xi + I((unsigned int)dx)) & period_mask) * I(NOISE_PRIME_X), yp, zp);
+				F px = F((float)dx + 0.05f) + toFloat(hash & I(1023)) * F(jitter) - tx;
+				F py = F((float)dy + 0.05f) + toFloat((hash >> 10) & I(1023)) * F(jitter) - ty;
+				F pz = F((float)dz + 0.05f) + toFloat((hash >> 20) & I(1023)) * F(jitter) - tz;
+				nearest = minF(nearest, px * px + py * py + pz * pz);
+			}
+		}
+	}
+	return minF(sqrtF(nearest), F(1.0f)) * F(2.0f) - F(1.0f);
+}
+
+
+template <class V>
+inline typename V::F baseNoise(const NoiseSettings& settings, typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y)
+{
+	switch (settings.m_type)
+	{
+	case NoiseType::Value: return valueNoise<V>(seed, period_mask, x, y);
+	case NoiseType::Simplex: return simplexNoise<V>(seed, x, y);
+	case NoiseType::Cellular: return cellularNoise<V>(seed, period_mask, x, y);
+	default: return perlinNoise<V>(seed, period_mask, x, y);
+	}
+}
+
+template <class V>
+inline typename V::F baseNoise(const NoiseSettings& settings, typename V::I seed, typename V::I period_mask, typename V::F x, typename V::F y, typename V::F z)
+{
+	switch (settings.m_type)
+	{
+	case NoiseType::Value: return valueNoise<V>(seed, period_mask, x, y, z);
+	case NoiseType::Simplex: return simplexNoise<V>(seed, x, y, z);
+	case NoiseType::Cellular: return cellularNoise<V>(seed, period_mask, x, y, z);
+	default: return perlinNoise<V>(seed, period_mask, x, y, z);
+	}
+}
+
+
+/*
+	fractal sum of octaves: each one with its own seed, lacunarity times the frequency and gain times the amplitude.
+	Normalized by the sum of the amplitudes -> [-1, 1] like a single octave. Ridged: (1 - |noise|)^2 gives sharp crests
+	and wide valleys.
+	The period doubles with the octave, so a periodic pattern stays periodic with a lacunarity of 2
+*/
+
+template <class V, class Sample>
+inline typename V::F fractalNoise(const NoiseSettings& settings, const Sample& sample)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	unsigned int octaves = settings.m_fractal == NoiseFractal::None ? 1 : settings.m_octaves;
+	float frequency = settings.m_frequency;
+	float amplitude = 1.0f;
+	float total = 0.0f;
+	F sum(0.0f);
+
+	for (unsigned int octave = 0; octave < octaves; octave++)
+	{
+		I seed(settings.m_seed + octave * 0x9E3779B9u);
+		I period_mask(settings.m_period ? (settings.m_period << octave) - 1 : ~0u);
+		F value = sample(seed, period_mask, frequency);
+		if (settings.m_fractal == NoiseFractal::Ridged)
+		{
+			value = F(1.0f) - absF(value);
+			value = value * value;
+		}
+
+		sum = sum + value * F(amplitude);
+		total += amplitude;
+		amplitude *= settings.m_gain;
+		frequency *= settings.m_lacunarity;
+	}
+
+	if (settings.m_fractal == NoiseFractal::Ridged)
+		return sum * F(2.0f / total) - F(1.0f);
+	return sum * F(1.0f / total);
+}
+
+
+/*
+	count samples of one row at x = x0 + i * step. The lanes beyond count are computed and dropped
+*/
+
+template <class V>
+void noiseRow(const NoiseSettings& settings, float* out, unsigned int count, float x0, float step, float y, float z, bool volume)
+{
+	typedef typename V::F F;
+	typedef typename V::I I;
+
+	F row_y(y), row_z(z);
+	for (unsigned int i = 0; i < count; i += V::WIDTH)
+	{
+		F x = toFloat(I(i) + V::lanes()) * F(step) + F(x0);
+
+		F value;
+		if (volume)
+		{
+			value = fractalNoise<V>(settings, [&](I seed, I period_mask, float frequency)
+				{
+					F scale(frequency);
+					return baseNoise<V>(settings, seed, period_mask, x * scale, row_y * scale, row_z * scale);
+				});
+		}
+		else
+		{
+			value = fractalNoise<V>(settings, [&](I seed, I period_mask, float frequency)
+				{
+					F scale(frequency);
+					return baseNoise<V>(settings, seed, period_mask, x * scale, row_y * scale);
+				});
+		}
+
+		if (i + V::WIDTH <= count)
+		{
+			V::store(out + i, value);
+		}
+		else
+		{
+			float lanes[V::WIDTH];
+			V::store(lanes, value);
+			for (unsigned int lane = 0; i + lane < count; lane++)
+				out[i + lane] = lanes[lane];
+		}
+	}
+}
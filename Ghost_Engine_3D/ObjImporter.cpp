@@ -0,0 +1,299 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "ObjImporter.h"
+#include "FileSystem.h"
+#include <Windows.h>
+#include <sstream>
+#include <unordered_map>
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+/*
+	with the help of https://github.com/tinyobjloader/tinyobjloader
+	- parsing of polygons. embedding .obj files to Engine
+*/
+
+/*
+	tinyobjloader opens .mtl files with std::ifstream -> read them through the FileSystem instead, so materials can
+	live in a pack. Looked up next to the .obj first, then relative to the working directory (old behaviour)
+*/
+class FileSystemMaterialReader : public tinyobj::MaterialReader
+{
+public:
+
+	FileSystemMaterialReader(const std::wstring& base_dir) : m_base_dir(base_dir)
+	{
+	}
+
+	virtual bool operator()(const std::string& mat_id, std::vector<tinyobj::material_t>* materials,
+		std::map<std::string, int>* mat_map, std::string* warn, std::string* err)
+	{
+		std::wstring name(::MultiByteToWideChar(CP_UTF8, 0, mat_id.data(), (int)mat_id.size(), nullptr, 0), 0);
+		if (!name.empty())
+			::MultiByteToWideChar(CP_UTF8, 0, mat_id.data(), (int)mat_id.size(), &name[0], (int)name.size());
+
+		FileSpan span;
+		if (!FileSystem::get()->read((m_base_dir + name).c_str(), span) && !FileSystem::get()->read(name.c_str(), span))
+		{
+			if (warn)
+				(*warn) += "Material file [ " + mat_id + " ] not found\n";
+			return false;
+		}
+
+		SpanStream stream(span.getData(), span.getSize());
+		tinyobj::LoadMtl(mat_map, materials, &stream, warn, err);
+		return true;
+	}
+
+private:
+
+	std::wstring m_base_dir;
+};
+
+
+// position, normal, texture coordinate index and material of one face corner
+struct ObjCorner
+{
+	int m_vertex;
+	int m_normal;
+	int m_texcoord;
+	int m_material;
+
+	bool operator==(const ObjCorner& corner) const
+	{
+		return m_vertex == corner.m_vertex && m_normal == corner.m_normal && m_texcoord == corner.m_texcoord && m_material == corner.m_material;
+	}
+};
+
+struct ObjCornerHash
+{
+	size_t operator()(const ObjCorner& corner) const
+	{
+		return ((size_t)corner.m_vertex * 73856093u) ^ ((size_t)corner.m_normal * 19349663u) ^ ((size_t)corner.m_texcoord * 83492791u) ^
+			((size_t)corner.m_material * 2654435761u);
+	}
+};
+
+
+bool ObjImporter::load(const wchar_t* file, std::vector<VertexMesh>& vertices, std::vector<unsigned int>& indices,
+	std::vector<unsigned short>* vertex_materials, std::vector<ObjMaterial>* materials)
+{
+	// the .obj from a pack or from disk, parsed straight out of memory
+	FileSpan span;
+	if (!FileSystem::get()->read(file, span))
+		return false;
+
+	return load(file, span.getData(), span.getSize(), vertices, indices, vertex_materials, materials);
+}
+
+
+/*
+	Explanation( Everything is based on polygons ):  with the help of https://www.tutorialfor.com/questions-104539.htm
+		obj file contains vertices coordinaes (vx, vy, vz), Normal (nx, ny, nz) and Texture coordinates (tx, ty)
+*/
+bool ObjImporter::load(const wchar_t* file, const unsigned char* data, size_t size, std::vector<VertexMesh>& vertices, std::vector<unsigned int>& indices,
+	std::vector<unsigned short>* vertex_materials, std::vector<ObjMaterial>* materials)
+{
+	tinyobj::attrib_t attrib;
+
+	// pass vector of shapes/formes 
+	std::vector<tinyobj::shape_t> shape;
+
+	// vector of materials
+	std::vector<tinyobj::material_t> material;
+
+	std::string warning;
+	std::string error;
+
+	std::wstring base_dir(file);
+	size_t separator = base_dir.find_last_of(L"\\/");
+	base_dir = (separator == std::wstring::npos) ? std::wstring() : base_dir.substr(0, separator + 1);
+
+	SpanStream stream(data, size);
+	FileSystemMaterialReader material_reader(base_dir);
+
+	bool res = tinyobj::LoadObj(&attrib, &shape, &material, &warning, &error, &stream, &material_reader);
+
+	if (!error.empty() || !res)
+		return false;
+
+	// the ids of the vertices are 16 bit, one more for the faces without a material
+	if (material.size() >= 0xffff)
+		return false;
+
+	vertices.clear();
+	indices.clear();
+	if (vertex_materials)
+		vertex_materials->clear();
+	if (materials)
+	{
+		materials->clear();
+		for (size_t i = 0; i < material.size(); i++)
+		{
+			ObjMaterial entry;
+			entry.m_name = material[i].name;
+			entry.m_diffuse_texture = material[i].diffuse_texname;
+			materials->push_back(entry);
+		}
+	}
+	bool unnamed = false;
+
+	std::unordered_map<ObjCorner, unsigned int, ObjCornerHash> corners;
+
+	for (size_t i = 0; i < shape.size(); i++)
+	{
+		size_t indexPosition = 0;
+		indices.reserve(indices.size() + shape[i].mesh.indices.size());
+
+		for (size_t j = 0; j < shape[i].mesh.num_face_vertices.size(); j++)
+		{
+			// each face -> number of vertices 
+			int verticeNumber = shape[i].mesh.num_face_vertices[j];
+
+			// faces without a material (-1 or an unknown id) share the extra material after the ones of the .mtl
+			int face_material = (j < shape[i].mesh.material_ids.size()) ? shape[i].mesh.material_ids[j] : -1;
+			if (face_material < 0 || face_material >= (int)material.size())
+			{
+				face_material = (int)material.size();
+				unnamed = true;
+			}
+
+			for (int k = 0; k < verticeNumber; k++)
+			{
+				tinyobj::index_t idx = shape[i].mesh.indices[indexPosition + k];
+
+				// a corner that was seen before reuses its vertex
+				ObjCorner corner = { idx.vertex_index, idx.normal_index, idx.texcoord_index, face_material };
+				auto found = corners.find(corner);
+				if (found != corners.end())
+				{
+					indices.push_back(found->second);
+					continue;
+				}
+
+				// vertices coordinates
+				tinyobj::real_t vx = attrib.vertices[3 * idx.vertex_index + 0];
+				tinyobj::real_t vy = attrib.vertices[3 * idx.vertex_index + 1];
+				tinyobj::real_t vz = attrib.vertices[3 * idx.vertex_index + 2];
+
+				// vertex normal (missing normals / texture coordinates are 0)
+				tinyobj::real_t nx = 0, ny = 0, nz = 0;
+				if (idx.normal_index >= 0)
+				{
+					nx = attrib.normals[3 * idx.normal_index + 0];
+					ny = attrib.normals[3 * idx.normal_index + 1];
+					nz = attrib.normals[3 * idx.normal_index + 2];
+				}
+
+				// texture coordinates
+				tinyobj::real_t tx = 0, ty = 0;
+				if (idx.texcoord_index >= 0)
+				{
+					tx = attrib.texcoords[2 * idx.texcoord_index + 0];
+					ty = attrib.texcoords[2 * idx.texcoord_index + 1];
+				}
+
+				unsigned int index = (unsigned int)vertices.size();
+				corners[corner] = index;
+
+				// VertexMesh(position, texcoord, normal)
+				vertices.push_back(VertexMesh(Vector3D(vx, vy, vz), Vector2D(tx, ty), Vector3D(nx, ny, nz)));
+				indices.push_back(index);
+				if (vertex_materials)
+					vertex_materials->push_back((unsigned short)face_material);
+			}
+
+			indexPosition += verticeNumber;
+		}
+	}
+
+	if (materials && unnamed)
+		materials->push_back(ObjMaterial());
+
+	return !vertices.empty();
+}
+
+
+// the words of every line that starts with one of the keywords
+static void findKeywordLines(const unsigned char* data, size_t size, const char* const* keywords, size_t keyword_count, std::vector<std::string>& files, bool last_word_only)
+{
+	std::istringstream stream(std::string((const char*)data, size));
+	std::string line;
+
+	while (std::getline(stream, line))
+	{
+		std::istringstream words(line);
+		std::string keyword;
+		words >> keyword;
+
+		bool match = false;
+		for (size_t i = 0; i < keyword_count && !match; i++)
+		{
+			match = (keyword == keywords[i]);
+		}
+
+		if (!match)
+			continue;
+
+		std::vector<std::string> values;
+		std::string value;
+		while (words >> value)
+		{
+			values.push_back(value);
+		}
+
+		if (values.empty())
+			continue;
+
+		// texture maps can have options before the file name (-bm 0.5 file.jpg)
+		if (last_word_only)
+			files.push_back(values.back());
+		else
+			files.insert(files.end(), values.begin(), values.end());
+	}
+}
+
+
+void ObjImporter::getMaterialLibraries(const unsigned char* data, size_t size, std::vector<std::string>& files)
+{
+	static const char* const keywords[] = { "mtllib" };
+	findKeywordLines(data, size, keywords, 1, files, false);
+}
+
+
+void ObjImporter::getMaterialTextures(const unsigned char* data, size_t size, std::vector<std::string>& files)
+{
+	static const char* const keywords[] = { "map_Ka", "map_Kd", "map_Ks", "map_Ns", "map_d", "map_bump", "map_Bump", "bump", "disp", "norm" };
+	findKeywordLines(data, size, keywords, sizeof(keywords) / sizeof(keywords[0]), files, true);
+}
+
+
+void ObjImporter::getMaterialNormalMaps(const unsigned char* data, size_t size, std::vector<std::string>& files)
+{
+	static const char* const keywords[] = { "norm" };
+	findKeywordLines(data, size, keywords, 1, files, true);
+}
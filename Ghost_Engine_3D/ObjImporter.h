@@ -0,0 +1,66 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "VertexMesh.h"
+#include <string>
+#include <vector>
+
+// material of an .obj as the .mtl describes it
+struct ObjMaterial
+{
+	std::string m_name;
+	std::string m_diffuse_texture;		// map_Kd as written in the .mtl (relative to the .mtl), empty without one
+};
+
+
+/*
+	ObjImporter: .obj files -> vertex and index list, shared by MeshModel (uncooked meshes) and the AssetCooker
+
+	- files are read through the FileSystem (packs, prefetched or loose), .mtl files as well
+	- corners of faces with the same position, normal, texture coordinate and material share one vertex -> every
+	  vertex belongs to one material, the AssetCooker can move its texture coordinates into a texture atlas
+	- faces without a material get an extra material with an empty name, the last one of the list
+*/
+
+class ObjImporter
+{
+public:
+
+	// vertex_materials: the material of every vertex, an index into materials
+	static bool load(const wchar_t* file, std::vector<VertexMesh>& vertices, std::vector<unsigned int>& indices,
+		std::vector<unsigned short>* vertex_materials = nullptr, std::vector<ObjMaterial>* materials = nullptr);
+	// the .obj already in memory (a prefetch completion job). file locates the .mtl files
+	static bool load(const wchar_t* file, const unsigned char* data, size_t size, std::vector<VertexMesh>& vertices, std::vector<unsigned int>& indices,
+		std::vector<unsigned short>* vertex_materials = nullptr, std::vector<ObjMaterial>* materials = nullptr);
+
+	// files named by "mtllib" lines of an .obj
+	static void getMaterialLibraries(const unsigned char* data, size_t size, std::vector<std::string>& files);
+	// files named by the texture maps (map_Kd, map_Bump, ...) of an .mtl
+	static void getMaterialTextures(const unsigned char* data, size_t size, std::vector<std::string>& files);
+	// files named by the "norm" maps of an .mtl: tangent space normal maps. Bump maps are height maps and not included
+	static void getMaterialNormalMaps(const unsigned char* data, size_t size, std::vector<std::string>& files);
+};
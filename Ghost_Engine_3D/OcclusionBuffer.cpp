@@ -0,0 +1,387 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "OcclusionBuffer.h"
+#include "JobSystem.h"
+
+#include <xmmintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+
+OcclusionBuffer::OcclusionBuffer(unsigned int width, unsigned int height) :m_tests(0), m_occluded(0)
+{
+	m_width = std::max(OCCLUSION_TILE_SIZE, (width + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE * OCCLUSION_TILE_SIZE);
+	m_height = std::max(OCCLUSION_TILE_SIZE, (height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE * OCCLUSION_TILE_SIZE);
+	m_tiles_x = m_width / OCCLUSION_TILE_SIZE;
+	m_tiles_y = m_height / OCCLUSION_TILE_SIZE;
+
+	m_depth.assign((size_t)m_width * m_height, 1.0f);
+	m_tile_depth.assign((size_t)m_tiles_x * m_tiles_y, 1.0f);
+	m_view_proj.setIdentity();
+}
+
+
+void OcclusionBuffer::begin(const Matrix4x4& view, const Matrix4x4& proj)
+{
+	m_view_proj = view;
+	m_view_proj *= proj;
+
+	std::fill(m_depth.begin(), m_depth.end(), 1.0f);
+	std::fill(m_tile_depth.begin(), m_tile_depth.end(), 1.0f);
+
+	m_occluders.clear();
+	m_stats = OcclusionStats();
+	m_tests = 0;
+	m_occluded = 0;
+}
+
+
+void OcclusionBuffer::addOccluder(const Vector3D* positions, const unsigned int* indices, unsigned int index_count, const Matrix4x4& world)
+{
+	Occluder occluder;
+	occluder.m_positions = positions;
+	occluder.m_indices = indices;
+	occluder.m_index_count = index_count;
+	occluder.m_world_view_proj = world;
+	occluder.m_world_view_proj *= m_view_proj;
+	m_occluders.push_back(occluder);
+}
+
+
+// clip = x * row0 + y * row1 + z * row2 + row3 (row vector times matrix), one SSE register per row
+static inline __m128 transformPoint(const __m128* rows, const Vector3D& p)
+{
+	__m128 clip = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(p.m_x), rows[0]), _mm_mul_ps(_mm_set1_ps(p.m_y), rows[1]));
+	clip = _mm_add_ps(clip, _mm_mul_ps(_mm_set1_ps(p.m_z), rows[2]));
+	return _mm_add_ps(clip, rows[3]);
+}
+
+
+void OcclusionBuffer::setupTriangles(const Occluder& occluder, std::vector<ScreenTriangle>& triangles)
+{
+	triangles.clear();
+
+	__m128 rows[4];
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		rows[i] = _mm_loadu_ps(occluder.m_world_view_proj.m_mat[i]);
+	}
+
+	for (unsigned int i = 0; i + 2 < occluder.m_index_count; i += 3)
+	{
+		ScreenTriangle triangle;
+		bool clipped = false;
+		float min_x = (float)m_width, max_x = 0.0f, min_y = (float)m_height, max_y = 0.0f;
+		triangle.m_depth = 0.0f;
+
+		for (unsigned int k = 0; k < 3; k++)
+		{
+			float clip[4];
+			_mm_storeu_ps(clip, transformPoint(rows, occluder.m_positions[occluder.m_indices[i + k]]));
+
+			// in front of the near plane: 0 <= z. Clipping would make new triangles, dropping them is conservative
+			if (clip[3] <= 1e-5f || clip[2] < 0.0f)
+			{
+				clipped = true;
+				break;
+			}
+
+			float inverse_w = 1.0f / clip[3];
+			triangle.m_x[k] = (clip[0] * inverse_w * 0.5f + 0.5f) * m_width;
+			triangle.m_y[k] = (0.5f - clip[1] * inverse_w * 0.5f) * m_height;
+			triangle.m_depth = std::max(triangle.m_depth, std::min(clip[2] * inverse_w, 1.0f));
+
+			min_x = std::min(min_x, triangle.m_x[k]);
+			max_x = std::max(max_x, triangle.m_x[k]);
+			min_y = std::min(min_y, triangle.m_y[k]);
+			max_y = std::max(max_y, triangle.m_y[k]);
+		}
+
+		if (clipped)
+			continue;
+
+		// clockwise on screen (y down) = front face = positive area
+		float area = (triangle.m_x[1] - triangle.m_x[0]) * (triangle.m_y[2] - triangle.m_y[0]) - (triangle.m_x[2] - triangle.m_x[0]) * (triangle.m_y[1] - triangle.m_y[0]);
+		if (area <= 0.0f)
+			continue;
+
+		if (max_x < 0.0f || min_x >= m_width || max_y < 0.0f || min_y >= m_height)
+			continue;
+
+		triangle.m_min_y = std::max(0, (int)floorf(min_y));
+		triangle.m_max_y = std::min((int)m_height - 1, (int)ceilf(max_y));
+		triangles.push_back(triangle);
+	}
+}
+
+
+void OcclusionBuffer::render()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_triangles.resize(m_occluders.size());
+	JobSystem::get()->parallelFor((unsigned int)m_occluders.size(), 1, [this](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				setupTriangles(m_occluders[i], m_triangles[i]);
+			}
+		});
+
+	JobSystem::get()->parallelFor(m_tiles_y, 1, [this](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int band = begin; band < end; band++)
+			{
+				rasterizeBand(band);
+			}
+		});
+
+	m_stats.m_occluders = (unsigned int)m_occluders.size();
+	for (size_t i = 0; i < m_occluders.size(); i++)
+	{
+		m_stats.m_triangles += m_occluders[i].m_index_count / 3;
+		m_stats.m_triangles_rasterized += (unsigned int)m_triangles[i].size();
+	}
+
+	m_stats.m_raster_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+/*
+	edge function of the edge a -> b at pixel p: (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)
+	= A * p.x + B * p.y + C, >= 0 on the inner side of every edge of a front facing triangle
+*/
+void OcclusionBuffer::rasterizeBand(unsigned int band)
+{
+	int band_min_y = (int)(band * OCCLUSION_TILE_SIZE);
+	int band_max_y = band_min_y + (int)OCCLUSION_TILE_SIZE - 1;
+
+	const __m128 pixel_offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+	for (size_t o = 0; o < m_triangles.size(); o++)
+	{
+		const std::vector<ScreenTriangle>& triangles = m_triangles[o];
+
+		for (size_t t = 0; t < triangles.size(); t++)
+		{
+			const ScreenTriangle& triangle = triangles[t];
+			if (triangle.m_max_y < band_min_y || triangle.m_min_y > band_max_y)
+				continue;
+
+			float a[3], b[3], c[3];
+			float min_x = triangle.m_x[0], max_x = triangle.m_x[0];
+			for (unsigned int e = 0; e < 3; e++)
+			{
+				unsigned int next = (e + 1) % 3;
+				a[e] = -(triangle.m_y[next] - triangle.m_y[e]);
+				b[e] = triangle.m_x[next] - triangle.m_x[e];
+				c[e] = (triangle.m_y[next] - triangle.m_y[e]) * triangle.m_x[e] - (triangle.m_x[next] - triangle.m_x[e]) * triangle.m_y[e];
+				min_x = std::min(min_x, triangle.m_x[e]);
+				max_x = std::max(max_x, triangle.m_x[e]);
+			}
+
+			// 4 pixel aligned columns
+			int x_begin = std::max(0, (int)floorf(min_x)) & ~3;
+			int x_end = std::min((int)m_width, (int)ceilf(max_x) + 1);
+			int y_begin = std::max(band_min_y, triangle.m_min_y);
+			int y_end = std::min(band_max_y, triangle.m_max_y);
+
+			__m128 depth = _mm_set1_ps(triangle.m_depth);
+			__m128 a0 = _mm_set1_ps(a[0]), a1 = _mm_set1_ps(a[1]), a2 = _mm_set1_ps(a[2]);
+			__m128 zero = _mm_setzero_ps();
+
+			for (int y = y_begin; y <= y_end; y++)
+			{
+				float py = y + 0.5f;
+				__m128 row0 = _mm_set1_ps(b[0] * py + c[0]);
+				__m128 row1 = _mm_set1_ps(b[1] * py + c[1]);
+				__m128 row2 = _mm_set1_ps(b[2] * py + c[2]);
+				float* depth_row = &m_depth[(size_t)y * m_width];
+
+				for (int x = x_begin; x < x_end; x += 4)
+				{
+					__m128 px = _mm_add_ps(_mm_set1_ps((float)x), pixel_offsets);
+
+					__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a0, px), row0), zero);
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a1, px), row1), zero));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(a2, px), row2), zero));
+
+					if (_mm_movemask_ps(inside) == 0)
+						continue;
+
+					__m128 current = _mm_loadu_ps(depth_row + x);
+					__m128 merged = _mm_min_ps(current, depth);
+					_mm_storeu_ps(depth_row + x, _mm_or_ps(_mm_and_ps(inside, merged), _mm_andnot_ps(inside, current)));
+				}
+			}
+		}
+	}
+
+	// farthest depth of the tiles of this band
+	for (unsigned int tx = 0; tx < m_tiles_x; tx++)
+	{
+		__m128 farthest = _mm_setzero_ps();
+		for (int y = band_min_y; y <= band_max_y; y++)
+		{
+			const float* depth_row = &m_depth[(size_t)y * m_width + tx * OCCLUSION_TILE_SIZE];
+			for (unsigned int x = 0; x < OCCLUSION_TILE_SIZE; x += 4)
+			{
+				farthest = _mm_max_ps(farthest, _mm_loadu_ps(depth_row + x));
+			}
+		}
+
+		float lanes[4];
+		_mm_storeu_ps(lanes, farthest);
+		m_tile_depth[band * m_tiles_x + tx] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	}
+}
+
+
+bool OcclusionBuffer::isBoxOccluded(const Vector3D& min, const Vector3D& max, const Matrix4x4& world)
+{
+	m_tests++;
+
+	Matrix4x4 world_view_proj = world;
+	world_view_proj *= m_view_proj;
+
+	__m128 rows[4];
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		rows[i] = _mm_loadu_ps(world_view_proj.m_mat[i]);
+	}
+
+	float min_x = 1e30f, max_x = -1e30f, min_y = 1e30f, max_y = -1e30f, nearest = 1.0f;
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		Vector3D corner((i & 1) ? max.m_x : min.m_x, (i & 2) ? max.m_y : min.m_y, (i & 4) ? max.m_z : min.m_z);
+
+		float clip[4];
+		_mm_storeu_ps(clip, transformPoint(rows, corner));
+
+		// the box reaches the camera: can not be hidden
+		if (clip[3] <= 1e-5f || clip[2] < 0.0f)
+			return false;
+
+		float inverse_w = 1.0f / clip[3];
+		float x = (clip[0] * inverse_w * 0.5f + 0.5f) * m_width;
+		float y = (0.5f - clip[1] * inverse_w * 0.5f) * m_height;
+		min_x = std::min(min_x, x);
+		max_x = std::max(max_x, x);
+		min_y = std::min(min_y, y);
+		max_y = std::max(max_y, y);
+		nearest = std::min(nearest, clip[2] * inverse_w);
+	}
+
+	// every pixel the box touches, one more on each side: occluders only cover pixel centers
+	int x0 = std::max(0, (int)floorf(min_x) - 1);
+	int x1 = std::min((int)m_width - 1, (int)ceilf(max_x) + 1);
+	int y0 = std::max(0, (int)floorf(min_y) - 1);
+	int y1 = std::min((int)m_height - 1, (int)ceilf(max_y) + 1);
+
+	// outside of the screen is the job of frustum culling
+	if (x0 > x1 || y0 > y1)
+		return false;
+
+	bool occluded = true;
+	for (int ty = y0 / (int)OCCLUSION_TILE_SIZE; ty <= y1 / (int)OCCLUSION_TILE_SIZE && occluded; ty++)
+	{
+		for (int tx = x0 / (int)OCCLUSION_TILE_SIZE; tx <= x1 / (int)OCCLUSION_TILE_SIZE; tx++)
+		{
+			if (m_tile_depth[ty * m_tiles_x + tx] >= nearest)
+			{
+				occluded = false;
+				break;
+			}
+		}
+	}
+
+	// the tiles are not enough: compare the pixels, 4 at a time
+	if (!occluded)
+	{
+		occluded = true;
+		__m128 box_depth = _mm_set1_ps(nearest);
+
+		for (int y = y0; y <= y1 && occluded; y++)
+		{
+			const float* depth_row = &m_depth[(size_t)y * m_width];
+			int x = x0;
+			for (; x + 3 <= x1; x += 4)
+			{
+				if (_mm_movemask_ps(_mm_cmpge_ps(_mm_loadu_ps(depth_row + x), box_depth)))
+				{
+					occluded = false;
+					break;
+				}
+			}
+			for (; x <= x1 && occluded; x++)
+			{
+				occluded = depth_row[x] < nearest;
+			}
+		}
+	}
+
+	if (occluded)
+		m_occluded++;
+
+	return occluded;
+}
+
+
+bool OcclusionBuffer::isOccluded(const Vector3D& center, float radius)
+{
+	Matrix4x4 identity;
+	identity.setIdentity();
+	return isBoxOccluded(Vector3D(center.m_x - radius, center.m_y - radius, center.m_z - radius), Vector3D(center.m_x + radius, center.m_y + radius, center.m_z + radius), identity);
+}
+
+
+unsigned int OcclusionBuffer::getWidth()
+{
+	return m_width;
+}
+
+
+unsigned int OcclusionBuffer::getHeight()
+{
+	return m_height;
+}
+
+
+const float* OcclusionBuffer::getDepth()
+{
+	return m_depth.data();
+}
+
+
+OcclusionStats OcclusionBuffer::getStats()
+{
+	OcclusionStats stats = m_stats;
+	stats.m_tests = m_tests;
+	stats.m_occluded = m_occluded;
+	return stats;
+}
@@ -0,0 +1,127 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "MeshletCuller.h"
+#include "Matrix4x4.h"
+#include <atomic>
+#include <vector>
+
+// size of a hierarchical depth tile and of the row bands the rasterizer works on in parallel
+static const unsigned int OCCLUSION_TILE_SIZE = 8;
+
+struct OcclusionStats
+{
+	unsigned int m_occluders = 0;
+	unsigned int m_triangles = 0;				// triangles of the occluders
+	unsigned int m_triangles_rasterized = 0;	// after back face and near plane rejection
+	unsigned int m_tests = 0;
+	unsigned int m_occluded = 0;
+	double m_raster_milliseconds = 0.0;
+};
+
+
+/*
+	OcclusionBuffer: software occlusion culling with a small depth buffer on the CPU
+
+	- the coarse versions of big objects (occluders) are rasterized into a low resolution depth buffer. Objects
+	  (occludees) whose bounding box is behind that depth everywhere are not drawn
+	- conservative both ways: an occluder writes the farthest depth of each triangle and only covers the pixels
+	  whose center is inside, triangles crossing the near plane are dropped. An occludee uses the nearest depth of
+	  its box and every pixel the box touches
+	- SIMD: the edge functions of 4 pixels at a time are evaluated with SSE, the depth is merged with a mask
+	- rasterized in bands of OCCLUSION_TILE_SIZE rows on the JobSystem, each band owns its rows -> no locks.
+	  A band also stores the farthest depth of each of its 8x8 tiles (hierarchical level), so most tests
+	  are decided by a few tiles (like the tiles of masked occlusion culling, with a depth per pixel instead of
+	  coverage masks)
+	- depth is z / w of the D3D projection: 0 at the near plane, 1 at the far plane
+*/
+
+class OcclusionBuffer : public OcclusionTest
+{
+public:
+
+	// width is rounded up to a multiple of OCCLUSION_TILE_SIZE, height as well
+	OcclusionBuffer(unsigned int width = 256, unsigned int height = 128);
+
+	// start a frame with the camera of this frame: clear the depth and the occluder list
+	void begin(const Matrix4x4& view, const Matrix4x4& proj);
+	// queue an occluder (triangle list, clockwise = front). The arrays must stay valid until render() returns
+	void addOccluder(const Vector3D* positions, const unsigned int* indices, unsigned int index_count, const Matrix4x4& world);
+	// rasterize all queued occluders
+	void render();
+
+	// true when the box (object space, moved by world) is hidden for sure. Thread safe after render()
+	bool isBoxOccluded(const Vector3D& min, const Vector3D& max, const Matrix4x4& world);
+	// OcclusionTest: world space sphere
+	virtual bool isOccluded(const Vector3D& center, float radius) override;
+
+	unsigned int getWidth();
+	unsigned int getHeight();
+	// depth of the pixels, row by row
+	const float* getDepth();
+	OcclusionStats getStats();
+
+private:
+
+	struct Occluder
+	{
+		const Vector3D* m_positions;
+		const unsigned int* m_indices;
+		unsigned int m_index_count;
+		Matrix4x4 m_world_view_proj;
+	};
+
+	// triangle after setup: screen position of the corners (pixels, y down) and its farthest depth
+	struct ScreenTriangle
+	{
+		float m_x[3];
+		float m_y[3];
+		float m_depth;
+		int m_min_y, m_max_y;
+	};
+
+	void setupTriangles(const Occluder& occluder, std::vector<ScreenTriangle>& triangles);
+	void rasterizeBand(unsigned int band);
+
+private:
+
+	unsigned int m_width;
+	unsigned int m_height;
+	unsigned int m_tiles_x;
+	unsigned int m_tiles_y;
+
+	std::vector<float> m_depth;
+	std::vector<float> m_tile_depth;		// farthest depth of every tile
+
+	Matrix4x4 m_view_proj;
+	std::vector<Occluder> m_occluders;
+	std::vector<std::vector<ScreenTriangle>> m_triangles;	// per occluder
+
+	OcclusionStats m_stats;
+	std::atomic<unsigned int> m_tests;
+	std::atomic<unsigned int> m_occluded;
+};
@@ -0,0 +1,332 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "PackFile.h"
+#include "LZCompressor.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+
+PackFile::PackFile()
+{
+}
+
+
+/*
+	validate everything that is later used as offset or size -> a broken pack is rejected instead of read out of bounds
+*/
+
+bool PackFile::open(const wchar_t* file)
+{
+	close();
+
+	if (!m_mapped.open(file))
+		return false;
+
+	const unsigned char* data = m_mapped.getData();
+	size_t size = m_mapped.getSize();
+
+	if (size < sizeof(PackFileHeader))
+	{
+		close();
+		return false;
+	}
+
+	const PackFileHeader* header = (const PackFileHeader*)data;
+
+	// the directory size is checked by division: entry_count * sizeof(PackFileEntry) overflows a 32 bit size_t
+	if (header->m_magic != PACK_FILE_MAGIC || header->m_version != PACK_FILE_VERSION ||
+		(size - sizeof(PackFileHeader)) / sizeof(PackFileEntry) < header->m_entry_count)
+	{
+		close();
+		return false;
+	}
+
+	size_t names_offset = sizeof(PackFileHeader) + (size_t)header->m_entry_count * sizeof(PackFileEntry);
+
+	if (header->m_names_size > size - names_offset || header->m_data_offset > size)
+	{
+		close();
+		return false;
+	}
+
+	const PackFileEntry* entries = (const PackFileEntry*)(data + sizeof(PackFileHeader));
+	const char* names = (const char*)(data + names_offset);
+
+	for (unsigned int i = 0; i < header->m_entry_count; i++)
+	{
+		const PackFileEntry& entry = entries[i];
+		if (entry.m_name_offset >= header->m_names_size || entry.m_offset > size || entry.m_stored_size > size - entry.m_offset ||
+			(!(entry.m_flags & PACK_ENTRY_COMPRESSED) && entry.m_stored_size != entry.m_size))
+		{
+			close();
+			return false;
+		}
+	}
+
+	if (header->m_names_size == 0 || names[header->m_names_size - 1] != 0)
+	{
+		close();
+		return false;
+	}
+
+	// find() is a binary search -> the names must be strictly ascending
+	for (unsigned int i = 1; i < header->m_entry_count; i++)
+	{
+		if (::strcmp(names + entries[i - 1].m_name_offset, names + entries[i].m_name_offset) >= 0)
+		{
+			close();
+			return false;
+		}
+	}
+
+	m_header = header;
+	m_entries = entries;
+	m_names = names;
+	return true;
+}
+
+
+void PackFile::close()
+{
+	m_mapped.close();
+	m_header = nullptr;
+	m_entries = nullptr;
+	m_names = nullptr;
+}
+
+
+const PackFileEntry* PackFile::find(const char* path)
+{
+	if (!m_header)
+		return nullptr;
+
+	const PackFileEntry* begin = m_entries;
+	const PackFileEntry* end = m_entries + m_header->m_entry_count;
+
+	const PackFileEntry* it = std::lower_bound(begin, end, path, [this](const PackFileEntry& entry, const char* name)
+		{
+			return ::strcmp(m_names + entry.m_name_offset, name) < 0;
+		});
+
+	if (it == end || ::strcmp(m_names + it->m_name_offset, path) != 0)
+		return nullptr;
+
+	return it;
+}
+
+
+const unsigned char* PackFile::getData(const PackFileEntry& entry)
+{
+	return m_mapped.getData() + entry.m_offset;
+}
+
+
+const char* PackFile::getName(const PackFileEntry& entry)
+{
+	return m_names + entry.m_name_offset;
+}
+
+
+unsigned int PackFile::getEntryCount()
+{
+	return m_header ? m_header->m_entry_count : 0;
+}
+
+
+/*
+	- directory and names are built in memory first, the entry data is streamed into the file one by one
+	- written through a temporary file, so a crash never leaves half a pack
+*/
+
+bool PackFile::write(const std::vector<PackSource>& sources, const wchar_t* file, bool compress)
+{
+	// sort by normalized path: the order of the directory
+	std::vector<std::pair<std::string, const PackSource*>> sorted;
+	for (size_t i = 0; i < sources.size(); i++)
+	{
+		sorted.push_back(std::make_pair(normalizePath(sources[i].m_path.c_str()), &sources[i]));
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const std::pair<std::string, const PackSource*>& a, const std::pair<std::string, const PackSource*>& b)
+		{
+			return a.first < b.first;
+		});
+
+	std::vector<PackFileEntry> entries(sorted.size());
+	std::string names;
+	for (size_t i = 0; i < sorted.size(); i++)
+	{
+		if (i > 0 && sorted[i].first == sorted[i - 1].first)
+			return false;
+
+		entries[i] = {};
+		entries[i].m_name_offset = (unsigned int)names.size();
+		names.append(sorted[i].first);
+		names.push_back(0);
+	}
+
+	PackFileHeader header = {};
+	header.m_magic = PACK_FILE_MAGIC;
+	header.m_version = PACK_FILE_VERSION;
+	header.m_entry_count = (unsigned int)entries.size();
+	header.m_names_size = (unsigned int)names.size();
+	header.m_data_offset = alignUp(sizeof(PackFileHeader) + sizeof(PackFileEntry) * entries.size() + names.size(), PACK_FILE_ALIGNMENT);
+
+	std::wstring temp = std::wstring(file) + L".tmp";
+
+	HANDLE handle = ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	bool ok = true;
+	unsigned long long offset = header.m_data_offset;
+	static const unsigned char zeros[PACK_FILE_ALIGNMENT] = {};
+
+	auto writeBytes = [&](const void* data, size_t size)
+	{
+		DWORD written = 0;
+		if (!::WriteFile(handle, data, (DWORD)size, &written, nullptr) || written != size)
+			ok = false;
+	};
+
+	// the directory is written at the end, when all offsets are known
+	if (::SetFilePointer(handle, (LONG)header.m_data_offset, nullptr, FILE_BEGIN) == INVALID_SET_FILE_POINTER)
+		ok = false;
+
+	std::vector<unsigned char> compressed;
+
+	for (size_t i = 0; ok && i < sorted.size(); i++)
+	{
+		MappedFile source;
+		const unsigned char* data = nullptr;
+		size_t size = 0;
+
+		// an empty file can not be mapped, it is stored as an empty entry
+		if (source.open(sorted[i].second->m_file.c_str()))
+		{
+			data = source.getData();
+			size = source.getSize();
+		}
+		else if (::GetFileAttributesW(sorted[i].second->m_file.c_str()) == INVALID_FILE_ATTRIBUTES)
+		{
+			ok = false;
+			break;
+		}
+
+		entries[i].m_offset = offset;
+		entries[i].m_size = size;
+		entries[i].m_stored_size = size;
+
+		if (compress && size > 0)
+		{
+			size_t compressed_size = LZCompressor::compress(data, size, compressed);
+			if (compressed_size > 0 && compressed_size <= size - size / 8)
+			{
+				data = compressed.data();
+				entries[i].m_stored_size = compressed_size;
+				entries[i].m_flags |= PACK_ENTRY_COMPRESSED;
+			}
+		}
+
+		writeBytes(data, (size_t)entries[i].m_stored_size);
+
+		size_t padding = alignUp((size_t)entries[i].m_stored_size, PACK_FILE_ALIGNMENT) - (size_t)entries[i].m_stored_size;
+		writeBytes(zeros, padding);
+
+		offset += entries[i].m_stored_size + padding;
+	}
+
+	if (ok && ::SetFilePointer(handle, 0, nullptr, FILE_BEGIN) == INVALID_SET_FILE_POINTER)
+		ok = false;
+
+	if (ok)
+	{
+		writeBytes(&header, sizeof(header));
+		writeBytes(entries.data(), sizeof(PackFileEntry) * entries.size());
+		writeBytes(names.data(), names.size());
+	}
+
+	::CloseHandle(handle);
+
+	if (!ok)
+	{
+		::DeleteFileW(temp.c_str());
+		return false;
+	}
+
+	return ::MoveFileExW(temp.c_str(), file, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+
+std::string PackFile::normalizePath(const wchar_t* path)
+{
+	std::string result;
+
+	if (path[0] == L'.' && (path[1] == L'\\' || path[1] == L'/'))
+		path += 2;
+
+	for (; *path; path++)
+	{
+		wchar_t c = *path;
+
+		if (c == L'\\')
+			c = L'/';
+		else if (c >= L'A' && c <= L'Z')
+			c = c - L'A' + L'a';
+
+		// paths of the assets are plain ASCII, anything else is UTF-8 encoded
+		if (c < 0x80)
+		{
+			result.push_back((char)c);
+		}
+		else if (c < 0x800)
+		{
+			result.push_back((char)(0xC0 | (c >> 6)));
+			result.push_back((char)(0x80 | (c & 0x3F)));
+		}
+		else
+		{
+			result.push_back((char)(0xE0 | ((c >> 12) & 0x0F)));
+			result.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+			result.push_back((char)(0x80 | (c & 0x3F)));
+		}
+	}
+
+	return result;
+}
+
+
+PackFile::~PackFile()
+{
+	close();
+}
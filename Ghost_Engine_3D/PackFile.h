@@ -0,0 +1,114 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "MappedFile.h"
+#include <string>
+#include <vector>
+
+/*
+	Pack file (.gpak): many asset files in one file
+
+		PackFileHeader          32 bytes
+		PackFileEntry[count]    32 bytes each, sorted by path
+		names                   0 terminated paths
+		padding                 -> data starts 16 byte aligned
+		entry data              each entry starts 16 byte aligned
+
+	- paths are stored normalized: lower case, '/' as separator, relative to the working directory
+	- the directory is sorted -> lookup is a binary search, no hash table has to be built at mount time
+	- an entry is either stored raw (served directly out of the mapping) or LZ compressed
+	- the alignment keeps cooked data (e.g. the levels of a .gtex) 16 byte aligned inside the pack
+*/
+
+static const unsigned int PACK_FILE_MAGIC = 0x4B415047;			// "GPAK"
+static const unsigned int PACK_FILE_VERSION = 1;
+static const unsigned int PACK_FILE_ALIGNMENT = 16;
+
+// set in PackFileEntry::m_flags when the data is LZ compressed
+static const unsigned int PACK_ENTRY_COMPRESSED = 0x1;
+
+struct PackFileHeader
+{
+	unsigned int m_magic;
+	unsigned int m_version;
+	unsigned int m_entry_count;
+	unsigned int m_names_size;
+	unsigned long long m_data_offset;
+	unsigned long long m_reserved;
+};
+
+struct PackFileEntry
+{
+	unsigned long long m_offset;			// from the start of the file
+	unsigned long long m_stored_size;		// bytes in the pack
+	unsigned long long m_size;				// bytes after decompression
+	unsigned int m_name_offset;				// into the names block
+	unsigned int m_flags;
+};
+
+// one file that goes into a pack
+struct PackSource
+{
+	std::wstring m_path;		// path inside the pack
+	std::wstring m_file;		// file on disk
+};
+
+
+class PackFile
+{
+public:
+
+	PackFile();
+	~PackFile();
+
+	// map a pack and validate its directory
+	bool open(const wchar_t* file);
+	void close();
+
+	// binary search for a normalized path, nullptr when the pack does not contain it
+	const PackFileEntry* find(const char* path);
+	// stored bytes of an entry inside the mapping
+	const unsigned char* getData(const PackFileEntry& entry);
+	const char* getName(const PackFileEntry& entry);
+	unsigned int getEntryCount();
+
+	/*
+		build a pack from loose files
+		- compress: entries are LZ compressed when that saves at least 1/8 of the size
+	*/
+	static bool write(const std::vector<PackSource>& sources, const wchar_t* file, bool compress);
+
+	// lower case, '/' separators, no leading "./" -> the form of the paths in the directory
+	static std::string normalizePath(const wchar_t* path);
+
+private:
+
+	MappedFile m_mapped;
+	const PackFileHeader* m_header = nullptr;
+	const PackFileEntry* m_entries = nullptr;
+	const char* m_names = nullptr;
+};
@@ -0,0 +1,99 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	vertex shader for the packed vertex formats of VertexPacker. The input assembler already turned the 16-bit
+	values into floats (UNORM: 0..1, SNORM: -1..1, half), here they are moved back into their ranges
+*/
+struct VS_INPUT
+{
+	float4 position: POSITION;
+	float2 texcoord: TEXCOORD;
+	float3 normal: NORMAL;
+};
+
+struct VS_OUTPUT
+{
+	precise float4 position: SV_POSITION;
+	float2 texcoord: TEXCOORD;
+	float3 normal: NORMAL;
+	float3 world_position: TEXCOORD1;		// point and spot lights of the pixel shader
+};
+
+// adding Data Structure passed into ConstantBuffer
+cbuffer constant: register(b0)
+{
+	row_major float4x4 m_world;
+	row_major float4x4 m_view;
+	row_major float4x4 m_proj;
+	unsigned int m_time;
+	float3 ambientColor;
+	float ambientPower;
+	float3 m_vectorLight;
+
+};
+
+// ranges of the packed attributes (QuantizationConstantType), value = offset + stored * scale
+cbuffer quantization: register(b1)
+{
+	float3 m_position_offset;
+	float3 m_position_scale;
+	float4 m_texcoord_offset_scale;
+	float m_octahedral_normals;
+};
+
+
+/*
+	unfold the octahedron: the lower half was mirrored over the diagonals of the square
+*/
+float3 decodeOctahedral(float2 encoded)
+{
+	float3 normal = float3(encoded.x, encoded.y, 1.0f - abs(encoded.x) - abs(encoded.y));
+	float t = saturate(-normal.z);
+	normal.xy += (normal.xy >= 0.0f) ? -t : t;
+	return normalize(normal);
+}
+
+
+VS_OUTPUT vsmain(VS_INPUT input)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+
+	float4 position = float4(m_position_offset + input.position.xyz * m_position_scale, 1.0f);
+
+	// world space
+	output.position = mul(position, m_world);
+	output.world_position = output.position.xyz;
+	// view space
+	output.position = mul(output.position, m_view);
+	// screen space
+	output.position = mul(output.position, m_proj);
+
+	output.texcoord = m_texcoord_offset_scale.xy + input.texcoord * m_texcoord_offset_scale.zw;
+	output.normal = (m_octahedral_normals > 0.5f) ? decodeOctahedral(input.normal.xy) : input.normal;
+
+	return output;
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	particles of ParticleSystem: no vertex buffer. Every instance is one ParticleVertex of the structured buffer, the 6
+	vertices of SV_VertexID make its quad (DeviceContext::drawInstancedVertexID)
+	- quads face the camera: the corner is added in view space
+	- the buffer is sorted far to near -> alpha blending without depth writes
+*/
+struct VS_OUTPUT
+{
+	float4 position: SV_POSITION;
+	float2 corner: TEXCOORD0;
+	float4 color: COLOR0;
+};
+
+cbuffer constant: register(b0)
+{
+	row_major float4x4 m_world;
+	row_major float4x4 m_view;
+	row_major float4x4 m_proj;
+	unsigned int m_time;
+	float3 ambientColor;
+	float ambientPower;
+	float3 m_vectorLight;
+};
+
+// ParticleVertex
+struct Particle
+{
+	float3 position;
+	float size;
+	uint color;			// RGBA8, red in the low byte
+};
+
+StructuredBuffer<Particle> Particles: register(t0);
+
+static const float2 corners[6] =
+{
+	float2(-1.0f, -1.0f), float2(-1.0f, 1.0f), float2(1.0f, 1.0f),
+	float2(-1.0f, -1.0f), float2(1.0f, 1.0f), float2(1.0f, -1.0f)
+};
+
+
+VS_OUTPUT vsmain(uint id: SV_VertexID, uint instance_id: SV_InstanceID)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+
+	Particle particle = Particles[instance_id];
+	float2 corner = corners[id];
+
+	float4 position = mul(float4(particle.position, 1.0f), m_view);
+	position.xy += corner * particle.size;
+	output.position = mul(position, m_proj);
+
+	output.corner = corner;
+	output.color = float4(particle.color & 0xff, (particle.color >> 8) & 0xff, (particle.color >> 16) & 0xff, particle.color >> 24) / 255.0f;
+
+	return output;
+}
+
+
+// round with a soft edge
+float4 psmain(VS_OUTPUT input) : SV_TARGET
+{
+	float alpha = saturate(1.0f - dot(input.corner, input.corner)) * input.color.a;
+	return float4(input.color.rgb, alpha);
+}
@@ -0,0 +1,658 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "ParticleSystem.h"
+#include "JobSystem.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <exception>
+
+
+static const unsigned int RADIX_BITS = 11;
+static const unsigned int RADIX_SIZE = 1 << RADIX_BITS;
+static const unsigned int RADIX_PASSES = 3;
+
+static double getMilliseconds(std::chrono::high_resolution_clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+}
+
+// random value in [0, 1) of a particle: the same emitter, particle and value always give the same number
+static float random(unsigned int emitter, unsigned int particle, unsigned int value)
+{
+	unsigned int hash = (particle * 8 + value) * 2654435761u + emitter * 0x9e3779b9u;
+	hash ^= hash >> 15;
+	hash *= 2246822519u;
+	hash ^= hash >> 13;
+	hash *= 3266489917u;
+	hash ^= hash >> 16;
+	return (hash >> 8) * (1.0f / 16777216.0f);
+}
+
+static unsigned int packColor(const Vector4D& color)
+{
+	auto channel = [](float value) { return (unsigned int)(std::min(std::max(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+	return channel(color.m_x) | (channel(color.m_y) << 8) | (channel(color.m_z) << 16) | (channel(color.m_s) << 24);
+}
+
+// the bits of a float ordered like the floats: negative ones flipped, positive ones above them
+static unsigned int getSortKey(float value)
+{
+	unsigned int bits;
+	::memcpy(&bits, &value, sizeof(bits));
+	return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+}
+
+
+unsigned int ParticleSystem::createEmitter(const ParticleEmitterSettings& settings)
+{
+	if (settings.m_lifetime_min <= 0.0f || settings.m_lifetime_max < settings.m_lifetime_min)
+		throw std::exception("ParticleSystem: the lifetime of an emitter must be positive");
+
+	Emitter emitter;
+	emitter.m_settings = settings;
+	float length = settings.m_direction.length();
+	emitter.m_settings.m_direction = length > 0.0f ? settings.m_direction * (1.0f / length) : Vector3D(0.0f, 1.0f, 0.0f);
+
+	// the keys sampled into the table, outside of the keys the first or last one
+	const std::vector<ParticleColorKey>& keys = settings.m_colors;
+	for (unsigned int i = 0; i < COLOR_TABLE_SIZE; i++)
+	{
+		float time = (float)i / (COLOR_TABLE_SIZE - 1);
+		Vector4D color(1.0f, 1.0f, 1.0f, 1.0f);
+		if (!keys.empty())
+		{
+			color = keys.front().m_color;
+			for (size_t key = 0; key < keys.size(); key++)
+			{
+				if (keys[key].m_time > time)
+				{
+					if (key)
+					{
+						const ParticleColorKey& a = keys[key - 1];
+						const ParticleColorKey& b = keys[key];
+						float t = (time - a.m_time) / std::max(b.m_time - a.m_time, 1e-6f);
+						color = Vector4D(a.m_color.m_x + (b.m_color.m_x - a.m_color.m_x) * t, a.m_color.m_y + (b.m_color.m_y - a.m_color.m_y) * t,
+							a.m_color.m_z + (b.m_color.m_z - a.m_color.m_z) * t, a.m_color.m_s + (b.m_color.m_s - a.m_color.m_s) * t);
+					}
+					break;
+				}
+				color = keys[key].m_color;
+			}
+		}
+		emitter.m_colors[i] = packColor(color);
+	}
+
+	m_emitters.push_back(emitter);
+	return (unsigned int)m_emitters.size() - 1;
+}
+
+
+void ParticleSystem::setEmitterPosition(unsigned int emitter, const Vector3D& position)
+{
+	m_emitters[emitter].m_settings.m_position = position;
+}
+
+
+void ParticleSystem::setEmitterRate(unsigned int emitter, float rate)
+{
+	m_emitters[emitter].m_settings.m_rate = rate;
+}
+
+
+void ParticleSystem::clear()
+{
+	*this = ParticleSystem();
+}
+
+
+void ParticleSystem::setSimd(bool simd)
+{
+	m_simd = simd;
+}
+
+
+unsigned int ParticleSystem::allocateBlock(unsigned int emitter)
+{
+	unsigned int block;
+	if (!m_free_blocks.empty())
+	{
+		block = m_free_blocks.back();
+		m_free_blocks.pop_back();
+	}
+	else
+	{
+		block = (unsigned int)m_block_count.size();
+		size_t size = ((size_t)block + 1) * BLOCK_SIZE;
+		for (std::vector<float>* data : { &m_position_x, &m_position_y, &m_position_z, &m_velocity_x, &m_velocity_y, &m_velocity_z, &m_age, &m_age_rate })
+			data->resize(size);
+		m_block_count.push_back(0);
+		m_block_emitter.push_back(0);
+	}
+	m_block_count[block] = 0;
+	m_block_emitter[block] = emitter;
+	m_emitters[emitter].m_blocks.push_back(block);
+	return block;
+}
+
+
+/*
+	- the particles of a step are born spread over it: the k-th of n is already (1 - k / n) of the step old, so a
+	  high rate gives an even stream instead of a puff per frame
+	- into the free space of the blocks of the emitter, a new block when they are full
+*/
+
+void ParticleSystem::spawn(Emitter& emitter, unsigned int emitter_index, float time)
+{
+	const ParticleEmitterSettings& settings = emitter.m_settings;
+	emitter.m_pending += settings.m_rate * time;
+	unsigned int count = (unsigned int)emitter.m_pending;
+	emitter.m_pending -= (float)count;
+	count = std::min(count, settings.m_capacity - std::min(emitter.m_count, settings.m_capacity));
+	if (!count)
+		return;
+
+	// a basis around the direction for the cone
+	const Vector3D& direction = settings.m_direction;
+	Vector3D side = fabsf(direction.m_x) < 0.57f ? Vector3D::cross(direction, Vector3D(1.0f, 0.0f, 0.0f)) : Vector3D::cross(direction, Vector3D(0.0f, 1.0f, 0.0f));
+	side = side * (1.0f / side.length());
+	Vector3D up = Vector3D::cross(direction, side);
+	float cos_spread = cosf(settings.m_spread);
+
+	unsigned int spawned = 0;
+	size_t block_index = 0;
+	while (spawned < count)
+	{
+		while (block_index < emitter.m_blocks.size() && m_block_count[emitter.m_blocks[block_index]] == BLOCK_SIZE)
+			block_index++;
+		unsigned int block = block_index < emitter.m_blocks.size() ? emitter.m_blocks[block_index] : allocateBlock(emitter_index);
+		unsigned int first = m_block_count[block];
+		unsigned int added = std::min(BLOCK_SIZE - first, count - spawned);
+
+		size_t base = (size_t)block * BLOCK_SIZE + first;
+		for (unsigned int i = 0; i < added; i++, spawned++)
+		{
+			unsigned int seed = emitter.m_spawned++;
+			float cos_angle = 1.0f - random(emitter_index, seed, 0) * (1.0f - cos_spread);
+			float sin_angle = sqrtf(std::max(1.0f - cos_angle * cos_angle, 0.0f));
+			float turn = random(emitter_index, seed, 1) * 6.2831853f;
+			float speed = settings.m_speed_min + (settings.m_speed_max - settings.m_speed_min) * random(emitter_index, seed, 2);
+			Vector3D velocity = (direction * cos_angle + side * (sin_angle * cosf(turn)) + up * (sin_angle * sinf(turn))) * speed;
+			Vector3D position = settings.m_position + Vector3D(settings.m_extent.m_x * (random(emitter_index, seed, 3) * 2.0f - 1.0f),
+				settings.m_extent.m_y * (random(emitter_index, seed, 4) * 2.0f - 1.0f), settings.m_extent.m_z * (random(emitter_index, seed, 5) * 2.0f - 1.0f));
+			float lifetime = settings.m_lifetime_min + (settings.m_lifetime_max - settings.m_lifetime_min) * random(emitter_index, seed, 6);
+
+			size_t index = base + i;
+			m_position_x[index] = position.m_x;
+			m_position_y[index] = position.m_y;
+			m_position_z[index] = position.m_z;
+			m_velocity_x[index] = velocity.m_x;
+			m_velocity_y[index] = velocity.m_y;
+			m_velocity_z[index] = velocity.m_z;
+			m_age_rate[index] = 1.0f / lifetime;
+			m_age[index] = std::min((1.0f - (float)spawned / count) * time / lifetime, 0.999f);
+		}
+		m_block_count[block] += added;
+	}
+	emitter.m_count += count;
+}
+
+
+/*
+	- SSE2: four particles per instruction. The live ones of four are stored at the write position: all four with one
+	  store per array when none died, one by one otherwise
+	- the same operations in the same order as simulateBlockScalar -> the same particles
+*/
+
+void ParticleSystem::simulateBlock(unsigned int block, float time)
+{
+	size_t base = (size_t)block * BLOCK_SIZE;
+	float* position_x = m_position_x.data() + base;
+	float* position_y = m_position_y.data() + base;
+	float* position_z = m_position_z.data() + base;
+	float* velocity_x = m_velocity_x.data() + base;
+	float* velocity_y = m_velocity_y.data() + base;
+	float* velocity_z = m_velocity_z.data() + base;
+	float* age = m_age.data() + base;
+	float* age_rate = m_age_rate.data() + base;
+	unsigned int count = m_block_count[block];
+
+	const ParticleEmitterSettings& settings = m_emitters[m_block_emitter[block]].m_settings;
+	float damping = std::max(1.0f - settings.m_drag * time, 0.0f);
+	Vector3D acceleration = settings.m_acceleration * time;
+
+	__m128 step = _mm_set1_ps(time);
+	__m128 damp = _mm_set1_ps(damping);
+	__m128 add_x = _mm_set1_ps(acceleration.m_x);
+	__m128 add_y = _mm_set1_ps(acceleration.m_y);
+	__m128 add_z = _mm_set1_ps(acceleration.m_z);
+	__m128 one = _mm_set1_ps(1.0f);
+
+	unsigned int live = 0;
+	unsigned int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(velocity_x + i), damp), add_x);
+		__m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(velocity_y + i), damp), add_y);
+		__m128 vz = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(velocity_z + i), damp), add_z);
+		__m128 px = _mm_add_ps(_mm_loadu_ps(position_x + i), _mm_mul_ps(vx, step));
+		__m128 py = _mm_add_ps(_mm_loadu_ps(position_y + i), _mm_mul_ps(vy, step));
+		__m128 pz = _mm_add_ps(_mm_loadu_ps(position_z + i), _mm_mul_ps(vz, step));
+		__m128 rate = _mm_loadu_ps(age_rate + i);
+		__m128 a = _mm_add_ps(_mm_loadu_ps(age + i), _mm_mul_ps(rate, step));
+		int alive = _mm_movemask_ps(_mm_cmplt_ps(a, one));
+
+		if (alive == 15)
+		{
+			_mm_storeu_ps(position_x + live, px);
+			_mm_storeu_ps(position_y + live, py);
+			_mm_storeu_ps(position_z + live, pz);
+			_mm_storeu_ps(velocity_x + live, vx);
+			_mm_storeu_ps(velocity_y + live, vy);
+			_mm_storeu_ps(velocity_z + live, vz);
+			_mm_storeu_ps(age + live, a);
+			_mm_storeu_ps(age_rate + live, rate);
+			live += 4;
+		}
+		else if (alive)
+		{
+			alignas(16) float lanes[8][4];
+			_mm_store_ps(lanes[0], px);
+			_mm_store_ps(lanes[1], py);
+			_mm_store_ps(lanes[2], pz);
+			_mm_store_ps(lanes[3], vx);
+			_mm_store_ps(lanes[4], vy);
+			_mm_store_ps(lanes[5], vz);
+			_mm_store_ps(lanes[6], a);
+			_mm_store_ps(lanes[7], rate);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (!(alive & (1 << lane)))
+					continue;
+				position_x[live] = lanes[0][lane];
+				position_y[live] = lanes[1][lane];
+				position_z[live] = lanes[2][lane];
+				velocity_x[live] = lanes[3][lane];
+				velocity_y[live] = lanes[4][lane];
+				velocity_z[live] = lanes[5][lane];
+				age[live] = lanes[6][lane];
+				age_rate[live] = lanes[7][lane];
+				live++;
+			}
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		float vx = velocity_x[i] * damping + acceleration.m_x;
+		float vy = velocity_y[i] * damping + acceleration.m_y;
+		float vz = velocity_z[i] * damping + acceleration.m_z;
+		float a = age[i] + age_rate[i] * time;
+		if (!(a < 1.0f))
+			continue;
+		position_x[live] = position_x[i] + vx * time;
+		position_y[live] = position_y[i] + vy * time;
+		position_z[live] = position_z[i] + vz * time;
+		velocity_x[live] = vx;
+		velocity_y[live] = vy;
+		velocity_z[live] = vz;
+		age[live] = a;
+		age_rate[live] = age_rate[i];
+		live++;
+	}
+	m_block_count[block] = live;
+}
+
+
+void ParticleSystem::simulateBlockScalar(unsigned int block, float time)
+{
+	size_t base = (size_t)block * BLOCK_SIZE;
+	unsigned int count = m_block_count[block];
+	const ParticleEmitterSettings& settings = m_emitters[m_block_emitter[block]].m_settings;
+	float damping = std::max(1.0f - settings.m_drag * time, 0.0f);
+	Vector3D acceleration = settings.m_acceleration * time;
+
+	size_t live = base;
+	for (size_t i = base; i < base + count; i++)
+	{
+		float vx = m_velocity_x[i] * damping + acceleration.m_x;
+		float vy = m_velocity_y[i] * damping + acceleration.m_y;
+		float vz = m_velocity_z[i] * damping + acceleration.m_z;
+		float a = m_age[i] + m_age_rate[i] * time;
+		if (!(a < 1.0f))
+			continue;
+		m_position_x[live] = m_position_x[i] + vx * time;
+		m_position_y[live] = m_position_y[i] + vy * time;
+		m_position_z[live] = m_position_z[i] + vz * time;
+		m_velocity_x[live] = vx;
+		m_velocity_y[live] = vy;
+		m_velocity_z[live] = vz;
+		m_age[live] = a;
+		m_age_rate[live] = m_age_rate[i];
+		live++;
+	}
+	m_block_count[block] = (unsigned int)(live - base);
+}
+
+
+void ParticleSystem::update(float time)
+{
+	if (time <= 0.0f)
+		return;
+
+	auto start = std::chrono::high_resolution_clock::now();
+	m_stats.m_spawned = 0;
+	for (unsigned int emitter = 0; emitter < m_emitters.size(); emitter++)
+	{
+		unsigned int before = m_emitters[emitter].m_count;
+		spawn(m_emitters[emitter], emitter, time);
+		m_stats.m_spawned += m_emitters[emitter].m_count - before;
+	}
+	m_stats.m_spawn_ms = getMilliseconds(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	unsigned int blocks = (unsigned int)m_block_count.size();
+	JobSystem::get()->parallelFor(blocks, 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int block = begin; block < end; block++)
+			{
+				if (!m_block_count[block])
+					continue;
+				if (m_simd)
+					simulateBlock(block, time);
+				else
+					simulateBlockScalar(block, time);
+			}
+		});
+
+	// counts of the emitters, empty blocks back to the free list
+	m_stats.m_particles = 0;
+	m_stats.m_blocks = 0;
+	for (unsigned int emitter = 0; emitter < m_emitters.size(); emitter++)
+	{
+		Emitter& data = m_emitters[emitter];
+		data.m_count = 0;
+		for (size_t i = 0; i < data.m_blocks.size();)
+		{
+			unsigned int block = data.m_blocks[i];
+			if (!m_block_count[block])
+			{
+				m_free_blocks.push_back(block);
+				data.m_blocks[i] = data.m_blocks.back();
+				data.m_blocks.pop_back();
+				continue;
+			}
+			data.m_count += m_block_count[block];
+			i++;
+		}
+		m_stats.m_particles += data.m_count;
+		m_stats.m_blocks += (unsigned int)data.m_blocks.size();
+	}
+	m_stats.m_emitters = (unsigned int)m_emitters.size();
+	m_stats.m_simulate_ms = getMilliseconds(start);
+}
+
+
+/*
+	- LSD radix sort of m_keys[0] with m_indices[0] along, stable -> equal depths keep the block order. The keys end
+	  in m_keys[0] and m_indices[0]
+	- every chunk counts its digits, the offsets of a digit in a chunk follow the same digit of the chunks before ->
+	  the chunks scatter in parallel without atomics. A pass whose digit is the same for all keys is skipped
+*/
+
+void ParticleSystem::sortKeys(unsigned int count)
+{
+	unsigned int jobs = JobSystem::get()->getThreadCount() * 4;
+	unsigned int group = std::max((count + jobs - 1) / jobs, 16384u);
+	unsigned int chunks = (count + group - 1) / group;
+	m_histograms.resize((size_t)chunks * RADIX_SIZE);
+	m_keys[1].resize(count);
+	m_indices[1].resize(count);
+
+	unsigned int source = 0;
+	for (unsigned int pass = 0; pass < RADIX_PASSES; pass++)
+	{
+		unsigned int shift = pass * RADIX_BITS;
+		const unsigned int* keys = m_keys[source].data();
+		JobSystem::get()->parallelFor(count, group, [&](unsigned int begin, unsigned int end)
+			{
+				unsigned int* histogram = m_histograms.data() + (size_t)(begin / group) * RADIX_SIZE;
+				std::fill(histogram, histogram + RADIX_SIZE, 0u);
+				for (unsigned int i = begin; i < end; i++)
+					histogram[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+			});
+
+		// exclusive offsets, digit by digit over the chunks
+		unsigned int offset = 0;
+		bool single = false;
+		for (unsigned int digit = 0; digit < RADIX_SIZE; digit++)
+		{
+			unsigned int total = 0;
+			for (unsigned int chunk = 0; chunk < chunks; chunk++)
+			{
+				unsigned int& value = m_histograms[(size_t)chunk * RADIX_SIZE + digit];
+				unsigned int digit_count = value;
+				value = offset + total;
+				total += digit_count;
+			}
+			single = single || total == count;
+			offset += total;
+		}
+		if (single)
+			continue;
+
+		unsigned int target = source ^ 1;
+		unsigned int* out_keys = m_keys[target].data();
+		unsigned int* out_indices = m_indices[target].data();
+		const unsigned int* indices = m_indices[source].data();
+		JobSystem::get()->parallelFor(count, group, [&](unsigned int begin, unsigned int end)
+			{
+				unsigned int* histogram = m_histograms.data() + (size_t)(begin / group) * RADIX_SIZE;
+				for (unsigned int i = begin; i < end; i++)
+				{
+					unsigned int position = histogram[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+					out_keys[position] = keys[i];
+					out_indices[position] = indices[i];
+				}
+			});
+		source = target;
+	}
+
+	if (source)
+	{
+		m_keys[0].swap(m_keys[1]);
+		m_indices[0].swap(m_indices[1]);
+	}
+}
+
+
+/*
+	- the blocks in parallel, each writes its vertices from the first vertex of the block on. Sorted: into
+	  m_unsorted with the keys, then gathered in key order into the output
+	- far particles get the small keys (inverted depth) -> the sort is ascending and draws them first
+*/
+
+void ParticleSystem::fillVertices(const Vector3D& camera, const Vector3D& forward, bool sort, std::vector<ParticleVertex>& vertices)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+	m_live_blocks.clear();
+	m_block_start.clear();
+	unsigned int count = 0;
+	for (unsigned int block = 0; block < m_block_count.size(); block++)
+	{
+		if (!m_block_count[block])
+			continue;
+		m_live_blocks.push_back(block);
+		m_block_start.push_back(count);
+		count += m_block_count[block];
+	}
+
+	vertices.resize(count);
+	std::vector<ParticleVertex>& target = sort ? m_unsorted : vertices;
+	if (sort)
+	{
+		m_unsorted.resize(count);
+		m_keys[0].resize(count);
+		m_indices[0].resize(count);
+	}
+
+	JobSystem::get()->parallelFor((unsigned int)m_live_blocks.size(), 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int live = begin; live < end; live++)
+			{
+				unsigned int block = m_live_blocks[live];
+				const Emitter& emitter = m_emitters[m_block_emitter[block]];
+				float size_start = emitter.m_settings.m_size_start;
+				float size_range = emitter.m_settings.m_size_end - size_start;
+				size_t base = (size_t)block * BLOCK_SIZE;
+				unsigned int first = m_block_start[live];
+				unsigned int particles = m_block_count[block];
+
+				for (unsigned int i = 0; i < particles; i++)
+				{
+					ParticleVertex& vertex = target[first + i];
+					float x = m_position_x[base + i], y = m_position_y[base + i], z = m_position_z[base + i];
+					float age = m_age[base + i];
+					vertex.m_position[0] = x;
+					vertex.m_position[1] = y;
+					vertex.m_position[2] = z;
+					vertex.m_size = size_start + size_range * age;
+					vertex.m_color = emitter.m_colors[std::min((unsigned int)(age * (COLOR_TABLE_SIZE - 1) + 0.5f), COLOR_TABLE_SIZE - 1)];
+				}
+
+				if (!sort)
+					continue;
+				unsigned int* keys = m_keys[0].data() + first;
+				unsigned int* indices = m_indices[0].data() + first;
+				for (unsigned int i = 0; i < particles; i++)
+				{
+					float depth = (m_position_x[base + i] - camera.m_x) * forward.m_x + (m_position_y[base + i] - camera.m_y) * forward.m_y +
+						(m_position_z[base + i] - camera.m_z) * forward.m_z;
+					keys[i] = ~getSortKey(depth);
+					indices[i] = first + i;
+				}
+			}
+		});
+	m_stats.m_fill_ms = getMilliseconds(start);
+
+	m_stats.m_sort_ms = 0.0;
+	if (!sort || !count)
+		return;
+
+	start = std::chrono::high_resolution_clock::now();
+	sortKeys(count);
+	m_stats.m_sort_ms = getMilliseconds(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	JobSystem::get()->parallelFor(count, 16384, [&](unsigned int begin, unsigned int end)
+		{
+			const unsigned int* indices = m_indices[0].data();
+			for (unsigned int i = begin; i < end; i++)
+				vertices[i] = m_unsorted[indices[i]];
+		});
+	m_stats.m_fill_ms += getMilliseconds(start);
+}
+
+
+unsigned int ParticleSystem::getParticleCount() const
+{
+	return m_stats.m_particles;
+}
+
+
+const ParticleStats& ParticleSystem::getStats() const
+{
+	return m_stats;
+}
+
+
+ParticleBenchmark ParticleSystem::runBenchmark(unsigned int particles, unsigned int frames)
+{
+	ParticleBenchmark result;
+	result.m_frames = frames;
+	result.m_threads = JobSystem::get()->getThreadCount();
+	if (!particles || !frames)
+		return result;
+
+	// fountains in a ring, each with room for its share and a rate that keeps it full
+	const unsigned int emitters = 8;
+	ParticleSystem system;
+	for (unsigned int i = 0; i < emitters; i++)
+	{
+		float angle = i * 6.2831853f / emitters;
+		ParticleEmitterSettings settings;
+		settings.m_position = Vector3D(cosf(angle) * 10.0f, 0.0f, sinf(angle) * 10.0f);
+		settings.m_spread = 0.4f;
+		settings.m_speed_min = 6.0f;
+		settings.m_speed_max = 10.0f;
+		settings.m_lifetime_min = 1.5f;
+		settings.m_lifetime_max = 2.5f;
+		settings.m_drag = 0.2f;
+		settings.m_capacity = (particles + emitters - 1) / emitters;
+		settings.m_rate = settings.m_capacity / settings.m_lifetime_min;
+		settings.m_colors = { { 0.0f, Vector4D(1.0f, 0.9f, 0.5f, 1.0f) }, { 0.5f, Vector4D(1.0f, 0.4f, 0.1f, 0.8f) }, { 1.0f, Vector4D(0.2f, 0.2f, 0.2f, 0.0f) } };
+		system.createEmitter(settings);
+	}
+
+	// a whole lifetime until the emitters are full and particles die as fast as they are born
+	for (unsigned int frame = 0; frame < 150; frame++)
+		system.update(1.0f / 60.0f);
+
+	Vector3D camera(0.0f, 5.0f, -30.0f);
+	Vector3D forward(0.0f, 0.0f, 1.0f);
+	std::vector<ParticleVertex> vertices;
+	double particle_sum = 0.0;
+	for (int simd = 0; simd < 2; simd++)
+	{
+		system.setSimd(simd != 0);
+		for (unsigned int frame = 0; frame < frames; frame++)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			system.update(1.0f / 60.0f);
+			result.m_simulate_ms[simd] += system.getStats().m_simulate_ms;
+			if (!simd)
+				continue;
+
+			system.fillVertices(camera, forward, true, vertices);
+			result.m_frame_ms += getMilliseconds(start);
+			result.m_sort_ms += system.getStats().m_sort_ms;
+			result.m_fill_ms += system.getStats().m_fill_ms;
+			particle_sum += system.getParticleCount();
+		}
+		result.m_simulate_ms[simd] /= frames;
+	}
+
+	result.m_particles = (unsigned int)(particle_sum / frames);
+	result.m_sort_ms /= frames;
+	result.m_fill_ms /= frames;
+	result.m_frame_ms /= frames;
+	result.m_megabytes = result.m_particles * sizeof(ParticleVertex) / (1024.0 * 1024.0);
+	return result;
+}
@@ -0,0 +1,174 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Vector3D.h"
+#include "Vector4D.h"
+#include <vector>
+
+// one particle for ParticleShader.hlsl t0: the vertex shader builds a quad facing the camera around it
+struct ParticleVertex
+{
+	float m_position[3] = {};
+	float m_size = 0.0f;
+	unsigned int m_color = 0;				// RGBA8, red in the low byte
+};
+
+// color and alpha at a point of the life of a particle, 0 born, 1 dead
+struct ParticleColorKey
+{
+	float m_time = 0.0f;
+	Vector4D m_color;
+};
+
+struct ParticleEmitterSettings
+{
+	Vector3D m_position;
+	Vector3D m_direction = Vector3D(0.0f, 1.0f, 0.0f);
+	float m_spread = 0.3f;					// angle of the cone around m_direction, radians
+	Vector3D m_extent;						// particles start anywhere in this box around m_position
+	float m_rate = 1000.0f;					// particles per second
+	float m_speed_min = 2.0f;
+	float m_speed_max = 4.0f;
+	float m_lifetime_min = 1.0f;
+	float m_lifetime_max = 2.0f;
+	float m_size_start = 0.1f;
+	float m_size_end = 0.3f;
+	// forces: a constant acceleration (gravity, buoyancy of smoke) and drag, the part of the velocity lost per second
+	Vector3D m_acceleration = Vector3D(0.0f, -9.81f, 0.0f);
+	float m_drag = 0.0f;
+	std::vector<ParticleColorKey> m_colors;	// sorted by time, none -> white
+	unsigned int m_capacity = 16384;		// the emitter stops spawning while this many live
+};
+
+struct ParticleStats
+{
+	unsigned int m_particles = 0;
+	unsigned int m_emitters = 0;
+	unsigned int m_blocks = 0;
+	unsigned int m_spawned = 0;				// in the last update
+	double m_spawn_ms = 0.0;
+	double m_simulate_ms = 0.0;
+	double m_sort_ms = 0.0;
+	double m_fill_ms = 0.0;					// depth keys and vertices
+};
+
+struct ParticleBenchmark
+{
+	unsigned int m_particles = 0;
+	unsigned int m_frames = 0;
+	unsigned int m_threads = 0;
+	double m_simulate_ms[2] = {};			// scalar, SSE2
+	double m_sort_ms = 0.0;
+	double m_fill_ms = 0.0;
+	double m_frame_ms = 0.0;				// SSE2 update and sorted vertices
+	double m_megabytes = 0.0;				// vertices streamed per frame
+};
+
+
+/*
+	ParticleSystem: emitters and their particles, simulated on the CPU and handed to the GPU as sorted vertices
+
+	- particles live in blocks of BLOCK_SIZE. Every block belongs to one emitter and keeps its live particles at its
+	  front, in SoA arrays (positions, velocities, ages, ...) -> the update is plain SIMD over floats with the settings
+	  of one emitter, and the blocks are the chunks the JobSystem runs in parallel. Empty blocks go back to a free list
+	- update(): spawn (each emitter on one thread, a hash of its spawn counter for the random values -> the same
+	  particles on every run and thread count), then every block: forces, integration, age. Dead particles are
+	  dropped by moving the live ones of the block together, in the same pass
+	- size grows linearly over the life, color and alpha come from a table sampled from the keys of the emitter
+	- fillVertices(): depth keys along the view direction and the vertices. Sorted far to near for blending with an
+	  LSD radix sort over the 32-bit keys, 3 passes of 11 bits, histograms and scatter in parallel
+*/
+
+class ParticleSystem
+{
+public:
+
+	static const unsigned int BLOCK_SIZE = 4096;
+	static const unsigned int COLOR_TABLE_SIZE = 64;
+
+	unsigned int createEmitter(const ParticleEmitterSettings& settings);
+	void setEmitterPosition(unsigned int emitter, const Vector3D& position);
+	// rate 0 stops spawning, the live particles still finish their life
+	void setEmitterRate(unsigned int emitter, float rate);
+	// all emitters and particles
+	void clear();
+
+	// scalar instead of SSE2, for the benchmark
+	void setSimd(bool simd);
+
+	void update(float time);
+	// back to front along forward from the camera when sorted, block order otherwise
+	void fillVertices(const Vector3D& camera, const Vector3D& forward, bool sort, std::vector<ParticleVertex>& vertices);
+
+	unsigned int getParticleCount() const;
+	const ParticleStats& getStats() const;
+
+	// emitters sharing particles, filled to about particles and updated for frames of 1/60 s, sorted every frame
+	static ParticleBenchmark runBenchmark(unsigned int particles, unsigned int frames);
+
+private:
+
+	struct Emitter
+	{
+		ParticleEmitterSettings m_settings;
+		unsigned int m_colors[COLOR_TABLE_SIZE] = {};
+		std::vector<unsigned int> m_blocks;
+		unsigned int m_count = 0;
+		float m_pending = 0.0f;				// fraction of a particle left to spawn
+		unsigned int m_spawned = 0;			// seed of the next particle
+	};
+
+	void spawn(Emitter& emitter, unsigned int emitter_index, float time);
+	unsigned int allocateBlock(unsigned int emitter);
+	void simulateBlock(unsigned int block, float time);
+	void simulateBlockScalar(unsigned int block, float time);
+	void sortKeys(unsigned int count);
+
+private:
+
+	std::vector<Emitter> m_emitters;
+	bool m_simd = true;
+
+	// BLOCK_SIZE per block
+	std::vector<float> m_position_x, m_position_y, m_position_z;
+	std::vector<float> m_velocity_x, m_velocity_y, m_velocity_z;
+	std::vector<float> m_age;				// 0 born, 1 dead
+	std::vector<float> m_age_rate;			// 1 / lifetime
+	std::vector<unsigned int> m_block_count;
+	std::vector<unsigned int> m_block_emitter;
+	std::vector<unsigned int> m_free_blocks;
+
+	// fillVertices: live blocks, their first vertex, the keys and vertex indices (two of each for the sort passes)
+	std::vector<unsigned int> m_live_blocks;
+	std::vector<unsigned int> m_block_start;
+	std::vector<unsigned int> m_keys[2];
+	std::vector<unsigned int> m_indices[2];
+	std::vector<ParticleVertex> m_unsorted;
+	std::vector<unsigned int> m_histograms;
+
+	ParticleStats m_stats;
+};
@@ -0,0 +1,853 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "PhysicsContacts.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+static const unsigned int MAX_VERTICES = PhysicsShape::MAX_HULL_VERTICES;
+static const unsigned int MAX_FACES = MAX_VERTICES * 2;
+static const unsigned int MAX_DIRECTIONS = MAX_VERTICES * 3;
+static const unsigned int MAX_CLIP_POINTS = MAX_VERTICES * 3;
+
+// cos of the angle up to which a face counts as lying on the normal of a rounded contact
+static const float FACE_ALIGNMENT = 0.99f;
+// an edge axis has to separate this much more than the best face axis
+static const float EDGE_TOLERANCE = 0.001f;
+
+// a shape in world space
+struct Polytope
+{
+	Vector3D m_vertices[MAX_VERTICES];
+	unsigned int m_vertex_count;
+	Vector3D m_normals[MAX_FACES];
+	float m_distances[MAX_FACES];
+	const PhysicsFace* m_faces;
+	unsigned int m_face_count;
+	const unsigned int* m_face_vertices;
+	const PhysicsEdge* m_edges;
+	unsigned int m_edge_count;
+	Vector3D m_directions[MAX_DIRECTIONS];
+	unsigned int m_direction_count;
+	float m_radius;
+	Vector3D m_center;
+};
+
+// a triangle of a mesh: a polyhedron with a face to each side
+static const PhysicsFace TRIANGLE_FACES[2] = { { Vector3D(), 0.0f, 0, 3 }, { Vector3D(), 0.0f, 3, 3 } };
+static const unsigned int TRIANGLE_FACE_VERTICES[6] = { 0, 1, 2, 0, 2, 1 };
+static const PhysicsEdge TRIANGLE_EDGES[3] = { { 0, 1, 0 }, { 1, 2, 1 }, { 0, 2, 2 } };
+
+
+static Vector3D rotate(const float rotation[9], const Vector3D& v)
+{
+	return Vector3D(rotation[0] * v.m_x + rotation[1] * v.m_y + rotation[2] * v.m_z, rotation[3] * v.m_x + rotation[4] * v.m_y + rotation[5] * v.m_z,
+		rotation[6] * v.m_x + rotation[7] * v.m_y + rotation[8] * v.m_z);
+}
+
+static Vector3D rotateInverse(const float rotation[9], const Vector3D& v)
+{
+	return Vector3D(rotation[0] * v.m_x + rotation[3] * v.m_y + rotation[6] * v.m_z, rotation[1] * v.m_x + rotation[4] * v.m_y + rotation[7] * v.m_z,
+		rotation[2] * v.m_x + rotation[5] * v.m_y + rotation[8] * v.m_z);
+}
+
+static Vector3D normalize(const Vector3D& v)
+{
+	return v * (1.0f / std::max(v.length(), FLT_MIN));
+}
+
+
+static void makePolytope(const PhysicsShape& shape, const PhysicsPose& pose, Polytope& polytope)
+{
+	const std::vector<Vector3D>& vertices = shape.getVertices();
+	polytope.m_vertex_count = (unsigned int)vertices.size();
+	for (unsigned int i = 0; i < polytope.m_vertex_count; i++)
+		polytope.m_vertices[i] = rotate(pose.m_rotation, vertices[i]) + pose.m_position;
+
+	const std::vector<PhysicsFace>& faces = shape.getFaces();
+	polytope.m_faces = faces.data();
+	polytope.m_face_count = (unsigned int)faces.size();
+	polytope.m_face_vertices = shape.getFaceVertices().data();
+	for (unsigned int i = 0; i < polytope.m_face_count; i++)
+	{
+		polytope.m_normals[i] = rotate(pose.m_rotation, faces[i].m_normal);
+		polytope.m_distances[i] = faces[i].m_distance + Vector3D::dot(polytope.m_normals[i], pose.m_position);
+	}
+
+	polytope.m_edges = shape.getEdges().data();
+	polytope.m_edge_count = (unsigned int)shape.getEdges().size();
+	const std::vector<Vector3D>& directions = shape.getEdgeDirections();
+	polytope.m_direction_count = (unsigned int)directions.size();
+	for (unsigned int i = 0; i < polytope.m_direction_count; i++)
+		polytope.m_directions[i] = rotate(pose.m_rotation, directions[i]);
+
+	polytope.m_radius = shape.getRadius();
+	polytope.m_center = pose.m_position;
+}
+
+
+// false for a triangle without area
+static bool makeTriangle(const Vector3D* corners, const PhysicsPose& pose, Polytope& polytope)
+{
+	for (int i = 0; i < 3; i++)
+		polytope.m_vertices[i] = rotate(pose.m_rotation, corners[i]) + pose.m_position;
+	const Vector3D* v = polytope.m_vertices;
+	Vector3D normal = Vector3D::cross(v[1] - v[0], v[2] - v[0]);
+	float length = normal.length();
+	if (length <= 1e-12f)
+		return false;
+	normal = normal * (1.0f / length);
+
+	polytope.m_vertex_count = 3;
+	polytope.m_normals[0] = normal;
+	polytope.m_distances[0] = Vector3D::dot(normal, v[0]);
+	polytope.m_normals[1] = normal * -1.0f;
+	polytope.m_distances[1] = -polytope.m_distances[0];
+	polytope.m_faces = TRIANGLE_FACES;
+	polytope.m_face_count = 2;
+	polytope.m_face_vertices = TRIANGLE_FACE_VERTICES;
+	polytope.m_edges = TRIANGLE_EDGES;
+	polytope.m_edge_count = 3;
+	polytope.m_directions[0] = normalize(v[1] - v[0]);
+	polytope.m_directions[1] = normalize(v[2] - v[1]);
+	polytope.m_directions[2] = normalize(v[2] - v[0]);
+	polytope.m_direction_count = 3;
+	polytope.m_radius = 0.0f;
+	polytope.m_center = (v[0] + v[1] + v[2]) * (1.0f / 3.0f);
+	return true;
+}
+
+
+static unsigned int findSupport(const Polytope& polytope, const Vector3D& direction)
+{
+	unsigned int best = 0;
+	float best_value = -FLT_MAX;
+	for (unsigned int i = 0; i < polytope.m_vertex_count; i++)
+	{
+		float value = Vector3D::dot(polytope.m_vertices[i], direction);
+		if (value > best_value)
+		{
+			best_value = value;
+			best = i;
+		}
+	}
+	return best;
+}
+
+
+static void project(const Polytope& polytope, const Vector3D& axis, float& min, float& max)
+{
+	min = FLT_MAX;
+	max = -FLT_MAX;
+	for (unsigned int i = 0; i < polytope.m_vertex_count; i++)
+	{
+		float value = Vector3D::dot(polytope.m_vertices[i], axis);
+		min = std::min(min, value);
+		max = std::max(max, value);
+	}
+}
+
+
+/*
+	GJK on the cores
+	- the closest point of the simplex to the origin: of all subsets whose affine closest point has positive weights, the
+	  nearest one. At most 15 subsets, no special cases for the Voronoi regions of triangles and tetrahedra
+*/
+
+struct SimplexPoint
+{
+	Vector3D m_a;
+	Vector3D m_b;
+	Vector3D m_w;		// m_a - m_b
+};
+
+// false when the origin is inside the tetrahedron
+static bool reduceSimplex(SimplexPoint* simplex, unsigned int& count, Vector3D& closest, float weights[4])
+{
+	float best = FLT_MAX;
+	unsigned int best_mask = 0;
+	float best_weights[4] = {};
+	for (unsigned int mask = 1; mask < (1u << count); mask++)
+	{
+		unsigned int index[4];
+		unsigned int size = 0;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (mask & (1u << i))
+				index[size++] = i;
+		}
+
+		// closest = w0 + sum of mu_i * e_i, perpendicular to every e_i
+		float lambda[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+		if (size > 1)
+		{
+			const Vector3D& origin = simplex[index[0]].m_w;
+			Vector3D e[3];
+			float m[3][3], rhs[3], mu[3];
+			unsigned int n = size - 1;
+			for (unsigned int i = 0; i < n; i++)
+				e[i] = simplex[index[i + 1]].m_w - origin;
+			for (unsigned int i = 0; i < n; i++)
+			{
+				for (unsigned int j = 0; j < n; j++)
+					m[i][j] = Vector3D::dot(e[i], e[j]);
+				rhs[i] = -Vector3D::dot(e[i], origin);
+			}
+
+			// Cramer's rule. The determinant of the Gram matrix is at most the product of its diagonal
+			float det, diagonal;
+			if (n == 1)
+			{
+				det = m[0][0];
+				diagonal = m[0][0];
+				mu[0] = rhs[0] / det;
+			}
+			else if (n == 2)
+			{
+				det = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+				diagonal = m[0][0] * m[1][1];
+				mu[0] = (rhs[0] * m[1][1] - m[0][1] * rhs[1]) / det;
+				mu[1] = (m[0][0] * rhs[1] - rhs[0] * m[1][0]) / det;
+			}
+			else
+			{
+				auto det3 = [](float a[3][3])
+				{
+					return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+						a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+				};
+				det = det3(m);
+				diagonal = m[0][0] * m[1][1] * m[2][2];
+				for (unsigned int column = 0; column < 3; column++)
+				{
+					float replaced[3][3];
+					for (unsigned int i = 0; i < 3; i++)
+					{
+						for (unsigned int j = 0; j < 3; j++)
+							replaced[i][j] = j == column ? rhs[i] : m[i][j];
+					}
+					mu[column] = det3(replaced) / det;
+				}
+			}
+			if (!(fabsf(det) > diagonal * 1e-6f))
+				continue;
+
+			lambda[0] = 1.0f;
+			for (unsigned int i = 0; i < n; i++)
+			{
+				lambda[i + 1] = mu[i];
+				lambda[0] -= mu[i];
+			}
+		}
+
+		bool inside = true;
+		Vector3D point;
+		for (unsigned int i = 0; i < size; i++)
+		{
+			inside &= lambda[i] > 0.0f;
+			point = point + simplex[index[i]].m_w * lambda[i];
+		}
+		float distance = Vector3D::dot(point, point);
+		if (inside && distance < best)
+		{
+			best = distance;
+			best_mask = mask;
+			for (unsigned int i = 0; i < 4; i++)
+				best_weights[i] = lambda[i];
+			closest = point;
+		}
+	}
+
+	unsigned int size = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (best_mask & (1u << i))
+		{
+			weights[size] = best_weights[size];
+			simplex[size++] = simplex[i];
+		}
+	}
+	count = size;
+	return size < 4;
+}
+
+
+// closest points of the cores, false when they overlap
+static bool findClosestPoints(const Polytope& a, const Polytope& b, Vector3D& point_a, Vector3D& point_b)
+{
+	SimplexPoint simplex[4];
+	simplex[0].m_a = a.m_vertices[0];
+	simplex[0].m_b = b.m_vertices[0];
+	simplex[0].m_w = simplex[0].m_a - simplex[0].m_b;
+	unsigned int count = 1;
+	float weights[4] = { 1.0f, 0.0f, 0.0f, 0.0f };
+	Vector3D v = simplex[0].m_w;
+
+	float last = FLT_MAX;
+	for (int iteration = 0; iteration < 32; iteration++)
+	{
+		float distance = Vector3D::dot(v, v);
+		if (distance < 1e-12f)
+			return false;
+
+		SimplexPoint point;
+		point.m_a = a.m_vertices[findSupport(a, v * -1.0f)];
+		point.m_b = b.m_vertices[findSupport(b, v)];
+		point.m_w = point.m_a - point.m_b;
+		// no point of the difference is nearer along v
+		if (distance - Vector3D::dot(v, point.m_w) <= distance * 1e-6f)
+			break;
+
+		simplex[count++] = point;
+		if (!reduceSimplex(simplex, count, v, weights))
+			return false;
+		if (Vector3D::dot(v, v) >= last)
+			break;
+		last = Vector3D::dot(v, v);
+	}
+
+	point_a = Vector3D();
+	point_b = Vector3D();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		point_a = point_a + simplex[i].m_a * weights[i];
+		point_b = point_b + simplex[i].m_b * weights[i];
+	}
+	return true;
+}
+
+
+/*
+	separating axis test of the cores
+*/
+
+enum class AxisType
+{
+	None,
+	FaceA,
+	FaceB,
+	Edges
+};
+
+struct SeparatingAxis
+{
+	AxisType m_type = AxisType::None;
+	unsigned int m_a = 0;		// face or edge direction of a
+	unsigned int m_b = 0;
+	Vector3D m_normal;			// from a to b
+	float m_separation = -FLT_MAX;
+};
+
+// false when an axis separates the cores by more than limit
+static bool findAxis(const Polytope& a, const Polytope& b, float limit, SeparatingAxis& axis)
+{
+	float min, max;
+	for (unsigned int face = 0; face < a.m_face_count; face++)
+	{
+		project(b, a.m_normals[face], min, max);
+		float separation = min - a.m_distances[face];
+		if (separation > limit)
+			return false;
+		if (separation > axis.m_separation)
+		{
+			axis.m_type = AxisType::FaceA;
+			axis.m_a = face;
+			axis.m_normal = a.m_normals[face];
+			axis.m_separation = separation;
+		}
+	}
+	for (unsigned int face = 0; face < b.m_face_count; face++)
+	{
+		project(a, b.m_normals[face], min, max);
+		float separation = min - b.m_distances[face];
+		if (separation > limit)
+			return false;
+		if (separation > axis.m_separation)
+		{
+			axis.m_type = AxisType::FaceB;
+			axis.m_b = face;
+			axis.m_normal = b.m_normals[face] * -1.0f;
+			axis.m_separation = separation;
+		}
+	}
+
+	float face_separation = axis.m_separation;
+	for (unsigned int i = 0; i < a.m_direction_count; i++)
+	{
+		for (unsigned int j = 0; j < b.m_direction_count; j++)
+		{
+			Vector3D normal = Vector3D::cross(a.m_directions[i], b.m_directions[j]);
+			float length = normal.length();
+			if (length < 1e-3f)
+				continue;
+			normal = normal * (1.0f / length);
+
+			float min_a, max_a, min_b, max_b;
+			project(a, normal, min_a, max_a);
+			project(b, normal, min_b, max_b);
+			float separation = min_b - max_a;
+			if (max_b - min_a < -separation)
+			{
+				normal = normal * -1.0f;
+				separation = min_a - max_b;
+			}
+			if (separation > limit)
+				return false;
+			if (separation > axis.m_separation && separation > face_separation + EDGE_TOLERANCE)
+			{
+				axis.m_type = AxisType::Edges;
+				axis.m_a = i;
+				axis.m_b = j;
+				axis.m_normal = normal;
+				axis.m_separation = separation;
+			}
+		}
+	}
+	return true;
+}
+
+
+/*
+	contact points
+*/
+
+// the face whose normal is closest to direction, -1 without faces
+static int findFace(const Polytope& polytope, const Vector3D& direction, float& alignment)
+{
+	int best = -1;
+	alignment = -FLT_MAX;
+	for (unsigned int face = 0; face < polytope.m_face_count; face++)
+	{
+		float value = Vector3D::dot(polytope.m_normals[face], direction);
+		if (value > alignment)
+		{
+			alignment = value;
+			best = (int)face;
+		}
+	}
+	return best;
+}
+
+// the corners of the face facing direction, a segment lying across it or the vertex furthest along it
+static unsigned int getIncident(const Polytope& polytope, const Vector3D& direction, Vector3D* points)
+{
+	float alignment;
+	int face = findFace(polytope, direction, alignment);
+	if (face >= 0)
+	{
+		const PhysicsFace& info = polytope.m_faces[face];
+		for (unsigned int corner = 0; corner < info.m_count; corner++)
+			points[corner] = polytope.m_vertices[polytope.m_face_vertices[info.m_first + corner]];
+		return info.m_count;
+	}
+	if (polytope.m_vertex_count == 2)
+	{
+		Vector3D segment = normalize(polytope.m_vertices[1] - polytope.m_vertices[0]);
+		if (fabsf(Vector3D::dot(segment, direction)) < 1.0f - FACE_ALIGNMENT)
+		{
+			points[0] = polytope.m_vertices[0];
+			points[1] = polytope.m_vertices[1];
+			return 2;
+		}
+	}
+	points[0] = polytope.m_vertices[findSupport(polytope, direction)];
+	return 1;
+}
+
+// the part of a polygon, a segment or a point on the inner side of the plane
+static unsigned int clipPlane(const Vector3D* in, unsigned int count, const Vector3D& normal, float distance, Vector3D* out)
+{
+	if (count == 1)
+	{
+		if (Vector3D::dot(normal, in[0]) > distance)
+			return 0;
+		out[0] = in[0];
+		return 1;
+	}
+	if (count == 2)
+	{
+		float da = Vector3D::dot(normal, in[0]) - distance;
+		float db = Vector3D::dot(normal, in[1]) - distance;
+		if (da > 0.0f && db > 0.0f)
+			return 0;
+		out[0] = da > 0.0f ? Vector3D::lerp(in[0], in[1], da / (da - db)) : in[0];
+		out[1] = db > 0.0f ? Vector3D::lerp(in[0], in[1], da / (da - db)) : in[1];
+		return 2;
+	}
+
+	unsigned int size = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const Vector3D& a = in[i];
+		const Vector3D& b = in[(i + 1) % count];
+		float da = Vector3D::dot(normal, a) - distance;
+		float db = Vector3D::dot(normal, b) - distance;
+		if (da <= 0.0f)
+			out[size++] = a;
+		if ((da <= 0.0f) != (db <= 0.0f))
+			out[size++] = Vector3D::lerp(a, b, da / (da - db));
+	}
+	return size;
+}
+
+// the deepest point, the one furthest from it, then the ones that add the most area
+static void addPoints(ContactManifold& manifold, const Vector3D* points, const float* depths, unsigned int count)
+{
+	unsigned int chosen[ContactManifold::MAX_POINTS];
+	unsigned int chosen_count = 0;
+	if (count <= ContactManifold::MAX_POINTS)
+	{
+		for (unsigned int i = 0; i < count; i++)
+			chosen[chosen_count++] = i;
+	}
+	else
+	{
+		unsigned int best = 0;
+		for (unsigned int i = 1; i < count; i++)
+		{
+			if (depths[i] > depths[best])
+				best = i;
+		}
+		chosen[chosen_count++] = best;
+
+		float best_value = -1.0f;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			Vector3D offset = points[i] - points[chosen[0]];
+			float value = Vector3D::dot(offset, offset);
+			if (value > best_value)
+			{
+				best_value = value;
+				best = i;
+			}
+		}
+		chosen[chosen_count++] = best;
+
+		const Vector3D& normal = manifold.m_normal;
+		Vector3D p0 = points[chosen[0]], p1 = points[chosen[1]];
+		best_value = -1.0f;
+		float side = 1.0f;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			float area = Vector3D::dot(Vector3D::cross(p1 - p0, points[i] - p0), normal);
+			if (fabsf(area) > best_value)
+			{
+				best_value = fabsf(area);
+				best = i;
+				side = area < 0.0f ? -1.0f : 1.0f;
+			}
+		}
+		chosen[chosen_count++] = best;
+
+		// outside the triangle, furthest from its nearest edge
+		Vector3D p2 = points[chosen[2]];
+		Vector3D corners[3] = { p0, p1, p2 };
+		best_value = 0.0f;
+		best = ~0u;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			float outside = 0.0f;
+			for (int edge = 0; edge < 3; edge++)
+			{
+				float area = -side * Vector3D::dot(Vector3D::cross(corners[(edge + 1) % 3] - corners[edge], points[i] - corners[edge]), normal);
+				outside = std::max(outside, area);
+			}
+			if (outside > best_value)
+			{
+				best_value = outside;
+				best = i;
+			}
+		}
+		if (best != ~0u)
+			chosen[chosen_count++] = best;
+	}
+
+	for (unsigned int i = 0; i < chosen_count; i++)
+	{
+		manifold.m_points[i] = points[chosen[i]];
+		manifold.m_depths[i] = depths[chosen[i]];
+	}
+	manifold.m_count = chosen_count;
+}
+
+
+/*
+	- the incident feature of the other shape clipped to the side planes of a reference face. flip: the reference face
+	  belongs to b, the normal of the manifold is the opposite of the face normal
+*/
+
+static void clipToFace(const Polytope& reference, unsigned int face, const Polytope& incident, bool flip, ContactManifold& manifold)
+{
+	const Vector3D& normal = reference.m_normals[face];
+	float distance = reference.m_distances[face];
+	const PhysicsFace& info = reference.m_faces[face];
+
+	Vector3D buffers[2][MAX_CLIP_POINTS];
+	unsigned int count = getIncident(incident, normal * -1.0f, buffers[0]);
+	unsigned int current = 0;
+	for (unsigned int corner = 0; corner < info.m_count && count; corner++)
+	{
+		const Vector3D& a = reference.m_vertices[reference.m_face_vertices[info.m_first + corner]];
+		const Vector3D& b = reference.m_vertices[reference.m_face_vertices[info.m_first + (corner + 1) % info.m_count]];
+		Vector3D side = normalize(Vector3D::cross(b - a, normal));
+		count = clipPlane(buffers[current], count, side, Vector3D::dot(side, a), buffers[1 - current]);
+		current = 1 - current;
+	}
+
+	Vector3D points[MAX_CLIP_POINTS];
+	float depths[MAX_CLIP_POINTS];
+	unsigned int kept = 0;
+	float radius = reference.m_radius + incident.m_radius;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const Vector3D& point = buffers[current][i];
+		float core_separation = Vector3D::dot(normal, point) - distance;
+		float separation = core_separation - radius;
+		if (separation > PhysicsContacts::CONTACT_MARGIN)
+			continue;
+		Vector3D on_reference = point - normal * (core_separation - reference.m_radius);
+		Vector3D on_incident = point - normal * incident.m_radius;
+		points[kept] = (on_reference + on_incident) * 0.5f;
+		depths[kept] = -separation;
+		kept++;
+	}
+
+	manifold.m_normal = flip ? normal * -1.0f : normal;
+	addPoints(manifold, points, depths, kept);
+}
+
+// two segments lying on each other: b clipped to the ends of a
+static void clipSegments(const Polytope& a, const Polytope& b, const Vector3D& normal, ContactManifold& manifold)
+{
+	Vector3D a0 = a.m_vertices[0], a1 = a.m_vertices[1];
+	Vector3D axis = normalize(a1 - a0);
+	Vector3D clipped[2][2] = { { b.m_vertices[0], b.m_vertices[1] } };
+	unsigned int count = clipPlane(clipped[0], 2, axis * -1.0f, -Vector3D::dot(axis, a0), clipped[1]);
+	if (count)
+		count = clipPlane(clipped[1], 2, axis, Vector3D::dot(axis, a1), clipped[0]);
+
+	Vector3D points[2];
+	float depths[2];
+	unsigned int kept = 0;
+	float length = (a1 - a0).length();
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const Vector3D& point = clipped[0][i];
+		Vector3D on_a = a0 + axis * std::min(std::max(Vector3D::dot(point - a0, axis), 0.0f), length);
+		float separation = Vector3D::dot(point - on_a, normal) - a.m_radius - b.m_radius;
+		if (separation > PhysicsContacts::CONTACT_MARGIN)
+			continue;
+		points[kept] = ((on_a + normal * a.m_radius) + (point - normal * b.m_radius)) * 0.5f;
+		depths[kept] = -separation;
+		kept++;
+	}
+	manifold.m_normal = normal;
+	addPoints(manifold, points, depths, kept);
+}
+
+// closest points of the segments p0 - p1 and q0 - q1
+static void closestSegmentPoints(const Vector3D& p0, const Vector3D& p1, const Vector3D& q0, const Vector3D& q1, Vector3D& on_p, Vector3D& on_q)
+{
+	Vector3D d1 = p1 - p0, d2 = q1 - q0, r = p0 - q0;
+	float a = Vector3D::dot(d1, d1), e = Vector3D::dot(d2, d2), f = Vector3D::dot(d2, r);
+	float c = Vector3D::dot(d1, r), b = Vector3D::dot(d1, d2);
+	float denominator = a * e - b * b;
+	float s = denominator > 1e-12f ? std::min(std::max((b * f - c * e) / denominator, 0.0f), 1.0f) : 0.0f;
+	float t = e > 1e-12f ? (b * s + f) / e : 0.0f;
+	if (t < 0.0f || t > 1.0f)
+	{
+		t = std::min(std::max(t, 0.0f), 1.0f);
+		s = a > 1e-12f ? std::min(std::max((b * t - c) / a, 0.0f), 1.0f) : 0.0f;
+	}
+	on_p = p0 + d1 * s;
+	on_q = q0 + d2 * t;
+}
+
+static void addPoint(ContactManifold& manifold, const Vector3D& core_a, float radius_a, const Vector3D& core_b, float radius_b)
+{
+	const Vector3D& normal = manifold.m_normal;
+	float separation = Vector3D::dot(core_b - core_a, normal) - radius_a - radius_b;
+	manifold.m_points[0] = ((core_a + normal * radius_a) + (core_b - normal * radius_b)) * 0.5f;
+	manifold.m_depths[0] = -separation;
+	manifold.m_count = 1;
+}
+
+
+static bool collidePolytopes(const Polytope& a, const Polytope& b, ContactManifold& manifold)
+{
+	manifold.m_count = 0;
+	float radius = a.m_radius + b.m_radius;
+	float limit = radius + PhysicsContacts::CONTACT_MARGIN;
+
+	Vector3D point_a, point_b;
+	if (radius > 0.0f && findClosestPoints(a, b, point_a, point_b))
+	{
+		Vector3D offset = point_b - point_a;
+		float distance = offset.length();
+		if (distance > limit)
+			return false;
+		if (distance > 1e-5f)
+		{
+			Vector3D normal = offset * (1.0f / distance);
+			float alignment_a, alignment_b;
+			int face_a = findFace(a, normal, alignment_a);
+			int face_b = findFace(b, normal * -1.0f, alignment_b);
+			if (face_a >= 0 && alignment_a >= FACE_ALIGNMENT && (face_b < 0 || alignment_a >= alignment_b))
+				clipToFace(a, face_a, b, false, manifold);
+			else if (face_b >= 0 && alignment_b >= FACE_ALIGNMENT)
+				clipToFace(b, face_b, a, true, manifold);
+			else if (a.m_vertex_count == 2 && b.m_vertex_count == 2 && !a.m_face_count && !b.m_face_count &&
+				fabsf(Vector3D::dot(normalize(a.m_vertices[1] - a.m_vertices[0]), normal)) < 1.0f - FACE_ALIGNMENT &&
+				fabsf(Vector3D::dot(normalize(b.m_vertices[1] - b.m_vertices[0]), normal)) < 1.0f - FACE_ALIGNMENT)
+				clipSegments(a, b, normal, manifold);
+
+			if (!manifold.m_count)
+			{
+				manifold.m_normal = normal;
+				addPoint(manifold, point_a, a.m_radius, point_b, b.m_radius);
+			}
+			return true;
+		}
+	}
+
+	// overlapping cores, or two polyhedra
+	SeparatingAxis axis;
+	if (!findAxis(a, b, limit, axis))
+		return false;
+
+	if (axis.m_type == AxisType::FaceA)
+		clipToFace(a, axis.m_a, b, false, manifold);
+	else if (axis.m_type == AxisType::FaceB)
+		clipToFace(b, axis.m_b, a, true, manifold);
+	else if (axis.m_type == AxisType::Edges)
+	{
+		// the edges of the two directions furthest toward each other
+		const Vector3D& normal = axis.m_normal;
+		float best_a = -FLT_MAX, best_b = -FLT_MAX;
+		Vector3D a0, a1, b0, b1;
+		for (unsigned int i = 0; i < a.m_edge_count; i++)
+		{
+			const PhysicsEdge& edge = a.m_edges[i];
+			float value = Vector3D::dot(a.m_vertices[edge.m_a] + a.m_vertices[edge.m_b], normal);
+			if (edge.m_direction == axis.m_a && value > best_a)
+			{
+				best_a = value;
+				a0 = a.m_vertices[edge.m_a];
+				a1 = a.m_vertices[edge.m_b];
+			}
+		}
+		for (unsigned int i = 0; i < b.m_edge_count; i++)
+		{
+			const PhysicsEdge& edge = b.m_edges[i];
+			float value = -Vector3D::dot(b.m_vertices[edge.m_a] + b.m_vertices[edge.m_b], normal);
+			if (edge.m_direction == axis.m_b && value > best_b)
+			{
+				best_b = value;
+				b0 = b.m_vertices[edge.m_a];
+				b1 = b.m_vertices[edge.m_b];
+			}
+		}
+		closestSegmentPoints(a0, a1, b0, b1, point_a, point_b);
+		manifold.m_normal = normal;
+		addPoint(manifold, point_a, a.m_radius, point_b, b.m_radius);
+	}
+	else
+	{
+		// points or segments on top of each other: any direction
+		Vector3D offset = b.m_center - a.m_center;
+		manifold.m_normal = offset.length() > 1e-6f ? normalize(offset) : Vector3D(0.0f, 1.0f, 0.0f);
+		addPoint(manifold, a.m_center, a.m_radius, b.m_center, b.m_radius);
+	}
+
+	// everything clipped away: the deepest points along the axis
+	if (!manifold.m_count)
+	{
+		addPoint(manifold, a.m_vertices[findSupport(a, manifold.m_normal)], a.m_radius, b.m_vertices[findSupport(b, manifold.m_normal * -1.0f)], b.m_radius);
+	}
+	return true;
+}
+
+
+static void setAnchors(const PhysicsPose& pose, ContactManifold& manifold)
+{
+	for (unsigned int i = 0; i < manifold.m_count; i++)
+		manifold.m_anchors[i] = rotateInverse(pose.m_rotation, manifold.m_points[i] - pose.m_position);
+}
+
+
+bool PhysicsContacts::collide(const PhysicsShape& a, const PhysicsPose& pose_a, const PhysicsShape& b, const PhysicsPose& pose_b, ContactManifold& manifold)
+{
+	Polytope polytope_a, polytope_b;
+	makePolytope(a, pose_a, polytope_a);
+	makePolytope(b, pose_b, polytope_b);
+	if (!collidePolytopes(polytope_a, polytope_b, manifold))
+		return false;
+	setAnchors(pose_a, manifold);
+	return true;
+}
+
+
+void PhysicsContacts::collideMesh(const PhysicsShape& a, const PhysicsPose& pose_a, const PhysicsShape& b, const PhysicsPose& pose_b,
+	unsigned int body_a, unsigned int body_b, std::vector<ContactManifold>& manifolds)
+{
+	const CollisionMesh* mesh = b.getMesh();
+	if (!mesh)
+		return;
+
+	// the world box of a in the space of the mesh
+	Vector3D world_min, world_max;
+	a.getBounds(pose_a.m_rotation, pose_a.m_position, world_min, world_max);
+	Vector3D margin(CONTACT_MARGIN, CONTACT_MARGIN, CONTACT_MARGIN);
+	world_min = world_min - margin;
+	world_max = world_max + margin;
+	Vector3D min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (int corner = 0; corner < 8; corner++)
+	{
+		Vector3D world((corner & 1) ? world_max.m_x : world_min.m_x, (corner & 2) ? world_max.m_y : world_min.m_y, (corner & 4) ? world_max.m_z : world_min.m_z);
+		Vector3D local = rotateInverse(pose_b.m_rotation, world - pose_b.m_position);
+		min = Vector3D(std::min(min.m_x, local.m_x), std::min(min.m_y, local.m_y), std::min(min.m_z, local.m_z));
+		max = Vector3D(std::max(max.m_x, local.m_x), std::max(max.m_y, local.m_y), std::max(max.m_z, local.m_z));
+	}
+
+	Polytope polytope_a, triangle;
+	makePolytope(a, pose_a, polytope_a);
+	mesh->getBVH().query(min, max, [&](unsigned int slot)
+		{
+			if (!makeTriangle(mesh->getTriangle(slot), pose_b, triangle))
+				return;
+			ContactManifold manifold;
+			if (!collidePolytopes(polytope_a, triangle, manifold))
+				return;
+			manifold.m_a = body_a;
+			manifold.m_b = body_b;
+			manifold.m_feature = slot;
+			setAnchors(pose_a, manifold);
+			manifolds.push_back(manifold);
+		});
+}
@@ -0,0 +1,79 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "PhysicsShape.h"
+#include <vector>
+
+// where a body is: the rows of its rotation (world = rotation * local) and the position of its center of mass
+struct PhysicsPose
+{
+	float m_rotation[9];
+	Vector3D m_position;
+};
+
+// up to MAX_POINTS points where two bodies touch, with the impulses the solver applied at them
+struct ContactManifold
+{
+	static const unsigned int MAX_POINTS = 4;
+
+	unsigned int m_a = 0;
+	unsigned int m_b = 0;
+	unsigned int m_feature = ~0u;					// triangle slot when b is a mesh
+	Vector3D m_normal;								// unit length, from a to b
+	unsigned int m_count = 0;
+	Vector3D m_points[MAX_POINTS];					// world, halfway between the two surfaces
+	float m_depths[MAX_POINTS] = {};				// penetration, negative for a gap below CONTACT_MARGIN
+	Vector3D m_anchors[MAX_POINTS];					// the points in the frame of a: the same points in the next step
+	float m_normal_impulses[MAX_POINTS] = {};
+	float m_tangent_impulses[MAX_POINTS][2] = {};
+};
+
+
+/*
+	PhysicsContacts: the contact points of two shapes
+
+	- rounded shapes (a radius): the closest points of the cores (GJK) give the normal while the cores do not overlap
+	- polyhedra and overlapping cores: the separating axis with the least overlap among the faces of both and the
+	  cross products of their edge directions. Face axes win ties, they give stable manifolds
+	- a face axis: the incident feature of the other shape (face, segment or point) clipped to the sides of the
+	  reference face, the points deepest and spread the most kept. An edge axis: the closest points of the two edges
+	- contacts start CONTACT_MARGIN before the shapes touch -> a resting body keeps its contacts from step to step
+*/
+
+class PhysicsContacts
+{
+public:
+
+	static constexpr float CONTACT_MARGIN = 0.02f;
+
+	// two convex shapes. False when they are further apart than CONTACT_MARGIN
+	static bool collide(const PhysicsShape& a, const PhysicsPose& pose_a, const PhysicsShape& b, const PhysicsPose& pose_b, ContactManifold& manifold);
+
+	// a convex shape against the triangles of a mesh shape its box touches: a manifold per triangle with m_a = body_a
+	static void collideMesh(const PhysicsShape& a, const PhysicsPose& pose_a, const PhysicsShape& b, const PhysicsPose& pose_b,
+		unsigned int body_a, unsigned int body_b, std::vector<ContactManifold>& manifolds);
+};
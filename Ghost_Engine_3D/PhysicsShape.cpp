@@ -0,0 +1,366 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "PhysicsShape.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <exception>
+
+
+void PhysicsShape::clear(PhysicsShapeType type, float radius)
+{
+	m_type = type;
+	m_radius = radius;
+	m_vertices.clear();
+	m_faces.clear();
+	m_face_vertices.clear();
+	m_edges.clear();
+	m_edge_directions.clear();
+	m_mesh = nullptr;
+}
+
+
+void PhysicsShape::setSphere(float radius)
+{
+	clear(PhysicsShapeType::Sphere, radius);
+	m_vertices.push_back(Vector3D(0.0f, 0.0f, 0.0f));
+	float inertia = 0.4f * radius * radius;
+	m_inertia = Vector3D(inertia, inertia, inertia);
+}
+
+
+/*
+	- inertia of a cylinder and two half spheres, their mass shared by volume
+*/
+
+void PhysicsShape::setCapsule(float radius, float half_height)
+{
+	clear(PhysicsShapeType::Capsule, radius);
+	m_vertices.push_back(Vector3D(0.0f, -half_height, 0.0f));
+	m_vertices.push_back(Vector3D(0.0f, half_height, 0.0f));
+	addEdges();
+
+	float length = half_height * 2.0f;
+	float cylinder = radius * radius * length;
+	float spheres = radius * radius * radius * 4.0f / 3.0f;
+	float cylinder_mass = cylinder / (cylinder + spheres);
+	float sphere_mass = 1.0f - cylinder_mass;
+	float axial = cylinder_mass * radius * radius * 0.5f + sphere_mass * radius * radius * 0.4f;
+	float side = cylinder_mass * (length * length / 12.0f + radius * radius * 0.25f) +
+		sphere_mass * (radius * radius * 0.4f + length * length * 0.25f + length * radius * 0.375f);
+	m_inertia = Vector3D(side, axial, side);
+}
+
+
+void PhysicsShape::setBox(const Vector3D& half_extents)
+{
+	std::vector<Vector3D> corners;
+	for (int corner = 0; corner < 8; corner++)
+	{
+		corners.push_back(Vector3D((corner & 1) ? half_extents.m_x : -half_extents.m_x, (corner & 2) ? half_extents.m_y : -half_extents.m_y,
+			(corner & 4) ? half_extents.m_z : -half_extents.m_z));
+	}
+	setHull(corners);
+	m_type = PhysicsShapeType::Box;
+}
+
+
+/*
+	- every plane through three points with all points on one side is a face. Brute force, fine for MAX_HULL_VERTICES
+	  points at load time
+	- the corners of a face sorted by their angle around its center, points in the middle of an edge dropped
+*/
+
+bool PhysicsShape::setHull(const std::vector<Vector3D>& source)
+{
+	if (source.size() > MAX_HULL_VERTICES)
+		throw std::exception("PhysicsShape: too many hull points");
+
+	clear(PhysicsShapeType::Hull, 0.0f);
+
+	Vector3D center;
+	Vector3D min(FLT_MAX, FLT_MAX, FLT_MAX), max(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (const Vector3D& point : source)
+	{
+		center = center + point;
+		min = Vector3D(std::min(min.m_x, point.m_x), std::min(min.m_y, point.m_y), std::min(min.m_z, point.m_z));
+		max = Vector3D(std::max(max.m_x, point.m_x), std::max(max.m_y, point.m_y), std::max(max.m_z, point.m_z));
+	}
+	if (source.size() < 4)
+		return false;
+	center = center * (1.0f / source.size());
+	float epsilon = (max - min).length() * 1e-4f;
+
+	std::vector<Vector3D> points;
+	for (const Vector3D& point : source)
+	{
+		Vector3D local = point - center;
+		bool duplicate = false;
+		for (const Vector3D& other : points)
+			duplicate |= (other - local).length() <= epsilon;
+		if (!duplicate)
+			points.push_back(local);
+	}
+
+	unsigned int count = (unsigned int)points.size();
+	std::vector<unsigned int> corners;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		for (unsigned int j = i + 1; j < count; j++)
+		{
+			for (unsigned int k = j + 1; k < count; k++)
+			{
+				Vector3D normal = Vector3D::cross(points[j] - points[i], points[k] - points[i]);
+				float length = normal.length();
+				if (length <= epsilon * epsilon)
+					continue;
+				normal = normal * (1.0f / length);
+				float distance = Vector3D::dot(normal, points[i]);
+
+				bool above = false, below = false;
+				for (const Vector3D& point : points)
+				{
+					float side = Vector3D::dot(normal, point) - distance;
+					above |= side > epsilon;
+					below |= side < -epsilon;
+				}
+				if (above && below)
+					continue;
+				if (!above && !below)
+					return false;
+				if (above)
+				{
+					normal = normal * -1.0f;
+					distance = -distance;
+				}
+
+				bool known = false;
+				for (const PhysicsFace& face : m_faces)
+					known |= Vector3D::dot(face.m_normal, normal) > 1.0f - 1e-4f && fabsf(face.m_distance - distance) <= epsilon;
+				if (known)
+					continue;
+
+				// corners on the plane, counter clockwise around the normal
+				corners.clear();
+				Vector3D face_center;
+				for (unsigned int point = 0; point < count; point++)
+				{
+					if (fabsf(Vector3D::dot(normal, points[point]) - distance) <= epsilon)
+					{
+						corners.push_back(point);
+						face_center = face_center + points[point];
+					}
+				}
+				face_center = face_center * (1.0f / corners.size());
+				Vector3D u = points[corners[0]] - face_center;
+				u = u * (1.0f / std::max(u.length(), FLT_MIN));
+				Vector3D v = Vector3D::cross(normal, u);
+				std::sort(corners.begin(), corners.end(), [&](unsigned int a, unsigned int b)
+					{
+						Vector3D da = points[a] - face_center, db = points[b] - face_center;
+						return atan2f(Vector3D::dot(da, v), Vector3D::dot(da, u)) < atan2f(Vector3D::dot(db, v), Vector3D::dot(db, u));
+					});
+				for (size_t corner = 0; corner < corners.size() && corners.size() > 3;)
+				{
+					const Vector3D& previous = points[corners[(corner + corners.size() - 1) % corners.size()]];
+					const Vector3D& next = points[corners[(corner + 1) % corners.size()]];
+					Vector3D edge = next - previous;
+					Vector3D offset = points[corners[corner]] - previous;
+					if (Vector3D::cross(edge, offset).length() <= epsilon * edge.length())
+						corners.erase(corners.begin() + corner);
+					else
+						corner++;
+				}
+
+				PhysicsFace face;
+				face.m_normal = normal;
+				face.m_distance = distance;
+				face.m_first = (unsigned int)m_face_vertices.size();
+				face.m_count = (unsigned int)corners.size();
+				m_faces.push_back(face);
+				m_face_vertices.insert(m_face_vertices.end(), corners.begin(), corners.end());
+			}
+		}
+	}
+
+	// only the corners of faces stay
+	std::vector<unsigned int> remap(count, ~0u);
+	for (unsigned int& index : m_face_vertices)
+	{
+		if (remap[index] == ~0u)
+		{
+			remap[index] = (unsigned int)m_vertices.size();
+			m_vertices.push_back(points[index]);
+		}
+		index = remap[index];
+	}
+	addEdges();
+
+	Vector3D size = max - min;
+	m_inertia = Vector3D(size.m_y * size.m_y + size.m_z * size.m_z, size.m_x * size.m_x + size.m_z * size.m_z, size.m_x * size.m_x + size.m_y * size.m_y) * (1.0f / 12.0f);
+	return true;
+}
+
+
+// from the face loops of a polyhedron, or the segment of a capsule
+void PhysicsShape::addEdges()
+{
+	std::vector<std::pair<unsigned int, unsigned int>> pairs;
+	if (m_faces.empty() && m_vertices.size() == 2)
+		pairs.push_back(std::make_pair(0u, 1u));
+	for (const PhysicsFace& face : m_faces)
+	{
+		for (unsigned int corner = 0; corner < face.m_count; corner++)
+		{
+			unsigned int a = m_face_vertices[face.m_first + corner];
+			unsigned int b = m_face_vertices[face.m_first + (corner + 1) % face.m_count];
+			pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+		}
+	}
+	std::sort(pairs.begin(), pairs.end());
+	pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+	for (const std::pair<unsigned int, unsigned int>& pair : pairs)
+	{
+		Vector3D direction = m_vertices[pair.second] - m_vertices[pair.first];
+		direction = direction * (1.0f / std::max(direction.length(), FLT_MIN));
+
+		PhysicsEdge edge;
+		edge.m_a = pair.first;
+		edge.m_b = pair.second;
+		edge.m_direction = (unsigned int)m_edge_directions.size();
+		for (unsigned int known = 0; known < m_edge_directions.size(); known++)
+		{
+			if (fabsf(Vector3D::dot(m_edge_directions[known], direction)) > 1.0f - 1e-4f)
+				edge.m_direction = known;
+		}
+		if (edge.m_direction == m_edge_directions.size())
+			m_edge_directions.push_back(direction);
+		m_edges.push_back(edge);
+	}
+}
+
+
+void PhysicsShape::setMesh(const CollisionMesh* mesh)
+{
+	clear(PhysicsShapeType::Mesh, 0.0f);
+	m_mesh = mesh;
+	m_inertia = Vector3D(0.0f, 0.0f, 0.0f);
+}
+
+
+PhysicsShapeType PhysicsShape::getType() const
+{
+	return m_type;
+}
+
+
+bool PhysicsShape::isConvex() const
+{
+	return m_type != PhysicsShapeType::Mesh;
+}
+
+
+float PhysicsShape::getRadius() const
+{
+	return m_radius;
+}
+
+
+const Vector3D& PhysicsShape::getInertia() const
+{
+	return m_inertia;
+}
+
+
+const std::vector<Vector3D>& PhysicsShape::getVertices() const
+{
+	return m_vertices;
+}
+
+
+const std::vector<PhysicsFace>& PhysicsShape::getFaces() const
+{
+	return m_faces;
+}
+
+
+const std::vector<unsigned int>& PhysicsShape::getFaceVertices() const
+{
+	return m_face_vertices;
+}
+
+
+const std::vector<PhysicsEdge>& PhysicsShape::getEdges() const
+{
+	return m_edges;
+}
+
+
+const std::vector<Vector3D>& PhysicsShape::getEdgeDirections() const
+{
+	return m_edge_directions;
+}
+
+
+const CollisionMesh* PhysicsShape::getMesh() const
+{
+	return m_mesh;
+}
+
+
+void PhysicsShape::getBounds(const float rotation[9], const Vector3D& position, Vector3D& min, Vector3D& max) const
+{
+	Vector3D local_min, local_max;
+	const Vector3D* corners = m_vertices.data();
+	unsigned int count = (unsigned int)m_vertices.size();
+	Vector3D box[8];
+	if (m_mesh)
+	{
+		m_mesh->getBoundingBox(local_min, local_max);
+		for (int corner = 0; corner < 8; corner++)
+			box[corner] = Vector3D((corner & 1) ? local_max.m_x : local_min.m_x, (corner & 2) ? local_max.m_y : local_min.m_y, (corner & 4) ? local_max.m_z : local_min.m_z);
+		corners = box;
+		count = 8;
+	}
+
+	min = Vector3D(FLT_MAX, FLT_MAX, FLT_MAX);
+	max = Vector3D(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		const Vector3D& p = corners[i];
+		float x = rotation[0] * p.m_x + rotation[1] * p.m_y + rotation[2] * p.m_z;
+		float y = rotation[3] * p.m_x + rotation[4] * p.m_y + rotation[5] * p.m_z;
+		float z = rotation[6] * p.m_x + rotation[7] * p.m_y + rotation[8] * p.m_z;
+		min = Vector3D(std::min(min.m_x, x), std::min(min.m_y, y), std::min(min.m_z, z));
+		max = Vector3D(std::max(max.m_x, x), std::max(max.m_y, y), std::max(max.m_z, z));
+	}
+	Vector3D radius(m_radius, m_radius, m_radius);
+	min = min + position - radius;
+	max = max + position + radius;
+}
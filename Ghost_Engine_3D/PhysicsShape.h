@@ -0,0 +1,117 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "CollisionMesh.h"
+#include "Vector3D.h"
+#include <vector>
+
+enum class PhysicsShapeType
+{
+	Sphere,
+	Capsule,
+	Box,
+	Hull,
+	Mesh
+};
+
+// a face of a polyhedron: its plane (normal * x = distance) and its corners, counter clockwise seen from outside
+struct PhysicsFace
+{
+	Vector3D m_normal;
+	float m_distance;
+	unsigned int m_first;		// in getFaceVertices()
+	unsigned int m_count;
+};
+
+// m_direction: index in getEdgeDirections(), parallel edges share one
+struct PhysicsEdge
+{
+	unsigned int m_a;
+	unsigned int m_b;
+	unsigned int m_direction;
+};
+
+
+/*
+	PhysicsShape: the collision shape of rigid bodies, shared by any number of them
+
+	- a convex shape is a core grown by a radius: a sphere is a point, a capsule a segment on the y axis, a box or a
+	  hull a polyhedron with radius 0 -> PhysicsContacts has one routine for every pair of shapes
+	- polyhedra keep their faces and the unique directions of their edges for the separating axis test, and the corners
+	  of their faces for the clipping of contact points
+	- hull: the convex hull of at most MAX_HULL_VERTICES points, moved so their mean is the origin (the center of mass
+	  of the body). Its inertia is the one of its bounding box
+	- mesh: the triangles of a CollisionMesh, for static bodies only
+	- getInertia() is per unit of mass, on the axes of the shape
+*/
+
+class PhysicsShape
+{
+public:
+
+	static const unsigned int MAX_HULL_VERTICES = 64;
+
+	void setSphere(float radius);
+	// half_height: from the center to the center of a cap
+	void setCapsule(float radius, float half_height);
+	void setBox(const Vector3D& half_extents);
+	// false when the points do not span a volume
+	bool setHull(const std::vector<Vector3D>& points);
+	// the mesh stays owned by the caller and must outlive the shape
+	void setMesh(const CollisionMesh* mesh);
+
+	PhysicsShapeType getType() const;
+	bool isConvex() const;
+	float getRadius() const;
+	const Vector3D& getInertia() const;
+	const std::vector<Vector3D>& getVertices() const;
+	const std::vector<PhysicsFace>& getFaces() const;
+	const std::vector<unsigned int>& getFaceVertices() const;
+	const std::vector<PhysicsEdge>& getEdges() const;
+	const std::vector<Vector3D>& getEdgeDirections() const;
+	const CollisionMesh* getMesh() const;
+
+	// world box of the shape. rotation: rows of the matrix from the shape to the world, world = rotation * local
+	void getBounds(const float rotation[9], const Vector3D& position, Vector3D& min, Vector3D& max) const;
+
+private:
+
+	void clear(PhysicsShapeType type, float radius);
+	void addEdges();
+
+private:
+
+	PhysicsShapeType m_type = PhysicsShapeType::Sphere;
+	float m_radius = 0.0f;
+	Vector3D m_inertia;
+	std::vector<Vector3D> m_vertices;		// of the core
+	std::vector<PhysicsFace> m_faces;
+	std::vector<unsigned int> m_face_vertices;
+	std::vector<PhysicsEdge> m_edges;
+	std::vector<Vector3D> m_edge_directions;
+	const CollisionMesh* m_mesh = nullptr;
+};
@@ -0,0 +1,820 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "PhysicsWorld.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <exception>
+
+
+// part of the penetration removed per step, and the penetration left alone so resting contacts do not jitter
+static const float BAUMGARTE = 0.2f;
+static const float PENETRATION_SLOP = 0.005f;
+static const float MAX_PUSH_VELOCITY = 4.0f;
+// a point of the last step within this distance in the frame of body a is the same point
+static const float MATCH_DISTANCE = 0.05f;
+static const float ANGULAR_DAMPING = 0.05f;
+
+static Vector3D multiply(const float* rows, const Vector3D& v)
+{
+	return Vector3D(rows[0] * v.m_x + rows[1] * v.m_y + rows[2] * v.m_z, rows[3] * v.m_x + rows[4] * v.m_y + rows[5] * v.m_z,
+		rows[6] * v.m_x + rows[7] * v.m_y + rows[8] * v.m_z);
+}
+
+
+/*
+	- job(begin, end, items) for chunks of [0, count) on all threads, the items of the chunks appended in chunk order
+*/
+
+template <class T, class Job>
+static void collectChunks(unsigned int count, std::vector<std::vector<T>>& chunk_items, std::vector<T>& items, Job job)
+{
+	if (!count)
+		return;
+
+	unsigned int jobs = JobSystem::get()->getThreadCount() * 8;
+	unsigned int group = std::max((count + jobs - 1) / jobs, 1u);
+	unsigned int chunks = (count + group - 1) / group;
+	if (chunk_items.size() < chunks)
+		chunk_items.resize(chunks);
+
+	JobSystem::get()->parallelFor(count, group, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<T>& chunk = chunk_items[begin / group];
+			chunk.clear();
+			job(begin, end, chunk);
+		});
+
+	for (unsigned int chunk = 0; chunk < chunks; chunk++)
+		items.insert(items.end(), chunk_items[chunk].begin(), chunk_items[chunk].end());
+}
+
+
+// a world is mostly a grid of small bodies: the hash tests cells instead of a whole slab of the sweep axis
+PhysicsWorld::PhysicsWorld()
+{
+	m_broadphase.setMethod(BroadphaseMethod::SpatialHash);
+}
+
+
+unsigned int PhysicsWorld::addShape(const PhysicsShape& shape)
+{
+	m_shapes.push_back(shape);
+	return (unsigned int)m_shapes.size() - 1;
+}
+
+
+unsigned int PhysicsWorld::createSphereShape(float radius)
+{
+	PhysicsShape shape;
+	shape.setSphere(radius);
+	return addShape(shape);
+}
+
+
+unsigned int PhysicsWorld::createCapsuleShape(float radius, float half_height)
+{
+	PhysicsShape shape;
+	shape.setCapsule(radius, half_height);
+	return addShape(shape);
+}
+
+
+unsigned int PhysicsWorld::createBoxShape(const Vector3D& half_extents)
+{
+	PhysicsShape shape;
+	shape.setBox(half_extents);
+	return addShape(shape);
+}
+
+
+unsigned int PhysicsWorld::createHullShape(const std::vector<Vector3D>& points)
+{
+	PhysicsShape shape;
+	if (!shape.setHull(points))
+		throw std::exception("PhysicsWorld: the hull points do not span a volume");
+	return addShape(shape);
+}
+
+
+unsigned int PhysicsWorld::createMeshShape(const CollisionMesh* mesh)
+{
+	PhysicsShape shape;
+	shape.setMesh(mesh);
+	return addShape(shape);
+}
+
+
+unsigned int PhysicsWorld::createBody(unsigned int shape, const Vector3D& position, const Vector4D& rotation, float mass)
+{
+	if (shape >= m_shapes.size())
+		throw std::exception("PhysicsWorld: unknown shape");
+	const PhysicsShape& body_shape = m_shapes[shape];
+	if (!body_shape.isConvex())
+		mass = 0.0f;
+
+	unsigned int body = (unsigned int)m_position_x.size();
+	float length = sqrtf(rotation.m_x * rotation.m_x + rotation.m_y * rotation.m_y + rotation.m_z * rotation.m_z + rotation.m_s * rotation.m_s);
+	float scale = length > 0.0f ? 1.0f / length : 0.0f;
+	m_position_x.push_back(position.m_x);
+	m_position_y.push_back(position.m_y);
+	m_position_z.push_back(position.m_z);
+	m_rotation_x.push_back(length > 0.0f ? rotation.m_x * scale : 0.0f);
+	m_rotation_y.push_back(rotation.m_y * scale);
+	m_rotation_z.push_back(rotation.m_z * scale);
+	m_rotation_s.push_back(length > 0.0f ? rotation.m_s * scale : 1.0f);
+	m_velocity_x.push_back(0.0f);
+	m_velocity_y.push_back(0.0f);
+	m_velocity_z.push_back(0.0f);
+	m_angular_x.push_back(0.0f);
+	m_angular_y.push_back(0.0f);
+	m_angular_z.push_back(0.0f);
+
+	const Vector3D& inertia = body_shape.getInertia();
+	auto inverse = [mass](float value) { return mass > 0.0f && value > 0.0f ? 1.0f / (mass * value) : 0.0f; };
+	m_inverse_mass.push_back(mass > 0.0f ? 1.0f / mass : 0.0f);
+	m_inverse_inertia_x.push_back(inverse(inertia.m_x));
+	m_inverse_inertia_y.push_back(inverse(inertia.m_y));
+	m_inverse_inertia_z.push_back(inverse(inertia.m_z));
+	m_sleep_time.push_back(0.0f);
+	m_body_shape.push_back(shape);
+	m_awake.push_back(mass > 0.0f);
+	m_poses.emplace_back();
+	m_world_inertia.resize(m_world_inertia.size() + 9);
+	m_parent.push_back(body);
+	m_island_of.push_back(0);
+	updatePose(body);
+
+	Vector3D min, max;
+	body_shape.getBounds(m_poses[body].m_rotation, m_poses[body].m_position, min, max);
+	Vector3D margin(PhysicsContacts::CONTACT_MARGIN, PhysicsContacts::CONTACT_MARGIN, PhysicsContacts::CONTACT_MARGIN);
+	m_broadphase.add(min - margin, max + margin);
+	return body;
+}
+
+
+void PhysicsWorld::clear()
+{
+	*this = PhysicsWorld();
+}
+
+
+void PhysicsWorld::setGravity(const Vector3D& gravity)
+{
+	m_gravity = gravity;
+}
+
+
+void PhysicsWorld::setVelocity(unsigned int body, const Vector3D& linear, const Vector3D& angular)
+{
+	if (m_inverse_mass[body] <= 0.0f)
+		return;
+	m_velocity_x[body] = linear.m_x;
+	m_velocity_y[body] = linear.m_y;
+	m_velocity_z[body] = linear.m_z;
+	m_angular_x[body] = angular.m_x;
+	m_angular_y[body] = angular.m_y;
+	m_angular_z[body] = angular.m_z;
+	wake(body);
+}
+
+
+void PhysicsWorld::wake(unsigned int body)
+{
+	if (m_inverse_mass[body] <= 0.0f)
+		return;
+	m_awake[body] = 1;
+	m_sleep_time[body] = 0.0f;
+}
+
+
+// rotation matrix of the quaternion, inverse inertia in world space: rotation * diagonal * transposed rotation
+void PhysicsWorld::updatePose(unsigned int body)
+{
+	float x = m_rotation_x[body], y = m_rotation_y[body], z = m_rotation_z[body], s = m_rotation_s[body];
+	PhysicsPose& pose = m_poses[body];
+	float* r = pose.m_rotation;
+	r[0] = 1.0f - 2.0f * (y * y + z * z);
+	r[1] = 2.0f * (x * y - s * z);
+	r[2] = 2.0f * (x * z + s * y);
+	r[3] = 2.0f * (x * y + s * z);
+	r[4] = 1.0f - 2.0f * (x * x + z * z);
+	r[5] = 2.0f * (y * z - s * x);
+	r[6] = 2.0f * (x * z - s * y);
+	r[7] = 2.0f * (y * z + s * x);
+	r[8] = 1.0f - 2.0f * (x * x + y * y);
+	pose.m_position = Vector3D(m_position_x[body], m_position_y[body], m_position_z[body]);
+
+	float diagonal[3] = { m_inverse_inertia_x[body], m_inverse_inertia_y[body], m_inverse_inertia_z[body] };
+	float* inertia = m_world_inertia.data() + (size_t)body * 9;
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+			inertia[i * 3 + j] = r[i * 3] * diagonal[0] * r[j * 3] + r[i * 3 + 1] * diagonal[1] * r[j * 3 + 1] + r[i * 3 + 2] * diagonal[2] * r[j * 3 + 2];
+	}
+}
+
+
+void PhysicsWorld::step(float time)
+{
+	if (time <= 0.0f)
+		return;
+
+	auto milliseconds = [](std::chrono::high_resolution_clock::time_point begin)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count();
+	};
+	auto step_start = std::chrono::high_resolution_clock::now();
+	unsigned int count = (unsigned int)m_position_x.size();
+
+	// gravity and damping of the awake bodies
+	m_awake_bodies.clear();
+	for (unsigned int body = 0; body < count; body++)
+	{
+		if (m_awake[body])
+			m_awake_bodies.push_back(body);
+	}
+	float damping = 1.0f / (1.0f + time * ANGULAR_DAMPING);
+	Vector3D gravity = m_gravity * time;
+	JobSystem::get()->parallelFor((unsigned int)m_awake_bodies.size(), 1024, [&](unsigned int begin, unsigned int end)
+		{
+			const unsigned int* bodies = m_awake_bodies.data();
+			float* velocity_x = m_velocity_x.data();
+			float* velocity_y = m_velocity_y.data();
+			float* velocity_z = m_velocity_z.data();
+			float* angular_x = m_angular_x.data();
+			float* angular_y = m_angular_y.data();
+			float* angular_z = m_angular_z.data();
+			for (unsigned int i = begin; i < end; i++)
+			{
+				unsigned int body = bodies[i];
+				velocity_x[body] += gravity.m_x;
+				velocity_y[body] += gravity.m_y;
+				velocity_z[body] += gravity.m_z;
+				angular_x[body] *= damping;
+				angular_y[body] *= damping;
+				angular_z[body] *= damping;
+			}
+		});
+
+	auto start = std::chrono::high_resolution_clock::now();
+	updateBroadphase();
+	m_stats.m_broadphase_ms = milliseconds(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	findContacts();
+	m_stats.m_narrowphase_ms = milliseconds(start);
+
+	start = std::chrono::high_resolution_clock::now();
+	buildIslands();
+	m_stats.m_islands_ms = milliseconds(start);
+
+	// effective masses and bias velocities of the points in awake islands
+	start = std::chrono::high_resolution_clock::now();
+	m_solver_points.resize(m_manifolds.size() * ContactManifold::MAX_POINTS);
+	JobSystem::get()->parallelFor((unsigned int)m_island_manifolds.size(), 256, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				unsigned int index = m_island_manifolds[i];
+				const ContactManifold& manifold = m_manifolds[index];
+				unsigned int a = manifold.m_a, b = manifold.m_b;
+				const Vector3D& normal = manifold.m_normal;
+				const float* inertia_a = m_world_inertia.data() + (size_t)a * 9;
+				const float* inertia_b = m_world_inertia.data() + (size_t)b * 9;
+
+				Vector3D directions[3];
+				directions[0] = normal;
+				directions[1] = fabsf(normal.m_x) < 0.57f ? Vector3D::cross(normal, Vector3D(1.0f, 0.0f, 0.0f)) : Vector3D::cross(normal, Vector3D(0.0f, 1.0f, 0.0f));
+				directions[1] = directions[1] * (1.0f / directions[1].length());
+				directions[2] = Vector3D::cross(normal, directions[1]);
+
+				for (unsigned int point = 0; point < manifold.m_count; point++)
+				{
+					SolverPoint& solver = m_solver_points[(size_t)index * ContactManifold::MAX_POINTS + point];
+					Vector3D ra = manifold.m_points[point] - m_poses[a].m_position;
+					Vector3D rb = manifold.m_points[point] - m_poses[b].m_position;
+					for (int i = 0; i < 3; i++)
+					{
+						SolverAxis& axis = solver.m_axes[i];
+						axis.m_direction = directions[i];
+						axis.m_arm_a = Vector3D::cross(ra, directions[i]);
+						axis.m_arm_b = Vector3D::cross(rb, directions[i]);
+						axis.m_turn_a = multiply(inertia_a, axis.m_arm_a);
+						axis.m_turn_b = multiply(inertia_b, axis.m_arm_b);
+						float k = m_inverse_mass[a] + m_inverse_mass[b] + Vector3D::dot(axis.m_arm_a, axis.m_turn_a) + Vector3D::dot(axis.m_arm_b, axis.m_turn_b);
+						axis.m_mass = k > 0.0f ? 1.0f / k : 0.0f;
+					}
+
+					// push out what is deeper than the slop, a gap may close within this step
+					float depth = manifold.m_depths[point];
+					if (depth > PENETRATION_SLOP)
+						solver.m_bias = std::min(BAUMGARTE * (depth - PENETRATION_SLOP) / time, MAX_PUSH_VELOCITY);
+					else
+						solver.m_bias = depth < 0.0f ? depth / time : 0.0f;
+				}
+			}
+		});
+
+	unsigned int islands = (unsigned int)m_island_order.size();
+	JobSystem::get()->parallelFor(islands, 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; i++)
+				solveIsland(m_island_order[i], time);
+		});
+	m_stats.m_solve_ms = milliseconds(start);
+
+	m_stats.m_bodies = count;
+	m_stats.m_awake = (unsigned int)m_island_bodies.size();
+	m_stats.m_pairs = (unsigned int)m_broadphase.getPairs().size();
+	m_stats.m_manifolds = (unsigned int)m_manifolds.size();
+	m_stats.m_contacts = 0;
+	for (const ContactManifold& manifold : m_manifolds)
+		m_stats.m_contacts += manifold.m_count;
+	m_stats.m_islands = islands;
+	m_stats.m_largest_island = islands ? m_island_body_start[m_island_order[0] + 1] - m_island_body_start[m_island_order[0]] : 0;
+	m_stats.m_step_ms = milliseconds(step_start);
+}
+
+
+void PhysicsWorld::updateBroadphase()
+{
+	// boxes in parallel, the broadphase takes them one by one
+	unsigned int count = (unsigned int)m_awake_bodies.size();
+	m_bounds.resize((size_t)count * 2);
+	JobSystem::get()->parallelFor(count, 512, [&](unsigned int begin, unsigned int end)
+		{
+			Vector3D margin(PhysicsContacts::CONTACT_MARGIN, PhysicsContacts::CONTACT_MARGIN, PhysicsContacts::CONTACT_MARGIN);
+			for (unsigned int i = begin; i < end; i++)
+			{
+				unsigned int body = m_awake_bodies[i];
+				m_shapes[m_body_shape[body]].getBounds(m_poses[body].m_rotation, m_poses[body].m_position, m_bounds[i * 2], m_bounds[i * 2 + 1]);
+				m_bounds[i * 2] = m_bounds[i * 2] - margin;
+				m_bounds[i * 2 + 1] = m_bounds[i * 2 + 1] + margin;
+			}
+		});
+	for (unsigned int i = 0; i < count; i++)
+		m_broadphase.update(m_awake_bodies[i], m_bounds[i * 2], m_bounds[i * 2 + 1]);
+	m_broadphase.findPairs();
+}
+
+
+/*
+	- a pair with an awake body is tested. A sleeping pair keeps its manifolds of the last step: they hold its island
+	  together until it wakes
+	- the convex body is always a: a mesh is only ever b
+*/
+
+void PhysicsWorld::findContacts()
+{
+	std::swap(m_manifolds, m_last_manifolds);
+	m_manifolds.clear();
+	m_last_keys.resize(m_last_manifolds.size());
+	for (unsigned int i = 0; i < m_last_manifolds.size(); i++)
+	{
+		const ContactManifold& manifold = m_last_manifolds[i];
+		m_last_keys[i] = { ((unsigned long long)manifold.m_a << 32) | manifold.m_b, manifold.m_feature, i };
+	}
+	auto less = [](const ManifoldKey& a, const ManifoldKey& b) { return a.m_bodies < b.m_bodies || (a.m_bodies == b.m_bodies && a.m_feature < b.m_feature); };
+	std::sort(m_last_keys.begin(), m_last_keys.end(), less);
+
+	auto warmStart = [&](ContactManifold& manifold)
+	{
+		ManifoldKey key = { ((unsigned long long)manifold.m_a << 32) | manifold.m_b, manifold.m_feature, 0 };
+		auto found = std::lower_bound(m_last_keys.begin(), m_last_keys.end(), key, less);
+		if (found == m_last_keys.end() || found->m_bodies != key.m_bodies || found->m_feature != key.m_feature)
+			return;
+		const ContactManifold& last = m_last_manifolds[found->m_index];
+		for (unsigned int point = 0; point < manifold.m_count; point++)
+		{
+			float best = MATCH_DISTANCE * MATCH_DISTANCE;
+			for (unsigned int other = 0; other < last.m_count; other++)
+			{
+				Vector3D offset = manifold.m_anchors[point] - last.m_anchors[other];
+				float distance = Vector3D::dot(offset, offset);
+				if (distance < best)
+				{
+					best = distance;
+					manifold.m_normal_impulses[point] = last.m_normal_impulses[other];
+					manifold.m_tangent_impulses[point][0] = last.m_tangent_impulses[other][0];
+					manifold.m_tangent_impulses[point][1] = last.m_tangent_impulses[other][1];
+				}
+			}
+		}
+	};
+
+	const std::vector<BroadphasePair>& pairs = m_broadphase.getPairs();
+	collectChunks((unsigned int)pairs.size(), m_chunk_manifolds, m_manifolds, [&](unsigned int begin, unsigned int end, std::vector<ContactManifold>& manifolds)
+		{
+			for (unsigned int i = begin; i < end; i++)
+			{
+				unsigned int a = pairs[i].m_a, b = pairs[i].m_b;
+				if (!m_shapes[m_body_shape[a]].isConvex())
+					std::swap(a, b);
+				const PhysicsShape& shape_a = m_shapes[m_body_shape[a]];
+				const PhysicsShape& shape_b = m_shapes[m_body_shape[b]];
+				if (!shape_a.isConvex() || (m_inverse_mass[a] <= 0.0f && m_inverse_mass[b] <= 0.0f))
+					continue;
+
+				if (!m_awake[a] && !m_awake[b])
+				{
+					ManifoldKey key = { ((unsigned long long)a << 32) | b, 0, 0 };
+					auto found = std::lower_bound(m_last_keys.begin(), m_last_keys.end(), key, less);
+					for (; found != m_last_keys.end() && found->m_bodies == key.m_bodies; ++found)
+						manifolds.push_back(m_last_manifolds[found->m_index]);
+					continue;
+				}
+
+				if (shape_b.isConvex())
+				{
+					ContactManifold manifold;
+					if (!PhysicsContacts::collide(shape_a, m_poses[a], shape_b, m_poses[b], manifold))
+						continue;
+					manifold.m_a = a;
+					manifold.m_b = b;
+					warmStart(manifold);
+					manifolds.push_back(manifold);
+				}
+				else
+				{
+					size_t first = manifolds.size();
+					PhysicsContacts::collideMesh(shape_a, m_poses[a], shape_b, m_poses[b], a, b, manifolds);
+					for (size_t manifold = first; manifold < manifolds.size(); manifold++)
+						warmStart(manifolds[manifold]);
+				}
+			}
+		});
+}
+
+
+unsigned int PhysicsWorld::findRoot(unsigned int body)
+{
+	while (m_parent[body] != body)
+	{
+		m_parent[body] = m_parent[m_parent[body]];
+		body = m_parent[body];
+	}
+	return body;
+}
+
+
+/*
+	- union find over the contacts between dynamic bodies, the lower root wins -> the same islands on every run
+	- an island with an awake body wakes as a whole. The bodies and manifolds of the awake islands are sorted into
+	  runs per island, the islands ordered largest first so the long jobs start early
+*/
+
+void PhysicsWorld::buildIslands()
+{
+	unsigned int count = (unsigned int)m_position_x.size();
+	for (unsigned int body = 0; body < count; body++)
+		m_parent[body] = body;
+	for (const ContactManifold& manifold : m_manifolds)
+	{
+		if (m_inverse_mass[manifold.m_a] <= 0.0f || m_inverse_mass[manifold.m_b] <= 0.0f)
+			continue;
+		unsigned int a = findRoot(manifold.m_a), b = findRoot(manifold.m_b);
+		if (a != b)
+			m_parent[std::max(a, b)] = std::min(a, b);
+	}
+
+	// m_island_of: first whether the root has an awake body, then the island of the root
+	const unsigned int NO_ISLAND = ~0u;
+	std::fill(m_island_of.begin(), m_island_of.end(), 0u);
+	for (unsigned int body = 0; body < count; body++)
+	{
+		if (m_awake[body])
+			m_island_of[findRoot(body)] = 1;
+	}
+	unsigned int islands = 0;
+	for (unsigned int body = 0; body < count; body++)
+	{
+		if (m_inverse_mass[body] <= 0.0f)
+			continue;
+		unsigned int root = findRoot(body);
+		if (root == body)
+			m_island_of[body] = m_island_of[body] ? islands++ : NO_ISLAND;
+	}
+
+	m_island_body_start.assign(islands + 1, 0);
+	m_island_manifold_start.assign(islands + 1, 0);
+	for (unsigned int body = 0; body < count; body++)
+	{
+		if (m_inverse_mass[body] <= 0.0f)
+			continue;
+		unsigned int island = m_island_of[findRoot(body)];
+		if (island == NO_ISLAND)
+			continue;
+		if (!m_awake[body])
+			wake(body);
+		m_island_body_start[island + 1]++;
+	}
+	auto getIsland = [&](const ContactManifold& manifold)
+	{
+		unsigned int body = m_inverse_mass[manifold.m_a] > 0.0f ? manifold.m_a : manifold.m_b;
+		return m_island_of[findRoot(body)];
+	};
+	for (const ContactManifold& manifold : m_manifolds)
+	{
+		unsigned int island = getIsland(manifold);
+		if (island != NO_ISLAND)
+			m_island_manifold_start[island + 1]++;
+	}
+	for (unsigned int island = 0; island < islands; island++)
+	{
+		m_island_body_start[island + 1] += m_island_body_start[island];
+		m_island_manifold_start[island + 1] += m_island_manifold_start[island];
+	}
+
+	m_island_bodies.resize(m_island_body_start[islands]);
+	m_island_manifolds.resize(m_island_manifold_start[islands]);
+	std::vector<unsigned int>& fill = m_island_order;
+	fill.assign(m_island_body_start.begin(), m_island_body_start.end() - 1);
+	for (unsigned int body = 0; body < count; body++)
+	{
+		if (m_inverse_mass[body] <= 0.0f)
+			continue;
+		unsigned int island = m_island_of[findRoot(body)];
+		if (island != NO_ISLAND)
+			m_island_bodies[fill[island]++] = body;
+	}
+	fill.assign(m_island_manifold_start.begin(), m_island_manifold_start.end() - 1);
+	for (unsigned int index = 0; index < m_manifolds.size(); index++)
+	{
+		unsigned int island = getIsland(m_manifolds[index]);
+		if (island != NO_ISLAND)
+			m_island_manifolds[fill[island]++] = index;
+	}
+
+	m_island_order.resize(islands);
+	for (unsigned int island = 0; island < islands; island++)
+		m_island_order[island] = island;
+	std::sort(m_island_order.begin(), m_island_order.end(), [&](unsigned int a, unsigned int b)
+		{
+			unsigned int size_a = m_island_body_start[a + 1] - m_island_body_start[a];
+			unsigned int size_b = m_island_body_start[b + 1] - m_island_body_start[b];
+			return size_a > size_b || (size_a == size_b && a < b);
+		});
+}
+
+
+/*
+	- warm start with the impulses of the last step, then sequential impulses: friction clamped by the normal impulse
+	  of the point, then the normal impulse clamped to push only. Static bodies are never written
+	- positions and rotations integrated with the solved velocities, then the island sleeps if every body was slow
+	  long enough
+*/
+
+void PhysicsWorld::solveIsland(unsigned int island, float time)
+{
+	const unsigned int* bodies = m_island_bodies.data() + m_island_body_start[island];
+	unsigned int body_count = m_island_body_start[island + 1] - m_island_body_start[island];
+	const unsigned int* manifolds = m_island_manifolds.data() + m_island_manifold_start[island];
+	unsigned int manifold_count = m_island_manifold_start[island + 1] - m_island_manifold_start[island];
+
+	// the velocity of b relative to a along an axis, and an impulse along it: pushes b, pulls a
+	auto getSpeed = [&](unsigned int a, unsigned int b, const SolverAxis& axis)
+	{
+		const Vector3D& d = axis.m_direction;
+		return (m_velocity_x[b] - m_velocity_x[a]) * d.m_x + (m_velocity_y[b] - m_velocity_y[a]) * d.m_y + (m_velocity_z[b] - m_velocity_z[a]) * d.m_z +
+			m_angular_x[b] * axis.m_arm_b.m_x + m_angular_y[b] * axis.m_arm_b.m_y + m_angular_z[b] * axis.m_arm_b.m_z -
+			m_angular_x[a] * axis.m_arm_a.m_x - m_angular_y[a] * axis.m_arm_a.m_y - m_angular_z[a] * axis.m_arm_a.m_z;
+	};
+	auto applyImpulse = [&](unsigned int a, unsigned int b, const SolverAxis& axis, float impulse)
+	{
+		if (m_inverse_mass[a] > 0.0f)
+		{
+			float linear = impulse * m_inverse_mass[a];
+			m_velocity_x[a] -= axis.m_direction.m_x * linear;
+			m_velocity_y[a] -= axis.m_direction.m_y * linear;
+			m_velocity_z[a] -= axis.m_direction.m_z * linear;
+			m_angular_x[a] -= axis.m_turn_a.m_x * impulse;
+			m_angular_y[a] -= axis.m_turn_a.m_y * impulse;
+			m_angular_z[a] -= axis.m_turn_a.m_z * impulse;
+		}
+		if (m_inverse_mass[b] > 0.0f)
+		{
+			float linear = impulse * m_inverse_mass[b];
+			m_velocity_x[b] += axis.m_direction.m_x * linear;
+			m_velocity_y[b] += axis.m_direction.m_y * linear;
+			m_velocity_z[b] += axis.m_direction.m_z * linear;
+			m_angular_x[b] += axis.m_turn_b.m_x * impulse;
+			m_angular_y[b] += axis.m_turn_b.m_y * impulse;
+			m_angular_z[b] += axis.m_turn_b.m_z * impulse;
+		}
+	};
+
+	for (unsigned int i = 0; i < manifold_count; i++)
+	{
+		const ContactManifold& manifold = m_manifolds[manifolds[i]];
+		const SolverPoint* points = m_solver_points.data() + (size_t)manifolds[i] * ContactManifold::MAX_POINTS;
+		for (unsigned int point = 0; point < manifold.m_count; point++)
+		{
+			applyImpulse(manifold.m_a, manifold.m_b, points[point].m_axes[0], manifold.m_normal_impulses[point]);
+			applyImpulse(manifold.m_a, manifold.m_b, points[point].m_axes[1], manifold.m_tangent_impulses[point][0]);
+			applyImpulse(manifold.m_a, manifold.m_b, points[point].m_axes[2], manifold.m_tangent_impulses[point][1]);
+		}
+	}
+
+	for (unsigned int iteration = 0; iteration < VELOCITY_ITERATIONS; iteration++)
+	{
+		for (unsigned int i = 0; i < manifold_count; i++)
+		{
+			ContactManifold& manifold = m_manifolds[manifolds[i]];
+			const SolverPoint* points = m_solver_points.data() + (size_t)manifolds[i] * ContactManifold::MAX_POINTS;
+			unsigned int a = manifold.m_a, b = manifold.m_b;
+			for (unsigned int point = 0; point < manifold.m_count; point++)
+			{
+				const SolverPoint& solver = points[point];
+
+				float limit = FRICTION * manifold.m_normal_impulses[point];
+				for (int tangent = 0; tangent < 2; tangent++)
+				{
+					const SolverAxis& axis = solver.m_axes[tangent + 1];
+					float& accumulated = manifold.m_tangent_impulses[point][tangent];
+					float total = std::min(std::max(accumulated - axis.m_mass * getSpeed(a, b, axis), -limit), limit);
+					applyImpulse(a, b, axis, total - accumulated);
+					accumulated = total;
+				}
+
+				const SolverAxis& axis = solver.m_axes[0];
+				float& accumulated = manifold.m_normal_impulses[point];
+				float total = std::max(accumulated + axis.m_mass * (solver.m_bias - getSpeed(a, b, axis)), 0.0f);
+				applyImpulse(a, b, axis, total - accumulated);
+				accumulated = total;
+			}
+		}
+	}
+
+	float slowest = FLT_MAX;
+	float linear_limit = SLEEP_VELOCITY * SLEEP_VELOCITY;
+	float angular_limit = 4.0f * linear_limit;
+	for (unsigned int i = 0; i < body_count; i++)
+	{
+		unsigned int body = bodies[i];
+		m_position_x[body] += m_velocity_x[body] * time;
+		m_position_y[body] += m_velocity_y[body] * time;
+		m_position_z[body] += m_velocity_z[body] * time;
+
+		// q += 0.5 * (angular, 0) * q * time
+		float wx = m_angular_x[body] * time * 0.5f, wy = m_angular_y[body] * time * 0.5f, wz = m_angular_z[body] * time * 0.5f;
+		float x = m_rotation_x[body], y = m_rotation_y[body], z = m_rotation_z[body], s = m_rotation_s[body];
+		x += wx * s + wy * z - wz * y;
+		y += wy * s + wz * x - wx * z;
+		z += wz * s + wx * y - wy * x;
+		s -= wx * m_rotation_x[body] + wy * m_rotation_y[body] + wz * m_rotation_z[body];
+		float scale = 1.0f / sqrtf(x * x + y * y + z * z + s * s);
+		m_rotation_x[body] = x * scale;
+		m_rotation_y[body] = y * scale;
+		m_rotation_z[body] = z * scale;
+		m_rotation_s[body] = s * scale;
+		updatePose(body);
+
+		float linear = m_velocity_x[body] * m_velocity_x[body] + m_velocity_y[body] * m_velocity_y[body] + m_velocity_z[body] * m_velocity_z[body];
+		float angular = m_angular_x[body] * m_angular_x[body] + m_angular_y[body] * m_angular_y[body] + m_angular_z[body] * m_angular_z[body];
+		m_sleep_time[body] = linear > linear_limit || angular > angular_limit ? 0.0f : m_sleep_time[body] + time;
+		slowest = std::min(slowest, m_sleep_time[body]);
+	}
+
+	if (slowest < SLEEP_TIME)
+		return;
+	for (unsigned int i = 0; i < body_count; i++)
+	{
+		unsigned int body = bodies[i];
+		m_awake[body] = 0;
+		m_velocity_x[body] = m_velocity_y[body] = m_velocity_z[body] = 0.0f;
+		m_angular_x[body] = m_angular_y[body] = m_angular_z[body] = 0.0f;
+	}
+}
+
+
+Vector3D PhysicsWorld::getPosition(unsigned int body) const
+{
+	return Vector3D(m_position_x[body], m_position_y[body], m_position_z[body]);
+}
+
+
+Vector4D PhysicsWorld::getRotation(unsigned int body) const
+{
+	return Vector4D(m_rotation_x[body], m_rotation_y[body], m_rotation_z[body], m_rotation_s[body]);
+}
+
+
+// row vectors: the rows of the matrix are the columns of the rotation
+Matrix4x4 PhysicsWorld::getWorldMatrix(unsigned int body) const
+{
+	const float* r = m_poses[body].m_rotation;
+	Matrix4x4 world;
+	world.setIdentity();
+	for (int i = 0; i < 3; i++)
+	{
+		for (int j = 0; j < 3; j++)
+			world.m_mat[i][j] = r[j * 3 + i];
+	}
+	world.setTranslation(getPosition(body));
+	return world;
+}
+
+
+bool PhysicsWorld::isSleeping(unsigned int body) const
+{
+	return m_inverse_mass[body] > 0.0f && !m_awake[body];
+}
+
+
+unsigned int PhysicsWorld::getBodyCount() const
+{
+	return (unsigned int)m_position_x.size();
+}
+
+
+const PhysicsStats& PhysicsWorld::getStats() const
+{
+	return m_stats;
+}
+
+
+PhysicsBenchmark PhysicsWorld::runBenchmark(unsigned int boxes, unsigned int steps)
+{
+	PhysicsBenchmark result;
+	result.m_bodies = boxes;
+	result.m_steps = steps;
+	result.m_threads = JobSystem::get()->getThreadCount();
+	if (!boxes || !steps)
+		return result;
+
+	auto random = [](unsigned int index, unsigned int value)
+	{
+		unsigned int hash = (index * 8 + value + 1) * 2654435761u;
+		hash ^= hash >> 15;
+		hash *= 2246822519u;
+		hash ^= hash >> 13;
+		return (hash & 0xffff) / 65535.0f;
+	};
+
+	// columns of ten boxes two units apart, slightly turned and shifted so they settle instead of standing exactly
+	const unsigned int height = 10;
+	const float spacing = 2.0f;
+	unsigned int columns = (boxes + height - 1) / height;
+	unsigned int side = (unsigned int)ceilf(sqrtf((float)columns));
+	float extent = side * spacing * 0.5f + 2.0f;
+
+	PhysicsWorld world;
+	unsigned int floor = world.createBoxShape(Vector3D(extent, 0.5f, extent));
+	unsigned int box = world.createBoxShape(Vector3D(0.5f, 0.5f, 0.5f));
+	world.createBody(floor, Vector3D(0.0f, -0.5f, 0.0f), Vector4D(0.0f, 0.0f, 0.0f, 1.0f), 0.0f);
+	for (unsigned int i = 0; i < boxes; i++)
+	{
+		unsigned int column = i / height, level = i % height;
+		float x = ((column % side) - side * 0.5f) * spacing + (random(i, 0) - 0.5f) * 0.1f;
+		float z = ((column / side) - side * 0.5f) * spacing + (random(i, 1) - 0.5f) * 0.1f;
+		float angle = (random(i, 2) - 0.5f) * 0.1f;
+		world.createBody(box, Vector3D(x, 0.52f + level * 1.02f, z), Vector4D(0.0f, sinf(angle * 0.5f), 0.0f, cosf(angle * 0.5f)), 1.0f);
+	}
+
+	double total = 0.0, settled = 0.0;
+	unsigned int settled_steps = std::max(steps / 4, 1u);
+	for (unsigned int step = 0; step < steps; step++)
+	{
+		world.step(1.0f / 60.0f);
+		const PhysicsStats& stats = world.getStats();
+		total += stats.m_step_ms;
+		result.m_max_ms = std::max(result.m_max_ms, stats.m_step_ms);
+		if (step >= steps - settled_steps)
+			settled += stats.m_step_ms;
+		if (stats.m_step_ms >= result.m_peak.m_step_ms)
+			result.m_peak = stats;
+	}
+	result.m_average_ms = total / steps;
+	result.m_settled_ms = settled / settled_steps;
+	for (unsigned int body = 0; body < world.getBodyCount(); body++)
+		result.m_sleeping += world.isSleeping(body) ? 1 : 0;
+	return result;
+}
@@ -0,0 +1,200 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Broadphase.h"
+#include "Matrix4x4.h"
+#include "PhysicsContacts.h"
+#include "PhysicsShape.h"
+#include "Vector4D.h"
+#include <vector>
+
+// of the last PhysicsWorld::step()
+struct PhysicsStats
+{
+	unsigned int m_bodies = 0;
+	unsigned int m_awake = 0;
+	unsigned int m_pairs = 0;
+	unsigned int m_manifolds = 0;
+	unsigned int m_contacts = 0;
+	unsigned int m_islands = 0;					// awake ones
+	unsigned int m_largest_island = 0;			// bodies
+	double m_broadphase_ms = 0.0;
+	double m_narrowphase_ms = 0.0;
+	double m_islands_ms = 0.0;
+	double m_solve_ms = 0.0;
+	double m_step_ms = 0.0;
+};
+
+// PhysicsWorld::runBenchmark
+struct PhysicsBenchmark
+{
+	unsigned int m_bodies = 0;
+	unsigned int m_steps = 0;
+	unsigned int m_threads = 0;
+	double m_average_ms = 0.0;
+	double m_max_ms = 0.0;
+	double m_settled_ms = 0.0;					// average of the last quarter of the steps
+	unsigned int m_sleeping = 0;				// bodies after the last step
+	PhysicsStats m_peak;						// the slowest step
+};
+
+
+/*
+	PhysicsWorld: rigid bodies with sphere, capsule, box, hull and static mesh shapes
+
+	- bodies in SoA arrays: positions, rotations (quaternions), velocities, inverse masses and inertias each in arrays
+	  of their own -> the integration loops are plain loops over floats the compiler vectorizes
+	- step(): gravity, then the broadphase over the boxes of the awake bodies (static and sleeping bodies do not move,
+	  the incremental broadphase does not test them again), contacts in parallel over the pairs. Points found again
+	  start with the impulses of the last step (warm starting)
+	- islands: dynamic bodies linked by contacts (union find), static bodies link nothing. Every awake island is solved
+	  on a job of its own with VELOCITY_ITERATIONS of sequential impulses (normal and friction), then its positions are
+	  integrated. Islands never share a dynamic body -> no locks, the static bodies they share are only read
+	- sleeping: an island whose bodies all stayed slower than SLEEP_VELOCITY for SLEEP_TIME sleeps as a whole. Its
+	  contacts are kept and a contact with an awake body wakes it
+	- rotations are quaternions in Vector4D, m_s the real part. Ids of shapes and bodies are indices, bodies are not
+	  removed but clear() empties the world
+*/
+
+class PhysicsWorld
+{
+public:
+
+	static const unsigned int VELOCITY_ITERATIONS = 16;	// a column of ten boxes still rocks with 8
+	static constexpr float SLEEP_TIME = 0.5f;
+	static constexpr float SLEEP_VELOCITY = 0.05f;
+	static constexpr float FRICTION = 0.5f;
+
+	PhysicsWorld();
+
+	unsigned int createSphereShape(float radius);
+	unsigned int createCapsuleShape(float radius, float half_height);
+	unsigned int createBoxShape(const Vector3D& half_extents);
+	unsigned int createHullShape(const std::vector<Vector3D>& points);
+	// the mesh stays owned by the caller and must outlive the world
+	unsigned int createMeshShape(const CollisionMesh* mesh);
+
+	// mass 0: static. Bodies with a mesh shape are always static
+	unsigned int createBody(unsigned int shape, const Vector3D& position, const Vector4D& rotation, float mass);
+	void clear();
+
+	void setGravity(const Vector3D& gravity);
+	// wakes the body
+	void setVelocity(unsigned int body, const Vector3D& linear, const Vector3D& angular);
+
+	void step(float time);
+
+	Vector3D getPosition(unsigned int body) const;
+	Vector4D getRotation(unsigned int body) const;
+	// rotation and translation for the row vectors of the shaders
+	Matrix4x4 getWorldMatrix(unsigned int body) const;
+	bool isSleeping(unsigned int body) const;
+	unsigned int getBodyCount() const;
+	const PhysicsStats& getStats() const;
+
+	/*
+		boxes of one unit in columns of ten, dropped onto a static floor, steps of 1/60 s. The step times of the
+		whole run: falling, settling and most of the columns asleep at the end
+	*/
+	static PhysicsBenchmark runBenchmark(unsigned int boxes, unsigned int steps);
+
+private:
+
+	unsigned int addShape(const PhysicsShape& shape);
+	void updatePose(unsigned int body);
+	void wake(unsigned int body);
+
+	void updateBroadphase();
+	void findContacts();
+	void buildIslands();
+	void solveIsland(unsigned int island, float time);
+	unsigned int findRoot(unsigned int body);
+
+private:
+
+	std::vector<PhysicsShape> m_shapes;
+	Vector3D m_gravity = Vector3D(0.0f, -9.81f, 0.0f);
+
+	// bodies
+	std::vector<float> m_position_x, m_position_y, m_position_z;
+	std::vector<float> m_rotation_x, m_rotation_y, m_rotation_z, m_rotation_s;
+	std::vector<float> m_velocity_x, m_velocity_y, m_velocity_z;
+	std::vector<float> m_angular_x, m_angular_y, m_angular_z;
+	std::vector<float> m_inverse_mass;
+	std::vector<float> m_inverse_inertia_x, m_inverse_inertia_y, m_inverse_inertia_z;	// on the axes of the shape
+	std::vector<float> m_sleep_time;
+	std::vector<unsigned int> m_body_shape;
+	std::vector<char> m_awake;					// never for static bodies
+	std::vector<PhysicsPose> m_poses;			// of the rotations and positions above
+	std::vector<float> m_world_inertia;			// inverse, 9 per body, rows
+
+	Broadphase m_broadphase;				// proxy ids are the body ids: bodies are only ever added
+	std::vector<unsigned int> m_awake_bodies;
+	std::vector<Vector3D> m_bounds;			// min and max of the awake bodies
+
+	// contacts of this and of the last step, the last ones sorted by bodies and feature for warm starting
+	struct ManifoldKey
+	{
+		unsigned long long m_bodies;
+		unsigned int m_feature;
+		unsigned int m_index;
+	};
+	std::vector<ContactManifold> m_manifolds;
+	std::vector<ContactManifold> m_last_manifolds;
+	std::vector<ManifoldKey> m_last_keys;
+	std::vector<std::vector<ContactManifold>> m_chunk_manifolds;
+
+	/*
+		per point of m_manifolds (ContactManifold::MAX_POINTS each): the normal and the two tangents with their lever
+		arms (r x axis) and the turn an impulse of one along them gives (inverse world inertia * arm) -> an iteration
+		only takes dot products
+	*/
+	struct SolverAxis
+	{
+		Vector3D m_direction;
+		Vector3D m_arm_a, m_arm_b;
+		Vector3D m_turn_a, m_turn_b;
+		float m_mass;
+	};
+	struct SolverPoint
+	{
+		SolverAxis m_axes[3];				// normal, tangents
+		float m_bias;
+	};
+	std::vector<SolverPoint> m_solver_points;
+
+	// islands: their bodies and manifolds in runs
+	std::vector<unsigned int> m_parent;
+	std::vector<unsigned int> m_island_of;
+	std::vector<unsigned int> m_island_body_start;
+	std::vector<unsigned int> m_island_bodies;
+	std::vector<unsigned int> m_island_manifold_start;
+	std::vector<unsigned int> m_island_manifolds;
+	std::vector<unsigned int> m_island_order;	// largest first, for the jobs
+
+	PhysicsStats m_stats;
+};
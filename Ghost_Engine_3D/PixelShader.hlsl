@@ -38,6 +38,7 @@ struct PS_INPUT
 	float4 position: SV_POSITION;
 	float2 texcoord: TEXCOORD;
 	float3 normal: NORMAL;
+	float3 world_position: TEXCOORD1;
 };
 
 cbuffer constant: register(b0)
@@ -52,6 +53,126 @@ cbuffer constant: register(b0)
 
 };
 
+// clustered point and spot lights of LightGrid (ClusterConstantType)
+cbuffer clusters: register(b2)
+{
+	uint3 m_grid;
+	uint m_light_count;
+	float2 m_tile_size;
+	float m_slice_scale;
+	float m_slice_bias;
+};
+
+// ShaderLight, world space. Point light: spot_cos_outer = -1
+struct Light
+{
+	float3 position;
+	float radius;
+	float3 color;
+	float spot_cos_outer;
+	float3 direction;
+	float spot_cos_inner;
+};
+
+StructuredBuffer<Light> Lights: register(t1);
+StructuredBuffer<uint2> Clusters: register(t2);		// offset and count in LightIndices
+StructuredBuffer<uint> LightIndices: register(t3);
+
+// cascaded shadow maps of ShadowCascades (ShadowConstantType)
+cbuffer shadows: register(b3)
+{
+	row_major float4x4 m_cascade_matrix[4];
+	float4 m_cascade_far;
+	float4 m_texel_size;
+	float m_enabled;
+	float m_bias;
+};
+
+Texture2D ShadowCascade0: register(t4);
+Texture2D ShadowCascade1: register(t5);
+Texture2D ShadowCascade2: register(t6);
+Texture2D ShadowCascade3: register(t7);
+SamplerComparisonState ShadowSampler: register(s1);
+
+
+/*
+	the cluster of the pixel: tile by screen position, slice by view depth (SV_POSITION.w). Only its lights are shaded.
+	Falloff (1 - (d / radius)^2)^2 reaches zero at the radius the lights were culled with
+*/
+float3 clusteredLights(PS_INPUT input)
+{
+	if (m_light_count == 0) return float3(0, 0, 0);
+
+	uint3 cluster;
+	cluster.xy = min(uint2(input.position.xy / m_tile_size), m_grid.xy - 1);
+	cluster.z = min((uint)max(log(input.position.w) * m_slice_scale + m_slice_bias, 0.0f), m_grid.z - 1);
+	uint2 range = Clusters[(cluster.z * m_grid.y + cluster.y) * m_grid.x + cluster.x];
+
+	float3 normal = normalize(mul(input.normal, (float3x3)m_world));
+	float3 result = float3(0, 0, 0);
+	for (uint i = 0; i < range.y; i++)
+	{
+		Light light = Lights[LightIndices[range.x + i]];
+		float3 to_light = light.position - input.world_position;
+		float distance = length(to_light);
+		to_light /= max(distance, 0.0001f);
+
+		float falloff = saturate(1.0f - (distance * distance) / (light.radius * light.radius));
+		falloff *= falloff;
+		if (light.spot_cos_outer > -1.0f)
+			falloff *= smoothstep(light.spot_cos_outer, light.spot_cos_inner, dot(-to_light, light.direction));
+
+		result += light.color * max(dot(normal, to_light), 0) * falloff;
+	}
+
+	return result;
+}
+
+/*
+	3 x 3 comparisons around the position, each filtered over 4 texels by the sampler -> soft edges of 4 texels
+*/
+float filterShadow(Texture2D shadow_map, float2 uv, float depth)
+{
+	float width, height;
+	shadow_map.GetDimensions(width, height);
+	float2 texel = float2(1.0f / width, 1.0f / height);
+
+	float lit = 0.0f;
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+			lit += shadow_map.SampleCmpLevelZero(ShadowSampler, uv + float2(x, y) * texel, depth);
+	}
+	return lit / 9.0f;
+}
+
+/*
+	- the cascade of the pixel by its view depth (SV_POSITION.w), as the splits were fitted on the CPU
+	- the position moves along the normal by m_bias texels of the cascade before the lookup: no self shadowing
+	  without a depth bias in the rasterizer state of the shadow pass
+	- 1 is lit. Beyond the last cascade (shadow distance) everything is lit
+*/
+float cascadedShadow(PS_INPUT input)
+{
+	if (m_enabled == 0.0f) return 1.0f;
+
+	float depth = input.position.w;
+	uint cascade = 0;
+	while (cascade < 3 && depth > m_cascade_far[cascade])
+		cascade++;
+	if (depth > m_cascade_far[3]) return 1.0f;
+
+	float3 normal = normalize(mul(input.normal, (float3x3)m_world));
+	float3 position = input.world_position + normal * m_texel_size[cascade] * m_bias;
+	float4 light = mul(float4(position, 1.0f), m_cascade_matrix[cascade]);
+	float2 uv = float2(light.x * 0.5f + 0.5f, 0.5f - light.y * 0.5f);
+
+	if (cascade == 0) return filterShadow(ShadowCascade0, uv, light.z);
+	if (cascade == 1) return filterShadow(ShadowCascade1, uv, light.z);
+	if (cascade == 2) return filterShadow(ShadowCascade2, uv, light.z);
+	return filterShadow(ShadowCascade3, uv, light.z);
+}
+
 float4 psmain(PS_INPUT input) : SV_TARGET
 {
 
@@ -63,9 +184,10 @@ float4 psmain(PS_INPUT input) : SV_TARGET
 
 
 	float3 diffuseLightIntense = max(dot(m_vectorLight.xyz, input.normal), 0); 
-	float3 diffuseLight = diffuseLightIntense * 2;
+	float3 diffuseLight = diffuseLightIntense * 2 * cascadedShadow(input);
 
 	ambient2Diffuse += diffuseLight;
+	ambient2Diffuse += clusteredLights(input);
 
 
 
@@ -0,0 +1,110 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	full screen passes of the render graph: one triangle from SV_VertexID (DeviceContext::drawFullScreenTriangle),
+	no vertex buffer. The pixel shaders read the targets of the earlier passes in t0 - t2
+	- psbright: the bright parts of the scene, written to a half size target
+	- psblur: 9 tap gaussian along m_direction, run once horizontal and once vertical
+	- pscomposite: scene + bloom into the back buffer, or the depth view
+	- psdepth: linear depth of the scene as gray
+*/
+struct VS_OUTPUT
+{
+	float4 position: SV_POSITION;
+	float2 texcoord: TEXCOORD0;
+};
+
+// PostProcessConstantType
+cbuffer constant: register(b0)
+{
+	float2 m_texel_size;		// 1 / size of the texture that is read
+	float2 m_direction;
+	float m_threshold;
+	float m_intensity;			// bloom strength, 0: no bloom target bound
+	float m_near;
+	float m_far;
+	float m_show_depth;
+};
+
+Texture2D Scene: register(t0);
+Texture2D Bloom: register(t1);
+Texture2D Depth: register(t2);
+SamplerState Sampler: register(s0);
+
+
+VS_OUTPUT vsmain(uint id: SV_VertexID)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+
+	// (0, 0) (2, 0) (0, 2) -> covers the screen, clipped to it
+	output.texcoord = float2((id << 1) & 2, id & 2);
+	output.position = float4(output.texcoord * float2(2.0f, -2.0f) + float2(-1.0f, 1.0f), 0.0f, 1.0f);
+
+	return output;
+}
+
+float4 psbright(VS_OUTPUT input) : SV_TARGET
+{
+	float3 color = Scene.Sample(Sampler, input.texcoord).rgb;
+	float luminance = dot(color, float3(0.2126f, 0.7152f, 0.0722f));
+
+	return float4(color * saturate(luminance - m_threshold), 1.0f);
+}
+
+float4 psblur(VS_OUTPUT input) : SV_TARGET
+{
+	const float weights[5] = { 0.227027f, 0.1945946f, 0.1216216f, 0.054054f, 0.016216f };
+
+	float2 step = m_direction * m_texel_size;
+	float3 color = Scene.Sample(Sampler, input.texcoord).rgb * weights[0];
+	for (int i = 1; i < 5; i++)
+	{
+		color += Scene.Sample(Sampler, input.texcoord + step * i).rgb * weights[i];
+		color += Scene.Sample(Sampler, input.texcoord - step * i).rgb * weights[i];
+	}
+
+	return float4(color, 1.0f);
+}
+
+float4 pscomposite(VS_OUTPUT input) : SV_TARGET
+{
+	if (m_show_depth > 0.0f) return float4(Depth.Sample(Sampler, input.texcoord).rrr, 1.0f);
+
+	float3 color = Scene.Sample(Sampler, input.texcoord).rgb;
+	if (m_intensity > 0.0f) color += Bloom.Sample(Sampler, input.texcoord).rgb * m_intensity;
+
+	return float4(saturate(color), 1.0f);
+}
+
+float4 psdepth(VS_OUTPUT input) : SV_TARGET
+{
+	float depth = Scene.Sample(Sampler, input.texcoord).r;
+	// back from the LH projection to view space
+	float linear_depth = m_near * m_far / (m_far - depth * (m_far - m_near));
+
+	return float4(saturate((linear_depth - m_near) / (m_far - m_near)).xxx, 1.0f);
+}
@@ -0,0 +1,169 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "Profiler.h"
+#include <cstring>
+
+namespace
+{
+	// row of the calling thread, -1 until its first marker
+	thread_local int t_thread_index = -1;
+}
+
+
+Profiler::Profiler() :m_start(std::chrono::high_resolution_clock::now())
+{
+}
+
+
+Profiler* Profiler::get()
+{
+	static Profiler profiler;
+	return &profiler;
+}
+
+
+void Profiler::setThreadName(const char* name)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// a restarted thread continues the row of its name
+	for (unsigned int i = 0; i < m_thread_names.size(); i++)
+	{
+		if (m_thread_names[i] == name)
+		{
+			t_thread_index = (int)i;
+			return;
+		}
+	}
+
+	if (t_thread_index < 0)
+	{
+		t_thread_index = (int)m_thread_names.size();
+		m_thread_names.push_back(name);
+	}
+	else
+	{
+		m_thread_names[t_thread_index] = name;
+	}
+}
+
+
+double Profiler::now()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - m_start).count();
+}
+
+
+void Profiler::addRecord(const char* name, double begin, double end)
+{
+	unsigned int thread = getThreadIndex();
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_records.push_back({ name, thread, begin, end });
+
+	while (!m_records.empty() && m_records.front().m_end < end - PROFILE_HISTORY_MS)
+	{
+		m_records.pop_front();
+	}
+}
+
+
+void Profiler::getRecords(double milliseconds, std::vector<ProfileRecord>& records)
+{
+	double since = now() - milliseconds;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	records.clear();
+	for (const ProfileRecord& record : m_records)
+	{
+		if (record.m_end >= since)
+			records.push_back(record);
+	}
+}
+
+
+unsigned int Profiler::getThreadCount()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return (unsigned int)m_thread_names.size();
+}
+
+
+std::string Profiler::getThreadName(unsigned int thread)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return thread < m_thread_names.size() ? m_thread_names[thread] : std::string();
+}
+
+
+/*
+	- for every record of first: the length of its intersection with the records of second on other threads.
+	  second should be a marker that does not nest in itself, otherwise the same time is counted twice
+*/
+
+double Profiler::getOverlap(const char* first, const char* second, double milliseconds)
+{
+	std::vector<ProfileRecord> records;
+	getRecords(milliseconds, records);
+
+	double total = 0.0;
+	double overlap = 0.0;
+
+	for (const ProfileRecord& a : records)
+	{
+		if (strcmp(a.m_name, first) != 0)
+			continue;
+
+		total += a.m_end - a.m_begin;
+
+		for (const ProfileRecord& b : records)
+		{
+			if (b.m_thread == a.m_thread || strcmp(b.m_name, second) != 0)
+				continue;
+
+			double begin = a.m_begin > b.m_begin ? a.m_begin : b.m_begin;
+			double end = a.m_end < b.m_end ? a.m_end : b.m_end;
+			if (end > begin)
+				overlap += end - begin;
+		}
+	}
+
+	return total > 0.0 ? overlap / total : 0.0;
+}
+
+
+unsigned int Profiler::getThreadIndex()
+{
+	if (t_thread_index < 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		t_thread_index = (int)m_thread_names.size();
+		m_thread_names.push_back("Thread " + std::to_string(t_thread_index));
+	}
+
+	return (unsigned int)t_thread_index;
+}
@@ -0,0 +1,110 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// one finished marker: what ran on which thread from when to when, in milliseconds since the profiler started
+struct ProfileRecord
+{
+	const char* m_name = nullptr;
+	unsigned int m_thread = 0;
+	double m_begin = 0.0;
+	double m_end = 0.0;
+};
+
+
+/*
+	Profiler: CPU timeline of named markers, per thread
+
+	- ProfileMarker measures its scope and hands the record to the profiler when it ends
+	- a thread gets its row on the first marker. setThreadName() gives the row a name, otherwise it is "Thread n"
+	- records older than PROFILE_HISTORY_MS are dropped -> the timeline shows the last frames, not the whole run
+	- marker names must be string literals (only the pointer is stored)
+	- Profiler class is a Singleton like GraphicsEngine
+*/
+
+class Profiler
+{
+public:
+	static const unsigned int PROFILE_HISTORY_MS = 500;
+
+public:
+
+	Profiler();
+
+	static Profiler* get();
+
+	// name of the calling thread in the timeline. A thread with the name of an earlier one takes over its row
+	void setThreadName(const char* name);
+
+	// milliseconds since the profiler started
+	double now();
+	void addRecord(const char* name, double begin, double end);
+
+	// records that ended in the last milliseconds, in the order they ended
+	void getRecords(double milliseconds, std::vector<ProfileRecord>& records);
+	unsigned int getThreadCount();
+	std::string getThreadName(unsigned int thread);
+
+	// part of the time of the first marker that another thread spent in the second marker, of the last milliseconds.
+	// 0: the two never ran at the same time, 1: the first one always ran alongside the second
+	double getOverlap(const char* first, const char* second, double milliseconds);
+
+private:
+
+	unsigned int getThreadIndex();
+
+private:
+
+	std::chrono::high_resolution_clock::time_point m_start;
+	std::mutex m_mutex;
+	std::deque<ProfileRecord> m_records;
+	std::vector<std::string> m_thread_names;
+};
+
+
+// measures from construction to the end of the scope
+class ProfileMarker
+{
+public:
+	ProfileMarker(const char* name) :m_name(name), m_begin(Profiler::get()->now())
+	{
+	}
+
+	~ProfileMarker()
+	{
+		Profiler::get()->addRecord(m_name, m_begin, Profiler::get()->now());
+	}
+
+private:
+	const char* m_name;
+	double m_begin;
+};
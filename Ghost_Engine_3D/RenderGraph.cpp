@@ -0,0 +1,348 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "RenderGraph.h"
+#include "DeviceContext.h"
+#include "SwapChain.h"
+#include "Profiler.h"
+#include <stdexcept>
+
+
+RenderGraphContext::RenderGraphContext(RenderGraph* graph, DeviceContext* context) :m_graph(graph), m_context(context)
+{
+}
+
+
+DeviceContext* RenderGraphContext::getDeviceContext()
+{
+	return m_context;
+}
+
+
+void RenderGraphContext::setRenderTargets(RenderGraphResource color, RenderGraphResource depth)
+{
+	RenderGraphResource sized = color != RENDER_GRAPH_NONE ? color : depth;
+	if (sized == RENDER_GRAPH_NONE)
+	{
+		throw std::runtime_error("RenderGraph: a pass needs a color or a depth target");
+	}
+
+	if (color != RENDER_GRAPH_NONE && m_graph->m_resources[color].m_swap_chain)
+	{
+		if (depth != RENDER_GRAPH_NONE)
+		{
+			throw std::runtime_error("RenderGraph: the back buffer is bound without depth");
+		}
+		m_context->setRenderTarget(m_graph->m_resources[color].m_swap_chain, false);
+	}
+	else
+	{
+		m_context->setRenderTargets(color != RENDER_GRAPH_NONE ? getRenderTarget(color) : nullptr, depth != RENDER_GRAPH_NONE ? getRenderTarget(depth) : nullptr);
+	}
+	m_context->setViewportSize(getWidth(sized), getHeight(sized));
+}
+
+
+// binds the back buffer (clearRenderTargetColor) -> clear before setRenderTargets
+void RenderGraphContext::clear(RenderGraphResource target, float red, float green, float blue, float alpha)
+{
+	if (m_graph->m_resources[target].m_swap_chain)
+	{
+		m_context->clearRenderTargetColor(m_graph->m_resources[target].m_swap_chain, red, green, blue, alpha);
+		return;
+	}
+	m_context->clearRenderTarget(getRenderTarget(target), red, green, blue, alpha);
+}
+
+
+void RenderGraphContext::setTexture(RenderGraphResource texture, UINT slot)
+{
+	if (m_graph->m_resources[texture].m_swap_chain)
+	{
+		throw std::runtime_error("RenderGraph: the back buffer cannot be read");
+	}
+	m_context->setTexture(getRenderTarget(texture), slot);
+}
+
+
+RenderTarget* RenderGraphContext::getRenderTarget(RenderGraphResource resource)
+{
+	if (m_graph->m_resources[resource].m_target)
+		return m_graph->m_resources[resource].m_target;
+
+	unsigned int physical = m_graph->getPhysicalIndex(resource);
+	if (physical == RENDER_GRAPH_NONE)
+		return nullptr;
+
+	return GraphicsEngine::get()->get(m_graph->m_physical[physical].m_target);
+}
+
+
+UINT RenderGraphContext::getWidth(RenderGraphResource resource)
+{
+	return m_graph->m_resources[resource].m_desc.m_width;
+}
+
+
+UINT RenderGraphContext::getHeight(RenderGraphResource resource)
+{
+	return m_graph->m_resources[resource].m_desc.m_height;
+}
+
+
+RenderGraph::RenderGraph()
+{
+}
+
+
+RenderGraph::~RenderGraph()
+{
+	clear();
+}
+
+
+void RenderGraph::reset()
+{
+	m_schedule.reset();
+	m_resources.clear();
+	m_passes.clear();
+	m_compiled = false;
+}
+
+
+RenderGraphResource RenderGraph::createTexture(const char* name, const RenderGraphTextureDesc& desc)
+{
+	if (!desc.m_width || !desc.m_height || !RenderTarget::getBytesPerPixel(desc.m_format))
+	{
+		throw std::runtime_error("RenderGraph: transient texture with an invalid size or format");
+	}
+
+	Resource resource;
+	resource.m_desc = desc;
+	m_resources.push_back(resource);
+	m_compiled = false;
+	return m_schedule.addTransient(name, getAliasKey(desc), getTextureBytes(desc));
+}
+
+
+RenderGraphResource RenderGraph::importBackBuffer(const char* name, SwapChain* swap_chain, UINT width, UINT height)
+{
+	Resource resource;
+	resource.m_desc.m_width = width;
+	resource.m_desc.m_height = height;
+	resource.m_desc.m_format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	resource.m_swap_chain = swap_chain;
+	m_resources.push_back(resource);
+	m_compiled = false;
+	return m_schedule.addImported(name);
+}
+
+
+RenderGraphResource RenderGraph::importTexture(const char* name, RenderTarget* target)
+{
+	if (!target)
+	{
+		throw std::runtime_error("RenderGraph: imported texture is missing");
+	}
+
+	Resource resource;
+	resource.m_desc.m_width = target->getWidth();
+	resource.m_desc.m_height = target->getHeight();
+	resource.m_desc.m_format = target->getFormat();
+	resource.m_target = target;
+	m_resources.push_back(resource);
+	m_compiled = false;
+	return m_schedule.addImported(name);
+}
+
+
+void RenderGraph::addPass(const char* name, const std::vector<RenderGraphResource>& reads, const std::vector<RenderGraphResource>& writes,
+	const std::function<void(RenderGraphContext& context)>& execute)
+{
+	m_schedule.addPass(name, reads, writes);
+	m_passes.push_back(execute);
+	m_compiled = false;
+}
+
+
+/*
+	- the schedule assigns the physical indices, this frame's targets are found for them here
+	- targets of the last frame are handed on by size and format, so a stable graph creates no targets after its
+	  first frame. The ones nobody takes are released by execute()
+*/
+
+void RenderGraph::compile()
+{
+	m_schedule.compile();
+
+	std::vector<Physical> previous;
+	previous.swap(m_physical);
+	m_physical.resize(m_schedule.getPhysicalCount());
+	for (RenderGraphResource resource = 0; resource < m_resources.size(); resource++)
+	{
+		unsigned int physical = m_schedule.getPhysicalIndex(resource);
+		if (physical != RENDER_GRAPH_NONE)
+			m_physical[physical].m_desc = m_resources[resource].m_desc;
+	}
+
+	for (Physical& target : m_physical)
+	{
+		for (Physical& old : previous)
+		{
+			if (old.m_target.isValid() && old.m_desc == target.m_desc)
+			{
+				target.m_target = old.m_target;
+				old.m_target = RenderTargetHandle();
+				break;
+			}
+		}
+	}
+
+	for (Physical& old : previous)
+	{
+		if (old.m_target.isValid())
+			m_stale.push_back(old.m_target);
+	}
+	m_compiled = true;
+}
+
+
+void RenderGraph::execute(DeviceContext* context)
+{
+	if (!m_compiled)
+		compile();
+
+	for (RenderTargetHandle target : m_stale)
+	{
+		GraphicsEngine::get()->release(target);
+	}
+	m_stale.clear();
+
+	for (Physical& physical : m_physical)
+	{
+		if (physical.m_target.isValid())
+			continue;
+
+		physical.m_target = GraphicsEngine::get()->createRenderTarget(physical.m_desc.m_width, physical.m_desc.m_height, physical.m_desc.m_format);
+		if (!physical.m_target.isValid())
+		{
+			throw std::runtime_error("RenderGraph: render target not created successfully");
+		}
+	}
+
+	RenderGraphContext pass_context(this, context);
+	for (unsigned int index : m_schedule.getOrder())
+	{
+		ProfileMarker marker(m_schedule.getPassName(index));
+		// the targets of the last pass may be written now
+		context->unbindTextures(8);
+		m_passes[index](pass_context);
+	}
+	context->unbindTextures(8);
+}
+
+
+const RenderGraphStats& RenderGraph::getStats()
+{
+	return m_schedule.getStats();
+}
+
+
+unsigned int RenderGraph::getPassCount()
+{
+	return m_schedule.getPassCount();
+}
+
+
+const char* RenderGraph::getPassName(unsigned int pass)
+{
+	return m_schedule.getPassName(pass);
+}
+
+
+bool RenderGraph::isPassCulled(unsigned int pass)
+{
+	return m_schedule.isPassCulled(pass);
+}
+
+
+const std::vector<unsigned int>& RenderGraph::getOrder()
+{
+	return m_schedule.getOrder();
+}
+
+
+unsigned int RenderGraph::getResourceCount()
+{
+	return m_schedule.getResourceCount();
+}
+
+
+const char* RenderGraph::getResourceName(RenderGraphResource resource)
+{
+	return m_schedule.getResourceName(resource);
+}
+
+
+bool RenderGraph::isImported(RenderGraphResource resource)
+{
+	return m_schedule.isImported(resource);
+}
+
+
+unsigned int RenderGraph::getPhysicalIndex(RenderGraphResource resource)
+{
+	return m_schedule.getPhysicalIndex(resource);
+}
+
+
+void RenderGraph::clear()
+{
+	for (Physical& physical : m_physical)
+	{
+		if (physical.m_target.isValid())
+			GraphicsEngine::get()->release(physical.m_target);
+	}
+	for (RenderTargetHandle target : m_stale)
+	{
+		GraphicsEngine::get()->release(target);
+	}
+
+	m_physical.clear();
+	m_stale.clear();
+}
+
+
+size_t RenderGraph::getTextureBytes(const RenderGraphTextureDesc& desc)
+{
+	return (size_t)desc.m_width * desc.m_height * RenderTarget::getBytesPerPixel(desc.m_format);
+}
+
+
+unsigned long long RenderGraph::getAliasKey(const RenderGraphTextureDesc& desc)
+{
+	return ((unsigned long long)desc.m_format << 48) | ((unsigned long long)desc.m_width << 24) | desc.m_height;
+}
@@ -0,0 +1,166 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+#include <functional>
+#include <vector>
+#include "GraphicsEngine.h"
+#include "RenderGraphSchedule.h"
+
+class DeviceContext;
+class SwapChain;
+class RenderGraph;
+
+struct RenderGraphTextureDesc
+{
+	UINT m_width = 0;
+	UINT m_height = 0;
+	DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+
+	bool operator ==(const RenderGraphTextureDesc& desc) const { return m_width == desc.m_width && m_height == desc.m_height && m_format == desc.m_format; }
+};
+
+
+/*
+	what a pass sees while it runs: its resources resolved to physical targets
+*/
+
+class RenderGraphContext
+{
+public:
+
+	RenderGraphContext(RenderGraph* graph, DeviceContext* context);
+
+	DeviceContext* getDeviceContext();
+	// bind the targets and set the viewport to their size. RENDER_GRAPH_NONE for no color or no depth target.
+	// The back buffer is bound without depth, the passes that need depth draw into a transient depth target
+	void setRenderTargets(RenderGraphResource color, RenderGraphResource depth = RENDER_GRAPH_NONE);
+	// color to the color, depth targets to 1
+	void clear(RenderGraphResource target, float red = 0.0f, float green = 0.0f, float blue = 0.0f, float alpha = 1.0f);
+	// read a target in the pixel shader, register t<slot>
+	void setTexture(RenderGraphResource texture, UINT slot);
+
+	// physical target of a transient or the imported texture, nullptr for the back buffer
+	RenderTarget* getRenderTarget(RenderGraphResource resource);
+	UINT getWidth(RenderGraphResource resource);
+	UINT getHeight(RenderGraphResource resource);
+
+private:
+
+	RenderGraph* m_graph;
+	DeviceContext* m_context;
+};
+
+
+/*
+	RenderGraph: the passes of a frame declared with the resources they read and write, instead of one hard-coded sequence
+
+	- rebuilt every frame: reset(), declare resources and passes, compile(), execute()
+	- culling, order and lifetimes are the RenderGraphSchedule's, which has no device and no D3D types. Any declaration
+	  order of independent passes works, a cycle throws. The roots are the passes writing an imported resource (the
+	  back buffer, textures kept across frames like shadow maps)
+	- transient textures only live from the first to the last pass that uses them. D3D11 has no placed resources, so
+	  transients alias by sharing one physical RenderTarget: same size and format, lifetimes that do not overlap.
+	  The physical targets are kept between frames and released when a frame does not need them anymore
+	- compile() does no GPU work. Only execute() creates targets
+*/
+
+class RenderGraph
+{
+public:
+
+	RenderGraph();
+	~RenderGraph();
+
+	// forget the passes and resources of the last frame, the physical targets stay for reuse
+	void reset();
+	// release the physical targets, e.g. on shutdown while the GraphicsEngine still exists
+	void clear();
+
+	// texture that only lives during the frame
+	RenderGraphResource createTexture(const char* name, const RenderGraphTextureDesc& desc);
+	// the back buffer of the swap chain: outlives the frame, so the passes writing it are never culled
+	RenderGraphResource importBackBuffer(const char* name, SwapChain* swap_chain, UINT width, UINT height);
+	// a render target owned outside of the graph, its content stays from frame to frame. Passes writing it are never culled
+	RenderGraphResource importTexture(const char* name, RenderTarget* target);
+
+	void addPass(const char* name, const std::vector<RenderGraphResource>& reads, const std::vector<RenderGraphResource>& writes,
+		const std::function<void(RenderGraphContext& context)>& execute);
+
+	// cull, order, lifetimes and aliasing
+	void compile();
+	// create the physical targets that are missing and run the passes in order
+	void execute(DeviceContext* context);
+
+	const RenderGraphStats& getStats();
+
+	unsigned int getPassCount();
+	const char* getPassName(unsigned int pass);
+	bool isPassCulled(unsigned int pass);
+	// passes that run, in order (indices of the declared passes)
+	const std::vector<unsigned int>& getOrder();
+
+	unsigned int getResourceCount();
+	const char* getResourceName(RenderGraphResource resource);
+	bool isImported(RenderGraphResource resource);
+	// transients with the same physical index share memory, RENDER_GRAPH_NONE when the resource is unused or imported
+	unsigned int getPhysicalIndex(RenderGraphResource resource);
+
+private:
+
+	// what the schedule does not know: the size and format, and where an imported resource lives
+	struct Resource
+	{
+		RenderGraphTextureDesc m_desc;
+		SwapChain* m_swap_chain = nullptr;		// imported back buffer
+		RenderTarget* m_target = nullptr;		// imported texture
+	};
+
+	// one per physical index of the schedule
+	struct Physical
+	{
+		RenderGraphTextureDesc m_desc;
+		RenderTargetHandle m_target;
+	};
+
+	static size_t getTextureBytes(const RenderGraphTextureDesc& desc);
+	// textures alias when their keys are equal: size and format
+	static unsigned long long getAliasKey(const RenderGraphTextureDesc& desc);
+
+private:
+
+	RenderGraphSchedule m_schedule;
+	std::vector<Resource> m_resources;
+	std::vector<std::function<void(RenderGraphContext&)>> m_passes;
+	std::vector<Physical> m_physical;
+	std::vector<RenderTargetHandle> m_stale;	// targets the last compile did not need, released by execute
+	bool m_compiled = false;
+
+private:
+
+	friend class RenderGraphContext;
+};
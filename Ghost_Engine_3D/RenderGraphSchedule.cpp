@@ -0,0 +1,379 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "RenderGraphSchedule.h"
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+
+void RenderGraphSchedule::reset()
+{
+	m_resources.clear();
+	m_passes.clear();
+	m_order.clear();
+	m_physical.clear();
+}
+
+
+RenderGraphResource RenderGraphSchedule::addTransient(const char* name, unsigned long long alias_key, size_t bytes)
+{
+	Resource resource;
+	resource.m_name = name;
+	resource.m_alias_key = alias_key;
+	resource.m_bytes = bytes;
+	m_resources.push_back(resource);
+	return (RenderGraphResource)m_resources.size() - 1;
+}
+
+
+RenderGraphResource RenderGraphSchedule::addImported(const char* name)
+{
+	Resource resource;
+	resource.m_name = name;
+	resource.m_imported = true;
+	m_resources.push_back(resource);
+	return (RenderGraphResource)m_resources.size() - 1;
+}
+
+
+void RenderGraphSchedule::addPass(const char* name, const std::vector<RenderGraphResource>& reads, const std::vector<RenderGraphResource>& writes)
+{
+	// checked before the pass is entered anywhere: a rejected pass leaves the graph as it was
+	for (RenderGraphResource resource : reads)
+	{
+		if (resource >= m_resources.size())
+		{
+			throw std::runtime_error("RenderGraph: pass reads an unknown resource");
+		}
+	}
+	for (RenderGraphResource resource : writes)
+	{
+		if (resource >= m_resources.size())
+		{
+			throw std::runtime_error("RenderGraph: pass writes an unknown resource");
+		}
+	}
+
+	unsigned int index = (unsigned int)m_passes.size();
+	for (RenderGraphResource resource : reads)
+	{
+		m_resources[resource].m_readers.push_back(index);
+	}
+	for (RenderGraphResource resource : writes)
+	{
+		m_resources[resource].m_writers.push_back(index);
+	}
+
+	Pass pass;
+	pass.m_name = name;
+	pass.m_reads = reads;
+	pass.m_writes = writes;
+	m_passes.push_back(pass);
+}
+
+
+void RenderGraphSchedule::compile()
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	m_stats = RenderGraphStats();
+	cull();
+	sort();
+	alias();
+
+	m_stats.m_passes = (unsigned int)m_passes.size();
+	m_stats.m_passes_culled = m_stats.m_passes - (unsigned int)m_order.size();
+	m_stats.m_compile_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+/*
+	walk back from the roots: a pass that runs needs the writers of what it reads.
+	For a resource the pass also writes (read-modify-write) that are only the writers declared before it
+*/
+
+void RenderGraphSchedule::cull()
+{
+	std::vector<unsigned int> stack;
+	for (Pass& pass : m_passes)
+	{
+		pass.m_culled = true;
+	}
+
+	for (unsigned int i = 0; i < m_passes.size(); i++)
+	{
+		for (RenderGraphResource resource : m_passes[i].m_writes)
+		{
+			if (isImported(resource) && m_passes[i].m_culled)
+			{
+				m_passes[i].m_culled = false;
+				stack.push_back(i);
+			}
+		}
+	}
+
+	while (!stack.empty())
+	{
+		unsigned int pass = stack.back();
+		stack.pop_back();
+
+		for (RenderGraphResource resource : m_passes[pass].m_reads)
+		{
+			const std::vector<unsigned int>& writers = m_resources[resource].m_writers;
+			bool modifies = std::find(writers.begin(), writers.end(), pass) != writers.end();
+
+			for (unsigned int writer : writers)
+			{
+				if (modifies && writer >= pass)
+					break;
+				if (writer == pass || !m_passes[writer].m_culled)
+					continue;
+
+				m_passes[writer].m_culled = false;
+				stack.push_back(writer);
+			}
+		}
+	}
+}
+
+
+/*
+	topological order (Kahn) of the passes that run. Edges:
+	- writers of a resource in the order they were declared
+	- every writer before a pass that only reads the resource
+	From the ready passes the one declared first runs first -> the order is stable from frame to frame
+*/
+
+void RenderGraphSchedule::sort()
+{
+	std::vector<std::vector<unsigned int>> successors(m_passes.size());
+	std::vector<unsigned int> dependencies(m_passes.size(), 0);
+
+	auto addEdge = [&](unsigned int from, unsigned int to)
+		{
+			if (from == to || m_passes[from].m_culled || m_passes[to].m_culled)
+				return;
+
+			successors[from].push_back(to);
+			dependencies[to]++;
+		};
+
+	for (Resource& resource : m_resources)
+	{
+		for (size_t i = 1; i < resource.m_writers.size(); i++)
+		{
+			addEdge(resource.m_writers[i - 1], resource.m_writers[i]);
+		}
+
+		for (unsigned int reader : resource.m_readers)
+		{
+			if (std::find(resource.m_writers.begin(), resource.m_writers.end(), reader) != resource.m_writers.end())
+				continue;
+
+			for (unsigned int writer : resource.m_writers)
+			{
+				addEdge(writer, reader);
+			}
+		}
+	}
+
+	m_order.clear();
+	std::vector<bool> done(m_passes.size(), false);
+	unsigned int alive = 0;
+	for (Pass& pass : m_passes)
+	{
+		if (!pass.m_culled)
+			alive++;
+	}
+
+	while (m_order.size() < alive)
+	{
+		unsigned int next = RENDER_GRAPH_NONE;
+		for (unsigned int i = 0; i < m_passes.size(); i++)
+		{
+			if (!m_passes[i].m_culled && !done[i] && !dependencies[i])
+			{
+				next = i;
+				break;
+			}
+		}
+
+		if (next == RENDER_GRAPH_NONE)
+		{
+			throw std::runtime_error("RenderGraph: the passes depend on each other in a cycle");
+		}
+
+		done[next] = true;
+		m_order.push_back(next);
+		for (unsigned int successor : successors[next])
+		{
+			dependencies[successor]--;
+		}
+	}
+}
+
+
+void RenderGraphSchedule::alias()
+{
+	for (Resource& resource : m_resources)
+	{
+		resource.m_first = RENDER_GRAPH_NONE;
+		resource.m_last = 0;
+		resource.m_physical = RENDER_GRAPH_NONE;
+	}
+
+	for (unsigned int position = 0; position < m_order.size(); position++)
+	{
+		Pass& pass = m_passes[m_order[position]];
+		for (int list = 0; list < 2; list++)
+		{
+			for (RenderGraphResource index : list ? pass.m_writes : pass.m_reads)
+			{
+				Resource& resource = m_resources[index];
+				resource.m_first = std::min(resource.m_first, position);
+				resource.m_last = std::max(resource.m_last, position);
+			}
+		}
+	}
+
+	std::vector<RenderGraphResource> transients;
+	for (unsigned int i = 0; i < m_resources.size(); i++)
+	{
+		if (!isImported(i) && m_resources[i].m_first != RENDER_GRAPH_NONE)
+			transients.push_back(i);
+	}
+	std::stable_sort(transients.begin(), transients.end(), [&](RenderGraphResource a, RenderGraphResource b)
+		{
+			return m_resources[a].m_first < m_resources[b].m_first;
+		});
+
+	m_physical.clear();
+	for (RenderGraphResource index : transients)
+	{
+		Resource& resource = m_resources[index];
+		unsigned int physical = RENDER_GRAPH_NONE;
+		for (unsigned int i = 0; i < m_physical.size(); i++)
+		{
+			if (m_physical[i].m_alias_key == resource.m_alias_key && m_physical[i].m_busy_until < resource.m_first)
+			{
+				physical = i;
+				break;
+			}
+		}
+
+		if (physical == RENDER_GRAPH_NONE)
+		{
+			Physical target;
+			target.m_alias_key = resource.m_alias_key;
+			target.m_bytes = resource.m_bytes;
+			physical = (unsigned int)m_physical.size();
+			m_physical.push_back(target);
+		}
+
+		m_physical[physical].m_busy_until = resource.m_last;
+		resource.m_physical = physical;
+		m_stats.m_transient_bytes += resource.m_bytes;
+	}
+
+	m_stats.m_transients = (unsigned int)transients.size();
+	m_stats.m_physical_targets = (unsigned int)m_physical.size();
+	for (Physical& physical : m_physical)
+	{
+		m_stats.m_physical_bytes += physical.m_bytes;
+	}
+
+	for (unsigned int position = 0; position < m_order.size(); position++)
+	{
+		size_t live = 0;
+		for (RenderGraphResource index : transients)
+		{
+			if (m_resources[index].m_first <= position && position <= m_resources[index].m_last)
+				live += m_resources[index].m_bytes;
+		}
+		m_stats.m_peak_live_bytes = std::max(m_stats.m_peak_live_bytes, live);
+	}
+}
+
+
+const RenderGraphStats& RenderGraphSchedule::getStats()
+{
+	return m_stats;
+}
+
+
+unsigned int RenderGraphSchedule::getPassCount()
+{
+	return (unsigned int)m_passes.size();
+}
+
+
+const char* RenderGraphSchedule::getPassName(unsigned int pass)
+{
+	return m_passes[pass].m_name;
+}
+
+
+bool RenderGraphSchedule::isPassCulled(unsigned int pass)
+{
+	return m_passes[pass].m_culled;
+}
+
+
+const std::vector<unsigned int>& RenderGraphSchedule::getOrder()
+{
+	return m_order;
+}
+
+
+unsigned int RenderGraphSchedule::getResourceCount()
+{
+	return (unsigned int)m_resources.size();
+}
+
+
+const char* RenderGraphSchedule::getResourceName(RenderGraphResource resource)
+{
+	return m_resources[resource].m_name;
+}
+
+
+bool RenderGraphSchedule::isImported(RenderGraphResource resource)
+{
+	return m_resources[resource].m_imported;
+}
+
+
+unsigned int RenderGraphSchedule::getPhysicalIndex(RenderGraphResource resource)
+{
+	return m_resources[resource].m_physical;
+}
+
+
+unsigned int RenderGraphSchedule::getPhysicalCount()
+{
+	return (unsigned int)m_physical.size();
+}
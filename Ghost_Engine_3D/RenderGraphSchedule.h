@@ -0,0 +1,132 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// resource of the graph of the current frame: index into its resources
+typedef unsigned int RenderGraphResource;
+static const RenderGraphResource RENDER_GRAPH_NONE = 0xffffffff;
+
+struct RenderGraphStats
+{
+	unsigned int m_passes = 0;
+	unsigned int m_passes_culled = 0;
+	unsigned int m_transients = 0;				// transient textures used by the passes that run
+	unsigned int m_physical_targets = 0;		// render targets they were aliased into
+	size_t m_transient_bytes = 0;				// every transient with its own memory
+	size_t m_physical_bytes = 0;				// memory of the physical targets
+	size_t m_peak_live_bytes = 0;				// most transient memory alive during one pass
+	double m_compile_ms = 0.0;
+};
+
+
+/*
+	RenderGraphSchedule: the device free part of the RenderGraph. Which passes run, in which order, and which transient
+	textures share a physical target
+
+	- only std headers: no device, no D3D types. A transient is a name, an alias key (textures alias only with an equal
+	  key, RenderGraph uses size and format) and its bytes
+	- culling: the passes writing an imported resource are the roots and always run. Any other pass only runs when a
+	  pass that runs reads what it writes
+	- order: the writers of a resource run in the order they were declared, a pass that only reads a resource runs after
+	  all of its writers. From the ready passes the one declared first runs first. A cycle throws
+	- lifetime of a transient: positions of the first and the last pass in the order that use it. Transients sorted by
+	  their start take the first physical index with the same key that is free again (its last user ran before)
+*/
+
+class RenderGraphSchedule
+{
+public:
+
+	// forget the passes and resources
+	void reset();
+
+	RenderGraphResource addTransient(const char* name, unsigned long long alias_key, size_t bytes);
+	RenderGraphResource addImported(const char* name);
+	void addPass(const char* name, const std::vector<RenderGraphResource>& reads, const std::vector<RenderGraphResource>& writes);
+
+	// cull, order, lifetimes and aliasing
+	void compile();
+
+	const RenderGraphStats& getStats();
+
+	unsigned int getPassCount();
+	const char* getPassName(unsigned int pass);
+	bool isPassCulled(unsigned int pass);
+	// passes that run, in order (indices of the declared passes)
+	const std::vector<unsigned int>& getOrder();
+
+	unsigned int getResourceCount();
+	const char* getResourceName(RenderGraphResource resource);
+	bool isImported(RenderGraphResource resource);
+	// transients with the same physical index share memory, RENDER_GRAPH_NONE when the resource is unused or imported
+	unsigned int getPhysicalIndex(RenderGraphResource resource);
+	unsigned int getPhysicalCount();
+
+private:
+
+	struct Resource
+	{
+		const char* m_name = nullptr;
+		unsigned long long m_alias_key = 0;
+		size_t m_bytes = 0;
+		bool m_imported = false;
+		std::vector<unsigned int> m_writers;
+		std::vector<unsigned int> m_readers;	// a pass that reads and writes the resource is in both
+		unsigned int m_first = 0;				// position in the order of the first and last pass using it
+		unsigned int m_last = 0;
+		unsigned int m_physical = RENDER_GRAPH_NONE;
+	};
+
+	struct Pass
+	{
+		const char* m_name = nullptr;
+		std::vector<RenderGraphResource> m_reads;
+		std::vector<RenderGraphResource> m_writes;
+		bool m_culled = false;
+	};
+
+	struct Physical
+	{
+		unsigned long long m_alias_key = 0;
+		size_t m_bytes = 0;
+		unsigned int m_busy_until = 0;			// last position of the resources assigned to it
+	};
+
+	void cull();
+	void sort();
+	void alias();
+
+private:
+
+	std::vector<Resource> m_resources;
+	std::vector<Pass> m_passes;
+	std::vector<unsigned int> m_order;
+	std::vector<Physical> m_physical;
+	RenderGraphStats m_stats;
+};
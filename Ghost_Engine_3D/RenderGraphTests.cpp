@@ -0,0 +1,259 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "RenderGraphSchedule.h"
+#include <cstdio>
+#include <stdexcept>
+
+/*
+	RenderGraphTests: checks of the device free part of the render graph (RenderGraphSchedule), no window or device
+
+		RenderGraphTests
+
+	- every test prints the checks that fail, the exit code is the number of failed checks -> 0 means everything passed
+	- the RenderGraph of the game hands its passes and resources to the same schedule, so the culling, order and
+	  aliasing tested here are the ones of a frame
+*/
+
+static unsigned int s_failures = 0;
+
+#define CHECK(condition) check(condition, #condition, __LINE__)
+
+static void check(bool condition, const char* text, int line)
+{
+	if (condition)
+		return;
+
+	printf("  failed (line %d): %s\n", line, text);
+	s_failures++;
+}
+
+
+static bool isOrder(RenderGraphSchedule& schedule, const std::vector<unsigned int>& order)
+{
+	return schedule.getOrder() == order;
+}
+
+
+// writers before readers, a pass declared before the pass it reads from still runs after it
+static void testOrder()
+{
+	printf("order\n");
+
+	RenderGraphSchedule schedule;
+	RenderGraphResource back_buffer = schedule.addImported("Back Buffer");
+	RenderGraphResource color = schedule.addTransient("Color", 1, 100);
+	RenderGraphResource bloom = schedule.addTransient("Bloom", 1, 100);
+
+	schedule.addPass("Composite", { color, bloom }, { back_buffer });		// 0
+	schedule.addPass("Bloom", { color }, { bloom });						// 1
+	schedule.addPass("Scene", {}, { color });								// 2
+	schedule.compile();
+
+	CHECK(isOrder(schedule, { 2, 1, 0 }));
+
+	// read-modify-write: the writers of a resource run in the order they were declared
+	schedule.reset();
+	back_buffer = schedule.addImported("Back Buffer");
+	color = schedule.addTransient("Color", 1, 100);
+	schedule.addPass("Clear", {}, { color });								// 0
+	schedule.addPass("Opaque", { color }, { color });						// 1
+	schedule.addPass("Transparent", { color }, { color });					// 2
+	schedule.addPass("Present", { color }, { back_buffer });				// 3
+	schedule.compile();
+
+	CHECK(isOrder(schedule, { 0, 1, 2, 3 }));
+
+	// independent passes keep the order they were declared in: the schedule is the same every frame
+	schedule.reset();
+	back_buffer = schedule.addImported("Back Buffer");
+	RenderGraphResource a = schedule.addTransient("A", 1, 100);
+	RenderGraphResource b = schedule.addTransient("B", 1, 100);
+	schedule.addPass("Write B", {}, { b });									// 0
+	schedule.addPass("Write A", {}, { a });									// 1
+	schedule.addPass("Combine", { a, b }, { back_buffer });					// 2
+	schedule.compile();
+
+	CHECK(isOrder(schedule, { 0, 1, 2 }));
+}
+
+
+// a pass only runs when a pass that runs reads what it writes, the roots write imported resources
+static void testCulling()
+{
+	printf("culling\n");
+
+	RenderGraphSchedule schedule;
+	RenderGraphResource back_buffer = schedule.addImported("Back Buffer");
+	RenderGraphResource shadow_map = schedule.addImported("Shadow Map");
+	RenderGraphResource color = schedule.addTransient("Color", 1, 100);
+	RenderGraphResource debug = schedule.addTransient("Debug", 1, 100);
+	RenderGraphResource debug_blur = schedule.addTransient("Debug Blur", 1, 100);
+
+	schedule.addPass("Scene", {}, { color });								// 0
+	schedule.addPass("Debug", { color }, { debug });						// 1: only read by a culled pass
+	schedule.addPass("Debug Blur", { debug }, { debug_blur });				// 2: read by nobody
+	schedule.addPass("Shadows", {}, { shadow_map });						// 3: imported, always runs
+	schedule.addPass("Composite", { color }, { back_buffer });				// 4
+	schedule.compile();
+
+	CHECK(!schedule.isPassCulled(0));
+	CHECK(schedule.isPassCulled(1));
+	CHECK(schedule.isPassCulled(2));
+	CHECK(!schedule.isPassCulled(3));
+	CHECK(!schedule.isPassCulled(4));
+	CHECK(isOrder(schedule, { 0, 3, 4 }));
+	CHECK(schedule.getStats().m_passes == 5);
+	CHECK(schedule.getStats().m_passes_culled == 2);
+
+	// the resources of culled passes get no memory
+	CHECK(schedule.getPhysicalIndex(debug) == RENDER_GRAPH_NONE);
+	CHECK(schedule.getPhysicalIndex(debug_blur) == RENDER_GRAPH_NONE);
+	CHECK(schedule.getPhysicalIndex(back_buffer) == RENDER_GRAPH_NONE);
+
+	// a writer declared after a read-modify-write pass is not needed by it
+	schedule.reset();
+	back_buffer = schedule.addImported("Back Buffer");
+	color = schedule.addTransient("Color", 1, 100);
+	schedule.addPass("Scene", {}, { color });								// 0
+	schedule.addPass("Present", { color }, { color, back_buffer });			// 1
+	schedule.addPass("Late", {}, { color });								// 2
+	schedule.compile();
+
+	CHECK(isOrder(schedule, { 0, 1 }));
+	CHECK(schedule.isPassCulled(2));
+}
+
+
+// transients share a physical target when their alias keys are equal and their lifetimes do not overlap
+static void testAliasing()
+{
+	printf("aliasing\n");
+
+	RenderGraphSchedule schedule;
+	RenderGraphResource back_buffer = schedule.addImported("Back Buffer");
+	RenderGraphResource a = schedule.addTransient("A", 1, 100);
+	RenderGraphResource b = schedule.addTransient("B", 1, 100);
+	RenderGraphResource c = schedule.addTransient("C", 1, 100);
+	RenderGraphResource depth = schedule.addTransient("Depth", 2, 40);
+
+	schedule.addPass("A", {}, { a });										// lifetime of a: 0 - 1
+	schedule.addPass("B", { a }, { b });									// b: 1 - 2
+	schedule.addPass("C", { b }, { c });									// c: 2 - 3
+	schedule.addPass("Depth", { c }, { depth });							// depth: 3 - 4, other key
+	schedule.addPass("Present", { depth }, { back_buffer });
+	schedule.compile();
+
+	// a is dead when c starts, b overlaps both
+	CHECK(schedule.getPhysicalIndex(a) == schedule.getPhysicalIndex(c));
+	CHECK(schedule.getPhysicalIndex(a) != schedule.getPhysicalIndex(b));
+	CHECK(schedule.getPhysicalIndex(b) != schedule.getPhysicalIndex(c));
+	CHECK(schedule.getPhysicalIndex(depth) != schedule.getPhysicalIndex(a));
+	CHECK(schedule.getPhysicalIndex(depth) != schedule.getPhysicalIndex(b));
+	CHECK(schedule.getPhysicalCount() == 3);
+
+	const RenderGraphStats& stats = schedule.getStats();
+	CHECK(stats.m_transients == 4);
+	CHECK(stats.m_physical_targets == 3);
+	CHECK(stats.m_transient_bytes == 340);
+	CHECK(stats.m_physical_bytes == 240);
+	CHECK(stats.m_peak_live_bytes == 200);
+
+	// a resource used by only one pass ends where it starts: the next one may take its target
+	schedule.reset();
+	back_buffer = schedule.addImported("Back Buffer");
+	a = schedule.addTransient("A", 1, 100);
+	b = schedule.addTransient("B", 1, 100);
+	schedule.addPass("A", {}, { a, back_buffer });
+	schedule.addPass("B", {}, { b, back_buffer });
+	schedule.compile();
+
+	CHECK(schedule.getPhysicalIndex(a) == schedule.getPhysicalIndex(b));
+	CHECK(schedule.getStats().m_physical_bytes == 100);
+}
+
+
+// passes that depend on each other can not be ordered, resources that do not exist can not be used
+static void testRejection()
+{
+	printf("rejection\n");
+
+	RenderGraphSchedule schedule;
+	RenderGraphResource back_buffer = schedule.addImported("Back Buffer");
+	RenderGraphResource a = schedule.addTransient("A", 1, 100);
+	RenderGraphResource b = schedule.addTransient("B", 1, 100);
+
+	// P reads b that R writes, R reads a that P writes: P and R wait for each other
+	schedule.addPass("P", { b }, { a, back_buffer });
+	schedule.addPass("R", { a }, { b, back_buffer });
+
+	bool cycle = false;
+	try
+	{
+		schedule.compile();
+	}
+	catch (const std::runtime_error&)
+	{
+		cycle = true;
+	}
+	CHECK(cycle);
+
+	// a rejected pass leaves the graph as it was
+	schedule.reset();
+	back_buffer = schedule.addImported("Back Buffer");
+	schedule.addPass("Present", {}, { back_buffer });
+
+	bool unknown = false;
+	try
+	{
+		schedule.addPass("Broken", { back_buffer + 5 }, { back_buffer });
+	}
+	catch (const std::runtime_error&)
+	{
+		unknown = true;
+	}
+	CHECK(unknown);
+	CHECK(schedule.getPassCount() == 1);
+
+	schedule.compile();
+	CHECK(isOrder(schedule, { 0 }));
+}
+
+
+int main()
+{
+	testOrder();
+	testCulling();
+	testAliasing();
+	testRejection();
+
+	if (s_failures)
+		printf("%u checks failed\n", s_failures);
+	else
+		printf("all checks passed\n");
+
+	return (int)s_failures;
+}
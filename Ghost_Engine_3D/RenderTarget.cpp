@@ -0,0 +1,139 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "RenderTarget.h"
+#include "GraphicsEngine.h"
+
+#include <exception>
+
+/*
+	- a depth texture cannot be read with its depth format -> the texture is R32_TYPELESS, the depth view D32_FLOAT
+	  and the shader resource view R32_FLOAT
+*/
+
+RenderTarget::RenderTarget(UINT width, UINT height, DXGI_FORMAT format) :m_width(width), m_height(height), m_format(format)
+{
+	ID3D11Device* device = GraphicsEngine::get()->m_d3d_device;
+	bool depth = isDepth();
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = width;
+	desc.Height = height;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = depth ? DXGI_FORMAT_R32_TYPELESS : format;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | (depth ? D3D11_BIND_DEPTH_STENCIL : D3D11_BIND_RENDER_TARGET);
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags = 0;
+
+	if (FAILED(device->CreateTexture2D(&desc, nullptr, &m_texture)))
+	{
+		throw std::exception("Create Render Target was not successful");
+	}
+
+	HRESULT hr = 0;
+	if (depth)
+	{
+		D3D11_DEPTH_STENCIL_VIEW_DESC dsv_desc = {};
+		dsv_desc.Format = DXGI_FORMAT_D32_FLOAT;
+		dsv_desc.ViewDimension = D3D11_DSV_DIMENSION_TEXTURE2D;
+		hr = device->CreateDepthStencilView(m_texture, &dsv_desc, &m_dsv);
+	}
+	else
+	{
+		hr = device->CreateRenderTargetView(m_texture, nullptr, &m_rtv);
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+	srv_desc.Format = depth ? DXGI_FORMAT_R32_FLOAT : format;
+	srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	srv_desc.Texture2D.MipLevels = 1;
+
+	if (FAILED(hr) || FAILED(device->CreateShaderResourceView(m_texture, &srv_desc, &m_srv)))
+	{
+		if (m_rtv) m_rtv->Release();
+		if (m_dsv) m_dsv->Release();
+		m_texture->Release();
+		throw std::exception("Create Render Target View was not successful");
+	}
+}
+
+
+UINT RenderTarget::getWidth()
+{
+	return m_width;
+}
+
+UINT RenderTarget::getHeight()
+{
+	return m_height;
+}
+
+DXGI_FORMAT RenderTarget::getFormat()
+{
+	return m_format;
+}
+
+bool RenderTarget::isDepth()
+{
+	return m_format == DXGI_FORMAT_D32_FLOAT;
+}
+
+
+UINT RenderTarget::getBytesPerPixel(DXGI_FORMAT format)
+{
+	switch (format)
+	{
+	case DXGI_FORMAT_R32G32B32A32_FLOAT: return 16;
+	case DXGI_FORMAT_R16G16B16A16_FLOAT:
+	case DXGI_FORMAT_R16G16B16A16_UNORM:
+	case DXGI_FORMAT_R32G32_FLOAT: return 8;
+	case DXGI_FORMAT_R8G8B8A8_UNORM:
+	case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+	case DXGI_FORMAT_B8G8R8A8_UNORM:
+	case DXGI_FORMAT_R10G10B10A2_UNORM:
+	case DXGI_FORMAT_R11G11B10_FLOAT:
+	case DXGI_FORMAT_R16G16_FLOAT:
+	case DXGI_FORMAT_R32_FLOAT:
+	case DXGI_FORMAT_D32_FLOAT: return 4;
+	case DXGI_FORMAT_R16_FLOAT:
+	case DXGI_FORMAT_R8G8_UNORM: return 2;
+	case DXGI_FORMAT_R8_UNORM: return 1;
+	default: return 0;
+	}
+}
+
+
+RenderTarget::~RenderTarget()
+{
+	if (m_srv) m_srv->Release();
+	if (m_rtv) m_rtv->Release();
+	if (m_dsv) m_dsv->Release();
+	if (m_texture) m_texture->Release();
+}
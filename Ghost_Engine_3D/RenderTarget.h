@@ -0,0 +1,69 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+
+class DeviceContext;
+
+/*
+	RenderTarget: a texture the GPU draws into and later reads from
+
+	- a color format gets a render target view, DXGI_FORMAT_D32_FLOAT a depth stencil view. Both get a shader resource view
+	  (the depth texture is created typeless for it)
+	- created through GraphicsEngine::createRenderTarget, usually by RenderGraph for its transient resources
+*/
+
+class RenderTarget
+{
+public:
+
+	RenderTarget(UINT width, UINT height, DXGI_FORMAT format);
+	~RenderTarget();
+
+	UINT getWidth();
+	UINT getHeight();
+	DXGI_FORMAT getFormat();
+	bool isDepth();
+
+	// memory of one texel, 0 for formats a render target does not use
+	static UINT getBytesPerPixel(DXGI_FORMAT format);
+
+private:
+
+	ID3D11Texture2D* m_texture = nullptr;
+	ID3D11RenderTargetView* m_rtv = nullptr;
+	ID3D11DepthStencilView* m_dsv = nullptr;
+	ID3D11ShaderResourceView* m_srv = nullptr;
+
+	UINT m_width = 0;
+	UINT m_height = 0;
+	DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+
+private:
+
+	friend class DeviceContext;
+};
@@ -0,0 +1,265 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+/*
+	32-bit generational handle of a resource stored in a ResourcePool
+
+		| generation (12 bits) | slot index (20 bits) |
+
+	- the generation of a slot is increased each time its resource is destroyed. A handle that still carries the old generation
+	  is "stale" and resolves to nullptr instead of pointing to a new resource that reuses the same slot
+	- generation 0 is never used -> a handle with id 0 is always invalid
+	- template parameter T only makes handles of different resource types incompatible with each other
+*/
+
+template <class T>
+class ResourceHandle
+{
+public:
+	static const unsigned int INDEX_BITS = 20;
+	static const unsigned int INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const unsigned int GENERATION_MASK = (1u << (32 - INDEX_BITS)) - 1;
+
+public:
+	ResourceHandle() :m_id(0)
+	{
+	}
+
+	ResourceHandle(unsigned int index, unsigned int generation) :m_id((generation << INDEX_BITS) | (index & INDEX_MASK))
+	{
+	}
+
+	bool isValid() const { return m_id != 0; }
+	unsigned int getIndex() const { return m_id & INDEX_MASK; }
+	unsigned int getGeneration() const { return m_id >> INDEX_BITS; }
+
+	bool operator ==(const ResourceHandle& handle) const { return m_id == handle.m_id; }
+	bool operator !=(const ResourceHandle& handle) const { return m_id != handle.m_id; }
+
+public:
+	unsigned int m_id;
+};
+
+
+/*
+	Dense typed pool of resources addressed by ResourceHandle
+
+	- resources are constructed in place in pages of PAGE_SIZE slots. Pages are never moved or freed before the pool is destroyed,
+	  so resources of the same type stay next to each other in memory and a pointer returned by get() stays valid until the resource is destroyed
+	- get() is O(1): page table lookup + generation compare, without any lock
+	- create() only locks to reserve a slot. The constructor of T runs outside of the lock -> several threads can create resources at the same time
+	- destroy() is deferred: the resource stays resolvable until flush() is called at the end of the frame, so a frame that is still
+	  using it is never left with a dangling pointer
+*/
+
+template <class T>
+class ResourcePool
+{
+public:
+	typedef ResourceHandle<T> Handle;
+
+	static const unsigned int PAGE_BITS = 8;
+	static const unsigned int PAGE_SIZE = 1u << PAGE_BITS;
+	static const unsigned int MAX_PAGES = (Handle::INDEX_MASK + 1) / PAGE_SIZE;
+
+public:
+	ResourcePool()
+	{
+		for (unsigned int i = 0; i < MAX_PAGES; i++)
+		{
+			m_pages[i].store(nullptr, std::memory_order_relaxed);
+		}
+	}
+
+	// construct a new resource with the given constructor arguments. Exceptions of the constructor are passed to the caller
+	template <class... Args>
+	Handle create(Args&&... args)
+	{
+		unsigned int index = allocateSlot();
+		Slot& slot = getSlot(index);
+
+		try
+		{
+			new (slot.m_storage) T(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_free.push_back(index);
+			throw;
+		}
+
+		slot.m_alive.store(true, std::memory_order_release);
+		return Handle(index, slot.m_generation.load(std::memory_order_relaxed));
+	}
+
+	// return the resource or nullptr when the handle is invalid or stale
+	T* get(Handle handle) const
+	{
+		if (!handle.isValid())
+			return nullptr;
+
+		Slot* page = m_pages[handle.getIndex() >> PAGE_BITS].load(std::memory_order_acquire);
+		if (!page)
+			return nullptr;
+
+		const Slot& slot = page[handle.getIndex() & (PAGE_SIZE - 1)];
+		if (!slot.m_alive.load(std::memory_order_acquire) || slot.m_generation.load(std::memory_order_relaxed) != handle.getGeneration())
+			return nullptr;
+
+		return (T*)slot.m_storage;
+	}
+
+	// mark the resource to be destroyed at the next flush(). Stale handles and handles destroyed twice are ignored
+	void destroy(Handle handle)
+	{
+		if (!get(handle))
+			return;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		Slot& slot = getSlot(handle.getIndex());
+		if (slot.m_pending)
+			return;
+
+		slot.m_pending = true;
+		m_pending.push_back(handle.getIndex());
+	}
+
+	// destroy all resources that were marked with destroy(). Called once per frame when the GPU work of the frame is submitted
+	void flush()
+	{
+		std::vector<unsigned int> pending;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			pending.swap(m_pending);
+		}
+
+		for (size_t i = 0; i < pending.size(); i++)
+		{
+			destroySlot(pending[i]);
+		}
+	}
+
+	// destroy every resource that is still alive (shutdown)
+	void clear()
+	{
+		flush();
+
+		unsigned int count = 0;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			count = m_next_index;
+		}
+
+		for (unsigned int i = 0; i < count; i++)
+		{
+			if (getSlot(i).m_alive.load(std::memory_order_acquire))
+				destroySlot(i);
+		}
+	}
+
+	// number of resources currently alive
+	unsigned int getCount() const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_next_index - (unsigned int)m_free.size();
+	}
+
+	~ResourcePool()
+	{
+		clear();
+
+		for (unsigned int i = 0; i < MAX_PAGES; i++)
+		{
+			delete[] m_pages[i].load(std::memory_order_relaxed);
+		}
+	}
+
+private:
+	struct Slot
+	{
+		alignas(T) unsigned char m_storage[sizeof(T)];
+		std::atomic<unsigned int> m_generation{ 1 };
+		std::atomic<bool> m_alive{ false };
+		bool m_pending = false;
+	};
+
+	Slot& getSlot(unsigned int index) const
+	{
+		return m_pages[index >> PAGE_BITS].load(std::memory_order_acquire)[index & (PAGE_SIZE - 1)];
+	}
+
+	unsigned int allocateSlot()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (!m_free.empty())
+		{
+			unsigned int index = m_free.back();
+			m_free.pop_back();
+			return index;
+		}
+
+		if (m_next_index > Handle::INDEX_MASK)
+			throw std::bad_alloc();
+
+		unsigned int page = m_next_index >> PAGE_BITS;
+		if (!m_pages[page].load(std::memory_order_relaxed))
+			m_pages[page].store(new Slot[PAGE_SIZE], std::memory_order_release);
+
+		return m_next_index++;
+	}
+
+	void destroySlot(unsigned int index)
+	{
+		Slot& slot = getSlot(index);
+
+		// invalidate all handles first, then destroy the object outside of the lock (its destructor may release other resources)
+		slot.m_alive.store(false, std::memory_order_release);
+		((T*)slot.m_storage)->~T();
+
+		unsigned int generation = (slot.m_generation.load(std::memory_order_relaxed) + 1) & Handle::GENERATION_MASK;
+		slot.m_generation.store(generation ? generation : 1, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		slot.m_pending = false;
+		m_free.push_back(index);
+	}
+
+private:
+	std::atomic<Slot*> m_pages[MAX_PAGES];
+	std::vector<unsigned int> m_free;
+	std::vector<unsigned int> m_pending;
+	unsigned int m_next_index = 0;
+	mutable std::mutex m_mutex;
+};
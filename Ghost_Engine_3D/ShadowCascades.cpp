@@ -0,0 +1,236 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "ShadowCascades.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+// 0: uniform splits, 1: logarithmic splits
+static const float CASCADE_SPLIT_LAMBDA = 0.8f;
+// the box size is rounded up to this fraction of the size around the whole frustum part
+static const float CASCADE_SIZE_STEPS = 16.0f;
+
+
+Vector3D ShadowCascades::toLight(const Vector3D& point)
+{
+	const Matrix4x4& r = m_light_rotation;
+	return Vector3D(
+		point.m_x * r.m_mat[0][0] + point.m_y * r.m_mat[1][0] + point.m_z * r.m_mat[2][0],
+		point.m_x * r.m_mat[0][1] + point.m_y * r.m_mat[1][1] + point.m_z * r.m_mat[2][1],
+		point.m_x * r.m_mat[0][2] + point.m_y * r.m_mat[1][2] + point.m_z * r.m_mat[2][2]);
+}
+
+
+/*
+	- light space: z along the light, x and y across it. The rotation is the same for all cascades
+	- the camera frustum part of a cascade: the corners at its near and far split depth, x = +-depth / x_scale of the
+	  projection, back to world space with the inverse view
+*/
+
+void ShadowCascades::fit(const Matrix4x4& view, const Matrix4x4& proj, const Vector3D& light_direction, const Vector3D& scene_min, const Vector3D& scene_max,
+	float shadow_distance, ShadowCascade cascades[CASCADE_COUNT])
+{
+	Vector3D z = light_direction * (1.0f / std::max(light_direction.length(), 0.0001f));
+	Vector3D up = fabsf(z.m_y) > 0.99f ? Vector3D(1.0f, 0.0f, 0.0f) : Vector3D(0.0f, 1.0f, 0.0f);
+	Vector3D x = Vector3D::cross(up, z);
+	x = x * (1.0f / x.length());
+	Vector3D y = Vector3D::cross(z, x);
+
+	m_light_rotation.setIdentity();
+	m_light_rotation.m_mat[0][0] = x.m_x; m_light_rotation.m_mat[0][1] = y.m_x; m_light_rotation.m_mat[0][2] = z.m_x;
+	m_light_rotation.m_mat[1][0] = x.m_y; m_light_rotation.m_mat[1][1] = y.m_y; m_light_rotation.m_mat[1][2] = z.m_y;
+	m_light_rotation.m_mat[2][0] = x.m_z; m_light_rotation.m_mat[2][1] = y.m_z; m_light_rotation.m_mat[2][2] = z.m_z;
+
+	Vector3D scene_corners[8];
+	for (int i = 0; i < 8; i++)
+	{
+		scene_corners[i] = Vector3D((i & 1) ? scene_max.m_x : scene_min.m_x, (i & 2) ? scene_max.m_y : scene_min.m_y, (i & 4) ? scene_max.m_z : scene_min.m_z);
+	}
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		m_scene_min[axis] = FLT_MAX;
+		m_scene_max[axis] = -FLT_MAX;
+	}
+	for (const Vector3D& corner : scene_corners)
+	{
+		Vector3D p = toLight(corner);
+		float values[3] = { p.m_x, p.m_y, p.m_z };
+		for (int axis = 0; axis < 3; axis++)
+		{
+			m_scene_min[axis] = std::min(m_scene_min[axis], values[axis]);
+			m_scene_max[axis] = std::max(m_scene_max[axis], values[axis]);
+		}
+	}
+
+	float x_scale = proj.m_mat[0][0];
+	float y_scale = proj.m_mat[1][1];
+	float z_near = -proj.m_mat[3][2] / proj.m_mat[2][2];
+	float z_far = std::min(shadow_distance, proj.m_mat[3][2] / (1.0f - proj.m_mat[2][2]));
+
+	Matrix4x4 camera = view;
+	camera.inverse();
+
+	for (unsigned int i = 0; i < CASCADE_COUNT; i++)
+	{
+		ShadowCascade& cascade = cascades[i];
+		auto split = [&](unsigned int index)
+		{
+			float t = (float)index / CASCADE_COUNT;
+			return CASCADE_SPLIT_LAMBDA * z_near * powf(z_far / z_near, t) + (1.0f - CASCADE_SPLIT_LAMBDA) * (z_near + (z_far - z_near) * t);
+		};
+		cascade.m_split_near = split(i);
+		cascade.m_split_far = split(i + 1);
+		cascade.m_static = i == CASCADE_COUNT - 1;
+
+		if (cascade.m_static)
+		{
+			fitBox(cascade, scene_corners, 8);
+			continue;
+		}
+
+		Vector3D corners[8];
+		float depths[2] = { cascade.m_split_near, cascade.m_split_far };
+		for (int c = 0; c < 8; c++)
+		{
+			float depth = depths[c >> 2];
+			Vector3D p(((c & 1) ? 1.0f : -1.0f) * depth / x_scale, ((c & 2) ? 1.0f : -1.0f) * depth / y_scale, depth);
+			corners[c] = Vector3D(
+				p.m_x * camera.m_mat[0][0] + p.m_y * camera.m_mat[1][0] + p.m_z * camera.m_mat[2][0] + camera.m_mat[3][0],
+				p.m_x * camera.m_mat[0][1] + p.m_y * camera.m_mat[1][1] + p.m_z * camera.m_mat[2][1] + camera.m_mat[3][1],
+				p.m_x * camera.m_mat[0][2] + p.m_y * camera.m_mat[1][2] + p.m_z * camera.m_mat[2][2] + camera.m_mat[3][2]);
+		}
+		fitBox(cascade, corners, 8);
+	}
+}
+
+
+/*
+	- square box: the same texel size in x and y
+	- the size is rounded up to steps of the diagonal of the corners (that does not change when the camera turns), then
+	  the corner is snapped to whole texels -> a moving camera shifts the shadow map by whole texels only
+*/
+
+void ShadowCascades::fitBox(ShadowCascade& cascade, const Vector3D* corners, unsigned int corner_count)
+{
+	float box_min[2] = { FLT_MAX, FLT_MAX };
+	float box_max[2] = { -FLT_MAX, -FLT_MAX };
+	for (unsigned int i = 0; i < corner_count; i++)
+	{
+		Vector3D p = toLight(corners[i]);
+		box_min[0] = std::min(box_min[0], p.m_x);
+		box_min[1] = std::min(box_min[1], p.m_y);
+		box_max[0] = std::max(box_max[0], p.m_x);
+		box_max[1] = std::max(box_max[1], p.m_y);
+	}
+
+	float diagonal = 0.0f;
+	for (unsigned int i = 0; i < corner_count; i++)
+	{
+		for (unsigned int j = i + 1; j < corner_count; j++)
+			diagonal = std::max(diagonal, (corners[i] - corners[j]).length());
+	}
+
+	// nothing to shadow outside of the scene
+	for (int axis = 0; axis < 2; axis++)
+	{
+		box_min[axis] = std::max(box_min[axis], m_scene_min[axis]);
+		box_max[axis] = std::min(box_max[axis], m_scene_max[axis]);
+		if (box_max[axis] < box_min[axis])
+			box_max[axis] = box_min[axis];
+	}
+
+	float step = std::max(diagonal / CASCADE_SIZE_STEPS, 0.001f);
+	float size = ceilf(std::max(std::max(box_max[0] - box_min[0], box_max[1] - box_min[1]), step) / step) * step;
+	float texel = size / SHADOW_MAP_SIZE;
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		float center = (box_min[axis] + box_max[axis]) * 0.5f;
+		cascade.m_box_min[axis] = floorf((center - size * 0.5f) / texel) * texel;
+		cascade.m_box_max[axis] = cascade.m_box_min[axis] + size;
+	}
+
+	float depth_padding = (m_scene_max[2] - m_scene_min[2]) * 0.01f + 0.01f;
+	cascade.m_box_min[2] = m_scene_min[2] - depth_padding;
+	cascade.m_box_max[2] = m_scene_max[2] + depth_padding;
+	cascade.m_texel_size = texel;
+
+	cascade.m_view = m_light_rotation;
+	cascade.m_view.m_mat[3][0] = -(cascade.m_box_min[0] + cascade.m_box_max[0]) * 0.5f;
+	cascade.m_view.m_mat[3][1] = -(cascade.m_box_min[1] + cascade.m_box_max[1]) * 0.5f;
+	cascade.m_proj.setOrthoLH(size, size, cascade.m_box_min[2], cascade.m_box_max[2]);
+}
+
+
+void ShadowCascades::cull(const std::vector<ShadowCaster>& casters, ShadowCascade cascades[CASCADE_COUNT], ShadowStats& stats)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	std::vector<Vector3D> centers(casters.size());
+	for (size_t i = 0; i < casters.size(); i++)
+		centers[i] = toLight(casters[i].m_center);
+
+	JobSystem::get()->parallelFor(CASCADE_COUNT, 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int c = begin; c < end; c++)
+			{
+				ShadowCascade& cascade = cascades[c];
+				cascade.m_casters.clear();
+				for (unsigned int i = 0; i < (unsigned int)casters.size(); i++)
+				{
+					const Vector3D& p = centers[i];
+					float r = casters[i].m_radius;
+					if (p.m_x + r < cascade.m_box_min[0] || p.m_x - r > cascade.m_box_max[0] ||
+						p.m_y + r < cascade.m_box_min[1] || p.m_y - r > cascade.m_box_max[1] ||
+						p.m_z + r < cascade.m_box_min[2] || p.m_z - r > cascade.m_box_max[2])
+						continue;
+					cascade.m_casters.push_back(i);
+				}
+			}
+		});
+
+	stats.m_casters = (unsigned int)casters.size();
+	for (unsigned int c = 0; c < CASCADE_COUNT; c++)
+		stats.m_cascade_casters[c] = (unsigned int)cascades[c].m_casters.size();
+	stats.m_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+void ShadowCascades::getConstants(const ShadowCascade cascades[CASCADE_COUNT], ShadowConstantType& constants)
+{
+	for (unsigned int c = 0; c < CASCADE_COUNT; c++)
+	{
+		constants.m_cascade_matrix[c] = cascades[c].m_view;
+		constants.m_cascade_matrix[c] *= cascades[c].m_proj;
+		constants.m_cascade_far[c] = cascades[c].m_split_far;
+		constants.m_texel_size[c] = cascades[c].m_texel_size;
+	}
+}
@@ -0,0 +1,100 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Matrix4x4.h"
+#include "ConstantBuffer.h"
+#include <vector>
+
+// an object that throws a shadow: placement and world space bounding sphere
+struct ShadowCaster
+{
+	Matrix4x4 m_world;
+	Vector3D m_center;
+	float m_radius = 0.0f;
+};
+
+struct ShadowCascade
+{
+	Matrix4x4 m_view;						// world to light space, rotation and the offset of the fitted box
+	Matrix4x4 m_proj;						// setOrthoLH of the fitted box
+	float m_split_near = 0.0f;				// view depth range of the camera the cascade covers
+	float m_split_far = 0.0f;
+	float m_texel_size = 0.0f;				// world size of one shadow map texel
+	bool m_static = false;					// fitted to the scene only, the same as long as the light does not move
+	float m_box_min[3] = {};				// fitted box in light space (without the offset of m_view)
+	float m_box_max[3] = {};
+	std::vector<unsigned int> m_casters;	// indices into the casters given to cull()
+};
+
+struct ShadowStats
+{
+	unsigned int m_casters = 0;
+	unsigned int m_cascade_casters[4] = {};	// casters left per cascade after culling
+	double m_milliseconds = 0.0;
+};
+
+
+/*
+	ShadowCascades: fits the cascades of a directional light on the CPU and culls the casters per cascade
+
+	- the view depth up to the shadow distance is split between logarithmic and uniform (practical split scheme)
+	- cascade box: the corners of the camera frustum part in light space, cut to the scene bounds, so no texel is spent
+	  where nothing can be. The size is rounded up to coarse steps and the position snapped to whole texels, so the
+	  shadow edges do not shimmer while the camera moves. Depth range: the scene bounds, so casters between the light
+	  and the frustum part are kept
+	- the last cascade is fitted to the whole scene and does not depend on the camera: static, the render thread keeps
+	  its shadow map as long as the light does not move. The others are kept when their matrices did not change either
+	- culling: the bounding sphere of every caster against the box of each cascade in light space
+*/
+
+class ShadowCascades
+{
+public:
+
+	static const unsigned int CASCADE_COUNT = 4;
+	static const unsigned int SHADOW_MAP_SIZE = 1024;
+
+	// light_direction: direction the light travels. scene_min/max: bounds of everything that casts or receives shadows
+	void fit(const Matrix4x4& view, const Matrix4x4& proj, const Vector3D& light_direction, const Vector3D& scene_min, const Vector3D& scene_max,
+		float shadow_distance, ShadowCascade cascades[CASCADE_COUNT]);
+	void cull(const std::vector<ShadowCaster>& casters, ShadowCascade cascades[CASCADE_COUNT], ShadowStats& stats);
+
+	// constants of the pixel shader for the cascades
+	static void getConstants(const ShadowCascade cascades[CASCADE_COUNT], ShadowConstantType& constants);
+
+private:
+
+	// box around the world space corners in light space, cut to the scene, rounded and snapped
+	void fitBox(ShadowCascade& cascade, const Vector3D* corners, unsigned int corner_count);
+	Vector3D toLight(const Vector3D& point);
+
+private:
+
+	Matrix4x4 m_light_rotation;			// world to light space without offset
+	float m_scene_min[3] = {};			// scene bounds in light space
+	float m_scene_max[3] = {};
+};
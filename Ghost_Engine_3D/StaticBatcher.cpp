@@ -0,0 +1,338 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "StaticBatcher.h"
+#include "DeviceContext.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <exception>
+
+// objects per job of the culling pass
+static const unsigned int STATIC_BATCH_CULL_GROUP = 64;
+
+
+StaticBatcher::StaticBatcher()
+{
+}
+
+
+void StaticBatcher::add(MeshModel* mesh, const Matrix4x4& world, TextureShaderHandle material, unsigned int level)
+{
+	if (!mesh || !mesh->getLodCount())
+		return;
+
+	StagingBatch* batch = nullptr;
+	for (StagingBatch& staging : m_staging)
+	{
+		if (staging.m_material == material)
+			batch = &staging;
+	}
+	if (!batch)
+	{
+		m_staging.push_back(StagingBatch());
+		batch = &m_staging.back();
+		batch->m_material = material;
+	}
+
+	const MeshFileLod& lod = mesh->getLod(std::min(level, mesh->getLodCount() - 1));
+	const std::vector<VertexMesh>& vertices = mesh->getVertexData();
+	const unsigned int* indices = mesh->getIndexData().data() + lod.m_index_start;
+
+	// normals with the inverse transpose (row vectors: n' = n * transpose(inverse(world)))
+	Matrix4x4 normal_matrix = world;
+	normal_matrix.inverse();
+
+	Matrix4x4 determinant = world;
+	bool mirrored = determinant.getDeterminant() < 0.0f;
+
+	// only the vertices the level uses, renumbered in the order of first use
+	std::vector<unsigned int> remap(vertices.size(), ~0u);
+	unsigned int base = (unsigned int)batch->m_vertices.size();
+
+	StaticBatchObject object;
+	object.m_index_start = (unsigned int)batch->m_indices.size();
+	object.m_index_count = lod.m_index_count;
+
+	for (unsigned int i = 0; i < lod.m_index_count; i++)
+	{
+		unsigned int index = indices[i];
+		if (remap[index] == ~0u)
+		{
+			const VertexMesh& vertex = vertices[index];
+			const Vector3D& p = vertex.m_Pos;
+			const Vector3D& n = vertex.m_Norm;
+
+			Vector3D position(
+				p.m_x * world.m_mat[0][0] + p.m_y * world.m_mat[1][0] + p.m_z * world.m_mat[2][0] + world.m_mat[3][0],
+				p.m_x * world.m_mat[0][1] + p.m_y * world.m_mat[1][1] + p.m_z * world.m_mat[2][1] + world.m_mat[3][1],
+				p.m_x * world.m_mat[0][2] + p.m_y * world.m_mat[1][2] + p.m_z * world.m_mat[2][2] + world.m_mat[3][2]);
+
+			Vector3D normal(
+				n.m_x * normal_matrix.m_mat[0][0] + n.m_y * normal_matrix.m_mat[0][1] + n.m_z * normal_matrix.m_mat[0][2],
+				n.m_x * normal_matrix.m_mat[1][0] + n.m_y * normal_matrix.m_mat[1][1] + n.m_z * normal_matrix.m_mat[1][2],
+				n.m_x * normal_matrix.m_mat[2][0] + n.m_y * normal_matrix.m_mat[2][1] + n.m_z * normal_matrix.m_mat[2][2]);
+
+			float length = normal.length();
+			if (length > 0.0f)
+				normal = normal * (1.0f / length);
+
+			bool first = (base == batch->m_vertices.size());
+			object.m_box_min = first ? position : Vector3D(std::min(object.m_box_min.m_x, position.m_x), std::min(object.m_box_min.m_y, position.m_y), std::min(object.m_box_min.m_z, position.m_z));
+			object.m_box_max = first ? position : Vector3D(std::max(object.m_box_max.m_x, position.m_x), std::max(object.m_box_max.m_y, position.m_y), std::max(object.m_box_max.m_z, position.m_z));
+
+			remap[index] = (unsigned int)batch->m_vertices.size();
+			batch->m_vertices.push_back(VertexMesh(position, vertex.m_Tex, normal));
+		}
+		batch->m_indices.push_back(remap[index]);
+	}
+
+	// a mirroring matrix turns front faces into back faces
+	if (mirrored)
+	{
+		for (size_t i = object.m_index_start; i + 2 < batch->m_indices.size(); i += 3)
+		{
+			std::swap(batch->m_indices[i + 1], batch->m_indices[i + 2]);
+		}
+	}
+
+	batch->m_objects.push_back(object);
+}
+
+
+/*
+	- the index list is copied once more for 16-bit batches, the buffers keep their own copy so the staging
+	  memory is freed afterwards
+*/
+void StaticBatcher::build()
+{
+	releaseBatches();
+
+	void* shader_byte_code = nullptr;
+	size_t size_shader = 0;
+	GraphicsEngine::get()->getMeshModelShader(&shader_byte_code, &size_shader);
+
+	m_stats = StaticBatchStats();
+
+	for (StagingBatch& staging : m_staging)
+	{
+		if (staging.m_indices.empty())
+			continue;
+
+		StaticBatch batch;
+		batch.m_material = staging.m_material;
+		batch.m_vertex_count = (unsigned int)staging.m_vertices.size();
+		batch.m_index_count = (unsigned int)staging.m_indices.size();
+		batch.m_index_format = (batch.m_vertex_count <= 65536) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+
+		batch.m_vertices = GraphicsEngine::get()->createVertexBuffer(staging.m_vertices.data(), sizeof(VertexMesh), batch.m_vertex_count, shader_byte_code, (UINT)size_shader);
+
+		if (batch.m_index_format == DXGI_FORMAT_R16_UINT)
+		{
+			std::vector<unsigned short> indices(staging.m_indices.begin(), staging.m_indices.end());
+			batch.m_indices = GraphicsEngine::get()->createIndexBuffer(indices.data(), batch.m_index_count, DXGI_FORMAT_R16_UINT);
+		}
+		else
+		{
+			batch.m_indices = GraphicsEngine::get()->createIndexBuffer(staging.m_indices.data(), batch.m_index_count);
+		}
+
+		if (!batch.m_vertices.isValid() || !batch.m_indices.isValid())
+		{
+			GraphicsEngine::get()->release(batch.m_vertices);
+			GraphicsEngine::get()->release(batch.m_indices);
+			releaseBatches();
+			throw std::exception("Create Static Batch Buffers was not successful");
+		}
+
+		batch.m_objects = std::move(staging.m_objects);
+		batch.m_visible.assign(batch.m_objects.size(), 1);
+
+		m_stats.m_batches++;
+		m_stats.m_batches_16bit += (batch.m_index_format == DXGI_FORMAT_R16_UINT) ? 1 : 0;
+		m_stats.m_objects += (unsigned int)batch.m_objects.size();
+		m_stats.m_vertices += batch.m_vertex_count;
+		m_stats.m_indices += batch.m_index_count;
+
+		m_batches.push_back(std::move(batch));
+	}
+
+	m_staging.clear();
+}
+
+
+void StaticBatcher::clear()
+{
+	releaseBatches();
+	m_staging.clear();
+	m_stats = StaticBatchStats();
+}
+
+
+/*
+	- box against plane: only the corner farthest along the plane normal has to be tested
+	- the occlusion test gets the sphere around the box
+*/
+void StaticBatcher::cull(const Matrix4x4& view, const Matrix4x4& proj, OcclusionTest* occlusion)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	Matrix4x4 view_proj = view;
+	view_proj *= proj;
+
+	float planes[6][4];
+	getFrustumPlanes(view_proj, planes);
+
+	m_stats.m_objects_visible = 0;
+
+	for (StaticBatch& batch : m_batches)
+	{
+		JobSystem::get()->parallelFor((unsigned int)batch.m_objects.size(), STATIC_BATCH_CULL_GROUP, [&](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int i = begin; i < end; i++)
+				{
+					const StaticBatchObject& object = batch.m_objects[i];
+
+					bool visible = true;
+					for (unsigned int p = 0; p < 6 && visible; p++)
+					{
+						float x = planes[p][0] >= 0.0f ? object.m_box_max.m_x : object.m_box_min.m_x;
+						float y = planes[p][1] >= 0.0f ? object.m_box_max.m_y : object.m_box_min.m_y;
+						float z = planes[p][2] >= 0.0f ? object.m_box_max.m_z : object.m_box_min.m_z;
+						if (planes[p][0] * x + planes[p][1] * y + planes[p][2] * z + planes[p][3] < 0.0f)
+							visible = false;
+					}
+
+					if (visible && occlusion)
+					{
+						Vector3D center = (object.m_box_min + object.m_box_max) * 0.5f;
+						float radius = (object.m_box_max - object.m_box_min).length() * 0.5f;
+						visible = !occlusion->isOccluded(center, radius);
+					}
+
+					batch.m_visible[i] = visible ? 1 : 0;
+				}
+			});
+
+		for (unsigned char visible : batch.m_visible)
+		{
+			m_stats.m_objects_visible += visible;
+		}
+	}
+
+	m_stats.m_cull_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+void StaticBatcher::draw(DeviceContext* context)
+{
+	m_stats.m_draws = 0;
+	m_stats.m_binds = 0;
+
+	for (StaticBatch& batch : m_batches)
+	{
+		VertexBuffer* vertices = GraphicsEngine::get()->get(batch.m_vertices);
+		IndexBuffer* indices = GraphicsEngine::get()->get(batch.m_indices);
+		TextureShader* material = GraphicsEngine::get()->get(batch.m_material);
+		if (!vertices || !indices)
+			continue;
+
+		if (std::find(batch.m_visible.begin(), batch.m_visible.end(), 1) == batch.m_visible.end())
+			continue;
+
+		if (material)
+			context->setTextureShader(material);
+		context->setVertexBuffer(vertices);
+		context->setIndexBuffer(indices);
+		m_stats.m_binds++;
+
+		// objects are stored in index order -> visible neighbours are one contiguous range
+		unsigned int run_start = 0, run_count = 0;
+		for (size_t i = 0; i < batch.m_objects.size(); i++)
+		{
+			if (!batch.m_visible[i])
+				continue;
+
+			const StaticBatchObject& object = batch.m_objects[i];
+			if (run_count && run_start + run_count == object.m_index_start)
+			{
+				run_count += object.m_index_count;
+				continue;
+			}
+
+			if (run_count)
+			{
+				context->drawIndexedTriangleList(run_count, 0, run_start);
+				m_stats.m_draws++;
+			}
+			run_start = object.m_index_start;
+			run_count = object.m_index_count;
+		}
+
+		if (run_count)
+		{
+			context->drawIndexedTriangleList(run_count, 0, run_start);
+			m_stats.m_draws++;
+		}
+	}
+}
+
+
+unsigned int StaticBatcher::getBatchCount()
+{
+	return (unsigned int)m_batches.size();
+}
+
+
+const StaticBatch& StaticBatcher::getBatch(unsigned int index)
+{
+	return m_batches[index];
+}
+
+
+const StaticBatchStats& StaticBatcher::getStats()
+{
+	return m_stats;
+}
+
+
+void StaticBatcher::releaseBatches()
+{
+	for (StaticBatch& batch : m_batches)
+	{
+		GraphicsEngine::get()->release(batch.m_vertices);
+		GraphicsEngine::get()->release(batch.m_indices);
+	}
+	m_batches.clear();
+}
+
+
+StaticBatcher::~StaticBatcher()
+{
+	releaseBatches();
+}
@@ -0,0 +1,126 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "GraphicsEngine.h"
+#include "MeshletCuller.h"
+#include "VertexMesh.h"
+#include <vector>
+
+class DeviceContext;
+
+// one static object inside a batch: its range of the batch index buffer and its world space box
+struct StaticBatchObject
+{
+	unsigned int m_index_start = 0;
+	unsigned int m_index_count = 0;
+	Vector3D m_box_min;
+	Vector3D m_box_max;
+};
+
+// the objects of one material, merged into one vertex and one index buffer
+struct StaticBatch
+{
+	TextureShaderHandle m_material;
+	VertexBufferHandle m_vertices;
+	IndexBufferHandle m_indices;
+	DXGI_FORMAT m_index_format = DXGI_FORMAT_R32_UINT;
+	unsigned int m_vertex_count = 0;
+	unsigned int m_index_count = 0;
+	std::vector<StaticBatchObject> m_objects;
+	std::vector<unsigned char> m_visible;		// of the last cull(), all objects before the first one
+};
+
+struct StaticBatchStats
+{
+	unsigned int m_batches = 0;
+	unsigned int m_batches_16bit = 0;
+	unsigned int m_objects = 0;
+	unsigned int m_vertices = 0;
+	unsigned int m_indices = 0;
+
+	// of the last cull() and draw()
+	unsigned int m_objects_visible = 0;
+	unsigned int m_draws = 0;
+	unsigned int m_binds = 0;				// buffer pairs bound
+	double m_cull_milliseconds = 0.0;
+};
+
+
+/*
+	StaticBatcher: merges static objects into shared vertex and index buffers, one pair per material
+
+	- add() bakes the object into world space on the CPU: positions through the world matrix, normals through its
+	  inverse transpose, winding flipped for mirroring matrices. Copies of the same mesh are copied each time
+	- build() creates the buffers. A batch with at most 65536 vertices gets 16-bit indices, bigger ones 32-bit
+	- every object keeps its index range and world box, so it can still be culled on its own. draw() binds each
+	  batch once and merges the ranges of neighbouring visible objects into one draw call
+	- the batch vertices are in world space: draw them with the identity as world matrix. The detail level is
+	  fixed at add(), a batch does not switch levels per object
+*/
+
+class StaticBatcher
+{
+public:
+
+	StaticBatcher();
+	~StaticBatcher();
+
+	// bake one detail level of mesh, placed with world, into the batch of material. The GPU buffers are created by build()
+	void add(MeshModel* mesh, const Matrix4x4& world, TextureShaderHandle material, unsigned int level = 0);
+	// create the buffers of all objects added since the last build(). Replaces the batches of an earlier build
+	void build();
+	// release the batches and the objects that were not built yet
+	void clear();
+
+	// visibility of every object: box against the frustum of view * proj, then the optional occlusion test
+	void cull(const Matrix4x4& view, const Matrix4x4& proj, OcclusionTest* occlusion = nullptr);
+	// draw the visible objects of all batches
+	void draw(DeviceContext* context);
+
+	unsigned int getBatchCount();
+	const StaticBatch& getBatch(unsigned int index);
+	const StaticBatchStats& getStats();
+
+private:
+
+	// CPU side of a batch until build()
+	struct StagingBatch
+	{
+		TextureShaderHandle m_material;
+		std::vector<VertexMesh> m_vertices;
+		std::vector<unsigned int> m_indices;
+		std::vector<StaticBatchObject> m_objects;
+	};
+
+	void releaseBatches();
+
+private:
+
+	std::vector<StagingBatch> m_staging;
+	std::vector<StaticBatch> m_batches;
+	StaticBatchStats m_stats;
+};
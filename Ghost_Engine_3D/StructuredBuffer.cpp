@@ -0,0 +1,95 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "StructuredBuffer.h"
+#include "GraphicsEngine.h"
+#include "DeviceContext.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+
+/*
+	- D3D11_RESOURCE_MISC_BUFFER_STRUCTURED with the stride of one element, the view covers all elements
+*/
+
+StructuredBuffer::StructuredBuffer(UINT size_element, UINT size_list) :m_size_element(size_element), m_size_list(std::max(size_list, 1u))
+{
+	D3D11_BUFFER_DESC buff_desc = {};
+	buff_desc.Usage = D3D11_USAGE_DYNAMIC;
+	buff_desc.ByteWidth = m_size_element * m_size_list;
+	buff_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	buff_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	buff_desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	buff_desc.StructureByteStride = m_size_element;
+
+	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateBuffer(&buff_desc, nullptr, &m_buffer)))
+	{
+		throw std::exception("Create Structured Buffer was not successful");
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+	srv_desc.Format = DXGI_FORMAT_UNKNOWN;
+	srv_desc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srv_desc.Buffer.FirstElement = 0;
+	srv_desc.Buffer.NumElements = m_size_list;
+
+	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateShaderResourceView(m_buffer, &srv_desc, &m_srv)))
+	{
+		m_buffer->Release();
+		throw std::exception("Create Structured Buffer View was not successful");
+	}
+}
+
+
+void StructuredBuffer::update(DeviceContext* context, const void* list_elements, UINT size_list)
+{
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->m_device_context->Map(m_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+
+	::memcpy(mapped.pData, list_elements, m_size_element * (size_t)std::min(size_list, m_size_list));
+	context->m_device_context->Unmap(m_buffer, 0);
+}
+
+
+UINT StructuredBuffer::getSizeElement()
+{
+	return m_size_element;
+}
+
+
+UINT StructuredBuffer::getSizeList()
+{
+	return m_size_list;
+}
+
+
+StructuredBuffer::~StructuredBuffer()
+{
+	if (m_srv) m_srv->Release();
+	if (m_buffer) m_buffer->Release();
+}
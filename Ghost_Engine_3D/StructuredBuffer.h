@@ -0,0 +1,62 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+
+class DeviceContext;
+
+/*
+	StructuredBuffer: an array of structs the shaders read (StructuredBuffer<T> in HLSL)
+
+	- dynamic: the CPU rewrites it every frame with update(), like a dynamic IndexBuffer
+	- bound with DeviceContext::setStructuredBuffer to a register t<slot>
+*/
+
+class StructuredBuffer
+{
+public:
+
+	StructuredBuffer(UINT size_element, UINT size_list);
+	~StructuredBuffer();
+
+	// replace the content with size_list elements (at most the size of the buffer)
+	void update(DeviceContext* context, const void* list_elements, UINT size_list);
+
+	UINT getSizeElement();
+	UINT getSizeList();
+
+private:
+
+	ID3D11Buffer* m_buffer = nullptr;
+	ID3D11ShaderResourceView* m_srv = nullptr;
+	UINT m_size_element = 0;
+	UINT m_size_list = 0;
+
+private:
+
+	friend class DeviceContext;
+};
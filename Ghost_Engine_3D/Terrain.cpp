@@ -0,0 +1,610 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "Terrain.h"
+#include "FileSystem.h"
+#include "MeshletCuller.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+
+
+Terrain::Terrain() :m_reader(READS_PER_BATCH)
+{
+}
+
+
+/*
+	- tiles are counted level by level, the tiles of a level row by row -> one index per tile
+	- the quadtree levels only need the offsets of their first node in the bounds
+*/
+
+void Terrain::initTiles()
+{
+	// completions of a previous terrain must not arrive in the new one
+	m_reader.wait();
+	m_read_tiles.clear();
+	m_ready_tiles.clear();
+	m_reads_in_flight = 0;
+
+	m_level_offsets.resize(m_header.m_node_levels);
+	for (unsigned int level = 0; level < m_header.m_node_levels; level++)
+		m_level_offsets[level] = (unsigned int)TerrainFile::getLevelOffset(m_header, level);
+
+	unsigned int tile_count = 0;
+	m_tile_offsets.resize(m_header.m_tile_levels);
+	for (unsigned int level = 0; level < m_header.m_tile_levels; level++)
+	{
+		unsigned int side = m_header.m_size / (m_header.m_tile_size << level);
+		m_tile_offsets[level] = tile_count;
+		tile_count += side * side;
+	}
+
+	m_tiles.assign(tile_count, Tile());
+	m_slots.assign(TILE_SLOTS, ~0u);
+	m_requested.clear();
+	m_root_tile = m_tile_offsets[m_header.m_tile_levels - 1];
+	m_frame = 0;
+	m_tiles_streamed = 0;
+
+	m_ranges.resize(m_header.m_node_levels);
+}
+
+
+bool Terrain::open(const wchar_t* directory)
+{
+	m_open = false;
+
+	FileSpan span;
+	if (!FileSystem::get()->read(TerrainFile::getTerrainPath(directory).c_str(), span))
+		return false;
+	if (!TerrainFile::open(span.getData(), span.getSize(), m_header, m_bounds))
+		return false;
+
+	m_directory = directory;
+	m_procedural = false;
+	initTiles();
+
+	// the root tile is there from the first frame on: the whole terrain can always be drawn
+	FileSpan tile_span;
+	if (!FileSystem::get()->read(TerrainFile::getTilePath(directory, m_header.m_tile_levels - 1, 0, 0).c_str(), tile_span))
+		return false;
+	if (!TerrainFile::openTile(tile_span.getData(), tile_span.getSize(), m_header))
+		return false;
+
+	ReadTile root;
+	root.m_tile = m_root_tile;
+	root.m_data.assign(tile_span.getData(), tile_span.getData() + tile_span.getSize());
+	m_ready_tiles.push_back(std::move(root));
+	m_tiles[m_root_tile].m_state = TileState::Ready;
+
+	m_open = true;
+	return true;
+}
+
+
+/*
+	- leaf bounds from every eighth height of the noise in both directions: building the exact bounds of a 16k map
+	  would take many times longer than the whole benchmark. The surface can pass the bounds slightly between the samples,
+	  which does not change how many nodes are selected
+	- the sampled heights of a row of leaves come from one SIMD row fill of the noise per sampled line
+*/
+
+void Terrain::createProcedural(unsigned int size, unsigned int chunk_size, float spacing, float height_scale)
+{
+	m_open = false;
+
+	m_header = TerrainFileHeader();
+	m_header.m_size = size;
+	m_header.m_tile_size = std::min(m_header.m_tile_size, size);
+	m_header.m_chunk_size = chunk_size;
+	m_header.m_spacing = spacing;
+	m_header.m_height_scale = height_scale;
+	if (!TerrainFile::setLevels(m_header))
+		return;
+
+	m_bounds.resize(TerrainFile::getLevelOffset(m_header, m_header.m_node_levels));
+	unsigned int leaves = TerrainFile::getNodesPerSide(m_header, 0);
+	unsigned int stride = std::min(8u, chunk_size);
+	unsigned int steps = chunk_size / stride;
+	NoiseSettings noise = TerrainFile::getNoiseSettings(size);
+	JobSystem::get()->parallelFor(leaves, 1, [&](unsigned int begin, unsigned int end)
+		{
+			std::vector<float> row(leaves * steps + 1);
+			for (unsigned int y = begin; y < end; y++)
+			{
+				for (unsigned int x = 0; x < leaves; x++)
+				{
+					m_bounds[y * leaves + x].m_min = 0xffff;
+					m_bounds[y * leaves + x].m_max = 0;
+				}
+
+				for (unsigned int j = 0; j <= chunk_size; j += stride)
+				{
+					Noise::fillRow2D(noise, row.data(), (unsigned int)row.size(), 0.0f, (float)stride, (float)(y * chunk_size + j));
+					for (unsigned int x = 0; x < leaves; x++)
+					{
+						TerrainHeightBounds& bound = m_bounds[y * leaves + x];
+						for (unsigned int i = 0; i <= steps; i++)
+						{
+							unsigned short height = Noise::toHeight(row[x * steps + i]);
+							bound.m_min = std::min(bound.m_min, height);
+							bound.m_max = std::max(bound.m_max, height);
+						}
+					}
+				}
+			}
+		});
+	TerrainFile::buildBounds(m_header, m_bounds);
+
+	m_directory.clear();
+	m_procedural = true;
+	initTiles();
+	m_open = true;
+}
+
+
+bool Terrain::isOpen()
+{
+	return m_open;
+}
+
+
+void Terrain::setOrigin(const Vector3D& origin)
+{
+	m_origin = origin;
+}
+
+
+void Terrain::getBoundingBox(Vector3D& min, Vector3D& max)
+{
+	TerrainHeightBounds root;
+	if (!m_bounds.empty())
+		root = m_bounds.back();
+	float size = m_header.m_size * m_header.m_spacing;
+
+	min = m_origin + Vector3D(0.0f, root.m_min / 65535.0f * m_header.m_height_scale, 0.0f);
+	max = m_origin + Vector3D(size, root.m_max / 65535.0f * m_header.m_height_scale, size);
+}
+
+
+const TerrainFileHeader& Terrain::getHeader()
+{
+	return m_header;
+}
+
+
+void Terrain::select(const Matrix4x4& view, const Matrix4x4& proj, const Vector3D& camera, float lod_distance, TerrainFrame& frame)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	frame.m_instances.clear();
+	frame.m_uploads.clear();
+	m_stats = TerrainStats();
+
+	if (!m_open)
+	{
+		frame.m_stats = m_stats;
+		return;
+	}
+
+	m_frame++;
+	if (!m_procedural)
+		updateStreaming(frame);
+
+	Matrix4x4 view_proj = view;
+	view_proj *= proj;
+	getFrustumPlanes(view_proj, m_planes);
+
+	m_camera[0] = camera.m_x;
+	m_camera[1] = camera.m_y;
+	m_camera[2] = camera.m_z;
+
+	float leaf_size = m_header.m_chunk_size * m_header.m_spacing;
+	for (unsigned int level = 0; level < m_header.m_node_levels; level++)
+		m_ranges[level] = std::max(lod_distance, 1.0f) * leaf_size * (float)(1u << level);
+
+	// the root is always drawn, as soon as its heights are there
+	unsigned int root_level = m_header.m_node_levels - 1;
+	if (requestTile(getNodeTile(root_level, 0, 0)))
+		selectNode(root_level, 0, 0, frame);
+
+	unsigned int grid = m_header.m_chunk_size / 2;
+	m_stats.m_instances = (unsigned int)frame.m_instances.size();
+	m_stats.m_vertices = (unsigned long long)m_stats.m_instances * (grid + 1) * (grid + 1);
+	m_stats.m_triangles = (unsigned long long)m_stats.m_instances * grid * grid * 2;
+	m_stats.m_tiles_resident = (unsigned int)(TILE_SLOTS - std::count(m_slots.begin(), m_slots.end(), ~0u));
+	m_stats.m_tiles_loading = m_reads_in_flight + (unsigned int)m_requested.size() + (unsigned int)m_ready_tiles.size();
+	m_stats.m_tiles_streamed = m_tiles_streamed;
+
+	TerrainConstantType& constants = frame.m_constants;
+	constants.m_camera[0] = camera.m_x;
+	constants.m_camera[1] = camera.m_y;
+	constants.m_camera[2] = camera.m_z;
+	constants.m_height_scale = m_header.m_height_scale;
+	constants.m_origin[0] = m_origin.m_x;
+	constants.m_origin[1] = m_origin.m_y;
+	constants.m_origin[2] = m_origin.m_z;
+	constants.m_tile_samples = (float)(m_header.m_tile_size + 1);
+	constants.m_grid_size = grid;
+
+	m_stats.m_select_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	frame.m_stats = m_stats;
+}
+
+
+/*
+	- out of range (not for the root): the parent draws this area with a quadrant
+	- in the range of the next finer level and the tiles of the children are there: the children decide, each child
+	  out of its range becomes a quadrant of this node. Otherwise all four quadrants at this level
+*/
+
+bool Terrain::selectNode(unsigned int level, unsigned int x, unsigned int y, TerrainFrame& frame)
+{
+	float box_min[3], box_max[3];
+	getNodeBox(level, x, y, box_min, box_max);
+	m_stats.m_nodes_visited++;
+
+	if (level + 1 < m_header.m_node_levels && !isInRange(box_min, box_max, m_ranges[level]))
+		return false;
+
+	if (!isInFrustum(box_min, box_max))
+	{
+		m_stats.m_nodes_culled++;
+		return true;
+	}
+
+	bool split = level > 0 && isInRange(box_min, box_max, m_ranges[level - 1]);
+	if (split && !requestTile(getNodeTile(level - 1, x * 2, y * 2)))
+	{
+		split = false;
+		m_stats.m_waiting++;
+	}
+
+	for (unsigned int quadrant = 0; quadrant < 4; quadrant++)
+	{
+		if (!split || !selectNode(level - 1, x * 2 + (quadrant & 1), y * 2 + (quadrant >> 1), frame))
+			addQuadrant(level, x, y, quadrant, frame);
+	}
+
+	return true;
+}
+
+
+void Terrain::addQuadrant(unsigned int level, unsigned int x, unsigned int y, unsigned int quadrant, TerrainFrame& frame)
+{
+	// quadrant in quads of the map
+	unsigned int half = (m_header.m_chunk_size << level) / 2;
+	unsigned int quad_x = x * half * 2 + (quadrant & 1) * half;
+	unsigned int quad_y = y * half * 2 + (quadrant >> 1) * half;
+
+	float box_min[3], box_max[3];
+	getNodeBox(level, x, y, box_min, box_max);
+	box_min[0] = m_origin.m_x + quad_x * m_header.m_spacing;
+	box_min[2] = m_origin.m_z + quad_y * m_header.m_spacing;
+	box_max[0] = box_min[0] + half * m_header.m_spacing;
+	box_max[2] = box_min[2] + half * m_header.m_spacing;
+	if (!isInFrustum(box_min, box_max))
+	{
+		m_stats.m_nodes_culled++;
+		return;
+	}
+
+	if (frame.m_instances.size() >= MAX_INSTANCES)
+		return;
+
+	unsigned int tile_level = getTileLevel(level);
+	unsigned int tile_quads = m_header.m_tile_size << tile_level;
+	Tile& tile = m_tiles[getTileIndex(tile_level, quad_x / tile_quads, quad_y / tile_quads)];
+	tile.m_last_used = m_frame;
+
+	// the next coarser level morphs into nothing: the root never morphs
+	float range = m_ranges[level];
+	float previous = level ? m_ranges[level - 1] : 0.0f;
+	bool root = level + 1 == m_header.m_node_levels;
+
+	TerrainInstance instance;
+	instance.m_offset[0] = box_min[0];
+	instance.m_offset[1] = box_min[2];
+	instance.m_quad_size = m_header.m_spacing * (float)(1u << level);
+	instance.m_morph_start = root ? FLT_MAX : previous + (range - previous) * 0.7f;
+	instance.m_morph_end = root ? FLT_MAX : range;
+	instance.m_uv_offset[0] = (float)((quad_x % tile_quads) >> tile_level);
+	instance.m_uv_offset[1] = (float)((quad_y % tile_quads) >> tile_level);
+	instance.m_uv_step = (float)(1u << (level - tile_level));
+	instance.m_slice = m_procedural ? 0 : tile.m_slot;
+	frame.m_instances.push_back(instance);
+}
+
+
+void Terrain::getNodeBox(unsigned int level, unsigned int x, unsigned int y, float box_min[3], float box_max[3])
+{
+	const TerrainHeightBounds& bounds = m_bounds[m_level_offsets[level] + y * TerrainFile::getNodesPerSide(m_header, level) + x];
+	float size = (float)(m_header.m_chunk_size << level) * m_header.m_spacing;
+	float height_scale = m_header.m_height_scale / 65535.0f;
+
+	box_min[0] = m_origin.m_x + x * size;
+	box_min[1] = m_origin.m_y + bounds.m_min * height_scale;
+	box_min[2] = m_origin.m_z + y * size;
+	box_max[0] = box_min[0] + size;
+	box_max[1] = m_origin.m_y + bounds.m_max * height_scale;
+	box_max[2] = box_min[2] + size;
+}
+
+
+// outside when the corner furthest along the normal is behind one of the planes
+bool Terrain::isInFrustum(const float box_min[3], const float box_max[3])
+{
+	for (unsigned int i = 0; i < 6; i++)
+	{
+		const float* plane = m_planes[i];
+		float distance = plane[3];
+		for (unsigned int axis = 0; axis < 3; axis++)
+			distance += plane[axis] * (plane[axis] >= 0.0f ? box_max[axis] : box_min[axis]);
+		if (distance < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+
+bool Terrain::isInRange(const float box_min[3], const float box_max[3], float range)
+{
+	float distance = 0.0f;
+	for (unsigned int axis = 0; axis < 3; axis++)
+	{
+		float delta = std::max(std::max(box_min[axis] - m_camera[axis], m_camera[axis] - box_max[axis]), 0.0f);
+		distance += delta * delta;
+	}
+	return distance <= range * range;
+}
+
+
+unsigned int Terrain::getTileLevel(unsigned int level)
+{
+	return std::min(level, m_header.m_tile_levels - 1);
+}
+
+
+unsigned int Terrain::getTileIndex(unsigned int tile_level, unsigned int x, unsigned int y)
+{
+	unsigned int side = m_header.m_size / (m_header.m_tile_size << tile_level);
+	return m_tile_offsets[tile_level] + y * side + x;
+}
+
+
+unsigned int Terrain::getNodeTile(unsigned int level, unsigned int x, unsigned int y)
+{
+	unsigned int tile_level = getTileLevel(level);
+	unsigned int node_quads = m_header.m_chunk_size << level;
+	unsigned int tile_quads = m_header.m_tile_size << tile_level;
+	return getTileIndex(tile_level, x * node_quads / tile_quads, y * node_quads / tile_quads);
+}
+
+
+bool Terrain::requestTile(unsigned int index)
+{
+	if (m_procedural)
+		return true;
+
+	Tile& tile = m_tiles[index];
+	tile.m_last_used = m_frame;
+	if (tile.m_state == TileState::Resident)
+		return true;
+
+	if (tile.m_state == TileState::Absent)
+	{
+		tile.m_state = TileState::Requested;
+		m_requested.push_back(index);
+	}
+	return false;
+}
+
+
+/*
+	- the tiles read since the last frame get a slot, at most UPLOADS_PER_FRAME per frame. The rest waits
+	- a new batch of reads starts when the last one is complete. Requests no node asked for in the last frame are
+	  dropped: the camera moved on
+*/
+
+void Terrain::updateStreaming(TerrainFrame& frame)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_read_mutex);
+		m_reads_in_flight -= (unsigned int)m_read_tiles.size();
+		for (ReadTile& read_tile : m_read_tiles)
+		{
+			if (TerrainFile::openTile(read_tile.m_data.data(), read_tile.m_data.size(), m_header))
+			{
+				m_tiles[read_tile.m_tile].m_state = TileState::Ready;
+				m_ready_tiles.push_back(std::move(read_tile));
+			}
+			else
+			{
+				m_tiles[read_tile.m_tile].m_state = TileState::Failed;
+			}
+		}
+		m_read_tiles.clear();
+	}
+
+	unsigned int uploads = 0;
+	while (!m_ready_tiles.empty() && uploads < UPLOADS_PER_FRAME)
+	{
+		ReadTile& read_tile = m_ready_tiles.front();
+		if (!assignSlot(read_tile.m_tile, TerrainFile::openTile(read_tile.m_data.data(), read_tile.m_data.size(), m_header), frame))
+			break;
+		m_ready_tiles.erase(m_ready_tiles.begin());
+		uploads++;
+	}
+
+	if (m_reads_in_flight || m_requested.empty())
+		return;
+
+	size_t next = 0;
+	for (; next < m_requested.size() && m_reads_in_flight < READS_PER_BATCH; next++)
+	{
+		unsigned int index = m_requested[next];
+		Tile& tile = m_tiles[index];
+		if (tile.m_last_used + 1 < m_frame)
+		{
+			tile.m_state = TileState::Absent;
+			continue;
+		}
+
+		unsigned int level = 0;
+		while (level + 1 < m_header.m_tile_levels && m_tile_offsets[level + 1] <= index)
+			level++;
+		unsigned int side = m_header.m_size / (m_header.m_tile_size << level);
+		unsigned int local = index - m_tile_offsets[level];
+
+		tile.m_state = TileState::Loading;
+		m_reader.read(TerrainFile::getTilePath(m_directory.c_str(), level, local % side, local / side),
+			[this, index](const std::wstring& path, std::vector<unsigned char>& data, bool ok)
+			{
+				ReadTile read_tile;
+				read_tile.m_tile = index;
+				if (ok)
+					read_tile.m_data = std::move(data);
+
+				std::lock_guard<std::mutex> lock(m_read_mutex);
+				m_read_tiles.push_back(std::move(read_tile));
+			});
+		m_reads_in_flight++;
+	}
+	m_requested.erase(m_requested.begin(), m_requested.begin() + next);
+
+	if (m_reads_in_flight)
+		m_reader.submit();
+}
+
+
+// a free slot, otherwise the tile used longest ago that was not used in the last frames
+bool Terrain::assignSlot(unsigned int index, const unsigned short* heights, TerrainFrame& frame)
+{
+	unsigned int slot = ~0u;
+	unsigned long long oldest = m_frame;
+	for (unsigned int i = 0; i < TILE_SLOTS; i++)
+	{
+		if (m_slots[i] == ~0u)
+		{
+			slot = i;
+			break;
+		}
+
+		const Tile& used = m_tiles[m_slots[i]];
+		if (m_slots[i] != m_root_tile && used.m_last_used + EVICT_FRAMES < m_frame && used.m_last_used < oldest)
+		{
+			oldest = used.m_last_used;
+			slot = i;
+		}
+	}
+
+	if (slot == ~0u)
+		return false;
+
+	if (m_slots[slot] != ~0u)
+		m_tiles[m_slots[slot]].m_state = TileState::Absent;
+
+	Tile& tile = m_tiles[index];
+	tile.m_state = TileState::Resident;
+	tile.m_slot = slot;
+	tile.m_last_used = m_frame;
+	m_slots[slot] = index;
+
+	unsigned int samples = m_header.m_tile_size + 1;
+	frame.m_uploads.emplace_back();
+	frame.m_uploads.back().m_slice = slot;
+	frame.m_uploads.back().m_heights.assign(heights, heights + (size_t)samples * samples);
+	m_tiles_streamed++;
+	return true;
+}
+
+
+/*
+	- the camera circles over the map at a third of its size from the center, looking ahead and down, with a far plane
+	  at the size of the map -> every level of the quadtree is visible in every frame
+	- the same lod distance as the default of the scene
+*/
+
+TerrainBenchmark Terrain::runBenchmark(unsigned int size, unsigned int frames)
+{
+	TerrainBenchmark result;
+	result.m_size = size;
+	result.m_frames = frames;
+	result.m_full_vertices = (unsigned long long)(size + 1) * (size + 1);
+
+	Terrain terrain;
+	auto start = std::chrono::high_resolution_clock::now();
+	terrain.createProcedural(size, 32, 1.0f, size / 16.0f);
+	result.m_build_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	if (!terrain.isOpen() || !frames)
+		return result;
+
+	Matrix4x4 proj;
+	proj.setPerspectiveFovLH(1.6f, 16.0f / 9.0f, 0.1f, (float)size);
+
+	TerrainFrame frame;
+	for (unsigned int i = 0; i < frames; i++)
+	{
+		float angle = 6.2831853f * i / frames;
+		float radius = size / 3.0f;
+		Vector3D camera(size * 0.5f + cosf(angle) * radius, size / 16.0f * 0.75f, size * 0.5f + sinf(angle) * radius);
+
+		Matrix4x4 view, temp;
+		view.setIdentity();
+		view.setRotationX(0.3f);
+		temp.setIdentity();
+		temp.setRotationY(-angle);
+		view *= temp;
+		view.setTranslation(camera);
+		view.inverse();
+
+		terrain.select(view, proj, camera, 2.5f, frame);
+
+		const TerrainStats& stats = frame.m_stats;
+		result.m_average_select_ms += stats.m_select_ms;
+		result.m_max_select_ms = std::max(result.m_max_select_ms, stats.m_select_ms);
+		result.m_average_instances += stats.m_instances;
+		result.m_average_vertices += (double)stats.m_vertices;
+		result.m_average_triangles += (double)stats.m_triangles;
+	}
+
+	result.m_average_select_ms /= frames;
+	result.m_average_instances /= frames;
+	result.m_average_vertices /= frames;
+	result.m_average_triangles /= frames;
+	return result;
+}
+
+
+Terrain::~Terrain()
+{
+	// the completions write into this object
+	m_reader.wait();
+}
@@ -0,0 +1,219 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "TerrainFile.h"
+#include "AsyncFileReader.h"
+#include "ConstantBuffer.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+// one quadrant of a quadtree node: the shared grid of chunk_size / 2 quads placed on the map, TerrainShader.hlsl t0
+struct TerrainInstance
+{
+	float m_offset[2] = {};					// world x z of the first grid vertex
+	float m_quad_size = 0.0f;				// world size of one grid quad
+	float m_morph_start = 0.0f;				// camera distance where the odd vertices start moving to the coarser grid
+	float m_uv_offset[2] = {};				// height tile texel of the first grid vertex
+	float m_uv_step = 0.0f;					// height tile texels per grid quad
+	float m_morph_end = 0.0f;				// camera distance where the grid matches the next level
+	unsigned int m_slice = 0;				// slice of the tile in the height tile array
+	float m_pad[3] = {};
+};
+
+// heights of a tile for a slice of the height tile array, uploaded by the render thread
+struct TerrainTileUpload
+{
+	unsigned int m_slice = 0;
+	std::vector<unsigned short> m_heights;	// (tile_size + 1)^2
+};
+
+struct TerrainStats
+{
+	unsigned int m_nodes_visited = 0;
+	unsigned int m_nodes_culled = 0;		// outside of the frustum
+	unsigned int m_instances = 0;
+	unsigned long long m_vertices = 0;		// grid vertices of all instances
+	unsigned long long m_triangles = 0;
+	unsigned int m_waiting = 0;				// nodes drawn coarser because the tiles of their children are not there yet
+	unsigned int m_tiles_resident = 0;
+	unsigned int m_tiles_loading = 0;
+	unsigned int m_tiles_streamed = 0;		// uploads since open()
+	double m_select_ms = 0.0;
+};
+
+// what the render thread needs to draw the terrain of one frame
+struct TerrainFrame
+{
+	std::vector<TerrainInstance> m_instances;
+	std::vector<TerrainTileUpload> m_uploads;
+	TerrainConstantType m_constants;
+	TerrainStats m_stats;
+};
+
+struct TerrainBenchmark
+{
+	unsigned int m_size = 0;
+	unsigned int m_frames = 0;
+	double m_build_ms = 0.0;				// bounds of the quadtree
+	double m_average_select_ms = 0.0;
+	double m_max_select_ms = 0.0;
+	double m_average_instances = 0.0;
+	double m_average_vertices = 0.0;
+	double m_average_triangles = 0.0;
+	unsigned long long m_full_vertices = 0;	// the whole map at full resolution
+};
+
+
+/*
+	Terrain: heightmap terrain of TerrainFile, drawn as instances of one grid with quadtree level of detail (CDLOD)
+
+	- select() walks the quadtree from the root. Level l is used up to lod_distance * leaf size * 2^l from the camera,
+	  the test is the distance to the bounding box of a node -> a level only borders the next finer or coarser one
+	- a node inside the range of the next finer level is split, its children that are out of range are drawn as
+	  quadrants of the node. Nodes outside of the frustum are skipped with all their children
+	- morphing: in the last 30 % of its range the odd vertices of an instance move onto the grid of the next level ->
+	  at the border both levels have the same vertices, no cracks and no popping
+	- streaming: a level of the quadtree reads the heights of the tile level with the same spacing (or the last, which
+	  is one tile). A node is only split when the tiles of its children are resident, missing tiles are requested and
+	  read in batches by the AsyncFileReader while the node is drawn coarser. Read tiles get a slot in the height
+	  tile array, the least recently used tile is replaced. The tile of the root is read by open() and never replaced
+	- game thread only: the render thread gets the instances and the heights to upload in the TerrainFrame
+*/
+
+class Terrain
+{
+public:
+
+	static const unsigned int TILE_SLOTS = 128;			// slices of the height tile array
+	static const unsigned int MAX_INSTANCES = 4096;
+	static const unsigned int UPLOADS_PER_FRAME = 4;
+	static const unsigned int READS_PER_BATCH = 8;
+	static const unsigned int EVICT_FRAMES = 8;			// a tile used in the last frames is not replaced
+
+public:
+
+	Terrain();
+	// waits for the reads that are still running
+	~Terrain();
+
+	// read terrain.gter and the tile of the root. False when there is no valid terrain in directory
+	bool open(const wchar_t* directory);
+	// the bounds of a procedural terrain (TerrainFile::generateHeight) without tiles, to measure the selection
+	void createProcedural(unsigned int size, unsigned int chunk_size, float spacing, float height_scale);
+	bool isOpen();
+
+	// world position of the first height
+	void setOrigin(const Vector3D& origin);
+	void getBoundingBox(Vector3D& min, Vector3D& max);
+	const TerrainFileHeader& getHeader();
+
+	// lod_distance: range of the leaves in leaf node sizes
+	void select(const Matrix4x4& view, const Matrix4x4& proj, const Vector3D& camera, float lod_distance, TerrainFrame& frame);
+
+	// a camera flying over a procedural terrain of size quads per side
+	static TerrainBenchmark runBenchmark(unsigned int size, unsigned int frames);
+
+private:
+
+	enum class TileState
+	{
+		Absent,
+		Requested,							// waits for the next batch of reads
+		Loading,
+		Ready,								// read, waits for a slot
+		Resident,
+		Failed
+	};
+
+	struct Tile
+	{
+		TileState m_state = TileState::Absent;
+		unsigned int m_slot = 0;
+		unsigned long long m_last_used = 0;
+	};
+
+	struct ReadTile
+	{
+		unsigned int m_tile = 0;
+		std::vector<unsigned char> m_data;
+	};
+
+	// tile indices, empty slots and the ranges for the levels of m_header
+	void initTiles();
+
+	// draws the node itself or its children. False when the node is out of its range: the parent draws the area
+	bool selectNode(unsigned int level, unsigned int x, unsigned int y, TerrainFrame& frame);
+	// one quadrant (0 - 3) of a node, if it is in the frustum
+	void addQuadrant(unsigned int level, unsigned int x, unsigned int y, unsigned int quadrant, TerrainFrame& frame);
+
+	void getNodeBox(unsigned int level, unsigned int x, unsigned int y, float box_min[3], float box_max[3]);
+	bool isInFrustum(const float box_min[3], const float box_max[3]);
+	bool isInRange(const float box_min[3], const float box_max[3], float range);
+
+	// tile level and tile index of the heights of a node
+	unsigned int getTileLevel(unsigned int level);
+	unsigned int getTileIndex(unsigned int tile_level, unsigned int x, unsigned int y);
+	// index of the tile a node of level is in
+	unsigned int getNodeTile(unsigned int level, unsigned int x, unsigned int y);
+	// true when the tile is resident, otherwise it is requested
+	bool requestTile(unsigned int tile);
+
+	// read finished tiles into slots, start the next batch of reads
+	void updateStreaming(TerrainFrame& frame);
+	bool assignSlot(unsigned int tile, const unsigned short* heights, TerrainFrame& frame);
+
+private:
+
+	std::wstring m_directory;
+	TerrainFileHeader m_header;
+	std::vector<TerrainHeightBounds> m_bounds;
+	std::vector<unsigned int> m_level_offsets;		// first node of each quadtree level in m_bounds
+	std::vector<unsigned int> m_tile_offsets;		// first tile of each tile level in m_tiles
+	bool m_open = false;
+	bool m_procedural = false;						// no tiles: every tile counts as resident
+	Vector3D m_origin;
+
+	std::vector<Tile> m_tiles;
+	std::vector<unsigned int> m_slots;				// tile in each slot, or ~0u
+	std::vector<unsigned int> m_requested;
+	unsigned int m_root_tile = 0;
+	unsigned long long m_frame = 0;
+	unsigned int m_tiles_streamed = 0;
+
+	AsyncFileReader m_reader;
+	unsigned int m_reads_in_flight = 0;				// reads of the current batch whose completion did not arrive
+	std::vector<ReadTile> m_read_tiles;				// filled by the completion jobs
+	std::mutex m_read_mutex;
+	std::vector<ReadTile> m_ready_tiles;			// read, waiting for a slot
+
+	// of the current select()
+	float m_planes[6][4] = {};
+	float m_camera[3] = {};
+	std::vector<float> m_ranges;					// per quadtree level
+	TerrainStats m_stats;
+};
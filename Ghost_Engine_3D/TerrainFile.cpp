@@ -0,0 +1,322 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "TerrainFile.h"
+#include "MappedFile.h"
+#include "JobSystem.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+
+static bool isPowerOfTwo(unsigned int value)
+{
+	return value && !(value & (value - 1));
+}
+
+static unsigned int log2u(unsigned int value)
+{
+	unsigned int result = 0;
+	while (value > 1)
+	{
+		value >>= 1;
+		result++;
+	}
+	return result;
+}
+
+// through a temporary file like the other cooked files, so a crash never leaves half a file
+static bool writeFile(const std::wstring& file, const void* data, size_t size)
+{
+	std::wstring temp = file + L".tmp";
+
+	HANDLE handle = ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	DWORD written = 0;
+	BOOL ok = ::WriteFile(handle, data, (DWORD)size, &written, nullptr);
+	::CloseHandle(handle);
+
+	if (!ok || written != size)
+	{
+		::DeleteFileW(temp.c_str());
+		return false;
+	}
+
+	return ::MoveFileExW(temp.c_str(), file.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+
+bool TerrainFile::setLevels(TerrainFileHeader& header)
+{
+	if (!isPowerOfTwo(header.m_size) || !isPowerOfTwo(header.m_tile_size) || !isPowerOfTwo(header.m_chunk_size))
+		return false;
+	if (header.m_chunk_size < 4 || header.m_chunk_size > header.m_tile_size || header.m_tile_size > header.m_size)
+		return false;
+
+	header.m_node_levels = log2u(header.m_size / header.m_chunk_size) + 1;
+	header.m_tile_levels = log2u(header.m_size / header.m_tile_size) + 1;
+	return true;
+}
+
+
+unsigned int TerrainFile::getNodesPerSide(const TerrainFileHeader& header, unsigned int level)
+{
+	return header.m_size / (header.m_chunk_size << level);
+}
+
+
+size_t TerrainFile::getLevelOffset(const TerrainFileHeader& header, unsigned int level)
+{
+	size_t offset = 0;
+	for (unsigned int i = 0; i < level; i++)
+	{
+		size_t side = getNodesPerSide(header, i);
+		offset += side * side;
+	}
+	return offset;
+}
+
+
+void TerrainFile::buildBounds(const TerrainFileHeader& header, std::vector<TerrainHeightBounds>& bounds)
+{
+	bounds.resize(getLevelOffset(header, header.m_node_levels));
+
+	for (unsigned int level = 1; level < header.m_node_levels; level++)
+	{
+		const TerrainHeightBounds* children = bounds.data() + getLevelOffset(header, level - 1);
+		TerrainHeightBounds* nodes = bounds.data() + getLevelOffset(header, level);
+		unsigned int side = getNodesPerSide(header, level);
+
+		for (unsigned int y = 0; y < side; y++)
+		{
+			for (unsigned int x = 0; x < side; x++)
+			{
+				TerrainHeightBounds& node = nodes[y * side + x];
+				node.m_min = 0xffff;
+				node.m_max = 0;
+				for (unsigned int child = 0; child < 4; child++)
+				{
+					const TerrainHeightBounds& bound = children[(y * 2 + (child >> 1)) * side * 2 + x * 2 + (child & 1)];
+					node.m_min = std::min(node.m_min, bound.m_min);
+					node.m_max = std::max(node.m_max, bound.m_max);
+				}
+			}
+		}
+	}
+}
+
+
+/*
+	- leaf bounds over the (chunk_size + 1)^2 heights of each leaf, rows of leaves in parallel
+	- tiles: every level in parallel over its tiles, each tile picks every 2^level-th height
+*/
+
+bool TerrainFile::write(const wchar_t* directory, const TerrainFileHeader& source_header, const std::vector<unsigned short>& heights)
+{
+	TerrainFileHeader header = source_header;
+	if (!setLevels(header))
+		return false;
+
+	size_t stride = (size_t)header.m_size + 1;
+	if (heights.size() != stride * stride)
+		return false;
+
+	::CreateDirectoryW(directory, nullptr);
+
+	std::vector<TerrainHeightBounds> bounds(getLevelOffset(header, header.m_node_levels));
+	unsigned int leaves = getNodesPerSide(header, 0);
+	unsigned int chunk = header.m_chunk_size;
+	JobSystem::get()->parallelFor(leaves, 1, [&](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int y = begin; y < end; y++)
+			{
+				for (unsigned int x = 0; x < leaves; x++)
+				{
+					TerrainHeightBounds& bound = bounds[y * leaves + x];
+					bound.m_min = 0xffff;
+					bound.m_max = 0;
+					for (unsigned int j = 0; j <= chunk; j++)
+					{
+						const unsigned short* row = heights.data() + (y * chunk + j) * stride + x * chunk;
+						for (unsigned int i = 0; i <= chunk; i++)
+						{
+							bound.m_min = std::min(bound.m_min, row[i]);
+							bound.m_max = std::max(bound.m_max, row[i]);
+						}
+					}
+				}
+			}
+		});
+	buildBounds(header, bounds);
+
+	std::vector<unsigned char> data(sizeof(TerrainFileHeader) + bounds.size() * sizeof(TerrainHeightBounds));
+	::memcpy(data.data(), &header, sizeof(header));
+	::memcpy(data.data() + sizeof(header), bounds.data(), bounds.size() * sizeof(TerrainHeightBounds));
+	if (!writeFile(getTerrainPath(directory), data.data(), data.size()))
+		return false;
+
+	std::atomic<bool> ok(true);
+	unsigned int samples = header.m_tile_size + 1;
+	for (unsigned int level = 0; level < header.m_tile_levels; level++)
+	{
+		unsigned int side = header.m_size / (header.m_tile_size << level);
+		JobSystem::get()->parallelFor(side * side, 1, [&](unsigned int begin, unsigned int end)
+			{
+				std::vector<unsigned char> tile(sizeof(TerrainTileHeader) + (size_t)samples * samples * sizeof(unsigned short));
+				for (unsigned int index = begin; index < end; index++)
+				{
+					TerrainTileHeader tile_header;
+					tile_header.m_level = level;
+					tile_header.m_x = index % side;
+					tile_header.m_y = index / side;
+					tile_header.m_samples = samples;
+					::memcpy(tile.data(), &tile_header, sizeof(tile_header));
+
+					unsigned short* tile_heights = (unsigned short*)(tile.data() + sizeof(tile_header));
+					size_t x0 = (size_t)tile_header.m_x * (header.m_tile_size << level);
+					size_t y0 = (size_t)tile_header.m_y * (header.m_tile_size << level);
+					for (unsigned int j = 0; j < samples; j++)
+					{
+						for (unsigned int i = 0; i < samples; i++)
+							tile_heights[j * samples + i] = heights[(y0 + ((size_t)j << level)) * stride + x0 + ((size_t)i << level)];
+					}
+
+					if (!writeFile(getTilePath(directory, level, tile_header.m_x, tile_header.m_y), tile.data(), tile.size()))
+						ok = false;
+				}
+			});
+	}
+
+	return ok;
+}
+
+
+bool TerrainFile::readRaw(const wchar_t* file, unsigned int size, std::vector<unsigned short>& heights)
+{
+	MappedFile mapped;
+	if (!mapped.open(file))
+		return false;
+
+	size_t count = mapped.getSize() / sizeof(unsigned short);
+	size_t side = (size_t)sqrt((double)count);
+	while (side * side > count) side--;
+	if (side < 2)
+		return false;
+
+	const unsigned short* source = (const unsigned short*)mapped.getData();
+	size_t stride = (size_t)size + 1;
+	heights.resize(stride * stride);
+	for (size_t y = 0; y < stride; y++)
+	{
+		for (size_t x = 0; x < stride; x++)
+			heights[y * stride + x] = source[std::min(y, side - 1) * side + std::min(x, side - 1)];
+	}
+	return true;
+}
+
+
+NoiseSettings TerrainFile::getNoiseSettings(unsigned int size)
+{
+	NoiseSettings settings;
+	settings.m_type = NoiseType::Simplex;
+	settings.m_fractal = NoiseFractal::Ridged;
+	settings.m_seed = 0;
+	settings.m_frequency = 4.0f / size;
+	settings.m_octaves = std::min(log2u(std::max(size / 8, 1u)) + 1, 10u);
+	return settings;
+}
+
+
+// the same noise as generate(), one height at a time
+unsigned short TerrainFile::generateHeight(unsigned int x, unsigned int y, unsigned int size)
+{
+	return Noise::toHeight(Noise::sample2D(getNoiseSettings(size), (float)x, (float)y));
+}
+
+
+void TerrainFile::generate(unsigned int size, std::vector<unsigned short>& heights)
+{
+	heights.resize(((size_t)size + 1) * (size + 1));
+	Noise::fillHeights(getNoiseSettings(size), size + 1, size + 1, heights.data());
+}
+
+
+/*
+	validate everything that is later used as offset or size -> a broken file is rejected instead of read out of bounds
+*/
+
+bool TerrainFile::open(const unsigned char* data, size_t size, TerrainFileHeader& header, std::vector<TerrainHeightBounds>& bounds)
+{
+	if (size < sizeof(TerrainFileHeader))
+		return false;
+
+	::memcpy(&header, data, sizeof(header));
+	if (header.m_magic != TERRAIN_FILE_MAGIC || header.m_version != TERRAIN_FILE_VERSION)
+		return false;
+
+	TerrainFileHeader check = header;
+	if (!setLevels(check) || check.m_node_levels != header.m_node_levels || check.m_tile_levels != header.m_tile_levels)
+		return false;
+
+	size_t count = getLevelOffset(header, header.m_node_levels);
+	if (size < sizeof(TerrainFileHeader) + count * sizeof(TerrainHeightBounds))
+		return false;
+
+	bounds.resize(count);
+	::memcpy(bounds.data(), data + sizeof(TerrainFileHeader), count * sizeof(TerrainHeightBounds));
+	return true;
+}
+
+
+const unsigned short* TerrainFile::openTile(const unsigned char* data, size_t size, const TerrainFileHeader& header)
+{
+	unsigned int samples = header.m_tile_size + 1;
+	if (size < sizeof(TerrainTileHeader) + (size_t)samples * samples * sizeof(unsigned short))
+		return nullptr;
+
+	const TerrainTileHeader* tile = (const TerrainTileHeader*)data;
+	if (tile->m_magic != TERRAIN_TILE_MAGIC || tile->m_samples != samples || tile->m_level >= header.m_tile_levels)
+		return nullptr;
+
+	return (const unsigned short*)(data + sizeof(TerrainTileHeader));
+}
+
+
+std::wstring TerrainFile::getTerrainPath(const wchar_t* directory)
+{
+	return std::wstring(directory) + L"\\terrain.gter";
+}
+
+
+std::wstring TerrainFile::getTilePath(const wchar_t* directory, unsigned int level, unsigned int x, unsigned int y)
+{
+	return std::wstring(directory) + L"\\tile_" + std::to_wstring(level) + L"_" + std::to_wstring(x) + L"_" + std::to_wstring(y) + L".gtile";
+}
@@ -0,0 +1,114 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "Noise.h"
+#include <string>
+#include <vector>
+
+/*
+	Cooked terrain (one directory)
+
+		terrain.gter                TerrainFileHeader, then TerrainHeightBounds of all quadtree nodes: level by level
+		                            from the leaves (level 0) to the root, the nodes of a level row by row
+		tile_<level>_<x>_<y>.gtile  TerrainTileHeader, then (tile_size + 1)^2 heights, row by row
+
+	- heights are unsigned short, world height = height / 65535 * height_scale
+	- a leaf node of the quadtree covers chunk_size quads, each level above twice as many per side
+	- tile level l holds every 2^l-th height of the map: tile_size quads with a spacing of 2^l heights. The last row and
+	  column are the first of the next tile -> neighbouring tiles meet without a gap. The last level is one tile
+	- the bounds of a node are the lowest and highest height of the full map inside it. A coarse level only leaves out
+	  heights, so its surface stays within the same bounds
+	- all values are little endian
+*/
+
+static const unsigned int TERRAIN_FILE_MAGIC = 0x52455447;		// "GTER"
+static const unsigned int TERRAIN_TILE_MAGIC = 0x4C495447;		// "GTIL"
+static const unsigned int TERRAIN_FILE_VERSION = 1;
+
+struct TerrainFileHeader
+{
+	unsigned int m_magic = TERRAIN_FILE_MAGIC;
+	unsigned int m_version = TERRAIN_FILE_VERSION;
+	unsigned int m_size = 0;				// quads per side, a power of two
+	unsigned int m_tile_size = 256;			// quads per side of a tile, a power of two
+	unsigned int m_chunk_size = 32;			// quads per side of a leaf node, a power of two of at least 4
+	unsigned int m_node_levels = 0;			// quadtree levels, leaves to root
+	unsigned int m_tile_levels = 0;
+	float m_spacing = 1.0f;					// world size of one quad
+	float m_height_scale = 1.0f;			// world height of the height 65535
+	unsigned int m_reserved[3] = {};
+};
+
+struct TerrainTileHeader
+{
+	unsigned int m_magic = TERRAIN_TILE_MAGIC;
+	unsigned int m_level = 0;
+	unsigned int m_x = 0;
+	unsigned int m_y = 0;
+	unsigned int m_samples = 0;				// tile_size + 1 heights per side
+	unsigned int m_reserved[3] = {};
+};
+
+struct TerrainHeightBounds
+{
+	unsigned short m_min = 0;
+	unsigned short m_max = 0;
+};
+
+
+class TerrainFile
+{
+public:
+
+	// fill the level counts of a header from size, tile size and chunk size. False when they do not fit together
+	static bool setLevels(TerrainFileHeader& header);
+
+	// heights of the whole map, (size + 1)^2 row by row -> terrain.gter and the tiles of all levels
+	static bool write(const wchar_t* directory, const TerrainFileHeader& header, const std::vector<unsigned short>& heights);
+
+	// a square 16-bit raw heightmap, resampled to (size + 1)^2 by clamping at its border
+	static bool readRaw(const wchar_t* file, unsigned int size, std::vector<unsigned short>& heights);
+	// test terrain without a source: ridged simplex noise, the largest hills a quarter of the map, octaves down to
+	// features of a few heights. Repeatable for every size
+	static NoiseSettings getNoiseSettings(unsigned int size);
+	static unsigned short generateHeight(unsigned int x, unsigned int y, unsigned int size);
+	static void generate(unsigned int size, std::vector<unsigned short>& heights);
+
+	// the bounds of all levels from the bounds of the leaves (level 0, nodes row by row)
+	static void buildBounds(const TerrainFileHeader& header, std::vector<TerrainHeightBounds>& bounds);
+	// nodes per side of a quadtree level and the index of its first node in the bounds
+	static unsigned int getNodesPerSide(const TerrainFileHeader& header, unsigned int level);
+	static size_t getLevelOffset(const TerrainFileHeader& header, unsigned int level);
+
+	// validate terrain.gter from memory and copy its header and bounds
+	static bool open(const unsigned char* data, size_t size, TerrainFileHeader& header, std::vector<TerrainHeightBounds>& bounds);
+	// validate a tile of the terrain and return its heights (pointing into data)
+	static const unsigned short* openTile(const unsigned char* data, size_t size, const TerrainFileHeader& header);
+
+	static std::wstring getTerrainPath(const wchar_t* directory);
+	static std::wstring getTilePath(const wchar_t* directory, unsigned int level, unsigned int x, unsigned int y);
+};
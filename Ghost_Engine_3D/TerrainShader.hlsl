@@ -0,0 +1,166 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+/*
+	terrain of Terrain (CDLOD): no vertex buffer. Every instance is the same grid of m_grid_size quads, the vertex comes
+	from SV_VertexID and is placed by the TerrainInstance of SV_InstanceID (DeviceContext::drawIndexedInstancedVertexID)
+	- heights: Load from the slice of the instance in the height tile array, bilinear by hand so a morphing vertex
+	  moves smoothly between two heights
+	- morph: near the end of its range the odd vertices of an instance slide onto the even ones -> the grid becomes
+	  the grid of the next coarser level where the levels meet
+*/
+struct VS_OUTPUT
+{
+	float4 position: SV_POSITION;
+	float3 world: TEXCOORD0;
+	float3 normal: NORMAL0;
+};
+
+cbuffer constant: register(b0)
+{
+	row_major float4x4 m_world;
+	row_major float4x4 m_view;
+	row_major float4x4 m_proj;
+	unsigned int m_time;
+	float3 ambientColor;
+	float ambientPower;
+	float3 m_vectorLight;
+};
+
+// TerrainConstantType
+cbuffer terrain: register(b1)
+{
+	float3 m_camera;
+	float m_height_scale;
+	float3 m_origin;
+	float m_tile_samples;
+	uint m_grid_size;
+};
+
+struct TerrainInstance
+{
+	float2 offset;
+	float quad_size;
+	float morph_start;
+	float2 uv_offset;
+	float uv_step;
+	float morph_end;
+	uint slice;
+	float3 pad;
+};
+
+StructuredBuffer<TerrainInstance> Instances: register(t0);
+Texture2DArray<float> HeightTiles: register(t1);
+Texture2DArray<float> DetailNoise: register(t2);		// Noise::fillTexels, tileable
+
+
+float loadHeight(int2 texel, uint slice)
+{
+	texel = clamp(texel, 0, (int)m_tile_samples - 1);
+	return HeightTiles.Load(int4(texel, slice, 0));
+}
+
+float sampleHeight(float2 texel, uint slice)
+{
+	float2 base = floor(texel);
+	float2 weight = texel - base;
+	int2 index = (int2)base;
+
+	float top = lerp(loadHeight(index, slice), loadHeight(index + int2(1, 0), slice), weight.x);
+	float bottom = lerp(loadHeight(index + int2(0, 1), slice), loadHeight(index + int2(1, 1), slice), weight.x);
+	return lerp(top, bottom, weight.y) * m_height_scale;
+}
+
+
+VS_OUTPUT vsmain(uint id: SV_VertexID, uint instance_id: SV_InstanceID)
+{
+	VS_OUTPUT output = (VS_OUTPUT)0;
+
+	TerrainInstance instance = Instances[instance_id];
+	float2 grid = float2(id % (m_grid_size + 1), id / (m_grid_size + 1));
+
+	// distance of the unmorphed vertex decides how far it morphs
+	float2 texel = instance.uv_offset + grid * instance.uv_step;
+	float3 position = float3(instance.offset.x + grid.x * instance.quad_size, 0.0f, instance.offset.y + grid.y * instance.quad_size);
+	position.y = m_origin.y + sampleHeight(texel, instance.slice);
+
+	float morph = saturate((distance(position, m_camera) - instance.morph_start) / max(instance.morph_end - instance.morph_start, 0.0001f));
+	grid -= frac(grid * 0.5f) * 2.0f * morph;
+
+	texel = instance.uv_offset + grid * instance.uv_step;
+	position.xz = instance.offset + grid * instance.quad_size;
+	position.y = m_origin.y + sampleHeight(texel, instance.slice);
+
+	// normal from the heights one texel to each side
+	float texel_size = instance.quad_size / instance.uv_step;
+	float dx = sampleHeight(texel + float2(1.0f, 0.0f), instance.slice) - sampleHeight(texel - float2(1.0f, 0.0f), instance.slice);
+	float dz = sampleHeight(texel + float2(0.0f, 1.0f), instance.slice) - sampleHeight(texel - float2(0.0f, 1.0f), instance.slice);
+	output.normal = normalize(float3(-dx, 2.0f * texel_size, -dz));
+
+	output.world = position;
+	output.position = mul(float4(position, 1.0f), m_view);
+	output.position = mul(output.position, m_proj);
+
+	return output;
+}
+
+
+// detail noise at a world position: one repeat per 4 units, wrapped and bilinear by hand like the heights
+float sampleDetail(float2 world)
+{
+	uint width, height, slices;
+	DetailNoise.GetDimensions(width, height, slices);
+
+	float2 texel = world * (width / 4.0f) - 0.5f;
+	float2 base = floor(texel);
+	float2 weight = texel - base;
+	int2 index = (int2)base;
+	int2 mask = int2(width, height) - 1;
+
+	float top = lerp(DetailNoise.Load(int4(index & mask, 0, 0)), DetailNoise.Load(int4((index + int2(1, 0)) & mask, 0, 0)), weight.x);
+	float bottom = lerp(DetailNoise.Load(int4((index + int2(0, 1)) & mask, 0, 0)), DetailNoise.Load(int4((index + int2(1, 1)) & mask, 0, 0)), weight.x);
+	return lerp(top, bottom, weight.y);
+}
+
+
+// grass on flat ground, rock on steep slopes, snow on high flat ground. Detail noise up close, faded out with distance
+float4 psmain(VS_OUTPUT input) : SV_TARGET
+{
+	float3 normal = normalize(input.normal);
+	float height = saturate((input.world.y - m_origin.y) / max(m_height_scale, 0.0001f));
+
+	float3 grass = float3(0.22f, 0.36f, 0.14f);
+	float3 rock = float3(0.38f, 0.34f, 0.30f);
+	float3 snow = float3(0.85f, 0.87f, 0.90f);
+
+	float3 color = lerp(grass, rock, smoothstep(0.75f, 0.55f, normal.y));
+	color = lerp(color, snow, smoothstep(0.6f, 0.75f, height) * smoothstep(0.6f, 0.8f, normal.y));
+	float detail = lerp(0.75f, 1.25f, sampleDetail(input.world.xz));
+	color *= lerp(detail, 1.0f, saturate(distance(input.world, m_camera) / 40.0f));
+
+	float3 light = ambientColor * ambientPower * 0.5f + max(dot(m_vectorLight, normal), 0.0f) * 1.5f;
+	return float4(color * light, 1.0f);
+}
@@ -0,0 +1,106 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "TextureArray.h"
+#include "GraphicsEngine.h"
+#include "DeviceContext.h"
+
+#include <exception>
+
+/*
+	- default usage: the slices are written with UpdateSubresource, one mip level -> subresource index = slice
+*/
+
+TextureArray::TextureArray(UINT width, UINT height, UINT slices, DXGI_FORMAT format) :m_width(width), m_height(height), m_slices(slices)
+{
+	ID3D11Device* device = GraphicsEngine::get()->m_d3d_device;
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = width;
+	desc.Height = height;
+	desc.MipLevels = 1;
+	desc.ArraySize = slices;
+	desc.Format = format;
+	desc.SampleDesc.Count = 1;
+	desc.SampleDesc.Quality = 0;
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = 0;
+	desc.MiscFlags = 0;
+
+	if (FAILED(device->CreateTexture2D(&desc, nullptr, &m_texture)))
+	{
+		throw std::exception("Create Texture Array was not successful");
+	}
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srv_desc = {};
+	srv_desc.Format = format;
+	srv_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2DARRAY;
+	srv_desc.Texture2DArray.MostDetailedMip = 0;
+	srv_desc.Texture2DArray.MipLevels = 1;
+	srv_desc.Texture2DArray.FirstArraySlice = 0;
+	srv_desc.Texture2DArray.ArraySize = slices;
+
+	if (FAILED(device->CreateShaderResourceView(m_texture, &srv_desc, &m_srv)))
+	{
+		m_texture->Release();
+		throw std::exception("Create Texture Array View was not successful");
+	}
+}
+
+
+void TextureArray::update(DeviceContext* context, UINT slice, const void* data, UINT row_pitch)
+{
+	if (slice >= m_slices)
+		return;
+
+	context->m_device_context->UpdateSubresource(m_texture, slice, nullptr, data, row_pitch, 0);
+}
+
+
+UINT TextureArray::getWidth()
+{
+	return m_width;
+}
+
+
+UINT TextureArray::getHeight()
+{
+	return m_height;
+}
+
+
+UINT TextureArray::getSliceCount()
+{
+	return m_slices;
+}
+
+
+TextureArray::~TextureArray()
+{
+	if (m_srv) m_srv->Release();
+	if (m_texture) m_texture->Release();
+}
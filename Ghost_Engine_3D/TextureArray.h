@@ -0,0 +1,65 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+
+class DeviceContext;
+
+/*
+	TextureArray: slices of the same size and format in one texture (Texture2DArray in HLSL)
+
+	- the CPU replaces single slices with update(), e.g. the height tiles Terrain streams in. The other slices stay
+	- read by the vertex shader, bound with DeviceContext::setTextureArray to a register t<slot>
+*/
+
+class TextureArray
+{
+public:
+
+	TextureArray(UINT width, UINT height, UINT slices, DXGI_FORMAT format);
+	~TextureArray();
+
+	// replace one slice. row_pitch: bytes of one row of data
+	void update(DeviceContext* context, UINT slice, const void* data, UINT row_pitch);
+
+	UINT getWidth();
+	UINT getHeight();
+	UINT getSliceCount();
+
+private:
+
+	ID3D11Texture2D* m_texture = nullptr;
+	ID3D11ShaderResourceView* m_srv = nullptr;
+
+	UINT m_width = 0;
+	UINT m_height = 0;
+	UINT m_slices = 0;
+
+private:
+
+	friend class DeviceContext;
+};
@@ -0,0 +1,269 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "TextureAtlas.h"
+#include "MipMapGenerator.h"
+#include "VertexMesh.h"
+
+#include <DirectXTex.h>
+
+// imgui_draw.cpp compiles imstb_rectpack as static functions -> this file needs its own copy of the implementation
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "Libs/ImGui/imstb_rectpack.h"
+
+
+TextureAtlas::TextureAtlas(unsigned int atlas_size, unsigned int padding, unsigned int mip_levels) :
+	m_atlas_size(atlas_size), m_padding(padding), m_mip_levels(mip_levels ? mip_levels : 1)
+{
+}
+
+
+int TextureAtlas::add(const DirectX::Image& image)
+{
+	if (image.format != DXGI_FORMAT_R8G8B8A8_UNORM && image.format != DXGI_FORMAT_B8G8R8A8_UNORM)
+		return -1;
+
+	if (m_format != DXGI_FORMAT_UNKNOWN && image.format != m_format)
+		return -1;
+
+	m_format = image.format;
+
+	Source source;
+	source.m_width = (unsigned int)image.width;
+	source.m_height = (unsigned int)image.height;
+	source.m_pixels.resize(image.width * image.height * 4);
+
+	for (size_t y = 0; y < image.height; y++)
+	{
+		::memcpy(&source.m_pixels[y * image.width * 4], image.pixels + y * image.rowPitch, image.width * 4);
+	}
+
+	m_sources.push_back(std::move(source));
+	m_regions.push_back(AtlasRegion());
+	return (int)m_sources.size() - 1;
+}
+
+
+/*
+	- sizes are converted into cells of 2^(mips-1) texels before packing -> every packed position is aligned for all levels
+	- stbrp_pack_rects packs as many rects as possible; the rest goes into the next atlas
+*/
+
+bool TextureAtlas::build()
+{
+	unsigned int cell = 1u << (m_mip_levels - 1);
+	unsigned int gutter = m_padding * cell;
+	int grid = (int)(m_atlas_size / cell);
+
+	std::vector<int> remaining;
+	for (size_t i = 0; i < m_sources.size(); i++)
+	{
+		remaining.push_back((int)i);
+	}
+
+	std::vector<stbrp_node> nodes(grid);
+
+	while (!remaining.empty())
+	{
+		std::vector<stbrp_rect> rects(remaining.size());
+		for (size_t i = 0; i < remaining.size(); i++)
+		{
+			const Source& source = m_sources[remaining[i]];
+			rects[i] = {};
+			rects[i].id = remaining[i];
+			rects[i].w = (stbrp_coord)((source.m_width + 2 * gutter + cell - 1) / cell);
+			rects[i].h = (stbrp_coord)((source.m_height + 2 * gutter + cell - 1) / cell);
+		}
+
+		stbrp_context context;
+		stbrp_init_target(&context, grid, grid, nodes.data(), grid);
+		stbrp_pack_rects(&context, rects.data(), (int)rects.size());
+
+		unsigned int atlas = (unsigned int)m_atlases.size();
+		std::vector<int> packed;
+		std::vector<int> left;
+
+		for (size_t i = 0; i < rects.size(); i++)
+		{
+			if (!rects[i].was_packed)
+			{
+				left.push_back(rects[i].id);
+				continue;
+			}
+
+			const Source& source = m_sources[rects[i].id];
+			AtlasRegion& region = m_regions[rects[i].id];
+			region.m_atlas = atlas;
+			region.m_x = rects[i].x * cell + gutter;
+			region.m_y = rects[i].y * cell + gutter;
+			region.m_width = source.m_width;
+			region.m_height = source.m_height;
+			region.m_u_scale = (float)source.m_width / m_atlas_size;
+			region.m_v_scale = (float)source.m_height / m_atlas_size;
+			region.m_u_offset = (float)region.m_x / m_atlas_size;
+			region.m_v_offset = (float)region.m_y / m_atlas_size;
+
+			packed.push_back(rects[i].id);
+		}
+
+		// nothing fits into an empty atlas -> an image is too big
+		if (packed.empty())
+			return false;
+
+		compose(atlas, packed);
+		remaining.swap(left);
+	}
+
+	return true;
+}
+
+
+/*
+	copy the images into a new atlas, extend their border texels into the gutter and build the mips
+*/
+
+void TextureAtlas::compose(unsigned int atlas, const std::vector<int>& images)
+{
+	unsigned int gutter = m_padding * (1u << (m_mip_levels - 1));
+	size_t pitch = (size_t)m_atlas_size * 4;
+
+	std::vector<unsigned char> pixels(pitch * m_atlas_size, 0);
+
+	for (size_t i = 0; i < images.size(); i++)
+	{
+		const Source& source = m_sources[images[i]];
+		const AtlasRegion& region = m_regions[images[i]];
+
+		int x0 = (int)region.m_x - (int)gutter;
+		int y0 = (int)region.m_y - (int)gutter;
+		int x1 = (int)(region.m_x + source.m_width + gutter);
+		int y1 = (int)(region.m_y + source.m_height + gutter);
+
+		for (int y = (y0 < 0 ? 0 : y0); y < y1 && y < (int)m_atlas_size; y++)
+		{
+			int sy = y - (int)region.m_y;
+			sy = (sy < 0) ? 0 : ((sy >= (int)source.m_height) ? source.m_height - 1 : sy);
+
+			for (int x = (x0 < 0 ? 0 : x0); x < x1 && x < (int)m_atlas_size; x++)
+			{
+				int sx = x - (int)region.m_x;
+				sx = (sx < 0) ? 0 : ((sx >= (int)source.m_width) ? source.m_width - 1 : sx);
+
+				::memcpy(&pixels[y * pitch + x * 4], &source.m_pixels[((size_t)sy * source.m_width + sx) * 4], 4);
+			}
+		}
+	}
+
+	DirectX::Image image = {};
+	image.width = m_atlas_size;
+	image.height = m_atlas_size;
+	image.format = m_format;
+	image.rowPitch = pitch;
+	image.slicePitch = pixels.size();
+	image.pixels = pixels.data();
+
+	DirectX::ScratchImage* chain = new DirectX::ScratchImage();
+	if (!MipMapGenerator::generate(image, MipFilter::Box, MipContent::Color, *chain, nullptr, m_mip_levels))
+		chain->InitializeFromImage(image);
+
+	m_atlases.push_back(chain);
+}
+
+
+const AtlasRegion& TextureAtlas::getRegion(int id)
+{
+	return m_regions[id];
+}
+
+
+unsigned int TextureAtlas::getAtlasCount()
+{
+	return (unsigned int)m_atlases.size();
+}
+
+
+const DirectX::ScratchImage& TextureAtlas::getAtlas(unsigned int index)
+{
+	return *m_atlases[index];
+}
+
+
+AtlasStats TextureAtlas::getStats()
+{
+	AtlasStats stats;
+	stats.m_atlases = (unsigned int)m_atlases.size();
+	stats.m_images = (unsigned int)m_sources.size();
+
+	for (size_t i = 0; i < m_sources.size(); i++)
+	{
+		stats.m_used_texels += (size_t)m_sources[i].m_width * m_sources[i].m_height;
+	}
+
+	stats.m_total_texels = (size_t)stats.m_atlases * m_atlas_size * m_atlas_size;
+	stats.m_efficiency = stats.m_total_texels ? (double)stats.m_used_texels / stats.m_total_texels : 0.0;
+	return stats;
+}
+
+
+bool TextureAtlas::fitsAtlas(const std::vector<VertexMesh>& vertices, const std::vector<unsigned short>& vertex_materials, unsigned short material)
+{
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		if (vertex_materials[i] != material)
+			continue;
+
+		const Vector2D& uv = vertices[i].m_Tex;
+		if (uv.m_x < 0.0f || uv.m_x > 1.0f || uv.m_y < 0.0f || uv.m_y > 1.0f)
+			return false;
+	}
+
+	return true;
+}
+
+
+void TextureAtlas::remapTexcoords(std::vector<VertexMesh>& vertices, const std::vector<unsigned short>& vertex_materials, unsigned short material,
+	const AtlasRegion& region)
+{
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		if (vertex_materials[i] != material)
+			continue;
+
+		Vector2D& uv = vertices[i].m_Tex;
+		uv.m_x = uv.m_x * region.m_u_scale + region.m_u_offset;
+		uv.m_y = uv.m_y * region.m_v_scale + region.m_v_offset;
+	}
+}
+
+
+TextureAtlas::~TextureAtlas()
+{
+	for (size_t i = 0; i < m_atlases.size(); i++)
+	{
+		delete m_atlases[i];
+	}
+}
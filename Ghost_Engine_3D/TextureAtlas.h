@@ -0,0 +1,130 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+#include <vector>
+
+namespace DirectX
+{
+	struct Image;
+	class ScratchImage;
+}
+
+class VertexMesh;
+
+// place of one packed texture inside an atlas. uv_atlas = uv * scale + offset
+struct AtlasRegion
+{
+	unsigned int m_atlas = 0;
+	unsigned int m_x = 0, m_y = 0;				// top left texel of the image (without gutter)
+	unsigned int m_width = 0, m_height = 0;
+	float m_u_scale = 1.0f, m_v_scale = 1.0f;
+	float m_u_offset = 0.0f, m_v_offset = 0.0f;
+};
+
+// atlases the AssetCooker builds for the materials of a mesh
+struct AtlasSettings
+{
+	unsigned int m_size = 0;			// texels per side, a power of two. 0 = no atlases
+	unsigned int m_padding = 2;			// gutter texels at the smallest level
+	unsigned int m_mip_levels = 5;
+};
+
+struct AtlasStats
+{
+	unsigned int m_atlases = 0;
+	unsigned int m_images = 0;
+	size_t m_used_texels = 0;		// texels of the images
+	size_t m_total_texels = 0;		// texels of all atlases
+	double m_efficiency = 0.0;		// used / total
+};
+
+
+/*
+	TextureAtlas: packs many small RGBA8 textures into few big ones, so meshes with different materials can be drawn
+	with one texture bind
+
+	- packing with the skyline packer of imstb_rectpack (vendored with ImGui)
+	- every image gets a gutter of padding texels *at the smallest mip level*. With n mip levels the gutter is
+	  padding * 2^(n-1) texels at level 0, and images are placed on a grid of 2^(n-1) texels. This way no level mixes
+	  texels of two neighbours. The gutter repeats the border texels of the image (clamp)
+	- when one atlas is full a new one is started
+	- mips of the atlas use the Box filter: its footprint never leaves the gutter
+*/
+
+class TextureAtlas
+{
+public:
+
+	TextureAtlas(unsigned int atlas_size, unsigned int padding, unsigned int mip_levels);
+
+	// copy an image into the builder. All images must have the same RGBA8 format. Returns the id of the image or -1
+	int add(const DirectX::Image& image);
+
+	// pack all images and compose the atlases. False if an image does not fit into an empty atlas
+	bool build();
+
+	const AtlasRegion& getRegion(int id);
+	unsigned int getAtlasCount();
+	// mip chain of one atlas (R8G8B8A8 or B8G8R8A8)
+	const DirectX::ScratchImage& getAtlas(unsigned int index);
+	AtlasStats getStats();
+
+	/*
+		cook time: the vertices of one material of a mesh (vertex_materials holds the material of every vertex)
+		- a texture that repeats over the mesh (texture coordinates outside [0, 1]) can not live in an atlas:
+		  fitsAtlas() is false, such a material keeps its own texture
+		- remapTexcoords() moves the texture coordinates of the material into the region of its texture
+	*/
+	static bool fitsAtlas(const std::vector<VertexMesh>& vertices, const std::vector<unsigned short>& vertex_materials, unsigned short material);
+	static void remapTexcoords(std::vector<VertexMesh>& vertices, const std::vector<unsigned short>& vertex_materials, unsigned short material,
+		const AtlasRegion& region);
+
+	~TextureAtlas();
+
+private:
+
+	struct Source
+	{
+		unsigned int m_width;
+		unsigned int m_height;
+		std::vector<unsigned char> m_pixels;
+	};
+
+	void compose(unsigned int atlas, const std::vector<int>& images);
+
+private:
+
+	unsigned int m_atlas_size;
+	unsigned int m_padding;
+	unsigned int m_mip_levels;
+	DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+
+	std::vector<Source> m_sources;
+	std::vector<AtlasRegion> m_regions;
+	std::vector<DirectX::ScratchImage*> m_atlases;
+};
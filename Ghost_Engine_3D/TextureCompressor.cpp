@@ -0,0 +1,193 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "TextureCompressor.h"
+#include "JobSystem.h"
+
+#include <DirectXTex.h>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+
+/*
+	- normal maps only use x and y -> BC5 stores two channels with full precision
+	- Quality preset always uses BC7
+	- Fast preset uses BC1 when alpha is 255 everywhere, otherwise BC3
+*/
+
+DXGI_FORMAT TextureCompressor::chooseFormat(const DirectX::Image& image, CompressionPreset preset, bool normal_map)
+{
+	if (normal_map)
+		return DXGI_FORMAT_BC5_UNORM;
+
+	if (preset == CompressionPreset::Quality)
+		return DXGI_FORMAT_BC7_UNORM;
+
+	for (size_t y = 0; y < image.height; y++)
+	{
+		const unsigned char* row = image.pixels + y * image.rowPitch;
+		for (size_t x = 0; x < image.width; x++)
+		{
+			if (row[x * 4 + 3] != 255)
+				return DXGI_FORMAT_BC3_UNORM;
+		}
+	}
+
+	return DXGI_FORMAT_BC1_UNORM;
+}
+
+
+static DWORD getCompressFlags(DXGI_FORMAT format, CompressionPreset preset)
+{
+	if (format == DXGI_FORMAT_BC7_UNORM)
+		return (preset == CompressionPreset::Fast) ? DirectX::TEX_COMPRESS_BC7_QUICK : DirectX::TEX_COMPRESS_BC7_USE_3SUBSETS;
+
+	// dithering spreads the quantization error of the 565 end points and hides banding in gradients
+	return (preset == CompressionPreset::Quality) ? DirectX::TEX_COMPRESS_DITHER : DirectX::TEX_COMPRESS_DEFAULT;
+}
+
+
+/*
+	one strip = 16 block rows (64 pixel rows). The last strip of a level can be smaller, and levels smaller than
+	one block (2x2, 1x1) are padded by DirectXTex
+*/
+
+static const size_t STRIP_BLOCK_ROWS = 16;
+
+bool TextureCompressor::compress(const DirectX::ScratchImage& source, DXGI_FORMAT format, CompressionPreset preset, DirectX::ScratchImage& compressed, CompressionReport* report)
+{
+	auto start = std::chrono::high_resolution_clock::now();
+
+	const DirectX::TexMetadata& metadata = source.GetMetadata();
+
+	if (FAILED(compressed.Initialize2D(format, metadata.width, metadata.height, 1, metadata.mipLevels)))
+		return false;
+
+	DWORD flags = getCompressFlags(format, preset);
+
+	// collect the strips of all levels first -> the small levels run in parallel with the big ones
+	struct Strip
+	{
+		size_t m_level;
+		size_t m_first_row;
+		size_t m_rows;
+	};
+
+	std::vector<Strip> strips;
+	size_t pixels = 0;
+
+	for (size_t level = 0; level < metadata.mipLevels; level++)
+	{
+		const DirectX::Image* image = source.GetImage(level, 0, 0);
+		pixels += image->width * image->height;
+
+		for (size_t row = 0; row < image->height; row += STRIP_BLOCK_ROWS * 4)
+		{
+			size_t rows = image->height - row;
+			if (rows > STRIP_BLOCK_ROWS * 4)
+				rows = STRIP_BLOCK_ROWS * 4;
+
+			strips.push_back(Strip{ level, row, rows });
+		}
+	}
+
+	std::atomic<bool> failed(false);
+
+	JobSystem::get()->parallelFor((unsigned int)strips.size(), 1, [&](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; i++)
+		{
+			const Strip& strip = strips[i];
+			const DirectX::Image* src = source.GetImage(strip.m_level, 0, 0);
+			const DirectX::Image* dst = compressed.GetImage(strip.m_level, 0, 0);
+
+			// view on the rows of the strip, no copy
+			DirectX::Image view = *src;
+			view.height = strip.m_rows;
+			view.pixels = src->pixels + strip.m_first_row * src->rowPitch;
+			view.slicePitch = view.rowPitch * view.height;
+
+			DirectX::ScratchImage blocks;
+			if (FAILED(DirectX::Compress(view, format, flags, 0.5f, blocks)))
+			{
+				failed = true;
+				continue;
+			}
+
+			// rowPitch of a compressed image is the size of one row of blocks
+			const DirectX::Image* encoded = blocks.GetImage(0, 0, 0);
+			size_t first_block_row = strip.m_first_row / 4;
+			size_t block_rows = (strip.m_rows + 3) / 4;
+
+			for (size_t b = 0; b < block_rows; b++)
+			{
+				::memcpy(dst->pixels + (first_block_row + b) * dst->rowPitch, encoded->pixels + b * encoded->rowPitch, dst->rowPitch);
+			}
+		}
+	});
+
+	if (failed)
+		return false;
+
+	if (report)
+	{
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+		report->m_format = format;
+		report->m_milliseconds = ms;
+		report->m_megapixels_per_second = (ms > 0.0) ? pixels / (ms * 1000.0) : 0.0;
+		report->m_source_bytes = source.GetPixelsSize();
+		report->m_compressed_bytes = compressed.GetPixelsSize();
+		report->m_psnr = computePSNR(source, compressed);
+	}
+
+	return true;
+}
+
+
+/*
+	PSNR = 10 * log10(1 / MSE) with MSE of the channels in [0, 1]
+*/
+
+double TextureCompressor::computePSNR(const DirectX::ScratchImage& source, const DirectX::ScratchImage& compressed)
+{
+	const DirectX::Image* original = source.GetImage(0, 0, 0);
+
+	DirectX::ScratchImage decoded;
+	if (FAILED(DirectX::Decompress(*compressed.GetImage(0, 0, 0), original->format, decoded)))
+		return 0.0;
+
+	float mse = 0.0f;
+	if (FAILED(DirectX::ComputeMSE(*original, *decoded.GetImage(0, 0, 0), mse, nullptr)))
+		return 0.0;
+
+	if (mse <= 0.0f)
+		return 99.0;
+
+	return 10.0 * log10(1.0 / mse);
+}
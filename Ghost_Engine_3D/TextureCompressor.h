@@ -0,0 +1,78 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+
+namespace DirectX
+{
+	struct Image;
+	class ScratchImage;
+}
+
+// speed / quality trade off of the block compression
+enum class CompressionPreset
+{
+	Fast,			// BC1 / BC3 (BC7 in quick mode when requested). Used when a texture is cooked at load time
+	Quality			// BC7 with full mode search and 3 subset partitions. Used by the AssetCooker
+};
+
+
+// result of the compression of one texture
+struct CompressionReport
+{
+	DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
+	double m_psnr = 0.0;					// of level 0 in dB, higher is better (> 40 dB is hard to see)
+	double m_milliseconds = 0.0;
+	double m_megapixels_per_second = 0.0;	// pixels of all levels / encode time
+	size_t m_source_bytes = 0;				// RGBA8 size of all levels
+	size_t m_compressed_bytes = 0;
+};
+
+
+/*
+	TextureCompressor: CPU block compression of RGBA8 textures (all mip levels) with DirectXTex
+
+	- formats:  BC1 -> 8:1 (opaque color)     BC3 -> 4:1 (color + alpha)
+	            BC5 -> 4:1 (two channel normal maps)   BC7 -> 4:1 (high quality color + alpha)
+	- multithreaded: every mip level is split in strips of block rows. The strips are encoded in parallel on the JobSystem
+	  and copied into the final image, so the output is the same as a single threaded encode
+	- the compressed chain is written as cooked file (TextureFile) which the texture loader uploads directly without decoding
+*/
+
+class TextureCompressor
+{
+public:
+
+	// pick the block format for the content of the image
+	static DXGI_FORMAT chooseFormat(const DirectX::Image& image, CompressionPreset preset, bool normal_map);
+
+	// compress all levels of a RGBA8 mip chain into the block format
+	static bool compress(const DirectX::ScratchImage& source, DXGI_FORMAT format, CompressionPreset preset, DirectX::ScratchImage& compressed, CompressionReport* report = nullptr);
+
+	// peak signal to noise ratio between the level 0 of the source and the compressed chain
+	static double computePSNR(const DirectX::ScratchImage& source, const DirectX::ScratchImage& compressed);
+};
@@ -0,0 +1,133 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "TextureCooker.h"
+#include <DirectXTex.h>
+
+#include <cwchar>
+#include <cwctype>
+#include <string>
+#include <utility>
+
+
+bool TextureCooker::cook(const unsigned char* data, size_t size, DirectX::ScratchImage& cooked, MipMapStats* mip_stats, CompressionReport* compression,
+	const TextureCookSettings& settings)
+{
+	// contains image data
+	DirectX::ScratchImage picture;
+
+	// decoded by WIC straight out of memory
+	HRESULT res = DirectX::LoadFromWICMemory(data, size, DirectX::WIC_FLAGS_NONE, nullptr, picture);
+
+
+	/*
+		- JPEG files have no mips (mipLevels = 1) -> minified texture aliases and the texture cache is trashed
+		- generate the full mip chain on the CPU, gamma correct with the filter of the settings
+		- normal maps are not gamma encoded -> filtered linearly and renormalized
+	*/
+	if (SUCCEEDED(res) && picture.GetMetadata().mipLevels == 1)
+	{
+		DXGI_FORMAT format = picture.GetMetadata().format;
+
+		if (format != DXGI_FORMAT_R8G8B8A8_UNORM && format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB &&
+			format != DXGI_FORMAT_B8G8R8A8_UNORM && format != DXGI_FORMAT_B8G8R8A8_UNORM_SRGB)
+		{
+			DirectX::ScratchImage converted;
+			res = DirectX::Convert(*picture.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, 0.5f, converted);
+			if (SUCCEEDED(res))
+				picture = std::move(converted);
+		}
+
+		DirectX::ScratchImage mip_chain;
+		if (SUCCEEDED(res) && MipMapGenerator::generate(*picture.GetImage(0, 0, 0), settings.m_mip_filter,
+			settings.m_normal_map ? MipContent::NormalMap : MipContent::Color, mip_chain, mip_stats))
+			picture = std::move(mip_chain);
+	}
+
+	if (FAILED(res))
+		return false;
+
+	/*
+		- block compress with the preset of the settings (4-8x less memory)
+		- level 0 of a block compressed texture must be a multiple of 4 in width and height, otherwise the raw texels are cooked
+	*/
+	const DirectX::TexMetadata& metadata = picture.GetMetadata();
+	if ((metadata.width % 4) == 0 && (metadata.height % 4) == 0)
+	{
+		DXGI_FORMAT format = TextureCompressor::chooseFormat(*picture.GetImage(0, 0, 0), settings.m_preset, settings.m_normal_map);
+
+		DirectX::ScratchImage compressed;
+		if (TextureCompressor::compress(picture, format, settings.m_preset, compressed, compression))
+			picture = std::move(compressed);
+	}
+
+	cooked = std::move(picture);
+	return true;
+}
+
+
+bool TextureCooker::decode(const unsigned char* data, size_t size, DirectX::ScratchImage& image)
+{
+	DirectX::ScratchImage picture;
+	if (FAILED(DirectX::LoadFromWICMemory(data, size, DirectX::WIC_FLAGS_IGNORE_SRGB, nullptr, picture)))
+		return false;
+
+	if (picture.GetMetadata().format == DXGI_FORMAT_R8G8B8A8_UNORM)
+	{
+		image = std::move(picture);
+		return true;
+	}
+
+	return SUCCEEDED(DirectX::Convert(*picture.GetImage(0, 0, 0), DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, 0.5f, image));
+}
+
+
+bool TextureCooker::isNormalMapName(const wchar_t* path)
+{
+	std::wstring name(path);
+
+	size_t separator = name.find_last_of(L"\\/");
+	if (separator != std::wstring::npos)
+		name = name.substr(separator + 1);
+
+	size_t dot = name.find_last_of(L'.');
+	if (dot != std::wstring::npos)
+		name = name.substr(0, dot);
+
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		name[i] = (wchar_t)towlower(name[i]);
+	}
+
+	static const wchar_t* const suffixes[] = { L"_n", L"_nrm", L"_norm", L"_normal", L"_normals" };
+	for (const wchar_t* suffix : suffixes)
+	{
+		size_t length = wcslen(suffix);
+		if (name.size() > length && name.compare(name.size() - length, length, suffix) == 0)
+			return true;
+	}
+	return false;
+}
@@ -0,0 +1,63 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "MipMapGenerator.h"
+#include "TextureCompressor.h"
+
+// how a texture is cooked. The defaults are the ones of a texture cooked at load time
+struct TextureCookSettings
+{
+	CompressionPreset m_preset = CompressionPreset::Fast;
+	MipFilter m_mip_filter = MipFilter::Kaiser;
+	bool m_normal_map = false;		// linear renormalized mips, BC5
+};
+
+
+/*
+	TextureCooker: encoded image (jpg, png, ...) -> texture as the GPU wants it
+	- WIC decode, RGBA8, gamma correct mip chain (Kaiser by default), block compression (Fast preset at load time,
+	  Quality in the AssetCooker)
+	- normal maps: mips filtered linearly and renormalized, two channel BC5. The AssetCooker knows them from the "norm"
+	  maps of the materials and by name, a texture cooked at load time by name only
+	- shared by TextureShader (cook on first load) and the AssetCooker (offline)
+	- WIC needs COM on the calling thread (or the process wide MTA)
+*/
+
+class TextureCooker
+{
+public:
+
+	// false if the image can not be decoded
+	static bool cook(const unsigned char* data, size_t size, DirectX::ScratchImage& cooked, MipMapStats* mip_stats = nullptr, CompressionReport* compression = nullptr,
+		const TextureCookSettings& settings = TextureCookSettings());
+
+	// decode only: level 0 as R8G8B8A8_UNORM, the bytes as they are in the file (sRGB is not converted). For the TextureAtlas
+	static bool decode(const unsigned char* data, size_t size, DirectX::ScratchImage& image);
+
+	// naming convention of normal maps: the file name ends with _n, _nrm, _norm, _normal or _normals (any extension and case)
+	static bool isNormalMapName(const wchar_t* path);
+};
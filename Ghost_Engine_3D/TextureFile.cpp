@@ -0,0 +1,210 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "TextureFile.h"
+#include "MappedFile.h"
+
+#include <DirectXTex.h>
+#include <algorithm>
+#include <vector>
+
+
+static size_t alignUp(size_t value, size_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+
+TextureFile::TextureFile()
+{
+}
+
+
+bool TextureFile::write(const DirectX::ScratchImage& image, const wchar_t* file)
+{
+	const DirectX::TexMetadata& metadata = image.GetMetadata();
+
+	TextureFileHeader header = {};
+	header.m_magic = TEXTURE_FILE_MAGIC;
+	header.m_version = TEXTURE_FILE_VERSION;
+	header.m_format = (unsigned int)metadata.format;
+	header.m_width = (unsigned int)metadata.width;
+	header.m_height = (unsigned int)metadata.height;
+	header.m_mip_levels = (unsigned int)metadata.mipLevels;
+	header.m_flags = DirectX::IsCompressed(metadata.format) ? TEXTURE_FILE_BLOCK_COMPRESSED : 0;
+
+	// layout: header, mip table, then the aligned levels
+	std::vector<TextureFileMip> mips(metadata.mipLevels);
+	size_t offset = alignUp(sizeof(TextureFileHeader) + sizeof(TextureFileMip) * mips.size(), TEXTURE_FILE_ALIGNMENT);
+
+	for (size_t level = 0; level < metadata.mipLevels; level++)
+	{
+		const DirectX::Image* mip = image.GetImage(level, 0, 0);
+
+		mips[level].m_offset = offset;
+		mips[level].m_size = (unsigned int)mip->slicePitch;
+		mips[level].m_row_pitch = (unsigned int)mip->rowPitch;
+		mips[level].m_width = (unsigned int)mip->width;
+		mips[level].m_height = (unsigned int)mip->height;
+
+		offset = alignUp(offset + mip->slicePitch, TEXTURE_FILE_ALIGNMENT);
+	}
+
+	std::vector<unsigned char> data(offset, 0);
+	::memcpy(&data[0], &header, sizeof(header));
+	::memcpy(&data[sizeof(header)], mips.data(), sizeof(TextureFileMip) * mips.size());
+
+	for (size_t level = 0; level < metadata.mipLevels; level++)
+	{
+		::memcpy(&data[(size_t)mips[level].m_offset], image.GetImage(level, 0, 0)->pixels, mips[level].m_size);
+	}
+
+	std::wstring temp = std::wstring(file) + L".tmp";
+
+	HANDLE handle = ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	DWORD written = 0;
+	BOOL ok = ::WriteFile(handle, data.data(), (DWORD)data.size(), &written, nullptr);
+	::CloseHandle(handle);
+
+	if (!ok || written != data.size())
+	{
+		::DeleteFileW(temp.c_str());
+		return false;
+	}
+
+	return ::MoveFileExW(temp.c_str(), file, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+
+/*
+	validate everything that is later used as offset or size -> a broken file is rejected instead of read out of bounds
+	- the format must be one a texture can be created with, the levels the mip chain of the header's size
+	- every level holds at least the rows of its format with at least the pitch of its width: CreateTexture2D reads
+	  row pitch * rows bytes from the level
+*/
+
+bool TextureFile::open(const unsigned char* data, size_t size)
+{
+	m_data = nullptr;
+	m_size = 0;
+
+	if (!data || size < sizeof(TextureFileHeader))
+		return false;
+
+	const TextureFileHeader* header = (const TextureFileHeader*)data;
+	if (header->m_magic != TEXTURE_FILE_MAGIC || header->m_version != TEXTURE_FILE_VERSION || header->m_mip_levels == 0 || header->m_mip_levels > 16)
+		return false;
+
+	if (header->m_width == 0 || header->m_height == 0 ||
+		header->m_width > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION || header->m_height > D3D11_REQ_TEXTURE2D_U_OR_V_DIMENSION)
+		return false;
+
+	DXGI_FORMAT format = (DXGI_FORMAT)header->m_format;
+	if (!DirectX::IsValid(format) || DirectX::IsTypeless(format) || DirectX::IsPlanar(format) || DirectX::IsPacked(format) || DirectX::IsVideo(format))
+		return false;
+
+	bool compressed = DirectX::IsCompressed(format);
+	if (compressed != ((header->m_flags & TEXTURE_FILE_BLOCK_COMPRESSED) != 0))
+		return false;
+
+	unsigned int max_levels = 1;
+	for (unsigned int extent = std::max(header->m_width, header->m_height); extent > 1; extent >>= 1)
+		max_levels++;
+	if (header->m_mip_levels > max_levels)
+		return false;
+
+	if (sizeof(TextureFileHeader) + sizeof(TextureFileMip) * header->m_mip_levels > size)
+		return false;
+
+	const TextureFileMip* mips = (const TextureFileMip*)(data + sizeof(TextureFileHeader));
+	for (unsigned int level = 0; level < header->m_mip_levels; level++)
+	{
+		const TextureFileMip& mip = mips[level];
+		if (mip.m_offset % TEXTURE_FILE_ALIGNMENT != 0 || mip.m_offset > size || mip.m_size > size - mip.m_offset)
+			return false;
+
+		if (mip.m_width != std::max(header->m_width >> level, 1u) || mip.m_height != std::max(header->m_height >> level, 1u))
+			return false;
+
+		// rows of blocks for block compressed formats
+		size_t row_pitch = 0, slice_pitch = 0;
+		if (FAILED(DirectX::ComputePitch(format, mip.m_width, mip.m_height, row_pitch, slice_pitch)))
+			return false;
+		unsigned long long rows = compressed ? std::max((mip.m_height + 3) / 4, 1u) : mip.m_height;
+		if (mip.m_row_pitch < row_pitch || (unsigned long long)mip.m_row_pitch * rows > mip.m_size)
+			return false;
+	}
+
+	m_data = data;
+	m_size = size;
+	m_header = header;
+	m_mips = mips;
+	return true;
+}
+
+
+const TextureFileHeader& TextureFile::getHeader()
+{
+	return *m_header;
+}
+
+
+const TextureFileMip& TextureFile::getMip(unsigned int level)
+{
+	return m_mips[level];
+}
+
+
+const unsigned char* TextureFile::getMipData(unsigned int level)
+{
+	return m_data + m_mips[level].m_offset;
+}
+
+
+void TextureFile::getSubresources(D3D11_SUBRESOURCE_DATA* subresources)
+{
+	for (unsigned int level = 0; level < m_header->m_mip_levels; level++)
+	{
+		subresources[level].pSysMem = getMipData(level);
+		subresources[level].SysMemPitch = m_mips[level].m_row_pitch;
+		subresources[level].SysMemSlicePitch = m_mips[level].m_size;
+	}
+}
+
+
+std::wstring TextureFile::getCookedPath(const wchar_t* source_file)
+{
+	return std::wstring(source_file) + L".gtex";
+}
+
+
+bool TextureFile::isUpToDate(const wchar_t* cooked_file, const wchar_t* source_file)
+{
+	return MappedFile::isUpToDate(cooked_file, source_file);
+}
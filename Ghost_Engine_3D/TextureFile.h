@@ -0,0 +1,109 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include <d3d11.h>
+#include <string>
+
+namespace DirectX
+{
+	class ScratchImage;
+}
+
+/*
+	Cooked texture container (.gtex)
+
+		TextureFileHeader       32 bytes
+		TextureFileMip[levels]  24 bytes each
+		padding                 -> payload starts 16 byte aligned
+		level 0 .. level n      each level starts 16 byte aligned
+
+	- the payload is stored exactly as D3D11 expects it (raw RGBA8 rows or rows of 4x4 blocks), so a mapped file
+	  can be passed to CreateTexture2D as D3D11_SUBRESOURCE_DATA without any decode step
+	- all values are little endian
+*/
+
+static const unsigned int TEXTURE_FILE_MAGIC = 0x58455447;		// "GTEX"
+static const unsigned int TEXTURE_FILE_VERSION = 1;
+static const unsigned int TEXTURE_FILE_ALIGNMENT = 16;
+
+// set in TextureFileHeader::m_flags when the payload is block compressed
+static const unsigned int TEXTURE_FILE_BLOCK_COMPRESSED = 0x1;
+
+struct TextureFileHeader
+{
+	unsigned int m_magic;
+	unsigned int m_version;
+	unsigned int m_format;			// DXGI_FORMAT
+	unsigned int m_width;
+	unsigned int m_height;
+	unsigned int m_mip_levels;
+	unsigned int m_flags;
+	unsigned int m_reserved;
+};
+
+struct TextureFileMip
+{
+	unsigned long long m_offset;	// from the start of the file
+	unsigned int m_size;			// bytes of the level
+	unsigned int m_row_pitch;		// bytes of one row of texels (or one row of blocks)
+	unsigned int m_width;
+	unsigned int m_height;
+};
+
+
+class TextureFile
+{
+public:
+
+	TextureFile();
+
+	// write all levels of the image into a cooked file (through a temporary file, so a crash never leaves half a file)
+	static bool write(const DirectX::ScratchImage& image, const wchar_t* file);
+
+	// read the container from memory (mapped file or a span of a pack file). The memory must stay valid while it is used
+	bool open(const unsigned char* data, size_t size);
+
+	const TextureFileHeader& getHeader();
+	const TextureFileMip& getMip(unsigned int level);
+	const unsigned char* getMipData(unsigned int level);
+
+	// fill one D3D11_SUBRESOURCE_DATA per level, pointing into the payload
+	void getSubresources(D3D11_SUBRESOURCE_DATA* subresources);
+
+	// path of the cooked file of a source texture
+	static std::wstring getCookedPath(const wchar_t* source_file);
+
+	// true when the cooked file exists and is not older than the source (a missing source counts as older)
+	static bool isUpToDate(const wchar_t* cooked_file, const wchar_t* source_file);
+
+private:
+
+	const unsigned char* m_data = nullptr;
+	size_t m_size = 0;
+	const TextureFileHeader* m_header = nullptr;
+	const TextureFileMip* m_mips = nullptr;
+};
@@ -27,40 +27,190 @@
 
 #include "TextureShader.h"
 #include "GraphicsEngine.h"
+#include "TextureFile.h"
+#include "TextureCooker.h"
+#include "FileSystem.h"
 #include <DirectXTex.h>
 
 #include <exception>
 
 /*
-	with the help of https://github.com/microsoft/DirectXTex/wiki/CreateTexture
-	- create direct3D resource from a set of images
+	- prefer the cooked file (.gtex) when it is not older than the source: it is memory mapped and the payload goes
+	  straight to CreateTexture2D -> loading is pure I/O
+	- a cooked file inside a pack is always used: the pack is built from cooked files
+	- otherwise decode the source, build the mips, block compress and write the cooked file for the next start
+	- a texture decoded by a prefetch completion job is only uploaded
 */
 
 TextureShader::TextureShader(const wchar_t* file)
 {
-	// contains image data
-	DirectX::ScratchImage picture;
+	std::wstring load_path = getLoadPath(file);
+
+	PrefetchedAsset* asset = FileSystem::get()->takeDecoded(load_path.c_str());
+	TextureData* prefetched = dynamic_cast<TextureData*>(asset);
+	if (prefetched)
+	{
+		upload(*prefetched);
+		delete asset;
+		return;
+	}
+	delete asset;
+
+	// encoded file from a pack or from disk. The span stays alive until the upload: a cooked texture points into it
+	FileSpan span;
+	TextureData data;
+	if (!FileSystem::get()->read(load_path.c_str(), span) || !decode(file, load_path, span.getData(), span.getSize(), data))
+	{
+		// a broken cooked file is cooked again from the source
+		if (load_path == file || !FileSystem::get()->read(file, span) || !decode(file, file, span.getData(), span.getSize(), data))
+		{
+			throw std::exception("Loading Texture Resources was not successful");
+		}
+	}
+
+	upload(data);
+}
+
+
+std::wstring TextureShader::getLoadPath(const wchar_t* file)
+{
+	std::wstring cooked = TextureFile::getCookedPath(file);
 
-	// load files in memory
-	HRESULT res = DirectX::LoadFromWICFile(file, DirectX::WIC_FLAGS_NONE, nullptr, picture);
+	if (FileSystem::get()->isPacked(cooked.c_str()) || TextureFile::isUpToDate(cooked.c_str(), file))
+		return cooked;
 
+	return file;
+}
 
-	if (SUCCEEDED(res))
+
+PrefetchRequest TextureShader::getPrefetchRequest(const wchar_t* file)
+{
+	PrefetchRequest request;
+	request.m_path = getLoadPath(file);
+
+	std::wstring source = file;
+	std::wstring load_path = request.m_path;
+	request.m_decoder = [source, load_path](const std::wstring& path, std::vector<unsigned char>& bytes) -> PrefetchedAsset*
+		{
+			TextureData* data = new TextureData();
+			data->m_bytes.swap(bytes);
+
+			if (!decode(source.c_str(), load_path, data->m_bytes.data(), data->m_bytes.size(), *data))
+			{
+				delete data;
+				return nullptr;
+			}
+
+			// a decoded source does not need its encoded bytes any more
+			if (!data->m_cooked)
+				std::vector<unsigned char>().swap(data->m_bytes);
+
+			return data;
+		};
+
+	return request;
+}
+
+
+bool TextureShader::decode(const wchar_t* file, const std::wstring& load_path, const unsigned char* bytes, size_t size, TextureData& data)
+{
+	if (load_path != file)
 	{
-		res = DirectX::CreateTexture(GraphicsEngine::get()->m_d3d_device, picture.GetImages(), picture.GetImageCount(), picture.GetMetadata(), &m_picture);
+		TextureFile texture;
+		if (!texture.open(bytes, size))
+			return false;
+
+		data.m_cooked = bytes;
+		data.m_cooked_size = size;
+		return true;
+	}
+
+	// decode, mips and block compression
+	TextureCookSettings settings;
+	settings.m_normal_map = TextureCooker::isNormalMapName(file);
+
+	if (!TextureCooker::cook(bytes, size, data.m_picture, &data.m_mip_stats, &data.m_compression, settings))
+		return false;
+
+	// a packed source has no place on disk for a cooked file next to it
+	if (!FileSystem::get()->isPacked(file))
+		TextureFile::write(data.m_picture, TextureFile::getCookedPath(file).c_str());
+
+	return true;
+}
 
-		D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
-		desc.Format = picture.GetMetadata().format;
-		desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-		desc.Texture2D.MipLevels = (UINT)picture.GetMetadata().mipLevels;
-		desc.Texture2D.MostDetailedMip = 0;
 
-		GraphicsEngine::get()->m_d3d_device->CreateShaderResourceView(m_picture, &desc, &m_ts);
+/*
+	with the help of https://github.com/microsoft/DirectXTex/wiki/CreateTexture
+	- create direct3D resource from a set of images
+*/
+
+void TextureShader::upload(TextureData& data)
+{
+	if (!data.m_cooked)
+	{
+		HRESULT res = DirectX::CreateTexture(GraphicsEngine::get()->m_d3d_device, data.m_picture.GetImages(), data.m_picture.GetImageCount(),
+			data.m_picture.GetMetadata(), &m_picture);
+
+		if (FAILED(res))
+		{
+			throw std::exception("Loading Texture Resources was not successful");
+		}
+
+		m_mip_stats = data.m_mip_stats;
+		m_compression = data.m_compression;
+		createView(data.m_picture.GetMetadata().format, (UINT)data.m_picture.GetMetadata().mipLevels);
+		return;
 	}
-	else
+
+	// validated by decode()
+	TextureFile texture;
+	texture.open(data.m_cooked, data.m_cooked_size);
+	const TextureFileHeader& header = texture.getHeader();
+
+	D3D11_SUBRESOURCE_DATA subresources[16] = {};
+	texture.getSubresources(subresources);
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = header.m_width;
+	desc.Height = header.m_height;
+	desc.MipLevels = header.m_mip_levels;
+	desc.ArraySize = 1;
+	desc.Format = (DXGI_FORMAT)header.m_format;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	ID3D11Texture2D* picture = nullptr;
+	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateTexture2D(&desc, subresources, &picture)))
 	{
 		throw std::exception("Loading Texture Resources was not successful");
 	}
+
+	m_picture = picture;
+	createView(desc.Format, desc.MipLevels);
+
+	m_mip_stats.m_levels = header.m_mip_levels;
+	if (header.m_flags & TEXTURE_FILE_BLOCK_COMPRESSED)
+	{
+		m_compression.m_format = desc.Format;
+		m_compression.m_compressed_bytes = data.m_cooked_size;
+	}
+}
+
+
+void TextureShader::createView(DXGI_FORMAT format, UINT mip_levels)
+{
+	D3D11_SHADER_RESOURCE_VIEW_DESC desc = {};
+	desc.Format = format;
+	desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+	desc.Texture2D.MipLevels = mip_levels;
+	desc.Texture2D.MostDetailedMip = 0;
+
+	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateShaderResourceView(m_picture, &desc, &m_ts)))
+	{
+		throw std::exception("Create Texture View was not successful");
+	}
 }
 
 
@@ -70,6 +220,18 @@ ID3D11ShaderResourceView* TextureShader::GetTexture()
 }
 
 
+const MipMapStats& TextureShader::getMipStats()
+{
+	return m_mip_stats;
+}
+
+
+const CompressionReport& TextureShader::getCompressionReport()
+{
+	return m_compression;
+}
+
+
 TextureShader::~TextureShader()
 {
 	m_ts->Release();
@@ -27,10 +27,35 @@
 #pragma once
 
 #include <d3d11.h>
+#include <DirectXTex.h>
+#include <string>
+#include <vector>
+#include "MipMapGenerator.h"
+#include "TextureCompressor.h"
+#include "FileSystem.h"
 
 class GraphicsEngine;
 class DeviceContext;
 
+/*
+	TextureData: CPU side of a texture, everything the constructor needs besides the device. Built by
+	TextureShader::decode on any thread, so a prefetch completion job does the decoding and only the upload is left
+*/
+
+struct TextureData : public PrefetchedAsset
+{
+	// cooked file: its bytes, uploaded as they are. m_bytes owns them when they were prefetched
+	const unsigned char* m_cooked = nullptr;
+	size_t m_cooked_size = 0;
+	std::vector<unsigned char> m_bytes;
+
+	// source file: decoded, mip mapped and block compressed
+	DirectX::ScratchImage m_picture;
+	MipMapStats m_mip_stats;
+	CompressionReport m_compression;
+};
+
+
 class TextureShader
 {
 public:
@@ -38,13 +63,34 @@ public:
 	// this will load a texutre from a file
 	TextureShader(const wchar_t* file);
 	~TextureShader();
+	// the file the constructor will read: the cooked file if it can be used, otherwise the source
+	static std::wstring getLoadPath(const wchar_t* file);
+	// getLoadPath(file) with a decoder for FileSystem::prefetch: the constructor then only uploads
+	static PrefetchRequest getPrefetchRequest(const wchar_t* file);
+	/*
+		bytes of load_path (see getLoadPath) -> data. A cooked file is only validated, data points into bytes.
+		A source is decoded, mip mapped and compressed and its cooked file is written. Needs no device
+	*/
+	static bool decode(const wchar_t* file, const std::wstring& load_path, const unsigned char* bytes, size_t size, TextureData& data);
 	// return a pointer to the texture resource
 	ID3D11ShaderResourceView* GetTexture();
+	// timing and memory of the mip chain generated at load time
+	const MipMapStats& getMipStats();
+	// format, PSNR and encode speed when the texture was block compressed at load time
+	const CompressionReport& getCompressionReport();
+
+private:
+
+	// create the texture and its view from the result of decode()
+	void upload(TextureData& data);
+	void createView(DXGI_FORMAT format, UINT mip_levels);
 
 private:
 
 	ID3D11Resource* m_picture = nullptr;
 	ID3D11ShaderResourceView* m_ts = nullptr;
+	MipMapStats m_mip_stats;
+	CompressionReport m_compression;
 
 private:
 
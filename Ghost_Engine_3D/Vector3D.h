@@ -27,6 +27,7 @@
 */
 
 #pragma once
+#include <cmath>
 
 class Vector3D
 {
@@ -57,6 +58,36 @@ public:
 		return v;
 	}
 
+	Vector3D operator +(const Vector3D& vec) const
+	{
+		return Vector3D(m_x + vec.m_x, m_y + vec.m_y, m_z + vec.m_z);
+	}
+
+	Vector3D operator -(const Vector3D& vec) const
+	{
+		return Vector3D(m_x - vec.m_x, m_y - vec.m_y, m_z - vec.m_z);
+	}
+
+	Vector3D operator *(float num) const
+	{
+		return Vector3D(m_x * num, m_y * num, m_z * num);
+	}
+
+	static float dot(const Vector3D& a, const Vector3D& b)
+	{
+		return a.m_x * b.m_x + a.m_y * b.m_y + a.m_z * b.m_z;
+	}
+
+	static Vector3D cross(const Vector3D& a, const Vector3D& b)
+	{
+		return Vector3D(a.m_y * b.m_z - a.m_z * b.m_y, a.m_z * b.m_x - a.m_x * b.m_z, a.m_x * b.m_y - a.m_y * b.m_x);
+	}
+
+	float length() const
+	{
+		return ::sqrtf(dot(*this, *this));
+	}
+
 
 	~Vector3D()
 	{
@@ -51,6 +51,79 @@
 */
 
 VertexBuffer::VertexBuffer(void* list_vertices, UINT size_vertex, UINT size_list, void* shader_byte_code, size_t size_byte_shader) : m_layout(0), m_buffer(0)
+{
+	/*
+		this is the layout of the vertex data that will be processed by the shader.
+		AlignedByteOffset indicates how the data is spaced in the buffer. First position needs 12 Bytes of space. Next one added 12 or 16 Bytes. D3D11_APPEND_ALIGNED_ELEMENT makes it automatically
+	*/
+
+	D3D11_INPUT_ELEMENT_DESC layout[] =
+	{
+		//SEMANTIC NAME - SEMANTIC INDEX - FORMAT - INPUT SLOT - ALIGNED BYTE OFFSET - INPUT SLOT CLASS - INSTANCE DATA STEP RATE
+		{"POSITION", 0,  DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+		{"TEXCOORD", 0,  DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA , 0},
+		{"NORMAL", 0,  DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}
+
+	};
+
+	create(list_vertices, size_vertex, size_list, layout, ARRAYSIZE(layout), shader_byte_code, size_byte_shader);
+}
+
+
+/*
+	- the input assembler converts UNORM, SNORM and half formats to float before the vertex shader runs. The shader
+	  only applies the ranges of VertexQuantization and unfolds octahedral normals (PackedVertexShader.hlsl)
+	- the shader inputs keep their types (float4 position, float2 texcoord, float3 normal): missing components of
+	  a smaller format are filled with 0 (w with 1)
+	- split streams: the Position stream only has the POSITION element (shader_byte_code of a position only shader).
+	  The Attributes stream has TEXCOORD and NORMAL in slot 1 and POSITION from the Position stream in slot 0
+*/
+VertexBuffer::VertexBuffer(void* list_vertices, const VertexFormat& format, UINT size_list, void* shader_byte_code, size_t size_byte_shader,
+	VertexStream stream) : m_layout(0), m_buffer(0), m_stream(stream)
+{
+	DXGI_FORMAT position = (format.m_position == PositionFormat::Float3) ? DXGI_FORMAT_R32G32B32_FLOAT : DXGI_FORMAT_R16G16B16A16_UNORM;
+	DXGI_FORMAT texcoord = (format.m_texcoord == TexcoordFormat::Float2) ? DXGI_FORMAT_R32G32_FLOAT :
+		(format.m_texcoord == TexcoordFormat::Half2) ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R16G16_UNORM;
+	DXGI_FORMAT normal = (format.m_normal == NormalFormat::Float3) ? DXGI_FORMAT_R32G32B32_FLOAT : DXGI_FORMAT_R16G16_SNORM;
+
+	if (stream == VertexStream::Interleaved)
+	{
+		D3D11_INPUT_ELEMENT_DESC layout[] =
+		{
+			{"POSITION", 0,  position, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+			{"TEXCOORD", 0,  texcoord, 0, format.getTexcoordOffset(), D3D11_INPUT_PER_VERTEX_DATA , 0},
+			{"NORMAL", 0,  normal, 0, format.getNormalOffset(), D3D11_INPUT_PER_VERTEX_DATA, 0}
+		};
+
+		create(list_vertices, format.getStride(), size_list, layout, ARRAYSIZE(layout), shader_byte_code, size_byte_shader);
+	}
+	else if (stream == VertexStream::Position)
+	{
+		D3D11_INPUT_ELEMENT_DESC layout[] =
+		{
+			{"POSITION", 0,  position, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0}
+		};
+
+		create(list_vertices, format.getPositionStride(), size_list, layout, ARRAYSIZE(layout), shader_byte_code, size_byte_shader);
+	}
+	else
+	{
+		UINT texcoord_size = format.getNormalOffset() - format.getTexcoordOffset();
+
+		D3D11_INPUT_ELEMENT_DESC layout[] =
+		{
+			{"POSITION", 0,  position, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
+			{"TEXCOORD", 0,  texcoord, 1, 0, D3D11_INPUT_PER_VERTEX_DATA , 0},
+			{"NORMAL", 0,  normal, 1, texcoord_size, D3D11_INPUT_PER_VERTEX_DATA, 0}
+		};
+
+		create(list_vertices, format.getAttributeStride(), size_list, layout, ARRAYSIZE(layout), shader_byte_code, size_byte_shader);
+	}
+}
+
+
+void VertexBuffer::create(void* list_vertices, UINT size_vertex, UINT size_list, const D3D11_INPUT_ELEMENT_DESC* layout, UINT size_layout,
+	void* shader_byte_code, size_t size_byte_shader)
 {
 	// release these to create new ones
 	if (m_buffer)m_buffer->Release();
@@ -76,24 +149,10 @@ VertexBuffer::VertexBuffer(void* list_vertices, UINT size_vertex, UINT size_list
 		throw std::exception("Create Vertex Buffer was not successful");
 	}
 
-	/*
-		this is the layout of the vertex data that will be processed by the shader.
-		AlignedByteOffset indicates how the data is spaced in the buffer. First position needs 12 Bytes of space. Next one added 12 or 16 Bytes. D3D11_APPEND_ALIGNED_ELEMENT makes it automatically
-	*/
-
-	D3D11_INPUT_ELEMENT_DESC layout[] =
-	{
-		//SEMANTIC NAME - SEMANTIC INDEX - FORMAT - INPUT SLOT - ALIGNED BYTE OFFSET - INPUT SLOT CLASS - INSTANCE DATA STEP RATE
-		{"POSITION", 0,  DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0},
-		{"TEXCOORD", 0,  DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA , 0},
-		{"NORMAL", 0,  DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0}
-
-	};
-
-	UINT size_layout = ARRAYSIZE(layout);
-
 	if (FAILED(GraphicsEngine::get()->m_d3d_device->CreateInputLayout(layout, size_layout, shader_byte_code, size_byte_shader, &m_layout)))
 	{
+		m_buffer->Release();
+		m_buffer = nullptr;
 		throw std::exception("Create Input Layout was not successful");
 	}
 }
@@ -105,6 +164,12 @@ UINT VertexBuffer::getSizeVertexList()
 }
 
 
+VertexStream VertexBuffer::getStream()
+{
+	return this->m_stream;
+}
+
+
 VertexBuffer::~VertexBuffer()
 {
 	m_layout->Release();
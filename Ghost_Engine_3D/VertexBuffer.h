@@ -28,21 +28,46 @@
 
 #pragma once
 #include <d3d11.h>
+#include "VertexPacker.h"
 
 class DeviceContext;
 
+/*
+	attributes a vertex buffer holds
+	- Interleaved: position, texcoord and normal of a vertex next to each other, bound alone
+	- Position: only the positions, bound alone for passes that need nothing else (depth, shadow)
+	- Attributes: texcoord and normal, bound in slot 1 next to the Position stream of the same mesh in slot 0.
+	  Its input layout describes both slots
+*/
+enum class VertexStream
+{
+	Interleaved,
+	Position,
+	Attributes
+};
+
 class VertexBuffer
 {
 public:
 
 	VertexBuffer(void* list_vertices, UINT size_vertex, UINT size_list, void* shader_byte_code, size_t size_byte_shader);
+	// vertices in a packed format (VertexPacker), the input layout describes the packed attributes of the stream
+	VertexBuffer(void* list_vertices, const VertexFormat& format, UINT size_list, void* shader_byte_code, size_t size_byte_shader,
+		VertexStream stream = VertexStream::Interleaved);
 	~VertexBuffer();
 	UINT getSizeVertexList();
+	VertexStream getStream();
+
+private:
+
+	void create(void* list_vertices, UINT size_vertex, UINT size_list, const D3D11_INPUT_ELEMENT_DESC* layout, UINT size_layout,
+		void* shader_byte_code, size_t size_byte_shader);
 
 private:
 
 	UINT m_size_vertex = 0;
 	UINT m_size_list = 0;
+	VertexStream m_stream = VertexStream::Interleaved;
 
 private:
 
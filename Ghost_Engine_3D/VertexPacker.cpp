@@ -0,0 +1,448 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#include "VertexPacker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+VertexFormat VertexFormat::packed()
+{
+	VertexFormat format;
+	format.m_position = PositionFormat::Unorm16;
+	format.m_texcoord = TexcoordFormat::Unorm16;
+	format.m_normal = NormalFormat::Octahedral16;
+	return format;
+}
+
+
+bool VertexFormat::isPacked() const
+{
+	return m_position != PositionFormat::Float3 || m_texcoord != TexcoordFormat::Float2 || m_normal != NormalFormat::Float3;
+}
+
+
+unsigned int VertexFormat::getStride() const
+{
+	return getNormalOffset() + (m_normal == NormalFormat::Float3 ? 12 : 4);
+}
+
+
+unsigned int VertexFormat::getTexcoordOffset() const
+{
+	return m_position == PositionFormat::Float3 ? 12 : 8;
+}
+
+
+unsigned int VertexFormat::getNormalOffset() const
+{
+	return getTexcoordOffset() + (m_texcoord == TexcoordFormat::Float2 ? 8 : 4);
+}
+
+
+unsigned int VertexFormat::getPositionStride() const
+{
+	return getTexcoordOffset();
+}
+
+
+unsigned int VertexFormat::getAttributeStride() const
+{
+	return getStride() - getPositionStride();
+}
+
+
+unsigned int VertexFormat::getKey() const
+{
+	return (unsigned int)m_position | ((unsigned int)m_texcoord << 8) | ((unsigned int)m_normal << 16);
+}
+
+
+bool VertexFormat::fromKey(unsigned int key, VertexFormat& format)
+{
+	unsigned int position = key & 0xff, texcoord = (key >> 8) & 0xff, normal = (key >> 16) & 0xff;
+	if (position > (unsigned int)PositionFormat::Unorm16 || texcoord > (unsigned int)TexcoordFormat::Unorm16 ||
+		normal > (unsigned int)NormalFormat::Octahedral16 || (key >> 24))
+		return false;
+
+	format.m_position = (PositionFormat)position;
+	format.m_texcoord = (TexcoordFormat)texcoord;
+	format.m_normal = (NormalFormat)normal;
+	return true;
+}
+
+
+static unsigned short toUnorm16(float value)
+{
+	return (unsigned short)(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f + 0.5f);
+}
+
+
+static float fromSnorm16(short value)
+{
+	return std::max(value / 32767.0f, -1.0f);
+}
+
+
+static Vector3D decodeOctahedral(float x, float y)
+{
+	Vector3D normal(x, y, 1.0f - fabsf(x) - fabsf(y));
+	float t = std::max(-normal.m_z, 0.0f);
+	normal.m_x += normal.m_x >= 0.0f ? -t : t;
+	normal.m_y += normal.m_y >= 0.0f ? -t : t;
+
+	float length = normal.length();
+	return length > 0.0f ? normal * (1.0f / length) : normal;
+}
+
+
+/*
+	project onto the octahedron |x| + |y| + |z| = 1, fold the lower half over the diagonals. Of the four roundings
+	of the two components the one whose decoded normal is closest to the source is kept
+*/
+static void encodeOctahedral(const Vector3D& normal, short result[2])
+{
+	float sum = fabsf(normal.m_x) + fabsf(normal.m_y) + fabsf(normal.m_z);
+	if (sum == 0.0f)
+	{
+		result[0] = result[1] = 0;
+		return;
+	}
+
+	float x = normal.m_x / sum, y = normal.m_y / sum;
+	if (normal.m_z < 0.0f)
+	{
+		float folded_x = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float folded_y = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = folded_x;
+		y = folded_y;
+	}
+
+	Vector3D source = normal * (1.0f / normal.length());
+	float best = -2.0f;
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		float cx = (i & 1) ? ceilf(x * 32767.0f) : floorf(x * 32767.0f);
+		float cy = (i & 2) ? ceilf(y * 32767.0f) : floorf(y * 32767.0f);
+		short sx = (short)std::min(std::max(cx, -32767.0f), 32767.0f);
+		short sy = (short)std::min(std::max(cy, -32767.0f), 32767.0f);
+
+		float cosine = Vector3D::dot(decodeOctahedral(fromSnorm16(sx), fromSnorm16(sy)), source);
+		if (cosine > best)
+		{
+			best = cosine;
+			result[0] = sx;
+			result[1] = sy;
+		}
+	}
+}
+
+
+VertexQuantization VertexPacker::computeQuantization(const VertexMesh* vertices, size_t count, const VertexFormat& format)
+{
+	VertexQuantization quantization;
+	if (count == 0)
+		return quantization;
+
+	Vector3D min = vertices[0].m_Pos, max = vertices[0].m_Pos;
+	Vector2D tex_min = vertices[0].m_Tex, tex_max = vertices[0].m_Tex;
+	for (size_t i = 1; i < count; i++)
+	{
+		const Vector3D& p = vertices[i].m_Pos;
+		const Vector2D& t = vertices[i].m_Tex;
+		min = Vector3D(std::min(min.m_x, p.m_x), std::min(min.m_y, p.m_y), std::min(min.m_z, p.m_z));
+		max = Vector3D(std::max(max.m_x, p.m_x), std::max(max.m_y, p.m_y), std::max(max.m_z, p.m_z));
+		tex_min = Vector2D(std::min(tex_min.m_x, t.m_x), std::min(tex_min.m_y, t.m_y));
+		tex_max = Vector2D(std::max(tex_max.m_x, t.m_x), std::max(tex_max.m_y, t.m_y));
+	}
+
+	if (format.m_position == PositionFormat::Unorm16)
+	{
+		float min_values[3] = { min.m_x, min.m_y, min.m_z };
+		float max_values[3] = { max.m_x, max.m_y, max.m_z };
+		for (unsigned int i = 0; i < 3; i++)
+		{
+			quantization.m_position_offset[i] = min_values[i];
+			quantization.m_position_scale[i] = max_values[i] - min_values[i];
+		}
+	}
+
+	if (format.m_texcoord == TexcoordFormat::Unorm16)
+	{
+		quantization.m_texcoord_offset[0] = tex_min.m_x;
+		quantization.m_texcoord_offset[1] = tex_min.m_y;
+		quantization.m_texcoord_scale[0] = tex_max.m_x - tex_min.m_x;
+		quantization.m_texcoord_scale[1] = tex_max.m_y - tex_min.m_y;
+	}
+
+	return quantization;
+}
+
+
+void VertexPacker::encode(const VertexMesh* vertices, size_t count, const VertexFormat& format, const VertexQuantization& quantization,
+	std::vector<unsigned char>& packed, VertexPackReport* report)
+{
+	unsigned int stride = format.getStride();
+	unsigned int texcoord_offset = format.getTexcoordOffset();
+	unsigned int normal_offset = format.getNormalOffset();
+
+	packed.assign(count * stride, 0);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const VertexMesh& vertex = vertices[i];
+		unsigned char* out = &packed[i * stride];
+
+		if (format.m_position == PositionFormat::Float3)
+		{
+			float position[3] = { vertex.m_Pos.m_x, vertex.m_Pos.m_y, vertex.m_Pos.m_z };
+			::memcpy(out, position, sizeof(position));
+		}
+		else
+		{
+			float values[3] = { vertex.m_Pos.m_x, vertex.m_Pos.m_y, vertex.m_Pos.m_z };
+			unsigned short position[4] = {};
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				float scale = quantization.m_position_scale[k];
+				position[k] = scale > 0.0f ? toUnorm16((values[k] - quantization.m_position_offset[k]) / scale) : 0;
+			}
+			::memcpy(out, position, sizeof(position));
+		}
+
+		float tex[2] = { vertex.m_Tex.m_x, vertex.m_Tex.m_y };
+		if (format.m_texcoord == TexcoordFormat::Float2)
+		{
+			::memcpy(out + texcoord_offset, tex, sizeof(tex));
+		}
+		else
+		{
+			unsigned short texcoord[2];
+			for (unsigned int k = 0; k < 2; k++)
+			{
+				float scale = quantization.m_texcoord_scale[k];
+				if (format.m_texcoord == TexcoordFormat::Half2)
+					texcoord[k] = floatToHalf(tex[k]);
+				else
+					texcoord[k] = scale > 0.0f ? toUnorm16((tex[k] - quantization.m_texcoord_offset[k]) / scale) : 0;
+			}
+			::memcpy(out + texcoord_offset, texcoord, sizeof(texcoord));
+		}
+
+		if (format.m_normal == NormalFormat::Float3)
+		{
+			float normal[3] = { vertex.m_Norm.m_x, vertex.m_Norm.m_y, vertex.m_Norm.m_z };
+			::memcpy(out + normal_offset, normal, sizeof(normal));
+		}
+		else
+		{
+			short normal[2];
+			encodeOctahedral(vertex.m_Norm, normal);
+			::memcpy(out + normal_offset, normal, sizeof(normal));
+		}
+	}
+
+	if (!report)
+		return;
+
+	*report = VertexPackReport();
+	report->m_vertices = (unsigned int)count;
+	report->m_float_bytes = (unsigned int)(count * sizeof(VertexMesh));
+	report->m_packed_bytes = (unsigned int)packed.size();
+
+	std::vector<VertexMesh> decoded;
+	decode(packed.data(), count, format, quantization, decoded);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const VertexMesh& source = vertices[i];
+		const VertexMesh& result = decoded[i];
+
+		report->m_position_error = std::max(report->m_position_error, (result.m_Pos - source.m_Pos).length());
+		report->m_texcoord_error = std::max(report->m_texcoord_error, std::max(fabsf(result.m_Tex.m_x - source.m_Tex.m_x), fabsf(result.m_Tex.m_y - source.m_Tex.m_y)));
+
+		float length = source.m_Norm.length() * result.m_Norm.length();
+		if (length > 0.0f)
+		{
+			float cosine = std::min(std::max(Vector3D::dot(source.m_Norm, result.m_Norm) / length, -1.0f), 1.0f);
+			report->m_normal_error = std::max(report->m_normal_error, acosf(cosine) * 57.2957795f);
+		}
+	}
+}
+
+
+void VertexPacker::decode(const unsigned char* packed, size_t count, const VertexFormat& format, const VertexQuantization& quantization,
+	std::vector<VertexMesh>& vertices)
+{
+	unsigned int stride = format.getStride();
+	unsigned int texcoord_offset = format.getTexcoordOffset();
+	unsigned int normal_offset = format.getNormalOffset();
+
+	vertices.resize(count);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const unsigned char* in = packed + i * stride;
+		VertexMesh& vertex = vertices[i];
+
+		if (format.m_position == PositionFormat::Float3)
+		{
+			float position[3];
+			::memcpy(position, in, sizeof(position));
+			vertex.m_Pos = Vector3D(position[0], position[1], position[2]);
+		}
+		else
+		{
+			unsigned short position[4];
+			::memcpy(position, in, sizeof(position));
+			float values[3];
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				values[k] = quantization.m_position_offset[k] + position[k] / 65535.0f * quantization.m_position_scale[k];
+			}
+			vertex.m_Pos = Vector3D(values[0], values[1], values[2]);
+		}
+
+		if (format.m_texcoord == TexcoordFormat::Float2)
+		{
+			float tex[2];
+			::memcpy(tex, in + texcoord_offset, sizeof(tex));
+			vertex.m_Tex = Vector2D(tex[0], tex[1]);
+		}
+		else
+		{
+			unsigned short texcoord[2];
+			::memcpy(texcoord, in + texcoord_offset, sizeof(texcoord));
+			float tex[2];
+			for (unsigned int k = 0; k < 2; k++)
+			{
+				if (format.m_texcoord == TexcoordFormat::Half2)
+					tex[k] = halfToFloat(texcoord[k]);
+				else
+					tex[k] = quantization.m_texcoord_offset[k] + texcoord[k] / 65535.0f * quantization.m_texcoord_scale[k];
+			}
+			vertex.m_Tex = Vector2D(tex[0], tex[1]);
+		}
+
+		if (format.m_normal == NormalFormat::Float3)
+		{
+			float normal[3];
+			::memcpy(normal, in + normal_offset, sizeof(normal));
+			vertex.m_Norm = Vector3D(normal[0], normal[1], normal[2]);
+		}
+		else
+		{
+			short normal[2];
+			::memcpy(normal, in + normal_offset, sizeof(normal));
+			vertex.m_Norm = decodeOctahedral(fromSnorm16(normal[0]), fromSnorm16(normal[1]));
+		}
+	}
+}
+
+
+void VertexPacker::split(const unsigned char* packed, size_t count, const VertexFormat& format, std::vector<unsigned char>& positions,
+	std::vector<unsigned char>& attributes)
+{
+	unsigned int stride = format.getStride();
+	unsigned int position_stride = format.getPositionStride();
+	unsigned int attribute_stride = format.getAttributeStride();
+
+	positions.resize(count * position_stride);
+	attributes.resize(count * attribute_stride);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		::memcpy(&positions[i * position_stride], packed + i * stride, position_stride);
+		::memcpy(&attributes[i * attribute_stride], packed + i * stride + position_stride, attribute_stride);
+	}
+}
+
+
+/*
+	IEEE 754 binary16: 1 sign bit, 5 exponent bits (bias 15), 10 mantissa bits. Rounded to nearest even, too big
+	values become infinity, too small ones subnormal or zero
+*/
+unsigned short VertexPacker::floatToHalf(float value)
+{
+	unsigned int bits;
+	::memcpy(&bits, &value, sizeof(bits));
+
+	unsigned int sign = (bits >> 16) & 0x8000;
+	unsigned int float_exponent = (bits >> 23) & 0xff;
+	unsigned int mantissa = bits & 0x7fffff;
+
+	// infinity and NaN
+	if (float_exponent == 0xff)
+		return (unsigned short)(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+
+	int exponent = (int)float_exponent - 127 + 15;
+	if (exponent >= 31)
+		return (unsigned short)(sign | 0x7c00);
+
+	if (exponent <= 0)
+	{
+		if (exponent < -10)
+			return (unsigned short)sign;
+
+		mantissa |= 0x800000;
+		unsigned int shift = (unsigned int)(14 - exponent);
+		unsigned int half = mantissa >> shift;
+		unsigned int rest = mantissa & ((1u << shift) - 1);
+		unsigned int halfway = 1u << (shift - 1);
+		if (rest > halfway || (rest == halfway && (half & 1)))
+			half++;
+		return (unsigned short)(sign | half);
+	}
+
+	// a carry out of the mantissa increases the exponent, which is the correct result
+	unsigned int half = ((unsigned int)exponent << 10) | (mantissa >> 13);
+	unsigned int rest = mantissa & 0x1fff;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+		half++;
+	return (unsigned short)(sign | half);
+}
+
+
+float VertexPacker::halfToFloat(unsigned short value)
+{
+	unsigned int sign = (unsigned int)(value & 0x8000) << 16;
+	unsigned int exponent = (value >> 10) & 0x1f;
+	unsigned int mantissa = value & 0x3ff;
+
+	if (exponent == 0)
+	{
+		float result = ldexpf((float)mantissa, -24);
+		return sign ? -result : result;
+	}
+
+	unsigned int bits = (exponent == 31) ? (sign | 0x7f800000 | (mantissa << 13)) : (sign | ((exponent - 15 + 127) << 23) | (mantissa << 13));
+
+	float result;
+	::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
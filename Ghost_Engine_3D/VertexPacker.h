@@ -0,0 +1,126 @@
+/*
+	MIT License
+
+	Ghost Engine 3D (https://github.com/GhostlyActive/Ghost-Engine-3D)
+
+	Copyright (c) 2021, GhostlyActive
+
+	Permission is hereby granted, free of charge, to any person obtaining a copy
+	of this software and associated documentation files (the "Software"), to deal
+	in the Software without restriction, including without limitation the rights
+	to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the Software is
+	furnished to do so, subject to the following conditions:
+
+	The above copyright notice and this permission notice shall be included in all
+	copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+	IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+	FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+	AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+	LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+	OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+	SOFTWARE.
+*/
+
+#pragma once
+#include "VertexMesh.h"
+#include <vector>
+
+enum class PositionFormat : unsigned char
+{
+	Float3,			// 12 bytes
+	Unorm16			// 8 bytes, x y z w as 16-bit fractions of the bounding box of the mesh (w unused)
+};
+
+enum class TexcoordFormat : unsigned char
+{
+	Float2,			// 8 bytes
+	Half2,			// 4 bytes, 16-bit floats
+	Unorm16			// 4 bytes, 16-bit fractions of the texcoord range of the mesh
+};
+
+enum class NormalFormat : unsigned char
+{
+	Float3,			// 12 bytes
+	Octahedral16	// 4 bytes, unit vector folded onto an octahedron and unwrapped to a square, 16-bit signed per axis
+};
+
+// layout of one vertex in the vertex buffer: position, texcoord, normal, packed without gaps
+struct VertexFormat
+{
+	PositionFormat m_position = PositionFormat::Float3;
+	TexcoordFormat m_texcoord = TexcoordFormat::Float2;
+	NormalFormat m_normal = NormalFormat::Float3;
+
+	// the smallest formats: 16 bytes instead of 32
+	static VertexFormat packed();
+
+	bool isPacked() const;
+	unsigned int getStride() const;
+	unsigned int getTexcoordOffset() const;
+	unsigned int getNormalOffset() const;
+
+	// split streams: the position alone and texcoord + normal
+	unsigned int getPositionStride() const;
+	unsigned int getAttributeStride() const;
+
+	// one byte per attribute, stored in files and cache keys
+	unsigned int getKey() const;
+	// false for a key with an unknown format
+	static bool fromKey(unsigned int key, VertexFormat& format);
+};
+
+// the ranges the quantized attributes are stored in: value = offset + stored * scale (identity for float formats)
+struct VertexQuantization
+{
+	float m_position_offset[3] = { 0.0f, 0.0f, 0.0f };
+	float m_position_scale[3] = { 1.0f, 1.0f, 1.0f };
+	float m_texcoord_offset[2] = { 0.0f, 0.0f };
+	float m_texcoord_scale[2] = { 1.0f, 1.0f };
+};
+
+struct VertexPackReport
+{
+	unsigned int m_vertices = 0;
+	unsigned int m_float_bytes = 0;		// as VertexMesh
+	unsigned int m_packed_bytes = 0;
+	float m_position_error = 0.0f;		// largest distance to the source position, object space
+	float m_texcoord_error = 0.0f;		// largest difference of a texcoord component
+	float m_normal_error = 0.0f;		// largest angle to the source normal, degrees
+};
+
+
+/*
+	VertexPacker: encodes VertexMesh into smaller vertex formats at cook time, the vertex shader decodes them
+
+	- positions: 16 bits per axis relative to the bounding box -> the error is at most half a step of extent / 65535
+	- texcoords: half floats (exact around 0, coarser for big values of tiling meshes) or 16 bits relative to the
+	  texcoord range of the mesh
+	- normals: octahedral mapping (Meyer et al., "On Floating-Point Normal Vectors"), for every vertex the rounding
+	  of the two components with the smallest angle to the source normal is chosen
+	- the GPU unpacks UNORM / SNORM / half formats in the input assembler, the shader only applies the ranges
+	  (PackedVertexShader.hlsl) and unfolds the normal
+*/
+
+class VertexPacker
+{
+public:
+
+	// ranges of the quantized attributes of a mesh
+	static VertexQuantization computeQuantization(const VertexMesh* vertices, size_t count, const VertexFormat& format);
+
+	// count vertices into count * format.getStride() bytes. report: sizes and the largest errors after decoding
+	static void encode(const VertexMesh* vertices, size_t count, const VertexFormat& format, const VertexQuantization& quantization,
+		std::vector<unsigned char>& packed, VertexPackReport* report = nullptr);
+	// back to VertexMesh (CPU copies for culling, picking and batching)
+	static void decode(const unsigned char* packed, size_t count, const VertexFormat& format, const VertexQuantization& quantization,
+		std::vector<VertexMesh>& vertices);
+	// interleaved vertices of format into a position stream and an attribute stream (texcoord + normal)
+	static void split(const unsigned char* packed, size_t count, const VertexFormat& format, std::vector<unsigned char>& positions,
+		std::vector<unsigned char>& attributes);
+
+	static unsigned short floatToHalf(float value);
+	static float halfToFloat(unsigned short value);
+};
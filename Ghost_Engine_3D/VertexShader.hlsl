@@ -40,9 +40,10 @@ struct VS_INPUT
 
 struct VS_OUTPUT
 {
-	float4 position: SV_POSITION;
+	precise float4 position: SV_POSITION;
 	float2 texcoord: TEXCOORD;
 	float3 normal: NORMAL;
+	float3 world_position: TEXCOORD1;		// point and spot lights of the pixel shader
 };
 
 // adding Data Structure passed into ConstantBuffer
@@ -70,6 +71,7 @@ VS_OUTPUT vsmain(VS_INPUT input)
 		
 	// world space
 	output.position = mul(input.position, m_world);
+	output.world_position = output.position.xyz;
 	// view space
 	output.position = mul(output.position, m_view);
 	// screen space